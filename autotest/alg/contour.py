@@ -196,6 +196,52 @@ def contour_2():
 
     return 'success'
 
+###############################################################################
+# Test that contouring strips of lines in parallel gives the same contours
+
+def contour_3():
+
+    xsize = 100
+    ysize = 1000
+    ds = gdal.GetDriverByName('MEM').Create('', xsize, ysize, 1, gdal.GDT_Float32)
+    ds.SetGeoTransform( [ 0, 1, 0, 0, 0, -1 ] )
+    # Concentric rings crossing several strips of lines, and nodata holes
+    for j in range(ysize):
+        vals = []
+        for i in range(xsize):
+            if (i // 13 + j // 41) % 9 == 0:
+                vals.append(-9999)
+            else:
+                vals.append(((i - 50) * (i - 50) + (j - 500) * (j - 500)) ** 0.5)
+        ds.GetRasterBand(1).WriteRaster( 0, j, xsize, 1,
+                                         array.array('f', vals).tostring() )
+
+    results = []
+    for num_threads in [ '1', '4' ]:
+        ogr_ds = ogr.GetDriverByName('Memory').CreateDataSource('')
+        ogr_lyr = ogr_ds.CreateLayer('contour')
+        field_defn = ogr.FieldDefn('elev', ogr.OFTReal)
+        ogr_lyr.CreateField(field_defn)
+
+        gdal.SetConfigOption('GDAL_CONTOUR_NUM_THREADS', num_threads)
+        gdal.ContourGenerate(ds.GetRasterBand(1), 25, 0, [], 1, -9999, ogr_lyr, -1, 0)
+        gdal.SetConfigOption('GDAL_CONTOUR_NUM_THREADS', None)
+
+        contours = []
+        for feat in ogr_lyr:
+            geom = feat.GetGeometryRef()
+            contours.append( ( feat.GetField('elev'), geom.GetPointCount(),
+                               geom.GetEnvelope(), '%.6f' % geom.Length() ) )
+        contours.sort()
+        results.append(contours)
+
+    if len(results[0]) == 0 or results[0] != results[1]:
+        print(len(results[0]))
+        print(len(results[1]))
+        return 'fail'
+
+    return 'success'
+
 ###############################################################################
 # Cleanup
 
@@ -213,6 +259,7 @@ def contour_cleanup():
 gdaltest_list = [
     contour_1,
     contour_2,
+    contour_3,
     contour_cleanup
     ]
 
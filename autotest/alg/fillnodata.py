@@ -0,0 +1,149 @@
+#!/usr/bin/env python
+###############################################################################
+# $Id$
+#
+# Project:  GDAL/OGR Test Suite
+# Purpose:  Test FillNodata() algorithm.
+# Author:   agent <agent at local>
+#
+###############################################################################
+# Copyright (c) 2026, agent <agent at local>
+#
+# Permission is hereby granted, free of charge, to any person obtaining a
+# copy of this software and associated documentation files (the "Software"),
+# to deal in the Software without restriction, including without limitation
+# the rights to use, copy, modify, merge, publish, distribute, sublicense,
+# and/or sell copies of the Software, and to permit persons to whom the
+# Software is furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included
+# in all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+# OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+# THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+# FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+# DEALINGS IN THE SOFTWARE.
+###############################################################################
+
+import math
+import struct
+import sys
+
+sys.path.append( '../pymod' )
+
+import gdaltest
+
+from osgeo import gdal
+
+###############################################################################
+# Test that the push-pull algorithm gives the same result with one and
+# several threads. With a maximum distance of 200 pixels, the tiles are
+# 1024 pixels wide, so the raster is made of 3 columns of tiles, and some
+# of the voids straddle tile boundaries. The largest void is wider than
+# twice the maximum distance, so its center must stay at nodata.
+# Also test that the tiles give the same result as a single window: a
+# 1000 pixel wide extract of the raster fits in one tile, and its result
+# must match the tiled one away from its left and right edges.
+
+def fillnodata_1():
+
+    xsize = 2500
+    ysize = 1000
+    voids = [ (1024, 500, 180), (2048, 300, 120), (400, 200, 60),
+              (1800, 800, 250) ]
+
+    ds = gdal.GetDriverByName('MEM').Create('', xsize, ysize, 1,
+                                            gdal.GDT_Float32)
+    band = ds.GetRasterBand(1)
+    band.SetNoDataValue(-1)
+    for j in range(ysize):
+        line = [ 100.0 * math.sin(i / 150.0) * math.cos(j / 90.0) +
+                 0.0001 * i * j for i in range(xsize) ]
+        for (cx, cy, r) in voids:
+            dy = j - cy
+            if dy * dy > r * r:
+                continue
+            dx = int(math.sqrt(r * r - dy * dy))
+            for i in range(max(0, cx - dx), min(xsize - 1, cx + dx) + 1):
+                line[i] = -1
+        band.WriteRaster(0, j, xsize, 1, struct.pack('f' * xsize, *line))
+    src_data = band.ReadRaster()
+
+    results = []
+    for num_threads in [ '1', '4' ]:
+        band.WriteRaster(0, 0, xsize, ysize, src_data)
+        gdal.FillNodata(band, None, 200, 0,
+                        [ 'ALGORITHM=PUSH_PULL',
+                          'NUM_THREADS=' + num_threads ])
+        results.append(band.ReadRaster())
+
+    if results[0] == src_data:
+        gdaltest.post_reason('no pixel was filled')
+        return 'fail'
+
+    if results[1] != results[0]:
+        gdaltest.post_reason('result depends on the number of threads')
+        return 'fail'
+
+    (val,) = struct.unpack('f', band.ReadRaster(1800, 800, 1, 1))
+    if val != -1:
+        gdaltest.post_reason('fail')
+        print(val)
+        return 'fail'
+
+    # With a maximum distance of 20 pixels, the margin of the tiles is
+    # 64 pixels, and the extract starts on a multiple of the coarsest cells.
+    band.WriteRaster(0, 0, xsize, ysize, src_data)
+    gdal.FillNodata(band, None, 20, 0, [ 'ALGORITHM=PUSH_PULL' ])
+    tiled = band.ReadRaster(576, 0, 872, ysize)
+
+    extract_ds = gdal.GetDriverByName('MEM').Create('', 1000, ysize, 1,
+                                                    gdal.GDT_Float32)
+    extract_band = extract_ds.GetRasterBand(1)
+    extract_band.SetNoDataValue(-1)
+    band.WriteRaster(0, 0, xsize, ysize, src_data)
+    extract_band.WriteRaster(0, 0, 1000, ysize,
+                             band.ReadRaster(512, 0, 1000, ysize))
+    gdal.FillNodata(extract_band, None, 20, 0, [ 'ALGORITHM=PUSH_PULL' ])
+    if extract_band.ReadRaster(64, 0, 872, ysize) != tiled:
+        gdaltest.post_reason('tiled result differs from a single window')
+        return 'fail'
+
+    return 'success'
+
+###############################################################################
+# Test that PUSH_PULL fills the pixels strictly closer than the maximum
+# distance of the nearest valid pixel, and only them.
+
+def fillnodata_2():
+
+    ds = gdal.GetDriverByName('MEM').Create('', 20, 1, 1, gdal.GDT_Float32)
+    band = ds.GetRasterBand(1)
+    band.SetNoDataValue(-1)
+    src_data = struct.pack('f' * 20, *([ 10.0 ] + [ -1.0 ] * 19))
+    band.WriteRaster(0, 0, 20, 1, src_data)
+
+    gdal.FillNodata(band, None, 5, 0, [ 'ALGORITHM=PUSH_PULL' ])
+    got = struct.unpack('f' * 20, band.ReadRaster())
+    if got[4] != 10.0 or got[5] != -1.0:
+        gdaltest.post_reason('fail')
+        print(got)
+        return 'fail'
+
+    return 'success'
+
+gdaltest_list = [
+    fillnodata_1,
+    fillnodata_2,
+    ]
+
+if __name__ == '__main__':
+
+    gdaltest.setup_run( 'fillnodata' )
+
+    gdaltest.run_tests( gdaltest_list )
+
+    gdaltest.summarize()
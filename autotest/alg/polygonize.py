@@ -29,6 +29,8 @@
 # DEALINGS IN THE SOFTWARE.
 ###############################################################################
 
+import random
+import struct
 import sys
 
 sys.path.append( '../pymod' )
@@ -217,12 +219,82 @@ def polygonize_4():
     else:
         return 'fail'
 
+###############################################################################
+# Test the strip mode, with and without threads, against the default mode.
+
+def polygonize_5():
+
+    # A random raster has many polygons touching themselves, or the
+    # polygons of their holes, at a vertex
+    rnd = random.Random(3)
+    random_ds = gdal.GetDriverByName('MEM').Create('', 37, 41)
+    random_ds.GetRasterBand(1).WriteRaster(0, 0, 37, 41,
+        struct.pack('B' * 37 * 41, *[rnd.randint(0, 2) for i in range(37 * 41)]))
+
+    for src_band in [ gdal.Open('data/polygonize_in.grd').GetRasterBand(1),
+                      random_ds.GetRasterBand(1) ]:
+        ret = polygonize_5_compare_strip_modes(src_band)
+        if ret != 'success':
+            return ret
+
+    return 'success'
+
+# Check that the strip modes give the same polygons, down to their rings,
+# as the default mode
+def polygonize_5_compare_strip_modes(src_band):
+
+    mem_drv = ogr.GetDriverByName( 'Memory' )
+
+    ref_polys = None
+    for options in [ [],
+                     ['STRIP_HEIGHT=1'],
+                     ['STRIP_HEIGHT=3', 'NUM_THREADS=4'],
+                     ['NUM_THREADS=ALL_CPUS'],
+                     ['8CONNECTED=8'],
+                     ['8CONNECTED=8', 'STRIP_HEIGHT=2', 'NUM_THREADS=3'] ]:
+
+        if options == ['8CONNECTED=8']:
+            ref_polys = None
+
+        mem_ds = mem_drv.CreateDataSource( 'out' )
+        mem_layer = mem_ds.CreateLayer( 'poly', None, ogr.wkbPolygon )
+        fd = ogr.FieldDefn( 'DN', ogr.OFTInteger )
+        mem_layer.CreateField( fd )
+
+        result = gdal.Polygonize( src_band, src_band.GetMaskBand(),
+                                  mem_layer, 0, options )
+        if result != 0:
+            gdaltest.post_reason( 'Polygonize failed' )
+            print(options)
+            return 'fail'
+
+        polys = []
+        for feat in mem_layer:
+            polys.append( (feat.GetField('DN'),
+                           feat.GetGeometryRef().ExportToWkt()) )
+        polys.sort()
+
+        if ref_polys is None:
+            ref_polys = polys
+        elif polys != ref_polys:
+            gdaltest.post_reason( 'did not get the same polygons' )
+            print(options)
+            for i in range(min(len(polys), len(ref_polys))):
+                if polys[i] != ref_polys[i]:
+                    print(polys[i])
+                    print(ref_polys[i])
+                    break
+            return 'fail'
+
+    return 'success'
+
 gdaltest_list = [
     polygonize_1,
     polygonize_1_float,
     polygonize_2,
     polygonize_3,
-    polygonize_4
+    polygonize_4,
+    polygonize_5
     ]
 
 if __name__ == '__main__':
@@ -137,10 +137,47 @@ def proximity_3():
     else:
         return 'success'
 
+###############################################################################
+# Test the exact distance transform
+
+def proximity_4():
+
+    drv = gdal.GetDriverByName( 'MEM' )
+    src_ds = gdal.Open('data/pat.tif')
+    src_band = src_ds.GetRasterBand(1)
+
+    dst_ds = drv.Create('', 25, 25, 1, gdal.GDT_Byte )
+    dst_band = dst_ds.GetRasterBand(1)
+
+    gdal.ComputeProximity( src_band, dst_band, options = [ 'EXACT=YES' ] )
+
+    cs_expected = 1941
+    cs = dst_band.Checksum()
+    if cs != cs_expected:
+        print('Got: ', cs)
+        gdaltest.post_reason( 'got wrong checksum' )
+        return 'fail'
+
+    # Same result with several threads
+    dst_ds = drv.Create('', 25, 25, 1, gdal.GDT_Float32 )
+    gdal.ComputeProximity( src_band, dst_ds.GetRasterBand(1),
+                           options = [ 'EXACT=YES' ] )
+    ref_data = dst_ds.ReadRaster(0, 0, 25, 25)
+
+    dst_ds = drv.Create('', 25, 25, 1, gdal.GDT_Float32 )
+    gdal.ComputeProximity( src_band, dst_ds.GetRasterBand(1),
+                           options = [ 'EXACT=YES', 'NUM_THREADS=2' ] )
+    if dst_ds.ReadRaster(0, 0, 25, 25) != ref_data:
+        gdaltest.post_reason( 'got different result with threads' )
+        return 'fail'
+
+    return 'success'
+
 gdaltest_list = [
     proximity_1,
     proximity_2,
-    proximity_3
+    proximity_3,
+    proximity_4
     ]
 
 if __name__ == '__main__':
@@ -328,12 +328,123 @@ def rasterize_5():
 
     return 'success'
 
+###############################################################################
+# Check that the single pass mode, with several chunks and threads, gives
+# the same result as reading the layer again for each chunk.
+
+def rasterize_6():
+
+    sr_wkt = 'LOCAL_CS["arbitrary"]'
+    sr = osr.SpatialReference( sr_wkt )
+
+    rast_ogr_ds = \
+              ogr.GetDriverByName('Memory').CreateDataSource( 'wrk' )
+    rast_mem_lyr = rast_ogr_ds.CreateLayer( 'poly', srs=sr )
+    rast_mem_lyr.CreateField( ogr.FieldDefn( 'val', ogr.OFTReal ) )
+
+    wkts = [ 'POLYGON((1020 1030,1020 1045,1050 1045,1050 1030,1020 1030),(1025 1035,1030 1035,1030 1040,1025 1035))',
+             'POLYGON((1045 1050,1055 1050,1055 1020,1045 1020,1045 1050))',
+             'MULTIPOLYGON(((1000 1100,1100 1000,1090 1000,1000 1090,1000 1100)),((1060 1090,1070 1095,1080 1060,1060 1090)))',
+             'LINESTRING(1000 1000, 1100 1050)',
+             'LINESTRING(1005 1000, 1000 1050, 1070.5 1099.5)',
+             'MULTIPOINT(1010.5 1010.5,1090.5 1080.5,1010.5 1010.5)',
+             'POLYGON((900 900,1200 900,1200 1200,900 900))' ]
+    i = 0
+    for wkt_geom in wkts:
+        feat = ogr.Feature( rast_mem_lyr.GetLayerDefn() )
+        feat.SetGeometryDirectly( ogr.Geometry(wkt = wkt_geom) )
+        feat.SetField( 'val', 10 + i )
+        rast_mem_lyr.CreateFeature( feat )
+        i = i + 1
+
+    for options in [ ['MERGE_ALG=ADD'],
+                     ['MERGE_ALG=ADD', 'ALL_TOUCHED=YES'],
+                     ['ATTRIBUTE=val'] ]:
+        ref_cs = None
+        for extra_options in [ ['SINGLE_PASS=NO'],
+                               ['SINGLE_PASS=YES'],
+                               ['SINGLE_PASS=YES', 'NUM_THREADS=3'],
+                               ['SINGLE_PASS=YES', 'NUM_THREADS=ALL_CPUS'] ]:
+            target_ds = gdal.GetDriverByName('MEM').Create( '', 100, 100, 2,
+                                                            gdal.GDT_Byte )
+            target_ds.SetGeoTransform( (1000,1,0,1100,0,-1) )
+            target_ds.SetProjection( sr_wkt )
+
+            err = gdal.RasterizeLayer( target_ds, [1, 2], rast_mem_lyr,
+                                       burn_values = [20,30],
+                                       options = options + extra_options + ['CHUNKYSIZE=7'] )
+            if err != 0:
+                print(err)
+                gdaltest.post_reason( 'got non-zero result code from RasterizeLayer' )
+                return 'fail'
+
+            cs = [ target_ds.GetRasterBand(1).Checksum(),
+                   target_ds.GetRasterBand(2).Checksum() ]
+            if ref_cs is None:
+                ref_cs = cs
+            elif cs != ref_cs:
+                gdaltest.post_reason( 'Did not get expected image checksum' )
+                print(options, extra_options, cs, ref_cs)
+                return 'fail'
+
+    # Vertices that cannot be transformed (the poles in Mercator) are
+    # skipped in the same way whether in single pass or not.
+    geog_sr = osr.SpatialReference()
+    geog_sr.SetWellKnownGeogCS( 'WGS84' )
+    merc_sr = osr.SpatialReference()
+    merc_sr.ImportFromProj4( '+proj=merc +datum=WGS84' )
+    gdal.PushErrorHandler('CPLQuietErrorHandler')
+    ct = osr.CoordinateTransformation( geog_sr, merc_sr )
+    gdal.PopErrorHandler()
+    if ct is None or ct.this is None:
+        return 'success'
+
+    geog_lyr = rast_ogr_ds.CreateLayer( 'geog', srs=geog_sr )
+    for wkt_geom in [ 'LINESTRING(-10 10,0 90,10 10)',
+                      'POLYGON((-15 -15,-15 90,15 -15,-15 -15))',
+                      'MULTIPOINT(0 90,5 5)' ]:
+        feat = ogr.Feature( geog_lyr.GetLayerDefn() )
+        feat.SetGeometryDirectly( ogr.Geometry(wkt = wkt_geom) )
+        geog_lyr.CreateFeature( feat )
+
+    ref_cs = None
+    for options in [ ['SINGLE_PASS=NO'],
+                     ['SINGLE_PASS=YES'],
+                     ['SINGLE_PASS=YES', 'NUM_THREADS=3'] ]:
+        target_ds = gdal.GetDriverByName('MEM').Create( '', 100, 100, 1,
+                                                        gdal.GDT_Byte )
+        target_ds.SetGeoTransform( (-2000000,40000,0,2000000,0,-40000) )
+        target_ds.SetProjection( merc_sr.ExportToWkt() )
+
+        with gdaltest.error_handler():
+            err = gdal.RasterizeLayer( target_ds, [1], geog_lyr,
+                                       burn_values = [255],
+                                       options = options + ['CHUNKYSIZE=7'] )
+        if err != 0:
+            print(err)
+            gdaltest.post_reason( 'got non-zero result code from RasterizeLayer' )
+            return 'fail'
+
+        cs = target_ds.GetRasterBand(1).Checksum()
+        if ref_cs is None:
+            ref_cs = cs
+            if cs == 0:
+                gdaltest.post_reason( 'Did not get expected image checksum' )
+                return 'fail'
+        elif cs != ref_cs:
+            gdaltest.post_reason( 'Did not get expected image checksum' )
+            print(options, cs, ref_cs)
+            return 'fail'
+
+    return 'success'
+
 gdaltest_list = [
     rasterize_1,
     rasterize_2,
     rasterize_3,
     rasterize_4,
     rasterize_5,
+    rasterize_6,
     ]
 
 if __name__ == '__main__':
@@ -342,6 +342,40 @@ cellsize     60.000000000000
     else:
         return 'success'
 
+###############################################################################
+# Test that processing by strips of lines, in several threads, gives the
+# same result as processing the whole raster at once.
+
+def sieve_9():
+
+    src_ds = gdal.Open('../gcore/data/byte.tif')
+    src_band = src_ds.GetRasterBand(1)
+
+    for connectedness in [ 4, 8 ]:
+        for threshold in [ 3, 10, 50 ]:
+
+            dst_ds = gdal.GetDriverByName('MEM').Create('', 20, 20, 1 )
+            gdal.SieveFilter( src_band, None, dst_ds.GetRasterBand(1),
+                              threshold, connectedness )
+            ref_data = dst_ds.ReadRaster(0, 0, 20, 20)
+            ref_cs = dst_ds.GetRasterBand(1).Checksum()
+
+            for strip_lines in [ '1', '3', '7' ]:
+                dst_ds = gdal.GetDriverByName('MEM').Create('', 20, 20, 1 )
+                gdal.SetConfigOption( 'GDAL_SIEVE_STRIP_LINES', strip_lines )
+                gdal.SieveFilter( src_band, None, dst_ds.GetRasterBand(1),
+                                  threshold, connectedness,
+                                  options = [ 'NUM_THREADS=4' ] )
+                gdal.SetConfigOption( 'GDAL_SIEVE_STRIP_LINES', None )
+
+                if dst_ds.ReadRaster(0, 0, 20, 20) != ref_data:
+                    print(connectedness, threshold, strip_lines)
+                    print('Got: ', dst_ds.GetRasterBand(1).Checksum())
+                    print('Expected: ', ref_cs)
+                    gdaltest.post_reason( 'got wrong result' )
+                    return 'fail'
+
+    return 'success'
 
 gdaltest_list = [
     sieve_1,
@@ -351,7 +385,8 @@ gdaltest_list = [
     sieve_5,
     sieve_6,
     sieve_7,
-    sieve_8
+    sieve_8,
+    sieve_9
     ]
 
 if __name__ == '__main__':
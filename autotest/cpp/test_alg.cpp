@@ -31,6 +31,10 @@
 #include <tut_gdal.h>
 
 #include <gdal_alg.h>
+#include <gdal_alg_priv.h>
+#include <cpl_string.h>
+
+#include <vector>
 
 namespace tut
 {
@@ -82,4 +86,132 @@ namespace tut
         ensure_approx_equals(data.y, 0.0);
         GDAL_CG_Destroy(hCG);
     }
+    // Checksum does not depend on the number of threads
+    template<>
+    template<>
+    void object::test<2>()
+    {
+        GDALDatasetH hDS = GDALCreate(GDALGetDriverByName("MEM"), "",
+                                      1000, 1500, 1, GDT_CFloat32, NULL);
+        GDALRasterBandH hBand = GDALGetRasterBand(hDS, 1);
+        float* pafData = (float*)CPLMalloc(2 * 1000 * sizeof(float));
+        for( int iLine = 0; iLine < 1500; iLine++ )
+        {
+            for( int i = 0; i < 2 * 1000; i++ )
+                pafData[i] = (float)((iLine * 7919 + i * 104729) % 65537) / 3;
+            ensure_equals(GDALRasterIO(hBand, GF_Write, 0, iLine, 1000, 1,
+                                       pafData, 1000, 1, GDT_CFloat32, 0, 0),
+                          CE_None);
+        }
+        CPLFree(pafData);
+
+        CPLSetConfigOption("GDAL_NUM_THREADS", "1");
+        const int nChecksum1 = GDALChecksumImage(hBand, 0, 0, 1000, 1500);
+        const int nChecksumWin1 = GDALChecksumImage(hBand, 3, 5, 997, 1234);
+        CPLSetConfigOption("GDAL_NUM_THREADS", "4");
+        const int nChecksum4 = GDALChecksumImage(hBand, 0, 0, 1000, 1500);
+        const int nChecksumWin4 = GDALChecksumImage(hBand, 3, 5, 997, 1234);
+        CPLSetConfigOption("GDAL_NUM_THREADS", NULL);
+        ensure_equals(nChecksum4, nChecksum1);
+        ensure_equals(nChecksumWin4, nChecksumWin1);
+
+        // 200 real parts at 1, 200 imaginary parts at 0
+        GDALFillRaster(hBand, 1, 0);
+        ensure_equals(GDALChecksumImage(hBand, 0, 0, 10, 20), 200);
+
+        GDALClose(hDS);
+    }
+
+    // Raster fingerprint: incremental update and serialization
+    template<>
+    template<>
+    void object::test<3>()
+    {
+        GDALDatasetH hDS = GDALCreate(GDALGetDriverByName("MEM"), "",
+                                      300, 200, 1, GDT_Int16, NULL);
+        GDALRasterBandH hBand = GDALGetRasterBand(hDS, 1);
+        GDALFillRaster(hBand, 10, 0);
+
+        GDALRasterFingerprintH hFP =
+            GDALComputeRasterFingerprint(hBand, NULL, NULL, NULL);
+        ensure(hFP != NULL);
+        CPLString osInitial(GDALGetRasterFingerprintValue(hFP));
+        ensure_equals(osInitial.size(), 16U);
+
+        GInt16 nVal = 11;
+        ensure_equals(GDALRasterIO(hBand, GF_Write, 150, 100, 1, 1, &nVal,
+                                   1, 1, GDT_Int16, 0, 0), CE_None);
+        ensure_equals(GDALUpdateRasterFingerprint(hFP, hBand, 150, 100, 1, 1,
+                                                  NULL), CE_None);
+        CPLString osUpdated(GDALGetRasterFingerprintValue(hFP));
+        ensure(osUpdated != osInitial);
+
+        char** papszOptions = CSLSetNameValue(NULL, "NUM_THREADS", "3");
+        GDALRasterFingerprintH hFPFull =
+            GDALComputeRasterFingerprint(hBand, papszOptions, NULL, NULL);
+        CSLDestroy(papszOptions);
+        ensure_equals(CPLString(GDALGetRasterFingerprintValue(hFPFull)),
+                      osUpdated);
+
+        CPLXMLNode* psTree = GDALSerializeRasterFingerprint(hFPFull);
+        GDALRasterFingerprintH hFPDeser =
+            GDALDeserializeRasterFingerprint(psTree);
+        CPLDestroyXMLNode(psTree);
+        ensure(hFPDeser != NULL);
+        ensure_equals(CPLString(GDALGetRasterFingerprintValue(hFPDeser)),
+                      osUpdated);
+
+        GDALDestroyRasterFingerprint(hFP);
+        GDALDestroyRasterFingerprint(hFPFull);
+        GDALDestroyRasterFingerprint(hFPDeser);
+        GDALClose(hDS);
+    }
+
+    // XXH64 against the reference xxHash sanity test vectors
+    template<>
+    template<>
+    void object::test<4>()
+    {
+        const GUInt32 nPrime32 = 2654435761U;
+        const GUIntBig nPrime64 = 2654435761U;
+
+        std::vector<GByte> abyBuffer(2367);
+        GUInt32 nByteGen = nPrime32;
+        for( size_t i = 0; i < abyBuffer.size(); i++ )
+        {
+            abyBuffer[i] = static_cast<GByte>(nByteGen >> 24);
+            nByteGen *= nByteGen;
+        }
+
+        // Length, hash with a zero seed, hash with nPrime64 as the seed.
+        static const struct
+        {
+            size_t nLen;
+            GUIntBig nHashSeed0;
+            GUIntBig nHashSeedPrime;
+        } asVectors[] = {
+            { 0, 0xEF46DB3751D8E999ULL, 0xAC75FDA2929B17EFULL },
+            { 1, 0x4FCE394CC88952D8ULL, 0x739840CB819FA723ULL },
+            { 4, 0x9256E58AA397AEF1ULL, 0x09D5FFDFB928AB4BULL },
+            { 14, 0xCFFA8DB881BC3A3DULL, 0x5B9611585EFCC9CBULL },
+            { 31, 0xAD09D9A6941DD847ULL, 0x9C90D9D9C2E3D340ULL },
+            { 32, 0xAF5753D39159EDEEULL, 0xDCAB9233B8CA7B0FULL },
+            { 101, 0x0EAB543384F878ADULL, 0xCAA65939306F1E21ULL },
+            { 222, 0x9DD507880DEBB03DULL, 0xDC515172B8EE0600ULL },
+            { 2367, 0x2E717C2BB15C0A8AULL, 0xF7B7F152E920C87CULL }
+        };
+
+        for( size_t i = 0; i < sizeof(asVectors) / sizeof(asVectors[0]); i++ )
+        {
+            const size_t nLen = asVectors[i].nLen;
+            ensure_equals(CPLSPrintf("length %d, seed 0",
+                                     static_cast<int>(nLen)),
+                          GDALXXH64(&abyBuffer[0], nLen, 0),
+                          asVectors[i].nHashSeed0);
+            ensure_equals(CPLSPrintf("length %d, seed prime",
+                                     static_cast<int>(nLen)),
+                          GDALXXH64(&abyBuffer[0], nLen, nPrime64),
+                          asVectors[i].nHashSeedPrime);
+        }
+    }
 } // namespace tut
@@ -28,9 +28,12 @@
 #include <tut.h>
 #include <tut_gdal.h>
 #include <gdal_common.h>
+#include <algorithm>
 #include <string>
 #include <fstream>
 #include "cpl_list.h"
+#include "cpl_packed_rtree.h"
+#include "cpl_json_streaming_parser.h"
 #include "cpl_hash_set.h"
 #include "cpl_string.h"
 #include "cpl_sha256.h"
@@ -917,4 +920,230 @@ namespace tut
         CPLSetConfigOption("CPL_DEBUG", oldVal.size() ? oldVal.c_str() : NULL);
     }
 
+    // Test packed R-tree against brute force search
+    template<>
+    template<>
+    void object::test<16>()
+    {
+        const int nFeatures = 1000;
+        CPLRectObj* pasBounds = static_cast<CPLRectObj*>(
+            CPLMalloc(nFeatures * sizeof(CPLRectObj)));
+        srand(1234);
+        for( int i = 0; i < nFeatures; i++ )
+        {
+            const double dfX = rand() * 1000.0 / RAND_MAX;
+            const double dfY = rand() * 1000.0 / RAND_MAX;
+            pasBounds[i].minx = dfX;
+            pasBounds[i].miny = dfY;
+            pasBounds[i].maxx = dfX + (i % 10);
+            pasBounds[i].maxy = dfY + (i % 7);
+        }
+
+        for( int iOrder = 0; iOrder < 2; iOrder++ )
+        {
+            CPLPackedRTree* hTree = CPLPackedRTreeCreateWithBounds(
+                nFeatures, NULL, pasBounds,
+                iOrder == 0 ? CPLPRT_ORDER_STR : CPLPRT_ORDER_HILBERT, 8);
+            ensure( hTree != NULL );
+
+            int nCount = 0;
+            int nNodeCount = 0;
+            int nDepth = 0;
+            CPLPackedRTreeGetStats(hTree, &nCount, &nNodeCount, &nDepth, NULL);
+            ensure_equals( nCount, nFeatures );
+            ensure_equals( nNodeCount, 125 + 16 + 2 + 1 );
+            ensure_equals( nDepth, 5 );
+
+            // Round-trip through the serialized form
+            VSILFILE* fp = VSIFOpenL("/vsimem/test_cpl_16.bin", "wb");
+            ensure( CPLPackedRTreeWrite(hTree, fp) );
+            VSIFCloseL(fp);
+            CPLPackedRTreeDestroy(hTree);
+
+            // A different number of features than expected is rejected
+            fp = VSIFOpenL("/vsimem/test_cpl_16.bin", "rb");
+            CPLPushErrorHandler(CPLQuietErrorHandler);
+            ensure( CPLPackedRTreeRead(fp, nFeatures + 1, NULL) == NULL );
+            CPLPopErrorHandler();
+            VSIFCloseL(fp);
+            fp = VSIFOpenL("/vsimem/test_cpl_16.bin", "rb");
+            hTree = CPLPackedRTreeRead(fp, nFeatures, NULL);
+            VSIFCloseL(fp);
+            VSIUnlink("/vsimem/test_cpl_16.bin");
+            ensure( hTree != NULL );
+
+            for( int iIter = 0; iIter < 100; iIter++ )
+            {
+                CPLRectObj sAoi;
+                sAoi.minx = rand() * 1000.0 / RAND_MAX;
+                sAoi.miny = rand() * 1000.0 / RAND_MAX;
+                sAoi.maxx = sAoi.minx + iIter;
+                sAoi.maxy = sAoi.miny + iIter;
+
+                int nResults = 0;
+                int* panResults =
+                    CPLPackedRTreeSearchIndices(hTree, &sAoi, &nResults);
+                int iResult = 0;
+                for( int i = 0; i < nFeatures; i++ )
+                {
+                    if( pasBounds[i].minx > sAoi.maxx ||
+                        pasBounds[i].maxx < sAoi.minx ||
+                        pasBounds[i].miny > sAoi.maxy ||
+                        pasBounds[i].maxy < sAoi.miny )
+                        continue;
+                    ensure( iResult < nResults );
+                    ensure_equals( panResults[iResult], i );
+                    iResult ++;
+                }
+                ensure_equals( iResult, nResults );
+                CPLFree(panResults);
+
+                // Nearest features, by increasing distance then index
+                const int nMaxCount = 1 + iIter % 20;
+                const double dfMaxDistance = (iIter % 3 == 0) ? -1.0 : iIter;
+                std::vector< std::pair<double, int> > aoDist;
+                for( int i = 0; i < nFeatures; i++ )
+                {
+                    const double dfDX =
+                        sAoi.minx < pasBounds[i].minx ? pasBounds[i].minx - sAoi.minx :
+                        sAoi.minx > pasBounds[i].maxx ? sAoi.minx - pasBounds[i].maxx : 0.0;
+                    const double dfDY =
+                        sAoi.miny < pasBounds[i].miny ? pasBounds[i].miny - sAoi.miny :
+                        sAoi.miny > pasBounds[i].maxy ? sAoi.miny - pasBounds[i].maxy : 0.0;
+                    const double dfDist2 = dfDX * dfDX + dfDY * dfDY;
+                    if( dfMaxDistance < 0 ||
+                        dfDist2 <= dfMaxDistance * dfMaxDistance )
+                        aoDist.push_back(std::pair<double, int>(dfDist2, i));
+                }
+                std::sort(aoDist.begin(), aoDist.end());
+                std::vector<double> adfDist2(nMaxCount);
+                panResults = CPLPackedRTreeSearchNearestIndices(
+                    hTree, sAoi.minx, sAoi.miny, nMaxCount, dfMaxDistance,
+                    &nResults, &adfDist2[0]);
+                ensure_equals( nResults,
+                               std::min(nMaxCount, (int)aoDist.size()) );
+                for( int i = 0; i < nResults; i++ )
+                {
+                    ensure_equals( panResults[i], aoDist[i].second );
+                    ensure_equals( adfDist2[i], aoDist[i].first );
+                }
+                CPLFree(panResults);
+            }
+            CPLPackedRTreeDestroy(hTree);
+        }
+
+        // Degenerate trees
+        CPLRectObj sAoi = { 0, 0, 1000, 1000 };
+        CPLPackedRTree* hTree =
+            CPLPackedRTreeCreateWithBounds(0, NULL, NULL, CPLPRT_ORDER_STR, 0);
+        int nResults = -1;
+        ensure( CPLPackedRTreeSearch(hTree, &sAoi, &nResults) == NULL );
+        ensure_equals( nResults, 0 );
+        CPLPackedRTreeDestroy(hTree);
+
+        void* hFeature = &sAoi;
+        hTree = CPLPackedRTreeCreateWithBounds(1, &hFeature, pasBounds,
+                                               CPLPRT_ORDER_HILBERT, 0);
+        void** pahResults = CPLPackedRTreeSearch(hTree, &sAoi, &nResults);
+        ensure_equals( nResults, 1 );
+        ensure( pahResults[0] == hFeature );
+        CPLFree(pahResults);
+        CPLPackedRTreeDestroy(hTree);
+
+        CPLFree(pasBounds);
+    }
+
+    class CPLJSonStreamingParserDump: public CPLJSonStreamingParser
+    {
+            std::string m_osStr;
+            std::string m_osException;
+
+        public:
+            CPLJSonStreamingParserDump() {}
+
+            const std::string& GetSerialized() const { return m_osStr; }
+            const std::string& GetException() const { return m_osException; }
+
+        protected:
+            virtual void String(const char* pszValue, size_t nLength)
+            {
+                m_osStr += "S(" + std::string(pszValue, nLength) + ")";
+            }
+            virtual void Number(const char* pszValue, size_t nLength)
+            {
+                m_osStr += "N(" + std::string(pszValue, nLength) + ")";
+            }
+            virtual void Boolean(bool b) { m_osStr += b ? "true" : "false"; }
+            virtual void Null() { m_osStr += "null"; }
+            virtual void StartObject() { m_osStr += "{"; }
+            virtual void EndObject() { m_osStr += "}"; }
+            virtual void StartObjectMember(const char* pszKey, size_t nLength)
+            {
+                m_osStr += "K(" + std::string(pszKey, nLength) + ")";
+            }
+            virtual void StartArray() { m_osStr += "["; }
+            virtual void EndArray() { m_osStr += "]"; }
+            virtual void StartArrayMember() { m_osStr += ","; }
+            virtual void Exception(const char* pszMessage)
+            {
+                m_osException = pszMessage;
+            }
+    };
+
+    // Test CPLJSonStreamingParser
+    template<>
+    template<>
+    void object::test<17>()
+    {
+        const char* const apszValid[] = {
+            "{\"a\": [1, -2.5e3, true, false, null], \"b\": \"x\\u00e9\\n\"}",
+            "{\"a\":[1,-2.5e3,true,false,null],\"b\":\"x\\u00e9\\n\"}"
+        };
+        const std::string osExpected(
+            "{K(a)[,N(1),N(-2.5e3),true,false,null]K(b)S(x\xC3\xA9\n)}");
+        for( size_t i = 0; i < sizeof(apszValid) / sizeof(apszValid[0]); i++ )
+        {
+            // Whole buffer
+            {
+                CPLJSonStreamingParserDump oParser;
+                ensure( oParser.Parse(apszValid[i], strlen(apszValid[i]),
+                                      true) );
+                ensure_equals( oParser.GetSerialized(), osExpected );
+            }
+            // Byte per byte
+            {
+                CPLJSonStreamingParserDump oParser;
+                const size_t nLen = strlen(apszValid[i]);
+                for( size_t j = 0; j < nLen; j++ )
+                {
+                    ensure( oParser.Parse(apszValid[i] + j, 1,
+                                          j + 1 == nLen) );
+                }
+                ensure_equals( oParser.GetSerialized(), osExpected );
+            }
+        }
+
+        const char* const apszInvalid[] = {
+            "",
+            "{",
+            "[1,]",
+            "{\"a\" 1}",
+            "{\"a\": 0x1}",
+            "\"unterminated",
+            "nul",
+            "[1] 2",
+            "[[[1]]]"
+        };
+        for( size_t i = 0; i < sizeof(apszInvalid) / sizeof(apszInvalid[0]);
+             i++ )
+        {
+            CPLJSonStreamingParserDump oParser;
+            oParser.SetMaxDepth(2);
+            ensure( !oParser.Parse(apszInvalid[i], strlen(apszInvalid[i]),
+                                   true) );
+            ensure( oParser.ExceptionOccurred() );
+            ensure( !oParser.GetException().empty() );
+        }
+    }
+
 } // namespace tut
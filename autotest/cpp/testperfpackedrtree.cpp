@@ -0,0 +1,156 @@
+/******************************************************************************
+ * $Id$
+ *
+ * Project:  CPL - Common Portability Library
+ * Purpose:  Compare performance of CPLPackedRTree and CPLQuadTree.
+ * Author:   agent <agent at local>
+ *
+ ******************************************************************************
+ * Copyright (c) 2026, agent <agent at local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ****************************************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "cpl_conv.h"
+#include "cpl_packed_rtree.h"
+#include "cpl_quad_tree.h"
+
+static const CPLRectObj* pasGlobalBounds = NULL;
+
+static void GetBounds(const void* hFeature, CPLRectObj* pBounds)
+{
+    *pBounds = pasGlobalBounds[(size_t)hFeature];
+}
+
+int main(int argc, char* argv[])
+{
+    int nFeatures = 1000 * 1000;
+    int nQueries = 100 * 1000;
+    if( argc >= 2 )
+        nFeatures = atoi(argv[1]);
+    if( argc >= 3 )
+        nQueries = atoi(argv[2]);
+
+    CPLRectObj* pasBounds = (CPLRectObj*)CPLMalloc(nFeatures * sizeof(CPLRectObj));
+    void** pahFeatures = (void**)CPLMalloc(nFeatures * sizeof(void*));
+    srand(0);
+    for( int i = 0; i < nFeatures; i++ )
+    {
+        const double dfX = rand() * 10000.0 / RAND_MAX;
+        const double dfY = rand() * 10000.0 / RAND_MAX;
+        pasBounds[i].minx = dfX;
+        pasBounds[i].miny = dfY;
+        pasBounds[i].maxx = dfX + (i % 3);
+        pasBounds[i].maxy = dfY + (i % 5);
+        pahFeatures[i] = (void*)(size_t)i;
+    }
+    pasGlobalBounds = pasBounds;
+
+    CPLRectObj* pasAoi = (CPLRectObj*)CPLMalloc(nQueries * sizeof(CPLRectObj));
+    for( int i = 0; i < nQueries; i++ )
+    {
+        pasAoi[i].minx = rand() * 10000.0 / RAND_MAX;
+        pasAoi[i].miny = rand() * 10000.0 / RAND_MAX;
+        pasAoi[i].maxx = pasAoi[i].minx + 20;
+        pasAoi[i].maxy = pasAoi[i].miny + 20;
+    }
+
+    clock_t start, end;
+    GIntBig nTotalResults = 0;
+
+    // CPLQuadTree
+    {
+        CPLRectObj sGlobalBounds = { 0, 0, 10004, 10006 };
+        start = clock();
+        CPLQuadTree* hQuadTree = CPLQuadTreeCreate(&sGlobalBounds, GetBounds);
+        CPLQuadTreeSetMaxDepth(hQuadTree,
+                               CPLQuadTreeGetAdvisedMaxDepth(nFeatures));
+        for( int i = 0; i < nFeatures; i++ )
+            CPLQuadTreeInsert(hQuadTree, pahFeatures[i]);
+        end = clock();
+        printf("CPLQuadTree build: %.3f s\n",
+               (end - start) * 1.0 / CLOCKS_PER_SEC);
+
+        int nFeatureCount = 0, nNodeCount = 0, nMaxDepth = 0, nMaxBucket = 0;
+        CPLQuadTreeGetStats(hQuadTree, &nFeatureCount, &nNodeCount,
+                            &nMaxDepth, &nMaxBucket);
+        // Approximate memory usage: nodes + feature handle arrays
+        printf("CPLQuadTree memory: ~%.1f MB (%d nodes)\n",
+               (nNodeCount * (4 * sizeof(double) + 2 * sizeof(int) +
+                              6 * sizeof(void*)) +
+                (double)nFeatureCount * sizeof(void*)) / (1024 * 1024),
+               nNodeCount);
+
+        start = clock();
+        nTotalResults = 0;
+        for( int i = 0; i < nQueries; i++ )
+        {
+            int nCount = 0;
+            void** pahRes = CPLQuadTreeSearch(hQuadTree, &pasAoi[i], &nCount);
+            nTotalResults += nCount;
+            CPLFree(pahRes);
+        }
+        end = clock();
+        printf("CPLQuadTree query: %.3f s (" CPL_FRMT_GIB " results)\n",
+               (end - start) * 1.0 / CLOCKS_PER_SEC, nTotalResults);
+        CPLQuadTreeDestroy(hQuadTree);
+    }
+
+    // CPLPackedRTree
+    for( int iOrder = 0; iOrder < 2; iOrder++ )
+    {
+        const char* pszName = iOrder == 0 ? "STR" : "Hilbert";
+        start = clock();
+        CPLPackedRTree* hTree = CPLPackedRTreeCreate(
+            nFeatures, pahFeatures, GetBounds,
+            iOrder == 0 ? CPLPRT_ORDER_STR : CPLPRT_ORDER_HILBERT, 0);
+        end = clock();
+        printf("CPLPackedRTree(%s) build: %.3f s\n", pszName,
+               (end - start) * 1.0 / CLOCKS_PER_SEC);
+
+        int nNodeCount = 0;
+        GUIntBig nMemory = 0;
+        CPLPackedRTreeGetStats(hTree, NULL, &nNodeCount, NULL, &nMemory);
+        printf("CPLPackedRTree(%s) memory: %.1f MB (%d nodes)\n", pszName,
+               nMemory / (1024.0 * 1024), nNodeCount);
+
+        start = clock();
+        nTotalResults = 0;
+        for( int i = 0; i < nQueries; i++ )
+        {
+            int nCount = 0;
+            void** pahRes = CPLPackedRTreeSearch(hTree, &pasAoi[i], &nCount);
+            nTotalResults += nCount;
+            CPLFree(pahRes);
+        }
+        end = clock();
+        printf("CPLPackedRTree(%s) query: %.3f s (" CPL_FRMT_GIB " results)\n",
+               pszName, (end - start) * 1.0 / CLOCKS_PER_SEC, nTotalResults);
+        CPLPackedRTreeDestroy(hTree);
+    }
+
+    CPLFree(pasAoi);
+    CPLFree(pahFeatures);
+    CPLFree(pasBounds);
+    return 0;
+}
@@ -2451,6 +2451,38 @@ def tiff_read_one_strip_no_bytecount():
 
     return 'success'
 
+###############################################################################
+# Test multi-threaded decompression
+
+def tiff_read_multi_threaded():
+
+    src_ds = gdal.Open('data/byte.tif')
+    for options in [ [ 'TILED=YES', 'BLOCKXSIZE=16', 'BLOCKYSIZE=16', 'COMPRESS=DEFLATE' ],
+                     [ 'BLOCKYSIZE=3', 'COMPRESS=LZW', 'INTERLEAVE=PIXEL' ],
+                     [ 'TILED=YES', 'BLOCKXSIZE=16', 'BLOCKYSIZE=16', 'COMPRESS=PACKBITS', 'INTERLEAVE=BAND' ] ]:
+        tmp_ds = gdal.Translate('/vsimem/tiff_read_multi_threaded.tif', src_ds,
+                                bandList = [1, 1, 1], creationOptions = options)
+        tmp_ds = None
+
+        ds = gdal.Open('/vsimem/tiff_read_multi_threaded.tif')
+        expected_data = ds.ReadRaster()
+        ds = None
+
+        ds = gdal.OpenEx('/vsimem/tiff_read_multi_threaded.tif', open_options = ['NUM_THREADS=4'])
+        data = ds.ReadRaster()
+        cs = ds.GetRasterBand(2).Checksum()
+        ds = None
+
+        gdal.Unlink('/vsimem/tiff_read_multi_threaded.tif')
+
+        if data != expected_data or cs != 4672:
+            gdaltest.post_reason('fail')
+            print(options)
+            print(cs)
+            return 'fail'
+
+    return 'success'
+
 ###############################################################################
 
 for item in init_list:
@@ -2513,6 +2545,7 @@ gdaltest_list.append( (tiff_read_logl_as_rgba) )
 gdaltest_list.append( (tiff_read_scanline_more_than_2GB) )
 gdaltest_list.append( (tiff_read_wrong_number_extrasamples) )
 gdaltest_list.append( (tiff_read_one_strip_no_bytecount) )
+gdaltest_list.append( (tiff_read_multi_threaded) )
 
 gdaltest_list.append( (tiff_read_online_1) )
 gdaltest_list.append( (tiff_read_online_2) )
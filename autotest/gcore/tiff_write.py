@@ -6650,6 +6650,168 @@ def tiff_write_149():
 
     return 'success'
 
+###############################################################################
+# Test ZSTD compression, and predictors on multi-band and floating point data
+
+def tiff_write_150():
+
+    md = gdaltest.tiff_drv.GetMetadata()
+    compressions = [ 'DEFLATE' ]
+    if md['DMD_CREATIONOPTIONLIST'].find('ZSTD') >= 0:
+        compressions.append('ZSTD')
+
+    for compression in compressions:
+        ut = gdaltest.GDALTest( 'GTiff', 'byte.tif', 1, 4672,
+                                options = [ 'COMPRESS=' + compression ] )
+        ret = ut.testCreateCopy()
+        if ret != 'success':
+            return ret
+
+        ut = gdaltest.GDALTest( 'GTiff', 'float32.tif', 1, 4672,
+                                options = [ 'COMPRESS=' + compression,
+                                            'PREDICTOR=3' ] )
+        ret = ut.testCreateCopy()
+        if ret != 'success':
+            return ret
+
+        src_ds = gdal.Open('data/rgbsmall.tif')
+        for interleave in [ 'PIXEL', 'BAND' ]:
+            for tiled in [ 'YES', 'NO' ]:
+                ds = gdaltest.tiff_drv.CreateCopy('/vsimem/tiff_write_150.tif',
+                    src_ds, options = [ 'COMPRESS=' + compression,
+                                        'PREDICTOR=2',
+                                        'INTERLEAVE=' + interleave,
+                                        'TILED=' + tiled ] )
+                ds = None
+                ds = gdal.Open('/vsimem/tiff_write_150.tif')
+                if ds.GetMetadataItem('COMPRESSION', 'IMAGE_STRUCTURE') != compression:
+                    gdaltest.post_reason('fail')
+                    print(compression)
+                    return 'fail'
+                for i in range(3):
+                    cs = ds.GetRasterBand(i+1).Checksum()
+                    expected_cs = src_ds.GetRasterBand(i+1).Checksum()
+                    if cs != expected_cs:
+                        gdaltest.post_reason('fail')
+                        print(compression, interleave, tiled, i, cs, expected_cs)
+                        return 'fail'
+                ds = None
+                gdaltest.tiff_drv.Delete('/vsimem/tiff_write_150.tif')
+
+    if 'ZSTD' in compressions:
+        ut = gdaltest.GDALTest( 'GTiff', 'byte.tif', 1, 4672,
+                                options = [ 'COMPRESS=ZSTD', 'ZSTD_LEVEL=1',
+                                            'NUM_THREADS=2' ] )
+        ret = ut.testCreateCopy()
+        if ret != 'success':
+            return ret
+
+    return 'success'
+
+###############################################################################
+# Test COG=YES
+
+def tiff_write_151_cbk_interrupt(pct, message, user_data):
+    return pct < 0.2
+
+def tiff_write_151():
+
+    gdal.FileFromMemBuffer('/vsimem/tiff_write_151_0.tif.tmp.tif', 'foo')
+
+    src_ds = gdal.Open('data/rgbsmall.tif')
+    for i in range(2):
+        ds = gdaltest.tiff_drv.CreateCopy('/vsimem/tiff_write_151_%d.tif' % i,
+            src_ds, options = [ 'COG=YES', 'COMPRESS=JPEG',
+                                'BLOCKXSIZE=16', 'BLOCKYSIZE=16',
+                                'OVERVIEW_RESAMPLING=AVERAGE' ] )
+        ds = None
+    src_ds = None
+
+    if len([ f for f in gdal.ReadDir('/vsimem/') if f.find('.tmp') >= 0 and
+             f != 'tiff_write_151_0.tif.tmp.tif' ]) != 0:
+        gdaltest.post_reason('temporary file not deleted')
+        print(gdal.ReadDir('/vsimem/'))
+        return 'fail'
+
+    # A file that happens to have the name of an obvious temporary file
+    # must be left untouched
+    if gdal.VSIStatL('/vsimem/tiff_write_151_0.tif.tmp.tif') is None:
+        gdaltest.post_reason('existing file deleted')
+        return 'fail'
+    gdal.Unlink('/vsimem/tiff_write_151_0.tif.tmp.tif')
+
+    # Repeated creation must give the same file
+    f = gdal.VSIFOpenL('/vsimem/tiff_write_151_0.tif', 'rb')
+    data0 = gdal.VSIFReadL(1, 1000000, f)
+    gdal.VSIFCloseL(f)
+    f = gdal.VSIFOpenL('/vsimem/tiff_write_151_1.tif', 'rb')
+    data1 = gdal.VSIFReadL(1, 1000000, f)
+    gdal.VSIFCloseL(f)
+    if data0 != data1:
+        gdaltest.post_reason('fail')
+        return 'fail'
+
+    ds = gdal.Open('/vsimem/tiff_write_151_0.tif')
+    if ds.GetMetadataItem('COMPRESSION', 'IMAGE_STRUCTURE') != 'JPEG':
+        gdaltest.post_reason('fail')
+        return 'fail'
+    band = ds.GetRasterBand(1)
+    if band.GetBlockSize() != [16, 16]:
+        gdaltest.post_reason('fail')
+        print(band.GetBlockSize())
+        return 'fail'
+    # 50x50 -> 25x25 -> 13x13
+    if band.GetOverviewCount() != 2:
+        gdaltest.post_reason('fail')
+        print(band.GetOverviewCount())
+        return 'fail'
+    if band.GetOverview(1).XSize != 13:
+        gdaltest.post_reason('fail')
+        print(band.GetOverview(1).XSize)
+        return 'fail'
+    # Imagery of the smallest overview comes first, full resolution last
+    off_ovr1 = int(band.GetOverview(1).GetMetadataItem('BLOCK_OFFSET_0_0', 'TIFF'))
+    off_ovr0 = int(band.GetOverview(0).GetMetadataItem('BLOCK_OFFSET_0_0', 'TIFF'))
+    off_full = int(band.GetMetadataItem('BLOCK_OFFSET_0_0', 'TIFF'))
+    if not (off_ovr1 < off_ovr0 and off_ovr0 < off_full):
+        gdaltest.post_reason('fail')
+        print(off_ovr1, off_ovr0, off_full)
+        return 'fail'
+    ds = None
+
+    gdaltest.tiff_drv.Delete('/vsimem/tiff_write_151_0.tif')
+    gdaltest.tiff_drv.Delete('/vsimem/tiff_write_151_1.tif')
+
+    # The temporary file must also be removed when its creation fails
+    src_ds = gdal.Open('data/rgbsmall.tif')
+    with gdaltest.error_handler():
+        ds = gdaltest.tiff_drv.CreateCopy('/vsimem/tiff_write_151_2.tif',
+            src_ds, options = [ 'COG=YES',
+                                'BLOCKXSIZE=16', 'BLOCKYSIZE=16' ],
+            callback = tiff_write_151_cbk_interrupt)
+    src_ds = None
+    if ds is not None:
+        gdaltest.post_reason('fail')
+        return 'fail'
+    if len([ f for f in gdal.ReadDir('/vsimem/') if f.find('.tmp') >= 0 ]) != 0:
+        gdaltest.post_reason('temporary file not deleted')
+        print(gdal.ReadDir('/vsimem/'))
+        return 'fail'
+    gdal.Unlink('/vsimem/tiff_write_151_2.tif')
+
+    # Streaming output is rejected before reading the source
+    src_ds = gdal.Open('data/rgbsmall.tif')
+    with gdaltest.error_handler():
+        ds = gdaltest.tiff_drv.CreateCopy('/vsistdout/', src_ds,
+                                          options = [ 'COG=YES' ])
+    src_ds = None
+    if ds is not None or gdal.GetLastErrorMsg().find('streaming') < 0:
+        gdaltest.post_reason('fail')
+        print(gdal.GetLastErrorMsg())
+        return 'fail'
+
+    return 'success'
+
 ###############################################################################
 # Ask to run again tests with GDAL_API_PROXY=YES
 
@@ -6829,6 +6991,8 @@ gdaltest_list = [
     tiff_write_147,
     tiff_write_148,
     tiff_write_149,
+    tiff_write_150,
+    tiff_write_151,
     #tiff_write_api_proxy,
     tiff_write_cleanup ]
 
@@ -30,6 +30,9 @@
 # DEALINGS IN THE SOFTWARE.
 ###############################################################################
 
+import base64
+import math
+import random
 import sys
 
 sys.path.append( '../pymod' )
@@ -876,6 +879,248 @@ def transformer_15():
 
     return 'success'
 
+###############################################################################
+# Test interpolation of the source transformer from a precomputed grid
+
+def transformer_16():
+
+    ds = gdal.Open('data/rpc.vrt')
+    tr_exact = gdal.Transformer( ds, None, [ 'METHOD=RPC' ] )
+
+    for interpolation in [ 'BILINEAR', 'CUBIC' ]:
+        tr = gdal.Transformer( ds, None, [ 'METHOD=RPC',
+                                           'SRC_GRID_STEP=64',
+                                           'SRC_GRID_INTERPOLATION=' + interpolation ] )
+
+        for (x, y) in [ (0.5, 0.5), (20.5, 10.5), (1000.25, 1500.75),
+                        (2219.5, 2919.5), (1234.5, 42.125) ]:
+            (success, pnt_exact) = tr_exact.TransformPoint( 0, x, y )
+            (success2, pnt) = tr.TransformPoint( 0, x, y )
+            if not success or not success2 or pnt[2] != 0:
+                print(interpolation, x, y, pnt)
+                gdaltest.post_reason( 'got wrong forward transform result.' )
+                return 'fail'
+
+            # Compare the forward results in source pixels
+            (success, back_exact) = tr_exact.TransformPoint( 1, pnt_exact[0], pnt_exact[1] )
+            (success2, back) = tr_exact.TransformPoint( 1, pnt[0], pnt[1] )
+            if not success or not success2 \
+               or abs(back[0]-back_exact[0]) > 0.2 \
+               or abs(back[1]-back_exact[1]) > 0.2:
+                print(interpolation, x, y, back, back_exact)
+                gdaltest.post_reason( 'got wrong forward transform result.' )
+                return 'fail'
+
+            (success, back_grid) = tr.TransformPoint( 1, pnt_exact[0], pnt_exact[1] )
+            if not success \
+               or abs(back_grid[0]-back_exact[0]) > 0.2 \
+               or abs(back_grid[1]-back_exact[1]) > 0.2:
+                print(interpolation, x, y, back_grid, back_exact)
+                gdaltest.post_reason( 'got wrong reverse transform result.' )
+                return 'fail'
+
+        # Points with a height are not interpolated
+        (success, pnt_exact) = tr_exact.TransformPoint( 0, 20.5, 10.5, 30 )
+        (success2, pnt) = tr.TransformPoint( 0, 20.5, 10.5, 30 )
+        if not success or not success2 or pnt != pnt_exact:
+            print(pnt, pnt_exact)
+            gdaltest.post_reason( 'got wrong forward transform result.' )
+            return 'fail'
+
+    # Grid written, then read back from a file
+    options = [ 'METHOD=RPC', 'SRC_GRID_FILE=/vsimem/transformer_16.xml' ]
+    tr = gdal.Transformer( ds, None, options )
+    (success, pnt) = tr.TransformPoint( 1, 125.65, 39.87 )
+    if not success:
+        gdaltest.post_reason( 'fail' )
+        return 'fail'
+
+    f = gdal.VSIFOpenL('/vsimem/transformer_16.xml', 'rb')
+    content = gdal.VSIFReadL(1, 100000000, f).decode('ascii')
+    gdal.VSIFCloseL(f)
+    if content.find('<InterpGridTransformer>') < 0 or \
+       content.find('<ForwardGrid>') < 0 or \
+       content.find('<RPCTransformer>') < 0:
+        print(content[0:1000])
+        gdaltest.post_reason( 'fail' )
+        return 'fail'
+
+    tr = gdal.Transformer( ds, None, options )
+    (success, pnt2) = tr.TransformPoint( 1, 125.65, 39.87 )
+    if not success or pnt2 != pnt:
+        print(pnt, pnt2)
+        gdaltest.post_reason( 'fail' )
+        return 'fail'
+
+    # A different step must not reuse the grid of the file
+    tr = gdal.Transformer( ds, None, options + [ 'SRC_GRID_STEP=16' ] )
+    f = gdal.VSIFOpenL('/vsimem/transformer_16.xml', 'rb')
+    content = gdal.VSIFReadL(1, 100000000, f).decode('ascii')
+    gdal.VSIFCloseL(f)
+    if content.find('<Step>16</Step>') < 0:
+        print(content[0:1000])
+        gdaltest.post_reason( 'fail' )
+        return 'fail'
+
+    gdal.Unlink('/vsimem/transformer_16.xml')
+
+    # Invalid options
+    with gdaltest.error_handler():
+        tr = gdal.Transformer( ds, None, [ 'METHOD=RPC',
+                                           'SRC_GRID_INTERPOLATION=NEAREST',
+                                           'SRC_GRID_STEP=32' ] )
+    if gdal.GetLastErrorMsg().find('INTERPOLATION') < 0:
+        gdaltest.post_reason( 'fail' )
+        return 'fail'
+
+    return 'success'
+
+###############################################################################
+# Test that the interpolation grid stays close to MAX_ERROR source pixels of a
+# strongly distorted TPS transformation, in both directions, on many random
+# points. MAX_ERROR is only checked at sample points of the grid cells, so it
+# may be slightly exceeded at a few points.
+
+def transformer_17_check(seed):
+
+    rnd = random.Random(seed)
+    size = 4000
+    ds = gdal.GetDriverByName('MEM').Create('', size, size)
+    gcps = []
+    for i in range(200):
+        pixel = rnd.uniform(0, size)
+        line = rnd.uniform(0, size)
+        gcps.append(gdal.GCP(1000 + pixel + rnd.uniform(-150, 150),
+                             5000 - line + rnd.uniform(-150, 150),
+                             0, pixel, line))
+    ds.SetGCPs(gcps, '')
+
+    tr_exact = gdal.Transformer( ds, None, [ 'METHOD=GCP_TPS' ] )
+
+    points = []
+    for i in range(5000):
+        points.append((rnd.uniform(0, size), rnd.uniform(0, size)))
+    # Exact forward results, and at one pixel to the right and bottom to
+    # express the forward errors in source pixels.
+    (fwd_exact, success) = tr_exact.TransformPoints( 0, points )
+    (fwd_right, success) = tr_exact.TransformPoints( 0,
+        [ (x + 1, y) for (x, y) in points ] )
+    (fwd_bottom, success) = tr_exact.TransformPoints( 0,
+        [ (x, y + 1) for (x, y) in points ] )
+    geo_points = [ (x, y) for (x, y, z) in fwd_exact ]
+    (inv_exact, success) = tr_exact.TransformPoints( 1, geo_points )
+
+    max_error = 0.125
+    for interpolation in [ 'BILINEAR', 'CUBIC' ]:
+        tr = gdal.Transformer( ds, None, [ 'METHOD=GCP_TPS',
+                                           'SRC_GRID_STEP=32',
+                                           'SRC_GRID_MAX_ERROR=%g' % max_error,
+                                           'SRC_GRID_INTERPOLATION=' + interpolation ] )
+        (fwd, success) = tr.TransformPoints( 0, points )
+        (inv, success) = tr.TransformPoints( 1, geo_points )
+
+        exceeded = 0
+        for i in range(len(points)):
+            a = fwd_right[i][0] - fwd_exact[i][0]
+            b = fwd_bottom[i][0] - fwd_exact[i][0]
+            c = fwd_right[i][1] - fwd_exact[i][1]
+            d = fwd_bottom[i][1] - fwd_exact[i][1]
+            det = a * d - b * c
+            dx = fwd[i][0] - fwd_exact[i][0]
+            dy = fwd[i][1] - fwd_exact[i][1]
+            err_x = (d * dx - b * dy) / det
+            err_y = (-c * dx + a * dy) / det
+            err = math.sqrt(err_x * err_x + err_y * err_y)
+            if err > max_error:
+                exceeded += 1
+            if err > 1.5 * max_error:
+                print(seed, interpolation, points[i], err_x, err_y)
+                gdaltest.post_reason( 'got wrong forward transform result.' )
+                return 'fail'
+
+            err_x = inv[i][0] - inv_exact[i][0]
+            err_y = inv[i][1] - inv_exact[i][1]
+            err = math.sqrt(err_x * err_x + err_y * err_y)
+            if err > max_error:
+                exceeded += 1
+            if err > 1.5 * max_error:
+                print(seed, interpolation, geo_points[i], err_x, err_y)
+                gdaltest.post_reason( 'got wrong reverse transform result.' )
+                return 'fail'
+
+        if exceeded > 5:
+            print(seed, interpolation, exceeded)
+            gdaltest.post_reason( 'MAX_ERROR exceeded at too many points.' )
+            return 'fail'
+
+    return 'success'
+
+def transformer_17():
+
+    for seed in range(1, 4):
+        ret = transformer_17_check(seed)
+        if ret != 'success':
+            return ret
+
+    return 'success'
+
+###############################################################################
+# Test that corrupted grids read from a file are not trusted beyond what their
+# nodes allow
+
+def transformer_18():
+
+    ds = gdal.Open('data/rpc.vrt')
+    tr_exact = gdal.Transformer( ds, None, [ 'METHOD=RPC' ] )
+    options = [ 'METHOD=RPC', 'SRC_GRID_FILE=/vsimem/transformer_18.xml' ]
+    tr = gdal.Transformer( ds, None, options )
+    tr = None
+
+    f = gdal.VSIFOpenL('/vsimem/transformer_18.xml', 'rb')
+    content = gdal.VSIFReadL(1, 100000000, f).decode('ascii')
+    gdal.VSIFCloseL(f)
+
+    # Flag all cells of both grids as cubic, including the border ones that
+    # have no 4x4 stencil of nodes
+    pos = 0
+    while True:
+        start = content.find('<Cells>', pos)
+        if start < 0:
+            break
+        start += len('<Cells>')
+        end = content.find('</Cells>', start)
+        ncells = len(base64.b64decode(content[start:end]))
+        content = content[0:start] + \
+            base64.b64encode(b'\x02' * ncells).decode('ascii') + content[end:]
+        pos = start
+    gdal.FileFromMemBuffer('/vsimem/transformer_18.xml', content)
+
+    tr = gdal.Transformer( ds, None, options )
+    for (x, y) in [ (0.5, 0.5), (2219.5, 2919.5), (0.5, 2919.5), (1000.25, 1500.75) ]:
+        (success, pnt) = tr.TransformPoint( 0, x, y )
+        (success2, back) = tr_exact.TransformPoint( 1, pnt[0], pnt[1] )
+        if not success or not success2 or \
+           abs(back[0] - x) > 1 or abs(back[1] - y) > 1:
+            print(x, y, pnt, back)
+            gdaltest.post_reason( 'got wrong forward transform result.' )
+            return 'fail'
+
+    # A grid whose size does not match the raster is recomputed
+    content = content.replace('<Size>', '<Size>1')
+    gdal.FileFromMemBuffer('/vsimem/transformer_18.xml', content)
+    tr = gdal.Transformer( ds, None, options )
+    (success, pnt) = tr.TransformPoint( 0, 0.5, 0.5 )
+    (success2, back) = tr_exact.TransformPoint( 1, pnt[0], pnt[1] )
+    if not success or not success2 or \
+       abs(back[0] - 0.5) > 0.2 or abs(back[1] - 0.5) > 0.2:
+        print(pnt, back)
+        gdaltest.post_reason( 'got wrong forward transform result.' )
+        return 'fail'
+
+    gdal.Unlink('/vsimem/transformer_18.xml')
+
+    return 'success'
+
 gdaltest_list = [
     transformer_1,
     transformer_2,
@@ -891,7 +1136,10 @@ gdaltest_list = [
     transformer_12,
     transformer_13,
     transformer_14,
-    transformer_15
+    transformer_15,
+    transformer_16,
+    transformer_17,
+    transformer_18
     ]
 
 disabled_gdaltest_list = [
@@ -1091,6 +1091,266 @@ def vrt_read_24():
 
     return 'success'
 
+###############################################################################
+# Test that the spatial index of sources, used when a band has many sources,
+# gives the same result as iterating over all sources, including for
+# overlapping sources.
+
+def vrt_read_25():
+
+    xml = '<VRTDataset rasterXSize="200" rasterYSize="200">\n'
+    xml += '  <VRTRasterBand dataType="Byte" band="1">\n'
+    for j in range(10):
+        for i in range(10):
+            xml += """    <SimpleSource>
+      <SourceFilename>data/byte.tif</SourceFilename>
+      <SourceBand>1</SourceBand>
+      <SrcRect xOff="%d" yOff="%d" xSize="20" ySize="20"/>
+      <DstRect xOff="%d" yOff="%d" xSize="22" ySize="22"/>
+    </SimpleSource>
+""" % (i, j, i * 20, j * 20)
+    xml += '  </VRTRasterBand>\n</VRTDataset>\n'
+
+    res = []
+    for opt in ['NO', 'YES']:
+        gdal.SetConfigOption('VRT_SOURCES_INDEX', opt)
+        ds = gdal.Open(xml)
+        cs = ds.GetRasterBand(1).Checksum()
+        subwin = ds.ReadRaster(15, 35, 50, 30)
+        minmax = ds.GetRasterBand(1).ComputeRasterMinMax()
+        ds = None
+        gdal.SetConfigOption('VRT_SOURCES_INDEX', None)
+        res.append((cs, subwin, minmax))
+
+    if res[0] != res[1]:
+        gdaltest.post_reason('failure')
+        print(res[0][0], res[0][2], res[1][0], res[1][2])
+        return 'fail'
+
+    return 'success'
+
+###############################################################################
+# Test fetching disjoint sources in parallel with VRT_NUM_THREADS
+
+def vrt_read_26():
+
+    src_ds = gdal.Open('data/byte.tif')
+    xml = '<VRTDataset rasterXSize="40" rasterYSize="40">\n'
+    xml += '  <VRTRasterBand dataType="Byte" band="1">\n'
+    for j in range(2):
+        for i in range(2):
+            filename = '/vsimem/vrt_read_26_%d_%d.tif' % (i, j)
+            gdal.Translate(filename, src_ds, srcWin = [i * 5, j * 5, 15, 15])
+            xml += """    <SimpleSource>
+      <SourceFilename>%s</SourceFilename>
+      <SourceBand>1</SourceBand>
+      <SrcRect xOff="0" yOff="0" xSize="15" ySize="15"/>
+      <DstRect xOff="%d" yOff="%d" xSize="20" ySize="20"/>
+    </SimpleSource>
+""" % (filename, i * 20, j * 20)
+    xml += '  </VRTRasterBand>\n</VRTDataset>\n'
+    src_ds = None
+
+    res = []
+    for num_threads in [None, '4']:
+        gdal.SetConfigOption('VRT_NUM_THREADS', num_threads)
+        ds = gdal.Open(xml)
+        res.append((ds.GetRasterBand(1).Checksum(),
+                    ds.ReadRaster(10, 10, 20, 20),
+                    ds.ReadRaster(0, 0, 40, 40, 13, 13)))
+        ds = None
+        gdal.SetConfigOption('VRT_NUM_THREADS', None)
+
+    for j in range(2):
+        for i in range(2):
+            gdal.Unlink('/vsimem/vrt_read_26_%d_%d.tif' % (i, j))
+
+    if res[0] != res[1]:
+        gdaltest.post_reason('failure')
+        print(res[0][0], res[1][0])
+        return 'fail'
+
+    return 'success'
+
+###############################################################################
+# Test reading a VRT with more source files than the dataset pool can keep
+# opened, including from several threads at once. The number of threads must
+# be limited so that each of them can keep a dataset of the pool opened.
+
+class vrt_read_27_debug_handler:
+    def __init__(self):
+        self.msgs = []
+
+    def handler(self, eErrClass, err_no, msg):
+        if eErrClass == gdal.CE_Debug and msg.find('Limiting to') >= 0:
+            self.msgs.append(msg)
+
+def vrt_read_27():
+
+    src_ds = gdal.Open('data/byte.tif')
+    xml = '<VRTDataset rasterXSize="120" rasterYSize="100">\n'
+    xml += '  <VRTRasterBand dataType="Byte" band="1">\n'
+    for j in range(5):
+        for i in range(6):
+            filename = '/vsimem/vrt_read_27_%d_%d.tif' % (i, j)
+            gdal.Translate(filename, src_ds, srcWin = [i, j, 15, 15])
+            xml += """    <SimpleSource>
+      <SourceFilename>%s</SourceFilename>
+      <SourceBand>1</SourceBand>
+      <SrcRect xOff="0" yOff="0" xSize="15" ySize="15"/>
+      <DstRect xOff="%d" yOff="%d" xSize="20" ySize="20"/>
+    </SimpleSource>
+""" % (filename, i * 20, j * 20)
+    xml += '  </VRTRasterBand>\n</VRTDataset>\n'
+    src_ds = None
+
+    res = []
+    debug = vrt_read_27_debug_handler()
+    for (pool_size, num_threads) in [(None, None), ('3', None), ('3', '4')]:
+        gdal.SetConfigOption('GDAL_MAX_DATASET_POOL_SIZE', pool_size)
+        gdal.SetConfigOption('VRT_NUM_THREADS', num_threads)
+        ds = gdal.Open(xml)
+        old_debug = gdal.GetConfigOption('CPL_DEBUG')
+        gdal.SetConfigOption('CPL_DEBUG', 'ON')
+        gdal.PushErrorHandler(debug.handler)
+        res.append((ds.GetRasterBand(1).Checksum(),
+                    ds.ReadRaster(10, 10, 60, 50)))
+        gdal.PopErrorHandler()
+        gdal.SetConfigOption('CPL_DEBUG', old_debug)
+        ds = None
+        gdal.SetConfigOption('GDAL_MAX_DATASET_POOL_SIZE', None)
+        gdal.SetConfigOption('VRT_NUM_THREADS', None)
+
+    for j in range(5):
+        for i in range(6):
+            gdal.Unlink('/vsimem/vrt_read_27_%d_%d.tif' % (i, j))
+
+    if res[0] != res[1] or res[0] != res[2]:
+        gdaltest.post_reason('failure')
+        print(res[0][0], res[1][0], res[2][0])
+        return 'fail'
+
+    if len(debug.msgs) != 1 or debug.msgs[0].find('Limiting to 2 threads') < 0:
+        gdaltest.post_reason('failure')
+        print(debug.msgs)
+        return 'fail'
+
+    return 'success'
+
+###############################################################################
+# Test that a dataset-level read of a mosaic with many sources uses the
+# spatial index of sources, and that it does not invalidate it for later
+# band-level reads.
+
+class vrt_read_28_debug_handler:
+    def __init__(self):
+        self.nbuilt = 0
+
+    def handler(self, eErrClass, err_no, msg):
+        if eErrClass == gdal.CE_Debug and \
+           msg.find('Built spatial index') >= 0:
+            self.nbuilt = self.nbuilt + 1
+
+def vrt_read_28():
+
+    xml = '<VRTDataset rasterXSize="400" rasterYSize="400">\n'
+    for band in range(1, 4):
+        xml += '  <VRTRasterBand dataType="Byte" band="%d">\n' % band
+        for j in range(10):
+            for i in range(10):
+                xml += """    <SimpleSource>
+      <SourceFilename>data/rgbsmall.tif</SourceFilename>
+      <SourceBand>%d</SourceBand>
+      <SrcRect xOff="%d" yOff="%d" xSize="40" ySize="40"/>
+      <DstRect xOff="%d" yOff="%d" xSize="40" ySize="40"/>
+    </SimpleSource>
+""" % (band, i, j, i * 40, j * 40)
+        xml += '  </VRTRasterBand>\n'
+    xml += '</VRTDataset>\n'
+
+    res = []
+    nbuilt = []
+    for opt in ['NO', None]:
+        gdal.SetConfigOption('VRT_SOURCES_INDEX', opt)
+        ds = gdal.Open(xml)
+        debug = vrt_read_28_debug_handler()
+        old_debug = gdal.GetConfigOption('CPL_DEBUG')
+        gdal.SetConfigOption('CPL_DEBUG', 'ON')
+        gdal.PushErrorHandler(debug.handler)
+        data = ds.ReadRaster(0, 0, 400, 400)
+        data += ds.GetRasterBand(3).ReadRaster(50, 50, 100, 100)
+        data += ds.ReadRaster(10, 10, 300, 300)
+        gdal.PopErrorHandler()
+        gdal.SetConfigOption('CPL_DEBUG', old_debug)
+        ds = None
+        gdal.SetConfigOption('VRT_SOURCES_INDEX', None)
+        res.append(data)
+        nbuilt.append(debug.nbuilt)
+
+    if res[0] != res[1]:
+        gdaltest.post_reason('failure')
+        return 'fail'
+
+    # The index of the last band is built by the first dataset-level read,
+    # and reused afterwards.
+    if nbuilt != [0, 1]:
+        gdaltest.post_reason('failure')
+        print(nbuilt)
+        return 'fail'
+
+    return 'success'
+
+###############################################################################
+# Test that sources entirely outside of the band are skipped by the min/max
+# computations, whether the spatial index of sources is built or not.
+
+def vrt_read_29():
+
+    for (filename, val, stats) in [ ('/vsimem/vrt_read_29_1.tif', 10, (5, 50)),
+                                    ('/vsimem/vrt_read_29_2.tif', 200, (1, 250)) ]:
+        ds = gdal.GetDriverByName('GTiff').Create(filename, 20, 20)
+        ds.GetRasterBand(1).Fill(val)
+        ds.GetRasterBand(1).SetStatistics(stats[0], stats[1], 1, 1)
+        ds = None
+
+    xml = """<VRTDataset rasterXSize="20" rasterYSize="20">
+  <VRTRasterBand dataType="Byte" band="1">
+    <SimpleSource>
+      <SourceFilename>/vsimem/vrt_read_29_1.tif</SourceFilename>
+      <SourceBand>1</SourceBand>
+      <SrcRect xOff="0" yOff="0" xSize="20" ySize="20"/>
+      <DstRect xOff="0" yOff="0" xSize="20" ySize="20"/>
+    </SimpleSource>
+    <SimpleSource>
+      <SourceFilename>/vsimem/vrt_read_29_2.tif</SourceFilename>
+      <SourceBand>1</SourceBand>
+      <SrcRect xOff="0" yOff="0" xSize="20" ySize="20"/>
+      <DstRect xOff="100" yOff="0" xSize="20" ySize="20"/>
+    </SimpleSource>
+  </VRTRasterBand>
+</VRTDataset>"""
+
+    res = []
+    for opt in ['NO', 'YES']:
+        gdal.SetConfigOption('VRT_SOURCES_INDEX', opt)
+        ds = gdal.Open(xml)
+        res.append((ds.GetRasterBand(1).GetMinimum(),
+                    ds.GetRasterBand(1).GetMaximum(),
+                    ds.GetRasterBand(1).ComputeRasterMinMax(True)))
+        ds = None
+        gdal.SetConfigOption('VRT_SOURCES_INDEX', None)
+
+    gdal.Unlink('/vsimem/vrt_read_29_1.tif')
+    gdal.Unlink('/vsimem/vrt_read_29_2.tif')
+
+    for r in res:
+        if r != (5, 50, (5, 50)):
+            gdaltest.post_reason('failure')
+            print(res)
+            return 'fail'
+
+    return 'success'
+
 for item in init_list:
     ut = gdaltest.GDALTest( 'VRT', item[0], item[1], item[2] )
     if ut is None:
@@ -1122,6 +1382,11 @@ gdaltest_list.append( vrt_read_21 )
 gdaltest_list.append( vrt_read_22 )
 gdaltest_list.append( vrt_read_23 )
 gdaltest_list.append( vrt_read_24 )
+gdaltest_list.append( vrt_read_25 )
+gdaltest_list.append( vrt_read_26 )
+gdaltest_list.append( vrt_read_27 )
+gdaltest_list.append( vrt_read_28 )
+gdaltest_list.append( vrt_read_29 )
 
 if __name__ == '__main__':
 
@@ -498,6 +498,54 @@ def mem_9():
 
     return 'success'
 
+###############################################################################
+# Test that RasterIO() requests split between several threads, and nearest
+# neighbour resampling done by the driver, give the same results as the
+# generic implementation.
+
+def mem_10():
+
+    src_ds = gdal.Open('data/rgbsmall.tif')
+    drv = gdal.GetDriverByName('MEM')
+
+    for interleave in [ 'BAND', 'PIXEL' ] :
+        for num_threads in [ '1', '4' ]:
+            out_ds = drv.Create('', 400, 300, 3, options = [
+                'INTERLEAVE=%s' % interleave, 'NUM_THREADS=%s' % num_threads,
+                'HUGE_PAGES=YES'])
+            out_ds.WriteRaster(0, 0, 400, 300,
+                               src_ds.ReadRaster(0, 0, 50, 50, 400, 300))
+            # Reference dataset using the generic RasterIO() implementation
+            ref_ds = gdal.GetDriverByName('GTiff').CreateCopy(
+                '/vsimem/mem_10.tif', out_ds)
+
+            for (win, buf_size, buf_type) in [
+                    ((0, 0, 400, 300), (400, 300), gdal.GDT_Float32),
+                    ((10, 20, 310, 250), (310, 250), gdal.GDT_Int16),
+                    ((0, 0, 400, 300), (133, 99), gdal.GDT_Byte),
+                    ((5, 7, 300, 200), (701, 413), gdal.GDT_UInt16) ]:
+                for ds_type in [ 'dataset', 'band' ]:
+                    got_ds = out_ds
+                    exp_ds = ref_ds
+                    if ds_type == 'band':
+                        got_ds = out_ds.GetRasterBand(2)
+                        exp_ds = ref_ds.GetRasterBand(2)
+                    got_data = got_ds.ReadRaster(win[0], win[1], win[2], win[3],
+                                                 buf_size[0], buf_size[1],
+                                                 buf_type = buf_type)
+                    ref_data = exp_ds.ReadRaster(win[0], win[1], win[2], win[3],
+                                                 buf_size[0], buf_size[1],
+                                                 buf_type = buf_type)
+                    if ref_data != got_data:
+                        gdaltest.post_reason('fail')
+                        print(interleave, num_threads, ds_type, win, buf_size)
+                        return 'fail'
+
+            ref_ds = None
+            gdal.Unlink('/vsimem/mem_10.tif')
+
+    return 'success'
+
 ###############################################################################
 # cleanup
 
@@ -516,6 +564,7 @@ gdaltest_list = [
     mem_7,
     mem_8,
     mem_9,
+    mem_10,
     mem_cleanup ]
 
 if __name__ == '__main__':
@@ -30,6 +30,7 @@
 ###############################################################################
 
 import os
+import struct
 import sys
 from osgeo import gdal
 
@@ -189,6 +190,118 @@ def vrtderived_4():
 
     return 'success'
 
+###############################################################################
+# Check a band math expression
+
+def vrtderived_5():
+
+    src_ds = gdal.GetDriverByName('MEM').Create('', 3, 1, 2, gdal.GDT_Float32)
+    src_ds.GetRasterBand(1).WriteRaster(0, 0, 3, 1, struct.pack('f' * 3, 1, 2, -1))
+    src_ds.GetRasterBand(2).WriteRaster(0, 0, 3, 1, struct.pack('f' * 3, 3, 2, 5))
+    src_ds.GetRasterBand(1).SetNoDataValue(-1)
+    gdal.GetDriverByName('GTiff').CreateCopy('/vsimem/vrtderived_5.tif', src_ds)
+    src_ds = None
+
+    xml = """<VRTDataset rasterXSize="3" rasterYSize="1">
+  <VRTRasterBand dataType="Float32" band="1" subClass="VRTDerivedRasterBand">
+    <NoDataValue>-1</NoDataValue>
+    <PixelFunctionExpression>(B2-B1)/(B2+B1) + (B1 &lt; B2 ? 10 : 0)</PixelFunctionExpression>
+    <SimpleSource>
+      <SourceFilename>/vsimem/vrtderived_5.tif</SourceFilename>
+      <SourceBand>1</SourceBand>
+    </SimpleSource>
+    <SimpleSource>
+      <SourceFilename>/vsimem/vrtderived_5.tif</SourceFilename>
+      <SourceBand>2</SourceBand>
+    </SimpleSource>
+  </VRTRasterBand>
+</VRTDataset>"""
+
+    for num_threads in [None, '4']:
+        gdal.SetConfigOption('VRT_NUM_THREADS', num_threads)
+        ds = gdal.Open(xml)
+        data = struct.unpack('f' * 3, ds.GetRasterBand(1).ReadRaster())
+        ds = None
+        gdal.SetConfigOption('VRT_NUM_THREADS', None)
+        if data != (10.5, 0.0, -1.0):
+            gdaltest.post_reason('fail')
+            print(num_threads)
+            print(data)
+            return 'fail'
+
+    # Test that the expression is serialized
+    ds = gdal.GetDriverByName('VRT').CreateCopy('', gdal.Open(xml))
+    if ds.GetMetadata('xml:VRT')[0].find('<PixelFunctionExpression>') < 0:
+        gdaltest.post_reason('fail')
+        print(ds.GetMetadata('xml:VRT')[0])
+        return 'fail'
+    ds = None
+
+    # Reasonably nested expressions are accepted
+    ds = gdal.Open(xml.replace('(B2-B1)/(B2+B1) + (B1 &lt; B2 ? 10 : 0)',
+                               '(' * 100 + 'B1' + ')' * 100))
+    if ds is None:
+        gdaltest.post_reason('fail')
+        return 'fail'
+    ds = None
+
+    # Invalid expressions are detected when opening the dataset, including
+    # too deeply nested ones that would exhaust the stack of the parser
+    for expr in ['B3', '(B1', 'B1 +* 2', 'foo(B1)', 'min(B1)',
+                 '(' * 200000 + 'B1' + ')' * 200000,
+                 '-' * 200000 + 'B1',
+                 'B1' + '^B1' * 200000]:
+        gdal.PushErrorHandler('CPLQuietErrorHandler')
+        ds = gdal.Open(xml.replace('(B2-B1)/(B2+B1) + (B1 &lt; B2 ? 10 : 0)', expr))
+        gdal.PopErrorHandler()
+        if ds is not None:
+            gdaltest.post_reason('fail')
+            print(expr)
+            return 'fail'
+
+    gdal.Unlink('/vsimem/vrtderived_5.tif')
+
+    return 'success'
+
+###############################################################################
+# Check built-in pixel functions
+
+def vrtderived_6():
+
+    src_ds = gdal.GetDriverByName('MEM').Create('', 1, 1, 2, gdal.GDT_Float32)
+    src_ds.GetRasterBand(1).Fill(2)
+    src_ds.GetRasterBand(2).Fill(6)
+    gdal.GetDriverByName('GTiff').CreateCopy('/vsimem/vrtderived_6.tif', src_ds)
+    src_ds = None
+
+    for (func, nsources, expected) in [ ('sum', 2, 8), ('diff', 2, -4),
+                                        ('mul', 2, 12), ('div', 2, 1. / 3),
+                                        ('ndvi', 2, 0.5), ('inv', 1, 0.5),
+                                        ('dB2amp', 1, 10 ** 0.1) ]:
+        xml = """<VRTDataset rasterXSize="1" rasterYSize="1">
+  <VRTRasterBand dataType="Float64" band="1" subClass="VRTDerivedRasterBand">
+    <PixelFunctionType>%s</PixelFunctionType>""" % func
+        for i in range(nsources):
+            xml += """
+    <SimpleSource>
+      <SourceFilename>/vsimem/vrtderived_6.tif</SourceFilename>
+      <SourceBand>%d</SourceBand>
+    </SimpleSource>""" % (i + 1)
+        xml += """
+  </VRTRasterBand>
+</VRTDataset>"""
+        ds = gdal.Open(xml)
+        val = struct.unpack('d', ds.GetRasterBand(1).ReadRaster())[0]
+        if abs(val - expected) > 1e-10:
+            gdaltest.post_reason('fail')
+            print(func)
+            print(val)
+            return 'fail'
+
+    gdal.Unlink('/vsimem/vrtderived_6.tif')
+
+    return 'success'
+
 ###############################################################################
 # Cleanup.
 
@@ -204,6 +317,8 @@ gdaltest_list = [
     vrtderived_2,
     vrtderived_3,
     vrtderived_4,
+    vrtderived_5,
+    vrtderived_6,
     vrtderived_cleanup,
 ]
 
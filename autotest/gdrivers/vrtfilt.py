@@ -146,6 +146,72 @@ def vrtfilt_5():
 
     return 'success'
 
+###############################################################################
+# Test separable kernels, declared with Size coefficients, or detected from
+# a full 2D kernel, with and without nodata.
+
+def vrtfilt_6():
+
+    template = """<VRTDataset rasterXSize="50" rasterYSize="50">
+  <VRTRasterBand dataType="Byte" band="1">
+    <KernelFilteredSource>
+      <SourceFilename>%s</SourceFilename>
+      <SourceBand>1</SourceBand>
+      <Kernel normalized="1">
+        <Size>5</Size>
+        <Coefs>%s</Coefs>
+      </Kernel>
+    </KernelFilteredSource>
+  </VRTRasterBand>
+</VRTDataset>"""
+
+    coefs_1d = [1, 4, 6, 4, 1]
+    coefs_2d = [a * b for a in coefs_1d for b in coefs_1d]
+    coefs_1d = ' '.join(['%d' % x for x in coefs_1d])
+    coefs_2d = ' '.join(['%d' % x for x in coefs_2d])
+
+    ds = gdal.Translate('/vsimem/vrtfilt_6.tif', 'data/rgbsmall.tif',
+                        bandList = [1], noData = 0)
+    ds = None
+
+    # Checksums computed by applying the full 5x5 kernel, as done before
+    # separable kernels were detected.
+    for (filename, cs_expected) in [ ('data/rgbsmall.tif', 21713),
+                                     ('/vsimem/vrtfilt_6.tif', 21186) ]:
+        ds = gdal.Open(template % (filename, coefs_2d))
+        cs_2d = ds.GetRasterBand(1).Checksum()
+        ds = None
+
+        ds = gdal.Open(template % (filename, coefs_1d))
+        cs_1d = ds.GetRasterBand(1).Checksum()
+        if cs_1d != cs_expected or cs_2d != cs_expected:
+            gdaltest.post_reason('fail')
+            print(filename, cs_1d, cs_2d, cs_expected)
+            return 'fail'
+
+        # The kernel should be serialized as it was declared
+        gdal.Unlink('/vsimem/vrtfilt_6.vrt')
+        gdal.GetDriverByName('VRT').CreateCopy('/vsimem/vrtfilt_6.vrt', ds)
+        ds = None
+        fp = gdal.VSIFOpenL('/vsimem/vrtfilt_6.vrt', 'rb')
+        content = gdal.VSIFReadL(1, 10000, fp).decode('ascii')
+        gdal.VSIFCloseL(fp)
+        gdal.Unlink('/vsimem/vrtfilt_6.vrt')
+        if content.find('<Coefs>1 4 6 4 1 </Coefs>') < 0:
+            gdaltest.post_reason('fail')
+            print(content)
+            return 'fail'
+
+    gdal.Unlink('/vsimem/vrtfilt_6.tif')
+
+    with gdaltest.error_handler():
+        ds = gdal.Open(template % ('data/rgbsmall.tif', '1 2 1'))
+    if ds is not None:
+        gdaltest.post_reason('fail')
+        return 'fail'
+
+    return 'success'
+
 ###############################################################################
 # Cleanup.
 
@@ -158,6 +224,7 @@ gdaltest_list = [
     vrtfilt_3,
     vrtfilt_4,
     vrtfilt_5,
+    vrtfilt_6,
     vrtfilt_cleanup ]
 
 if __name__ == '__main__':
@@ -29,9 +29,11 @@
 ###############################################################################
 
 import os
+import re
 import shutil
 import sys
 from osgeo import gdal
+from osgeo import osr
 
 sys.path.append( '../pymod' )
 
@@ -491,6 +493,233 @@ def vrtwarp_11():
 
     return 'success'
 
+###############################################################################
+# Test warping several blocks at once, for requests spanning several blocks
+# and for sequential block readers
+
+def vrtwarp_12():
+
+    ds = gdal.Warp('tmp/vrtwarp_12.vrt', '../gcore/data/byte.tif',
+                   format = 'VRT', width = 100, height = 100)
+    ds = None
+    xml = open('tmp/vrtwarp_12.vrt').read()
+    xml = xml.replace('<BlockXSize>100</BlockXSize>', '<BlockXSize>16</BlockXSize>')
+    xml = xml.replace('<BlockYSize>100</BlockYSize>', '<BlockYSize>16</BlockYSize>')
+    open('tmp/vrtwarp_12.vrt', 'wt').write(xml)
+    vrt_filename = 'tmp/vrtwarp_12.vrt'
+
+    gdal.SetConfigOption('VRT_WARP_MULTI_BLOCK', 'NO')
+    ds = gdal.Open(vrt_filename)
+    (blockx, blocky) = ds.GetRasterBand(1).GetBlockSize()
+    ref_data = ds.GetRasterBand(1).ReadRaster()
+    ds = None
+    gdal.SetConfigOption('VRT_WARP_MULTI_BLOCK', None)
+    if (blockx, blocky) != (16, 16):
+        gdaltest.post_reason('fail')
+        print(blockx, blocky)
+        return 'fail'
+
+    # Requests spanning several blocks
+    for multi_block in [None, 'YES']:
+        gdal.SetConfigOption('VRT_WARP_MULTI_BLOCK', multi_block)
+        ds = gdal.Open(vrt_filename)
+        data = ds.GetRasterBand(1).ReadRaster()
+        ds = None
+        gdal.SetConfigOption('VRT_WARP_MULTI_BLOCK', None)
+        if data != ref_data:
+            gdaltest.post_reason('fail')
+            print(multi_block)
+            return 'fail'
+
+    # Block by block reading, with the next blocks of the row warped ahead
+    gdal.SetConfigOption('VRT_WARP_READ_AHEAD', '3')
+    ds = gdal.Open(vrt_filename)
+    mem_ds = gdal.GetDriverByName('MEM').Create('', 100, 100)
+    for y in range(0, 100, 16):
+        for x in range(0, 100, 16):
+            xsize = min(16, 100 - x)
+            ysize = min(16, 100 - y)
+            mem_ds.GetRasterBand(1).WriteRaster(x, y, xsize, ysize,
+                ds.GetRasterBand(1).ReadRaster(x, y, xsize, ysize))
+    ds = None
+    gdal.SetConfigOption('VRT_WARP_READ_AHEAD', None)
+    gdal.Unlink('tmp/vrtwarp_12.vrt')
+    if mem_ds.GetRasterBand(1).ReadRaster() != ref_data:
+        gdaltest.post_reason('fail')
+        return 'fail'
+
+    return 'success'
+
+###############################################################################
+# Test that one large read of a non-trivial warp (2nd order polynomial)
+# gives the same result as block by block reading, with the approximate
+# transformer (multi-block warping disabled by default) and with the exact
+# one (multi-block warping enabled by default).
+
+def vrtwarp_13_read(filename, blocks):
+
+    ds = gdal.Open(filename)
+    xsize = ds.RasterXSize
+    ysize = ds.RasterYSize
+    if not blocks:
+        data = ds.GetRasterBand(1).ReadRaster()
+        ds = None
+        return data
+
+    mem_ds = gdal.GetDriverByName('MEM').Create('', xsize, ysize)
+    for y in range(0, ysize, 64):
+        for x in range(0, xsize, 64):
+            w = min(64, xsize - x)
+            h = min(64, ysize - y)
+            mem_ds.GetRasterBand(1).WriteRaster(x, y, w, h,
+                ds.GetRasterBand(1).ReadRaster(x, y, w, h))
+    ds = None
+    return mem_ds.GetRasterBand(1).ReadRaster()
+
+def vrtwarp_13():
+
+    size = 400
+    src_ds = gdal.GetDriverByName('GTiff').Create('/vsimem/vrtwarp_13.tif',
+                                                  size, size)
+    data = bytearray(size * size)
+    for j in range(size):
+        for i in range(size):
+            data[j * size + i] = (i * 7 + j * 13 + (i * j) % 17) % 256
+    src_ds.GetRasterBand(1).WriteRaster(0, 0, size, size, bytes(data))
+    gcps = []
+    for j in range(3):
+        for i in range(3):
+            gcps.append(gdal.GCP(2 + i * 0.5 + 0.03 * j * j + 0.02 * i * j,
+                                 49 - j * 0.5 + 0.04 * i * i - 0.01 * i * j,
+                                 0, i * size / 2, j * size / 2))
+    src_ds.SetGCPs(gcps, osr.SRS_WKT_WGS84)
+    src_ds = None
+
+    for et in [0.125, 0]:
+        ds = gdal.Warp('/vsimem/vrtwarp_13.vrt', '/vsimem/vrtwarp_13.tif',
+                       format = 'VRT', polynomialOrder = 2,
+                       errorThreshold = et)
+        ds = None
+        f = gdal.VSIFOpenL('/vsimem/vrtwarp_13.vrt', 'rb')
+        xml = gdal.VSIFReadL(1, 100000, f).decode('ascii')
+        gdal.VSIFCloseL(f)
+        xml = re.sub('<BlockXSize>[0-9]*</BlockXSize>',
+                     '<BlockXSize>64</BlockXSize>', xml)
+        xml = re.sub('<BlockYSize>[0-9]*</BlockYSize>',
+                     '<BlockYSize>64</BlockYSize>', xml)
+        gdal.FileFromMemBuffer('/vsimem/vrtwarp_13.vrt', xml)
+
+        gdal.SetConfigOption('VRT_WARP_MULTI_BLOCK', 'NO')
+        ref_data = vrtwarp_13_read('/vsimem/vrtwarp_13.vrt', True)
+        gdal.SetConfigOption('VRT_WARP_MULTI_BLOCK', None)
+
+        data = vrtwarp_13_read('/vsimem/vrtwarp_13.vrt', False)
+        if data != ref_data:
+            gdaltest.post_reason('fail')
+            print(et)
+            return 'fail'
+
+    gdal.Unlink('/vsimem/vrtwarp_13.vrt')
+    gdal.Unlink('/vsimem/vrtwarp_13.tif')
+
+    return 'success'
+
+###############################################################################
+# Test that a read spanning several blocks does not warp again the blocks that
+# are already in the block cache.
+
+class vrtwarp_14_debug_handler:
+    def __init__(self):
+        self.warped_blocks = 0
+
+    def handler(self, eErrClass, err_no, msg):
+        if eErrClass == gdal.CE_Debug and msg.find('Warping ') >= 0:
+            tokens = msg[msg.find('Warping '):].split(' ')
+            self.warped_blocks += int(tokens[1]) * int(tokens[3])
+
+def vrtwarp_14():
+
+    ds = gdal.Warp('/vsimem/vrtwarp_14.vrt', '../gcore/data/byte.tif',
+                   format = 'VRT', width = 100, height = 100)
+    ds = None
+    f = gdal.VSIFOpenL('/vsimem/vrtwarp_14.vrt', 'rb')
+    xml = gdal.VSIFReadL(1, 100000, f).decode('ascii')
+    gdal.VSIFCloseL(f)
+    xml = xml.replace('<BlockXSize>100</BlockXSize>', '<BlockXSize>16</BlockXSize>')
+    xml = xml.replace('<BlockYSize>100</BlockYSize>', '<BlockYSize>16</BlockYSize>')
+    gdal.FileFromMemBuffer('/vsimem/vrtwarp_14.vrt', xml)
+
+    gdal.SetConfigOption('VRT_WARP_MULTI_BLOCK', 'NO')
+    ds = gdal.Open('/vsimem/vrtwarp_14.vrt')
+    ref_data = ds.GetRasterBand(1).ReadRaster()
+    ds = None
+
+    gdal.SetConfigOption('VRT_WARP_MULTI_BLOCK', 'YES')
+    ds = gdal.Open('/vsimem/vrtwarp_14.vrt')
+    debug = vrtwarp_14_debug_handler()
+    old_debug = gdal.GetConfigOption('CPL_DEBUG')
+    gdal.SetConfigOption('CPL_DEBUG', 'ON')
+    gdal.PushErrorHandler(debug.handler)
+    # Blocks (1,1) and (2,1)
+    ds.GetRasterBand(1).ReadRaster(16, 16, 32, 16)
+    # The 47 other blocks of the 7x7 ones
+    data = ds.GetRasterBand(1).ReadRaster()
+    gdal.PopErrorHandler()
+    gdal.SetConfigOption('CPL_DEBUG', old_debug)
+    gdal.SetConfigOption('VRT_WARP_MULTI_BLOCK', None)
+    ds = None
+    gdal.Unlink('/vsimem/vrtwarp_14.vrt')
+
+    if data != ref_data:
+        gdaltest.post_reason('fail')
+        return 'fail'
+    if debug.warped_blocks != 49:
+        gdaltest.post_reason('fail')
+        print(debug.warped_blocks)
+        return 'fail'
+
+    return 'success'
+
+###############################################################################
+# Test that a read spanning several blocks of a heavily downsampled warp is
+# split in regions whose source window fits in the warp memory limit.
+
+def vrtwarp_15():
+
+    src_ds = gdal.GetDriverByName('GTiff').Create('/vsimem/vrtwarp_15.tif',
+                                                  50000, 50000,
+                                                  options = ['SPARSE_OK=YES', 'TILED=YES'])
+    src_ds.SetGeoTransform([100, 1, 0, 100000, 0, -1])
+    sr = osr.SpatialReference()
+    sr.SetWellKnownGeogCS('WGS84')
+    sr.SetUTM(31)
+    src_ds.SetProjection(sr.ExportToWkt())
+    src_ds = None
+
+    ds = gdal.Warp('/vsimem/vrtwarp_15.vrt', '/vsimem/vrtwarp_15.tif',
+                   format = 'VRT', width = 2000, height = 2000,
+                   errorThreshold = 0)
+    ds = None
+
+    gdal.SetConfigOption('VRT_WARP_MULTI_BLOCK', 'NO')
+    ds = gdal.Open('/vsimem/vrtwarp_15.vrt')
+    ref_data = ds.GetRasterBand(1).ReadRaster()
+    ds = None
+    gdal.SetConfigOption('VRT_WARP_MULTI_BLOCK', None)
+
+    ds = gdal.Open('/vsimem/vrtwarp_15.vrt')
+    data = ds.GetRasterBand(1).ReadRaster()
+    ds = None
+
+    gdal.Unlink('/vsimem/vrtwarp_15.vrt')
+    gdal.Unlink('/vsimem/vrtwarp_15.tif')
+
+    if data is None or data != ref_data:
+        gdaltest.post_reason('fail')
+        return 'fail'
+
+    return 'success'
+
 gdaltest_list = [
     vrtwarp_1,
     vrtwarp_2,
@@ -502,7 +731,11 @@ gdaltest_list = [
     vrtwarp_8,
     vrtwarp_9,
     vrtwarp_10,
-    vrtwarp_11
+    vrtwarp_11,
+    vrtwarp_12,
+    vrtwarp_13,
+    vrtwarp_14,
+    vrtwarp_15
      ]
 
 
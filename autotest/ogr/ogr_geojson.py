@@ -2713,6 +2713,117 @@ def ogr_geojson_54():
         return 'fail'
     return 'success'
 
+###############################################################################
+# Test streaming reading of a FeatureCollection and compare it with the
+# in-memory ingestion
+
+def ogr_geojson_55():
+    if gdaltest.geojson_drv is None:
+        return 'skip'
+
+    gdal.FileFromMemBuffer('/vsimem/ogr_geojson_55.json',
+"""{ "type": "FeatureCollection",
+  "features": [
+      { "type": "Feature", "id": 10, "properties": { "a": 1 }, "geometry": { "type": "Point", "coordinates": [ 1, 2 ] } },
+      { "type": "Feature", "id": 3, "properties": { "b": "foo" }, "geometry": null },
+      { "type": "Feature", "id": 7, "properties": { "a": 2.5 }, "geometry": { "type": "Point", "coordinates": [ 3, 4 ] } }
+  ],
+  "crs": { "type": "name", "properties": { "name": "urn:ogc:def:crs:EPSG::32631" } }
+}""")
+
+    res = []
+    for streaming in [ 'YES', 'NO' ]:
+        gdal.SetConfigOption('OGR_GEOJSON_STREAMING', streaming)
+        ds = ogr.Open('/vsimem/ogr_geojson_55.json')
+        gdal.SetConfigOption('OGR_GEOJSON_STREAMING', None)
+        lyr = ds.GetLayer(0)
+        if lyr.GetFeatureCount() != 3:
+            gdaltest.post_reason('fail')
+            print(streaming)
+            return 'fail'
+        if lyr.GetLayerDefn().GetFieldDefn(0).GetType() != ogr.OFTReal:
+            gdaltest.post_reason('fail')
+            print(streaming)
+            return 'fail'
+        if lyr.GetSpatialRef().GetAuthorityCode(None) != '32631':
+            gdaltest.post_reason('fail')
+            print(streaming)
+            return 'fail'
+        f = lyr.GetFeature(7)
+        if f is None or f.GetField('a') != 2.5:
+            gdaltest.post_reason('fail')
+            print(streaming)
+            return 'fail'
+        if lyr.GetFeature(4) is not None:
+            gdaltest.post_reason('fail')
+            print(streaming)
+            return 'fail'
+        lyr.SetAttributeFilter('a IS NOT NULL')
+        if lyr.GetFeatureCount() != 2:
+            gdaltest.post_reason('fail')
+            print(streaming)
+            return 'fail'
+        lyr.SetAttributeFilter(None)
+        out = []
+        for f in lyr:
+            out.append(f.ExportToJson())
+        res.append(out)
+        ds = None
+
+    gdal.Unlink('/vsimem/ogr_geojson_55.json')
+
+    if res[0] != res[1]:
+        gdaltest.post_reason('fail')
+        print(res)
+        return 'fail'
+
+    return 'success'
+
+###############################################################################
+# Test that the layer geometry type established from the parsing events of
+# the geometries in streaming mode is the one of the in-memory ingestion
+
+def ogr_geojson_56():
+    if gdaltest.geojson_drv is None:
+        return 'skip'
+
+    docs = [
+        """{ "type": "FeatureCollection", "features": [
+  { "type": "Feature", "properties": {}, "geometry": { "type": "Point", "coordinates": [ 1, 2, 3 ] } },
+  { "type": "Feature", "properties": {}, "geometry": { "type": "Point", "coordinates": [ 1, 2 ] } } ] }""",
+        """{ "type": "FeatureCollection", "features": [
+  { "type": "Feature", "properties": {}, "geometry": { "type": "Point", "coordinates": [] } },
+  { "type": "Feature", "properties": {}, "geometry": { "type": "Unknown", "coordinates": [ 1, 2 ] } },
+  { "type": "Feature", "properties": {}, "geometry": { "type": "LineString", "coordinates": [ [ 1, 2 ], [ 3, 4 ] ], "bbox": [ 1, 2, 3, 4 ] } } ] }""",
+        """{ "type": "FeatureCollection", "features": [
+  { "type": "Feature", "properties": {}, "geometry": { "type": "GeometryCollection", "geometries": [
+    { "type": "Point", "coordinates": [ 1, 2 ] },
+    { "type": "LineString", "coordinates": [ [ 1, 2, 5 ], [ 3, 4, 6 ] ] } ] } } ] }""",
+        """{ "type": "FeatureCollection", "features": [
+  { "type": "Feature", "properties": {}, "geometry": null },
+  { "type": "Feature", "properties": {}, "geometry": { "type": "MultiPolygon", "coordinates": [ [ [ [ 0, 0, 1 ], [ 0, 1, 1 ], [ 1, 1, 1 ], [ 0, 0, 1 ] ] ] ] } } ] }""" ]
+
+    for doc in docs:
+        gdal.FileFromMemBuffer('/vsimem/ogr_geojson_56.json', doc)
+        for as_collection in [ None, 'YES' ]:
+            res = []
+            for streaming in [ 'YES', 'NO' ]:
+                gdal.SetConfigOption('GEOMETRY_AS_COLLECTION', as_collection)
+                gdal.SetConfigOption('OGR_GEOJSON_STREAMING', streaming)
+                ds = ogr.Open('/vsimem/ogr_geojson_56.json')
+                gdal.SetConfigOption('OGR_GEOJSON_STREAMING', None)
+                gdal.SetConfigOption('GEOMETRY_AS_COLLECTION', None)
+                res.append(ds.GetLayer(0).GetGeomType())
+                ds = None
+            if res[0] != res[1]:
+                gdaltest.post_reason('fail')
+                print(doc, as_collection, res)
+                return 'fail'
+
+    gdal.Unlink('/vsimem/ogr_geojson_56.json')
+
+    return 'success'
+
 gdaltest_list = [
     ogr_geojson_1,
     ogr_geojson_2,
@@ -2768,6 +2879,8 @@ gdaltest_list = [
     ogr_geojson_52,
     ogr_geojson_53,
     ogr_geojson_54,
+    ogr_geojson_55,
+    ogr_geojson_56,
     ogr_geojson_cleanup ]
 
 if __name__ == '__main__':
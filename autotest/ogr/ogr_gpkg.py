@@ -2078,6 +2078,89 @@ def ogr_gpkg_31():
 
     return 'success'
 
+###############################################################################
+# Test deferred update of the spatial index within a transaction
+
+def ogr_gpkg_32():
+
+    if gdaltest.gpkg_dr is None:
+        return 'skip'
+
+    ds = gdaltest.gpkg_dr.CreateDataSource('/vsimem/ogr_gpkg_32.gpkg')
+    lyr = ds.CreateLayer('test', geom_type = ogr.wkbPoint)
+    # Force the creation of the spatial index
+    lyr.ResetReading()
+    lyr.GetNextFeature()
+    ds = None
+
+    ds = ogr.Open('/vsimem/ogr_gpkg_32.gpkg', update = 1)
+    lyr = ds.GetLayer(0)
+    lyr.StartTransaction()
+    for i in range(1000):
+        f = ogr.Feature(lyr.GetLayerDefn())
+        if i == 500:
+            f.SetGeometryDirectly(ogr.CreateGeometryFromWkt('POINT EMPTY'))
+        elif i != 501:
+            f.SetGeometryDirectly(ogr.CreateGeometryFromWkt('POINT(%d %d)' % (i % 37, i % 41)))
+        lyr.CreateFeature(f)
+    # Triggers are restored before reading
+    sql_lyr = ds.ExecuteSQL("SELECT COUNT(*) FROM sqlite_master WHERE type = 'trigger' AND name = 'rtree_test_geom_insert'")
+    f = sql_lyr.GetNextFeature()
+    if f.GetField(0) != 1:
+        gdaltest.post_reason('fail')
+        return 'fail'
+    ds.ReleaseResultSet(sql_lyr)
+    # Append a second batch in the same transaction
+    for i in range(10):
+        f = ogr.Feature(lyr.GetLayerDefn())
+        f.SetGeometryDirectly(ogr.CreateGeometryFromWkt('POINT(100 100)'))
+        lyr.CreateFeature(f)
+    lyr.CommitTransaction()
+
+    # Rolled back features must not end up in the RTree
+    lyr.StartTransaction()
+    f = ogr.Feature(lyr.GetLayerDefn())
+    f.SetGeometryDirectly(ogr.CreateGeometryFromWkt('POINT(200 200)'))
+    lyr.CreateFeature(f)
+    lyr.RollbackTransaction()
+    ds = None
+
+    ds = ogr.Open('/vsimem/ogr_gpkg_32.gpkg')
+    sql_lyr = ds.ExecuteSQL("SELECT COUNT(*) FROM rtree_test_geom")
+    f = sql_lyr.GetNextFeature()
+    if f.GetField(0) != 1008:
+        gdaltest.post_reason('fail')
+        f.DumpReadable()
+        return 'fail'
+    ds.ReleaseResultSet(sql_lyr)
+
+    sql_lyr = ds.ExecuteSQL("SELECT COUNT(*) FROM test t JOIN rtree_test_geom r ON t.fid = r.id WHERE r.minx = ST_MinX(t.geom) AND r.maxx = ST_MaxX(t.geom) AND r.miny = ST_MinY(t.geom) AND r.maxy = ST_MaxY(t.geom)")
+    f = sql_lyr.GetNextFeature()
+    if f.GetField(0) != 1008:
+        gdaltest.post_reason('fail')
+        f.DumpReadable()
+        return 'fail'
+    ds.ReleaseResultSet(sql_lyr)
+
+    sql_lyr = ds.ExecuteSQL("SELECT COUNT(*) FROM sqlite_master WHERE type = 'trigger' AND name LIKE 'rtree_test_geom_%'")
+    f = sql_lyr.GetNextFeature()
+    if f.GetField(0) != 6:
+        gdaltest.post_reason('fail')
+        f.DumpReadable()
+        return 'fail'
+    ds.ReleaseResultSet(sql_lyr)
+
+    lyr = ds.GetLayer(0)
+    lyr.SetSpatialFilterRect(99, 99, 101, 101)
+    if lyr.GetFeatureCount() != 10:
+        gdaltest.post_reason('fail')
+        return 'fail'
+    ds = None
+
+    gdaltest.gpkg_dr.DeleteDataSource('/vsimem/ogr_gpkg_32.gpkg')
+
+    return 'success'
+
 ###############################################################################
 # Run test_ogrsf
 
@@ -2167,6 +2250,7 @@ gdaltest_list = [
     ogr_gpkg_29,
     ogr_gpkg_30,
     ogr_gpkg_31,
+    ogr_gpkg_32,
     ogr_gpkg_test_ogrsf,
     ogr_gpkg_cleanup,
 ]
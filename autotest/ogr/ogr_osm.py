@@ -30,7 +30,9 @@
 ###############################################################################
 
 import os
+import struct
 import sys
+import zlib
 from osgeo import ogr
 from osgeo import gdal
 
@@ -767,6 +769,204 @@ def ogr_osm_14():
 
     return 'success'
 
+###############################################################################
+# Write a .pbf file with several compressed data blocks, so that their
+# decoding can be dispatched to several threads. Nodes are on a grid and
+# carry a name, and each way is a line through 10 consecutive nodes.
+
+def ogr_osm_pbf_varint(val):
+    ret = bytearray()
+    while val >= 0x80:
+        ret.append((val & 0x7f) | 0x80)
+        val = val >> 7
+    ret.append(val)
+    return ret
+
+def ogr_osm_pbf_packed(vals, zigzag = False):
+    ret = bytearray()
+    prev = 0
+    for val in vals:
+        if zigzag:
+            delta = val - prev
+            prev = val
+            ret += ogr_osm_pbf_varint((delta << 1) ^ (delta >> 63))
+        else:
+            ret += ogr_osm_pbf_varint(val)
+    return ret
+
+def ogr_osm_pbf_field(num, data):
+    return ogr_osm_pbf_varint((num << 3) | 2) + \
+           ogr_osm_pbf_varint(len(data)) + data
+
+def ogr_osm_pbf_blob(blob_type, block):
+    blob = ogr_osm_pbf_varint((2 << 3) | 0) + ogr_osm_pbf_varint(len(block)) + \
+           ogr_osm_pbf_field(3, bytearray(zlib.compress(bytes(block))))
+    header = ogr_osm_pbf_field(1, bytearray(blob_type.encode('ascii'))) + \
+             ogr_osm_pbf_varint((3 << 3) | 0) + ogr_osm_pbf_varint(len(blob))
+    return bytearray(struct.pack('>I', len(header))) + header + blob
+
+def ogr_osm_create_multi_block_pbf(filename, node_blocks = 10,
+                                   nodes_per_block = 1000, way_blocks = 10):
+
+    content = ogr_osm_pbf_blob('OSMHeader',
+        ogr_osm_pbf_field(4, bytearray(b'OsmSchema-V0.6')) +
+        ogr_osm_pbf_field(4, bytearray(b'DenseNodes')))
+
+    node_id = 1
+    for block in range(node_blocks):
+        ids = range(node_id, node_id + nodes_per_block)
+        node_id += nodes_per_block
+        strings = [ b'', b'name' ] + [ ('n%d' % i).encode('ascii') for i in ids ]
+        keys_vals = []
+        for i in range(len(ids)):
+            keys_vals += [ 1, i + 2, 0 ]
+        dense = ogr_osm_pbf_field(1, ogr_osm_pbf_packed(ids, True)) + \
+                ogr_osm_pbf_field(8, ogr_osm_pbf_packed([ 490000000 + (i // 100) * 10000 for i in ids], True)) + \
+                ogr_osm_pbf_field(9, ogr_osm_pbf_packed([ 20000000 + (i % 100) * 10000 for i in ids], True)) + \
+                ogr_osm_pbf_field(10, ogr_osm_pbf_packed(keys_vals))
+        stringtable = bytearray()
+        for string in strings:
+            stringtable += ogr_osm_pbf_field(1, bytearray(string))
+        content += ogr_osm_pbf_blob('OSMData',
+            ogr_osm_pbf_field(1, stringtable) +
+            ogr_osm_pbf_field(2, ogr_osm_pbf_field(2, dense)))
+
+    ways_per_block = (node_id - 1) // 10 // way_blocks
+    way_id = 1
+    for block in range(way_blocks):
+        ids = range(way_id, way_id + ways_per_block)
+        way_id += ways_per_block
+        strings = [ b'', b'highway', b'residential', b'name' ] + \
+                  [ ('w%d' % i).encode('ascii') for i in ids ]
+        group = bytearray()
+        for i in range(len(ids)):
+            way = ogr_osm_pbf_varint((1 << 3) | 0) + ogr_osm_pbf_varint(ids[i]) + \
+                  ogr_osm_pbf_field(2, ogr_osm_pbf_packed([1, 3])) + \
+                  ogr_osm_pbf_field(3, ogr_osm_pbf_packed([2, i + 4])) + \
+                  ogr_osm_pbf_field(8, ogr_osm_pbf_packed(
+                      range(10 * ids[i] - 9, 10 * ids[i] + 1), True))
+            group += ogr_osm_pbf_field(3, way)
+        stringtable = bytearray()
+        for string in strings:
+            stringtable += ogr_osm_pbf_field(1, bytearray(string))
+        content += ogr_osm_pbf_blob('OSMData',
+            ogr_osm_pbf_field(1, stringtable) + ogr_osm_pbf_field(2, group))
+
+    gdal.FileFromMemBuffer(filename, bytes(content))
+
+###############################################################################
+# Return the content of the points and lines layers of a dataset
+
+def ogr_osm_dump_points_and_lines(filename):
+
+    ret = []
+    ds = ogr.Open(filename)
+    if ds is None:
+        return None
+    for layer_name in [ 'points', 'lines' ]:
+        lyr = ds.GetLayerByName(layer_name)
+        feat = lyr.GetNextFeature()
+        while feat is not None:
+            ret.append( (layer_name, feat.GetFID(),
+                         [ feat.GetField(i) for i in range(feat.GetFieldCount()) ],
+                         feat.GetGeometryRef().ExportToWkt()) )
+            feat = lyr.GetNextFeature()
+    ds = None
+    return ret
+
+###############################################################################
+# Test that decoding the blocks of a .pbf file with several threads gives
+# the same features as with a single thread
+
+def ogr_osm_15():
+
+    if ogrtest.osm_drv is None:
+        return 'skip'
+
+    ogr_osm_create_multi_block_pbf('/vsimem/ogr_osm_15.pbf')
+
+    old_val = gdal.GetConfigOption('GDAL_NUM_THREADS')
+    dumps = []
+    for num_threads in [ '1', '4' ]:
+        gdal.SetConfigOption('GDAL_NUM_THREADS', num_threads)
+        dumps.append(ogr_osm_dump_points_and_lines('/vsimem/ogr_osm_15.pbf'))
+    gdal.SetConfigOption('GDAL_NUM_THREADS', old_val)
+
+    gdal.Unlink('/vsimem/ogr_osm_15.pbf')
+
+    if dumps[0] is None:
+        gdaltest.post_reason('fail')
+        return 'fail'
+    count_points = len([ x for x in dumps[0] if x[0] == 'points' ])
+    count_lines = len([ x for x in dumps[0] if x[0] == 'lines' ])
+    if count_points != 10000 or count_lines != 1000:
+        gdaltest.post_reason('fail')
+        print(count_points, count_lines)
+        return 'fail'
+    if dumps[1] != dumps[0]:
+        gdaltest.post_reason('fail')
+        return 'fail'
+
+    return 'success'
+
+###############################################################################
+# Test that resolving the ways through the in-memory node index, the on-disk
+# node index mapped in memory, and the on-disk node index read with seeks
+# give the same features.
+
+class ogr_osm_16_debug_handler:
+    def __init__(self):
+        self.spilled = False
+
+    def handler(self, err_type, err_no, err_msg):
+        if err_msg.find('too big for RAM') >= 0:
+            self.spilled = True
+
+def ogr_osm_16():
+
+    if ogrtest.osm_drv is None:
+        return 'skip'
+
+    ogr_osm_create_multi_block_pbf('/vsimem/ogr_osm_16.pbf')
+
+    options = [ 'OSM_MAX_TMPFILE_SIZE', 'OSM_MMAP_NODES_FILE',
+                'OSM_COMPRESS_NODES', 'CPL_DEBUG' ]
+    old_vals = [ gdal.GetConfigOption(option) for option in options ]
+    ret = 'success'
+    ref = None
+    for compress_nodes in [ 'NO', 'YES' ]:
+        for (max_tmpfile_size, mmap_nodes_file) in [ (None, None),
+                                                     ('0', 'YES'),
+                                                     ('0', 'NO') ]:
+            gdal.SetConfigOption('OSM_MAX_TMPFILE_SIZE', max_tmpfile_size)
+            gdal.SetConfigOption('OSM_MMAP_NODES_FILE', mmap_nodes_file)
+            gdal.SetConfigOption('OSM_COMPRESS_NODES', compress_nodes)
+            gdal.SetConfigOption('CPL_DEBUG', 'ON')
+            debug_handler = ogr_osm_16_debug_handler()
+            gdal.PushErrorHandler(debug_handler.handler)
+            dump = ogr_osm_dump_points_and_lines('/vsimem/ogr_osm_16.pbf')
+            gdal.PopErrorHandler()
+
+            if debug_handler.spilled != (max_tmpfile_size is not None):
+                gdaltest.post_reason('fail')
+                print(compress_nodes, max_tmpfile_size, mmap_nodes_file)
+                ret = 'fail'
+            if ref is None:
+                ref = dump
+                if ref is None or len(ref) != 11000:
+                    gdaltest.post_reason('fail')
+                    ret = 'fail'
+            elif dump != ref:
+                gdaltest.post_reason('fail')
+                print(compress_nodes, max_tmpfile_size, mmap_nodes_file)
+                ret = 'fail'
+    for i in range(len(options)):
+        gdal.SetConfigOption(options[i], old_vals[i])
+
+    gdal.Unlink('/vsimem/ogr_osm_16.pbf')
+
+    return ret
+
 gdaltest_list = [
     ogr_osm_1,
     ogr_osm_2,
@@ -786,6 +986,8 @@ gdaltest_list = [
     ogr_osm_test_uncompressed_dense_false_pbf,
     ogr_osm_13,
     ogr_osm_14,
+    ogr_osm_15,
+    ogr_osm_16,
     ]
 
 if __name__ == '__main__':
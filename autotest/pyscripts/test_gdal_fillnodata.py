@@ -76,13 +76,35 @@ def test_gdal_fillnodata_2():
 
     return 'success'
 
+###############################################################################
+# Test the push-pull pyramid algorithm
+
+def test_gdal_fillnodata_3():
+
+    script_path = test_py_scripts.get_py_script('gdal_fillnodata')
+    if script_path is None:
+        return 'skip'
+
+    test_py_scripts.run_py_script(script_path, 'gdal_fillnodata', '-o ALGORITHM=PUSH_PULL -o NUM_THREADS=2 ../gcore/data/nodata_byte.tif tmp/test_gdal_fillnodata_3.tif')
+
+    ds = gdal.Open('tmp/test_gdal_fillnodata_3.tif')
+    cs = ds.GetRasterBand(1).Checksum()
+    if cs != 4718:
+        gdaltest.post_reason('fail')
+        print(cs)
+        return 'fail'
+    ds = None
+
+    return 'success'
+
 
 ###############################################################################
 # Cleanup
 
 def test_gdal_fillnodata_cleanup():
 
-    lst = [ 'tmp/test_gdal_fillnodata_1.tif', 'tmp/test_gdal_fillnodata_2.tif' ]
+    lst = [ 'tmp/test_gdal_fillnodata_1.tif', 'tmp/test_gdal_fillnodata_2.tif',
+            'tmp/test_gdal_fillnodata_3.tif' ]
     for filename in lst:
         try:
             os.remove(filename)
@@ -94,6 +116,7 @@ def test_gdal_fillnodata_cleanup():
 gdaltest_list = [
     test_gdal_fillnodata_1,
     test_gdal_fillnodata_2,
+    test_gdal_fillnodata_3,
     test_gdal_fillnodata_cleanup
     ]
 
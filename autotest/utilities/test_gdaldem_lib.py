@@ -29,6 +29,7 @@
 # DEALINGS IN THE SOFTWARE.
 ###############################################################################
 
+import struct
 import sys
 
 sys.path.append( '../pymod' )
@@ -164,6 +165,36 @@ def test_gdaldem_lib_hillshade_azimuth():
 
     return 'success'
 
+###############################################################################
+# Test gdaldem hillshade and slope with several threads and nodata
+
+def test_gdaldem_lib_threads():
+
+    src_ds = gdal.Translate('', '../gdrivers/data/n43.dt0', format = 'MEM', outputType = gdal.GDT_Float32)
+    src_ds.GetRasterBand(1).SetNoDataValue(0)
+    src_ds.GetRasterBand(1).WriteRaster(10, 20, 5, 3, struct.pack('f' * 15, *([0] * 15)))
+
+    for processing in [ 'hillshade', 'slope' ]:
+        for alg in [ 'Horn', 'ZevenbergenThorne' ]:
+            for computeEdges in [ False, True ]:
+                ref_ds = gdal.DEMProcessing('', src_ds, processing, format = 'MEM', alg = alg, computeEdges = computeEdges, scale = 111120)
+                ref_cs = ref_ds.GetRasterBand(1).Checksum()
+                ref_ds = None
+
+                gdal.SetConfigOption('GDAL_NUM_THREADS', '4')
+                ds = gdal.DEMProcessing('', src_ds, processing, format = 'MEM', alg = alg, computeEdges = computeEdges, scale = 111120)
+                gdal.SetConfigOption('GDAL_NUM_THREADS', None)
+                cs = ds.GetRasterBand(1).Checksum()
+                ds = None
+                if cs != ref_cs:
+                    gdaltest.post_reason('Bad checksum')
+                    print(processing, alg, computeEdges, cs, ref_cs)
+                    return 'fail'
+
+    src_ds = None
+
+    return 'success'
+
 ###############################################################################
 # Test gdaldem color relief
 
@@ -211,6 +242,7 @@ gdaltest_list = [
     test_gdaldem_lib_hillshade_combined,
     test_gdaldem_lib_hillshade_compute_edges,
     test_gdaldem_lib_hillshade_azimuth,
+    test_gdaldem_lib_threads,
     test_gdaldem_lib_color_relief
     ]
 
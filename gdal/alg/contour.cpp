@@ -32,6 +32,12 @@
 #include "gdal_priv.h"
 #include "gdal_alg.h"
 #include "ogr_api.h"
+#include "cpl_worker_thread_pool.h"
+
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <vector>
 
 CPL_CVSID("$Id$");
 
@@ -139,6 +145,8 @@ class GDALContourGenerator
 
     GDALContourLevel *FindLevel( double dfLevel );
 
+    void   PerturbLine( double *padfLine );
+
 public:
     GDALContourWriter pfnWriter;
     void   *pWriterCBData;
@@ -156,6 +164,8 @@ public:
           dfContourOffset = dfContourOffsetIn; }
 
     void                SetFixedLevels( int, double * );
+    void                SetStartLine( int iStartLine,
+                                      const double *padfPreviousLine );
     CPLErr              FeedLine( double *padfScanline );
     CPLErr              EjectContours( int bOnlyUnused = FALSE );
 
@@ -775,21 +785,7 @@ CPLErr GDALContourGenerator::FeedLine( double *padfScanline )
 /* -------------------------------------------------------------------- */
 /*      Perturb any values that occur exactly on level boundaries.      */
 /* -------------------------------------------------------------------- */
-    int iPixel;
-
-    for( iPixel = 0; iPixel < nWidth; iPixel++ )
-    {
-        if( bNoDataActive && padfThisLine[iPixel] == dfNoDataValue )
-            continue;
-
-        double dfLevel = (padfThisLine[iPixel] - dfContourOffset)
-            / dfContourInterval;
-
-        if( dfLevel - (int) dfLevel == 0.0 )
-        {
-            padfThisLine[iPixel] += dfContourInterval * FUDGE_EXACT;
-        }
-    }
+    PerturbLine( padfThisLine );
 
 /* -------------------------------------------------------------------- */
 /*      If this is the first line we need to initialize the previous    */
@@ -819,7 +815,7 @@ CPLErr GDALContourGenerator::FeedLine( double *padfScanline )
 /*      Process each pixel.                                             */
 /* -------------------------------------------------------------------- */
     const bool bNoDataIsNan = CPL_TO_BOOL(CPLIsNan(dfNoDataValue));
-    for( iPixel = 0; iPixel < nWidth+1; iPixel++ )
+    for( int iPixel = 0; iPixel < nWidth+1; iPixel++ )
     {
         CPLErr eErr = bNoDataIsNan ? ProcessPixel<true>( iPixel ) :
                                      ProcessPixel<false>( iPixel );
@@ -840,6 +836,47 @@ CPLErr GDALContourGenerator::FeedLine( double *padfScanline )
         return eErr;
 }
 
+/************************************************************************/
+/*                            PerturbLine()                             */
+/************************************************************************/
+
+void GDALContourGenerator::PerturbLine( double *padfLine )
+
+{
+    for( int iPixel = 0; iPixel < nWidth; iPixel++ )
+    {
+        if( bNoDataActive && padfLine[iPixel] == dfNoDataValue )
+            continue;
+
+        double dfLevel = (padfLine[iPixel] - dfContourOffset)
+            / dfContourInterval;
+
+        if( dfLevel - (int) dfLevel == 0.0 )
+        {
+            padfLine[iPixel] += dfContourInterval * FUDGE_EXACT;
+        }
+    }
+}
+
+/************************************************************************/
+/*                            SetStartLine()                            */
+/*                                                                      */
+/*      Start the generation at line iStartLine instead of the first    */
+/*      line of the raster, padfPreviousLine being the content of       */
+/*      line iStartLine - 1. This is used to contour strips of lines    */
+/*      separately.                                                     */
+/************************************************************************/
+
+void GDALContourGenerator::SetStartLine( int iStartLine,
+                                         const double *padfPreviousLine )
+
+{
+    // FeedLine() will switch it to the "lastline" slot.
+    memcpy( padfThisLine, padfPreviousLine, sizeof(double) * nWidth );
+    PerturbLine( padfThisLine );
+    iLine = iStartLine;
+}
+
 /************************************************************************/
 /*                           EjectContours()                            */
 /************************************************************************/
@@ -1423,6 +1460,566 @@ CPLErr OGRContourWriter( double dfLevel,
     return (eErr == OGRERR_NONE) ? CE_None : CE_Failure;
 }
 
+/************************************************************************/
+/* ==================================================================== */
+/*                      Strip based contour generation                  */
+/* ==================================================================== */
+/*                                                                      */
+/*      The raster is split in strips of lines that are contoured      */
+/*      independently by the threads of a worker pool.  The contours    */
+/*      that reach the line shared by two strips are then joined        */
+/*      together by GDALContourStitcher, which looks up their ends in   */
+/*      a map keyed by the level, the line and the quantized x.         */
+/************************************************************************/
+
+// Number of lines of a strip.
+#define CONTOUR_STRIP_LINES 256
+
+/************************************************************************/
+/*                           GDALContourStrip                           */
+/************************************************************************/
+
+typedef struct
+{
+    int     nXSize;
+    int     nYSize;
+    int     iStartLine;         // first line fed to the generator
+    int     iEndLine;           // last line fed to the generator, excluded
+    double *padfPreviousLine;   // line iStartLine - 1, or NULL
+    double *padfLines;          // lines iStartLine to iEndLine - 1
+
+    int     nFixedLevelCount;
+    double *padfFixedLevels;
+    double  dfContourInterval;
+    double  dfContourBase;
+    int     bUseNoData;
+    double  dfNoDataValue;
+
+    std::vector<GDALContourItem *> apoContours;
+    CPLErr  eErr;
+} GDALContourStrip;
+
+/************************************************************************/
+/*                       GDALContourStripWriter()                       */
+/*                                                                      */
+/*      Keeps a copy of the contours ejected from a strip, for the      */
+/*      stitching done afterwards by the main thread.                   */
+/************************************************************************/
+
+static CPLErr GDALContourStripWriter( double dfLevel, int nPoints,
+                                      double *padfX, double *padfY,
+                                      void *pInfo )
+
+{
+    GDALContourStrip *psStrip = static_cast<GDALContourStrip *>(pInfo);
+
+    // The points are already oriented by PrepareEjection().
+    GDALContourItem *poItem = new GDALContourItem( dfLevel );
+    poItem->MakeRoomFor( nPoints );
+    memcpy( poItem->padfX, padfX, sizeof(double) * nPoints );
+    memcpy( poItem->padfY, padfY, sizeof(double) * nPoints );
+    poItem->nPoints = nPoints;
+    poItem->dfTailX = padfX[nPoints-1];
+
+    psStrip->apoContours.push_back( poItem );
+
+    return CE_None;
+}
+
+/************************************************************************/
+/*                        GDALContourStripJob()                         */
+/************************************************************************/
+
+static void GDALContourStripJob( void *pData )
+
+{
+    GDALContourStrip *psStrip = static_cast<GDALContourStrip *>(pData);
+
+    GDALContourGenerator oCG( psStrip->nXSize, psStrip->nYSize,
+                              GDALContourStripWriter, psStrip );
+    if( !oCG.Init() )
+    {
+        psStrip->eErr = CE_Failure;
+        return;
+    }
+
+    if( psStrip->nFixedLevelCount > 0 )
+        oCG.SetFixedLevels( psStrip->nFixedLevelCount,
+                            psStrip->padfFixedLevels );
+    else
+        oCG.SetContourLevels( psStrip->dfContourInterval,
+                              psStrip->dfContourBase );
+
+    if( psStrip->bUseNoData )
+        oCG.SetNoData( psStrip->dfNoDataValue );
+
+    if( psStrip->padfPreviousLine != NULL )
+        oCG.SetStartLine( psStrip->iStartLine, psStrip->padfPreviousLine );
+
+    CPLErr eErr = CE_None;
+    for( int iLine = psStrip->iStartLine;
+         iLine < psStrip->iEndLine && eErr == CE_None; iLine++ )
+    {
+        eErr = oCG.FeedLine( psStrip->padfLines +
+                static_cast<size_t>(iLine - psStrip->iStartLine) *
+                                                        psStrip->nXSize );
+    }
+
+    // The last strip is flushed by FeedLine() itself.
+    if( eErr == CE_None && psStrip->iEndLine < psStrip->nYSize )
+        eErr = oCG.EjectContours( FALSE );
+
+    psStrip->eErr = eErr;
+}
+
+/************************************************************************/
+/*                         GDALContourStitcher                          */
+/************************************************************************/
+
+typedef struct
+{
+    double  dfLevel;
+    int     iBoundary;          // first line of the strip below
+    GIntBig nXCell;             // x / JOIN_DIST
+} GDALContourEndKey;
+
+struct GDALContourEndKeyLess
+{
+    bool operator()( const GDALContourEndKey &a,
+                     const GDALContourEndKey &b ) const
+    {
+        if( a.iBoundary != b.iBoundary )
+            return a.iBoundary < b.iBoundary;
+        if( a.dfLevel != b.dfLevel )
+            return a.dfLevel < b.dfLevel;
+        return a.nXCell < b.nXCell;
+    }
+};
+
+typedef std::multimap<GDALContourEndKey, GDALContourItem *,
+                      GDALContourEndKeyLess> GDALContourEndMap;
+
+class GDALContourStitcher
+{
+    int     nYSize;
+    int     nStripLines;
+
+    GDALContourWriter pfnWriter;
+    void   *pWriterCBData;
+
+    // Ends of the contours lying on the top or bottom line of the strip
+    // being stitched.
+    GDALContourEndMap oMapEnds;
+
+    int     IsOnBoundary( double dfY, int iBoundary ) const;
+    GDALContourEndKey GetKey( double dfLevel, double dfX,
+                              int iBoundary ) const;
+    void    Register( GDALContourItem *poItem, int iBoundary );
+    void    Unregister( GDALContourItem *poItem, int iBoundary );
+    GDALContourItem *FindPartner( GDALContourItem *poItem,
+                                  double dfX, double dfY, int iBoundary );
+    CPLErr  Write( GDALContourItem *poItem );
+
+public:
+    GDALContourStitcher( int nYSizeIn, int nStripLinesIn,
+                         GDALContourWriter pfnWriterIn,
+                         void *pWriterCBDataIn ) :
+        nYSize(nYSizeIn), nStripLines(nStripLinesIn),
+        pfnWriter(pfnWriterIn), pWriterCBData(pWriterCBDataIn) {}
+    ~GDALContourStitcher();
+
+    CPLErr  AddStrip( GDALContourStrip *psStrip );
+};
+
+/************************************************************************/
+/*                        ~GDALContourStitcher()                        */
+/************************************************************************/
+
+GDALContourStitcher::~GDALContourStitcher()
+
+{
+    // Only left in case of error: an item may be registered twice.
+    std::vector<GDALContourItem *> apoItems;
+    for( GDALContourEndMap::iterator oIter = oMapEnds.begin();
+         oIter != oMapEnds.end(); ++oIter )
+        apoItems.push_back( oIter->second );
+    std::sort( apoItems.begin(), apoItems.end() );
+    apoItems.erase( std::unique( apoItems.begin(), apoItems.end() ),
+                    apoItems.end() );
+    for( size_t i = 0; i < apoItems.size(); i++ )
+        delete apoItems[i];
+}
+
+/************************************************************************/
+/*                            IsOnBoundary()                            */
+/*                                                                      */
+/*      The line shared by the strip ending before iBoundary and the    */
+/*      strip starting at iBoundary is the line of the centers of the   */
+/*      pixels of line iBoundary - 1.                                   */
+/************************************************************************/
+
+int GDALContourStitcher::IsOnBoundary( double dfY, int iBoundary ) const
+
+{
+    return iBoundary > 0 && iBoundary < nYSize &&
+           fabs(dfY - (iBoundary - 0.5)) < JOIN_DIST;
+}
+
+/************************************************************************/
+/*                               GetKey()                               */
+/************************************************************************/
+
+GDALContourEndKey GDALContourStitcher::GetKey( double dfLevel, double dfX,
+                                               int iBoundary ) const
+
+{
+    GDALContourEndKey sKey;
+    sKey.dfLevel = dfLevel;
+    sKey.iBoundary = iBoundary;
+    sKey.nXCell = static_cast<GIntBig>(floor(dfX / JOIN_DIST));
+    return sKey;
+}
+
+/************************************************************************/
+/*                              Register()                              */
+/************************************************************************/
+
+void GDALContourStitcher::Register( GDALContourItem *poItem, int iBoundary )
+
+{
+    const int nPoints = poItem->nPoints;
+    if( IsOnBoundary( poItem->padfY[0], iBoundary ) )
+        oMapEnds.insert( std::pair<GDALContourEndKey, GDALContourItem *>(
+            GetKey( poItem->dfLevel, poItem->padfX[0], iBoundary ), poItem ));
+    if( IsOnBoundary( poItem->padfY[nPoints-1], iBoundary ) )
+        oMapEnds.insert( std::pair<GDALContourEndKey, GDALContourItem *>(
+            GetKey( poItem->dfLevel, poItem->padfX[nPoints-1], iBoundary ),
+            poItem ));
+}
+
+/************************************************************************/
+/*                             Unregister()                             */
+/************************************************************************/
+
+void GDALContourStitcher::Unregister( GDALContourItem *poItem, int iBoundary )
+
+{
+    for( int iEnd = 0; iEnd < 2; iEnd++ )
+    {
+        const int iPoint = iEnd == 0 ? 0 : poItem->nPoints - 1;
+        if( !IsOnBoundary( poItem->padfY[iPoint], iBoundary ) )
+            continue;
+
+        std::pair<GDALContourEndMap::iterator, GDALContourEndMap::iterator>
+            oRange = oMapEnds.equal_range(
+                GetKey( poItem->dfLevel, poItem->padfX[iPoint], iBoundary ) );
+        for( GDALContourEndMap::iterator oIter = oRange.first;
+             oIter != oRange.second; ++oIter )
+        {
+            if( oIter->second == poItem )
+            {
+                oMapEnds.erase( oIter );
+                break;
+            }
+        }
+    }
+}
+
+/************************************************************************/
+/*                            FindPartner()                             */
+/*                                                                      */
+/*      Find a registered contour, other than poItem, with an end at    */
+/*      (dfX, dfY).                                                     */
+/************************************************************************/
+
+GDALContourItem *GDALContourStitcher::FindPartner( GDALContourItem *poItem,
+                                                   double dfX, double dfY,
+                                                   int iBoundary )
+
+{
+    GDALContourEndKey sKey = GetKey( poItem->dfLevel, dfX, iBoundary );
+    const GIntBig nXCell = sKey.nXCell;
+
+    // The end may have been quantized in a neighbouring cell.
+    for( sKey.nXCell = nXCell - 1; sKey.nXCell <= nXCell + 1; sKey.nXCell++ )
+    {
+        std::pair<GDALContourEndMap::iterator, GDALContourEndMap::iterator>
+            oRange = oMapEnds.equal_range( sKey );
+        for( GDALContourEndMap::iterator oIter = oRange.first;
+             oIter != oRange.second; ++oIter )
+        {
+            GDALContourItem *poOther = oIter->second;
+            if( poOther == poItem )
+                continue;
+            for( int iEnd = 0; iEnd < 2; iEnd++ )
+            {
+                const int iPoint = iEnd == 0 ? 0 : poOther->nPoints - 1;
+                if( fabs(poOther->padfX[iPoint] - dfX) < JOIN_DIST &&
+                    fabs(poOther->padfY[iPoint] - dfY) < JOIN_DIST )
+                    return poOther;
+            }
+        }
+    }
+
+    return NULL;
+}
+
+/************************************************************************/
+/*                               Write()                                */
+/************************************************************************/
+
+CPLErr GDALContourStitcher::Write( GDALContourItem *poItem )
+
+{
+    CPLErr eErr = CE_None;
+    if( pfnWriter != NULL )
+        eErr = pfnWriter( poItem->dfLevel, poItem->nPoints,
+                          poItem->padfX, poItem->padfY, pWriterCBData );
+    delete poItem;
+    return eErr;
+}
+
+/************************************************************************/
+/*                              AddStrip()                              */
+/*                                                                      */
+/*      Stitch the contours of a strip to the ones of the previous      */
+/*      strip, and write the contours that are complete.  The strips    */
+/*      must be added in order.                                         */
+/************************************************************************/
+
+CPLErr GDALContourStitcher::AddStrip( GDALContourStrip *psStrip )
+
+{
+    const int iTop = psStrip->iStartLine;
+    const int iBottom = psStrip->iEndLine;
+    CPLErr eErr = CE_None;
+
+    for( size_t iItem = 0; iItem < psStrip->apoContours.size(); iItem++ )
+    {
+        GDALContourItem *poItem = psStrip->apoContours[iItem];
+        psStrip->apoContours[iItem] = NULL;
+        if( eErr != CE_None )
+        {
+            delete poItem;
+            continue;
+        }
+
+/* -------------------------------------------------------------------- */
+/*      Join the contour with the ones having a common end on the       */
+/*      top line of the strip.                                          */
+/* -------------------------------------------------------------------- */
+        bool bMerged = true;
+        while( bMerged )
+        {
+            bMerged = false;
+            for( int iEnd = 0; iEnd < 2 && !bMerged; iEnd++ )
+            {
+                const int iPoint = iEnd == 0 ? 0 : poItem->nPoints - 1;
+                if( !IsOnBoundary( poItem->padfY[iPoint], iTop ) )
+                    continue;
+
+                GDALContourItem *poOther =
+                    FindPartner( poItem, poItem->padfX[iPoint],
+                                 poItem->padfY[iPoint], iTop );
+                if( poOther == NULL )
+                    continue;
+
+                Unregister( poOther, iTop );
+                Unregister( poOther, iBottom );
+                if( poItem->Merge( poOther ) )
+                {
+                    delete poOther;
+                    bMerged = true;
+                }
+                else
+                {
+                    Register( poOther, iTop );
+                    Register( poOther, iBottom );
+                }
+            }
+        }
+
+/* -------------------------------------------------------------------- */
+/*      Write it if it is closed, or if it does not reach the top or    */
+/*      bottom lines of the strip.                                      */
+/* -------------------------------------------------------------------- */
+        const int nPoints = poItem->nPoints;
+        const bool bClosed = nPoints > 2 &&
+            fabs(poItem->padfX[0] - poItem->padfX[nPoints-1]) < JOIN_DIST &&
+            fabs(poItem->padfY[0] - poItem->padfY[nPoints-1]) < JOIN_DIST;
+        if( !bClosed &&
+            ( IsOnBoundary( poItem->padfY[0], iTop ) ||
+              IsOnBoundary( poItem->padfY[nPoints-1], iTop ) ||
+              IsOnBoundary( poItem->padfY[0], iBottom ) ||
+              IsOnBoundary( poItem->padfY[nPoints-1], iBottom ) ) )
+        {
+            Register( poItem, iTop );
+            Register( poItem, iBottom );
+        }
+        else
+        {
+            eErr = Write( poItem );
+        }
+    }
+
+/* -------------------------------------------------------------------- */
+/*      The ends still on the top line have no continuation: the        */
+/*      contours that do not reach the bottom line are complete.        */
+/* -------------------------------------------------------------------- */
+    GDALContourEndKey sKey;
+    sKey.dfLevel = -std::numeric_limits<double>::max();
+    sKey.iBoundary = iTop;
+    sKey.nXCell = 0;
+    GDALContourEndMap::iterator oIter = oMapEnds.lower_bound( sKey );
+    std::vector<GDALContourItem *> apoComplete;
+    while( oIter != oMapEnds.end() && oIter->first.iBoundary == iTop )
+    {
+        GDALContourItem *poItem = oIter->second;
+        oMapEnds.erase( oIter++ );
+
+        const int nPoints = poItem->nPoints;
+        if( !IsOnBoundary( poItem->padfY[0], iBottom ) &&
+            !IsOnBoundary( poItem->padfY[nPoints-1], iBottom ) &&
+            std::find( apoComplete.begin(), apoComplete.end(), poItem ) ==
+                                                            apoComplete.end() )
+        {
+            apoComplete.push_back( poItem );
+        }
+    }
+    for( size_t i = 0; i < apoComplete.size(); i++ )
+    {
+        if( eErr == CE_None )
+            eErr = Write( apoComplete[i] );
+        else
+            delete apoComplete[i];
+    }
+
+    return eErr;
+}
+
+/************************************************************************/
+/*                      GDALContourGenerateStrips()                     */
+/*                                                                      */
+/*      Contour the band by batches of strips, processed in parallel    */
+/*      by the threads of the pool.  Only a batch of lines and the      */
+/*      contours crossing the last line of the batch are kept in        */
+/*      memory.                                                         */
+/************************************************************************/
+
+static CPLErr
+GDALContourGenerateStrips( GDALRasterBandH hBand,
+                           CPLWorkerThreadPool *poThreadPool, int nThreads,
+                           double dfContourInterval, double dfContourBase,
+                           int nFixedLevelCount, double *padfFixedLevels,
+                           int bUseNoData, double dfNoDataValue,
+                           GDALContourWriter pfnWriter, void *pWriterCBData,
+                           GDALProgressFunc pfnProgress, void *pProgressArg )
+
+{
+    const int nXSize = GDALGetRasterBandXSize( hBand );
+    const int nYSize = GDALGetRasterBandYSize( hBand );
+    // Keep the lines of a batch within the block cache size, but take at
+    // least one strip.
+    const GIntBig nStripBytes =
+        static_cast<GIntBig>(sizeof(double)) * nXSize * CONTOUR_STRIP_LINES;
+    const int nBatchStrips = static_cast<int>(
+        MAX(1, MIN(static_cast<GIntBig>(2) * nThreads,
+                   GDALGetCacheMax64() / nStripBytes)));
+    const int nBatchLines = nBatchStrips * CONTOUR_STRIP_LINES;
+
+    // One more line for the line preceding the batch.
+    double *padfLines = static_cast<double *>(
+        VSI_MALLOC3_VERBOSE( sizeof(double), nXSize, nBatchLines + 1 ));
+    if( padfLines == NULL )
+        return CE_Failure;
+
+    std::vector<GDALContourStrip> asStrips( nBatchStrips );
+    GDALContourStitcher oStitcher( nYSize, CONTOUR_STRIP_LINES,
+                                   pfnWriter, pWriterCBData );
+    CPLErr eErr = CE_None;
+
+    for( int iBatch = 0; iBatch < nYSize && eErr == CE_None;
+         iBatch += nBatchLines )
+    {
+        const int nLines = MIN(nBatchLines, nYSize - iBatch);
+
+        // The last line of the previous batch becomes the first one.
+        if( iBatch > 0 )
+            memmove( padfLines,
+                     padfLines + static_cast<size_t>(nBatchLines) * nXSize,
+                     sizeof(double) * nXSize );
+
+        eErr = GDALRasterIO( hBand, GF_Read, 0, iBatch, nXSize, nLines,
+                             padfLines + nXSize, nXSize, nLines,
+                             GDT_Float64, 0, 0 );
+        if( eErr != CE_None )
+            break;
+
+        std::vector<void *> apJobs;
+        for( int iStrip = 0; iStrip < nBatchStrips; iStrip++ )
+        {
+            const int iStartLine = iBatch + iStrip * CONTOUR_STRIP_LINES;
+            if( iStartLine >= iBatch + nLines )
+                break;
+
+            GDALContourStrip *psStrip = &asStrips[iStrip];
+            psStrip->nXSize = nXSize;
+            psStrip->nYSize = nYSize;
+            psStrip->iStartLine = iStartLine;
+            psStrip->iEndLine = MIN(iStartLine + CONTOUR_STRIP_LINES,
+                                    iBatch + nLines);
+            psStrip->padfLines = padfLines +
+                static_cast<size_t>(iStartLine - iBatch + 1) * nXSize;
+            psStrip->padfPreviousLine =
+                iStartLine > 0 ? psStrip->padfLines - nXSize : NULL;
+            psStrip->nFixedLevelCount = nFixedLevelCount;
+            psStrip->padfFixedLevels = padfFixedLevels;
+            psStrip->dfContourInterval = dfContourInterval;
+            psStrip->dfContourBase = dfContourBase;
+            psStrip->bUseNoData = bUseNoData;
+            psStrip->dfNoDataValue = dfNoDataValue;
+            psStrip->eErr = CE_None;
+            apJobs.push_back( psStrip );
+        }
+
+        // On failure, no job has been queued: run them here.
+        if( poThreadPool->SubmitJobs( GDALContourStripJob, apJobs ) )
+        {
+            poThreadPool->WaitCompletion();
+        }
+        else
+        {
+            for( size_t iJob = 0; iJob < apJobs.size(); iJob++ )
+                GDALContourStripJob( apJobs[iJob] );
+        }
+
+        for( size_t iJob = 0; iJob < apJobs.size(); iJob++ )
+        {
+            GDALContourStrip *psStrip =
+                static_cast<GDALContourStrip *>(apJobs[iJob]);
+            if( eErr == CE_None )
+                eErr = psStrip->eErr;
+            if( eErr == CE_None )
+                eErr = oStitcher.AddStrip( psStrip );
+            for( size_t i = 0; i < psStrip->apoContours.size(); i++ )
+                delete psStrip->apoContours[i];
+            psStrip->apoContours.clear();
+        }
+
+        if( eErr == CE_None &&
+            !pfnProgress( (iBatch + nLines) / (double) nYSize, "",
+                          pProgressArg ) )
+        {
+            CPLError( CE_Failure, CPLE_UserInterrupt, "User terminated" );
+            eErr = CE_Failure;
+        }
+    }
+
+    CPLFree( padfLines );
+
+    return eErr;
+}
+
 
 /************************************************************************/
 /*                        GDALContourGenerate()                         */
@@ -1559,6 +2156,13 @@ an averaged value from the two nearby points (in this case (12+3+5)/3).
  *
  * @param pProgressArg The callback data for the pfnProgress function.
  *
+ * Starting with GDAL 2.2, the GDAL_CONTOUR_NUM_THREADS configuration option
+ * can be set to a number of threads, or ALL_CPUS, to contour strips of lines
+ * in parallel.  The contours crossing the strips are joined back together,
+ * but the contours are not written in the same order as with a single
+ * thread, and joins at nearly degenerate crossings may differ on noisy
+ * data.  This is why GDAL_NUM_THREADS is not taken into account.
+ *
  * @return CE_None on success or CE_Failure if an error occurs.
  */
 
@@ -1605,11 +2209,35 @@ CPLErr GDALContourGenerate( GDALRasterBandH hBand,
     oCWI.nNextID = 0;
 
 /* -------------------------------------------------------------------- */
-/*      Setup contour generator.                                        */
+/*      Contour strips of lines in parallel if several threads are      */
+/*      requested.                                                      */
 /* -------------------------------------------------------------------- */
     int nXSize = GDALGetRasterBandXSize( hBand );
     int nYSize = GDALGetRasterBandYSize( hBand );
 
+    const int nThreads =
+        CPLParseNumThreads( CPLGetConfigOption("GDAL_CONTOUR_NUM_THREADS",
+                                               NULL) );
+
+    if( nThreads > 1 && nYSize > CONTOUR_STRIP_LINES )
+    {
+        CPLWorkerThreadPool oThreadPool;
+        if( oThreadPool.Setup( nThreads, NULL, NULL ) )
+        {
+            CPLDebug( "CONTOUR", "Using %d threads", nThreads );
+            return GDALContourGenerateStrips( hBand, &oThreadPool, nThreads,
+                                              dfContourInterval, dfContourBase,
+                                              nFixedLevelCount, padfFixedLevels,
+                                              bUseNoData, dfNoDataValue,
+                                              OGRContourWriter, &oCWI,
+                                              pfnProgress, pProgressArg );
+        }
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Setup contour generator.                                        */
+/* -------------------------------------------------------------------- */
+
     GDALContourGenerator oCG( nXSize, nYSize, OGRContourWriter, &oCWI );
     if( !oCG.Init() )
     {
@@ -65,6 +65,26 @@ int CPL_DLL CPL_STDCALL GDALDitherRGB2PCT( GDALRasterBandH hRed,
 int CPL_DLL CPL_STDCALL GDALChecksumImage( GDALRasterBandH hBand,
                                int nXOff, int nYOff, int nXSize, int nYSize );
 
+/*! Raster fingerprint handle */
+typedef void *GDALRasterFingerprintH;
+
+GDALRasterFingerprintH CPL_DLL
+GDALComputeRasterFingerprint( GDALRasterBandH hBand, char **papszOptions,
+                              GDALProgressFunc pfnProgress,
+                              void *pProgressArg );
+CPLErr CPL_DLL
+GDALUpdateRasterFingerprint( GDALRasterFingerprintH hFingerprint,
+                             GDALRasterBandH hBand,
+                             int nXOff, int nYOff, int nXSize, int nYSize,
+                             char **papszOptions );
+const char CPL_DLL *
+GDALGetRasterFingerprintValue( GDALRasterFingerprintH hFingerprint );
+CPLXMLNode CPL_DLL *
+GDALSerializeRasterFingerprint( GDALRasterFingerprintH hFingerprint );
+GDALRasterFingerprintH CPL_DLL
+GDALDeserializeRasterFingerprint( CPLXMLNode *psTree );
+void CPL_DLL GDALDestroyRasterFingerprint( GDALRasterFingerprintH hFingerprint );
+
 CPLErr CPL_DLL CPL_STDCALL
 GDALComputeProximity( GDALRasterBandH hSrcBand,
                       GDALRasterBandH hProximityBand,
@@ -229,6 +249,19 @@ int  CPL_DLL GDALApproxTransform(
     void *pTransformArg, int bDstToSrc, int nPointCount,
     double *x, double *y, double *z, int *panSuccess );
 
+/* Interpolation grid transformer */
+void CPL_DLL *
+GDALCreateInterpGridTransformer( GDALTransformerFunc pfnBaseTransformer,
+                                 void *pBaseTransformArg,
+                                 int nXSize, int nYSize,
+                                 char **papszOptions );
+void CPL_DLL GDALInterpGridTransformerOwnsSubtransformer( void *pCBData,
+                                                          int bOwnFlag );
+void CPL_DLL GDALDestroyInterpGridTransformer( void *pTransformArg );
+int  CPL_DLL GDALInterpGridTransform(
+    void *pTransformArg, int bDstToSrc, int nPointCount,
+    double *x, double *y, double *z, int *panSuccess );
+
 
 int CPL_DLL CPL_STDCALL
 GDALSimpleImageWarp( GDALDatasetH hSrcDS,
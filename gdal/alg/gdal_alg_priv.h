@@ -52,6 +52,7 @@ typedef struct {
     unsigned char * pabyChunkBuf;
     int nXSize;
     int nYSize;
+    size_t nBandStride; /* in pixels, between the start of two bands */
     int nBands;
     GDALDataType eType;
     double *padfBurnValue;
@@ -206,4 +207,18 @@ struct FloatEqualityTest
     bool operator()(float a, float b) { return GDALFloatEquals(a,b) == TRUE; }
 };
 
+/************************************************************************/
+/*      XXH64 hash used by the checksum functions.                      */
+/************************************************************************/
+
+GUIntBig CPL_DLL GDALXXH64( const void *pData, size_t nLen, GUIntBig nSeed );
+
+/************************************************************************/
+/*      Exact euclidean distance transform.                             */
+/************************************************************************/
+
+/* Defined in gdalproximity.cpp, also used by rasterfill.cpp */
+void GDALDistanceTransform1D( const double *padfF, int nSize, double *padfD,
+                              int *panV, double *padfZ );
+
 #endif /* ndef GDAL_ALG_PRIV_H_INCLUDED */
@@ -29,10 +29,179 @@
  ****************************************************************************/
 
 #include "gdal_alg.h"
+#include "gdal_alg_priv.h"
 #include "cpl_conv.h"
+#include "cpl_string.h"
+#include "cpl_worker_thread_pool.h"
+
+#include <vector>
 
 CPL_CVSID("$Id$");
 
+/* Number of samples read at once by GDALChecksumImage() */
+#define CHECKSUM_CHUNK_SAMPLES  (1024 * 1024)
+
+/* Number of bytes read at once by the fingerprint functions */
+#define FINGERPRINT_CHUNK_BYTES (16 * 1024 * 1024)
+
+/************************************************************************/
+/* ==================================================================== */
+/*                            Checksum                                  */
+/* ==================================================================== */
+/************************************************************************/
+
+/*
+ * The checksum is the sum, modulo 65536, of the values modulo a prime
+ * cycling over 11 primes along the samples of the window in line order.
+ * Partial sums of ranges of samples can thus be computed independently,
+ * provided that they start with the right prime, and added together.
+ */
+
+static const int anPrimes[11] =
+    { 7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43 };
+
+/************************************************************************/
+/*                          GDALChecksumValue()                         */
+/************************************************************************/
+
+static inline int GDALChecksumValue( GInt32 nVal )
+{
+    return nVal;
+}
+
+static inline int GDALChecksumValue( double dfVal )
+{
+    if (CPLIsNan(dfVal) || CPLIsInf(dfVal))
+    {
+        /* Most compilers seem to cast NaN or Inf to 0x80000000. */
+        /* but VC7 is an exception. So we force the result */
+        /* of such a cast */
+        return static_cast<int>(0x80000000);
+    }
+
+    /* Standard behaviour of GDALCopyWords when converting */
+    /* from floating point to Int32 */
+    dfVal += 0.5;
+
+    if( dfVal < -2147483647.0 )
+        return -2147483647;
+    else if( dfVal > 2147483647 )
+        return 2147483647;
+    else
+        return (GInt32) floor(dfVal);
+}
+
+/************************************************************************/
+/*                         GDALChecksumValues()                         */
+/*                                                                      */
+/*      Partial checksum of nCount samples, the first one being         */
+/*      reduced by anPrimes[iPrime].  Full cycles of the primes are     */
+/*      unrolled so that the modulos are by constants.                  */
+/************************************************************************/
+
+#define CHECKSUM_TERM(i, nPrime) \
+    static_cast<GUInt32>(GDALChecksumValue(paValues[i]) % (nPrime))
+
+template<class T>
+static GUInt32 GDALChecksumValues( const T *paValues, size_t nCount,
+                                   int iPrime )
+{
+    GUInt32 nSum = 0;
+    size_t i = 0;
+
+    for( ; i < nCount && iPrime != 0; i++ )
+    {
+        nSum += CHECKSUM_TERM(i, anPrimes[iPrime]);
+        if( ++iPrime > 10 )
+            iPrime = 0;
+    }
+
+    for( ; i + 11 <= nCount; i += 11 )
+    {
+        nSum += CHECKSUM_TERM(i, 7) + CHECKSUM_TERM(i + 1, 11) +
+                CHECKSUM_TERM(i + 2, 13) + CHECKSUM_TERM(i + 3, 17) +
+                CHECKSUM_TERM(i + 4, 19) + CHECKSUM_TERM(i + 5, 23) +
+                CHECKSUM_TERM(i + 6, 29) + CHECKSUM_TERM(i + 7, 31) +
+                CHECKSUM_TERM(i + 8, 37) + CHECKSUM_TERM(i + 9, 41) +
+                CHECKSUM_TERM(i + 10, 43);
+    }
+
+    for( iPrime = 0; i < nCount; i++, iPrime++ )
+        nSum += CHECKSUM_TERM(i, anPrimes[iPrime]);
+
+    return nSum;
+}
+
+typedef struct
+{
+    const void *pData;
+    int         bFloat;
+    size_t      nCount;
+    int         iPrime;
+    GUInt32     nSum;
+} GDALChecksumJob;
+
+/************************************************************************/
+/*                        GDALChecksumJobFunc()                         */
+/************************************************************************/
+
+static void GDALChecksumJobFunc( void *pData )
+{
+    GDALChecksumJob *psJob = static_cast<GDALChecksumJob *>(pData);
+    if( psJob->bFloat )
+        psJob->nSum = GDALChecksumValues(
+            static_cast<const double *>(psJob->pData),
+            psJob->nCount, psJob->iPrime );
+    else
+        psJob->nSum = GDALChecksumValues(
+            static_cast<const GInt32 *>(psJob->pData),
+            psJob->nCount, psJob->iPrime );
+}
+
+/************************************************************************/
+/*                        GDALChecksumLineByLine()                      */
+/*                                                                      */
+/*      Reading of a range of lines one at a time, as done before       */
+/*      chunked reading, so that a read error stops the checksum at     */
+/*      the same line.                                                  */
+/************************************************************************/
+
+static GUInt32 GDALChecksumLineByLine( GDALRasterBandH hBand, int nXOff,
+                                       int nXSize, int nFirstLine,
+                                       int nLastLine, GDALDataType eBufType,
+                                       void *pBuffer, int nValuesPerLine,
+                                       int iPrime )
+{
+    const int bFloat = eBufType == GDT_Float64 || eBufType == GDT_CFloat64;
+    GUInt32 nSum = 0;
+
+    for( int iLine = nFirstLine; iLine < nLastLine; iLine++ )
+    {
+        if (GDALRasterIO( hBand, GF_Read, nXOff, iLine, nXSize, 1,
+                          pBuffer, nXSize, 1, eBufType, 0, 0 ) != CE_None)
+        {
+            if( bFloat )
+                CPLError( CE_Failure, CPLE_FileIO,
+                        "Checksum value couldn't be computed due to I/O read error.\n");
+            else
+                CPLError( CE_Failure, CPLE_FileIO,
+                          "Checksum value could not be computed due to I/O "
+                          "read error.\n");
+            break;
+        }
+
+        if( bFloat )
+            nSum += GDALChecksumValues( static_cast<const double *>(pBuffer),
+                                        nValuesPerLine, iPrime );
+        else
+            nSum += GDALChecksumValues( static_cast<const GInt32 *>(pBuffer),
+                                        nValuesPerLine, iPrime );
+        iPrime = (iPrime + nValuesPerLine) % 11;
+    }
+
+    return nSum;
+}
+
 /************************************************************************/
 /*                         GDALChecksumImage()                          */
 /************************************************************************/
@@ -45,6 +214,15 @@ CPL_CVSID("$Id$");
  * so decimal portions of such raster data will not affect the checksum.
  * Real and Imaginary components of complex bands influence the result.
  *
+ * The region is read by chunks of lines aligned on the blocks of the band.
+ * Starting with GDAL 2.2, the GDAL_NUM_THREADS configuration option can be
+ * set to a number of threads, or ALL_CPUS, to compute the checksum of a
+ * chunk in worker threads while the next one is read.  The result does not
+ * depend on the number of threads.
+ *
+ * For a stronger way of detecting changes in raster data, see
+ * GDALComputeRasterFingerprint().
+ *
  * @param hBand the raster band to read from.
  * @param nXOff pixel offset of window to read.
  * @param nYOff line offset of window to read.
@@ -61,106 +239,998 @@ GDALChecksumImage( GDALRasterBandH hBand,
 {
     VALIDATE_POINTER1( hBand, "GDALChecksumImage", 0 );
 
-    const static int anPrimes[11] =
-        { 7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43 };
-
-    int  iLine, i, nChecksum = 0, iPrime = 0, nCount;
     GDALDataType eDataType = GDALGetRasterDataType( hBand );
     int  bComplex = GDALDataTypeIsComplex( eDataType );
+    int  bFloat = (eDataType == GDT_Float32 || eDataType == GDT_Float64 ||
+                   eDataType == GDT_CFloat32 || eDataType == GDT_CFloat64);
+    GDALDataType eDstDataType;
+    if( bFloat )
+        eDstDataType = (bComplex) ? GDT_CFloat64 : GDT_Float64;
+    else
+        eDstDataType = (bComplex) ? GDT_CInt32 : GDT_Int32;
+    const int nValueSize = bFloat ? (int)sizeof(double) : (int)sizeof(GInt32);
 
-    if (eDataType == GDT_Float32 || eDataType == GDT_Float64 ||
-        eDataType == GDT_CFloat32 || eDataType == GDT_CFloat64)
+    if( nXSize <= 0 || nYSize <= 0 )
+        return 0;
+
+    const int nValuesPerLine = (bComplex) ? nXSize * 2 : nXSize;
+
+/* -------------------------------------------------------------------- */
+/*      Chunks of lines, made of whole blocks if possible.              */
+/* -------------------------------------------------------------------- */
+    int nBlockXSize = 0, nBlockYSize = 0;
+    GDALGetBlockSize( hBand, &nBlockXSize, &nBlockYSize );
+    if( nBlockYSize <= 0 )
+        nBlockYSize = 1;
+
+    int nChunkLines = MAX(1, CHECKSUM_CHUNK_SAMPLES / nValuesPerLine);
+    if( nChunkLines >= nBlockYSize )
+        nChunkLines = (nChunkLines / nBlockYSize) * nBlockYSize;
+    nChunkLines = MIN(nChunkLines, nYSize);
+
+    const int nThreads = CPLGetNumThreads( NULL, "1" );
+    CPLWorkerThreadPool *poThreadPool = NULL;
+    if( nThreads > 1 &&
+        (GIntBig)nValuesPerLine * nYSize > CHECKSUM_CHUNK_SAMPLES / 4 )
     {
-        double* padfLineData;
-        GDALDataType eDstDataType = (bComplex) ? GDT_CFloat64 : GDT_Float64;
+        poThreadPool = new CPLWorkerThreadPool();
+        if( !poThreadPool->Setup( nThreads, NULL, NULL ) )
+        {
+            delete poThreadPool;
+            poThreadPool = NULL;
+        }
+    }
 
-        padfLineData = (double *) VSI_MALLOC2_VERBOSE(nXSize, sizeof(double) * 2);
-        if (padfLineData == NULL)
+    /* Two buffers: one being checksummed while the other one is read */
+    const int nBuffers = poThreadPool != NULL ? 2 : 1;
+    void *apBuffers[2] = { NULL, NULL };
+    for( int i = 0; i < nBuffers; i++ )
+    {
+        apBuffers[i] = VSI_MALLOC3_VERBOSE( nValuesPerLine, nChunkLines,
+                                            nValueSize );
+        if( apBuffers[i] == NULL )
         {
+            CPLFree( apBuffers[0] );
+            delete poThreadPool;
             return 0;
         }
+    }
 
-        for( iLine = nYOff; iLine < nYOff + nYSize; iLine++ )
+    std::vector<GDALChecksumJob> asJobs( nThreads );
+    GUInt32 nChecksum = 0;
+
+/* -------------------------------------------------------------------- */
+/*      Chunk boundaries are at multiples of nChunkLines.               */
+/* -------------------------------------------------------------------- */
+    int iChunkStart = nYOff;
+    int iChunkEnd = MIN(nYOff + nYSize,
+                        (nYOff / nChunkLines + 1) * nChunkLines);
+    int iBuffer = 0;
+    CPLErr eErr = GDALRasterIO( hBand, GF_Read, nXOff, iChunkStart,
+                                nXSize, iChunkEnd - iChunkStart,
+                                apBuffers[0], nXSize, iChunkEnd - iChunkStart,
+                                eDstDataType, 0, 0 );
+
+    while( iChunkStart < nYOff + nYSize )
+    {
+        const int iPrime = static_cast<int>(
+            ((GUIntBig)(iChunkStart - nYOff) * nValuesPerLine) % 11);
+
+        if( eErr != CE_None )
         {
-            if (GDALRasterIO( hBand, GF_Read, nXOff, iLine, nXSize, 1,
-                              padfLineData, nXSize, 1, eDstDataType, 0, 0 ) != CE_None)
-            {
-                CPLError( CE_Failure, CPLE_FileIO,
-                        "Checksum value couldn't be computed due to I/O read error.\n");
-                break;
-            }
-            nCount = (bComplex) ? nXSize * 2 : nXSize;
+            nChecksum += GDALChecksumLineByLine( hBand, nXOff, nXSize,
+                                                 iChunkStart, iChunkEnd,
+                                                 eDstDataType,
+                                                 apBuffers[iBuffer],
+                                                 nValuesPerLine, iPrime );
+            break;
+        }
+
+/* -------------------------------------------------------------------- */
+/*      Checksum the chunk, in worker threads while the next chunk is   */
+/*      read if possible.                                               */
+/* -------------------------------------------------------------------- */
+        const size_t nCount = (size_t)nValuesPerLine * (iChunkEnd - iChunkStart);
+        std::vector<void *> apJobs;
+        const int nJobs = poThreadPool != NULL ? nThreads : 1;
+        for( int i = 0; i < nJobs; i++ )
+        {
+            const size_t nStart = nCount / nJobs * i;
+            const size_t nEnd = (i == nJobs - 1) ? nCount : nCount / nJobs * (i + 1);
+            asJobs[i].pData = static_cast<GByte *>(apBuffers[iBuffer]) +
+                                                        nStart * nValueSize;
+            asJobs[i].bFloat = bFloat;
+            asJobs[i].nCount = nEnd - nStart;
+            asJobs[i].iPrime = static_cast<int>((iPrime + nStart) % 11);
+            asJobs[i].nSum = 0;
+            apJobs.push_back( &asJobs[i] );
+        }
+        // On failure, no job has been queued: run them here.
+        if( poThreadPool == NULL ||
+            !poThreadPool->SubmitJobs( GDALChecksumJobFunc, apJobs ) )
+        {
+            for( size_t i = 0; i < apJobs.size(); i++ )
+                GDALChecksumJobFunc( apJobs[i] );
+        }
+
+        const int iNextStart = iChunkEnd;
+        const int iNextEnd = MIN(nYOff + nYSize, iNextStart + nChunkLines);
+        const int iNextBuffer = (iBuffer + 1) % nBuffers;
+        if( iNextStart < nYOff + nYSize )
+        {
+            eErr = GDALRasterIO( hBand, GF_Read, nXOff, iNextStart,
+                                 nXSize, iNextEnd - iNextStart,
+                                 apBuffers[iNextBuffer], nXSize,
+                                 iNextEnd - iNextStart, eDstDataType, 0, 0 );
+        }
+
+        if( poThreadPool != NULL )
+            poThreadPool->WaitCompletion();
+        for( int i = 0; i < nJobs; i++ )
+            nChecksum += asJobs[i].nSum;
+
+        iChunkStart = iNextStart;
+        iChunkEnd = iNextEnd;
+        iBuffer = iNextBuffer;
+    }
+
+    for( int i = 0; i < nBuffers; i++ )
+        CPLFree( apBuffers[i] );
+    delete poThreadPool;
+
+    return static_cast<int>(nChecksum & 0xffff);
+}
+
+/************************************************************************/
+/* ==================================================================== */
+/*                              XXH64                                   */
+/* ==================================================================== */
+/************************************************************************/
+
+/*
+ * Streaming implementation of the 64 bit xxHash algorithm (XXH64) of
+ * Yann Collet.  Its results are the same as the reference implementation,
+ * whatever the endianness of the host.  The checksum code uses a zero seed.
+ */
+
+#define XXH64_CONST(hi, lo) \
+    ((static_cast<GUIntBig>(hi) << 32) | static_cast<GUIntBig>(lo))
+
+static const GUIntBig XXH_PRIME64_1 = XXH64_CONST(0x9E3779B1U, 0x85EBCA87U);
+static const GUIntBig XXH_PRIME64_2 = XXH64_CONST(0xC2B2AE3DU, 0x27D4EB4FU);
+static const GUIntBig XXH_PRIME64_3 = XXH64_CONST(0x165667B1U, 0x9E3779F9U);
+static const GUIntBig XXH_PRIME64_4 = XXH64_CONST(0x85EBCA77U, 0xC2B2AE63U);
+static const GUIntBig XXH_PRIME64_5 = XXH64_CONST(0x27D4EB2FU, 0x165667C5U);
+
+typedef struct
+{
+    GUIntBig    nTotalLen;
+    GUIntBig    anAcc[4];
+    GByte       abyBuffer[32];
+    int         nBufferSize;
+} GDALXXH64State;
+
+static inline GUIntBig GDALXXH64Rotl( GUIntBig nVal, int nBits )
+{
+    return (nVal << nBits) | (nVal >> (64 - nBits));
+}
+
+static inline GUIntBig GDALXXH64Read64( const GByte *pabyData )
+{
+    GUIntBig nVal;
+    memcpy( &nVal, pabyData, sizeof(nVal) );
+    CPL_LSBPTR64( &nVal );
+    return nVal;
+}
+
+static inline GUIntBig GDALXXH64Read32( const GByte *pabyData )
+{
+    GUInt32 nVal;
+    memcpy( &nVal, pabyData, sizeof(nVal) );
+    CPL_LSBPTR32( &nVal );
+    return nVal;
+}
+
+static inline GUIntBig GDALXXH64Round( GUIntBig nAcc, GUIntBig nInput )
+{
+    nAcc += nInput * XXH_PRIME64_2;
+    nAcc = GDALXXH64Rotl( nAcc, 31 );
+    return nAcc * XXH_PRIME64_1;
+}
+
+static inline GUIntBig GDALXXH64MergeRound( GUIntBig nAcc, GUIntBig nVal )
+{
+    nAcc ^= GDALXXH64Round( 0, nVal );
+    return nAcc * XXH_PRIME64_1 + XXH_PRIME64_4;
+}
+
+static void GDALXXH64Reset( GDALXXH64State *psState, GUIntBig nSeed )
+{
+    psState->nTotalLen = 0;
+    psState->anAcc[0] = nSeed + XXH_PRIME64_1 + XXH_PRIME64_2;
+    psState->anAcc[1] = nSeed + XXH_PRIME64_2;
+    psState->anAcc[2] = nSeed;
+    psState->anAcc[3] = nSeed - XXH_PRIME64_1;
+    psState->nBufferSize = 0;
+}
+
+static inline void GDALXXH64Stripe( GUIntBig anAcc[4], const GByte *pabyData )
+{
+    anAcc[0] = GDALXXH64Round( anAcc[0], GDALXXH64Read64( pabyData ) );
+    anAcc[1] = GDALXXH64Round( anAcc[1], GDALXXH64Read64( pabyData + 8 ) );
+    anAcc[2] = GDALXXH64Round( anAcc[2], GDALXXH64Read64( pabyData + 16 ) );
+    anAcc[3] = GDALXXH64Round( anAcc[3], GDALXXH64Read64( pabyData + 24 ) );
+}
+
+static void GDALXXH64Update( GDALXXH64State *psState,
+                             const GByte *pabyData, size_t nLen )
+{
+    psState->nTotalLen += nLen;
+
+    if( psState->nBufferSize + nLen < 32 )
+    {
+        memcpy( psState->abyBuffer + psState->nBufferSize, pabyData, nLen );
+        psState->nBufferSize += static_cast<int>(nLen);
+        return;
+    }
+
+    if( psState->nBufferSize > 0 )
+    {
+        const size_t nFill = 32 - psState->nBufferSize;
+        memcpy( psState->abyBuffer + psState->nBufferSize, pabyData, nFill );
+        GDALXXH64Stripe( psState->anAcc, psState->abyBuffer );
+        pabyData += nFill;
+        nLen -= nFill;
+        psState->nBufferSize = 0;
+    }
+
+    GUIntBig anAcc[4] = { psState->anAcc[0], psState->anAcc[1],
+                          psState->anAcc[2], psState->anAcc[3] };
+    for( ; nLen >= 32; pabyData += 32, nLen -= 32 )
+        GDALXXH64Stripe( anAcc, pabyData );
+    memcpy( psState->anAcc, anAcc, sizeof(anAcc) );
+
+    memcpy( psState->abyBuffer, pabyData, nLen );
+    psState->nBufferSize = static_cast<int>(nLen);
+}
+
+static GUIntBig GDALXXH64Digest( const GDALXXH64State *psState )
+{
+    GUIntBig nHash;
+    const GUIntBig *panAcc = psState->anAcc;
+
+    if( psState->nTotalLen >= 32 )
+    {
+        nHash = GDALXXH64Rotl( panAcc[0], 1 ) + GDALXXH64Rotl( panAcc[1], 7 ) +
+                GDALXXH64Rotl( panAcc[2], 12 ) + GDALXXH64Rotl( panAcc[3], 18 );
+        for( int i = 0; i < 4; i++ )
+            nHash = GDALXXH64MergeRound( nHash, panAcc[i] );
+    }
+    else
+    {
+        nHash = panAcc[2] /* seed */ + XXH_PRIME64_5;
+    }
+    nHash += psState->nTotalLen;
+
+    const GByte *pabyData = psState->abyBuffer;
+    int nLen = psState->nBufferSize;
+    for( ; nLen >= 8; pabyData += 8, nLen -= 8 )
+    {
+        nHash ^= GDALXXH64Round( 0, GDALXXH64Read64( pabyData ) );
+        nHash = GDALXXH64Rotl( nHash, 27 ) * XXH_PRIME64_1 + XXH_PRIME64_4;
+    }
+    if( nLen >= 4 )
+    {
+        nHash ^= GDALXXH64Read32( pabyData ) * XXH_PRIME64_1;
+        nHash = GDALXXH64Rotl( nHash, 23 ) * XXH_PRIME64_2 + XXH_PRIME64_3;
+        pabyData += 4;
+        nLen -= 4;
+    }
+    for( ; nLen > 0; pabyData++, nLen-- )
+    {
+        nHash ^= (*pabyData) * XXH_PRIME64_5;
+        nHash = GDALXXH64Rotl( nHash, 11 ) * XXH_PRIME64_1;
+    }
+
+    nHash ^= nHash >> 33;
+    nHash *= XXH_PRIME64_2;
+    nHash ^= nHash >> 29;
+    nHash *= XXH_PRIME64_3;
+    nHash ^= nHash >> 32;
+
+    return nHash;
+}
+
+/************************************************************************/
+/*                              GDALXXH64()                             */
+/************************************************************************/
+
+/**
+ * One shot XXH64 hash of a buffer.
+ *
+ * This is mostly meant for checking the streaming implementation used by
+ * the checksum functions against the reference xxHash test vectors.
+ */
+
+GUIntBig GDALXXH64( const void *pData, size_t nLen, GUIntBig nSeed )
+{
+    GDALXXH64State sState;
+    GDALXXH64Reset( &sState, nSeed );
+    GDALXXH64Update( &sState, static_cast<const GByte *>(pData), nLen );
+    return GDALXXH64Digest( &sState );
+}
+
+/************************************************************************/
+/* ==================================================================== */
+/*                          Raster fingerprint                          */
+/* ==================================================================== */
+/************************************************************************/
+
+/*
+ * The fingerprint of a band keeps the XXH64 hash of each of its blocks,
+ * computed on the pixels of the block that are inside the raster, in the
+ * data type of the band and in little endian order.  The fingerprint value
+ * is the XXH64 hash of the raster and block dimensions, of the data type and
+ * of the hashes of the blocks in row-major order.  When only some blocks
+ * change, only their hashes need to be recomputed.
+ */
+
+typedef struct
+{
+    int                 nXSize;
+    int                 nYSize;
+    int                 nBlockXSize;
+    int                 nBlockYSize;
+    GDALDataType        eDataType;
+    int                 nBlocksPerRow;
+    int                 nBlocksPerColumn;
+    GUIntBig           *panBlockHash;
+    char                szValue[17];
+} GDALRasterFingerprintInfo;
+
+/* A block hashed on a range of its lines in a chunk */
+typedef struct
+{
+    const GByte        *pabyData;
+    size_t              nLineStride;
+    int                 nLines;
+    int                 nLineBytes;
+    int                 bStart;
+    int                 bEnd;
+    GDALXXH64State     *psCarryIn;
+    GDALXXH64State     *psCarryOut;
+    GUIntBig           *pnHash;
+} GDALFingerprintSegment;
+
+typedef struct
+{
+    GDALFingerprintSegment *pasSegments;
+    int                 nSegments;
+    int                 nWordSize;
+} GDALFingerprintJob;
+
+/************************************************************************/
+/*                       GDALFingerprintJobFunc()                       */
+/************************************************************************/
+
+static void GDALFingerprintJobFunc( void *pData )
+{
+    GDALFingerprintJob *psJob = static_cast<GDALFingerprintJob *>(pData);
+
+#ifdef CPL_MSB
+    std::vector<GByte> abyLine;
+#endif
+
+    for( int i = 0; i < psJob->nSegments; i++ )
+    {
+        GDALFingerprintSegment *psSeg = psJob->pasSegments + i;
+        GDALXXH64State sState;
+        if( psSeg->bStart )
+            GDALXXH64Reset( &sState, 0 );
+        else
+            sState = *(psSeg->psCarryIn);
 
-            for( i = 0; i < nCount; i++ )
+        for( int iLine = 0; iLine < psSeg->nLines; iLine++ )
+        {
+            const GByte *pabyLine = psSeg->pabyData + iLine * psSeg->nLineStride;
+#ifdef CPL_MSB
+            if( psJob->nWordSize > 1 )
             {
-                double dfVal = padfLineData[i];
-                int nVal;
-                if (CPLIsNan(dfVal) || CPLIsInf(dfVal))
-                {
-                    /* Most compilers seem to cast NaN or Inf to 0x80000000. */
-                    /* but VC7 is an exception. So we force the result */
-                    /* of such a cast */
-                    nVal = 0x80000000;
-                }
-                else
-                {
-                    /* Standard behaviour of GDALCopyWords when converting */
-                    /* from floating point to Int32 */
-                    dfVal += 0.5;
-
-                    if( dfVal < -2147483647.0 )
-                        nVal = -2147483647;
-                    else if( dfVal > 2147483647 )
-                        nVal = 2147483647;
-                    else
-                        nVal = (GInt32) floor(dfVal);
-                }
-
-                nChecksum += (nVal % anPrimes[iPrime++]);
-                if( iPrime > 10 )
-                    iPrime = 0;
-
-                nChecksum &= 0xffff;
+                abyLine.assign( pabyLine, pabyLine + psSeg->nLineBytes );
+                GDALSwapWords( &abyLine[0], psJob->nWordSize,
+                               psSeg->nLineBytes / psJob->nWordSize,
+                               psJob->nWordSize );
+                pabyLine = &abyLine[0];
             }
+#endif
+            GDALXXH64Update( &sState, pabyLine, psSeg->nLineBytes );
         }
 
-        CPLFree(padfLineData);
+        if( psSeg->bEnd )
+            *(psSeg->pnHash) = GDALXXH64Digest( &sState );
+        else
+            *(psSeg->psCarryOut) = sState;
     }
-    else
+}
+
+/************************************************************************/
+/*                      GDALFingerprintHashBlocks()                     */
+/*                                                                      */
+/*      Hash the blocks [nBlockXStart,nBlockXEnd[ x                     */
+/*      [nBlockYStart,nBlockYEnd[.  Chunks of lines are read in the     */
+/*      calling thread, made of whole rows of blocks when they fit, and */
+/*      hashed in worker threads while the next chunk is read.  Blocks  */
+/*      taller than a chunk are hashed incrementally.                   */
+/************************************************************************/
+
+static CPLErr GDALFingerprintHashBlocks( GDALRasterFingerprintInfo *psInfo,
+                                         GDALRasterBandH hBand,
+                                         int nBlockXStart, int nBlockXEnd,
+                                         int nBlockYStart, int nBlockYEnd,
+                                         int nThreads,
+                                         GDALProgressFunc pfnProgress,
+                                         void *pProgressArg )
+{
+    const int nBlockXSize = psInfo->nBlockXSize;
+    const int nBlockYSize = psInfo->nBlockYSize;
+    const int nPixelSize = GDALGetDataTypeSize( psInfo->eDataType ) / 8;
+    const int nWinXOff = nBlockXStart * nBlockXSize;
+    const int nWinXSize = MIN(psInfo->nXSize, nBlockXEnd * nBlockXSize) - nWinXOff;
+    const int nWinYOff = nBlockYStart * nBlockYSize;
+    const int nWinYEnd = MIN(psInfo->nYSize, nBlockYEnd * nBlockYSize);
+    const int nBlocksX = nBlockXEnd - nBlockXStart;
+    const size_t nLineStride = (size_t)nWinXSize * nPixelSize;
+
+    int nChunkLines = static_cast<int>(
+        MAX(1, FINGERPRINT_CHUNK_BYTES / nLineStride));
+    if( nChunkLines >= nBlockYSize )
+        nChunkLines = (nChunkLines / nBlockYSize) * nBlockYSize;
+    nChunkLines = MIN(nChunkLines, nWinYEnd - nWinYOff);
+
+    CPLWorkerThreadPool *poThreadPool = NULL;
+    if( nThreads > 1 && (GIntBig)nLineStride * (nWinYEnd - nWinYOff) >
+                                                FINGERPRINT_CHUNK_BYTES / 4 )
     {
-        int  *panLineData;
-        GDALDataType eDstDataType = (bComplex) ? GDT_CInt32 : GDT_Int32;
+        poThreadPool = new CPLWorkerThreadPool();
+        if( !poThreadPool->Setup( nThreads, NULL, NULL ) )
+        {
+            delete poThreadPool;
+            poThreadPool = NULL;
+        }
+    }
+    if( poThreadPool == NULL )
+        nThreads = 1;
 
-        panLineData = (GInt32 *) VSI_MALLOC2_VERBOSE(nXSize, sizeof(GInt32) * 2);
-        if (panLineData == NULL)
+    const int nBuffers = poThreadPool != NULL ? 2 : 1;
+    GByte *apabyBuffers[2] = { NULL, NULL };
+    for( int i = 0; i < nBuffers; i++ )
+    {
+        apabyBuffers[i] = static_cast<GByte *>(
+            VSI_MALLOC2_VERBOSE( nLineStride, nChunkLines ) );
+        if( apabyBuffers[i] == NULL )
         {
-            return 0;
+            CPLFree( apabyBuffers[0] );
+            delete poThreadPool;
+            return CE_Failure;
         }
+    }
+
+    /* State of blocks that continue in the next chunk */
+    std::vector<GDALXXH64State> asCarryIn( nBlocksX ), asCarryOut( nBlocksX );
+    std::vector<GDALFingerprintSegment> asSegments;
+    std::vector<GDALFingerprintJob> asJobs( nThreads );
+    const int nWordSize = GDALDataTypeIsComplex( psInfo->eDataType ) ?
+                                            nPixelSize / 2 : nPixelSize;
 
-        for( iLine = nYOff; iLine < nYOff + nYSize; iLine++ )
+    int iChunkStart = nWinYOff;
+    int iChunkEnd = MIN(nWinYEnd, nWinYOff + nChunkLines);
+    int iBuffer = 0;
+    CPLErr eErr = GDALRasterIO( hBand, GF_Read, nWinXOff, iChunkStart,
+                                nWinXSize, iChunkEnd - iChunkStart,
+                                apabyBuffers[0], nWinXSize,
+                                iChunkEnd - iChunkStart,
+                                psInfo->eDataType, 0, 0 );
+
+    while( eErr == CE_None && iChunkStart < nWinYEnd )
+    {
+/* -------------------------------------------------------------------- */
+/*      One segment per block and per row of blocks of the chunk.       */
+/* -------------------------------------------------------------------- */
+        asSegments.resize( 0 );
+        for( int iY = iChunkStart; iY < iChunkEnd; )
         {
-            if (GDALRasterIO( hBand, GF_Read, nXOff, iLine, nXSize, 1,
-                            panLineData, nXSize, 1, eDstDataType, 0, 0 ) != CE_None)
+            const int iBlockY = iY / nBlockYSize;
+            const int nBlockEnd = MIN(psInfo->nYSize, (iBlockY + 1) * nBlockYSize);
+            const int nLines = MIN(nBlockEnd, iChunkEnd) - iY;
+            for( int iBX = 0; iBX < nBlocksX; iBX++ )
             {
-                CPLError( CE_Failure, CPLE_FileIO,
-                          "Checksum value could not be computed due to I/O "
-                          "read error.\n");
-                break;
+                const int iBlockX = nBlockXStart + iBX;
+                const int nXOff = iBlockX * nBlockXSize;
+                GDALFingerprintSegment sSeg;
+                sSeg.pabyData = apabyBuffers[iBuffer] +
+                    (size_t)(iY - iChunkStart) * nLineStride +
+                    (size_t)(nXOff - nWinXOff) * nPixelSize;
+                sSeg.nLineStride = nLineStride;
+                sSeg.nLines = nLines;
+                sSeg.nLineBytes = (MIN(psInfo->nXSize, nXOff + nBlockXSize)
+                                                        - nXOff) * nPixelSize;
+                sSeg.bStart = (iY == iBlockY * nBlockYSize);
+                sSeg.bEnd = (iY + nLines == nBlockEnd);
+                sSeg.psCarryIn = &asCarryIn[iBX];
+                sSeg.psCarryOut = &asCarryOut[iBX];
+                sSeg.pnHash = psInfo->panBlockHash +
+                    (size_t)iBlockY * psInfo->nBlocksPerRow + iBlockX;
+                asSegments.push_back( sSeg );
             }
-            nCount = (bComplex) ? nXSize * 2 : nXSize;
+            iY += nLines;
+        }
 
-            for( i = 0; i < nCount; i++ )
-            {
-                nChecksum += (panLineData[i] % anPrimes[iPrime++]);
-                if( iPrime > 10 )
-                    iPrime = 0;
+        const int nSegments = static_cast<int>(asSegments.size());
+        const int nJobs = MIN(nThreads, nSegments);
+        std::vector<void *> apJobs;
+        for( int i = 0; i < nJobs; i++ )
+        {
+            const int nStart = static_cast<int>((GIntBig)nSegments * i / nJobs);
+            const int nEnd = static_cast<int>((GIntBig)nSegments * (i + 1) / nJobs);
+            asJobs[i].pasSegments = &asSegments[0] + nStart;
+            asJobs[i].nSegments = nEnd - nStart;
+            asJobs[i].nWordSize = nWordSize;
+            apJobs.push_back( &asJobs[i] );
+        }
+        // On failure, no job has been queued: run them here.
+        if( poThreadPool == NULL ||
+            !poThreadPool->SubmitJobs( GDALFingerprintJobFunc, apJobs ) )
+        {
+            for( size_t i = 0; i < apJobs.size(); i++ )
+                GDALFingerprintJobFunc( apJobs[i] );
+        }
 
-                nChecksum &= 0xffff;
-            }
+/* -------------------------------------------------------------------- */
+/*      Read the next chunk meanwhile.                                  */
+/* -------------------------------------------------------------------- */
+        const int iNextStart = iChunkEnd;
+        const int iNextEnd = MIN(nWinYEnd, iNextStart + nChunkLines);
+        const int iNextBuffer = (iBuffer + 1) % nBuffers;
+        if( iNextStart < nWinYEnd )
+        {
+            eErr = GDALRasterIO( hBand, GF_Read, nWinXOff, iNextStart,
+                                 nWinXSize, iNextEnd - iNextStart,
+                                 apabyBuffers[iNextBuffer], nWinXSize,
+                                 iNextEnd - iNextStart,
+                                 psInfo->eDataType, 0, 0 );
+        }
+
+        if( poThreadPool != NULL )
+            poThreadPool->WaitCompletion();
+        asCarryIn.swap( asCarryOut );
+
+        iChunkStart = iNextStart;
+        iChunkEnd = iNextEnd;
+        iBuffer = iNextBuffer;
+
+        if( eErr == CE_None &&
+            !pfnProgress( (iChunkStart - nWinYOff) /
+                                (double)(nWinYEnd - nWinYOff),
+                          "", pProgressArg ) )
+        {
+            CPLError( CE_Failure, CPLE_UserInterrupt, "User terminated" );
+            eErr = CE_Failure;
         }
+    }
+
+    for( int i = 0; i < nBuffers; i++ )
+        CPLFree( apabyBuffers[i] );
+    delete poThreadPool;
+
+    return eErr;
+}
+
+/************************************************************************/
+/*                     GDALFingerprintComputeValue()                    */
+/************************************************************************/
+
+static void GDALFingerprintComputeValue( GDALRasterFingerprintInfo *psInfo )
+{
+    GDALXXH64State sState;
+    GDALXXH64Reset( &sState, 0 );
+
+    GUIntBig anHeader[5] = {
+        static_cast<GUIntBig>(psInfo->nXSize),
+        static_cast<GUIntBig>(psInfo->nYSize),
+        static_cast<GUIntBig>(psInfo->nBlockXSize),
+        static_cast<GUIntBig>(psInfo->nBlockYSize),
+        static_cast<GUIntBig>(psInfo->eDataType) };
+    for( int i = 0; i < 5; i++ )
+        CPL_LSBPTR64( &anHeader[i] );
+    GDALXXH64Update( &sState, reinterpret_cast<GByte *>(anHeader),
+                     sizeof(anHeader) );
+
+    const size_t nBlocks =
+        (size_t)psInfo->nBlocksPerRow * psInfo->nBlocksPerColumn;
+    for( size_t i = 0; i < nBlocks; i++ )
+    {
+        GUIntBig nHash = psInfo->panBlockHash[i];
+        CPL_LSBPTR64( &nHash );
+        GDALXXH64Update( &sState, reinterpret_cast<GByte *>(&nHash),
+                         sizeof(nHash) );
+    }
+
+    const GUIntBig nValue = GDALXXH64Digest( &sState );
+    snprintf( psInfo->szValue, sizeof(psInfo->szValue), "%08X%08X",
+              static_cast<unsigned>(nValue >> 32),
+              static_cast<unsigned>(nValue & 0xFFFFFFFFU) );
+}
+
+/************************************************************************/
+/*                    GDALCreateRasterFingerprintInfo()                 */
+/************************************************************************/
+
+static GDALRasterFingerprintInfo *
+GDALCreateRasterFingerprintInfo( int nXSize, int nYSize,
+                                 int nBlockXSize, int nBlockYSize,
+                                 GDALDataType eDataType )
+{
+    if( nXSize <= 0 || nYSize <= 0 || nBlockXSize <= 0 || nBlockYSize <= 0 ||
+        GDALGetDataTypeSize( eDataType ) == 0 )
+    {
+        CPLError( CE_Failure, CPLE_AppDefined,
+                  "Invalid dimensions or data type for a raster fingerprint." );
+        return NULL;
+    }
+
+    GDALRasterFingerprintInfo *psInfo =
+        static_cast<GDALRasterFingerprintInfo *>(
+            CPLCalloc( sizeof(GDALRasterFingerprintInfo), 1 ) );
+    psInfo->nXSize = nXSize;
+    psInfo->nYSize = nYSize;
+    psInfo->nBlockXSize = nBlockXSize;
+    psInfo->nBlockYSize = nBlockYSize;
+    psInfo->eDataType = eDataType;
+    psInfo->nBlocksPerRow = (nXSize + nBlockXSize - 1) / nBlockXSize;
+    psInfo->nBlocksPerColumn = (nYSize + nBlockYSize - 1) / nBlockYSize;
+    psInfo->panBlockHash = static_cast<GUIntBig *>(
+        VSI_CALLOC_VERBOSE( (size_t)psInfo->nBlocksPerRow *
+                                    psInfo->nBlocksPerColumn,
+                            sizeof(GUIntBig) ) );
+    if( psInfo->panBlockHash == NULL )
+    {
+        CPLFree( psInfo );
+        return NULL;
+    }
+
+    return psInfo;
+}
+
+/************************************************************************/
+/*                    GDALComputeRasterFingerprint()                    */
+/************************************************************************/
+
+/**
+ * Compute the fingerprint of a raster band.
+ *
+ * The fingerprint is made of a 64 bit xxHash (XXH64) hash of the data of
+ * each block of the band, in its data type, and of a fingerprint value,
+ * hash of the dimensions, data type and hashes of the blocks.  Unlike
+ * GDALChecksumImage(), any change of a pixel value is very likely to change
+ * the fingerprint value, but it is not a cryptographic hash.
+ *
+ * When some blocks of the band are modified, GDALUpdateRasterFingerprint()
+ * only needs to read them again to update the fingerprint.  The fingerprint
+ * can be saved with GDALSerializeRasterFingerprint().
+ *
+ * The band is read by chunks of rows of blocks.  Options:
+ * <ul>
+ * <li>NUM_THREADS=number_of_threads or ALL_CPUS: number of threads hashing
+ * the blocks of a chunk while the next one is read.  Defaults to the
+ * GDAL_NUM_THREADS configuration option, or 1.  The result does not depend
+ * on the number of threads.</li>
+ * </ul>
+ *
+ * @param hBand the raster band to fingerprint.
+ * @param papszOptions NULL-terminated list of options, or NULL.
+ * @param pfnProgress progress function, or NULL.
+ * @param pProgressArg argument of the progress function.
+ *
+ * @return a fingerprint handle, to be freed with
+ * GDALDestroyRasterFingerprint(), or NULL on failure.
+ *
+ * @since GDAL 2.2
+ */
+
+GDALRasterFingerprintH
+GDALComputeRasterFingerprint( GDALRasterBandH hBand, char **papszOptions,
+                              GDALProgressFunc pfnProgress,
+                              void *pProgressArg )
 
-        CPLFree( panLineData );
+{
+    VALIDATE_POINTER1( hBand, "GDALComputeRasterFingerprint", NULL );
+
+    if( pfnProgress == NULL )
+        pfnProgress = GDALDummyProgress;
+
+    int nBlockXSize = 0, nBlockYSize = 0;
+    GDALGetBlockSize( hBand, &nBlockXSize, &nBlockYSize );
+
+    GDALRasterFingerprintInfo *psInfo =
+        GDALCreateRasterFingerprintInfo( GDALGetRasterBandXSize( hBand ),
+                                         GDALGetRasterBandYSize( hBand ),
+                                         nBlockXSize, nBlockYSize,
+                                         GDALGetRasterDataType( hBand ) );
+    if( psInfo == NULL )
+        return NULL;
+
+    if( GDALFingerprintHashBlocks( psInfo, hBand,
+                                   0, psInfo->nBlocksPerRow,
+                                   0, psInfo->nBlocksPerColumn,
+                                   CPLGetNumThreads( papszOptions, "1" ),
+                                   pfnProgress, pProgressArg ) != CE_None )
+    {
+        GDALDestroyRasterFingerprint( psInfo );
+        return NULL;
     }
 
-    return nChecksum;
+    GDALFingerprintComputeValue( psInfo );
+    pfnProgress( 1.0, "", pProgressArg );
+
+    return psInfo;
+}
+
+/************************************************************************/
+/*                     GDALUpdateRasterFingerprint()                    */
+/************************************************************************/
+
+/**
+ * Update the fingerprint of a raster band after a change of a region.
+ *
+ * The blocks intersecting the region are read and hashed again, and the
+ * fingerprint value is recomputed.  The result is the same as
+ * GDALComputeRasterFingerprint() on the whole band, provided that the band
+ * was only modified in that region.
+ *
+ * @param hFingerprint fingerprint of the band.
+ * @param hBand the raster band, of the same dimensions, block size and data
+ * type as when the fingerprint was computed.
+ * @param nXOff pixel offset of the modified region.
+ * @param nYOff line offset of the modified region.
+ * @param nXSize width of the modified region.
+ * @param nYSize height of the modified region.
+ * @param papszOptions NULL-terminated list of options, or NULL.  Same as
+ * GDALComputeRasterFingerprint().
+ *
+ * @return CE_None on success, or CE_Failure.
+ *
+ * @since GDAL 2.2
+ */
+
+CPLErr GDALUpdateRasterFingerprint( GDALRasterFingerprintH hFingerprint,
+                                    GDALRasterBandH hBand,
+                                    int nXOff, int nYOff,
+                                    int nXSize, int nYSize,
+                                    char **papszOptions )
+
+{
+    VALIDATE_POINTER1( hFingerprint, "GDALUpdateRasterFingerprint", CE_Failure );
+    VALIDATE_POINTER1( hBand, "GDALUpdateRasterFingerprint", CE_Failure );
+
+    GDALRasterFingerprintInfo *psInfo =
+        static_cast<GDALRasterFingerprintInfo *>(hFingerprint);
+
+    int nBlockXSize = 0, nBlockYSize = 0;
+    GDALGetBlockSize( hBand, &nBlockXSize, &nBlockYSize );
+    if( GDALGetRasterBandXSize( hBand ) != psInfo->nXSize ||
+        GDALGetRasterBandYSize( hBand ) != psInfo->nYSize ||
+        nBlockXSize != psInfo->nBlockXSize ||
+        nBlockYSize != psInfo->nBlockYSize ||
+        GDALGetRasterDataType( hBand ) != psInfo->eDataType )
+    {
+        CPLError( CE_Failure, CPLE_AppDefined,
+                  "The dimensions, block size or data type of the band do not "
+                  "match the fingerprint." );
+        return CE_Failure;
+    }
+
+    /* Clip the region to the raster */
+    const int nXEnd = MIN(psInfo->nXSize, nXOff + MAX(0, nXSize));
+    const int nYEnd = MIN(psInfo->nYSize, nYOff + MAX(0, nYSize));
+    nXOff = MAX(0, nXOff);
+    nYOff = MAX(0, nYOff);
+    if( nXOff >= nXEnd || nYOff >= nYEnd )
+        return CE_None;
+
+    CPLErr eErr = GDALFingerprintHashBlocks( psInfo, hBand,
+                                nXOff / nBlockXSize,
+                                (nXEnd - 1) / nBlockXSize + 1,
+                                nYOff / nBlockYSize,
+                                (nYEnd - 1) / nBlockYSize + 1,
+                                CPLGetNumThreads( papszOptions, "1" ),
+                                GDALDummyProgress, NULL );
+
+    /* The hashes of the blocks that were not read are still valid */
+    GDALFingerprintComputeValue( psInfo );
+
+    return eErr;
+}
+
+/************************************************************************/
+/*                    GDALGetRasterFingerprintValue()                   */
+/************************************************************************/
+
+/**
+ * Return the value of a fingerprint.
+ *
+ * @param hFingerprint the fingerprint.
+ *
+ * @return the 64 bit fingerprint value, as 16 hexadecimal digits.  The string
+ * is owned by the fingerprint.
+ *
+ * @since GDAL 2.2
+ */
+
+const char *GDALGetRasterFingerprintValue( GDALRasterFingerprintH hFingerprint )
+
+{
+    VALIDATE_POINTER1( hFingerprint, "GDALGetRasterFingerprintValue", NULL );
+
+    return static_cast<GDALRasterFingerprintInfo *>(hFingerprint)->szValue;
+}
+
+/************************************************************************/
+/*                   GDALSerializeRasterFingerprint()                   */
+/************************************************************************/
+
+/**
+ * Serialize a fingerprint.
+ *
+ * The hashes of the blocks are stored so that the fingerprint can be updated
+ * after a later GDALDeserializeRasterFingerprint().
+ *
+ * @param hFingerprint the fingerprint.
+ *
+ * @return a RasterFingerprint XML tree, to be freed with CPLDestroyXMLNode().
+ *
+ * @since GDAL 2.2
+ */
+
+CPLXMLNode *GDALSerializeRasterFingerprint( GDALRasterFingerprintH hFingerprint )
+
+{
+    VALIDATE_POINTER1( hFingerprint, "GDALSerializeRasterFingerprint", NULL );
+
+    GDALRasterFingerprintInfo *psInfo =
+        static_cast<GDALRasterFingerprintInfo *>(hFingerprint);
+
+    const size_t nBlocks =
+        (size_t)psInfo->nBlocksPerRow * psInfo->nBlocksPerColumn;
+    if( nBlocks * sizeof(GUIntBig) > INT_MAX )
+    {
+        CPLError( CE_Failure, CPLE_NotSupported,
+                  "Too many blocks to serialize the fingerprint." );
+        return NULL;
+    }
+
+    CPLXMLNode *psTree =
+        CPLCreateXMLNode( NULL, CXT_Element, "RasterFingerprint" );
+
+    CPLCreateXMLElementAndValue( psTree, "Value", psInfo->szValue );
+    CPLCreateXMLElementAndValue( psTree, "DataType",
+                                 GDALGetDataTypeName( psInfo->eDataType ) );
+    CPLCreateXMLElementAndValue( psTree, "Size",
+        CPLString().Printf( "%d,%d", psInfo->nXSize, psInfo->nYSize ) );
+    CPLCreateXMLElementAndValue( psTree, "BlockSize",
+        CPLString().Printf( "%d,%d", psInfo->nBlockXSize,
+                            psInfo->nBlockYSize ) );
+
+/* -------------------------------------------------------------------- */
+/*      Block hashes as little endian 64 bit integers, in base64.       */
+/* -------------------------------------------------------------------- */
+    GUIntBig *panLSB = static_cast<GUIntBig *>(
+        VSI_MALLOC_VERBOSE( nBlocks * sizeof(GUIntBig) ) );
+    if( panLSB == NULL )
+    {
+        CPLDestroyXMLNode( psTree );
+        return NULL;
+    }
+    memcpy( panLSB, psInfo->panBlockHash, nBlocks * sizeof(GUIntBig) );
+#ifdef CPL_MSB
+    for( size_t i = 0; i < nBlocks; i++ )
+        CPL_LSBPTR64( panLSB + i );
+#endif
+    char *pszHashes =
+        CPLBase64Encode( static_cast<int>(nBlocks * sizeof(GUIntBig)),
+                         reinterpret_cast<GByte *>(panLSB) );
+    CPLFree( panLSB );
+    CPLCreateXMLElementAndValue( psTree, "BlockHashes", pszHashes );
+    CPLFree( pszHashes );
+
+    return psTree;
+}
+
+/************************************************************************/
+/*                  GDALDeserializeRasterFingerprint()                  */
+/************************************************************************/
+
+/**
+ * Create a fingerprint from its serialization.
+ *
+ * @param psTree a tree returned by GDALSerializeRasterFingerprint().
+ *
+ * @return a fingerprint handle, to be freed with
+ * GDALDestroyRasterFingerprint(), or NULL on failure.
+ *
+ * @since GDAL 2.2
+ */
+
+GDALRasterFingerprintH GDALDeserializeRasterFingerprint( CPLXMLNode *psTree )
+
+{
+    VALIDATE_POINTER1( psTree, "GDALDeserializeRasterFingerprint", NULL );
+
+    int nXSize = 0, nYSize = 0, nBlockXSize = 0, nBlockYSize = 0;
+    const char *pszHashes = CPLGetXMLValue( psTree, "BlockHashes", NULL );
+    if( psTree->eType != CXT_Element ||
+        !EQUAL(psTree->pszValue, "RasterFingerprint") ||
+        pszHashes == NULL ||
+        sscanf( CPLGetXMLValue( psTree, "Size", "" ), "%d,%d",
+                &nXSize, &nYSize ) != 2 ||
+        sscanf( CPLGetXMLValue( psTree, "BlockSize", "" ), "%d,%d",
+                &nBlockXSize, &nBlockYSize ) != 2 )
+    {
+        CPLError( CE_Failure, CPLE_AppDefined,
+                  "Invalid RasterFingerprint definition." );
+        return NULL;
+    }
+
+    GDALRasterFingerprintInfo *psInfo =
+        GDALCreateRasterFingerprintInfo(
+            nXSize, nYSize, nBlockXSize, nBlockYSize,
+            GDALGetDataTypeByName( CPLGetXMLValue( psTree, "DataType", "" ) ) );
+    if( psInfo == NULL )
+        return NULL;
+
+    const size_t nBlocks =
+        (size_t)psInfo->nBlocksPerRow * psInfo->nBlocksPerColumn;
+    GByte *pabyHashes = reinterpret_cast<GByte *>( CPLStrdup( pszHashes ) );
+    const int nDecoded = CPLBase64DecodeInPlace( pabyHashes );
+    if( (size_t)nDecoded != nBlocks * sizeof(GUIntBig) )
+    {
+        CPLError( CE_Failure, CPLE_AppDefined,
+                  "Invalid BlockHashes in RasterFingerprint definition." );
+        CPLFree( pabyHashes );
+        GDALDestroyRasterFingerprint( psInfo );
+        return NULL;
+    }
+    memcpy( psInfo->panBlockHash, pabyHashes, nBlocks * sizeof(GUIntBig) );
+    CPLFree( pabyHashes );
+#ifdef CPL_MSB
+    for( size_t i = 0; i < nBlocks; i++ )
+        CPL_LSBPTR64( psInfo->panBlockHash + i );
+#endif
+
+    GDALFingerprintComputeValue( psInfo );
+
+    return psInfo;
+}
+
+/************************************************************************/
+/*                    GDALDestroyRasterFingerprint()                    */
+/************************************************************************/
+
+/**
+ * Free a fingerprint.
+ *
+ * @param hFingerprint the fingerprint, or NULL.
+ *
+ * @since GDAL 2.2
+ */
+
+void GDALDestroyRasterFingerprint( GDALRasterFingerprintH hFingerprint )
+
+{
+    if( hFingerprint == NULL )
+        return;
+
+    GDALRasterFingerprintInfo *psInfo =
+        static_cast<GDALRasterFingerprintInfo *>(hFingerprint);
+    CPLFree( psInfo->panBlockHash );
+    CPLFree( psInfo );
 }
@@ -51,21 +51,55 @@ CPL_CVSID("$Id$");
 #endif /* DBL_MAX */
 
 /************************************************************************/
-/*                        GDALGridGetPointBounds()                      */
+/*                     GDALGridGetPointsInEllipse()                     */
 /************************************************************************/
 
-static void GDALGridGetPointBounds(const void* hFeature, CPLRectObj* pBounds)
+/* Fetches from the spatial index the indices, in increasing order, of the */
+/* points in the bounding box of the search ellipse centered on the grid */
+/* node, so that the algorithms only test those points, in the same order */
+/* as a full scan would. Returns false when there is no spatial index, or */
+/* when the ellipse is degenerate, in which case all the points must be */
+/* scanned. */
+
+static bool GDALGridGetPointsInEllipse( const void* hExtraParamsIn,
+                                        double dfXPoint, double dfYPoint,
+                                        double dfRadius1, double dfRadius2,
+                                        double dfAngle,
+                                        int** ppanIndices, int* pnCount )
 {
-    GDALGridPoint* psPoint = (GDALGridPoint*) hFeature;
-    GDALGridXYArrays* psXYArrays = psPoint->psXYArrays;
-    int i = psPoint->i;
-    double dfX = psXYArrays->padfX[i];
-    double dfY = psXYArrays->padfY[i];
-    pBounds->minx = dfX;
-    pBounds->miny = dfY;
-    pBounds->maxx = dfX;
-    pBounds->maxy = dfY;
-};
+    *ppanIndices = NULL;
+    *pnCount = 0;
+
+    const GDALGridExtraParameters* psExtraParams =
+        (const GDALGridExtraParameters*) hExtraParamsIn;
+    if( psExtraParams == NULL || psExtraParams->hRTree == NULL ||
+        !(dfRadius1 > 0.0) || !(dfRadius2 > 0.0) )
+        return false;
+
+    double dfHalfWidth = dfRadius1;
+    double dfHalfHeight = dfRadius2;
+    if( dfAngle != 0.0 )
+    {
+        const double dfCos = cos(dfAngle);
+        const double dfSin = sin(dfAngle);
+        dfHalfWidth = sqrt(dfRadius1 * dfRadius1 * dfCos * dfCos +
+                           dfRadius2 * dfRadius2 * dfSin * dfSin);
+        dfHalfHeight = sqrt(dfRadius1 * dfRadius1 * dfSin * dfSin +
+                            dfRadius2 * dfRadius2 * dfCos * dfCos);
+    }
+    // Margin for the rounding errors of the ellipse test.
+    dfHalfWidth *= 1 + 1e-10;
+    dfHalfHeight *= 1 + 1e-10;
+
+    CPLRectObj sAoi;
+    sAoi.minx = dfXPoint - dfHalfWidth;
+    sAoi.miny = dfYPoint - dfHalfHeight;
+    sAoi.maxx = dfXPoint + dfHalfWidth;
+    sAoi.maxy = dfYPoint + dfHalfHeight;
+    *ppanIndices = CPLPackedRTreeSearchIndices(psExtraParams->hRTree, &sAoi,
+                                               pnCount);
+    return true;
+}
 
 /************************************************************************/
 /*                   GDALGridInverseDistanceToAPower()                  */
@@ -123,7 +157,7 @@ GDALGridInverseDistanceToAPower( const void *poOptions, GUInt32 nPoints,
                                  const double *padfZ,
                                  double dfXPoint, double dfYPoint,
                                  double *pdfValue,
-                                 CPL_UNUSED void* hExtraParamsIn )
+                                 void* hExtraParamsIn )
 {
     // TODO: For optimization purposes pre-computed parameters should be moved
     // out of this routine to the calling function.
@@ -157,10 +191,20 @@ GDALGridInverseDistanceToAPower( const void *poOptions, GUInt32 nPoints,
     const GUInt32   nMaxPoints =
         ((GDALGridInverseDistanceToAPowerOptions *)poOptions)->nMaxPoints;
     double  dfNominator = 0.0, dfDenominator = 0.0;
-    GUInt32 i, n = 0;
+    GUInt32 n = 0;
 
-    for ( i = 0; i < nPoints; i++ )
+    int* panIndices = NULL;
+    int nIndices = 0;
+    const bool bUseIndex = GDALGridGetPointsInEllipse(
+        hExtraParamsIn, dfXPoint, dfYPoint,
+        ((GDALGridInverseDistanceToAPowerOptions *)poOptions)->dfRadius1,
+        ((GDALGridInverseDistanceToAPowerOptions *)poOptions)->dfRadius2,
+        dfAngle, &panIndices, &nIndices );
+    const GUInt32 nCandidates = bUseIndex ? (GUInt32)nIndices : nPoints;
+
+    for ( GUInt32 k = 0; k < nCandidates; k++ )
     {
+        const GUInt32 i = bUseIndex ? (GUInt32)panIndices[k] : k;
         double  dfRX = padfX[i] - dfXPoint;
         double  dfRY = padfY[i] - dfYPoint;
         const double dfR2 =
@@ -183,6 +227,7 @@ GDALGridInverseDistanceToAPower( const void *poOptions, GUInt32 nPoints,
             if ( dfR2 < 0.0000000000001 )
             {
                 (*pdfValue) = padfZ[i];
+                CPLFree(panIndices);
                 return CE_None;
             }
             else
@@ -197,6 +242,7 @@ GDALGridInverseDistanceToAPower( const void *poOptions, GUInt32 nPoints,
             }
         }
     }
+    CPLFree(panIndices);
 
     if ( n < ((GDALGridInverseDistanceToAPowerOptions *)poOptions)->nMinPoints
          || dfDenominator == 0.0 )
@@ -278,7 +324,7 @@ GDALGridInverseDistanceToAPowerNearestNeighbor( const void *poOptions, GUInt32 n
     GUInt32 n = 0;
 
     GDALGridExtraParameters* psExtraParams = (GDALGridExtraParameters*) hExtraParamsIn;
-    CPLQuadTree* phQuadTree = psExtraParams->hQuadTree;
+    CPLPackedRTree* hRTree = psExtraParams ? psExtraParams->hRTree : NULL;
 
     const double dfRPower2 = psExtraParams->dfRadiusPower2PreComp;
     const double dfRPower4 = psExtraParams->dfRadiusPower4PreComp;
@@ -286,7 +332,41 @@ GDALGridInverseDistanceToAPowerNearestNeighbor( const void *poOptions, GUInt32 n
     const double dfPowerDiv2 = psExtraParams->dfPowerDiv2PreComp;
 
     std::multimap<double, double> oMapDistanceToZValues;
-    if (phQuadTree != NULL)
+    if (hRTree != NULL && nMaxPoints > 0)
+    {
+        // Only the nMaxPoints nearest points are used: ask them directly to
+        // the index. They come sorted by distance, and by index for points
+        // at the same distance, which is the order of the multimap.
+        int nFeatureCount = 0;
+        int* panPoints = CPLPackedRTreeSearchNearestIndices(
+            hRTree, dfXPoint, dfYPoint, static_cast<int>(nMaxPoints),
+            dfRadius, &nFeatureCount, NULL);
+        int iSingular = -1;
+        for(int k = 0; k < nFeatureCount; k++)
+        {
+            const int i = panPoints[k];
+            double  dfRX = padfX[i] - dfXPoint;
+            double  dfRY = padfY[i] - dfYPoint;
+
+            const double dfR2 = dfRX * dfRX + dfRY * dfRY;
+            if (dfR2 < 0.0000000000001)
+            {
+                if( iSingular < 0 || i < iSingular )
+                    iSingular = i;
+            }
+            else if( iSingular < 0 && dfR2 <= dfRPower2 )
+            {
+                oMapDistanceToZValues.insert(std::make_pair(dfR2, padfZ[i]));
+            }
+        }
+        CPLFree(panPoints);
+        if( iSingular >= 0 )
+        {
+            (*pdfValue) = padfZ[iSingular];
+            return CE_None;
+        }
+    }
+    else if (hRTree != NULL)
     {
         CPLRectObj sAoi;
         double dfSearchRadius = dfRadius;
@@ -295,13 +375,13 @@ GDALGridInverseDistanceToAPowerNearestNeighbor( const void *poOptions, GUInt32 n
         sAoi.maxx = dfXPoint + dfSearchRadius;
         sAoi.maxy = dfYPoint + dfSearchRadius;
         int nFeatureCount = 0;
-        GDALGridPoint** papsPoints = (GDALGridPoint**)
-                CPLQuadTreeSearch(phQuadTree, &sAoi, &nFeatureCount);
+        int* panPoints =
+                CPLPackedRTreeSearchIndices(hRTree, &sAoi, &nFeatureCount);
         if (nFeatureCount != 0)
         {
             for(int k = 0; k < nFeatureCount; k++)
             {
-                int i = papsPoints[k]->i;
+                int i = panPoints[k];
                 double  dfRX = padfX[i] - dfXPoint;
                 double  dfRY = padfY[i] - dfYPoint;
 
@@ -309,7 +389,7 @@ GDALGridInverseDistanceToAPowerNearestNeighbor( const void *poOptions, GUInt32 n
                 if (dfR2 < 0.0000000000001)
                 {
                     (*pdfValue) = padfZ[i];
-                    CPLFree(papsPoints);
+                    CPLFree(panPoints);
                     return CE_None;
                 }
                 if(dfR2 <= dfRPower2)
@@ -318,7 +398,7 @@ GDALGridInverseDistanceToAPowerNearestNeighbor( const void *poOptions, GUInt32 n
                 }
             }
         }
-        CPLFree(papsPoints);
+        CPLFree(panPoints);
     }
     else
     {
@@ -541,7 +621,7 @@ GDALGridMovingAverage( const void *poOptions, GUInt32 nPoints,
                        const double *padfX, const double *padfY,
                        const double *padfZ,
                        double dfXPoint, double dfYPoint, double *pdfValue,
-                       CPL_UNUSED void* hExtraParamsIn )
+                       void* hExtraParamsIn )
 {
     // TODO: For optimization purposes pre-computed parameters should be moved
     // out of this routine to the calling function.
@@ -567,10 +647,20 @@ GDALGridMovingAverage( const void *poOptions, GUInt32 nPoints,
     }
 
     double  dfAccumulator = 0.0;
-    GUInt32 i = 0, n = 0;
+    GUInt32 n = 0;
 
-    while ( i < nPoints )
+    int* panIndices = NULL;
+    int nIndices = 0;
+    const bool bUseIndex = GDALGridGetPointsInEllipse(
+        hExtraParamsIn, dfXPoint, dfYPoint,
+        ((GDALGridMovingAverageOptions *)poOptions)->dfRadius1,
+        ((GDALGridMovingAverageOptions *)poOptions)->dfRadius2,
+        dfAngle, &panIndices, &nIndices );
+    const GUInt32 nCandidates = bUseIndex ? (GUInt32)nIndices : nPoints;
+
+    for ( GUInt32 k = 0; k < nCandidates; k++ )
     {
+        const GUInt32 i = bUseIndex ? (GUInt32)panIndices[k] : k;
         double  dfRX = padfX[i] - dfXPoint;
         double  dfRY = padfY[i] - dfYPoint;
 
@@ -589,9 +679,8 @@ GDALGridMovingAverage( const void *poOptions, GUInt32 nPoints,
             dfAccumulator += padfZ[i];
             n++;
         }
-
-        i++;
     }
+    CPLFree(panIndices);
 
     if ( n < ((GDALGridMovingAverageOptions *)poOptions)->nMinPoints
          || n == 0 )
@@ -648,7 +737,7 @@ GDALGridNearestNeighbor( const void *poOptions, GUInt32 nPoints,
         ((GDALGridNearestNeighborOptions *)poOptions)->dfRadius2;
     double  dfR12;
     GDALGridExtraParameters* psExtraParams = (GDALGridExtraParameters*) hExtraParamsIn;
-    CPLQuadTree* hQuadTree = psExtraParams->hQuadTree;
+    CPLPackedRTree* hRTree = psExtraParams ? psExtraParams->hRTree : NULL;
 
     dfRadius1 *= dfRadius1;
     dfRadius2 *= dfRadius2;
@@ -671,58 +760,65 @@ GDALGridNearestNeighbor( const void *poOptions, GUInt32 nPoints,
     // Nearest distance will be initialized with the distance to the first
     // point in array.
     double      dfNearestR = DBL_MAX;
-    GUInt32 i = 0;
 
-    double dfSearchRadius = psExtraParams->dfInitialSearchRadius;
-    if( hQuadTree != NULL && dfRadius1 == dfRadius2 && dfSearchRadius > 0 )
+    if( hRTree != NULL && dfRadius1 == dfRadius2 )
     {
-        CPLRectObj sAoi;
-        if( dfRadius1 > 0 )
-            dfSearchRadius = ((GDALGridNearestNeighborOptions *)poOptions)->dfRadius1;
-        while(dfSearchRadius > 0)
+        double dfSearchRadius =
+            ((GDALGridNearestNeighborOptions *)poOptions)->dfRadius1;
+        int nFeatureCount = 0;
+        if( dfRadius1 == 0 )
         {
+            // Without search radius, the distance to the nearest point
+            // found by the index gives the search radius. The margin makes
+            // sure that the points at the same distance are also found.
+            double dfNearestDist2 = 0.0;
+            int* panNearest = CPLPackedRTreeSearchNearestIndices(
+                hRTree, dfXPoint, dfYPoint, 1, -1.0, &nFeatureCount,
+                &dfNearestDist2 );
+            CPLFree(panNearest);
+            dfSearchRadius = sqrt(dfNearestDist2) * (1 + 1e-10);
+        }
+        if( dfRadius1 > 0 || nFeatureCount > 0 )
+        {
+            CPLRectObj sAoi;
             sAoi.minx = dfXPoint - dfSearchRadius;
             sAoi.miny = dfYPoint - dfSearchRadius;
             sAoi.maxx = dfXPoint + dfSearchRadius;
             sAoi.maxy = dfYPoint + dfSearchRadius;
-            int nFeatureCount = 0;
-            GDALGridPoint** papsPoints = (GDALGridPoint**)
-                    CPLQuadTreeSearch(hQuadTree, &sAoi, &nFeatureCount);
-            if( nFeatureCount != 0 )
+            int* panPoints =
+                    CPLPackedRTreeSearchIndices(hRTree, &sAoi, &nFeatureCount);
+            if( nFeatureCount != 0 && dfRadius1 > 0 )
+                dfNearestR = dfRadius1;
+            for(int k=0; k<nFeatureCount; k++)
             {
-                if( dfRadius1 > 0 )
-                    dfNearestR = dfRadius1;
-                for(int k=0; k<nFeatureCount; k++)
-                {
-                    int idx = papsPoints[k]->i;
-                    double  dfRX = padfX[idx] - dfXPoint;
-                    double  dfRY = padfY[idx] - dfYPoint;
+                int idx = panPoints[k];
+                double  dfRX = padfX[idx] - dfXPoint;
+                double  dfRY = padfY[idx] - dfYPoint;
 
-                    const double    dfR2 = dfRX * dfRX + dfRY * dfRY;
-                    if( dfR2 <= dfNearestR )
-                    {
-                        dfNearestR = dfR2;
-                        dfNearestValue = padfZ[idx];
-                    }
+                const double    dfR2 = dfRX * dfRX + dfRY * dfRY;
+                if( dfR2 <= dfNearestR )
+                {
+                    dfNearestR = dfR2;
+                    dfNearestValue = padfZ[idx];
                 }
-
-                CPLFree(papsPoints);
-                break;
-            }
-            else
-            {
-                CPLFree(papsPoints);
-                if( dfRadius1 > 0 )
-                    break;
-                dfSearchRadius *= 2;
-                //CPLDebug("GDAL_GRID", "Increasing search radius to %.16g", dfSearchRadius);
             }
+            CPLFree(panPoints);
         }
     }
     else
     {
-        while ( i < nPoints )
+        int* panIndices = NULL;
+        int nIndices = 0;
+        const bool bUseIndex = GDALGridGetPointsInEllipse(
+            hExtraParamsIn, dfXPoint, dfYPoint,
+            ((GDALGridNearestNeighborOptions *)poOptions)->dfRadius1,
+            ((GDALGridNearestNeighborOptions *)poOptions)->dfRadius2,
+            dfAngle, &panIndices, &nIndices );
+        const GUInt32 nCandidates = bUseIndex ? (GUInt32)nIndices : nPoints;
+
+        for ( GUInt32 k = 0; k < nCandidates; k++ )
         {
+            const GUInt32 i = bUseIndex ? (GUInt32)panIndices[k] : k;
             double  dfRX = padfX[i] - dfXPoint;
             double  dfRY = padfY[i] - dfYPoint;
 
@@ -745,9 +841,8 @@ GDALGridNearestNeighbor( const void *poOptions, GUInt32 nPoints,
                     dfNearestValue = padfZ[i];
                 }
             }
-
-            i++;
         }
+        CPLFree(panIndices);
     }
 
     (*pdfValue) = dfNearestValue;
@@ -795,7 +890,7 @@ GDALGridDataMetricMinimum( const void *poOptions, GUInt32 nPoints,
                            const double *padfX, const double *padfY,
                            const double *padfZ,
                            double dfXPoint, double dfYPoint, double *pdfValue,
-                           CPL_UNUSED void* hExtraParamsIn )
+                           void* hExtraParamsIn )
 {
     // TODO: For optimization purposes pre-computed parameters should be moved
     // out of this routine to the calling function.
@@ -823,10 +918,20 @@ GDALGridDataMetricMinimum( const void *poOptions, GUInt32 nPoints,
     }
 
     double      dfMinimumValue=0.0;
-    GUInt32     i = 0, n = 0;
+    GUInt32     n = 0;
 
-    while ( i < nPoints )
+    int* panIndices = NULL;
+    int nIndices = 0;
+    const bool bUseIndex = GDALGridGetPointsInEllipse(
+        hExtraParamsIn, dfXPoint, dfYPoint,
+        ((GDALGridDataMetricsOptions *)poOptions)->dfRadius1,
+        ((GDALGridDataMetricsOptions *)poOptions)->dfRadius2,
+        dfAngle, &panIndices, &nIndices );
+    const GUInt32 nCandidates = bUseIndex ? (GUInt32)nIndices : nPoints;
+
+    for ( GUInt32 k = 0; k < nCandidates; k++ )
     {
+        const GUInt32 i = bUseIndex ? (GUInt32)panIndices[k] : k;
         double  dfRX = padfX[i] - dfXPoint;
         double  dfRY = padfY[i] - dfYPoint;
 
@@ -851,9 +956,8 @@ GDALGridDataMetricMinimum( const void *poOptions, GUInt32 nPoints,
                 dfMinimumValue = padfZ[i];
             n++;
         }
-
-        i++;
     }
+    CPLFree(panIndices);
 
     if ( n < ((GDALGridDataMetricsOptions *)poOptions)->nMinPoints
          || n == 0 )
@@ -907,7 +1011,7 @@ GDALGridDataMetricMaximum( const void *poOptions, GUInt32 nPoints,
                            const double *padfX, const double *padfY,
                            const double *padfZ,
                            double dfXPoint, double dfYPoint, double *pdfValue,
-                           CPL_UNUSED void* hExtraParamsIn )
+                           void* hExtraParamsIn )
 {
     // TODO: For optimization purposes pre-computed parameters should be moved
     // out of this routine to the calling function.
@@ -935,10 +1039,20 @@ GDALGridDataMetricMaximum( const void *poOptions, GUInt32 nPoints,
     }
 
     double      dfMaximumValue=0.0;
-    GUInt32     i = 0, n = 0;
+    GUInt32     n = 0;
 
-    while ( i < nPoints )
+    int* panIndices = NULL;
+    int nIndices = 0;
+    const bool bUseIndex = GDALGridGetPointsInEllipse(
+        hExtraParamsIn, dfXPoint, dfYPoint,
+        ((GDALGridDataMetricsOptions *)poOptions)->dfRadius1,
+        ((GDALGridDataMetricsOptions *)poOptions)->dfRadius2,
+        dfAngle, &panIndices, &nIndices );
+    const GUInt32 nCandidates = bUseIndex ? (GUInt32)nIndices : nPoints;
+
+    for ( GUInt32 k = 0; k < nCandidates; k++ )
     {
+        const GUInt32 i = bUseIndex ? (GUInt32)panIndices[k] : k;
         double  dfRX = padfX[i] - dfXPoint;
         double  dfRY = padfY[i] - dfYPoint;
 
@@ -963,9 +1077,8 @@ GDALGridDataMetricMaximum( const void *poOptions, GUInt32 nPoints,
                 dfMaximumValue = padfZ[i];
             n++;
         }
-
-        i++;
     }
+    CPLFree(panIndices);
 
     if ( n < ((GDALGridDataMetricsOptions *)poOptions)->nMinPoints
          || n == 0 )
@@ -1020,7 +1133,7 @@ GDALGridDataMetricRange( const void *poOptions, GUInt32 nPoints,
                          const double *padfX, const double *padfY,
                          const double *padfZ,
                          double dfXPoint, double dfYPoint, double *pdfValue,
-                         CPL_UNUSED void* hExtraParamsIn )
+                         void* hExtraParamsIn )
 {
     // TODO: For optimization purposes pre-computed parameters should be moved
     // out of this routine to the calling function.
@@ -1048,10 +1161,20 @@ GDALGridDataMetricRange( const void *poOptions, GUInt32 nPoints,
     }
 
     double      dfMaximumValue=0.0, dfMinimumValue=0.0;
-    GUInt32     i = 0, n = 0;
+    GUInt32     n = 0;
+
+    int* panIndices = NULL;
+    int nIndices = 0;
+    const bool bUseIndex = GDALGridGetPointsInEllipse(
+        hExtraParamsIn, dfXPoint, dfYPoint,
+        ((GDALGridDataMetricsOptions *)poOptions)->dfRadius1,
+        ((GDALGridDataMetricsOptions *)poOptions)->dfRadius2,
+        dfAngle, &panIndices, &nIndices );
+    const GUInt32 nCandidates = bUseIndex ? (GUInt32)nIndices : nPoints;
 
-    while ( i < nPoints )
+    for ( GUInt32 k = 0; k < nCandidates; k++ )
     {
+        const GUInt32 i = bUseIndex ? (GUInt32)panIndices[k] : k;
         double  dfRX = padfX[i] - dfXPoint;
         double  dfRY = padfY[i] - dfYPoint;
 
@@ -1078,9 +1201,8 @@ GDALGridDataMetricRange( const void *poOptions, GUInt32 nPoints,
                 dfMinimumValue = dfMaximumValue = padfZ[i];
             n++;
         }
-
-        i++;
     }
+    CPLFree(panIndices);
 
     if ( n < ((GDALGridDataMetricsOptions *)poOptions)->nMinPoints
          || n == 0 )
@@ -1132,7 +1254,7 @@ GDALGridDataMetricCount( const void *poOptions, GUInt32 nPoints,
                          const double *padfX, const double *padfY,
                          CPL_UNUSED const double *padfZ,
                          double dfXPoint, double dfYPoint, double *pdfValue,
-                         CPL_UNUSED void* hExtraParamsIn )
+                         void* hExtraParamsIn )
 {
     // TODO: For optimization purposes pre-computed parameters should be moved
     // out of this routine to the calling function.
@@ -1159,10 +1281,20 @@ GDALGridDataMetricCount( const void *poOptions, GUInt32 nPoints,
         dfCoeff2 = sin(dfAngle);
     }
 
-    GUInt32     i = 0, n = 0;
+    GUInt32     n = 0;
+
+    int* panIndices = NULL;
+    int nIndices = 0;
+    const bool bUseIndex = GDALGridGetPointsInEllipse(
+        hExtraParamsIn, dfXPoint, dfYPoint,
+        ((GDALGridDataMetricsOptions *)poOptions)->dfRadius1,
+        ((GDALGridDataMetricsOptions *)poOptions)->dfRadius2,
+        dfAngle, &panIndices, &nIndices );
+    const GUInt32 nCandidates = bUseIndex ? (GUInt32)nIndices : nPoints;
 
-    while ( i < nPoints )
+    for ( GUInt32 k = 0; k < nCandidates; k++ )
     {
+        const GUInt32 i = bUseIndex ? (GUInt32)panIndices[k] : k;
         double  dfRX = padfX[i] - dfXPoint;
         double  dfRY = padfY[i] - dfYPoint;
 
@@ -1178,9 +1310,8 @@ GDALGridDataMetricCount( const void *poOptions, GUInt32 nPoints,
         // Is this point located inside the search ellipse?
         if ( dfRadius2 * dfRX * dfRX + dfRadius1 * dfRY * dfRY <= dfR12 )
             n++;
-
-        i++;
     }
+    CPLFree(panIndices);
 
     if ( n < ((GDALGridDataMetricsOptions *)poOptions)->nMinPoints )
     {
@@ -1236,7 +1367,7 @@ GDALGridDataMetricAverageDistance( const void *poOptions, GUInt32 nPoints,
                                    CPL_UNUSED const double *padfZ,
                                    double dfXPoint, double dfYPoint,
                                    double *pdfValue,
-                                   CPL_UNUSED void* hExtraParamsIn )
+                                   void* hExtraParamsIn )
 {
     // TODO: For optimization purposes pre-computed parameters should be moved
     // out of this routine to the calling function.
@@ -1264,10 +1395,20 @@ GDALGridDataMetricAverageDistance( const void *poOptions, GUInt32 nPoints,
     }
 
     double      dfAccumulator = 0.0;
-    GUInt32     i = 0, n = 0;
+    GUInt32     n = 0;
+
+    int* panIndices = NULL;
+    int nIndices = 0;
+    const bool bUseIndex = GDALGridGetPointsInEllipse(
+        hExtraParamsIn, dfXPoint, dfYPoint,
+        ((GDALGridDataMetricsOptions *)poOptions)->dfRadius1,
+        ((GDALGridDataMetricsOptions *)poOptions)->dfRadius2,
+        dfAngle, &panIndices, &nIndices );
+    const GUInt32 nCandidates = bUseIndex ? (GUInt32)nIndices : nPoints;
 
-    while ( i < nPoints )
+    for ( GUInt32 k = 0; k < nCandidates; k++ )
     {
+        const GUInt32 i = bUseIndex ? (GUInt32)panIndices[k] : k;
         double  dfRX = padfX[i] - dfXPoint;
         double  dfRY = padfY[i] - dfYPoint;
 
@@ -1286,9 +1427,8 @@ GDALGridDataMetricAverageDistance( const void *poOptions, GUInt32 nPoints,
             dfAccumulator += sqrt( dfRX * dfRX + dfRY * dfRY );
             n++;
         }
-
-        i++;
     }
+    CPLFree(panIndices);
 
     if ( n < ((GDALGridDataMetricsOptions *)poOptions)->nMinPoints
          || n == 0 )
@@ -1347,7 +1487,7 @@ GDALGridDataMetricAverageDistancePts( const void *poOptions, GUInt32 nPoints,
                                       CPL_UNUSED const double *padfZ,
                                       double dfXPoint, double dfYPoint,
                                       double *pdfValue,
-                                      CPL_UNUSED void* hExtraParamsIn )
+                                      void* hExtraParamsIn )
 {
     // TODO: For optimization purposes pre-computed parameters should be moved
     // out of this routine to the calling function.
@@ -1375,11 +1515,21 @@ GDALGridDataMetricAverageDistancePts( const void *poOptions, GUInt32 nPoints,
     }
 
     double      dfAccumulator = 0.0;
-    GUInt32     i = 0, n = 0;
+    GUInt32     n = 0;
+
+    int* panIndices = NULL;
+    int nIndices = 0;
+    const bool bUseIndex = GDALGridGetPointsInEllipse(
+        hExtraParamsIn, dfXPoint, dfYPoint,
+        ((GDALGridDataMetricsOptions *)poOptions)->dfRadius1,
+        ((GDALGridDataMetricsOptions *)poOptions)->dfRadius2,
+        dfAngle, &panIndices, &nIndices );
+    const GUInt32 nCandidates = bUseIndex ? (GUInt32)nIndices : nPoints;
 
     // Search for the first point within the search ellipse
-    while ( i < nPoints - 1 )
+    for ( GUInt32 k = 0; k + 1 < nCandidates; k++ )
     {
+        const GUInt32 i = bUseIndex ? (GUInt32)panIndices[k] : k;
         double  dfRX1 = padfX[i] - dfXPoint;
         double  dfRY1 = padfY[i] - dfYPoint;
 
@@ -1395,12 +1545,11 @@ GDALGridDataMetricAverageDistancePts( const void *poOptions, GUInt32 nPoints,
         // Is this point located inside the search ellipse?
         if ( dfRadius2 * dfRX1 * dfRX1 + dfRadius1 * dfRY1 * dfRY1 <= dfR12 )
         {
-            GUInt32 j;
-
             // Search all the remaining points within the ellipse and compute
             // distances between them and the first point
-            for ( j = i + 1; j < nPoints; j++ )
+            for ( GUInt32 kk = k + 1; kk < nCandidates; kk++ )
             {
+                const GUInt32 j = bUseIndex ? (GUInt32)panIndices[kk] : kk;
                 double  dfRX2 = padfX[j] - dfXPoint;
                 double  dfRY2 = padfY[j] - dfYPoint;
 
@@ -1423,9 +1572,8 @@ GDALGridDataMetricAverageDistancePts( const void *poOptions, GUInt32 nPoints,
                 }
             }
         }
-
-        i++;
     }
+    CPLFree(panIndices);
 
     if ( n < ((GDALGridDataMetricsOptions *)poOptions)->nMinPoints
          || n == 0 )
@@ -1696,6 +1844,18 @@ static void GDALGridJobProcess(void* user_data)
     CPLFree(padfValues);
 }
 
+/************************************************************************/
+/*                      GDALGridHasSearchEllipse()                      */
+/************************************************************************/
+
+/* Whether the search of an algorithm is limited to an ellipse, and there */
+/* are enough points for a spatial index to pay off. */
+static bool GDALGridHasSearchEllipse( double dfRadius1, double dfRadius2,
+                                      GUInt32 nPoints )
+{
+    return dfRadius1 > 0 && dfRadius2 > 0 && nPoints > 100;
+}
+
 /************************************************************************/
 /*                        GDALGridContextCreate()                       */
 /************************************************************************/
@@ -1707,8 +1867,6 @@ struct GDALGridContext
     GDALGridFunction    pfnGDALGridMethod;
 
     GUInt32             nPoints;
-    GDALGridPoint      *pasGridPoints;
-    GDALGridXYArrays    sXYArrays;
 
     GDALGridExtraParameters sExtraParameters;
     double*             padfX;
@@ -1723,7 +1881,7 @@ struct GDALGridContext
     CPLWorkerThreadPool *poWorkerThreadPool;
 };
 
-static void GDALGridContextCreateQuadTree(GDALGridContext* psContext);
+static void GDALGridContextCreateRTree(GDALGridContext* psContext);
 
 /**
  * Creates a context to do regular gridding from the scattered data.
@@ -1744,6 +1902,11 @@ static void GDALGridContextCreateQuadTree(GDALGridContext* psContext);
  * instruction set. This can be disabled by setting the GDAL_USE_AVX
  * configuration option to NO.
  *
+ * When there are more than 100 points, the algorithms that search the points
+ * in an ellipse (or the nearest points) use a spatial index of the points,
+ * so that only the points in the neighbourhood of each node are examined.
+ * The result is the same as with an exhaustive scan of the points.
+ *
  * It is possible to set the GDAL_NUM_THREADS
  * configuration option to parallelize the processing. The value to set is
  * the number of worker threads, or ALL_CPUS to use all the cores/CPUs of the
@@ -1776,7 +1939,7 @@ GDALGridContextCreate( GDALGridAlgorithm eAlgorithm, const void *poOptions,
     CPLAssert( padfX );
     CPLAssert( padfY );
     CPLAssert( padfZ );
-    int bCreateQuadTree = FALSE;
+    int bCreateRTree = FALSE;
 
     /* Potentially unaligned pointers */
     void* pabyX = NULL;
@@ -1882,7 +2045,13 @@ GDALGridContextCreate( GDALGridAlgorithm eAlgorithm, const void *poOptions,
                 }
             }
             else
+            {
                 pfnGDALGridMethod = GDALGridInverseDistanceToAPower;
+                bCreateRTree = GDALGridHasSearchEllipse(
+                    ((GDALGridInverseDistanceToAPowerOptions *)poOptions)->dfRadius1,
+                    ((GDALGridInverseDistanceToAPowerOptions *)poOptions)->dfRadius2,
+                    nPoints);
+            }
             break;
 
         case GGA_InverseDistanceToAPowerNearestNeighbor:
@@ -1890,7 +2059,7 @@ GDALGridContextCreate( GDALGridAlgorithm eAlgorithm, const void *poOptions,
             memcpy(poOptionsNew, poOptions, sizeof(GDALGridInverseDistanceToAPowerNearestNeighborOptions));
 
             pfnGDALGridMethod = GDALGridInverseDistanceToAPowerNearestNeighbor;
-            bCreateQuadTree = TRUE;
+            bCreateRTree = TRUE;
             break;
 
         case GGA_MovingAverage:
@@ -1898,6 +2067,10 @@ GDALGridContextCreate( GDALGridAlgorithm eAlgorithm, const void *poOptions,
             memcpy(poOptionsNew, poOptions, sizeof(GDALGridMovingAverageOptions));
 
             pfnGDALGridMethod = GDALGridMovingAverage;
+            bCreateRTree = GDALGridHasSearchEllipse(
+                ((GDALGridMovingAverageOptions *)poOptions)->dfRadius1,
+                ((GDALGridMovingAverageOptions *)poOptions)->dfRadius2,
+                nPoints);
             break;
 
         case GGA_NearestNeighbor:
@@ -1905,9 +2078,7 @@ GDALGridContextCreate( GDALGridAlgorithm eAlgorithm, const void *poOptions,
             memcpy(poOptionsNew, poOptions, sizeof(GDALGridNearestNeighborOptions));
 
             pfnGDALGridMethod = GDALGridNearestNeighbor;
-            bCreateQuadTree = (nPoints > 100 &&
-                (((GDALGridNearestNeighborOptions *)poOptions)->dfRadius1 ==
-                ((GDALGridNearestNeighborOptions *)poOptions)->dfRadius2));
+            bCreateRTree = nPoints > 100;
             break;
 
         case GGA_MetricMinimum:
@@ -1915,6 +2086,10 @@ GDALGridContextCreate( GDALGridAlgorithm eAlgorithm, const void *poOptions,
             memcpy(poOptionsNew, poOptions, sizeof(GDALGridDataMetricsOptions));
 
             pfnGDALGridMethod = GDALGridDataMetricMinimum;
+            bCreateRTree = GDALGridHasSearchEllipse(
+                ((GDALGridDataMetricsOptions *)poOptions)->dfRadius1,
+                ((GDALGridDataMetricsOptions *)poOptions)->dfRadius2,
+                nPoints);
             break;
 
         case GGA_MetricMaximum:
@@ -1922,6 +2097,10 @@ GDALGridContextCreate( GDALGridAlgorithm eAlgorithm, const void *poOptions,
             memcpy(poOptionsNew, poOptions, sizeof(GDALGridDataMetricsOptions));
 
             pfnGDALGridMethod = GDALGridDataMetricMaximum;
+            bCreateRTree = GDALGridHasSearchEllipse(
+                ((GDALGridDataMetricsOptions *)poOptions)->dfRadius1,
+                ((GDALGridDataMetricsOptions *)poOptions)->dfRadius2,
+                nPoints);
             break;
 
         case GGA_MetricRange:
@@ -1929,6 +2108,10 @@ GDALGridContextCreate( GDALGridAlgorithm eAlgorithm, const void *poOptions,
             memcpy(poOptionsNew, poOptions, sizeof(GDALGridDataMetricsOptions));
 
             pfnGDALGridMethod = GDALGridDataMetricRange;
+            bCreateRTree = GDALGridHasSearchEllipse(
+                ((GDALGridDataMetricsOptions *)poOptions)->dfRadius1,
+                ((GDALGridDataMetricsOptions *)poOptions)->dfRadius2,
+                nPoints);
             break;
 
         case GGA_MetricCount:
@@ -1936,6 +2119,10 @@ GDALGridContextCreate( GDALGridAlgorithm eAlgorithm, const void *poOptions,
             memcpy(poOptionsNew, poOptions, sizeof(GDALGridDataMetricsOptions));
 
             pfnGDALGridMethod = GDALGridDataMetricCount;
+            bCreateRTree = GDALGridHasSearchEllipse(
+                ((GDALGridDataMetricsOptions *)poOptions)->dfRadius1,
+                ((GDALGridDataMetricsOptions *)poOptions)->dfRadius2,
+                nPoints);
             break;
 
         case GGA_MetricAverageDistance:
@@ -1943,6 +2130,10 @@ GDALGridContextCreate( GDALGridAlgorithm eAlgorithm, const void *poOptions,
             memcpy(poOptionsNew, poOptions, sizeof(GDALGridDataMetricsOptions));
 
             pfnGDALGridMethod = GDALGridDataMetricAverageDistance;
+            bCreateRTree = GDALGridHasSearchEllipse(
+                ((GDALGridDataMetricsOptions *)poOptions)->dfRadius1,
+                ((GDALGridDataMetricsOptions *)poOptions)->dfRadius2,
+                nPoints);
             break;
 
         case GGA_MetricAverageDistancePts:
@@ -1950,6 +2141,10 @@ GDALGridContextCreate( GDALGridAlgorithm eAlgorithm, const void *poOptions,
             memcpy(poOptionsNew, poOptions, sizeof(GDALGridDataMetricsOptions));
 
             pfnGDALGridMethod = GDALGridDataMetricAverageDistancePts;
+            bCreateRTree = GDALGridHasSearchEllipse(
+                ((GDALGridDataMetricsOptions *)poOptions)->dfRadius1,
+                ((GDALGridDataMetricsOptions *)poOptions)->dfRadius2,
+                nPoints);
             break;
 
         case GGA_Linear:
@@ -1992,11 +2187,7 @@ GDALGridContextCreate( GDALGridAlgorithm eAlgorithm, const void *poOptions,
     psContext->poOptions = poOptionsNew;
     psContext->pfnGDALGridMethod = pfnGDALGridMethod;
     psContext->nPoints = nPoints;
-    psContext->pasGridPoints = NULL;
-    psContext->sXYArrays.padfX = padfX;
-    psContext->sXYArrays.padfY = padfY;
-    psContext->sExtraParameters.hQuadTree = NULL;
-    psContext->sExtraParameters.dfInitialSearchRadius = 0;
+    psContext->sExtraParameters.hRTree = NULL;
     psContext->sExtraParameters.pafX = pafXAligned;
     psContext->sExtraParameters.pafY = pafYAligned;
     psContext->sExtraParameters.pafZ = pafZAligned;
@@ -2011,11 +2202,11 @@ GDALGridContextCreate( GDALGridAlgorithm eAlgorithm, const void *poOptions,
     psContext->pabyZ = pabyZ;
 
 /* -------------------------------------------------------------------- */
-/*  Create quadtree if requested and possible.                          */
+/*  Create spatial index if requested and possible.                     */
 /* -------------------------------------------------------------------- */
-    if( bCreateQuadTree )
+    if( bCreateRTree )
     {
-        GDALGridContextCreateQuadTree(psContext);
+        GDALGridContextCreateRTree(psContext);
     }
 
     /* -------------------------------------------------------------------- */
@@ -2077,51 +2268,37 @@ GDALGridContextCreate( GDALGridAlgorithm eAlgorithm, const void *poOptions,
 }
 
 /************************************************************************/
-/*                      GDALGridContextCreateQuadTree()                 */
+/*                      GDALGridContextCreateRTree()                    */
 /************************************************************************/
 
-void GDALGridContextCreateQuadTree(GDALGridContext* psContext)
+void GDALGridContextCreateRTree(GDALGridContext* psContext)
 {
     GUInt32 nPoints = psContext->nPoints;
-    psContext->pasGridPoints = (GDALGridPoint*)
-            VSI_MALLOC2_VERBOSE(nPoints, sizeof(GDALGridPoint));
-    if( psContext->pasGridPoints != NULL )
+    if( nPoints > INT_MAX )
+        return;
+    CPLRectObj* pasBounds = (CPLRectObj*)
+            VSI_MALLOC2_VERBOSE(nPoints, sizeof(CPLRectObj));
+    if( pasBounds != NULL )
     {
         const double* padfX = psContext->padfX;
         const double* padfY = psContext->padfY;
 
-        CPLRectObj sRect;
-        GUInt32 i;
-
-        /* Determine point extents */
-        sRect.minx = padfX[0];
-        sRect.miny = padfY[0];
-        sRect.maxx = padfX[0];
-        sRect.maxy = padfY[0];
-        for(i = 1; i < nPoints; i++)
+        for(GUInt32 i = 0; i < nPoints; i++)
         {
-            if( padfX[i] < sRect.minx ) sRect.minx = padfX[i];
-            if( padfY[i] < sRect.miny ) sRect.miny = padfY[i];
-            if( padfX[i] > sRect.maxx ) sRect.maxx = padfX[i];
-            if( padfY[i] > sRect.maxy ) sRect.maxy = padfY[i];
+            pasBounds[i].minx = padfX[i];
+            pasBounds[i].miny = padfY[i];
+            pasBounds[i].maxx = padfX[i];
+            pasBounds[i].maxy = padfY[i];
         }
 
-        /* Initial value for search radius is the typical dimension of a */
-        /* "pixel" of the point array (assuming rather uniform distribution) */
-        psContext->sExtraParameters.dfInitialSearchRadius =
-                                sqrt((sRect.maxx - sRect.minx) *
-                                        (sRect.maxy - sRect.miny) / nPoints);
-
-        psContext->sExtraParameters.hQuadTree =
-                    CPLQuadTreeCreate(&sRect, GDALGridGetPointBounds );
-
-        for(i = 0; i < nPoints; i++)
-        {
-            psContext->pasGridPoints[i].psXYArrays = &(psContext->sXYArrays);
-            psContext->pasGridPoints[i].i = i;
-            CPLQuadTreeInsert(psContext->sExtraParameters.hQuadTree,
-                                psContext->pasGridPoints + i);
-        }
+        /* Points never change during the gridding, so a bulk-loaded */
+        /* packed R-tree is both faster to build and to query than a */
+        /* quadtree. */
+        psContext->sExtraParameters.hRTree =
+            CPLPackedRTreeCreateWithBounds( static_cast<int>(nPoints), NULL,
+                                            pasBounds, CPLPRT_ORDER_HILBERT,
+                                            0 );
+        CPLFree(pasBounds);
     }
 }
 
@@ -2141,9 +2318,8 @@ void GDALGridContextFree(GDALGridContext* psContext)
     if( psContext )
     {
         CPLFree( psContext->poOptions );
-        CPLFree( psContext->pasGridPoints );
-        if( psContext->sExtraParameters.hQuadTree != NULL )
-            CPLQuadTreeDestroy( psContext->sExtraParameters.hQuadTree );
+        if( psContext->sExtraParameters.hRTree != NULL )
+            CPLPackedRTreeDestroy( psContext->sExtraParameters.hRTree );
         if( psContext->bFreePadfXYZArrays )
         {
             CPLFree(psContext->padfX);
@@ -2212,7 +2388,7 @@ CPLErr GDALGridContextProcess(GDALGridContext* psContext,
     // by sampling along the edges (if all points on edges are within triangles,
     // then interior points will also be!)
     if( psContext->eAlgorithm == GGA_Linear &&
-        psContext->sExtraParameters.hQuadTree == NULL )
+        psContext->sExtraParameters.hRTree == NULL )
     {
         int bNeedNearest = FALSE;
         int nStartLeft = 0, nStartRight = 0;
@@ -2262,7 +2438,7 @@ CPLErr GDALGridContextProcess(GDALGridContext* psContext,
         if( bNeedNearest )
         {
             CPLDebug("GDAL_GRID", "Will need nearest neighbour");
-            GDALGridContextCreateQuadTree(psContext);
+            GDALGridContextCreateRTree(psContext);
         }
     }
 
@@ -28,24 +28,11 @@
  ****************************************************************************/
 
 #include "cpl_error.h"
-#include "cpl_quad_tree.h"
+#include "cpl_packed_rtree.h"
 
 typedef struct
 {
-    const double* padfX;
-    const double* padfY;
-} GDALGridXYArrays;
-
-typedef struct
-{
-    GDALGridXYArrays* psXYArrays;
-    int               i;
-} GDALGridPoint;
-
-typedef struct
-{
-    CPLQuadTree* hQuadTree;
-    double       dfInitialSearchRadius;
+    CPLPackedRTree* hRTree;
     const float *pafX;
     const float *pafY;
     const float *pafZ;
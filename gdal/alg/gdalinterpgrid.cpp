@@ -0,0 +1,1368 @@
+/******************************************************************************
+ *
+ * Project:  High Performance Image Reprojector
+ * Purpose:  Transformer interpolating a precomputed grid of an other
+ *           (expensive) transformer, such as the GCP, TPS or RPC ones.
+ * Author:   agent <agent at local>
+ *
+ ******************************************************************************
+ * Copyright (c) 2026, agent <agent at local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ****************************************************************************/
+
+#include "gdal_alg.h"
+#include "gdal_alg_priv.h"
+#include "cpl_conv.h"
+#include "cpl_minixml.h"
+#include "cpl_string.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+CPL_CVSID("$Id$");
+
+CPL_C_START
+CPLXMLNode *GDALSerializeInterpGridTransformer( void *pTransformArg );
+void *GDALDeserializeInterpGridTransformer( CPLXMLNode *psTree );
+CPL_C_END
+
+/* Interpolation mode of a grid cell */
+#define IGT_CELL_EXACT      0
+#define IGT_CELL_BILINEAR   1
+#define IGT_CELL_CUBIC      2
+
+typedef struct
+{
+    double      dfXOrigin;
+    double      dfYOrigin;
+    double      dfXStep;
+    double      dfYStep;
+    int         nXNodes;
+    int         nYNodes;
+
+    /* nXNodes * nYNodes (x,y) pairs, HUGE_VAL where the base failed */
+    double     *padfNodes;
+    /* (nXNodes-1) * (nYNodes-1) IGT_CELL_xxx values */
+    GByte      *pabyCellMode;
+} GDALInterpGrid;
+
+typedef struct
+{
+    GDALTransformerInfo sTI;
+
+    GDALTransformerFunc pfnBaseTransformer;
+    void               *pBaseCBData;
+    int                 bOwnSubtransformer;
+
+    int                 nXSize;
+    int                 nYSize;
+    double              dfStep;
+    int                 bCubic;
+    double              dfMaxError;
+
+    /* Source pixel/line to base output coordinates */
+    GDALInterpGrid      sForward;
+    /* Base output coordinates to source pixel/line */
+    GDALInterpGrid      sInverse;
+} GDALInterpGridTransformInfo;
+
+/************************************************************************/
+/*                       GDALInterpGridCubicWeights()                   */
+/*                                                                      */
+/*      Catmull-Rom weights of the nodes -1, 0, 1 and 2 for a           */
+/*      fractional position t in [0,1].                                 */
+/************************************************************************/
+
+static void GDALInterpGridCubicWeights( double t, double adfW[4] )
+{
+    adfW[0] = 0.5 * ((-t + 2.0) * t - 1.0) * t;
+    adfW[1] = 0.5 * ((3.0 * t - 5.0) * t * t + 2.0);
+    adfW[2] = 0.5 * ((-3.0 * t + 4.0) * t + 1.0) * t;
+    adfW[3] = 0.5 * (t - 1.0) * t * t;
+}
+
+/************************************************************************/
+/*                      GDALInterpGridInterpolate()                     */
+/************************************************************************/
+
+static void GDALInterpGridInterpolate( const GDALInterpGrid *psGrid,
+                                       int iX, int iY,
+                                       double dfFX, double dfFY,
+                                       int nMode,
+                                       double *pdfX, double *pdfY )
+{
+    const int nXNodes = psGrid->nXNodes;
+
+    if( nMode == IGT_CELL_CUBIC )
+    {
+        double adfWX[4], adfWY[4];
+        GDALInterpGridCubicWeights( dfFX, adfWX );
+        GDALInterpGridCubicWeights( dfFY, adfWY );
+
+        double dfX = 0.0, dfY = 0.0;
+        for( int j = 0; j < 4; j++ )
+        {
+            const double *padfRow = psGrid->padfNodes +
+                2 * ((size_t)(iY - 1 + j) * nXNodes + (iX - 1));
+            const double dfRowX = adfWX[0] * padfRow[0] + adfWX[1] * padfRow[2]
+                                + adfWX[2] * padfRow[4] + adfWX[3] * padfRow[6];
+            const double dfRowY = adfWX[0] * padfRow[1] + adfWX[1] * padfRow[3]
+                                + adfWX[2] * padfRow[5] + adfWX[3] * padfRow[7];
+            dfX += adfWY[j] * dfRowX;
+            dfY += adfWY[j] * dfRowY;
+        }
+        *pdfX = dfX;
+        *pdfY = dfY;
+    }
+    else
+    {
+        const double *padf00 = psGrid->padfNodes +
+                                    2 * ((size_t)iY * nXNodes + iX);
+        const double *padf01 = padf00 + 2 * nXNodes;
+
+        const double dfTopX = padf00[0] + dfFX * (padf00[2] - padf00[0]);
+        const double dfTopY = padf00[1] + dfFX * (padf00[3] - padf00[1]);
+        const double dfBotX = padf01[0] + dfFX * (padf01[2] - padf01[0]);
+        const double dfBotY = padf01[1] + dfFX * (padf01[3] - padf01[1]);
+
+        *pdfX = dfTopX + dfFY * (dfBotX - dfTopX);
+        *pdfY = dfTopY + dfFY * (dfBotY - dfTopY);
+    }
+}
+
+/************************************************************************/
+/*                         GDALInterpGridEval()                         */
+/*                                                                      */
+/*      Returns false if the point is outside of the grid or falls in   */
+/*      a cell that must be computed with the base transformer.         */
+/************************************************************************/
+
+static bool GDALInterpGridEval( const GDALInterpGrid *psGrid,
+                                double dfX, double dfY,
+                                double *pdfX, double *pdfY )
+{
+    if( psGrid->pabyCellMode == NULL )
+        return false;
+
+    const double dfGX = (dfX - psGrid->dfXOrigin) / psGrid->dfXStep;
+    const double dfGY = (dfY - psGrid->dfYOrigin) / psGrid->dfYStep;
+
+    /* Written so that NaN ends up in the fallback */
+    if( !(dfGX >= 0.0 && dfGX <= psGrid->nXNodes - 1 &&
+          dfGY >= 0.0 && dfGY <= psGrid->nYNodes - 1) )
+        return false;
+
+    int iX = static_cast<int>(dfGX);
+    int iY = static_cast<int>(dfGY);
+    if( iX == psGrid->nXNodes - 1 )
+        iX--;
+    if( iY == psGrid->nYNodes - 1 )
+        iY--;
+
+    const int nMode =
+        psGrid->pabyCellMode[(size_t)iY * (psGrid->nXNodes - 1) + iX];
+    if( nMode == IGT_CELL_EXACT )
+        return false;
+
+    GDALInterpGridInterpolate( psGrid, iX, iY, dfGX - iX, dfGY - iY,
+                               nMode, pdfX, pdfY );
+    return true;
+}
+
+/************************************************************************/
+/*                         GDALInterpGridFree()                         */
+/************************************************************************/
+
+static void GDALInterpGridFree( GDALInterpGrid *psGrid )
+{
+    CPLFree( psGrid->padfNodes );
+    CPLFree( psGrid->pabyCellMode );
+    psGrid->padfNodes = NULL;
+    psGrid->pabyCellMode = NULL;
+    psGrid->nXNodes = 0;
+    psGrid->nYNodes = 0;
+}
+
+/************************************************************************/
+/*                        GDALInterpGridAlloc()                         */
+/************************************************************************/
+
+static bool GDALInterpGridAlloc( GDALInterpGrid *psGrid,
+                                 int nXNodes, int nYNodes )
+{
+    psGrid->nXNodes = nXNodes;
+    psGrid->nYNodes = nYNodes;
+    psGrid->padfNodes = static_cast<double *>(
+        VSI_MALLOC3_VERBOSE( nXNodes, nYNodes, 2 * sizeof(double) ) );
+    psGrid->pabyCellMode = static_cast<GByte *>(
+        VSI_MALLOC2_VERBOSE( nXNodes - 1, nYNodes - 1 ) );
+    if( psGrid->padfNodes == NULL || psGrid->pabyCellMode == NULL )
+    {
+        GDALInterpGridFree( psGrid );
+        return false;
+    }
+    return true;
+}
+
+/************************************************************************/
+/*                       GDALInterpGridBaseRun()                        */
+/*                                                                      */
+/*      Run the base transformer on points given in grid coordinates,   */
+/*      and flag failed points with HUGE_VAL.  Points whose z would be  */
+/*      changed by the base transformer cannot be interpolated either,  */
+/*      since z is left untouched by the grid.                          */
+/************************************************************************/
+
+static void GDALInterpGridBaseRun( const GDALInterpGridTransformInfo *psInfo,
+                                   const GDALInterpGrid *psGrid,
+                                   int bDstToSrc,
+                                   int nCount,
+                                   const double *padfGX, const double *padfGY,
+                                   double *padfOut,
+                                   std::vector<double> &adfZ,
+                                   std::vector<int> &anSuccess )
+{
+    if( nCount == 0 )
+        return;
+
+    std::vector<double> adfX( nCount ), adfY( nCount );
+    adfZ.assign( nCount, 0.0 );
+    anSuccess.assign( nCount, FALSE );
+    for( int i = 0; i < nCount; i++ )
+    {
+        adfX[i] = psGrid->dfXOrigin + padfGX[i] * psGrid->dfXStep;
+        adfY[i] = psGrid->dfYOrigin + padfGY[i] * psGrid->dfYStep;
+    }
+
+    if( !psInfo->pfnBaseTransformer( psInfo->pBaseCBData, bDstToSrc, nCount,
+                                     &adfX[0], &adfY[0], &adfZ[0],
+                                     &anSuccess[0] ) )
+    {
+        anSuccess.assign( nCount, FALSE );
+    }
+
+    for( int i = 0; i < nCount; i++ )
+    {
+        if( anSuccess[i] && adfZ[i] == 0.0 &&
+            CPLIsFinite(adfX[i]) && CPLIsFinite(adfY[i]) )
+        {
+            padfOut[2*i] = adfX[i];
+            padfOut[2*i+1] = adfY[i];
+        }
+        else
+        {
+            padfOut[2*i] = HUGE_VAL;
+            padfOut[2*i+1] = HUGE_VAL;
+        }
+    }
+}
+
+/*
+ * Fractional positions, in a cell, of the points where the interpolation is
+ * checked against the base transformer.  All cells are checked at the middle
+ * of their edges and at their centre (the first 5 points).  Cells accepted
+ * for the cubic interpolation are further checked at the quarters of their
+ * edges and of their diagonals, since the spline may oscillate between the
+ * first points, which are symmetric.
+ */
+#define IGT_CHECK_POINTS        5
+#define IGT_CUBIC_CHECK_POINTS  17
+
+/* Fraction of MAX_ERROR accepted at the check points.  This is a heuristic */
+/* margin for the error between them, which is not bounded. */
+#define IGT_CHECK_ERROR_RATIO   0.75
+
+static const double adfCheckFX[IGT_CUBIC_CHECK_POINTS] =
+    { 0.5, 0.5, 0.0, 1.0, 0.5,
+      0.25, 0.75, 0.25, 0.75, 0.0, 0.0, 1.0, 1.0,
+      0.25, 0.75, 0.25, 0.75 };
+static const double adfCheckFY[IGT_CUBIC_CHECK_POINTS] =
+    { 0.0, 1.0, 0.5, 0.5, 0.5,
+      0.0, 0.0, 1.0, 1.0, 0.25, 0.75, 0.25, 0.75,
+      0.25, 0.25, 0.75, 0.75 };
+
+/************************************************************************/
+/*                        GDALInterpGridCellMode()                      */
+/*                                                                      */
+/*      Decide how a cell can be interpolated from the exact values     */
+/*      at the nCheck first check points.  The error of the forward     */
+/*      grid is expressed in source pixels through the local jacobian   */
+/*      of the cell.                                                    */
+/************************************************************************/
+
+static int GDALInterpGridCellMode( const GDALInterpGridTransformInfo *psInfo,
+                                   const GDALInterpGrid *psGrid,
+                                   bool bForward, int iX, int iY,
+                                   int nCheck,
+                                   const double * const *papadfCheck )
+{
+    const int nXNodes = psGrid->nXNodes;
+    const double *padf00 = psGrid->padfNodes + 2 * ((size_t)iY * nXNodes + iX);
+    const double *padf10 = padf00 + 2;
+    const double *padf01 = padf00 + 2 * nXNodes;
+    const double *padf11 = padf01 + 2;
+
+    if( padf00[0] == HUGE_VAL || padf10[0] == HUGE_VAL ||
+        padf01[0] == HUGE_VAL || padf11[0] == HUGE_VAL )
+        return IGT_CELL_EXACT;
+    for( int k = 0; k < nCheck; k++ )
+    {
+        if( papadfCheck[k][0] == HUGE_VAL )
+            return IGT_CELL_EXACT;
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Inverse of the jacobian (per grid unit) for the forward grid.   */
+/* -------------------------------------------------------------------- */
+    double adfInvJ[4] = { 1.0, 0.0, 0.0, 1.0 };
+    double dfXScale = 1.0, dfYScale = 1.0;
+    if( bForward )
+    {
+        const double dfA = 0.5 * (padf10[0] - padf00[0] + padf11[0] - padf01[0]);
+        const double dfB = 0.5 * (padf01[0] - padf00[0] + padf11[0] - padf10[0]);
+        const double dfC = 0.5 * (padf10[1] - padf00[1] + padf11[1] - padf01[1]);
+        const double dfD = 0.5 * (padf01[1] - padf00[1] + padf11[1] - padf10[1]);
+        const double dfDet = dfA * dfD - dfB * dfC;
+        if( dfDet == 0.0 || !CPLIsFinite(dfDet) )
+            return IGT_CELL_EXACT;
+        adfInvJ[0] = dfD / dfDet;
+        adfInvJ[1] = -dfB / dfDet;
+        adfInvJ[2] = -dfC / dfDet;
+        adfInvJ[3] = dfA / dfDet;
+        dfXScale = psGrid->dfXStep;
+        dfYScale = psGrid->dfYStep;
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Try the cubic interpolation first when requested and its 4x4    */
+/*      stencil is available, then the bilinear one.                    */
+/* -------------------------------------------------------------------- */
+    int nFirstMode = IGT_CELL_BILINEAR;
+    if( psInfo->bCubic && iX >= 1 && iX + 2 < nXNodes &&
+        iY >= 1 && iY + 2 < psGrid->nYNodes )
+    {
+        nFirstMode = IGT_CELL_CUBIC;
+        for( int j = -1; j <= 2 && nFirstMode == IGT_CELL_CUBIC; j++ )
+        {
+            for( int i = -1; i <= 2; i++ )
+            {
+                if( padf00[2 * (j * nXNodes + i)] == HUGE_VAL )
+                {
+                    nFirstMode = IGT_CELL_BILINEAR;
+                    break;
+                }
+            }
+        }
+    }
+
+    // The error at the check points is compared to a fraction of the maximum
+    // error, as a margin for the error between them.
+    const double dfMaxCheckError = IGT_CHECK_ERROR_RATIO * psInfo->dfMaxError;
+    const double dfMaxError2 = dfMaxCheckError * dfMaxCheckError;
+    for( int nMode = nFirstMode; nMode >= IGT_CELL_BILINEAR; nMode-- )
+    {
+        bool bOK = true;
+        for( int k = 0; k < nCheck && bOK; k++ )
+        {
+            double dfX, dfY;
+            GDALInterpGridInterpolate( psGrid, iX, iY,
+                                       adfCheckFX[k], adfCheckFY[k],
+                                       nMode, &dfX, &dfY );
+            const double dfErrX = dfX - papadfCheck[k][0];
+            const double dfErrY = dfY - papadfCheck[k][1];
+            const double dfPixErrX =
+                (adfInvJ[0] * dfErrX + adfInvJ[1] * dfErrY) * dfXScale;
+            const double dfPixErrY =
+                (adfInvJ[2] * dfErrX + adfInvJ[3] * dfErrY) * dfYScale;
+            bOK = dfPixErrX * dfPixErrX + dfPixErrY * dfPixErrY <= dfMaxError2;
+        }
+        if( bOK )
+            return nMode;
+    }
+
+    return IGT_CELL_EXACT;
+}
+
+/************************************************************************/
+/*                        GDALInterpGridCompute()                       */
+/*                                                                      */
+/*      Compute the nodes of an allocated grid, and the mode of its     */
+/*      cells.  This is done by rows of cells so that the check points  */
+/*      only need buffers of the width of the grid.                     */
+/************************************************************************/
+
+static void GDALInterpGridCompute( const GDALInterpGridTransformInfo *psInfo,
+                                   GDALInterpGrid *psGrid, int bDstToSrc )
+{
+    const int nXNodes = psGrid->nXNodes;
+    const int nYNodes = psGrid->nYNodes;
+    const int nXCells = nXNodes - 1;
+    std::vector<double> adfZ;
+    std::vector<int> anSuccess;
+
+/* -------------------------------------------------------------------- */
+/*      Nodes.                                                          */
+/* -------------------------------------------------------------------- */
+    std::vector<double> adfGX( 2 * nXNodes ), adfGY( 2 * nXNodes );
+    for( int iY = 0; iY < nYNodes; iY++ )
+    {
+        for( int iX = 0; iX < nXNodes; iX++ )
+        {
+            adfGX[iX] = iX;
+            adfGY[iX] = iY;
+        }
+        GDALInterpGridBaseRun( psInfo, psGrid, bDstToSrc, nXNodes,
+                               &adfGX[0], &adfGY[0],
+                               psGrid->padfNodes + 2 * (size_t)iY * nXNodes,
+                               adfZ, anSuccess );
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Check points: middle of horizontal edges (shared between two    */
+/*      rows of cells), middle of vertical edges and centres.           */
+/* -------------------------------------------------------------------- */
+    std::vector<double> adfTop( 2 * nXCells ), adfBottom( 2 * nXCells );
+    std::vector<double> adfLeftRight( 2 * nXNodes ), adfCentre( 2 * nXCells );
+    std::vector<int> anCubicCells;
+    std::vector<double> adfExtraGX, adfExtraGY, adfExtra;
+
+    for( int iX = 0; iX < nXCells; iX++ )
+    {
+        adfGX[iX] = iX + 0.5;
+        adfGY[iX] = 0.0;
+    }
+    GDALInterpGridBaseRun( psInfo, psGrid, bDstToSrc, nXCells,
+                           &adfGX[0], &adfGY[0], &adfTop[0],
+                           adfZ, anSuccess );
+
+    for( int iY = 0; iY < nYNodes - 1; iY++ )
+    {
+        for( int iX = 0; iX < nXCells; iX++ )
+        {
+            adfGX[iX] = iX + 0.5;
+            adfGY[iX] = iY + 1.0;
+        }
+        GDALInterpGridBaseRun( psInfo, psGrid, bDstToSrc, nXCells,
+                               &adfGX[0], &adfGY[0], &adfBottom[0],
+                               adfZ, anSuccess );
+
+        for( int iX = 0; iX < nXNodes; iX++ )
+        {
+            adfGX[iX] = iX;
+            adfGY[iX] = iY + 0.5;
+        }
+        GDALInterpGridBaseRun( psInfo, psGrid, bDstToSrc, nXNodes,
+                               &adfGX[0], &adfGY[0], &adfLeftRight[0],
+                               adfZ, anSuccess );
+
+        for( int iX = 0; iX < nXCells; iX++ )
+        {
+            adfGX[iX] = iX + 0.5;
+            adfGY[iX] = iY + 0.5;
+        }
+        GDALInterpGridBaseRun( psInfo, psGrid, bDstToSrc, nXCells,
+                               &adfGX[0], &adfGY[0], &adfCentre[0],
+                               adfZ, anSuccess );
+
+        GByte *pabyModeRow = psGrid->pabyCellMode + (size_t)iY * nXCells;
+        anCubicCells.resize( 0 );
+        for( int iX = 0; iX < nXCells; iX++ )
+        {
+            const double *apadfCheck[IGT_CHECK_POINTS] = {
+                &adfTop[2*iX], &adfBottom[2*iX],
+                &adfLeftRight[2*iX], &adfLeftRight[2*(iX+1)],
+                &adfCentre[2*iX] };
+            pabyModeRow[iX] = static_cast<GByte>(
+                GDALInterpGridCellMode( psInfo, psGrid, !bDstToSrc,
+                                        iX, iY, IGT_CHECK_POINTS,
+                                        apadfCheck ) );
+            if( pabyModeRow[iX] == IGT_CELL_CUBIC )
+                anCubicCells.push_back( iX );
+        }
+
+/* -------------------------------------------------------------------- */
+/*      Additional check points of the cells accepted for the cubic     */
+/*      interpolation, computed in one batch for the row.               */
+/* -------------------------------------------------------------------- */
+        if( anCubicCells.empty() )
+        {
+            adfTop.swap( adfBottom );
+            continue;
+        }
+
+        const int nExtra = IGT_CUBIC_CHECK_POINTS - IGT_CHECK_POINTS;
+        const int nExtraPoints = static_cast<int>(anCubicCells.size()) * nExtra;
+        adfExtraGX.resize( nExtraPoints );
+        adfExtraGY.resize( nExtraPoints );
+        adfExtra.resize( 2 * nExtraPoints );
+        for( size_t i = 0; i < anCubicCells.size(); i++ )
+        {
+            for( int k = 0; k < nExtra; k++ )
+            {
+                adfExtraGX[i * nExtra + k] =
+                    anCubicCells[i] + adfCheckFX[IGT_CHECK_POINTS + k];
+                adfExtraGY[i * nExtra + k] =
+                    iY + adfCheckFY[IGT_CHECK_POINTS + k];
+            }
+        }
+        GDALInterpGridBaseRun( psInfo, psGrid, bDstToSrc, nExtraPoints,
+                               &adfExtraGX[0], &adfExtraGY[0], &adfExtra[0],
+                               adfZ, anSuccess );
+
+        for( size_t i = 0; i < anCubicCells.size(); i++ )
+        {
+            const int iX = anCubicCells[i];
+            const double *apadfCheck[IGT_CUBIC_CHECK_POINTS] = {
+                &adfTop[2*iX], &adfBottom[2*iX],
+                &adfLeftRight[2*iX], &adfLeftRight[2*(iX+1)],
+                &adfCentre[2*iX] };
+            for( int k = 0; k < nExtra; k++ )
+                apadfCheck[IGT_CHECK_POINTS + k] =
+                    &adfExtra[2 * (i * nExtra + k)];
+            pabyModeRow[iX] = static_cast<GByte>(
+                GDALInterpGridCellMode( psInfo, psGrid, !bDstToSrc,
+                                        iX, iY, IGT_CUBIC_CHECK_POINTS,
+                                        apadfCheck ) );
+        }
+
+        adfTop.swap( adfBottom );
+    }
+}
+
+/************************************************************************/
+/*                      GDALInterpGridGetCellCount()                    */
+/*                                                                      */
+/*      Number of cells of the forward grid in each dimension.  The     */
+/*      inverse grid has two more, for its margin.                      */
+/************************************************************************/
+
+static void GDALInterpGridGetCellCount( const GDALInterpGridTransformInfo *psInfo,
+                                        int *pnXCells, int *pnYCells )
+{
+    *pnXCells = std::max(1,
+        static_cast<int>(ceil(psInfo->nXSize / psInfo->dfStep)));
+    *pnYCells = std::max(1,
+        static_cast<int>(ceil(psInfo->nYSize / psInfo->dfStep)));
+}
+
+/************************************************************************/
+/*                        GDALInterpGridSetup()                         */
+/*                                                                      */
+/*      Define and compute the forward grid over the source raster,     */
+/*      then the inverse grid over the extent of the forward one, with  */
+/*      a margin of one cell.                                           */
+/************************************************************************/
+
+static bool GDALInterpGridSetup( GDALInterpGridTransformInfo *psInfo )
+{
+    int nXCells = 0, nYCells = 0;
+    GDALInterpGridGetCellCount( psInfo, &nXCells, &nYCells );
+
+    GDALInterpGrid *psFwd = &psInfo->sForward;
+    psFwd->dfXOrigin = 0.0;
+    psFwd->dfYOrigin = 0.0;
+    psFwd->dfXStep = static_cast<double>(psInfo->nXSize) / nXCells;
+    psFwd->dfYStep = static_cast<double>(psInfo->nYSize) / nYCells;
+    if( !GDALInterpGridAlloc( psFwd, nXCells + 1, nYCells + 1 ) )
+        return false;
+    GDALInterpGridCompute( psInfo, psFwd, FALSE );
+
+    double dfMinX = HUGE_VAL, dfMinY = HUGE_VAL;
+    double dfMaxX = -HUGE_VAL, dfMaxY = -HUGE_VAL;
+    const size_t nNodes = (size_t)psFwd->nXNodes * psFwd->nYNodes;
+    for( size_t i = 0; i < nNodes; i++ )
+    {
+        const double dfX = psFwd->padfNodes[2*i];
+        const double dfY = psFwd->padfNodes[2*i+1];
+        if( dfX == HUGE_VAL )
+            continue;
+        dfMinX = std::min(dfMinX, dfX);
+        dfMaxX = std::max(dfMaxX, dfX);
+        dfMinY = std::min(dfMinY, dfY);
+        dfMaxY = std::max(dfMaxY, dfY);
+    }
+    if( !(dfMaxX > dfMinX && dfMaxY > dfMinY) )
+    {
+        CPLDebug( "GDAL", "Interpolation grid: no valid extent for the "
+                  "inverse grid. Inverse transformations will be exact." );
+        return true;
+    }
+
+    GDALInterpGrid *psInv = &psInfo->sInverse;
+    psInv->dfXStep = (dfMaxX - dfMinX) / nXCells;
+    psInv->dfYStep = (dfMaxY - dfMinY) / nYCells;
+    psInv->dfXOrigin = dfMinX - psInv->dfXStep;
+    psInv->dfYOrigin = dfMinY - psInv->dfYStep;
+    if( !GDALInterpGridAlloc( psInv, nXCells + 3, nYCells + 3 ) )
+        return false;
+    GDALInterpGridCompute( psInfo, psInv, TRUE );
+
+    return true;
+}
+
+/************************************************************************/
+/*                       GDALInterpGridSerialize()                      */
+/************************************************************************/
+
+static void GDALInterpGridSerialize( CPLXMLNode *psParent,
+                                     const char *pszName,
+                                     const GDALInterpGrid *psGrid )
+{
+    if( psGrid->pabyCellMode == NULL )
+        return;
+
+    CPLXMLNode *psTree = CPLCreateXMLNode( psParent, CXT_Element, pszName );
+
+    CPLCreateXMLElementAndValue( psTree, "Origin",
+        CPLString().Printf("%.18g,%.18g",
+                           psGrid->dfXOrigin, psGrid->dfYOrigin) );
+    CPLCreateXMLElementAndValue( psTree, "Spacing",
+        CPLString().Printf("%.18g,%.18g",
+                           psGrid->dfXStep, psGrid->dfYStep) );
+    CPLCreateXMLElementAndValue( psTree, "Size",
+        CPLString().Printf("%d,%d", psGrid->nXNodes, psGrid->nYNodes) );
+
+/* -------------------------------------------------------------------- */
+/*      Nodes as little endian doubles, and cell modes, in base64.      */
+/* -------------------------------------------------------------------- */
+    const size_t nValues = 2 * (size_t)psGrid->nXNodes * psGrid->nYNodes;
+    const size_t nCells = (size_t)(psGrid->nXNodes - 1) * (psGrid->nYNodes - 1);
+    if( nValues * sizeof(double) > INT_MAX )
+    {
+        CPLError( CE_Warning, CPLE_AppDefined,
+                  "Interpolation grid too large to be serialized." );
+        return;
+    }
+
+    double *padfLSB = static_cast<double *>(
+        VSI_MALLOC_VERBOSE( nValues * sizeof(double) ) );
+    if( padfLSB == NULL )
+        return;
+    memcpy( padfLSB, psGrid->padfNodes, nValues * sizeof(double) );
+#ifdef CPL_MSB
+    for( size_t i = 0; i < nValues; i++ )
+        CPL_LSBPTR64( padfLSB + i );
+#endif
+    char *pszNodes = CPLBase64Encode( static_cast<int>(nValues * sizeof(double)),
+                                      reinterpret_cast<GByte *>(padfLSB) );
+    CPLFree( padfLSB );
+    CPLCreateXMLElementAndValue( psTree, "Nodes", pszNodes );
+    CPLFree( pszNodes );
+
+    char *pszCells = CPLBase64Encode( static_cast<int>(nCells),
+                                      psGrid->pabyCellMode );
+    CPLCreateXMLElementAndValue( psTree, "Cells", pszCells );
+    CPLFree( pszCells );
+}
+
+/************************************************************************/
+/*                     GDALInterpGridCheckCellModes()                   */
+/*                                                                      */
+/*      Downgrade the cells of a loaded grid whose mode cannot be       */
+/*      honoured: cubic cells need their full 4x4 stencil of valid      */
+/*      nodes, and bilinear cells their 4 corners.                      */
+/************************************************************************/
+
+static void GDALInterpGridCheckCellModes( GDALInterpGrid *psGrid )
+{
+    const int nXNodes = psGrid->nXNodes;
+    const int nYNodes = psGrid->nYNodes;
+    const size_t nValues = 2 * (size_t)nXNodes * nYNodes;
+
+    for( size_t i = 0; i < nValues; i += 2 )
+    {
+        if( !CPLIsFinite(psGrid->padfNodes[i]) ||
+            !CPLIsFinite(psGrid->padfNodes[i+1]) )
+        {
+            psGrid->padfNodes[i] = HUGE_VAL;
+            psGrid->padfNodes[i+1] = HUGE_VAL;
+        }
+    }
+
+    for( int iY = 0; iY < nYNodes - 1; iY++ )
+    {
+        for( int iX = 0; iX < nXNodes - 1; iX++ )
+        {
+            GByte *pbyMode =
+                psGrid->pabyCellMode + (size_t)iY * (nXNodes - 1) + iX;
+            const double *padf00 =
+                psGrid->padfNodes + 2 * ((size_t)iY * nXNodes + iX);
+
+            if( *pbyMode == IGT_CELL_CUBIC )
+            {
+                bool bOK = iX >= 1 && iX + 2 < nXNodes &&
+                           iY >= 1 && iY + 2 < nYNodes;
+                for( int j = -1; j <= 2 && bOK; j++ )
+                {
+                    for( int i = -1; i <= 2 && bOK; i++ )
+                        bOK = padf00[2 * (j * nXNodes + i)] != HUGE_VAL;
+                }
+                if( !bOK )
+                    *pbyMode = IGT_CELL_BILINEAR;
+            }
+
+            if( *pbyMode == IGT_CELL_BILINEAR &&
+                (padf00[0] == HUGE_VAL || padf00[2] == HUGE_VAL ||
+                 padf00[2 * nXNodes] == HUGE_VAL ||
+                 padf00[2 * nXNodes + 2] == HUGE_VAL) )
+            {
+                *pbyMode = IGT_CELL_EXACT;
+            }
+        }
+    }
+}
+
+/************************************************************************/
+/*                      GDALInterpGridDeserialize()                     */
+/*                                                                      */
+/*      Returns false if the grid is missing, inconsistent, or does not */
+/*      have nXNodes x nYNodes nodes.                                   */
+/************************************************************************/
+
+static bool GDALInterpGridDeserialize( CPLXMLNode *psTree,
+                                       int nExpectedXNodes,
+                                       int nExpectedYNodes,
+                                       GDALInterpGrid *psGrid )
+{
+    if( psTree == NULL )
+        return false;
+
+    const char *pszNodes = CPLGetXMLValue( psTree, "Nodes", NULL );
+    const char *pszCells = CPLGetXMLValue( psTree, "Cells", NULL );
+    if( pszNodes == NULL || pszCells == NULL )
+        return false;
+
+    int nXNodes = 0, nYNodes = 0;
+    if( sscanf( CPLGetXMLValue( psTree, "Size", "" ), "%d,%d",
+                &nXNodes, &nYNodes ) != 2 ||
+        nXNodes != nExpectedXNodes || nYNodes != nExpectedYNodes ||
+        nXNodes < 2 || nYNodes < 2 ||
+        nXNodes > INT_MAX / 16 / nYNodes )
+        return false;
+    if( CPLsscanf( CPLGetXMLValue( psTree, "Origin", "" ), "%lf,%lf",
+                   &psGrid->dfXOrigin, &psGrid->dfYOrigin ) != 2 ||
+        CPLsscanf( CPLGetXMLValue( psTree, "Spacing", "" ), "%lf,%lf",
+                   &psGrid->dfXStep, &psGrid->dfYStep ) != 2 ||
+        !CPLIsFinite(psGrid->dfXOrigin) || !CPLIsFinite(psGrid->dfYOrigin) ||
+        !CPLIsFinite(psGrid->dfXStep) || !CPLIsFinite(psGrid->dfYStep) ||
+        psGrid->dfXStep == 0.0 || psGrid->dfYStep == 0.0 )
+        return false;
+
+    const size_t nValues = 2 * (size_t)nXNodes * nYNodes;
+    const size_t nCells = (size_t)(nXNodes - 1) * (nYNodes - 1);
+
+    GByte *pabyNodes = reinterpret_cast<GByte *>( CPLStrdup( pszNodes ) );
+    GByte *pabyCells = reinterpret_cast<GByte *>( CPLStrdup( pszCells ) );
+    bool bRet = false;
+    if( (size_t)CPLBase64DecodeInPlace( pabyNodes ) == nValues * sizeof(double) &&
+        (size_t)CPLBase64DecodeInPlace( pabyCells ) == nCells &&
+        GDALInterpGridAlloc( psGrid, nXNodes, nYNodes ) )
+    {
+        memcpy( psGrid->padfNodes, pabyNodes, nValues * sizeof(double) );
+#ifdef CPL_MSB
+        for( size_t i = 0; i < nValues; i++ )
+            CPL_LSBPTR64( psGrid->padfNodes + i );
+#endif
+        memcpy( psGrid->pabyCellMode, pabyCells, nCells );
+        bRet = true;
+        for( size_t i = 0; i < nCells && bRet; i++ )
+        {
+            if( psGrid->pabyCellMode[i] > IGT_CELL_CUBIC )
+                bRet = false;
+        }
+        if( bRet )
+            GDALInterpGridCheckCellModes( psGrid );
+        else
+            GDALInterpGridFree( psGrid );
+    }
+    CPLFree( pabyNodes );
+    CPLFree( pabyCells );
+
+    return bRet;
+}
+
+/************************************************************************/
+/*                         GDALInterpGridLoad()                         */
+/*                                                                      */
+/*      Load the grids of a serialized transformer.  Returns false,     */
+/*      with no grid loaded, if the forward grid is missing or does     */
+/*      not match the raster size and step of the transformer.  An      */
+/*      invalid inverse grid is just ignored.                           */
+/************************************************************************/
+
+static bool GDALInterpGridLoad( GDALInterpGridTransformInfo *psInfo,
+                                CPLXMLNode *psTree )
+{
+    int nXCells = 0, nYCells = 0;
+    GDALInterpGridGetCellCount( psInfo, &nXCells, &nYCells );
+
+    GDALInterpGrid *psFwd = &psInfo->sForward;
+    if( !GDALInterpGridDeserialize( CPLGetXMLNode( psTree, "ForwardGrid" ),
+                                    nXCells + 1, nYCells + 1, psFwd ) )
+    {
+        GDALInterpGridFree( psFwd );
+        return false;
+    }
+    const double dfXStep = static_cast<double>(psInfo->nXSize) / nXCells;
+    const double dfYStep = static_cast<double>(psInfo->nYSize) / nYCells;
+    if( psFwd->dfXOrigin != 0.0 || psFwd->dfYOrigin != 0.0 ||
+        fabs(psFwd->dfXStep - dfXStep) > 1e-10 * dfXStep ||
+        fabs(psFwd->dfYStep - dfYStep) > 1e-10 * dfYStep )
+    {
+        GDALInterpGridFree( psFwd );
+        return false;
+    }
+
+    if( !GDALInterpGridDeserialize( CPLGetXMLNode( psTree, "InverseGrid" ),
+                                    nXCells + 3, nYCells + 3,
+                                    &psInfo->sInverse ) )
+        GDALInterpGridFree( &psInfo->sInverse );
+
+    return true;
+}
+
+/************************************************************************/
+/*                       GDALInterpGridClone()                          */
+/************************************************************************/
+
+static bool GDALInterpGridClone( const GDALInterpGrid *psSrc,
+                                 GDALInterpGrid *psDst )
+{
+    *psDst = *psSrc;
+    psDst->padfNodes = NULL;
+    psDst->pabyCellMode = NULL;
+    if( psSrc->pabyCellMode == NULL )
+        return true;
+    if( !GDALInterpGridAlloc( psDst, psSrc->nXNodes, psSrc->nYNodes ) )
+        return false;
+    memcpy( psDst->padfNodes, psSrc->padfNodes,
+            2 * sizeof(double) * psSrc->nXNodes * psSrc->nYNodes );
+    memcpy( psDst->pabyCellMode, psSrc->pabyCellMode,
+            (size_t)(psSrc->nXNodes - 1) * (psSrc->nYNodes - 1) );
+    return true;
+}
+
+/************************************************************************/
+/*               GDALCreateInterpGridTransformerInternal()              */
+/*                                                                      */
+/*      Create the transformer, without computing its grids.            */
+/************************************************************************/
+
+static GDALInterpGridTransformInfo *
+GDALCreateInterpGridTransformerInternal( GDALTransformerFunc pfnBaseTransformer,
+                                         void *pBaseTransformArg,
+                                         int nXSize, int nYSize,
+                                         double dfStep, int bCubic,
+                                         double dfMaxError )
+{
+    GDALInterpGridTransformInfo *psInfo =
+        static_cast<GDALInterpGridTransformInfo *>(
+            CPLCalloc( sizeof(GDALInterpGridTransformInfo), 1 ) );
+
+    psInfo->pfnBaseTransformer = pfnBaseTransformer;
+    psInfo->pBaseCBData = pBaseTransformArg;
+    psInfo->bOwnSubtransformer = FALSE;
+    psInfo->nXSize = nXSize;
+    psInfo->nYSize = nYSize;
+    psInfo->dfStep = dfStep;
+    psInfo->bCubic = bCubic;
+    psInfo->dfMaxError = dfMaxError;
+
+    memcpy( psInfo->sTI.abySignature, GDAL_GTI2_SIGNATURE, strlen(GDAL_GTI2_SIGNATURE) );
+    psInfo->sTI.pszClassName = "GDALInterpGridTransformer";
+    psInfo->sTI.pfnTransform = GDALInterpGridTransform;
+    psInfo->sTI.pfnCleanup = GDALDestroyInterpGridTransformer;
+    psInfo->sTI.pfnSerialize = GDALSerializeInterpGridTransformer;
+    psInfo->sTI.pfnCreateSimilar = NULL;
+
+    return psInfo;
+}
+
+/************************************************************************/
+/*                 GDALCreateSimilarInterpGridTransformer()             */
+/************************************************************************/
+
+static void *GDALCreateSimilarInterpGridTransformer( void *hTransformArg,
+                                                     double dfRatioX,
+                                                     double dfRatioY )
+{
+    VALIDATE_POINTER1( hTransformArg, "GDALCreateSimilarInterpGridTransformer",
+                       NULL );
+
+    GDALInterpGridTransformInfo *psInfo =
+        static_cast<GDALInterpGridTransformInfo *>(hTransformArg);
+
+    void *pBaseCBData = GDALCreateSimilarTransformer( psInfo->pBaseCBData,
+                                                      dfRatioX, dfRatioY );
+    if( pBaseCBData == NULL )
+        return NULL;
+
+    GDALInterpGridTransformInfo *psClonedInfo =
+        GDALCreateInterpGridTransformerInternal(
+            psInfo->pfnBaseTransformer, pBaseCBData,
+            static_cast<int>(psInfo->nXSize / dfRatioX + 0.5),
+            static_cast<int>(psInfo->nYSize / dfRatioY + 0.5),
+            psInfo->dfStep, psInfo->bCubic, psInfo->dfMaxError );
+    psClonedInfo->sTI.pfnCreateSimilar = GDALCreateSimilarInterpGridTransformer;
+    psClonedInfo->bOwnSubtransformer = TRUE;
+
+/* -------------------------------------------------------------------- */
+/*      The grids of a plain clone can be copied, the others must be    */
+/*      recomputed.                                                     */
+/* -------------------------------------------------------------------- */
+    bool bOK;
+    if( dfRatioX == 1.0 && dfRatioY == 1.0 )
+    {
+        bOK = GDALInterpGridClone( &psInfo->sForward, &psClonedInfo->sForward ) &&
+              GDALInterpGridClone( &psInfo->sInverse, &psClonedInfo->sInverse );
+    }
+    else
+    {
+        bOK = GDALInterpGridSetup( psClonedInfo );
+    }
+    if( !bOK )
+    {
+        GDALDestroyInterpGridTransformer( psClonedInfo );
+        return NULL;
+    }
+
+    return psClonedInfo;
+}
+
+/************************************************************************/
+/*                GDALInterpGridTransformerMatchesTree()                */
+/*                                                                      */
+/*      Whether a serialized transformer was computed with the same     */
+/*      parameters and the same base transformer.                       */
+/************************************************************************/
+
+static bool
+GDALInterpGridTransformerMatchesTree( const GDALInterpGridTransformInfo *psInfo,
+                                      CPLXMLNode *psTree )
+{
+    if( psTree == NULL || psTree->eType != CXT_Element ||
+        !EQUAL(psTree->pszValue, "InterpGridTransformer") )
+        return false;
+
+    if( CPLAtof(CPLGetXMLValue( psTree, "Step", "0" )) != psInfo->dfStep ||
+        CPLAtof(CPLGetXMLValue( psTree, "MaxError", "0" )) != psInfo->dfMaxError ||
+        EQUAL(CPLGetXMLValue( psTree, "Interpolation", "BILINEAR" ), "CUBIC")
+            != CPL_TO_BOOL(psInfo->bCubic) ||
+        atoi(CPLGetXMLValue( psTree, "XSize", "0" )) != psInfo->nXSize ||
+        atoi(CPLGetXMLValue( psTree, "YSize", "0" )) != psInfo->nYSize )
+        return false;
+
+    CPLXMLNode *psContainer = CPLGetXMLNode( psTree, "BaseTransformer" );
+    if( psContainer == NULL || psContainer->psChild == NULL )
+        return false;
+
+    CPLXMLNode *psBase = GDALSerializeTransformer( psInfo->pfnBaseTransformer,
+                                                   psInfo->pBaseCBData );
+    if( psBase == NULL )
+        return false;
+
+    char *pszBase = CPLSerializeXMLTree( psBase );
+    char *pszStoredBase = CPLSerializeXMLTree( psContainer->psChild );
+    const bool bMatch = strcmp( pszBase, pszStoredBase ) == 0;
+    CPLFree( pszBase );
+    CPLFree( pszStoredBase );
+    CPLDestroyXMLNode( psBase );
+
+    return bMatch;
+}
+
+/************************************************************************/
+/*                  GDALSerializeInterpGridTransformer()                */
+/************************************************************************/
+
+CPLXMLNode *GDALSerializeInterpGridTransformer( void *pTransformArg )
+
+{
+    VALIDATE_POINTER1( pTransformArg, "GDALSerializeInterpGridTransformer",
+                       NULL );
+
+    GDALInterpGridTransformInfo *psInfo =
+        static_cast<GDALInterpGridTransformInfo *>(pTransformArg);
+
+    CPLXMLNode *psTree =
+        CPLCreateXMLNode( NULL, CXT_Element, "InterpGridTransformer" );
+
+/* -------------------------------------------------------------------- */
+/*      Attach parameters.                                              */
+/* -------------------------------------------------------------------- */
+    CPLCreateXMLElementAndValue( psTree, "Step",
+                                 CPLString().Printf("%.18g", psInfo->dfStep) );
+    CPLCreateXMLElementAndValue( psTree, "Interpolation",
+                                 psInfo->bCubic ? "CUBIC" : "BILINEAR" );
+    CPLCreateXMLElementAndValue( psTree, "MaxError",
+                                 CPLString().Printf("%.18g", psInfo->dfMaxError) );
+    CPLCreateXMLElementAndValue( psTree, "XSize",
+                                 CPLString().Printf("%d", psInfo->nXSize) );
+    CPLCreateXMLElementAndValue( psTree, "YSize",
+                                 CPLString().Printf("%d", psInfo->nYSize) );
+
+/* -------------------------------------------------------------------- */
+/*      Attach grids.                                                   */
+/* -------------------------------------------------------------------- */
+    GDALInterpGridSerialize( psTree, "ForwardGrid", &psInfo->sForward );
+    GDALInterpGridSerialize( psTree, "InverseGrid", &psInfo->sInverse );
+
+/* -------------------------------------------------------------------- */
+/*      Capture underlying transformer.                                 */
+/* -------------------------------------------------------------------- */
+    CPLXMLNode *psTransformerContainer =
+        CPLCreateXMLNode( psTree, CXT_Element, "BaseTransformer" );
+
+    CPLXMLNode *psTransformer =
+        GDALSerializeTransformer( psInfo->pfnBaseTransformer,
+                                  psInfo->pBaseCBData );
+    if( psTransformer != NULL )
+        CPLAddXMLChild( psTransformerContainer, psTransformer );
+
+    return psTree;
+}
+
+/************************************************************************/
+/*                 GDALDeserializeInterpGridTransformer()               */
+/************************************************************************/
+
+void *GDALDeserializeInterpGridTransformer( CPLXMLNode *psTree )
+
+{
+    GDALTransformerFunc pfnBaseTransform = NULL;
+    void *pBaseCBData = NULL;
+
+    CPLXMLNode *psContainer = CPLGetXMLNode( psTree, "BaseTransformer" );
+
+    if( psContainer != NULL && psContainer->psChild != NULL )
+    {
+        GDALDeserializeTransformer( psContainer->psChild,
+                                    &pfnBaseTransform,
+                                    &pBaseCBData );
+    }
+
+    if( pfnBaseTransform == NULL )
+    {
+        CPLError( CE_Failure, CPLE_AppDefined,
+                  "Cannot get base transform for interpolation grid transformer." );
+        return NULL;
+    }
+
+    const double dfStep = CPLAtof(CPLGetXMLValue( psTree, "Step", "32" ));
+    const int nXSize = atoi(CPLGetXMLValue( psTree, "XSize", "0" ));
+    const int nYSize = atoi(CPLGetXMLValue( psTree, "YSize", "0" ));
+    if( !(dfStep >= 1.0) || nXSize <= 0 || nYSize <= 0 )
+    {
+        CPLError( CE_Failure, CPLE_AppDefined,
+                  "Invalid Step, XSize or YSize in InterpGridTransformer." );
+        GDALDestroyTransformer( pBaseCBData );
+        return NULL;
+    }
+
+    GDALInterpGridTransformInfo *psInfo =
+        GDALCreateInterpGridTransformerInternal(
+            pfnBaseTransform, pBaseCBData, nXSize, nYSize, dfStep,
+            EQUAL(CPLGetXMLValue( psTree, "Interpolation", "BILINEAR" ), "CUBIC"),
+            CPLAtof(CPLGetXMLValue( psTree, "MaxError", "0.125" )) );
+    psInfo->sTI.pfnCreateSimilar = GDALCreateSimilarInterpGridTransformer;
+    psInfo->bOwnSubtransformer = TRUE;
+
+/* -------------------------------------------------------------------- */
+/*      Recompute the grids if they are not embedded.                   */
+/* -------------------------------------------------------------------- */
+    if( !GDALInterpGridLoad( psInfo, psTree ) &&
+        !GDALInterpGridSetup( psInfo ) )
+    {
+        GDALDestroyInterpGridTransformer( psInfo );
+        return NULL;
+    }
+
+    return psInfo;
+}
+
+/************************************************************************/
+/*                   GDALCreateInterpGridTransformer()                  */
+/************************************************************************/
+
+/**
+ * Create a transformer interpolating a precomputed grid.
+ *
+ * This function creates a transformer that approximates another transformer,
+ * mapping the pixel/line coordinates of a raster of nXSize x nYSize pixels to
+ * some other coordinate space (typically the GCP, TPS, RPC or geolocation
+ * array transformers, whose evaluation is expensive).
+ *
+ * At creation, the base transformer is evaluated on the nodes of a regular
+ * grid over the raster (forward grid), and on the nodes of a grid over the
+ * extent of its result (inverse grid).  Each cell of the grids is also
+ * checked at its centre and at the middle of its edges, and, for the cubic
+ * interpolation, at the quarters of its edges and diagonals: cells where the
+ * interpolation differs from the base transformer by more than 3/4 of
+ * MAX_ERROR source pixels at one of these points, or where the base
+ * transformer failed, are flagged so that the points falling in them are
+ * transformed with the base transformer.  Points outside of the grids, or
+ * with a non-zero z, are also transformed with the base transformer.
+ *
+ * MAX_ERROR is therefore a target checked at sample points, and not a
+ * guarantee: the remaining 1/4 is a margin for the error between them,
+ * which usually covers it, but the error may slightly exceed MAX_ERROR at a
+ * few points of strongly distorted transformations, in particular with the
+ * cubic interpolation.
+ *
+ * Supported options:
+ * <ul>
+ * <li> STEP: spacing of the grid nodes, in source pixels.  Defaults to 32.
+ * <li> INTERPOLATION: BILINEAR (default) or CUBIC (Catmull-Rom spline, in
+ * cells where the 4x4 nodes around are valid).
+ * <li> MAX_ERROR: error targeted for the interpolation, in source pixels,
+ * checked at the sample points of each cell as explained above.  Defaults
+ * to 0.125.
+ * <li> GRID_FILE: file from which the transformer is read if it has been
+ * computed with the same base transformer and options, and to which it is
+ * written otherwise.  This allows repeated processings of the same scene to
+ * skip the computation of the grid.
+ * </ul>
+ *
+ * @param pfnBaseTransformer the transformer that should be interpolated.
+ * @param pBaseTransformArg the callback argument for the base transformer.
+ * @param nXSize width of the raster whose pixel/line coordinates are the
+ * input of the forward transformation.
+ * @param nYSize height of that raster.
+ * @param papszOptions NULL-terminated list of options, or NULL.
+ *
+ * @return callback pointer suitable for use with GDALInterpGridTransform(),
+ * to be deallocated with GDALDestroyInterpGridTransformer(), or NULL on
+ * failure.
+ *
+ * @since GDAL 2.2
+ */
+
+void *GDALCreateInterpGridTransformer( GDALTransformerFunc pfnBaseTransformer,
+                                       void *pBaseTransformArg,
+                                       int nXSize, int nYSize,
+                                       char **papszOptions )
+
+{
+    const double dfStep =
+        CPLAtof(CSLFetchNameValueDef( papszOptions, "STEP", "32" ));
+    const char *pszInterpolation =
+        CSLFetchNameValueDef( papszOptions, "INTERPOLATION", "BILINEAR" );
+    const double dfMaxError =
+        CPLAtof(CSLFetchNameValueDef( papszOptions, "MAX_ERROR", "0.125" ));
+    const char *pszGridFile = CSLFetchNameValue( papszOptions, "GRID_FILE" );
+
+    if( !(dfStep >= 1.0) )
+    {
+        CPLError( CE_Failure, CPLE_IllegalArg,
+                  "Invalid value for STEP: %s",
+                  CSLFetchNameValue( papszOptions, "STEP" ) );
+        return NULL;
+    }
+    if( !EQUAL(pszInterpolation, "BILINEAR") && !EQUAL(pszInterpolation, "CUBIC") )
+    {
+        CPLError( CE_Failure, CPLE_IllegalArg,
+                  "Unsupported value for INTERPOLATION: %s", pszInterpolation );
+        return NULL;
+    }
+    if( nXSize <= 0 || nYSize <= 0 )
+    {
+        CPLError( CE_Failure, CPLE_IllegalArg,
+                  "Invalid raster size for interpolation grid transformer." );
+        return NULL;
+    }
+
+    GDALInterpGridTransformInfo *psInfo =
+        GDALCreateInterpGridTransformerInternal( pfnBaseTransformer,
+                                                 pBaseTransformArg,
+                                                 nXSize, nYSize, dfStep,
+                                                 EQUAL(pszInterpolation, "CUBIC"),
+                                                 dfMaxError );
+    psInfo->sTI.pfnCreateSimilar = GDALCreateSimilarInterpGridTransformer;
+
+/* -------------------------------------------------------------------- */
+/*      Reuse the grids of a previous run if possible.                  */
+/* -------------------------------------------------------------------- */
+    if( pszGridFile != NULL )
+    {
+        VSIStatBufL sStat;
+        CPLXMLNode *psTree = NULL;
+        if( VSIStatL( pszGridFile, &sStat ) == 0 )
+        {
+            CPLPushErrorHandler( CPLQuietErrorHandler );
+            psTree = CPLParseXMLFile( pszGridFile );
+            CPLPopErrorHandler();
+        }
+
+        bool bLoaded = false;
+        if( GDALInterpGridTransformerMatchesTree( psInfo, psTree ) )
+            bLoaded = GDALInterpGridLoad( psInfo, psTree );
+        if( psTree != NULL )
+            CPLDestroyXMLNode( psTree );
+
+        if( bLoaded )
+        {
+            CPLDebug( "GDAL", "Interpolation grid read from %s", pszGridFile );
+            return psInfo;
+        }
+    }
+
+    if( !GDALInterpGridSetup( psInfo ) )
+    {
+        GDALDestroyInterpGridTransformer( psInfo );
+        return NULL;
+    }
+
+    if( pszGridFile != NULL )
+    {
+        CPLXMLNode *psTree = GDALSerializeInterpGridTransformer( psInfo );
+        if( !CPLSerializeXMLTreeToFile( psTree, pszGridFile ) )
+        {
+            CPLError( CE_Warning, CPLE_FileIO,
+                      "Cannot write interpolation grid to %s", pszGridFile );
+        }
+        CPLDestroyXMLNode( psTree );
+    }
+
+    return psInfo;
+}
+
+/************************************************************************/
+/*            GDALInterpGridTransformerOwnsSubtransformer()             */
+/************************************************************************/
+
+void GDALInterpGridTransformerOwnsSubtransformer( void *pCBData, int bOwnFlag )
+
+{
+    GDALInterpGridTransformInfo *psInfo =
+        static_cast<GDALInterpGridTransformInfo *>(pCBData);
+
+    psInfo->bOwnSubtransformer = bOwnFlag;
+}
+
+/************************************************************************/
+/*                  GDALDestroyInterpGridTransformer()                  */
+/************************************************************************/
+
+/**
+ * Cleanup interpolation grid transformer.
+ *
+ * Deallocates the resources allocated by GDALCreateInterpGridTransformer().
+ *
+ * @param pTransformArg callback data originally returned by
+ * GDALCreateInterpGridTransformer().
+ */
+
+void GDALDestroyInterpGridTransformer( void *pTransformArg )
+
+{
+    if( pTransformArg == NULL )
+        return;
+
+    GDALInterpGridTransformInfo *psInfo =
+        static_cast<GDALInterpGridTransformInfo *>(pTransformArg);
+
+    if( psInfo->bOwnSubtransformer )
+        GDALDestroyTransformer( psInfo->pBaseCBData );
+
+    GDALInterpGridFree( &psInfo->sForward );
+    GDALInterpGridFree( &psInfo->sInverse );
+
+    CPLFree( psInfo );
+}
+
+/************************************************************************/
+/*                      GDALInterpGridTransform()                       */
+/************************************************************************/
+
+/**
+ * Perform interpolation grid transformation.
+ *
+ * Points that cannot be interpolated within the error bound of the grid are
+ * transformed with the base transformer, in one batch.  This function
+ * matches the GDALTransformerFunc signature.
+ */
+
+int GDALInterpGridTransform( void *pTransformArg, int bDstToSrc,
+                             int nPointCount,
+                             double *x, double *y, double *z,
+                             int *panSuccess )
+
+{
+    GDALInterpGridTransformInfo *psInfo =
+        static_cast<GDALInterpGridTransformInfo *>(pTransformArg);
+    const GDALInterpGrid *psGrid =
+        bDstToSrc ? &psInfo->sInverse : &psInfo->sForward;
+
+    std::vector<int> anFallback;
+    for( int i = 0; i < nPointCount; i++ )
+    {
+        double dfX, dfY;
+        if( (z != NULL && z[i] != 0.0) ||
+            !GDALInterpGridEval( psGrid, x[i], y[i], &dfX, &dfY ) )
+        {
+            anFallback.push_back( i );
+            continue;
+        }
+        x[i] = dfX;
+        y[i] = dfY;
+        panSuccess[i] = TRUE;
+    }
+
+    if( anFallback.empty() )
+        return TRUE;
+
+    if( static_cast<int>(anFallback.size()) == nPointCount )
+        return psInfo->pfnBaseTransformer( psInfo->pBaseCBData, bDstToSrc,
+                                           nPointCount, x, y, z, panSuccess );
+
+/* -------------------------------------------------------------------- */
+/*      Transform the remaining points with the base transformer.       */
+/* -------------------------------------------------------------------- */
+    const int nFallback = static_cast<int>(anFallback.size());
+    std::vector<double> adfX( nFallback ), adfY( nFallback ), adfZ( nFallback );
+    std::vector<int> anSuccess( nFallback );
+    for( int j = 0; j < nFallback; j++ )
+    {
+        const int i = anFallback[j];
+        adfX[j] = x[i];
+        adfY[j] = y[i];
+        adfZ[j] = z != NULL ? z[i] : 0.0;
+    }
+
+    const int bRet =
+        psInfo->pfnBaseTransformer( psInfo->pBaseCBData, bDstToSrc, nFallback,
+                                    &adfX[0], &adfY[0], &adfZ[0],
+                                    &anSuccess[0] );
+
+    for( int j = 0; j < nFallback; j++ )
+    {
+        const int i = anFallback[j];
+        x[i] = adfX[j];
+        y[i] = adfY[j];
+        if( z != NULL )
+            z[i] = adfZ[j];
+        panSuccess[i] = bRet ? anSuccess[j] : FALSE;
+    }
+
+    return bRet;
+}
@@ -29,8 +29,11 @@
  ****************************************************************************/
 
 #include "gdal_alg.h"
+#include "gdal_alg_priv.h"
 #include "cpl_conv.h"
 #include "cpl_string.h"
+#include "cpl_worker_thread_pool.h"
+#include <vector>
 
 CPL_CVSID("$Id$");
 
@@ -40,6 +43,27 @@ ProcessProximityLine( GInt32 *panSrcScanline, int *panNearX, int *panNearY,
                       float *pafProximity, double *pdfSrcNoDataValue,
                       int nTargetValues, int *panTargetValues );
 
+typedef struct
+{
+    int     nXSize;
+    double  dfMaxDist;
+    double  dfDistMult;
+    double *pdfSrcNoData;
+    float   fNoDataValue;
+    int     bFixedBufVal;
+    double  dfFixedBufVal;
+    int     nTargetValues;
+    int    *panTargetValues;
+} GDALProximityParams;
+
+static CPLErr
+ComputeExactProximity( GDALRasterBandH hSrcBand,
+                       GDALRasterBandH hWorkProximityBand,
+                       GDALRasterBandH hProximityBand,
+                       const GDALProximityParams *psParams,
+                       char **papszOptions,
+                       GDALProgressFunc pfnProgress, void *pProgressArg );
+
 /************************************************************************/
 /*                        GDALComputeProximity()                        */
 /************************************************************************/
@@ -96,6 +120,19 @@ the proximity output.
 
 If this option is set, all pixels within the MAXDIST threadhold are
 set to this fixed value instead of to a proximity distance.
+
+  EXACT=YES/[NO]
+
+(GDAL >= 2.2) If this option is set, exact euclidean distances are computed
+with a separable distance transform (one pass along the columns, then the
+lower envelope of parabolas along each line), instead of propagating the
+nearest target of neighbouring pixels, which can slightly overestimate some
+distances.
+
+  NUM_THREADS=n/ALL_CPUS
+
+(GDAL >= 2.2) Number of threads used for the line pass of the EXACT mode.
+Defaults to the GDAL_NUM_THREADS configuration option, or 1.
 */
 
 
@@ -257,9 +294,16 @@ GDALComputeProximity( GDALRasterBandH hSrcBand,
     int iLine;
     CPLErr eErr = CE_None;
 
+    const bool bExact =
+        CPLFetchBool( const_cast<const char **>(papszOptions), "EXACT", false );
+
+    // The exact mode keeps the vertical distances to the nearest target,
+    // which need a type covering the raster height.
     if( eProxType == GDT_Byte
         || eProxType == GDT_UInt16
-        || eProxType == GDT_UInt32 )
+        || eProxType == GDT_UInt32
+        || (bExact && eProxType != GDT_Float32 && eProxType != GDT_Float64
+            && eProxType != GDT_Int32) )
     {
         GDALDriverH hDriver = GDALGetDriverByName("GTiff");
         if (hDriver == NULL)
@@ -281,6 +325,25 @@ GDALComputeProximity( GDALRasterBandH hSrcBand,
         hWorkProximityBand = GDALGetRasterBand( hWorkProximityDS, 1 );
     }
 
+    if( bExact )
+    {
+        GDALProximityParams sParams;
+        sParams.nXSize = nXSize;
+        sParams.dfMaxDist = dfMaxDist;
+        sParams.dfDistMult = dfDistMult;
+        sParams.pdfSrcNoData = pdfSrcNoData;
+        sParams.fNoDataValue = fNoDataValue;
+        sParams.bFixedBufVal = bFixedBufVal;
+        sParams.dfFixedBufVal = dfFixedBufVal;
+        sParams.nTargetValues = nTargetValues;
+        sParams.panTargetValues = panTargetValues;
+
+        eErr = ComputeExactProximity( hSrcBand, hWorkProximityBand,
+                                      hProximityBand, &sParams, papszOptions,
+                                      pfnProgress, pProgressArg );
+        goto end;
+    }
+
 /* -------------------------------------------------------------------- */
 /*      Allocate buffer for two scanlines of distances as floats        */
 /*      (the current and last line).                                    */
@@ -558,3 +621,359 @@ ProcessProximityLine( GInt32 *panSrcScanline, int *panNearX, int *panNearY,
 
     return CE_None;
 }
+
+/************************************************************************/
+/*                            IsTargetValue()                           */
+/************************************************************************/
+
+static bool IsTargetValue( GInt32 nValue, const GDALProximityParams *psParams )
+{
+    if( psParams->nTargetValues == 0 )
+        return nValue != 0;
+
+    for( int i = 0; i < psParams->nTargetValues; i++ )
+    {
+        if( nValue == psParams->panTargetValues[i] )
+            return true;
+    }
+    return false;
+}
+
+/************************************************************************/
+/*                       GDALDistanceTransform1D()                      */
+/************************************************************************/
+
+/**
+ * Evaluate the lower envelope of the parabolas (q - p)^2 + padfF[p] rooted
+ * at each position p where padfF[p] is not HUGE_VAL (Felzenszwalb &
+ * Huttenlocher): padfD[q] is the minimum over p of (q - p)^2 + padfF[p],
+ * or HUGE_VAL if there is no such position.  Applied to the squared
+ * distances along the columns of a raster, this gives the exact squared
+ * euclidean distances along its lines.
+ *
+ * padfD must not overlap padfF.  panV (nSize values) and padfZ (nSize + 1
+ * values) are working buffers.
+ */
+void GDALDistanceTransform1D( const double *padfF, int nSize, double *padfD,
+                              int *panV, double *padfZ )
+{
+/* -------------------------------------------------------------------- */
+/*      Build the lower envelope.                                       */
+/* -------------------------------------------------------------------- */
+    int k = -1;
+    for( int q = 0; q < nSize; q++ )
+    {
+        if( padfF[q] == HUGE_VAL )
+            continue;
+
+        const double dfFQ = padfF[q] + static_cast<double>(q) * q;
+        double dfS = 0.0;
+        while( k >= 0 )
+        {
+            const int v = panV[k];
+            const double dfFV = padfF[v] + static_cast<double>(v) * v;
+            dfS = (dfFQ - dfFV) / (2.0 * (q - v));
+            if( dfS > padfZ[k] )
+                break;
+            k--;
+        }
+        k++;
+        panV[k] = q;
+        padfZ[k] = (k == 0) ? -HUGE_VAL : dfS;
+    }
+    const int nSites = k + 1;
+    if( nSites == 0 )
+    {
+        for( int q = 0; q < nSize; q++ )
+            padfD[q] = HUGE_VAL;
+        return;
+    }
+    padfZ[nSites] = HUGE_VAL;
+
+/* -------------------------------------------------------------------- */
+/*      Evaluate it.                                                    */
+/* -------------------------------------------------------------------- */
+    k = 0;
+    for( int q = 0; q < nSize; q++ )
+    {
+        while( padfZ[k+1] < q )
+            k++;
+        const int v = panV[k];
+        padfD[q] = static_cast<double>(q - v) * (q - v) + padfF[v];
+    }
+}
+
+/************************************************************************/
+/*                        ExactProximityLinesJob                        */
+/************************************************************************/
+
+typedef struct
+{
+    const GDALProximityParams *psParams;
+    const GInt32 *panSrc;        // source values of the lines
+    const float  *pafColDist;    // vertical distance to the nearest target
+                                 // of the column, or -1
+    float        *pafProximity;  // output
+    int           nLines;
+} ExactProximityLinesJob;
+
+/************************************************************************/
+/*                     ExactProximityLinesJobFunc()                     */
+/*                                                                      */
+/*      Turn the vertical distances of each line into euclidean         */
+/*      distances.                                                      */
+/************************************************************************/
+
+static void ExactProximityLinesJobFunc( void *pData )
+{
+    ExactProximityLinesJob *psJob = static_cast<ExactProximityLinesJob *>(pData);
+    const GDALProximityParams *psParams = psJob->psParams;
+    const int nXSize = psParams->nXSize;
+    const double dfMaxDistSq = psParams->dfMaxDist * psParams->dfMaxDist;
+
+    std::vector<double> adfColDistSq( nXSize );
+    std::vector<double> adfDistSq( nXSize );
+    std::vector<int> anV( nXSize );
+    std::vector<double> adfZ( nXSize + 1 );
+
+    for( int iLine = 0; iLine < psJob->nLines; iLine++ )
+    {
+        const size_t nOffset = static_cast<size_t>(iLine) * nXSize;
+        const GInt32 *panSrc = psJob->panSrc + nOffset;
+        const float *pafColDist = psJob->pafColDist + nOffset;
+        float *pafProximity = psJob->pafProximity + nOffset;
+
+        for( int iX = 0; iX < nXSize; iX++ )
+        {
+            adfColDistSq[iX] = pafColDist[iX] < 0 ? HUGE_VAL :
+                static_cast<double>(pafColDist[iX]) * pafColDist[iX];
+        }
+        GDALDistanceTransform1D( &adfColDistSq[0], nXSize, &adfDistSq[0],
+                                 &anV[0], &adfZ[0] );
+
+        for( int iX = 0; iX < nXSize; iX++ )
+        {
+            if( IsTargetValue( panSrc[iX], psParams ) )
+            {
+                pafProximity[iX] = 0.0f;
+                continue;
+            }
+            const double dfDistSq = adfDistSq[iX];
+            if( dfDistSq == HUGE_VAL
+                || (psParams->pdfSrcNoData != NULL
+                    && panSrc[iX] == *(psParams->pdfSrcNoData)) )
+            {
+                pafProximity[iX] = psParams->fNoDataValue;
+                continue;
+            }
+
+            if( dfDistSq > dfMaxDistSq )
+                pafProximity[iX] = psParams->fNoDataValue;
+            else if( psParams->bFixedBufVal )
+                pafProximity[iX] = static_cast<float>(psParams->dfFixedBufVal);
+            else
+                pafProximity[iX] = static_cast<float>(
+                    sqrt(dfDistSq) * psParams->dfDistMult);
+        }
+    }
+}
+
+/************************************************************************/
+/*                       ComputeExactProximity()                        */
+/*                                                                      */
+/*      A first pass from top to bottom stores the vertical distance    */
+/*      to the nearest target above in the work band.  A second pass    */
+/*      from bottom to top combines it with the nearest target below,   */
+/*      and computes the distances line by line, in parallel.  Only     */
+/*      a batch of lines is kept in memory.                             */
+/************************************************************************/
+
+static CPLErr
+ComputeExactProximity( GDALRasterBandH hSrcBand,
+                       GDALRasterBandH hWorkProximityBand,
+                       GDALRasterBandH hProximityBand,
+                       const GDALProximityParams *psParams,
+                       char **papszOptions,
+                       GDALProgressFunc pfnProgress, void *pProgressArg )
+
+{
+    const int nXSize = psParams->nXSize;
+    const int nYSize = GDALGetRasterBandYSize( hSrcBand );
+
+/* -------------------------------------------------------------------- */
+/*      Set up the thread pool.                                         */
+/* -------------------------------------------------------------------- */
+    int nThreads = CPLGetNumThreads( papszOptions, "1" );
+
+    CPLWorkerThreadPool *poThreadPool = NULL;
+    if( nThreads > 1 )
+    {
+        poThreadPool = new CPLWorkerThreadPool();
+        if( !poThreadPool->Setup( nThreads, NULL, NULL ) )
+        {
+            delete poThreadPool;
+            poThreadPool = NULL;
+        }
+    }
+    if( poThreadPool == NULL )
+        nThreads = 1;
+
+/* -------------------------------------------------------------------- */
+/*      Allocate the batch buffers.                                     */
+/* -------------------------------------------------------------------- */
+    const int nBatchLines = MAX(1, MIN(nYSize, 16 * nThreads));
+    GInt32 *panSrc = static_cast<GInt32 *>(
+        VSI_MALLOC3_VERBOSE(sizeof(GInt32), nXSize, nBatchLines));
+    float *pafColDist = static_cast<float *>(
+        VSI_MALLOC3_VERBOSE(sizeof(float), nXSize, nBatchLines));
+    float *pafProximity = static_cast<float *>(
+        VSI_MALLOC3_VERBOSE(sizeof(float), nXSize, nBatchLines));
+    int *panColDist = static_cast<int *>(
+        VSI_MALLOC2_VERBOSE(sizeof(int), nXSize));
+    CPLErr eErr = CE_None;
+
+    if( panSrc == NULL || pafColDist == NULL || pafProximity == NULL
+        || panColDist == NULL )
+        eErr = CE_Failure;
+
+/* -------------------------------------------------------------------- */
+/*      Top to bottom: distance to the nearest target above.            */
+/* -------------------------------------------------------------------- */
+    int iX;
+    if( eErr == CE_None )
+    {
+        for( iX = 0; iX < nXSize; iX++ )
+            panColDist[iX] = -1;
+    }
+
+    for( int iBatch = 0; eErr == CE_None && iBatch < nYSize;
+         iBatch += nBatchLines )
+    {
+        const int nLines = MIN(nBatchLines, nYSize - iBatch);
+
+        eErr = GDALRasterIO( hSrcBand, GF_Read, 0, iBatch, nXSize, nLines,
+                             panSrc, nXSize, nLines, GDT_Int32, 0, 0 );
+        if( eErr != CE_None )
+            break;
+
+        for( int iLine = 0; iLine < nLines; iLine++ )
+        {
+            const size_t nOffset = static_cast<size_t>(iLine) * nXSize;
+            for( iX = 0; iX < nXSize; iX++ )
+            {
+                if( IsTargetValue( panSrc[nOffset + iX], psParams ) )
+                    panColDist[iX] = 0;
+                else if( panColDist[iX] >= 0 )
+                    panColDist[iX]++;
+                pafColDist[nOffset + iX] = static_cast<float>(panColDist[iX]);
+            }
+        }
+
+        eErr = GDALRasterIO( hWorkProximityBand, GF_Write, 0, iBatch,
+                             nXSize, nLines, pafColDist, nXSize, nLines,
+                             GDT_Float32, 0, 0 );
+
+        if( eErr == CE_None &&
+            !pfnProgress( 0.5 * (iBatch + nLines) / (double) nYSize,
+                          "", pProgressArg ) )
+        {
+            CPLError( CE_Failure, CPLE_UserInterrupt, "User terminated" );
+            eErr = CE_Failure;
+        }
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Bottom to top: combine with the nearest target below, and       */
+/*      compute the distances along the lines.                          */
+/* -------------------------------------------------------------------- */
+    if( eErr == CE_None )
+    {
+        for( iX = 0; iX < nXSize; iX++ )
+            panColDist[iX] = -1;
+    }
+
+    for( int iBatchEnd = nYSize; eErr == CE_None && iBatchEnd > 0;
+         iBatchEnd -= nBatchLines )
+    {
+        const int nLines = MIN(nBatchLines, iBatchEnd);
+        const int iBatch = iBatchEnd - nLines;
+
+        eErr = GDALRasterIO( hSrcBand, GF_Read, 0, iBatch, nXSize, nLines,
+                             panSrc, nXSize, nLines, GDT_Int32, 0, 0 );
+        if( eErr == CE_None )
+            eErr = GDALRasterIO( hWorkProximityBand, GF_Read, 0, iBatch,
+                                 nXSize, nLines, pafColDist, nXSize, nLines,
+                                 GDT_Float32, 0, 0 );
+        if( eErr != CE_None )
+            break;
+
+        for( int iLine = nLines - 1; iLine >= 0; iLine-- )
+        {
+            const size_t nOffset = static_cast<size_t>(iLine) * nXSize;
+            for( iX = 0; iX < nXSize; iX++ )
+            {
+                if( IsTargetValue( panSrc[nOffset + iX], psParams ) )
+                    panColDist[iX] = 0;
+                else if( panColDist[iX] >= 0 )
+                    panColDist[iX]++;
+
+                float &fColDist = pafColDist[nOffset + iX];
+                if( panColDist[iX] >= 0 &&
+                    (fColDist < 0 || panColDist[iX] < fColDist) )
+                    fColDist = static_cast<float>(panColDist[iX]);
+            }
+        }
+
+        // One job per thread, each with a range of lines.
+        const int nJobs = MIN(nThreads, nLines);
+        std::vector<ExactProximityLinesJob> asJobs( nJobs );
+        std::vector<void *> apJobs;
+        for( int iJob = 0; iJob < nJobs; iJob++ )
+        {
+            const int iStart = static_cast<int>(
+                static_cast<GIntBig>(nLines) * iJob / nJobs);
+            const int iEnd = static_cast<int>(
+                static_cast<GIntBig>(nLines) * (iJob + 1) / nJobs);
+            const size_t nOffset = static_cast<size_t>(iStart) * nXSize;
+
+            asJobs[iJob].psParams = psParams;
+            asJobs[iJob].panSrc = panSrc + nOffset;
+            asJobs[iJob].pafColDist = pafColDist + nOffset;
+            asJobs[iJob].pafProximity = pafProximity + nOffset;
+            asJobs[iJob].nLines = iEnd - iStart;
+            apJobs.push_back( &asJobs[iJob] );
+        }
+
+        // On failure, no job has been queued: run them here.
+        if( poThreadPool != NULL && nJobs > 1 &&
+            poThreadPool->SubmitJobs( ExactProximityLinesJobFunc, apJobs ) )
+        {
+            poThreadPool->WaitCompletion();
+        }
+        else
+        {
+            for( int iJob = 0; iJob < nJobs; iJob++ )
+                ExactProximityLinesJobFunc( apJobs[iJob] );
+        }
+
+        eErr = GDALRasterIO( hProximityBand, GF_Write, 0, iBatch,
+                             nXSize, nLines, pafProximity, nXSize, nLines,
+                             GDT_Float32, 0, 0 );
+
+        if( eErr == CE_None &&
+            !pfnProgress( 0.5 + 0.5 * (nYSize - iBatch) / (double) nYSize,
+                          "", pProgressArg ) )
+        {
+            CPLError( CE_Failure, CPLE_UserInterrupt, "User terminated" );
+            eErr = CE_Failure;
+        }
+    }
+
+    delete poThreadPool;
+    CPLFree( panSrc );
+    CPLFree( pafColDist );
+    CPLFree( pafProximity );
+    CPLFree( panColDist );
+
+    return eErr;
+}
@@ -28,6 +28,7 @@
  * DEALINGS IN THE SOFTWARE.
  ****************************************************************************/
 
+#include <cmath>
 #include <vector>
 
 #include "gdal_alg.h"
@@ -36,6 +37,7 @@
 #include "ogr_api.h"
 #include "ogr_geometry.h"
 #include "ogr_spatialref.h"
+#include "cpl_worker_thread_pool.h"
 
 #include "ogrsf_frmts.h"
 
@@ -74,8 +76,8 @@ void gvBurnScanline( void *pCBData, int nY, int nXStart, int nXEnd,
                              0 : dfVariant ) );
 
             pabyInsert = psInfo->pabyChunkBuf
-                + iBand * psInfo->nXSize * psInfo->nYSize
-                + nY * psInfo->nXSize + nXStart;
+                + iBand * psInfo->nBandStride
+                + static_cast<size_t>(nY) * psInfo->nXSize + nXStart;
 
             if( psInfo->eMergeAlg == GRMA_Add ) {
                 int	nPixels = nXEnd - nXStart + 1;
@@ -98,8 +100,8 @@ void gvBurnScanline( void *pCBData, int nY, int nXStart, int nXEnd,
                              0 : dfVariant ) );
 
             padfInsert = ((double *) psInfo->pabyChunkBuf)
-                + iBand * psInfo->nXSize * psInfo->nYSize
-                + nY * psInfo->nXSize + nXStart;
+                + iBand * psInfo->nBandStride
+                + static_cast<size_t>(nY) * psInfo->nXSize + nXStart;
 
             if( psInfo->eMergeAlg == GRMA_Add ) {
                 while( nPixels-- > 0 )
@@ -133,8 +135,8 @@ void gvBurnPoint( void *pCBData, int nY, int nX, double dfVariant )
         for( iBand = 0; iBand < psInfo->nBands; iBand++ )
         {
             unsigned char *pbyInsert = psInfo->pabyChunkBuf
-                                      + iBand * psInfo->nXSize * psInfo->nYSize
-                                      + nY * psInfo->nXSize + nX;
+                                      + iBand * psInfo->nBandStride
+                                      + static_cast<size_t>(nY) * psInfo->nXSize + nX;
 
             if( psInfo->eMergeAlg == GRMA_Add ) {
                 *pbyInsert += (unsigned char)( psInfo->padfBurnValue[iBand] +
@@ -152,8 +154,8 @@ void gvBurnPoint( void *pCBData, int nY, int nX, double dfVariant )
         for( iBand = 0; iBand < psInfo->nBands; iBand++ )
         {
             double   *pdfInsert = ((double *) psInfo->pabyChunkBuf)
-                                + iBand * psInfo->nXSize * psInfo->nYSize
-                                + nY * psInfo->nXSize + nX;
+                                + iBand * psInfo->nBandStride
+                                + static_cast<size_t>(nY) * psInfo->nXSize + nX;
 
             if( psInfo->eMergeAlg == GRMA_Add ) {
                 *pdfInsert += ( psInfo->padfBurnValue[iBand] +
@@ -300,6 +302,200 @@ static void GDALCollectRingsFromGeometry(
     }
 }
 
+/************************************************************************/
+/*                        gvBurnPointInWindow()                         */
+/*                                                                      */
+/*      Point burning restricted to a window of the lines seen by the   */
+/*      low level rasterizer.                                           */
+/************************************************************************/
+
+typedef struct
+{
+    GDALRasterizeInfo sInfo;  // must be first, llrasterize.cpp looks at it.
+    int               nYOff;  // first line of sInfo's buffer.
+} GDALRasterizeWindowInfo;
+
+static
+void gvBurnPointInWindow( void *pCBData, int nY, int nX, double dfVariant )
+
+{
+    GDALRasterizeWindowInfo *psWindowInfo =
+        (GDALRasterizeWindowInfo *) pCBData;
+
+    nY -= psWindowInfo->nYOff;
+    if( nY < 0 || nY >= psWindowInfo->sInfo.nYSize )
+        return;
+
+    gvBurnPoint( &(psWindowInfo->sInfo), nY, nX, dfVariant );
+}
+
+/************************************************************************/
+/*                        gv_image_line_all_touched()                   */
+/*                                                                      */
+/*      The pixels selected by GDALdllImageLineAllTouched() depend on    */
+/*      where segments get clipped, that is on the chunk of lines it    */
+/*      operates on.  When psInfo only covers a window of such a        */
+/*      chunk, the lines are drawn in the chunk (padfChunkY) and only   */
+/*      the ones of the window are burnt, so that the result does not   */
+/*      depend on how the chunk has been split.                         */
+/************************************************************************/
+
+static void
+gv_image_line_all_touched( GDALRasterizeInfo *psInfo,
+                           int nPartCount, int *panPartSize,
+                           double *padfX, double *padfY, double *padfVariant,
+                           double *padfChunkY, int nChunkYSize,
+                           int nWindowYOff )
+{
+    if( padfChunkY == NULL )
+    {
+        GDALdllImageLineAllTouched( psInfo->nXSize, psInfo->nYSize,
+                                    nPartCount, panPartSize,
+                                    padfX, padfY, padfVariant,
+                                    gvBurnPoint, psInfo );
+        return;
+    }
+
+    GDALRasterizeWindowInfo sWindowInfo;
+    sWindowInfo.sInfo = *psInfo;
+    sWindowInfo.nYOff = nWindowYOff;
+    GDALdllImageLineAllTouched( psInfo->nXSize, nChunkYSize,
+                                nPartCount, panPartSize,
+                                padfX, padfChunkY, padfVariant,
+                                gvBurnPointInWindow, &sWindowInfo );
+}
+
+/************************************************************************/
+/*                     gv_rasterize_collected_shape()                   */
+/*                                                                      */
+/*      Burn a shape whose rings have already been collected and        */
+/*      transformed into the pixel/line space of psInfo's buffer.       */
+/*      padfChunkY, nChunkYSize and nWindowYOff are only needed, for     */
+/*      ALL_TOUCHED, when this buffer is a window of a larger chunk     */
+/*      (see gv_image_line_all_touched()).                              */
+/************************************************************************/
+static void
+gv_rasterize_collected_shape( GDALRasterizeInfo *psInfo,
+                              OGRwkbGeometryType eFlatType, int bAllTouched,
+                              int nPartCount, int *panPartSize,
+                              int nPointCount, double *padfX, double *padfY,
+                              double *padfVariant,
+                              double *padfChunkY = NULL, int nChunkYSize = 0,
+                              int nWindowYOff = 0 )
+
+{
+    switch ( eFlatType )
+    {
+      case wkbPoint:
+      case wkbMultiPoint:
+        GDALdllImagePoint( psInfo->nXSize, psInfo->nYSize,
+                           nPartCount, panPartSize,
+                           padfX, padfY, padfVariant,
+                           gvBurnPoint, psInfo );
+        break;
+      case wkbLineString:
+      case wkbMultiLineString:
+      {
+          if( bAllTouched )
+              gv_image_line_all_touched( psInfo, nPartCount, panPartSize,
+                                         padfX, padfY, padfVariant,
+                                         padfChunkY, nChunkYSize,
+                                         nWindowYOff );
+          else
+              GDALdllImageLine( psInfo->nXSize, psInfo->nYSize,
+                                nPartCount, panPartSize,
+                                padfX, padfY, padfVariant,
+                                gvBurnPoint, psInfo );
+      }
+      break;
+
+      default:
+      {
+          GDALdllImageFilledPolygon( psInfo->nXSize, psInfo->nYSize,
+                                     nPartCount, panPartSize,
+                                     padfX, padfY, padfVariant,
+                                     gvBurnScanline, psInfo );
+          if( bAllTouched )
+          {
+              /* Reverting the variants to the first value because the
+                 polygon is filled using the variant from the first point of
+                 the first segment. Should be removed when the code to full
+                 polygons more appropriately is added. */
+              if( padfVariant == NULL )
+              {
+                  gv_image_line_all_touched( psInfo, nPartCount, panPartSize,
+                                             padfX, padfY, NULL,
+                                             padfChunkY, nChunkYSize,
+                                             nWindowYOff );
+              }
+              else
+              {
+                  std::vector<double> adfFirstVariant( nPointCount,
+                                                       padfVariant[0] );
+
+                  gv_image_line_all_touched( psInfo, nPartCount, panPartSize,
+                                             padfX, padfY,
+                                             &(adfFirstVariant[0]),
+                                             padfChunkY, nChunkYSize,
+                                             nWindowYOff );
+              }
+          }
+      }
+      break;
+    }
+}
+
+/************************************************************************/
+/*                    GDALRasterizeTransformPoints()                    */
+/*                                                                      */
+/*      Transform the points of collected rings in place, and drop      */
+/*      the ones that could not be transformed, as well as the parts    */
+/*      that end up empty. Returns false if no part is left.            */
+/************************************************************************/
+
+static bool GDALRasterizeTransformPoints( GDALTransformerFunc pfnTransformer,
+                                          void *pTransformArg,
+                                          std::vector<double> &aPointX,
+                                          std::vector<double> &aPointY,
+                                          std::vector<double> &aPointVariant,
+                                          std::vector<int> &aPartSize )
+{
+    int *panSuccess = (int *) CPLCalloc(sizeof(int),aPointX.size());
+
+    pfnTransformer( pTransformArg, FALSE, static_cast<int>(aPointX.size()),
+                    &(aPointX[0]), &(aPointY[0]), NULL, panSuccess );
+
+    const bool bHasVariant = !aPointVariant.empty();
+    size_t iSrc = 0;
+    size_t iDst = 0;
+    size_t iDstPart = 0;
+    for( size_t iPart = 0; iPart < aPartSize.size(); iPart++ )
+    {
+        int nKept = 0;
+        for( int i = 0; i < aPartSize[iPart]; i++, iSrc++ )
+        {
+            if( !panSuccess[iSrc] )
+                continue;
+            aPointX[iDst] = aPointX[iSrc];
+            aPointY[iDst] = aPointY[iSrc];
+            if( bHasVariant )
+                aPointVariant[iDst] = aPointVariant[iSrc];
+            iDst++;
+            nKept++;
+        }
+        if( nKept > 0 )
+            aPartSize[iDstPart++] = nKept;
+    }
+    CPLFree( panSuccess );
+
+    aPointX.resize(iDst);
+    aPointY.resize(iDst);
+    if( bHasVariant )
+        aPointVariant.resize(iDst);
+    aPartSize.resize(iDstPart);
+    return !aPartSize.empty();
+}
+
 /************************************************************************/
 /*                       gv_rasterize_one_shape()                       */
 /************************************************************************/
@@ -321,6 +517,7 @@ gv_rasterize_one_shape( unsigned char *pabyChunkBuf, int nYOff,
 
     sInfo.nXSize = nXSize;
     sInfo.nYSize = nYSize;
+    sInfo.nBandStride = static_cast<size_t>(nXSize) * nYSize;
     sInfo.nBands = nBands;
     sInfo.pabyChunkBuf = pabyChunkBuf;
     sInfo.eType = eType;
@@ -340,18 +537,17 @@ gv_rasterize_one_shape( unsigned char *pabyChunkBuf, int nYOff,
     GDALCollectRingsFromGeometry( poShape, aPointX, aPointY, aPointVariant,
                                   aPartSize, eBurnValueSrc );
 
+    if( aPartSize.empty() || aPointX.empty() )
+        return;
+
 /* -------------------------------------------------------------------- */
 /*      Transform points if needed.                                     */
 /* -------------------------------------------------------------------- */
-    if( pfnTransformer != NULL )
-    {
-        int *panSuccess = (int *) CPLCalloc(sizeof(int),aPointX.size());
-
-        // TODO: we need to add all appropriate error checking at some point.
-        pfnTransformer( pTransformArg, FALSE, static_cast<int>(aPointX.size()),
-                        &(aPointX[0]), &(aPointY[0]), NULL, panSuccess );
-        CPLFree( panSuccess );
-    }
+    if( pfnTransformer != NULL &&
+        !GDALRasterizeTransformPoints( pfnTransformer, pTransformArg,
+                                       aPointX, aPointY, aPointVariant,
+                                       aPartSize ) )
+        return;
 
 /* -------------------------------------------------------------------- */
 /*      Shift to account for the buffer offset of this buffer.          */
@@ -366,86 +562,422 @@ gv_rasterize_one_shape( unsigned char *pabyChunkBuf, int nYOff,
 /*      According to the C++ Standard/23.2.4, elements of a vector are  */
 /*      stored in continuous memory block.                              */
 /* -------------------------------------------------------------------- */
+    gv_rasterize_collected_shape( &sInfo,
+                                  wkbFlatten(poShape->getGeometryType()),
+                                  bAllTouched,
+                                  static_cast<int>(aPartSize.size()),
+                                  &(aPartSize[0]),
+                                  static_cast<int>(aPointX.size()),
+                                  &(aPointX[0]), &(aPointY[0]),
+                                  (eBurnValueSrc == GBV_UserBurnValue ||
+                                   aPointVariant.empty()) ?
+                                  NULL : &(aPointVariant[0]) );
+}
+
+/************************************************************************/
+/*                         GDALRasterizeShapeList                       */
+/*                                                                      */
+/*      Geometries collected into rings and transformed into the        */
+/*      pixel/line space of the target raster once, together with the   */
+/*      range of lines each of them may touch, so that the target can   */
+/*      then be processed chunk by chunk without going back to the      */
+/*      source features.                                                */
+/************************************************************************/
+
+typedef struct
+{
+    OGRwkbGeometryType eFlatType;
+    size_t             nFirstPart;
+    int                nPartCount;
+    size_t             nFirstPoint;
+    int                nPointCount;
+    size_t             nFirstVariant;
+    size_t             nFirstBurnValue;
+    int                nMinLine;
+    int                nMaxLine;
+} GDALRasterizeShape;
+
+class GDALRasterizeShapeList
+{
+    int                 nRasterYSize;
+    int                 nBandCount;
+    GDALBurnValueSrc    eBurnValueSrc;
+
+    // Work vectors of the shape being added.
+    std::vector<double> adfShapeX;
+    std::vector<double> adfShapeY;
+    std::vector<double> adfShapeVariant;
+    std::vector<int>    anShapePartSize;
+
+  public:
+    std::vector<GDALRasterizeShape> asShapes;
+    std::vector<int>    anPartSize;
+    std::vector<double> adfX;
+    std::vector<double> adfY;
+    std::vector<double> adfVariant;
+    std::vector<double> adfBurnValue;
+
+            GDALRasterizeShapeList( int nRasterYSizeIn, int nBandCountIn,
+                                    GDALBurnValueSrc eBurnValueSrcIn ) :
+                nRasterYSize(nRasterYSizeIn), nBandCount(nBandCountIn),
+                eBurnValueSrc(eBurnValueSrcIn) {}
+
+    void    Add( OGRGeometry *poShape, const double *padfBurnValues,
+                 GDALTransformerFunc pfnTransformer, void *pTransformArg );
+    GIntBig GetMemoryUsage() const;
+    void    Clear();
+};
+
+/************************************************************************/
+/*                                 Add()                                */
+/************************************************************************/
+
+void GDALRasterizeShapeList::Add( OGRGeometry *poShape,
+                                  const double *padfBurnValues,
+                                  GDALTransformerFunc pfnTransformer,
+                                  void *pTransformArg )
+{
+    if( poShape == NULL )
+        return;
+
+    adfShapeX.resize(0);
+    adfShapeY.resize(0);
+    adfShapeVariant.resize(0);
+    anShapePartSize.resize(0);
+
+    GDALCollectRingsFromGeometry( poShape, adfShapeX, adfShapeY,
+                                  adfShapeVariant, anShapePartSize,
+                                  eBurnValueSrc );
+    if( anShapePartSize.empty() || adfShapeX.empty() )
+        return;
 
-    // TODO - mloskot: Check if vectors are empty, otherwise it may
-    // lead to undefined behavior by returning non-referencable pointer.
-    // if (!aPointX.empty())
-    //    /* fill polygon */
-    // else
-    //    /* How to report this problem? */
-    switch ( wkbFlatten(poShape->getGeometryType()) )
+    if( pfnTransformer != NULL &&
+        !GDALRasterizeTransformPoints( pfnTransformer, pTransformArg,
+                                       adfShapeX, adfShapeY, adfShapeVariant,
+                                       anShapePartSize ) )
+        return;
+
+/* -------------------------------------------------------------------- */
+/*      Compute the range of lines the shape may touch.  It is widened  */
+/*      by one line on each side to be on the safe side whatever the    */
+/*      rounding rules of the low level rasterizers.  Shapes with       */
+/*      invalid coordinates are kept for all lines.                     */
+/* -------------------------------------------------------------------- */
+    double dfMinY = adfShapeY[0];
+    double dfMaxY = adfShapeY[0];
+    bool bInvalid = false;
+    for( size_t i = 0; i < adfShapeY.size(); i++ )
     {
-      case wkbPoint:
-      case wkbMultiPoint:
-        GDALdllImagePoint( sInfo.nXSize, nYSize,
-                           static_cast<int>(aPartSize.size()), &(aPartSize[0]),
-                           &(aPointX[0]), &(aPointY[0]),
-                           (eBurnValueSrc == GBV_UserBurnValue)?
-                           NULL : &(aPointVariant[0]),
-                           gvBurnPoint, &sInfo );
-        break;
-      case wkbLineString:
-      case wkbMultiLineString:
-      {
-          if( bAllTouched )
-              GDALdllImageLineAllTouched( sInfo.nXSize, nYSize,
-                                          static_cast<int>(aPartSize.size()), &(aPartSize[0]),
-                                          &(aPointX[0]), &(aPointY[0]),
-                                          (eBurnValueSrc == GBV_UserBurnValue)?
-                                          NULL : &(aPointVariant[0]),
-                                          gvBurnPoint, &sInfo );
-          else
-              GDALdllImageLine( sInfo.nXSize, nYSize,
-                                static_cast<int>(aPartSize.size()), &(aPartSize[0]),
-                                &(aPointX[0]), &(aPointY[0]),
-                                (eBurnValueSrc == GBV_UserBurnValue)?
-                                NULL : &(aPointVariant[0]),
-                                gvBurnPoint, &sInfo );
-      }
-      break;
+        const double dfY = adfShapeY[i];
+        if( CPLIsNan(dfY) )
+            bInvalid = true;
+        else if( dfY < dfMinY )
+            dfMinY = dfY;
+        else if( dfY > dfMaxY )
+            dfMaxY = dfY;
+    }
 
-      default:
-      {
-          GDALdllImageFilledPolygon( sInfo.nXSize, nYSize,
-                                     static_cast<int>(aPartSize.size()), &(aPartSize[0]),
-                                     &(aPointX[0]), &(aPointY[0]),
-                                     (eBurnValueSrc == GBV_UserBurnValue)?
-                                     NULL : &(aPointVariant[0]),
-                                     gvBurnScanline, &sInfo );
-          if( bAllTouched )
-          {
-              /* Reverting the variants to the first value because the
-                 polygon is filled using the variant from the first point of
-                 the first segment. Should be removed when the code to full
-                 polygons more appropriately is added. */
-              if(eBurnValueSrc == GBV_UserBurnValue)
-              {
-                  GDALdllImageLineAllTouched( sInfo.nXSize, nYSize,
-                                              static_cast<int>(aPartSize.size()), &(aPartSize[0]),
-                                              &(aPointX[0]), &(aPointY[0]),
-                                              NULL,
-                                              gvBurnPoint, &sInfo );
-              }
-              else
-              {
-                  unsigned int n;
-                  for ( i = 0, n = 0; i < static_cast<unsigned int>(aPartSize.size()); i++ )
-                  {
-                      int j;
-                      for ( j = 0; j < aPartSize[i]; j++ )
-                          aPointVariant[n++] = aPointVariant[0];
-                  }
-
-                  GDALdllImageLineAllTouched( sInfo.nXSize, nYSize,
-                                              static_cast<int>(aPartSize.size()), &(aPartSize[0]),
-                                              &(aPointX[0]), &(aPointY[0]),
-                                              &(aPointVariant[0]),
-                                              gvBurnPoint, &sInfo );
-              }
-          }
-      }
-      break;
+    GDALRasterizeShape sShape;
+    if( bInvalid || CPLIsNan(dfMinY) || CPLIsNan(dfMaxY) )
+    {
+        sShape.nMinLine = 0;
+        sShape.nMaxLine = nRasterYSize - 1;
     }
+    else
+    {
+        if( dfMaxY < -1.0 || dfMinY >= nRasterYSize + 1.0 )
+            return;
+        sShape.nMinLine = (dfMinY < 1.0) ? 0 :
+            static_cast<int>(floor(dfMinY)) - 1;
+        sShape.nMaxLine = (dfMaxY >= nRasterYSize - 2.0) ? nRasterYSize - 1 :
+            static_cast<int>(floor(dfMaxY)) + 1;
+    }
+
+    sShape.eFlatType = wkbFlatten(poShape->getGeometryType());
+    sShape.nFirstPart = anPartSize.size();
+    sShape.nPartCount = static_cast<int>(anShapePartSize.size());
+    sShape.nFirstPoint = adfX.size();
+    sShape.nPointCount = static_cast<int>(adfShapeX.size());
+    sShape.nFirstVariant = adfVariant.size();
+    sShape.nFirstBurnValue = adfBurnValue.size();
+
+    // insert() grows the storage geometrically, whereas the reserve()
+    // calls of GDALCollectRingsFromGeometry() would not.
+    anPartSize.insert( anPartSize.end(),
+                       anShapePartSize.begin(), anShapePartSize.end() );
+    adfX.insert( adfX.end(), adfShapeX.begin(), adfShapeX.end() );
+    adfY.insert( adfY.end(), adfShapeY.begin(), adfShapeY.end() );
+    if( eBurnValueSrc != GBV_UserBurnValue )
+        adfVariant.insert( adfVariant.end(),
+                           adfShapeVariant.begin(), adfShapeVariant.end() );
+    adfBurnValue.insert( adfBurnValue.end(),
+                         padfBurnValues, padfBurnValues + nBandCount );
+    asShapes.push_back( sShape );
+}
+
+/************************************************************************/
+/*                           GetMemoryUsage()                           */
+/************************************************************************/
+
+GIntBig GDALRasterizeShapeList::GetMemoryUsage() const
+{
+    return static_cast<GIntBig>(asShapes.capacity() *
+                                sizeof(GDALRasterizeShape)) +
+           static_cast<GIntBig>(anPartSize.capacity() * sizeof(int)) +
+           static_cast<GIntBig>((adfX.capacity() + adfY.capacity() +
+                                 adfVariant.capacity() +
+                                 adfBurnValue.capacity()) * sizeof(double));
+}
+
+/************************************************************************/
+/*                                Clear()                               */
+/************************************************************************/
+
+void GDALRasterizeShapeList::Clear()
+{
+    // Release the memory, and not only the content.
+    std::vector<GDALRasterizeShape>().swap(asShapes);
+    std::vector<int>().swap(anPartSize);
+    std::vector<double>().swap(adfX);
+    std::vector<double>().swap(adfY);
+    std::vector<double>().swap(adfVariant);
+    std::vector<double>().swap(adfBurnValue);
+}
+
+/************************************************************************/
+/*                       GDALRasterizeChunkJob                          */
+/*                                                                      */
+/*      Burning of the shapes of a bucket into a band of lines of a     */
+/*      chunk.  The bands of lines of a chunk do not overlap, and the   */
+/*      shapes are burnt in their original order, so the result does    */
+/*      not depend on the number of jobs, including with MERGE_ALG=ADD. */
+/************************************************************************/
+
+typedef struct
+{
+    const GDALRasterizeShapeList *poList;
+    const std::vector<int>       *panShapes;
+    unsigned char                *pabyChunkBuf;
+    int                           nXSize;
+    int                           nChunkYOff;
+    int                           nChunkYSize;
+    int                           nJobYOff;  // relative to the chunk
+    int                           nJobYSize;
+    int                           nBands;
+    GDALDataType                  eType;
+    int                           bAllTouched;
+    GDALBurnValueSrc              eBurnValueSrc;
+    GDALRasterMergeAlg            eMergeAlg;
+} GDALRasterizeChunkJob;
+
+static void GDALRasterizeChunkJobFunc( void *pData )
+{
+    const GDALRasterizeChunkJob *psJob =
+        static_cast<const GDALRasterizeChunkJob *>(pData);
+    const GDALRasterizeShapeList *poList = psJob->poList;
+    GDALRasterizeInfo sInfo;
+
+    sInfo.nXSize = psJob->nXSize;
+    sInfo.nYSize = psJob->nJobYSize;
+    sInfo.nBandStride =
+        static_cast<size_t>(psJob->nXSize) * psJob->nChunkYSize;
+    sInfo.nBands = psJob->nBands;
+    sInfo.pabyChunkBuf = psJob->pabyChunkBuf +
+        static_cast<size_t>(psJob->nJobYOff) * psJob->nXSize *
+        GDALGetDataTypeSizeBytes(psJob->eType);
+    sInfo.eType = psJob->eType;
+    sInfo.eBurnValueSource = psJob->eBurnValueSrc;
+    sInfo.eMergeAlg = psJob->eMergeAlg;
+
+    const int nLineOff = psJob->nChunkYOff + psJob->nJobYOff;
+    const bool bSplitChunk = psJob->nJobYSize < psJob->nChunkYSize;
+    std::vector<double> adfShiftedY;
+    std::vector<double> adfChunkY;
+
+    for( size_t i = 0; i < psJob->panShapes->size(); i++ )
+    {
+        const GDALRasterizeShape &sShape =
+            poList->asShapes[(*psJob->panShapes)[i]];
+        if( sShape.nMaxLine < nLineOff ||
+            sShape.nMinLine >= nLineOff + psJob->nJobYSize )
+            continue;
+
+        // The low level rasterizers do not modify the coordinates, so
+        // only the shifted Y values need a private copy.
+        adfShiftedY.resize( sShape.nPointCount );
+        const double *padfY = &(poList->adfY[sShape.nFirstPoint]);
+        for( int j = 0; j < sShape.nPointCount; j++ )
+            adfShiftedY[j] = padfY[j] - nLineOff;
+
+        double *padfChunkY = NULL;
+        if( psJob->bAllTouched && bSplitChunk &&
+            sShape.eFlatType != wkbPoint && sShape.eFlatType != wkbMultiPoint )
+        {
+            adfChunkY.resize( sShape.nPointCount );
+            for( int j = 0; j < sShape.nPointCount; j++ )
+                adfChunkY[j] = padfY[j] - psJob->nChunkYOff;
+            padfChunkY = &(adfChunkY[0]);
+        }
+
+        double *padfVariant = NULL;
+        if( psJob->eBurnValueSrc != GBV_UserBurnValue &&
+            sShape.nFirstVariant < poList->adfVariant.size() )
+        {
+            padfVariant = const_cast<double *>(
+                &(poList->adfVariant[sShape.nFirstVariant]));
+        }
+
+        sInfo.padfBurnValue = const_cast<double *>(
+            &(poList->adfBurnValue[sShape.nFirstBurnValue]));
+
+        gv_rasterize_collected_shape(
+            &sInfo, sShape.eFlatType, psJob->bAllTouched,
+            sShape.nPartCount,
+            const_cast<int *>(&(poList->anPartSize[sShape.nFirstPart])),
+            sShape.nPointCount,
+            const_cast<double *>(&(poList->adfX[sShape.nFirstPoint])),
+            &(adfShiftedY[0]), padfVariant,
+            padfChunkY, psJob->nChunkYSize, psJob->nJobYOff );
+    }
+}
+
+/************************************************************************/
+/*                       GDALRasterizeShapeListBurn()                   */
+/*                                                                      */
+/*      Burn collected shapes into the dataset, chunk by chunk.  The     */
+/*      shapes are first bucketed by the chunks they may touch, so that */
+/*      each chunk only considers its own shapes, and chunks without    */
+/*      any shape are neither read nor written.                         */
+/************************************************************************/
+
+static CPLErr
+GDALRasterizeShapeListBurn( GDALDataset *poDS,
+                            int nBandCount, int *panBandList,
+                            GDALDataType eType,
+                            unsigned char *pabyChunkBuf, int nYChunkSize,
+                            const GDALRasterizeShapeList &oList,
+                            int bAllTouched,
+                            GDALBurnValueSrc eBurnValueSrc,
+                            GDALRasterMergeAlg eMergeAlg,
+                            CPLWorkerThreadPool *poThreadPool,
+                            GDALProgressFunc pfnProgress,
+                            void *pProgressArg )
+{
+    const int nXSize = poDS->GetRasterXSize();
+    const int nYSize = poDS->GetRasterYSize();
+    const int nChunks = (nYSize + nYChunkSize - 1) / nYChunkSize;
+
+    std::vector< std::vector<int> > aanBuckets( nChunks );
+    for( size_t i = 0; i < oList.asShapes.size(); i++ )
+    {
+        const GDALRasterizeShape &sShape = oList.asShapes[i];
+        const int iFirstChunk = sShape.nMinLine / nYChunkSize;
+        const int iLastChunk = sShape.nMaxLine / nYChunkSize;
+        for( int iChunk = iFirstChunk; iChunk <= iLastChunk; iChunk++ )
+            aanBuckets[iChunk].push_back( static_cast<int>(i) );
+    }
+
+    const int nThreads = poThreadPool ? poThreadPool->GetThreadCount() : 1;
+    std::vector<GDALRasterizeChunkJob> asJobs( nThreads );
+    std::vector<void *> apJobs;
+    CPLErr eErr = CE_None;
+
+    for( int iChunk = 0; iChunk < nChunks && eErr == CE_None; iChunk++ )
+    {
+        const int iY = iChunk * nYChunkSize;
+        const int nThisYChunkSize = MIN(nYChunkSize, nYSize - iY);
+
+        if( !aanBuckets[iChunk].empty() )
+        {
+            eErr = poDS->RasterIO( GF_Read, 0, iY, nXSize, nThisYChunkSize,
+                                   pabyChunkBuf, nXSize, nThisYChunkSize,
+                                   eType, nBandCount, panBandList,
+                                   0, 0, 0, NULL );
+            if( eErr != CE_None )
+                break;
+
+            const int nJobs = MIN(nThreads, nThisYChunkSize);
+            apJobs.resize( 0 );
+            for( int iJob = 0; iJob < nJobs; iJob++ )
+            {
+                GDALRasterizeChunkJob &sJob = asJobs[iJob];
+                sJob.poList = &oList;
+                sJob.panShapes = &(aanBuckets[iChunk]);
+                sJob.pabyChunkBuf = pabyChunkBuf;
+                sJob.nXSize = nXSize;
+                sJob.nChunkYOff = iY;
+                sJob.nChunkYSize = nThisYChunkSize;
+                sJob.nJobYOff = static_cast<int>(
+                    static_cast<GIntBig>(nThisYChunkSize) * iJob / nJobs);
+                sJob.nJobYSize = static_cast<int>(
+                    static_cast<GIntBig>(nThisYChunkSize) * (iJob + 1) /
+                    nJobs) - sJob.nJobYOff;
+                sJob.nBands = nBandCount;
+                sJob.eType = eType;
+                sJob.bAllTouched = bAllTouched;
+                sJob.eBurnValueSrc = eBurnValueSrc;
+                sJob.eMergeAlg = eMergeAlg;
+                apJobs.push_back( &sJob );
+            }
+
+            if( nJobs == 1 )
+            {
+                GDALRasterizeChunkJobFunc( apJobs[0] );
+            }
+            else
+            {
+                // On failure, no job has been queued: run them here.
+                if( poThreadPool->SubmitJobs( GDALRasterizeChunkJobFunc,
+                                              apJobs ) )
+                {
+                    poThreadPool->WaitCompletion();
+                }
+                else
+                {
+                    for( int iJob = 0; iJob < nJobs; iJob++ )
+                        GDALRasterizeChunkJobFunc( apJobs[iJob] );
+                }
+            }
+
+            // Release the bucket as soon as it is no longer needed.
+            std::vector<int>().swap( aanBuckets[iChunk] );
+
+            eErr = poDS->RasterIO( GF_Write, 0, iY, nXSize, nThisYChunkSize,
+                                   pabyChunkBuf, nXSize, nThisYChunkSize,
+                                   eType, nBandCount, panBandList,
+                                   0, 0, 0, NULL );
+        }
+
+        if( eErr == CE_None &&
+            !pfnProgress((iY+nThisYChunkSize)/((double)nYSize),
+                         "", pProgressArg) )
+        {
+            CPLError( CE_Failure, CPLE_UserInterrupt, "User terminated" );
+            eErr = CE_Failure;
+        }
+    }
+
+    return eErr;
+}
+
+/************************************************************************/
+/*                     GDALRasterizeCreateThreadPool()                  */
+/************************************************************************/
+
+static CPLWorkerThreadPool *GDALRasterizeCreateThreadPool( char **papszOptions )
+{
+    const int nThreads = CPLGetNumThreads( papszOptions, "1" );
+    if( nThreads <= 1 )
+        return NULL;
+
+    CPLWorkerThreadPool *poThreadPool = new CPLWorkerThreadPool();
+    if( !poThreadPool->Setup( nThreads, NULL, NULL ) )
+    {
+        delete poThreadPool;
+        return NULL;
+    }
+    CPLDebug( "GDAL", "Rasterizer using %d threads", nThreads );
+    return poThreadPool;
 }
 
 /************************************************************************/
@@ -548,6 +1080,15 @@ static CPLErr GDALRasterizeOptions(char **papszOptions,
  * dfBurnValue is burned. This is implemented only for points and lines for
  * now. The M value may be supported in the future.</dd>
  * <dt>"MERGE_ALG":</dt> <dd>May be REPLACE (the default) or ADD.  REPLACE results in overwriting of value, while ADD adds the new value to the existing raster, suitable for heatmaps for instance.</dd>
+ * <dt>"SINGLE_PASS":</dt> <dd>(GDAL >= 2.2) May be set to NO to transform
+ * the geometries again for each chunk of the raster, as done by older
+ * versions.  Defaults to YES, in which case the geometries are transformed
+ * only once, and each chunk only processes the geometries that may
+ * touch it.</dd>
+ * <dt>"NUM_THREADS":</dt> <dd>(GDAL >= 2.2) Number of worker threads
+ * burning a chunk in single pass mode, or ALL_CPUS.  Defaults to the value
+ * of the GDAL_NUM_THREADS configuration option, or 1.  The result does not
+ * depend on the number of threads.</dd>
  * </dl>
  * @param pfnProgress the progress function to report completion.
  * @param pProgressArg callback data for progress function.
@@ -653,12 +1194,61 @@ CPLErr GDALRasterizeGeometries( GDALDatasetH hDS,
     }
 
 /* ==================================================================== */
-/*      Loop over image in designated chunks.                           */
+/*      In single pass mode, collect and transform the geometries       */
+/*      only once, and then burn them chunk by chunk.                   */
 /* ==================================================================== */
     CPLErr  eErr = CE_None;
 
     pfnProgress( 0.0, NULL, pProgressArg );
 
+    if( CPLFetchBool( const_cast<const char **>(papszOptions),
+                      "SINGLE_PASS", true ) )
+    {
+        CPLWorkerThreadPool *poThreadPool =
+            GDALRasterizeCreateThreadPool( papszOptions );
+        GDALRasterizeShapeList oList( poDS->GetRasterYSize(), nBandCount,
+                                      eBurnValueSource );
+        const GIntBig nMaxMemory = GDALGetCacheMax64();
+
+        for( int iShape = 0; iShape < nGeomCount && eErr == CE_None;
+             iShape++ )
+        {
+            oList.Add( (OGRGeometry *) pahGeometries[iShape],
+                       padfGeomBurnValue + iShape*nBandCount,
+                       pfnTransformer, pTransformArg );
+
+            // Burn what we have so far if it takes too much memory.
+            if( oList.GetMemoryUsage() > nMaxMemory &&
+                iShape + 1 < nGeomCount )
+            {
+                eErr = GDALRasterizeShapeListBurn(
+                    poDS, nBandCount, panBandList, eType,
+                    pabyChunkBuf, nYChunkSize, oList,
+                    bAllTouched, eBurnValueSource, eMergeAlg,
+                    poThreadPool, GDALDummyProgress, NULL );
+                oList.Clear();
+            }
+        }
+
+        if( eErr == CE_None )
+            eErr = GDALRasterizeShapeListBurn(
+                poDS, nBandCount, panBandList, eType,
+                pabyChunkBuf, nYChunkSize, oList,
+                bAllTouched, eBurnValueSource, eMergeAlg,
+                poThreadPool, pfnProgress, pProgressArg );
+
+        delete poThreadPool;
+
+        VSIFree( pabyChunkBuf );
+        if( bNeedToFreeTransformer )
+            GDALDestroyTransformer( pTransformArg );
+
+        return eErr;
+    }
+
+/* ==================================================================== */
+/*      Loop over image in designated chunks.                           */
+/* ==================================================================== */
     for( iY = 0;
          iY < poDS->GetRasterYSize() && eErr == CE_None;
          iY += nYChunkSize )
@@ -770,6 +1360,16 @@ CPLErr GDALRasterizeGeometries( GDALDatasetH hDS,
  * will be burned using the Z value from the first point. The M value may be
  * supported in the future.</dd>
  * <dt>"MERGE_ALG":</dt> <dd>May be REPLACE (the default) or ADD.  REPLACE results in overwriting of value, while ADD adds the new value to the existing raster, suitable for heatmaps for instance.</dd>
+ * <dt>"SINGLE_PASS":</dt> <dd>(GDAL >= 2.2) May be set to NO to read
+ * the layers again for each chunk of the raster, as done by older versions.
+ * Defaults to YES, in which case the features are read and their geometries
+ * transformed only once, and each chunk only processes the geometries that
+ * may touch it.  If the transformed geometries take more memory than the
+ * GDAL cache size, they are burnt before reading more features.</dd>
+ * <dt>"NUM_THREADS":</dt> <dd>(GDAL >= 2.2) Number of worker threads
+ * burning a chunk in single pass mode, or ALL_CPUS.  Defaults to the value
+ * of the GDAL_NUM_THREADS configuration option, or 1.  The result does not
+ * depend on the number of threads.</dd>
  * </dl>
  * @param pfnProgress the progress function to report completion.
  * @param pProgressArg callback data for progress function.
@@ -859,11 +1459,26 @@ CPLErr GDALRasterizeLayers( GDALDatasetH hDS,
         return CE_Failure;
     }
 
+/* -------------------------------------------------------------------- */
+/*      In single pass mode, the features of all layers are read and    */
+/*      transformed only once, and are burnt chunk by chunk at the end. */
+/* -------------------------------------------------------------------- */
+    const bool bSinglePass =
+        CPLFetchBool( const_cast<const char **>(papszOptions),
+                      "SINGLE_PASS", true );
+    CPLWorkerThreadPool *poThreadPool = NULL;
+    GDALRasterizeShapeList oList( poDS->GetRasterYSize(), nBandCount,
+                                  eBurnValueSource );
+    const GIntBig nMaxMemory = GDALGetCacheMax64();
+
+    if( bSinglePass )
+        poThreadPool = GDALRasterizeCreateThreadPool( papszOptions );
+
 /* -------------------------------------------------------------------- */
 /*      Read the image once for all layers if user requested to render  */
 /*      the whole raster in single chunk.                               */
 /* -------------------------------------------------------------------- */
-    if ( nYChunkSize == poDS->GetRasterYSize() )
+    else if ( nYChunkSize == poDS->GetRasterYSize() )
     {
         if ( poDS->RasterIO( GF_Read, 0, 0, poDS->GetRasterXSize(),
                              nYChunkSize, pabyChunkBuf,
@@ -959,16 +1574,49 @@ CPLErr GDALRasterizeLayers( GDALDatasetH hDS,
 
         poLayer->ResetReading();
 
-/* -------------------------------------------------------------------- */
-/*      Loop over image in designated chunks.                           */
-/* -------------------------------------------------------------------- */
-
         double *padfAttrValues = (double *) VSI_MALLOC_VERBOSE(sizeof(double) * nBandCount);
         if( padfAttrValues == NULL )
             eErr = CE_Failure;
 
+/* -------------------------------------------------------------------- */
+/*      In single pass mode, just collect the transformed geometries.   */
+/* -------------------------------------------------------------------- */
+        while( bSinglePass && eErr == CE_None &&
+               (poFeat = poLayer->GetNextFeature()) != NULL )
+        {
+            if ( pszBurnAttribute )
+            {
+                const double dfAttrValue =
+                    poFeat->GetFieldAsDouble( iBurnField );
+                for( int iBand = 0 ; iBand < nBandCount ; iBand++ )
+                    padfAttrValues[iBand] = dfAttrValue;
+
+                padfBurnValues = padfAttrValues;
+            }
+
+            oList.Add( poFeat->GetGeometryRef(), padfBurnValues,
+                       pfnTransformer, pTransformArg );
+
+            delete poFeat;
+
+            // Burn what we have so far if it takes too much memory.
+            if( oList.GetMemoryUsage() > nMaxMemory )
+            {
+                eErr = GDALRasterizeShapeListBurn(
+                    poDS, nBandCount, panBandList, eType,
+                    pabyChunkBuf, nYChunkSize, oList,
+                    bAllTouched, eBurnValueSource, eMergeAlg,
+                    poThreadPool, GDALDummyProgress, NULL );
+                oList.Clear();
+            }
+        }
+
+/* -------------------------------------------------------------------- */
+/*      Otherwise loop over image in designated chunks.                 */
+/* -------------------------------------------------------------------- */
         int     iY;
         for( iY = 0;
+             !bSinglePass &&
              iY < poDS->GetRasterYSize() && eErr == CE_None;
              iY += nYChunkSize )
         {
@@ -1049,11 +1697,25 @@ CPLErr GDALRasterizeLayers( GDALDatasetH hDS,
         }
     }
 
+/* -------------------------------------------------------------------- */
+/*      Burn the collected geometries in single pass mode.              */
+/* -------------------------------------------------------------------- */
+    if( bSinglePass )
+    {
+        if( eErr == CE_None )
+            eErr = GDALRasterizeShapeListBurn(
+                poDS, nBandCount, panBandList, eType,
+                pabyChunkBuf, nYChunkSize, oList,
+                bAllTouched, eBurnValueSource, eMergeAlg,
+                poThreadPool, pfnProgress, pProgressArg );
+        delete poThreadPool;
+    }
+
 /* -------------------------------------------------------------------- */
 /*      Write out the image once for all layers if user requested       */
 /*      to render the whole raster in single chunk.                     */
 /* -------------------------------------------------------------------- */
-    if ( eErr == CE_None && nYChunkSize == poDS->GetRasterYSize() )
+    else if ( eErr == CE_None && nYChunkSize == poDS->GetRasterYSize() )
     {
         eErr = poDS->RasterIO( GF_Write, 0, 0,
                                 poDS->GetRasterXSize(), nYChunkSize,
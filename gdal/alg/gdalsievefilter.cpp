@@ -30,30 +30,66 @@
 
 #include "gdal_alg_priv.h"
 #include "cpl_conv.h"
+#include "cpl_string.h"
+#include "cpl_worker_thread_pool.h"
+#include <algorithm>
 #include <vector>
-#include <set>
 
 CPL_CVSID("$Id$");
 
 #define MY_MAX_INT 2147483647
 
+/* Number of pixels of a strip of lines, unless GDAL_SIEVE_STRIP_LINES */
+/* is set. */
+#define SIEVE_STRIP_PIXELS (1024 * 1024)
+
+/* Minimum number of lines of a strip, so that wide rasters are not split */
+/* in thin strips, where most polygons would cross a strip boundary. */
+#define SIEVE_MIN_STRIP_LINES 128
+
+/* State of the resolution of a polygon. */
+#define SIEVE_UNKNOWN      0
+#define SIEVE_IN_PROGRESS  1
+#define SIEVE_DONE         2
+
+/* Outcome of the walk through the biggest neighbours of a polygon. */
+#define SIEVE_NONE         0
+#define SIEVE_FAIL         1
+#define SIEVE_FINAL        2
+#define SIEVE_GOTO         3
+
+/* A polygon reference is either the id (>= 0) of a polygon local to a */
+/* strip, or the encoded index of a global polygon in the table of the */
+/* global polygons seen by the strip.  -1 stands for nodata. */
+#define SIEVE_SLOT_REF(slot)   (-(slot) - 2)
+#define SIEVE_SLOT(ref)        (-(ref) - 2)
+
 /*
  * General Plan
  *
- * 1) make a pass with the polygon enumerator to build up the
- *    polygon map array.  Also accumulate polygon size information.
+ * The raster is processed by strips of lines.  Each strip is labelled
+ * independently with a union-find connected component labelling.  Only
+ * the polygons touching the top or bottom line of a strip (shared with
+ * another strip) get a global id, and the equivalences between them are
+ * merged at the strip boundaries.
+ *
+ * 1) Label each strip, and accumulate the sizes of the global polygons.
  *
- * 2) Identify the polygons that need to be merged.
+ * 2) Label each strip again.  For each polygon keep track of its largest
+ *    neighbour.  The largest neighbour of polygons entirely within the
+ *    strip is followed locally, and only the outcome for the global
+ *    polygons is kept.
  *
- * 3) Make a pass with the polygon enumerator.  For each "to be merged"
- *    polygon keep track of its largest neighbour.
+ * 3) Walk the largest neighbours of the small global polygons until a
+ *    polygon larger than the sieve size is found.
  *
- * 4) Fix up remappings that would go to polygons smaller than the seive
- *    size.  Ensure these in term map to the largest neighbour of the
- *    "to be sieved" polygons.
+ * 4) Label each strip a last time, resolve the polygons entirely within
+ *    it, and remap the actual pixel values of all polygons to be merged.
  *
- * 5) Make another pass with the polygon enumerator. This time we remap
- *    the actual pixel values of all polygons to be merged.
+ * Strips are independent within a pass, so they are processed in
+ * parallel.  Ties between neighbours of the same size are broken by the
+ * scan order, as in a single pass over the raster, so the result does not
+ * depend on the strip size nor on the number of threads.
  */
 
 /************************************************************************/
@@ -64,18 +100,18 @@ CPL_CVSID("$Id$");
 /************************************************************************/
 
 static CPLErr
-GPMaskImageData( GDALRasterBandH hMaskBand, GByte *pabyMaskLine, int iY, int nXSize,
-                 GInt32 *panImageLine )
+GPMaskImageData( GDALRasterBandH hMaskBand, GByte *pabyMaskLine, int iY,
+                 int nXSize, int nLines, GInt32 *panImageLine )
 
 {
     CPLErr eErr;
 
-    eErr = GDALRasterIO( hMaskBand, GF_Read, 0, iY, nXSize, 1,
-                         pabyMaskLine, nXSize, 1, GDT_Byte, 0, 0 );
+    eErr = GDALRasterIO( hMaskBand, GF_Read, 0, iY, nXSize, nLines,
+                         pabyMaskLine, nXSize, nLines, GDT_Byte, 0, 0 );
     if( eErr == CE_None )
     {
-        int i;
-        for( i = 0; i < nXSize; i++ )
+        const size_t nPixels = static_cast<size_t>(nXSize) * nLines;
+        for( size_t i = 0; i < nPixels; i++ )
         {
             if( pabyMaskLine[i] == 0 )
                 panImageLine[i] = GP_NODATA_MARKER;
@@ -85,521 +121,1208 @@ GPMaskImageData( GDALRasterBandH hMaskBand, GByte *pabyMaskLine, int iY, int nXS
     return eErr;
 }
 
-// TODO: What is "eaches" supposed to be?
+/************************************************************************/
+/*                           GDALSieveFind()                            */
+/************************************************************************/
+
+static inline int GDALSieveFind( std::vector<int> &anParent, int i )
+
+{
+    while( anParent[i] != i )
+    {
+        anParent[i] = anParent[anParent[i]];
+        i = anParent[i];
+    }
+    return i;
+}
 
 /************************************************************************/
-/*                          CompareNeighbour()                          */
-/*                                                                      */
-/*      Compare two neighbouring polygons, and update eaches            */
-/*      "biggest neighbour" if the other is larger than it's current    */
-/*      largest neighbour.                                              */
+/*                           GDALSieveStrip                             */
+/************************************************************************/
+
+// Largest neighbour of a global polygon within a strip.
+struct GDALSieveCandidate
+{
+    int      nGlobalId;
+    int      nSize;
+    int      nKind;
+    GInt32   nValue;
+};
+
+struct GDALSieveStrip
+{
+    int      nPass;
+    int      nXSize;
+    int      nLines;
+    bool     bTopSeam;
+    bool     bBottomSeam;
+    int      nConnectedness;
+    int      nSizeThreshold;
+
+    // nLines + 1 lines, the first one being the last line of the previous
+    // strip when bTopSeam is set.
+    GInt32  *panVal;
+    // Output values of the third pass.
+    GInt32  *panOut;
+    // Local polygon id of each pixel, or -1 for nodata.
+    GInt32  *panLabel;
+
+    // Global polygons, set for the second and third passes.
+    int            nGlobalBase;
+    const int     *panPrevGlobal;
+    const int     *panGlobalRoot;
+    const int     *panGlobalSize;
+    const GInt32  *panGlobalValue;
+    const int     *panGlobalKind;
+    const GInt32  *panGlobalResult;
+
+    // Local polygons.
+    int                  nPolygons;
+    std::vector<int>     anSize;
+    std::vector<GInt32>  anValue;
+    std::vector<int>     anBorder;
+    int                  nBorder;
+
+    // Global polygons seen by the strip.
+    std::vector<int>     anSlotGlobalId;
+    std::vector<int>     anSlotSize;
+    std::vector<int>     anSlotBigNeighbour;
+    std::vector<int>     anSlotBigNeighbourSize;
+
+    // Largest neighbours.
+    std::vector<int>     anBigNeighbour;
+    std::vector<int>     anBigNeighbourSize;
+    std::vector<int>     anKind;
+    std::vector<GInt32>  anResultValue;
+    std::vector<GByte>   abyState;
+    std::vector<int>     anPath;
+
+    std::vector<GDALSieveCandidate> asCandidates;
+
+    int      nSieveTargets;
+    int      nIsolatedSmall;
+    int      nFailedMerges;
+};
+
+/************************************************************************/
+/*                          GDALSieveMerge()                            */
 /*                                                                      */
-/*      Note that this should end up with each polygon knowing the      */
-/*      id of it's largest neighbour.  No attempt is made to            */
-/*      restrict things to small polygons that we will be merging,      */
-/*      nor to exclude assigning "biggest neighbours" that are still    */
-/*      smaller than our sieve threshold.                               */
+/*      Merge the provisional polygon nOther into nLabel, and return    */
+/*      the id to use for the current pixel.                            */
 /************************************************************************/
 
-static inline void CompareNeighbour( int nPolyId1, int nPolyId2,
-                                     int *panPolyIdMap,
-                                     int * /* panPolyValue */,
-                                     std::vector<int> &anPolySizes,
-                                     std::vector<int> &anBigNeighbour )
+static inline int GDALSieveMerge( std::vector<int> &anParent,
+                                  int nLabel, int nOther )
 
 {
-    // nodata polygon do not need neighbours, and cannot be neighbours
-    // to valid polygons.
-    if( nPolyId1 < 0 || nPolyId2 < 0 )
-        return;
+    if( nLabel < 0 || nLabel == nOther )
+        return nOther;
 
-    // make sure we are working with the final merged polygon ids.
-    nPolyId1 = panPolyIdMap[nPolyId1];
-    nPolyId2 = panPolyIdMap[nPolyId2];
+    nLabel = GDALSieveFind( anParent, nLabel );
+    nOther = GDALSieveFind( anParent, nOther );
 
-    if( nPolyId1 == nPolyId2 )
-        return;
+    // The smallest id stays the root, so parents always have a smaller
+    // id than their children.
+    if( nOther < nLabel )
+        std::swap( nOther, nLabel );
+    anParent[nOther] = nLabel;
 
-    // nodata polygon do not need neighbours, and cannot be neighbours
-    // to valid polygons.
-    // should no longer happen with r28826 optimization
-    //if( panPolyValue[nPolyId1] == GP_NODATA_MARKER
-    //    || panPolyValue[nPolyId2] == GP_NODATA_MARKER )
-    //    return;
-
-    if( anBigNeighbour[nPolyId1] == -1
-        || anPolySizes[anBigNeighbour[nPolyId1]] < anPolySizes[nPolyId2] )
-        anBigNeighbour[nPolyId1] = nPolyId2;
-
-    if( anBigNeighbour[nPolyId2] == -1
-        || anPolySizes[anBigNeighbour[nPolyId2]] < anPolySizes[nPolyId1] )
-        anBigNeighbour[nPolyId2] = nPolyId1;
+    return nLabel;
 }
 
 /************************************************************************/
-/*                          GDALSieveFilter()                           */
+/*                        GDALSieveLabelStrip()                         */
+/*                                                                      */
+/*      Assign a local polygon id to each pixel of the strip.  Ids      */
+/*      are numbered in the order of the first pixel of each            */
+/*      polygon, so labelling the same strip twice gives the same       */
+/*      ids.                                                            */
 /************************************************************************/
 
-/**
- * Removes small raster polygons.
- *
- * The function removes raster polygons smaller than a provided
- * threshold size (in pixels) and replaces replaces them with the pixel value
- * of the largest neighbour polygon.
- *
- * Polygon are determined (per GDALRasterPolygonEnumerator) as regions of
- * the raster where the pixels all have the same value, and that are contiguous
- * (connected).
- *
- * Pixels determined to be "nodata" per hMaskBand will not be treated as part
- * of a polygon regardless of their pixel values.  Nodata areas will never be
- * changed nor affect polygon sizes.
- *
- * Polygons smaller than the threshold with no neighbours that are as large
- * as the threshold will not be altered.  Polygons surrounded by nodata areas
- * will therefore not be altered.
- *
- * The algorithm makes three passes over the input file to enumerate the
- * polygons and collect limited information about them.  Memory use is
- * proportional to the number of polygons (roughly 24 bytes per polygon), but
- * is not directly related to the size of the raster.  So very large raster
- * files can be processed effectively if there aren't too many polygons.  But
- * extremely noisy rasters with many one pixel polygons will end up being
- * expensive (in memory) to process.
- *
- * @param hSrcBand the source raster band to be processed.
- * @param hMaskBand an optional mask band.  All pixels in the mask band with a
- * value other than zero will be considered suitable for inclusion in polygons.
- * @param hDstBand the output raster band.  It may be the same as hSrcBand
- * to update the source in place.
- * @param nSizeThreshold raster polygons with sizes smaller than this will
- * be merged into their largest neighbour.
- * @param nConnectedness either 4 indicating that diagonal pixels are not
- * considered directly adjacent for polygon membership purposes or 8
- * indicating they are.
- * @param papszOptions algorithm options in name=value list form.  None currently
- * supported.
- * @param pfnProgress callback for reporting algorithm progress matching the
- * GDALProgressFunc() semantics.  May be NULL.
- * @param pProgressArg callback argument passed to pfnProgress.
- *
- * @return CE_None on success or CE_Failure if an error occurs.
- */
+static void GDALSieveLabelStrip( GDALSieveStrip *psStrip )
 
-CPLErr CPL_STDCALL
-GDALSieveFilter( GDALRasterBandH hSrcBand, GDALRasterBandH hMaskBand,
-                 GDALRasterBandH hDstBand,
-                 int nSizeThreshold, int nConnectedness,
-                 CPL_UNUSED char **papszOptions,
-                 GDALProgressFunc pfnProgress,
-                 void * pProgressArg )
 {
-    VALIDATE_POINTER1( hSrcBand, "GDALSieveFilter", CE_Failure );
-    VALIDATE_POINTER1( hDstBand, "GDALSieveFilter", CE_Failure );
+    const int nXSize = psStrip->nXSize;
+    const int nLines = psStrip->nLines;
+    const bool b8Connected = psStrip->nConnectedness == 8;
+    const GInt32 *panVal = psStrip->panVal + nXSize;
+    GInt32 *panLabel = psStrip->panLabel;
+    std::vector<int> anParent;
+
+    for( int iY = 0; iY < nLines; iY++ )
+    {
+        const GInt32 *panThisVal = panVal + static_cast<size_t>(iY) * nXSize;
+        GInt32 *panThisLabel = panLabel + static_cast<size_t>(iY) * nXSize;
+        const GInt32 *panLastVal = iY > 0 ? panThisVal - nXSize : NULL;
+        const GInt32 *panLastLabel = iY > 0 ? panThisLabel - nXSize : NULL;
 
-    if( pfnProgress == NULL )
-        pfnProgress = GDALDummyProgress;
+        for( int iX = 0; iX < nXSize; iX++ )
+        {
+            const GInt32 nValue = panThisVal[iX];
+            if( nValue == GP_NODATA_MARKER )
+            {
+                panThisLabel[iX] = -1;
+                continue;
+            }
+
+            int nLabel = -1;
+            const bool bLeft = iX > 0 && panThisVal[iX-1] == nValue;
+            if( bLeft )
+                nLabel = panThisLabel[iX-1];
+
+            if( iY > 0 )
+            {
+                // The diagonal pixels are already connected to the pixel
+                // above, and the upper left one to the left pixel.
+                if( panLastVal[iX] == nValue )
+                    nLabel = GDALSieveMerge( anParent, nLabel,
+                                             panLastLabel[iX] );
+                else if( b8Connected )
+                {
+                    if( !bLeft && iX > 0 && panLastVal[iX-1] == nValue )
+                        nLabel = GDALSieveMerge( anParent, nLabel,
+                                                 panLastLabel[iX-1] );
+                    if( iX < nXSize-1 && panLastVal[iX+1] == nValue )
+                        nLabel = GDALSieveMerge( anParent, nLabel,
+                                                 panLastLabel[iX+1] );
+                }
+            }
+
+            if( nLabel < 0 )
+            {
+                nLabel = static_cast<int>(anParent.size());
+                anParent.push_back( nLabel );
+            }
+            panThisLabel[iX] = nLabel;
+        }
+    }
 
 /* -------------------------------------------------------------------- */
-/*      Allocate working buffers.                                       */
+/*      Renumber the polygons.  Roots are the first provisional id      */
+/*      of each polygon, and parents come before their children.        */
 /* -------------------------------------------------------------------- */
-    CPLErr eErr = CE_None;
-    int nXSize = GDALGetRasterBandXSize( hSrcBand );
-    int nYSize = GDALGetRasterBandYSize( hSrcBand );
-    GInt32 *panLastLineVal = (GInt32 *) VSI_MALLOC2_VERBOSE(sizeof(GInt32), nXSize);
-    GInt32 *panThisLineVal = (GInt32 *) VSI_MALLOC2_VERBOSE(sizeof(GInt32), nXSize);
-    GInt32 *panLastLineId =  (GInt32 *) VSI_MALLOC2_VERBOSE(sizeof(GInt32), nXSize);
-    GInt32 *panThisLineId =  (GInt32 *) VSI_MALLOC2_VERBOSE(sizeof(GInt32), nXSize);
-    GInt32 *panThisLineWriteVal = (GInt32 *) VSI_MALLOC2_VERBOSE(sizeof(GInt32), nXSize);
-    GByte *pabyMaskLine = (hMaskBand != NULL) ? (GByte *) VSI_MALLOC_VERBOSE(nXSize) : NULL;
-    if (panLastLineVal == NULL || panThisLineVal == NULL ||
-        panLastLineId == NULL || panThisLineId == NULL ||
-        panThisLineWriteVal == NULL ||
-        (hMaskBand != NULL && pabyMaskLine == NULL))
+    const int nProvisional = static_cast<int>(anParent.size());
+    int nPolygons = 0;
+    for( int i = 0; i < nProvisional; i++ )
     {
-        CPLFree( panThisLineId );
-        CPLFree( panLastLineId );
-        CPLFree( panThisLineVal );
-        CPLFree( panLastLineVal );
-        CPLFree( panThisLineWriteVal );
-        CPLFree( pabyMaskLine );
-        return CE_Failure;
+        if( anParent[i] == i )
+            anParent[i] = nPolygons++;
+        else
+            anParent[i] = anParent[anParent[i]];
     }
 
 /* -------------------------------------------------------------------- */
-/*      The first pass over the raster is only used to build up the     */
-/*      polygon id map so we will know in advance what polygons are     */
-/*      what on the second pass.                                        */
+/*      Relabel the pixels and accumulate the polygon sizes.            */
 /* -------------------------------------------------------------------- */
-    int iY, iX, iPoly;
-    GDALRasterPolygonEnumerator oFirstEnum( nConnectedness );
-    std::vector<int> anPolySizes;
+    psStrip->nPolygons = nPolygons;
+    psStrip->anSize.assign( nPolygons, 0 );
+    psStrip->anValue.resize( nPolygons );
+    psStrip->anBorder.assign( nPolygons, -1 );
 
-    for( iY = 0; eErr == CE_None && iY < nYSize; iY++ )
+    for( int iY = 0; iY < nLines; iY++ )
     {
-        eErr = GDALRasterIO(
-            hSrcBand,
-            GF_Read, 0, iY, nXSize, 1,
-            panThisLineVal, nXSize, 1, GDT_Int32, 0, 0 );
+        const GInt32 *panThisVal = panVal + static_cast<size_t>(iY) * nXSize;
+        GInt32 *panThisLabel = panLabel + static_cast<size_t>(iY) * nXSize;
+        const bool bBorder = (iY == 0 && psStrip->bTopSeam)
+            || (iY == nLines - 1 && psStrip->bBottomSeam);
 
-        if( eErr == CE_None && hMaskBand != NULL )
-            eErr = GPMaskImageData( hMaskBand, pabyMaskLine, iY, nXSize, panThisLineVal );
+        for( int iX = 0; iX < nXSize; iX++ )
+        {
+            if( panThisLabel[iX] < 0 )
+                continue;
+
+            const int iPoly = anParent[panThisLabel[iX]];
+            panThisLabel[iX] = iPoly;
+            psStrip->anValue[iPoly] = panThisVal[iX];
+            if( psStrip->anSize[iPoly] < MY_MAX_INT )
+                psStrip->anSize[iPoly] += 1;
+            if( bBorder )
+                psStrip->anBorder[iPoly] = 0;
+        }
+    }
 
-        if( iY == 0 )
-            oFirstEnum.ProcessLine(
-                NULL, panThisLineVal, NULL, panThisLineId, nXSize );
-        else
-            oFirstEnum.ProcessLine(
-                panLastLineVal, panThisLineVal,
-                panLastLineId,  panThisLineId,
-                nXSize );
+    psStrip->nBorder = 0;
+    for( int iPoly = 0; iPoly < nPolygons; iPoly++ )
+    {
+        if( psStrip->anBorder[iPoly] == 0 )
+            psStrip->anBorder[iPoly] = psStrip->nBorder++;
+    }
+}
 
-/* -------------------------------------------------------------------- */
-/*      Accumulate polygon sizes.                                       */
-/* -------------------------------------------------------------------- */
-        if( oFirstEnum.nNextPolygonId > (int) anPolySizes.size() )
-            anPolySizes.resize( oFirstEnum.nNextPolygonId );
+/************************************************************************/
+/*                          GDALSieveRefSize()                          */
+/************************************************************************/
 
-        for( iX = 0; iX < nXSize; iX++ )
-        {
-            iPoly = panThisLineId[iX];
+static inline int GDALSieveRefSize( const GDALSieveStrip *psStrip, int nRef )
+
+{
+    if( nRef >= 0 )
+        return psStrip->anSize[nRef];
+    return psStrip->anSlotSize[SIEVE_SLOT(nRef)];
+}
+
+/************************************************************************/
+/*                      GDALSieveUpdateNeighbour()                      */
+/*                                                                      */
+/*      Update the biggest neighbour of a polygon if the other is       */
+/*      larger than its current largest neighbour.                      */
+/************************************************************************/
+
+static inline void GDALSieveUpdateNeighbour( GDALSieveStrip *psStrip,
+                                             int nRef, int nOtherRef,
+                                             int nOtherSize )
 
-            if( iPoly >= 0 && anPolySizes[iPoly] < MY_MAX_INT )
-                anPolySizes[iPoly] += 1;
+{
+    if( nRef >= 0 )
+    {
+        if( psStrip->anBigNeighbour[nRef] == -1
+            || psStrip->anBigNeighbourSize[nRef] < nOtherSize )
+        {
+            psStrip->anBigNeighbour[nRef] = nOtherRef;
+            psStrip->anBigNeighbourSize[nRef] = nOtherSize;
         }
+    }
+    else if( psStrip->nPass == 2 )
+    {
+        // The third pass only needs the neighbours of local polygons.
+        const int nSlot = SIEVE_SLOT(nRef);
+        if( psStrip->anSlotBigNeighbour[nSlot] == -1
+            || psStrip->anSlotBigNeighbourSize[nSlot] < nOtherSize )
+        {
+            psStrip->anSlotBigNeighbour[nSlot] = nOtherRef;
+            psStrip->anSlotBigNeighbourSize[nSlot] = nOtherSize;
+        }
+    }
+}
 
-/* -------------------------------------------------------------------- */
-/*      swap this/last lines.                                           */
-/* -------------------------------------------------------------------- */
-        GInt32 *panTmp = panLastLineVal;
-        panLastLineVal = panThisLineVal;
-        panThisLineVal = panTmp;
+/************************************************************************/
+/*                         GDALSieveCompare()                           */
+/************************************************************************/
+
+static inline void GDALSieveCompare( GDALSieveStrip *psStrip,
+                                     int nRef1, int nRef2 )
 
-        panTmp = panThisLineId;
-        panThisLineId = panLastLineId;
-        panLastLineId = panTmp;
+{
+    // nodata polygon do not need neighbours, and cannot be neighbours
+    // to valid polygons.
+    if( nRef1 == -1 || nRef2 == -1 || nRef1 == nRef2 )
+        return;
+
+    // The largest neighbour of polygons larger than the threshold is
+    // never used.
+    const int nSize1 = GDALSieveRefSize( psStrip, nRef1 );
+    const int nSize2 = GDALSieveRefSize( psStrip, nRef2 );
+    if( nSize1 < psStrip->nSizeThreshold )
+        GDALSieveUpdateNeighbour( psStrip, nRef1, nRef2, nSize2 );
+    if( nSize2 < psStrip->nSizeThreshold )
+        GDALSieveUpdateNeighbour( psStrip, nRef2, nRef1, nSize1 );
+}
+
+/************************************************************************/
+/*                     GDALSieveFindBigNeighbours()                     */
+/*                                                                      */
+/*      Scan the strip in the same order as a whole raster scan, so     */
+/*      that ties between neighbours of the same size are broken the    */
+/*      same way whatever the strip boundaries.                         */
+/************************************************************************/
+
+static void GDALSieveFindBigNeighbours( GDALSieveStrip *psStrip )
+
+{
+    const int nXSize = psStrip->nXSize;
+    const bool b8Connected = psStrip->nConnectedness == 8;
 
 /* -------------------------------------------------------------------- */
-/*      Report progress, and support interrupts.                        */
+/*      Build the table of the global polygons of the strip and of      */
+/*      the last line of the previous strip.                            */
 /* -------------------------------------------------------------------- */
-        if( eErr == CE_None
-            && !pfnProgress( 0.25 * ((iY+1) / (double) nYSize),
-                             "", pProgressArg ) )
+    std::vector<int> &anSlotGlobalId = psStrip->anSlotGlobalId;
+    anSlotGlobalId.resize( 0 );
+    for( int iPoly = 0; iPoly < psStrip->nPolygons; iPoly++ )
+    {
+        if( psStrip->anBorder[iPoly] >= 0 )
+            anSlotGlobalId.push_back( psStrip->panGlobalRoot[
+                psStrip->nGlobalBase + psStrip->anBorder[iPoly]] );
+    }
+    if( psStrip->bTopSeam )
+    {
+        for( int iX = 0; iX < nXSize; iX++ )
         {
-            CPLError( CE_Failure, CPLE_UserInterrupt, "User terminated" );
-            eErr = CE_Failure;
+            if( psStrip->panPrevGlobal[iX] >= 0 &&
+                (iX == 0 ||
+                 psStrip->panPrevGlobal[iX] != psStrip->panPrevGlobal[iX-1]) )
+                anSlotGlobalId.push_back( psStrip->panPrevGlobal[iX] );
         }
     }
+    std::sort( anSlotGlobalId.begin(), anSlotGlobalId.end() );
+    anSlotGlobalId.erase( std::unique( anSlotGlobalId.begin(),
+                                       anSlotGlobalId.end() ),
+                          anSlotGlobalId.end() );
+
+    const size_t nSlots = anSlotGlobalId.size();
+    psStrip->anSlotSize.resize( nSlots );
+    for( size_t iSlot = 0; iSlot < nSlots; iSlot++ )
+        psStrip->anSlotSize[iSlot] =
+            psStrip->panGlobalSize[anSlotGlobalId[iSlot]];
+    psStrip->anSlotBigNeighbour.assign( nSlots, -1 );
+    psStrip->anSlotBigNeighbourSize.assign( nSlots, 0 );
 
 /* -------------------------------------------------------------------- */
-/*      Make a pass through the maps, ensuring every polygon id         */
-/*      points to the final id it should use, not an intermediate       */
-/*      value.                                                          */
+/*      Reference of each local polygon.                                */
 /* -------------------------------------------------------------------- */
-    oFirstEnum.CompleteMerges();
+    std::vector<int> anRef( psStrip->nPolygons );
+    for( int iPoly = 0; iPoly < psStrip->nPolygons; iPoly++ )
+    {
+        if( psStrip->anBorder[iPoly] >= 0 )
+        {
+            const int nId = psStrip->panGlobalRoot[
+                psStrip->nGlobalBase + psStrip->anBorder[iPoly]];
+            anRef[iPoly] = SIEVE_SLOT_REF( static_cast<int>(
+                std::lower_bound( anSlotGlobalId.begin(),
+                                  anSlotGlobalId.end(), nId ) -
+                anSlotGlobalId.begin()) );
+        }
+        else
+            anRef[iPoly] = iPoly;
+    }
 
-/* -------------------------------------------------------------------- */
-/*      Push the sizes of merged polygon fragments into the             */
-/*      merged polygon id's count.                                      */
-/* -------------------------------------------------------------------- */
-    for( iPoly = 0; iPoly < oFirstEnum.nNextPolygonId; iPoly++ )
+    psStrip->anBigNeighbour.assign( psStrip->nPolygons, -1 );
+    psStrip->anBigNeighbourSize.assign( psStrip->nPolygons, 0 );
+
+    std::vector<int> anLastRef( nXSize, -1 );
+    std::vector<int> anThisRef( nXSize, -1 );
+
+    if( psStrip->bTopSeam )
     {
-        if( oFirstEnum.panPolyIdMap[iPoly] != iPoly )
+        for( int iX = 0; iX < nXSize; iX++ )
         {
-            GIntBig nSize = anPolySizes[oFirstEnum.panPolyIdMap[iPoly]];
+            const int nId = psStrip->panPrevGlobal[iX];
+            if( nId < 0 )
+                anLastRef[iX] = -1;
+            else if( iX > 0 && nId == psStrip->panPrevGlobal[iX-1] )
+                anLastRef[iX] = anLastRef[iX-1];
+            else
+                anLastRef[iX] = SIEVE_SLOT_REF( static_cast<int>(
+                    std::lower_bound( anSlotGlobalId.begin(),
+                                      anSlotGlobalId.end(), nId ) -
+                    anSlotGlobalId.begin()) );
+        }
+    }
 
-            nSize += anPolySizes[iPoly];
+    for( int iY = 0; iY < psStrip->nLines; iY++ )
+    {
+        const GInt32 *panThisLabel =
+            psStrip->panLabel + static_cast<size_t>(iY) * nXSize;
+        for( int iX = 0; iX < nXSize; iX++ )
+            anThisRef[iX] = panThisLabel[iX] < 0 ? -1 :
+                                                anRef[panThisLabel[iX]];
+
+        const bool bHasLast = iY > 0 || psStrip->bTopSeam;
+        for( int iX = 0; iX < nXSize; iX++ )
+        {
+            if( bHasLast )
+            {
+                GDALSieveCompare( psStrip, anThisRef[iX], anLastRef[iX] );
 
-            if( nSize > MY_MAX_INT )
-                nSize = MY_MAX_INT;
+                if( iX > 0 && b8Connected )
+                    GDALSieveCompare( psStrip, anThisRef[iX],
+                                      anLastRef[iX-1] );
+
+                if( iX < nXSize-1 && b8Connected )
+                    GDALSieveCompare( psStrip, anThisRef[iX],
+                                      anLastRef[iX+1] );
+            }
 
-            anPolySizes[oFirstEnum.panPolyIdMap[iPoly]] = (int)nSize;
-            anPolySizes[iPoly] = 0;
+            if( iX > 0 )
+                GDALSieveCompare( psStrip, anThisRef[iX], anThisRef[iX-1] );
+
+            // We don't need to compare to next pixel or next line
+            // since they will be compared to us.
         }
+
+        anLastRef.swap( anThisRef );
+    }
+}
+
+/************************************************************************/
+/*                       GDALSieveFollowLocal()                         */
+/*                                                                      */
+/*      Return the outcome of merging into the polygon nRef.  Small     */
+/*      local polygons are followed through their biggest neighbour     */
+/*      until a polygon as large as the threshold is found, or a        */
+/*      global polygon is reached.                                      */
+/************************************************************************/
+
+static int GDALSieveFollowLocal( GDALSieveStrip *psStrip, int nRef,
+                                 GInt32 *pnValue )
+
+{
+    if( nRef == -1 )
+        return SIEVE_NONE;
+    if( nRef < -1 )
+    {
+        *pnValue = psStrip->anSlotGlobalId[SIEVE_SLOT(nRef)];
+        return SIEVE_GOTO;
+    }
+    if( psStrip->anSize[nRef] >= psStrip->nSizeThreshold )
+    {
+        *pnValue = psStrip->anValue[nRef];
+        return SIEVE_FINAL;
     }
 
 /* -------------------------------------------------------------------- */
-/*      We will use a new enumerator for the second pass primarily      */
-/*      so we can preserve the first pass map.                          */
+/*      Walk through the neighbours until a resolved polygon, or a      */
+/*      polygon large enough, is found.                                 */
 /* -------------------------------------------------------------------- */
-    GDALRasterPolygonEnumerator oSecondEnum( nConnectedness );
+    std::vector<int> &anPath = psStrip->anPath;
+    int nKind = SIEVE_FAIL;
+    GInt32 nValue = 0;
+    int iPoly = nRef;
+
+    anPath.resize( 0 );
 
-    std::vector<int> anBigNeighbour;
-    anBigNeighbour.resize( anPolySizes.size() );
+    while( true )
+    {
+        if( psStrip->abyState[iPoly] == SIEVE_DONE )
+        {
+            nKind = psStrip->anKind[iPoly];
+            nValue = psStrip->anResultValue[iPoly];
+            break;
+        }
+        // Check that we don't cycle on an already visited polygon
+        if( psStrip->abyState[iPoly] == SIEVE_IN_PROGRESS )
+        {
+            nKind = SIEVE_FAIL;
+            break;
+        }
+        psStrip->abyState[iPoly] = SIEVE_IN_PROGRESS;
+        anPath.push_back( iPoly );
 
-    for( iPoly = 0; iPoly < (int) anPolySizes.size(); iPoly++ )
-        anBigNeighbour[iPoly] = -1;
+        const int nNext = psStrip->anBigNeighbour[iPoly];
+        if( nNext == -1 )
+        {
+            nKind = SIEVE_FAIL;
+            break;
+        }
+        if( nNext < -1 )
+        {
+            nKind = SIEVE_GOTO;
+            nValue = psStrip->anSlotGlobalId[SIEVE_SLOT(nNext)];
+            break;
+        }
+        // If the biggest neighbour is larger than the threshold
+        // then we are golden.
+        if( psStrip->anSize[nNext] >= psStrip->nSizeThreshold )
+        {
+            nKind = SIEVE_FINAL;
+            nValue = psStrip->anValue[nNext];
+            break;
+        }
+        iPoly = nNext;
+    }
 
-/* ==================================================================== */
-/*      Second pass ... identify the largest neighbour for each         */
-/*      polygon.                                                        */
-/* ==================================================================== */
-    for( iY = 0; eErr == CE_None && iY < nYSize; iY++ )
+    for( size_t i = 0; i < anPath.size(); i++ )
     {
-/* -------------------------------------------------------------------- */
-/*      Read the image data.                                            */
-/* -------------------------------------------------------------------- */
-        eErr = GDALRasterIO( hSrcBand, GF_Read, 0, iY, nXSize, 1,
-                             panThisLineVal, nXSize, 1, GDT_Int32, 0, 0 );
+        psStrip->abyState[anPath[i]] = SIEVE_DONE;
+        psStrip->anKind[anPath[i]] = nKind;
+        psStrip->anResultValue[anPath[i]] = nValue;
+    }
 
-        if( eErr == CE_None && hMaskBand != NULL )
-            eErr = GPMaskImageData( hMaskBand, pabyMaskLine, iY, nXSize, panThisLineVal );
+    *pnValue = nValue;
+    return nKind;
+}
 
-        if( eErr != CE_None )
-            continue;
+/************************************************************************/
+/*                           GDALSieveJob()                             */
+/************************************************************************/
+
+static void GDALSieveJob( void *pData )
+
+{
+    GDALSieveStrip *psStrip = static_cast<GDALSieveStrip *>(pData);
+
+    GDALSieveLabelStrip( psStrip );
+
+    if( psStrip->nPass == 1 )
+        return;
+
+    GDALSieveFindBigNeighbours( psStrip );
+
+    psStrip->abyState.assign( psStrip->nPolygons, SIEVE_UNKNOWN );
+    psStrip->anKind.assign( psStrip->nPolygons, SIEVE_NONE );
+    psStrip->anResultValue.assign( psStrip->nPolygons, 0 );
 
 /* -------------------------------------------------------------------- */
-/*      Determine what polygon the various pixels belong to (redoing    */
-/*      the same thing done in the first pass above).                   */
+/*      Second pass: collect the outcome of the biggest neighbour of    */
+/*      the global polygons seen in this strip.                         */
 /* -------------------------------------------------------------------- */
-        if( iY == 0 )
-            oSecondEnum.ProcessLine(
-                NULL, panThisLineVal, NULL, panThisLineId, nXSize );
-        else
-            oSecondEnum.ProcessLine(
-                panLastLineVal, panThisLineVal,
-                panLastLineId,  panThisLineId,
-                nXSize );
+    if( psStrip->nPass == 2 )
+    {
+        psStrip->asCandidates.resize( 0 );
+        for( size_t iSlot = 0; iSlot < psStrip->anSlotGlobalId.size();
+             iSlot++ )
+        {
+            if( psStrip->anSlotBigNeighbour[iSlot] == -1 )
+                continue;
+
+            GDALSieveCandidate sCandidate;
+            sCandidate.nGlobalId = psStrip->anSlotGlobalId[iSlot];
+            sCandidate.nSize = psStrip->anSlotBigNeighbourSize[iSlot];
+            sCandidate.nValue = 0;
+            sCandidate.nKind = GDALSieveFollowLocal(
+                psStrip, psStrip->anSlotBigNeighbour[iSlot],
+                &sCandidate.nValue );
+            psStrip->asCandidates.push_back( sCandidate );
+        }
+        return;
+    }
 
 /* -------------------------------------------------------------------- */
-/*      Check our neighbours, and update our biggest neighbour map      */
-/*      as appropriate.                                                 */
+/*      Third pass: compute the new value of each polygon, and remap    */
+/*      the pixel values.                                               */
 /* -------------------------------------------------------------------- */
-        for( iX = 0; iX < nXSize; iX++ )
+    psStrip->nSieveTargets = 0;
+    psStrip->nIsolatedSmall = 0;
+    psStrip->nFailedMerges = 0;
+
+    std::vector<GByte> abyChanged( psStrip->nPolygons, 0 );
+    std::vector<GInt32> anNewValue( psStrip->nPolygons, 0 );
+
+    for( int iPoly = 0; iPoly < psStrip->nPolygons; iPoly++ )
+    {
+        int nKind;
+        GInt32 nValue = 0;
+
+        if( psStrip->anBorder[iPoly] >= 0 )
         {
-            if( iY > 0 )
+            // Global polygons have been resolved beforehand.
+            const int nId = psStrip->panGlobalRoot[
+                psStrip->nGlobalBase + psStrip->anBorder[iPoly]];
+            if( psStrip->panGlobalKind[nId] == SIEVE_FINAL )
             {
-                CompareNeighbour( panThisLineId[iX],
-                                  panLastLineId[iX],
-                                  oFirstEnum.panPolyIdMap,
-                                  oFirstEnum.panPolyValue,
-                                  anPolySizes, anBigNeighbour );
-
-                if( iX > 0 && nConnectedness == 8 )
-                    CompareNeighbour( panThisLineId[iX],
-                                      panLastLineId[iX-1],
-                                      oFirstEnum.panPolyIdMap,
-                                      oFirstEnum.panPolyValue,
-                                      anPolySizes, anBigNeighbour );
-
-                if( iX < nXSize-1 && nConnectedness == 8 )
-                    CompareNeighbour( panThisLineId[iX],
-                                      panLastLineId[iX+1],
-                                      oFirstEnum.panPolyIdMap,
-                                      oFirstEnum.panPolyValue,
-                                      anPolySizes, anBigNeighbour );
+                abyChanged[iPoly] = 1;
+                anNewValue[iPoly] = psStrip->panGlobalResult[nId];
             }
+            continue;
+        }
 
-            if( iX > 0 )
-                CompareNeighbour( panThisLineId[iX],
-                                  panThisLineId[iX-1],
-                                  oFirstEnum.panPolyIdMap,
-                                  oFirstEnum.panPolyValue,
-                                  anPolySizes, anBigNeighbour );
+        // Don't try to merge polygons larger than the threshold.
+        if( psStrip->anSize[iPoly] >= psStrip->nSizeThreshold )
+            continue;
 
-            // We don't need to compare to next pixel or next line
-            // since they will be compared to us.
-        }
+        psStrip->nSieveTargets++;
 
-/* -------------------------------------------------------------------- */
-/*      Swap pixel value, and polygon id lines to be ready for the      */
-/*      next line.                                                      */
-/* -------------------------------------------------------------------- */
-        GInt32 *panTmp = panLastLineVal;
-        panLastLineVal = panThisLineVal;
-        panThisLineVal = panTmp;
+        // if we have no neighbours but we are small, what shall we do?
+        if( psStrip->anBigNeighbour[iPoly] == -1 )
+        {
+            psStrip->nIsolatedSmall++;
+            continue;
+        }
 
-        panTmp = panThisLineId;
-        panThisLineId = panLastLineId;
-        panLastLineId = panTmp;
+        nKind = GDALSieveFollowLocal( psStrip, iPoly, &nValue );
+        if( nKind == SIEVE_GOTO )
+        {
+            const int nId = nValue;
+            if( psStrip->panGlobalSize[nId] >= psStrip->nSizeThreshold )
+            {
+                nKind = SIEVE_FINAL;
+                nValue = psStrip->panGlobalValue[nId];
+            }
+            else
+            {
+                nKind = psStrip->panGlobalKind[nId];
+                nValue = psStrip->panGlobalResult[nId];
+            }
+        }
 
-/* -------------------------------------------------------------------- */
-/*      Report progress, and support interrupts.                        */
-/* -------------------------------------------------------------------- */
-        if( eErr == CE_None
-            && !pfnProgress( 0.25 + 0.25 * ((iY+1) / (double) nYSize),
-                             "", pProgressArg ) )
+        if( nKind == SIEVE_FINAL )
         {
-            CPLError( CE_Failure, CPLE_UserInterrupt, "User terminated" );
-            eErr = CE_Failure;
+            abyChanged[iPoly] = 1;
+            anNewValue[iPoly] = nValue;
         }
+        else
+            psStrip->nFailedMerges++;
     }
 
-/* -------------------------------------------------------------------- */
-/*      If our biggest neighbour is still smaller than the              */
-/*      threshold, then try tracking to that polygons biggest           */
-/*      neighbour, and so forth.                                        */
-/* -------------------------------------------------------------------- */
-    int nFailedMerges = 0;
-    int nIsolatedSmall = 0;
-    int nSieveTargets = 0;
-
-    for( iPoly = 0; iPoly < (int) anPolySizes.size(); iPoly++ )
+    const size_t nPixels =
+        static_cast<size_t>(psStrip->nXSize) * psStrip->nLines;
+    for( size_t i = 0; i < nPixels; i++ )
     {
-        if( oFirstEnum.panPolyIdMap[iPoly] != iPoly )
-            continue;
+        const int iPoly = psStrip->panLabel[i];
+        if( iPoly >= 0 && abyChanged[iPoly] )
+            psStrip->panOut[i] = anNewValue[iPoly];
+    }
+}
+
+/************************************************************************/
+/*                        GDALSieveReadStrip()                          */
+/*                                                                      */
+/*      Read the lines of a strip, and the last line of the previous    */
+/*      strip.                                                          */
+/************************************************************************/
+
+static CPLErr GDALSieveReadStrip( GDALRasterBandH hSrcBand,
+                                  GDALRasterBandH hMaskBand,
+                                  GByte *pabyMaskLine, int nYOff,
+                                  GDALSieveStrip *psStrip )
+
+{
+    const int nXSize = psStrip->nXSize;
+    const int nFirstLine = psStrip->bTopSeam ? nYOff - 1 : nYOff;
+    const int nReadLines = psStrip->nLines + (psStrip->bTopSeam ? 1 : 0);
+    GInt32 *panBuffer = psStrip->bTopSeam ? psStrip->panVal :
+                                            psStrip->panVal + nXSize;
 
-        // Ignore nodata polygons.
-        if( oFirstEnum.panPolyValue[iPoly] == GP_NODATA_MARKER )
+    CPLErr eErr = GDALRasterIO( hSrcBand, GF_Read, 0, nFirstLine,
+                                nXSize, nReadLines, panBuffer,
+                                nXSize, nReadLines, GDT_Int32, 0, 0 );
+
+    if( eErr == CE_None && psStrip->nPass == 3 )
+        memcpy( psStrip->panOut, psStrip->panVal + nXSize,
+                sizeof(GInt32) * nXSize * psStrip->nLines );
+
+    if( eErr == CE_None && hMaskBand != NULL )
+        eErr = GPMaskImageData( hMaskBand, pabyMaskLine, nFirstLine, nXSize,
+                                nReadLines, panBuffer );
+
+    return eErr;
+}
+
+/************************************************************************/
+/*                       GDALSieveResolveGlobal()                       */
+/*                                                                      */
+/*      Walk the biggest neighbours of the small global polygons.  On   */
+/*      input panKind and panResult hold the outcome of the biggest     */
+/*      neighbour of each polygon.  On output they hold SIEVE_FINAL     */
+/*      and the value to assign to the polygon, SIEVE_FAIL if it        */
+/*      cannot be merged, or SIEVE_NONE for large polygons.             */
+/************************************************************************/
+
+static void GDALSieveResolveGlobal( int nGlobal, int nSizeThreshold,
+                                    const std::vector<int> &anRoot,
+                                    const std::vector<int> &anSize,
+                                    const std::vector<GInt32> &anValue,
+                                    const std::vector<int> &anBigNeighbourSize,
+                                    std::vector<int> &anKind,
+                                    std::vector<GInt32> &anResult,
+                                    int *pnSieveTargets, int *pnIsolatedSmall,
+                                    int *pnFailedMerges )
+
+{
+    std::vector<GByte> abyState( nGlobal, SIEVE_UNKNOWN );
+    std::vector<int> anPath;
+
+    for( int iPoly = 0; iPoly < nGlobal; iPoly++ )
+    {
+        if( anRoot[iPoly] != iPoly )
             continue;
 
         // Don't try to merge polygons larger than the threshold.
-        if( anPolySizes[iPoly] >= nSizeThreshold )
+        if( anSize[iPoly] >= nSizeThreshold )
         {
-            anBigNeighbour[iPoly] = -1;
+            anKind[iPoly] = SIEVE_NONE;
             continue;
         }
 
-        nSieveTargets++;
+        (*pnSieveTargets)++;
 
         // if we have no neighbours but we are small, what shall we do?
-        if( anBigNeighbour[iPoly] == -1 )
+        if( anBigNeighbourSize[iPoly] < 0 )
         {
-            nIsolatedSmall++;
+            (*pnIsolatedSmall)++;
+            anKind[iPoly] = SIEVE_FAIL;
+            abyState[iPoly] = SIEVE_DONE;
             continue;
         }
 
-        std::set<int> oSetVisitedPoly;
-        oSetVisitedPoly.insert(iPoly);
-
         // Walk through our neighbours until we find a polygon large enough
-        int iFinalId = iPoly;
-        bool bFoundBigEnoughPoly = false;
-        while(true)
+        int nKind = SIEVE_FAIL;
+        GInt32 nValue = 0;
+        int iCur = iPoly;
+        anPath.resize( 0 );
+        while( true )
         {
-            iFinalId = anBigNeighbour[iFinalId];
-            if( iFinalId < 0 )
+            if( abyState[iCur] == SIEVE_DONE )
             {
+                nKind = anKind[iCur];
+                nValue = anResult[iCur];
                 break;
             }
+            // Check that we don't cycle on an already visited polygon
+            if( abyState[iCur] == SIEVE_IN_PROGRESS )
+            {
+                nKind = SIEVE_FAIL;
+                break;
+            }
+            abyState[iCur] = SIEVE_IN_PROGRESS;
+            anPath.push_back( iCur );
+
+            if( anKind[iCur] != SIEVE_FINAL && anKind[iCur] != SIEVE_GOTO )
+            {
+                nKind = SIEVE_FAIL;
+                break;
+            }
+            if( anKind[iCur] == SIEVE_FINAL )
+            {
+                nKind = SIEVE_FINAL;
+                nValue = anResult[iCur];
+                break;
+            }
+            const int iNext = anResult[iCur];
             // If the biggest neighbour is larger than the threshold
             // then we are golden.
-            if( anPolySizes[iFinalId] >= nSizeThreshold )
+            if( anSize[iNext] >= nSizeThreshold )
             {
-                bFoundBigEnoughPoly = true;
+                nKind = SIEVE_FINAL;
+                nValue = anValue[iNext];
                 break;
             }
-            // Check that we don't cycle on an already visited polygon
-            if( oSetVisitedPoly.find(iFinalId) != oSetVisitedPoly.end() )
-                break;
-            oSetVisitedPoly.insert(iFinalId);
+            iCur = iNext;
         }
 
-        if( !bFoundBigEnoughPoly )
+        // Map the whole intermediate chain to it
+        for( size_t i = 0; i < anPath.size(); i++ )
         {
-            nFailedMerges++;
-            anBigNeighbour[iPoly] = -1;
-            continue;
+            abyState[anPath[i]] = SIEVE_DONE;
+            anKind[anPath[i]] = nKind;
+            anResult[anPath[i]] = nValue;
         }
 
-        // Map the whole intermediate chain to it
-        int iPolyCur = iPoly;
-        while( anBigNeighbour[iPolyCur] != iFinalId )
+        if( nKind != SIEVE_FINAL )
+            (*pnFailedMerges)++;
+    }
+}
+
+/************************************************************************/
+/*                          GDALSieveFilter()                           */
+/************************************************************************/
+
+/**
+ * Removes small raster polygons.
+ *
+ * The function removes raster polygons smaller than a provided
+ * threshold size (in pixels) and replaces replaces them with the pixel value
+ * of the largest neighbour polygon.
+ *
+ * Polygon are determined (per GDALRasterPolygonEnumerator) as regions of
+ * the raster where the pixels all have the same value, and that are contiguous
+ * (connected).
+ *
+ * Pixels determined to be "nodata" per hMaskBand will not be treated as part
+ * of a polygon regardless of their pixel values.  Nodata areas will never be
+ * changed nor affect polygon sizes.
+ *
+ * Polygons smaller than the threshold with no neighbours that are as large
+ * as the threshold will not be altered.  Polygons surrounded by nodata areas
+ * will therefore not be altered.
+ *
+ * The algorithm makes three passes over the input file, by strips of lines
+ * (about one million pixels each, and at least 128 lines).  Polygons are labelled within each
+ * strip, and only the polygons touching the boundary between two strips
+ * are kept in memory from one strip to the next (roughly 32 bytes per
+ * polygon).  So memory use is bounded by the size of a strip and the number
+ * of polygons crossing strip boundaries, whatever the number of polygons in
+ * the raster.
+ *
+ * Starting with GDAL 2.2, the strips can be labelled in parallel by setting
+ * the NUM_THREADS option, or the GDAL_NUM_THREADS configuration option, to
+ * a number of threads or ALL_CPUS.  The result does not depend on the number
+ * of threads.
+ *
+ * @param hSrcBand the source raster band to be processed.
+ * @param hMaskBand an optional mask band.  All pixels in the mask band with a
+ * value other than zero will be considered suitable for inclusion in polygons.
+ * @param hDstBand the output raster band.  It may be the same as hSrcBand
+ * to update the source in place.
+ * @param nSizeThreshold raster polygons with sizes smaller than this will
+ * be merged into their largest neighbour.
+ * @param nConnectedness either 4 indicating that diagonal pixels are not
+ * considered directly adjacent for polygon membership purposes or 8
+ * indicating they are.
+ * @param papszOptions algorithm options in name=value list form.
+ * NUM_THREADS=number_of_threads or ALL_CPUS (GDAL >= 2.2).
+ * @param pfnProgress callback for reporting algorithm progress matching the
+ * GDALProgressFunc() semantics.  May be NULL.
+ * @param pProgressArg callback argument passed to pfnProgress.
+ *
+ * @return CE_None on success or CE_Failure if an error occurs.
+ */
+
+CPLErr CPL_STDCALL
+GDALSieveFilter( GDALRasterBandH hSrcBand, GDALRasterBandH hMaskBand,
+                 GDALRasterBandH hDstBand,
+                 int nSizeThreshold, int nConnectedness,
+                 char **papszOptions,
+                 GDALProgressFunc pfnProgress,
+                 void * pProgressArg )
+{
+    VALIDATE_POINTER1( hSrcBand, "GDALSieveFilter", CE_Failure );
+    VALIDATE_POINTER1( hDstBand, "GDALSieveFilter", CE_Failure );
+
+    if( pfnProgress == NULL )
+        pfnProgress = GDALDummyProgress;
+
+    const int nXSize = GDALGetRasterBandXSize( hSrcBand );
+    const int nYSize = GDALGetRasterBandYSize( hSrcBand );
+
+/* -------------------------------------------------------------------- */
+/*      Split the raster in strips of lines.                            */
+/* -------------------------------------------------------------------- */
+    int nStripLines =
+        MAX(SIEVE_MIN_STRIP_LINES, SIEVE_STRIP_PIXELS / MAX(1, nXSize));
+    const char *pszStripLines =
+        CPLGetConfigOption( "GDAL_SIEVE_STRIP_LINES", NULL );
+    if( pszStripLines != NULL )
+        nStripLines = MAX(1, atoi(pszStripLines));
+    nStripLines = MIN(nStripLines, nYSize);
+    const int nStrips =
+        nStripLines > 0 ? (nYSize + nStripLines - 1) / nStripLines : 0;
+
+/* -------------------------------------------------------------------- */
+/*      Set up the thread pool.                                         */
+/* -------------------------------------------------------------------- */
+    const int nThreads = CPLGetNumThreads( papszOptions, "1" );
+
+    const int nBatch = MAX(1, MIN(nThreads, nStrips));
+    CPLWorkerThreadPool *poThreadPool = NULL;
+    if( nBatch > 1 )
+    {
+        poThreadPool = new CPLWorkerThreadPool();
+        if( !poThreadPool->Setup( nBatch, NULL, NULL ) )
         {
-            int iNextPoly = anBigNeighbour[iPolyCur];
-            anBigNeighbour[iPolyCur] = iFinalId;
-            iPolyCur = iNextPoly;
+            delete poThreadPool;
+            poThreadPool = NULL;
         }
     }
 
-    CPLDebug( "GDALSieveFilter",
-              "Small Polygons: %d, Isolated: %d, Unmergable: %d",
-              nSieveTargets, nIsolatedSmall, nFailedMerges );
+/* -------------------------------------------------------------------- */
+/*      Allocate working buffers.                                       */
+/* -------------------------------------------------------------------- */
+    CPLErr eErr = CE_None;
+    std::vector<GDALSieveStrip> asStrips( nBatch );
+    std::vector<int> anPrevGlobal( static_cast<size_t>(nBatch) * nXSize );
+    GByte *pabyMaskLine = (hMaskBand != NULL) ?
+        (GByte *) VSI_MALLOC3_VERBOSE(nXSize, nStripLines + 1, 1) : NULL;
+    if( hMaskBand != NULL && pabyMaskLine == NULL )
+        eErr = CE_Failure;
+
+    for( int iJob = 0; iJob < nBatch; iJob++ )
+    {
+        GDALSieveStrip *psStrip = &asStrips[iJob];
+        psStrip->nXSize = nXSize;
+        psStrip->nConnectedness = nConnectedness;
+        psStrip->nSizeThreshold = nSizeThreshold;
+        psStrip->panVal = (GInt32 *)
+            VSI_MALLOC3_VERBOSE(sizeof(GInt32), nXSize, nStripLines + 1);
+        psStrip->panOut = (GInt32 *)
+            VSI_MALLOC3_VERBOSE(sizeof(GInt32), nXSize, nStripLines);
+        psStrip->panLabel = (GInt32 *)
+            VSI_MALLOC3_VERBOSE(sizeof(GInt32), nXSize, nStripLines);
+        psStrip->panPrevGlobal = &anPrevGlobal[0] +
+            static_cast<size_t>(iJob) * nXSize;
+        if( psStrip->panVal == NULL || psStrip->panOut == NULL ||
+            psStrip->panLabel == NULL )
+            eErr = CE_Failure;
+    }
 
-/* ==================================================================== */
-/*      Make a third pass over the image, actually applying the         */
-/*      merges.  We reuse the second enumerator but preserve the        */
-/*      "final maps" from the first.                                    */
-/* ==================================================================== */
-    oSecondEnum.Clear();
+/* -------------------------------------------------------------------- */
+/*      Global polygons, crossing the boundary between two strips.      */
+/* -------------------------------------------------------------------- */
+    int nGlobal = 0;
+    std::vector<int> anStripBase( nStrips );
+    std::vector< std::vector<int> > aanLastLineRuns( nStrips );
+    std::vector<int> anLastLineGlobal( nXSize, -1 );
+    std::vector<int> anGlobalRoot;
+    std::vector<GIntBig> anGlobalSize64;
+    std::vector<int> anGlobalSize;
+    std::vector<GInt32> anGlobalValue;
+    std::vector<int> anBigNeighbourSize;
+    std::vector<int> anGlobalKind;
+    std::vector<GInt32> anGlobalResult;
 
-    for( iY = 0; eErr == CE_None && iY < nYSize; iY++ )
+    int nSieveTargets = 0;
+    int nIsolatedSmall = 0;
+    int nFailedMerges = 0;
+
+    for( int nPass = 1; nPass <= 3 && eErr == CE_None; nPass++ )
     {
+        const double dfPassStart = nPass == 1 ? 0.0 : nPass == 2 ? 0.25 : 0.5;
+        const double dfPassRatio = nPass == 3 ? 0.5 : 0.25;
+
+        for( int iStrip = 0; iStrip < nStrips && eErr == CE_None;
+             iStrip += nBatch )
+        {
+            const int nJobs = MIN(nBatch, nStrips - iStrip);
+            std::vector<void *> apJobs;
+
 /* -------------------------------------------------------------------- */
-/*      Read the image data.                                            */
+/*      Read the strips of this batch.                                  */
 /* -------------------------------------------------------------------- */
-        eErr = GDALRasterIO( hSrcBand, GF_Read, 0, iY, nXSize, 1,
-                             panThisLineVal, nXSize, 1, GDT_Int32, 0, 0 );
+            for( int iJob = 0; iJob < nJobs && eErr == CE_None; iJob++ )
+            {
+                GDALSieveStrip *psStrip = &asStrips[iJob];
+                const int nYOff = (iStrip + iJob) * nStripLines;
+                psStrip->nPass = nPass;
+                psStrip->nLines = MIN(nStripLines, nYSize - nYOff);
+                psStrip->bTopSeam = nYOff > 0;
+                psStrip->bBottomSeam = nYOff + psStrip->nLines < nYSize;
 
-        memcpy( panThisLineWriteVal, panThisLineVal, 4 * nXSize );
+                eErr = GDALSieveReadStrip( hSrcBand, hMaskBand, pabyMaskLine,
+                                           nYOff, psStrip );
 
-        if( eErr == CE_None && hMaskBand != NULL )
-            eErr = GPMaskImageData( hMaskBand, pabyMaskLine, iY, nXSize, panThisLineVal );
+                if( nPass > 1 )
+                {
+                    psStrip->nGlobalBase = anStripBase[iStrip + iJob];
+
+                    // Global ids of the last line of the previous strip.
+                    if( psStrip->bTopSeam )
+                    {
+                        const std::vector<int> &anRuns =
+                            aanLastLineRuns[iStrip + iJob - 1];
+                        int *panPrev = &anPrevGlobal[0] +
+                            static_cast<size_t>(iJob) * nXSize;
+                        for( size_t i = 0; i < anRuns.size(); i += 2 )
+                        {
+                            const int nEnd = i + 2 < anRuns.size() ?
+                                anRuns[i+2] : nXSize;
+                            const int nId = anRuns[i+1] < 0 ? -1 :
+                                anGlobalRoot[anRuns[i+1]];
+                            for( int iX = anRuns[i]; iX < nEnd; iX++ )
+                                panPrev[iX] = nId;
+                        }
+
+                        // Last use of the runs of the previous strip.
+                        if( nPass == 3 )
+                        {
+                            std::vector<int>().swap(
+                                aanLastLineRuns[iStrip + iJob - 1] );
+                        }
+                    }
+                }
 
-        if( eErr != CE_None )
-            continue;
+                apJobs.push_back( psStrip );
+            }
+            if( eErr != CE_None )
+                break;
 
 /* -------------------------------------------------------------------- */
-/*      Determine what polygon the various pixels belong to (redoing    */
-/*      the same thing done in the first pass above).                   */
+/*      Label the strips.                                               */
 /* -------------------------------------------------------------------- */
-        if( iY == 0 )
-            oSecondEnum.ProcessLine(
-                NULL, panThisLineVal, NULL, panThisLineId, nXSize );
-        else
-            oSecondEnum.ProcessLine(
-                panLastLineVal, panThisLineVal,
-                panLastLineId,  panThisLineId,
-                nXSize );
+            // On failure, no job has been queued: run them here.
+            if( poThreadPool != NULL && nJobs > 1 &&
+                poThreadPool->SubmitJobs( GDALSieveJob, apJobs ) )
+            {
+                poThreadPool->WaitCompletion();
+            }
+            else
+            {
+                for( int iJob = 0; iJob < nJobs; iJob++ )
+                    GDALSieveJob( apJobs[iJob] );
+            }
 
 /* -------------------------------------------------------------------- */
-/*      Reprocess the actual pixel values according to the polygon      */
-/*      merging, and write out this line of image data.                 */
+/*      Collect the results in the strip order.                         */
 /* -------------------------------------------------------------------- */
-        for( iX = 0; iX < nXSize; iX++ )
-        {
-            int iThisPoly = panThisLineId[iX];
-            if( iThisPoly >= 0 )
+            for( int iJob = 0; iJob < nJobs && eErr == CE_None; iJob++ )
             {
-                iThisPoly = oFirstEnum.panPolyIdMap[iThisPoly];
+                GDALSieveStrip *psStrip = &asStrips[iJob];
+                const int nYOff = (iStrip + iJob) * nStripLines;
 
-                if( anBigNeighbour[iThisPoly] != -1 )
+                if( nPass == 1 )
                 {
-                    panThisLineWriteVal[iX] =
-                        oFirstEnum.panPolyValue[
-                            anBigNeighbour[iThisPoly]];
+                    if( psStrip->nBorder > MY_MAX_INT - 2 - nGlobal )
+                    {
+                        CPLError( CE_Failure, CPLE_AppDefined,
+                                  "Too many polygons" );
+                        eErr = CE_Failure;
+                        break;
+                    }
+
+                    // Register the global polygons of this strip.
+                    const int nBase = nGlobal;
+                    anStripBase[iStrip + iJob] = nBase;
+                    for( int iPoly = 0; iPoly < psStrip->nPolygons; iPoly++ )
+                    {
+                        if( psStrip->anBorder[iPoly] < 0 )
+                            continue;
+                        anGlobalRoot.push_back( nGlobal++ );
+                        anGlobalSize64.push_back( psStrip->anSize[iPoly] );
+                        anGlobalValue.push_back( psStrip->anValue[iPoly] );
+                    }
+
+                    // Merge the polygons of the first line with the ones
+                    // of the last line of the previous strip.
+                    if( psStrip->bTopSeam )
+                    {
+                        const GInt32 *panLastVal = psStrip->panVal;
+                        const GInt32 *panThisVal = psStrip->panVal + nXSize;
+                        for( int iX = 0; iX < nXSize; iX++ )
+                        {
+                            if( psStrip->panLabel[iX] < 0 )
+                                continue;
+                            for( int iDX = -1; iDX <= 1; iDX++ )
+                            {
+                                if( iDX != 0 && nConnectedness != 8 )
+                                    continue;
+                                if( iX + iDX < 0 || iX + iDX >= nXSize
+                                    || panLastVal[iX+iDX] != panThisVal[iX] )
+                                    continue;
+
+                                int nId1 = GDALSieveFind(
+                                    anGlobalRoot, nBase + psStrip->anBorder[
+                                                    psStrip->panLabel[iX]] );
+                                int nId2 = GDALSieveFind(
+                                    anGlobalRoot, anLastLineGlobal[iX+iDX] );
+                                if( nId1 == nId2 )
+                                    continue;
+                                if( nId2 < nId1 )
+                                    std::swap( nId1, nId2 );
+                                anGlobalRoot[nId2] = nId1;
+                                anGlobalSize64[nId1] += anGlobalSize64[nId2];
+                            }
+                        }
+                    }
+
+                    // Keep the global ids of the last line for the next
+                    // strip, and as runs for the next passes.
+                    if( psStrip->bBottomSeam )
+                    {
+                        const GInt32 *panLastLabel = psStrip->panLabel +
+                            static_cast<size_t>(psStrip->nLines - 1) * nXSize;
+                        std::vector<int> &anRuns =
+                            aanLastLineRuns[iStrip + iJob];
+                        for( int iX = 0; iX < nXSize; iX++ )
+                        {
+                            const int nId = panLastLabel[iX] < 0 ? -1 :
+                                nBase + psStrip->anBorder[panLastLabel[iX]];
+                            anLastLineGlobal[iX] = nId;
+                            if( iX == 0 || anRuns.back() != nId )
+                            {
+                                anRuns.push_back( iX );
+                                anRuns.push_back( nId );
+                            }
+                        }
+                    }
                 }
-            }
-        }
+                else if( nPass == 2 )
+                {
+                    // Keep the first largest neighbour in the scan order.
+                    for( size_t i = 0; i < psStrip->asCandidates.size(); i++ )
+                    {
+                        const GDALSieveCandidate &sCandidate =
+                            psStrip->asCandidates[i];
+                        const int nId = sCandidate.nGlobalId;
+                        if( anBigNeighbourSize[nId] < sCandidate.nSize )
+                        {
+                            anBigNeighbourSize[nId] = sCandidate.nSize;
+                            anGlobalKind[nId] = sCandidate.nKind;
+                            anGlobalResult[nId] = sCandidate.nValue;
+                        }
+                    }
+                    psStrip->asCandidates.clear();
+                }
+                else
+                {
+                    nSieveTargets += psStrip->nSieveTargets;
+                    nIsolatedSmall += psStrip->nIsolatedSmall;
+                    nFailedMerges += psStrip->nFailedMerges;
 
 /* -------------------------------------------------------------------- */
 /*      Write the update data out.                                      */
 /* -------------------------------------------------------------------- */
-        eErr = GDALRasterIO( hDstBand, GF_Write, 0, iY, nXSize, 1,
-                             panThisLineWriteVal, nXSize, 1, GDT_Int32, 0, 0 );
+                    eErr = GDALRasterIO( hDstBand, GF_Write, 0, nYOff,
+                                         nXSize, psStrip->nLines,
+                                         psStrip->panOut,
+                                         nXSize, psStrip->nLines,
+                                         GDT_Int32, 0, 0 );
+                }
+            }
+
+/* -------------------------------------------------------------------- */
+/*      Report progress, and support interrupts.                        */
+/* -------------------------------------------------------------------- */
+            const int nLinesDone = MIN(nYSize, (iStrip + nJobs) * nStripLines);
+            if( eErr == CE_None
+                && !pfnProgress( dfPassStart + dfPassRatio *
+                                    (nLinesDone / (double) nYSize),
+                                 "", pProgressArg ) )
+            {
+                CPLError( CE_Failure, CPLE_UserInterrupt, "User terminated" );
+                eErr = CE_Failure;
+            }
+        }
+
+        if( eErr != CE_None )
+            break;
 
 /* -------------------------------------------------------------------- */
-/*      Swap pixel value, and polygon id lines to be ready for the      */
-/*      next line.                                                      */
+/*      Make a pass through the global polygons, ensuring every id      */
+/*      points to its final id, and cap the merged sizes.               */
 /* -------------------------------------------------------------------- */
-        GInt32 *panTmp = panLastLineVal;
-        panLastLineVal = panThisLineVal;
-        panThisLineVal = panTmp;
+        if( nPass == 1 )
+        {
+            anGlobalSize.resize( nGlobal );
+            for( int iPoly = 0; iPoly < nGlobal; iPoly++ )
+            {
+                const int nRoot = GDALSieveFind( anGlobalRoot, iPoly );
+                anGlobalRoot[iPoly] = nRoot;
+                anGlobalSize[iPoly] = static_cast<int>(
+                    MIN(anGlobalSize64[nRoot], (GIntBig)MY_MAX_INT) );
+            }
+            std::vector<GIntBig>().swap( anGlobalSize64 );
+            anLastLineGlobal.clear();
 
-        panTmp = panThisLineId;
-        panThisLineId = panLastLineId;
-        panLastLineId = panTmp;
+            anBigNeighbourSize.resize( nGlobal, -1 );
+            anGlobalKind.resize( nGlobal, SIEVE_NONE );
+            anGlobalResult.resize( nGlobal, 0 );
+
+            for( int iJob = 0; iJob < nBatch; iJob++ )
+            {
+                GDALSieveStrip *psStrip = &asStrips[iJob];
+                psStrip->panGlobalRoot =
+                    nGlobal ? &anGlobalRoot[0] : NULL;
+                psStrip->panGlobalSize =
+                    nGlobal ? &anGlobalSize[0] : NULL;
+                psStrip->panGlobalValue =
+                    nGlobal ? &anGlobalValue[0] : NULL;
+                psStrip->panGlobalKind =
+                    nGlobal ? &anGlobalKind[0] : NULL;
+                psStrip->panGlobalResult =
+                    nGlobal ? &anGlobalResult[0] : NULL;
+            }
+        }
 
 /* -------------------------------------------------------------------- */
-/*      Report progress, and support interrupts.                        */
+/*      If our biggest neighbour is still smaller than the              */
+/*      threshold, then try tracking to that polygons biggest           */
+/*      neighbour, and so forth.                                        */
 /* -------------------------------------------------------------------- */
-        if( eErr == CE_None
-            && !pfnProgress( 0.5 + 0.5 * ((iY+1) / (double) nYSize),
-                             "", pProgressArg ) )
+        else if( nPass == 2 )
         {
-            CPLError( CE_Failure, CPLE_UserInterrupt, "User terminated" );
-            eErr = CE_Failure;
+            GDALSieveResolveGlobal( nGlobal, nSizeThreshold, anGlobalRoot,
+                                    anGlobalSize, anGlobalValue,
+                                    anBigNeighbourSize, anGlobalKind,
+                                    anGlobalResult, &nSieveTargets,
+                                    &nIsolatedSmall, &nFailedMerges );
         }
     }
 
+    if( eErr == CE_None )
+        CPLDebug( "GDALSieveFilter",
+                  "Small Polygons: %d, Isolated: %d, Unmergable: %d, "
+                  "Crossing strips: %d",
+                  nSieveTargets, nIsolatedSmall, nFailedMerges, nGlobal );
+
 /* -------------------------------------------------------------------- */
 /*      Cleanup                                                         */
 /* -------------------------------------------------------------------- */
-    CPLFree( panThisLineId );
-    CPLFree( panLastLineId );
-    CPLFree( panThisLineVal );
-    CPLFree( panLastLineVal );
-    CPLFree( panThisLineWriteVal );
+    delete poThreadPool;
+    for( int iJob = 0; iJob < nBatch; iJob++ )
+    {
+        CPLFree( asStrips[iJob].panVal );
+        CPLFree( asStrips[iJob].panOut );
+        CPLFree( asStrips[iJob].panLabel );
+    }
     CPLFree( pabyMaskLine );
 
     return eErr;
@@ -44,6 +44,7 @@ void *GDALDeserializeGCPTransformer( CPLXMLNode *psTree );
 void *GDALDeserializeTPSTransformer( CPLXMLNode *psTree );
 void *GDALDeserializeGeoLocTransformer( CPLXMLNode *psTree );
 void *GDALDeserializeRPCTransformer( CPLXMLNode *psTree );
+void *GDALDeserializeInterpGridTransformer( CPLXMLNode *psTree );
 CPL_C_END
 
 static CPLXMLNode *GDALSerializeReprojectionTransformer( void *pTransformArg );
@@ -849,6 +850,9 @@ typedef struct {
     void     *pSrcTPSTransformArg;
     void     *pSrcGeoLocTransformArg;
 
+    /* Interpolation grid of one of the above, which it then owns */
+    void     *pSrcGridTransformArg;
+
     void     *pReprojectArg;
 
     double   adfDstGeoTransform[6];
@@ -876,7 +880,9 @@ static void* GDALCreateSimilarGenImgProjTransformer( void *hTransformArg, double
 
     memcpy(psClonedInfo, psInfo, sizeof(GDALGenImgProjTransformInfo));
 
-    if( psClonedInfo->pSrcGCPTransformArg )
+    if( psClonedInfo->pSrcGridTransformArg )
+        psClonedInfo->pSrcGridTransformArg = GDALCreateSimilarTransformer( psInfo->pSrcGridTransformArg, dfRatioX, dfRatioY );
+    else if( psClonedInfo->pSrcGCPTransformArg )
         psClonedInfo->pSrcGCPTransformArg = GDALCreateSimilarTransformer( psInfo->pSrcGCPTransformArg, dfRatioX, dfRatioY );
     else if( psClonedInfo->pSrcRPCTransformArg )
         psClonedInfo->pSrcRPCTransformArg = GDALCreateSimilarTransformer( psInfo->pSrcRPCTransformArg, dfRatioX, dfRatioY );
@@ -1157,6 +1163,18 @@ static GDALGenImgProjTransformInfo* GDALCreateGenImgProjTransformerInternal()
  * <li> INSERT_CENTER_LONG: May be set to FALSE to disable setting up a
  * CENTER_LONG value on the coordinate system to rewrap things around the
  * center of the image.
+ * <li> SRC_GRID_STEP: (GDAL &gt;= 2.2) When the source dataset uses GCPs, RPCs
+ * or a geolocation array, interpolate its pixel/line to georeferenced
+ * transformation from a grid precomputed with nodes every SRC_GRID_STEP
+ * pixels. See GDALCreateInterpGridTransformer().
+ * <li> SRC_GRID_INTERPOLATION: (GDAL &gt;= 2.2) BILINEAR (default) or CUBIC.
+ * <li> SRC_GRID_MAX_ERROR: (GDAL &gt;= 2.2) Error targeted for the
+ * interpolation, in source pixels. Defaults to 0.125. Points in grid cells
+ * where it is exceeded at sample points are transformed exactly, so that it
+ * may still be slightly exceeded between them.
+ * <li> SRC_GRID_FILE: (GDAL &gt;= 2.2) File from which the grid is read if it
+ * was computed for the same source transformation and grid options, and to
+ * which it is written otherwise. Implies a grid, with a default step of 32.
  * </ul>
  *
  * @param hSrcDS source dataset, or NULL.
@@ -1350,6 +1368,74 @@ GDALCreateGenImgProjTransformer2( GDALDatasetH hSrcDS, GDALDatasetH hDstDS,
         return NULL;
     }
 
+/* -------------------------------------------------------------------- */
+/*      Optionally replace the source transformation by the             */
+/*      interpolation of a precomputed grid.                            */
+/* -------------------------------------------------------------------- */
+    if( hSrcDS != NULL &&
+        (CSLFetchNameValue( papszOptions, "SRC_GRID_STEP" ) != NULL ||
+         CSLFetchNameValue( papszOptions, "SRC_GRID_FILE" ) != NULL) )
+    {
+        GDALTransformerFunc pfnSrcTransformer = NULL;
+        void **ppSrcTransformArg = NULL;
+
+        if( psInfo->pSrcGCPTransformArg != NULL )
+        {
+            pfnSrcTransformer = GDALGCPTransform;
+            ppSrcTransformArg = &psInfo->pSrcGCPTransformArg;
+        }
+        else if( psInfo->pSrcTPSTransformArg != NULL )
+        {
+            pfnSrcTransformer = GDALTPSTransform;
+            ppSrcTransformArg = &psInfo->pSrcTPSTransformArg;
+        }
+        else if( psInfo->pSrcRPCTransformArg != NULL )
+        {
+            pfnSrcTransformer = GDALRPCTransform;
+            ppSrcTransformArg = &psInfo->pSrcRPCTransformArg;
+        }
+        else if( psInfo->pSrcGeoLocTransformArg != NULL )
+        {
+            pfnSrcTransformer = GDALGeoLocTransform;
+            ppSrcTransformArg = &psInfo->pSrcGeoLocTransformArg;
+        }
+
+        if( ppSrcTransformArg != NULL )
+        {
+            static const char * const apszGridOptions[][2] = {
+                { "SRC_GRID_STEP", "STEP" },
+                { "SRC_GRID_INTERPOLATION", "INTERPOLATION" },
+                { "SRC_GRID_MAX_ERROR", "MAX_ERROR" },
+                { "SRC_GRID_FILE", "GRID_FILE" } };
+            char **papszGridOptions = NULL;
+            for( size_t i = 0; i < CPL_ARRAYSIZE(apszGridOptions); i++ )
+            {
+                pszValue = CSLFetchNameValue( papszOptions,
+                                              apszGridOptions[i][0] );
+                if( pszValue != NULL )
+                    papszGridOptions = CSLSetNameValue( papszGridOptions,
+                                                        apszGridOptions[i][1],
+                                                        pszValue );
+            }
+
+            psInfo->pSrcGridTransformArg =
+                GDALCreateInterpGridTransformer( pfnSrcTransformer,
+                                                 *ppSrcTransformArg,
+                                                 GDALGetRasterXSize( hSrcDS ),
+                                                 GDALGetRasterYSize( hSrcDS ),
+                                                 papszGridOptions );
+            CSLDestroy( papszGridOptions );
+            if( psInfo->pSrcGridTransformArg == NULL )
+            {
+                GDALDestroyGenImgProjTransformer( psInfo );
+                return NULL;
+            }
+            GDALInterpGridTransformerOwnsSubtransformer(
+                psInfo->pSrcGridTransformArg, TRUE );
+            *ppSrcTransformArg = NULL;
+        }
+    }
+
 /* -------------------------------------------------------------------- */
 /*      Get forward and inverse geotransform for destination image.     */
 /*      If we have no destination use a unit transform.                 */
@@ -1697,6 +1783,9 @@ void GDALDestroyGenImgProjTransformer( void *hTransformArg )
     if( psInfo->pSrcGeoLocTransformArg != NULL )
         GDALDestroyGeoLocTransformer( psInfo->pSrcGeoLocTransformArg );
 
+    if( psInfo->pSrcGridTransformArg != NULL )
+        GDALDestroyInterpGridTransformer( psInfo->pSrcGridTransformArg );
+
     if( psInfo->pDstGCPTransformArg != NULL )
         GDALDestroyGCPTransformer( psInfo->pDstGCPTransformArg );
 
@@ -1742,6 +1831,7 @@ int GDALGenImgProjTransform( void *pTransformArg, int bDstToSrc,
     void *pRPCTransformArg;
     void *pTPSTransformArg;
     void *pGeoLocTransformArg;
+    void *pGridTransformArg;
 
 #ifdef DEBUG_APPROX_TRANSFORMER
     CPLAssert(nPointCount > 0);
@@ -1764,6 +1854,7 @@ int GDALGenImgProjTransform( void *pTransformArg, int bDstToSrc,
         pRPCTransformArg = psInfo->pDstRPCTransformArg;
         pTPSTransformArg = psInfo->pDstTPSTransformArg;
         pGeoLocTransformArg = NULL;
+        pGridTransformArg = NULL;
     }
     else
     {
@@ -1772,9 +1863,17 @@ int GDALGenImgProjTransform( void *pTransformArg, int bDstToSrc,
         pRPCTransformArg = psInfo->pSrcRPCTransformArg;
         pTPSTransformArg = psInfo->pSrcTPSTransformArg;
         pGeoLocTransformArg = psInfo->pSrcGeoLocTransformArg;
+        pGridTransformArg = psInfo->pSrcGridTransformArg;
     }
 
-    if( pGCPTransformArg != NULL )
+    if( pGridTransformArg != NULL )
+    {
+        if( !GDALInterpGridTransform( pGridTransformArg, FALSE,
+                                      nPointCount, padfX, padfY, padfZ,
+                                      panSuccess ) )
+            return FALSE;
+    }
+    else if( pGCPTransformArg != NULL )
     {
         if( !GDALGCPTransform( pGCPTransformArg, FALSE,
                                nPointCount, padfX, padfY, padfZ,
@@ -1847,6 +1946,7 @@ int GDALGenImgProjTransform( void *pTransformArg, int bDstToSrc,
         pRPCTransformArg = psInfo->pSrcRPCTransformArg;
         pTPSTransformArg = psInfo->pSrcTPSTransformArg;
         pGeoLocTransformArg = psInfo->pSrcGeoLocTransformArg;
+        pGridTransformArg = psInfo->pSrcGridTransformArg;
     }
     else
     {
@@ -1855,9 +1955,17 @@ int GDALGenImgProjTransform( void *pTransformArg, int bDstToSrc,
         pRPCTransformArg = psInfo->pDstRPCTransformArg;
         pTPSTransformArg = psInfo->pDstTPSTransformArg;
         pGeoLocTransformArg = NULL;
+        pGridTransformArg = NULL;
     }
 
-    if( pGCPTransformArg != NULL )
+    if( pGridTransformArg != NULL )
+    {
+        if( !GDALInterpGridTransform( pGridTransformArg, TRUE,
+                                      nPointCount, padfX, padfY, padfZ,
+                                      panSuccess ) )
+            return FALSE;
+    }
+    else if( pGCPTransformArg != NULL )
     {
         if( !GDALGCPTransform( pGCPTransformArg, TRUE,
                                nPointCount, padfX, padfY, padfZ,
@@ -1924,10 +2032,24 @@ GDALSerializeGenImgProjTransformer( void *pTransformArg )
 
     psTree = CPLCreateXMLNode( NULL, CXT_Element, "GenImgProjTransformer" );
 
+/* -------------------------------------------------------------------- */
+/*      Handle interpolation grid transformation.                       */
+/* -------------------------------------------------------------------- */
+    if( psInfo->pSrcGridTransformArg != NULL )
+    {
+        CPLXMLNode *psTransformerContainer
+            = CPLCreateXMLNode( psTree, CXT_Element, "SrcGridTransformer" );
+
+        CPLXMLNode *psTransformer
+            = GDALSerializeTransformer( NULL, psInfo->pSrcGridTransformArg);
+        if( psTransformer != NULL )
+            CPLAddXMLChild( psTransformerContainer, psTransformer );
+    }
+
 /* -------------------------------------------------------------------- */
 /*      Handle GCP transformation.                                      */
 /* -------------------------------------------------------------------- */
-    if( psInfo->pSrcGCPTransformArg != NULL )
+    else if( psInfo->pSrcGCPTransformArg != NULL )
     {
 
         CPLXMLNode *psTransformerContainer =
@@ -2186,6 +2308,16 @@ void *GDALDeserializeGenImgProjTransformer( CPLXMLNode *psTree )
             GDALDeserializeRPCTransformer( psSubtree->psChild );
     }
 
+/* -------------------------------------------------------------------- */
+/*      Src Grid Transform                                              */
+/* -------------------------------------------------------------------- */
+    psSubtree = CPLGetXMLNode( psTree, "SrcGridTransformer" );
+    if( psSubtree != NULL && psSubtree->psChild != NULL )
+    {
+        psInfo->pSrcGridTransformArg =
+            GDALDeserializeInterpGridTransformer( psSubtree->psChild );
+    }
+
 /* -------------------------------------------------------------------- */
 /*      Dst TPS Transform                                               */
 /* -------------------------------------------------------------------- */
@@ -3290,6 +3422,11 @@ CPLErr GDALDeserializeTransformer( CPLXMLNode *psTree,
         *ppfnFunc = GDALApproxTransform;
         *ppTransformArg = GDALDeserializeApproxTransformer( psTree );
     }
+    else if( EQUAL(psTree->pszValue,"InterpGridTransformer") )
+    {
+        *ppfnFunc = GDALInterpGridTransform;
+        *ppTransformArg = GDALDeserializeInterpGridTransformer( psTree );
+    }
     else
     {
         GDALTransformDeserializeFunc pfnDeserializeFunc = NULL;
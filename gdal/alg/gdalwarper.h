@@ -382,6 +382,8 @@ private:
     void           *psThreadData;
 
     void            WipeChunkList();
+    void            ComputePixelCostsInBits( int *pnSrcPixelCostInBits,
+                                             int *pnDstPixelCostInBits );
     CPLErr          CollectChunkList( int nDstXOff, int nDstYOff,
                                       int nDstXSize, int nDstYSize );
     void            ReportTiming( const char * );
@@ -398,6 +400,9 @@ public:
                                        int nDstXSize, int nDstYSize );
     CPLErr          ChunkAndWarpMulti( int nDstXOff, int nDstYOff,
                                        int nDstXSize, int nDstYSize );
+    CPLErr          ComputeRegionMemoryUse( int nDstXOff, int nDstYOff,
+                                            int nDstXSize, int nDstYSize,
+                                            double *pdfMemoryUse );
     CPLErr          WarpRegion( int nDstXOff, int nDstYOff,
                                 int nDstXSize, int nDstYSize,
                                 int nSrcXOff=0, int nSrcYOff=0,
@@ -996,46 +996,16 @@ void GDALWarpOperation::WipeChunkList()
 }
 
 /************************************************************************/
-/*                          CollectChunkList()                          */
+/*                      ComputePixelCostsInBits()                       */
+/*                                                                      */
+/*      Number of bits used by a source and by a destination pixel,     */
+/*      given the types of masks in use.                                */
 /************************************************************************/
 
-CPLErr GDALWarpOperation::CollectChunkList(
-    int nDstXOff, int nDstYOff,  int nDstXSize, int nDstYSize )
+void GDALWarpOperation::ComputePixelCostsInBits( int *pnSrcPixelCostInBits,
+                                                 int *pnDstPixelCostInBits )
 
 {
-/* -------------------------------------------------------------------- */
-/*      Compute the bounds of the input area corresponding to the       */
-/*      output area.                                                    */
-/* -------------------------------------------------------------------- */
-    int nSrcXOff, nSrcYOff, nSrcXSize, nSrcYSize;
-    int nSrcXExtraSize, nSrcYExtraSize;
-    double dfSrcFillRatio;
-    CPLErr eErr;
-
-    eErr = ComputeSourceWindow( nDstXOff, nDstYOff, nDstXSize, nDstYSize,
-                                &nSrcXOff, &nSrcYOff, &nSrcXSize, &nSrcYSize,
-                                &nSrcXExtraSize, &nSrcYExtraSize, &dfSrcFillRatio );
-
-    if( eErr != CE_None )
-    {
-        CPLError( CE_Warning, CPLE_AppDefined,
-                  "Unable to compute source region for output window %d,%d,%d,%d, skipping.",
-                  nDstXOff, nDstYOff, nDstXSize, nDstYSize );
-        return eErr;
-    }
-
-/* -------------------------------------------------------------------- */
-/*      If we are allowed to drop no-source regions, do so now if       */
-/*      appropriate.                                                    */
-/* -------------------------------------------------------------------- */
-    if( (nSrcXSize == 0 || nSrcYSize == 0)
-        && CSLFetchBoolean( psOptions->papszWarpOptions, "SKIP_NOSOURCE",0 ))
-        return CE_None;
-
-/* -------------------------------------------------------------------- */
-/*      Based on the types of masks in use, how many bits will each     */
-/*      source pixel cost us?                                           */
-/* -------------------------------------------------------------------- */
     int nSrcPixelCostInBits;
 
     nSrcPixelCostInBits =
@@ -1062,9 +1032,6 @@ CPLErr GDALWarpOperation::CollectChunkList(
     if( psOptions->pfnSrcValidityMaskFunc != NULL )
         nSrcPixelCostInBits += 1; /* bit mask */
 
-/* -------------------------------------------------------------------- */
-/*      What about the cost for the destination.                        */
-/* -------------------------------------------------------------------- */
     int nDstPixelCostInBits;
 
     nDstPixelCostInBits =
@@ -1081,6 +1048,108 @@ CPLErr GDALWarpOperation::CollectChunkList(
     if( psOptions->nDstAlphaBand > 0 )
         nDstPixelCostInBits += 32; /* DstDensity float mask */
 
+    *pnSrcPixelCostInBits = nSrcPixelCostInBits;
+    *pnDstPixelCostInBits = nDstPixelCostInBits;
+}
+
+/************************************************************************/
+/*                       ComputeRegionMemoryUse()                       */
+/************************************************************************/
+
+/**
+ * \fn CPLErr GDALWarpOperation::ComputeRegionMemoryUse( int nDstXOff, int nDstYOff, int nDstXSize, int nDstYSize, double *pdfMemoryUse );
+ *
+ * Estimate the memory needed to warp a destination region in one chunk.
+ *
+ * The estimate covers the source window of the region and the destination
+ * buffer, with their masks, and is the one compared to the warp memory
+ * limit when splitting an operation into chunks.  A region whose memory
+ * use exceeds that limit is usually better warped as several smaller
+ * regions.
+ *
+ * @param nDstXOff X offset to window of destination data to be produced.
+ * @param nDstYOff Y offset to window of destination data to be produced.
+ * @param nDstXSize Width of output window on destination file to be produced.
+ * @param nDstYSize Height of output window on destination file to be produced.
+ * @param pdfMemoryUse location into which the number of bytes is returned.
+ *
+ * @return CE_None on success or CE_Failure if the source window of the
+ * region cannot be computed.
+ */
+
+CPLErr GDALWarpOperation::ComputeRegionMemoryUse( int nDstXOff, int nDstYOff,
+                                                  int nDstXSize, int nDstYSize,
+                                                  double *pdfMemoryUse )
+
+{
+    int nSrcXOff, nSrcYOff, nSrcXSize, nSrcYSize;
+    int nSrcXExtraSize, nSrcYExtraSize;
+    double dfSrcFillRatio;
+
+    CPLErr eErr = ComputeSourceWindow( nDstXOff, nDstYOff, nDstXSize, nDstYSize,
+                                       &nSrcXOff, &nSrcYOff,
+                                       &nSrcXSize, &nSrcYSize,
+                                       &nSrcXExtraSize, &nSrcYExtraSize,
+                                       &dfSrcFillRatio );
+    if( eErr != CE_None )
+        return eErr;
+
+    int nSrcPixelCostInBits, nDstPixelCostInBits;
+
+    ComputePixelCostsInBits( &nSrcPixelCostInBits, &nDstPixelCostInBits );
+
+    *pdfMemoryUse =
+        (((double) nSrcPixelCostInBits) * nSrcXSize * nSrcYSize
+         + ((double) nDstPixelCostInBits) * nDstXSize * nDstYSize) / 8.0;
+
+    return CE_None;
+}
+
+/************************************************************************/
+/*                          CollectChunkList()                          */
+/************************************************************************/
+
+CPLErr GDALWarpOperation::CollectChunkList(
+    int nDstXOff, int nDstYOff,  int nDstXSize, int nDstYSize )
+
+{
+/* -------------------------------------------------------------------- */
+/*      Compute the bounds of the input area corresponding to the       */
+/*      output area.                                                    */
+/* -------------------------------------------------------------------- */
+    int nSrcXOff, nSrcYOff, nSrcXSize, nSrcYSize;
+    int nSrcXExtraSize, nSrcYExtraSize;
+    double dfSrcFillRatio;
+    CPLErr eErr;
+
+    eErr = ComputeSourceWindow( nDstXOff, nDstYOff, nDstXSize, nDstYSize,
+                                &nSrcXOff, &nSrcYOff, &nSrcXSize, &nSrcYSize,
+                                &nSrcXExtraSize, &nSrcYExtraSize, &dfSrcFillRatio );
+
+    if( eErr != CE_None )
+    {
+        CPLError( CE_Warning, CPLE_AppDefined,
+                  "Unable to compute source region for output window %d,%d,%d,%d, skipping.",
+                  nDstXOff, nDstYOff, nDstXSize, nDstYSize );
+        return eErr;
+    }
+
+/* -------------------------------------------------------------------- */
+/*      If we are allowed to drop no-source regions, do so now if       */
+/*      appropriate.                                                    */
+/* -------------------------------------------------------------------- */
+    if( (nSrcXSize == 0 || nSrcYSize == 0)
+        && CSLFetchBoolean( psOptions->papszWarpOptions, "SKIP_NOSOURCE",0 ))
+        return CE_None;
+
+/* -------------------------------------------------------------------- */
+/*      Based on the types of masks in use, how many bits will each     */
+/*      source and destination pixel cost us?                           */
+/* -------------------------------------------------------------------- */
+    int nSrcPixelCostInBits, nDstPixelCostInBits;
+
+    ComputePixelCostsInBits( &nSrcPixelCostInBits, &nDstPixelCostInBits );
+
 /* -------------------------------------------------------------------- */
 /*      Does the cost of the current rectangle exceed our memory        */
 /*      limit? If so, split the destination along the longest           */
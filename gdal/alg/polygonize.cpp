@@ -30,6 +30,8 @@
 #include "gdal_alg_priv.h"
 #include "cpl_conv.h"
 #include "cpl_string.h"
+#include "cpl_worker_thread_pool.h"
+#include <algorithm>
 #include <vector>
 
 CPL_CVSID("$Id$");
@@ -57,6 +59,7 @@ public:
     void             Dump();
     void             Coalesce();
     void             Merge( int iBaseString, int iSrcString, int iDirection );
+    void             RebuildRings();
 };
 
 /************************************************************************/
@@ -179,6 +182,70 @@ void RPolygon::Merge( int iBaseString, int iSrcString, int iDirection )
     aanXY.resize(nSize-1);
 }
 
+/************************************************************************/
+/*                            RebuildRings()                            */
+/*                                                                      */
+/*      Alternative to Coalesce() for polygons assembled from pieces    */
+/*      formed separately.  Strings are exploded into unit pixel        */
+/*      edges, which are added again in the order of the single pass    */
+/*      of GDALPolygonizeT() before being coalesced, so that the rings  */
+/*      are the same as in the default mode, including where the        */
+/*      polygon touches itself at a vertex.                             */
+/************************************************************************/
+
+void RPolygon::RebuildRings()
+
+{
+/* -------------------------------------------------------------------- */
+/*      Explode the strings into unit edges, keyed by the line, the     */
+/*      column and the kind (horizontal edge above the pixel first,     */
+/*      then vertical edge on its right) of the AddEdges() call that    */
+/*      adds them in the single pass.                                   */
+/* -------------------------------------------------------------------- */
+    std::vector< std::pair< std::pair<int,int>, int > > aoEdges;
+    for( size_t iString = 0; iString < aanXY.size(); iString++ )
+    {
+        const std::vector<int> &anString = aanXY[iString];
+        for( size_t iVert = 2; iVert + 1 < anString.size(); iVert += 2 )
+        {
+            int nX = anString[iVert-2];
+            int nY = anString[iVert-1];
+            const int nX2 = anString[iVert];
+            const int nY2 = anString[iVert+1];
+            const int nDX = (nX2 > nX) ? 1 : (nX2 < nX) ? -1 : 0;
+            const int nDY = (nY2 > nY) ? 1 : (nY2 < nY) ? -1 : 0;
+            while( nX != nX2 || nY != nY2 )
+            {
+                if( nDY == 0 )
+                    aoEdges.push_back( std::make_pair(
+                        std::make_pair( nY, MIN(nX, nX + nDX) + 1 ), 0 ) );
+                else
+                    aoEdges.push_back( std::make_pair(
+                        std::make_pair( MIN(nY, nY + nDY), nX ), 1 ) );
+                nX += nDX;
+                nY += nDY;
+            }
+        }
+    }
+    std::sort( aoEdges.begin(), aoEdges.end() );
+
+/* -------------------------------------------------------------------- */
+/*      Add them again, as AddEdges() would have.                       */
+/* -------------------------------------------------------------------- */
+    aanXY.clear();
+    for( size_t iEdge = 0; iEdge < aoEdges.size(); iEdge++ )
+    {
+        const int nY = aoEdges[iEdge].first.first;
+        const int nX = aoEdges[iEdge].first.second;
+        if( aoEdges[iEdge].second == 0 )
+            AddSegment( nX - 1, nY, nX, nY );
+        else
+            AddSegment( nX, nY, nX, nY + 1 );
+    }
+
+    Coalesce();
+}
+
 /************************************************************************/
 /*                             AddSegment()                             */
 /************************************************************************/
@@ -264,13 +331,16 @@ void RPolygon::AddSegment( int x1, int y1, int x2, int y2 )
 /*      Examine one pixel and compare to its neighbour above            */
 /*      (previous) and right.  If they are different polygon ids        */
 /*      then add the pixel edge to this polygon and the one on the      */
-/*      other side of the edge.                                         */
+/*      other side of the edge.  The edge above is skipped if           */
+/*      bEdgeAbove is false, for the first line of a strip that is      */
+/*      stitched to the previous one afterwards.                        */
 /************************************************************************/
 
 template<class DataType>
 static void AddEdges( GInt32 *panThisLineId, GInt32 *panLastLineId,
                       GInt32 *panPolyIdMap, DataType *panPolyValue,
-                      RPolygon **papoPoly, int iX, int iY )
+                      RPolygon **papoPoly, int iX, int iY,
+                      bool bEdgeAbove = true )
 
 {
     int nThisId = panThisLineId[iX];
@@ -285,7 +355,7 @@ static void AddEdges( GInt32 *panThisLineId, GInt32 *panLastLineId,
     if( nPreviousId != -1 )
         nPreviousId = panPolyIdMap[nPreviousId];
 
-    if( nThisId != nPreviousId )
+    if( bEdgeAbove && nThisId != nPreviousId )
     {
         if( nThisId != -1 )
         {
@@ -324,21 +394,23 @@ static void AddEdges( GInt32 *panThisLineId, GInt32 *panLastLineId,
 }
 
 /************************************************************************/
-/*                         EmitPolygonToLayer()                         */
+/*                         RPolygonToGeometry()                         */
 /************************************************************************/
 
-static CPLErr
-EmitPolygonToLayer( OGRLayerH hOutLayer, int iPixValField,
-                    RPolygon *poRPoly, double *padfGeoTransform )
+static OGRGeometryH
+RPolygonToGeometry( RPolygon *poRPoly, double *padfGeoTransform,
+                    bool bRebuildRings = false )
 
 {
-    OGRFeatureH hFeat;
     OGRGeometryH hPolygon;
 
 /* -------------------------------------------------------------------- */
 /*      Turn bits of lines into coherent rings.                         */
 /* -------------------------------------------------------------------- */
-    poRPoly->Coalesce();
+    if( bRebuildRings )
+        poRPoly->RebuildRings();
+    else
+        poRPoly->Coalesce();
 
 /* -------------------------------------------------------------------- */
 /*      Create the polygon geometry.                                    */
@@ -377,15 +449,29 @@ EmitPolygonToLayer( OGRLayerH hOutLayer, int iPixValField,
         OGR_G_AddGeometryDirectly( hPolygon, hRing );
     }
 
+    return hPolygon;
+}
+
+/************************************************************************/
+/*                        EmitGeometryToLayer()                         */
+/*                                                                      */
+/*      Write a polygon feature, taking ownership of hPolygon.          */
+/************************************************************************/
+
+static CPLErr
+EmitGeometryToLayer( OGRLayerH hOutLayer, int iPixValField,
+                     OGRGeometryH hPolygon, double dfPolyValue )
+
+{
 /* -------------------------------------------------------------------- */
 /*      Create the feature object.                                      */
 /* -------------------------------------------------------------------- */
-    hFeat = OGR_F_Create( OGR_L_GetLayerDefn( hOutLayer ) );
+    OGRFeatureH hFeat = OGR_F_Create( OGR_L_GetLayerDefn( hOutLayer ) );
 
     OGR_F_SetGeometryDirectly( hFeat, hPolygon );
 
     if( iPixValField >= 0 )
-        OGR_F_SetFieldDouble( hFeat, iPixValField, poRPoly->dfPolyValue );
+        OGR_F_SetFieldDouble( hFeat, iPixValField, dfPolyValue );
 
 /* -------------------------------------------------------------------- */
 /*      Write the to the layer.                                         */
@@ -400,6 +486,21 @@ EmitPolygonToLayer( OGRLayerH hOutLayer, int iPixValField,
     return eErr;
 }
 
+/************************************************************************/
+/*                         EmitPolygonToLayer()                         */
+/************************************************************************/
+
+static CPLErr
+EmitPolygonToLayer( OGRLayerH hOutLayer, int iPixValField,
+                    RPolygon *poRPoly, double *padfGeoTransform )
+
+{
+    return EmitGeometryToLayer( hOutLayer, iPixValField,
+                                RPolygonToGeometry( poRPoly,
+                                                    padfGeoTransform ),
+                                poRPoly->dfPolyValue );
+}
+
 /************************************************************************/
 /*                          GPMaskImageData()                           */
 /*                                                                      */
@@ -430,6 +531,571 @@ GPMaskImageData( GDALRasterBandH hMaskBand, GByte* pabyMaskLine, int iY, int nXS
     return eErr;
 }
 
+/************************************************************************/
+/* ==================================================================== */
+/*                              Strip mode                              */
+/*                                                                      */
+/*      The raster is cut into strips of lines that are polygonized     */
+/*      independently, possibly in parallel.  Polygons that do not      */
+/*      touch the border of their strip with the previous or next one   */
+/*      (a seam) are complete and emitted right away.  The other ones   */
+/*      are stitched, in strip order, with the polygons left open at    */
+/*      the bottom of the previous strip, and emitted as soon as they   */
+/*      do not reach the bottom of the strip being stitched.            */
+/* ==================================================================== */
+/************************************************************************/
+
+template<class DataType>
+struct GPStripJob
+{
+    // Input.
+    DataType   *panVal;  // nXSize * nYSize values, masked pixels marked.
+    int         nXSize;
+    int         nYOff;
+    int         nYSize;
+    bool        bFirst;
+    bool        bLast;
+    int         nConnectedness;
+    double     *padfGeoTransform;
+
+    // Output.
+    std::vector<GInt32>       anFirstLineId;  // Polygon ids on first line.
+    std::vector<GInt32>       anLastLineId;   // Polygon ids on last line.
+    std::vector<RPolygon *>   apoSeamPoly;    // By id, if touching a seam.
+    std::vector<OGRGeometryH> ahCompleteGeom; // Complete polygons.
+    std::vector<double>       adfCompleteValue;
+};
+
+/************************************************************************/
+/*                         GPPolygonizeStrip()                          */
+/*                                                                      */
+/*      Same two passes as GDALPolygonizeT(), on a strip in memory.     */
+/************************************************************************/
+
+template<class DataType, class EqualityTest>
+static void GPPolygonizeStrip( void *pData )
+
+{
+    GPStripJob<DataType> *psJob = static_cast<GPStripJob<DataType> *>(pData);
+    const int nXSize = psJob->nXSize;
+    const int nYSize = psJob->nYSize;
+    std::vector<GInt32> anIdA( nXSize + 2, -1 );
+    std::vector<GInt32> anIdB( nXSize + 2, -1 );
+    GInt32 *panLastLineId = &(anIdA[0]);
+    GInt32 *panThisLineId = &(anIdB[0]);
+    int iY, iX;
+
+/* -------------------------------------------------------------------- */
+/*      First pass to build the polygon id map.                         */
+/* -------------------------------------------------------------------- */
+    GDALRasterPolygonEnumeratorT<DataType, EqualityTest>
+        oFirstEnum(psJob->nConnectedness);
+
+    for( iY = 0; iY < nYSize; iY++ )
+    {
+        DataType *panThisLineVal = psJob->panVal + static_cast<size_t>(iY) * nXSize;
+
+        if( iY == 0 )
+            oFirstEnum.ProcessLine(
+                NULL, panThisLineVal, NULL, panThisLineId, nXSize );
+        else
+            oFirstEnum.ProcessLine(
+                panThisLineVal - nXSize, panThisLineVal,
+                panLastLineId,  panThisLineId,
+                nXSize );
+
+        if( iY == 0 )
+            psJob->anFirstLineId.assign( panThisLineId,
+                                         panThisLineId + nXSize );
+        if( iY == nYSize - 1 )
+            psJob->anLastLineId.assign( panThisLineId,
+                                        panThisLineId + nXSize );
+
+        GInt32* panTmp = panThisLineId;
+        panThisLineId = panLastLineId;
+        panLastLineId = panTmp;
+    }
+
+    oFirstEnum.CompleteMerges();
+
+/* -------------------------------------------------------------------- */
+/*      Find the polygons touching a seam.                              */
+/* -------------------------------------------------------------------- */
+    std::vector<char> abTouchesSeam( oFirstEnum.nNextPolygonId, FALSE );
+
+    for( iX = 0; iX < nXSize; iX++ )
+    {
+        GInt32 &nFirstId = psJob->anFirstLineId[iX];
+        GInt32 &nLastId = psJob->anLastLineId[iX];
+
+        if( nFirstId != -1 )
+        {
+            nFirstId = oFirstEnum.panPolyIdMap[nFirstId];
+            if( !psJob->bFirst )
+                abTouchesSeam[nFirstId] = TRUE;
+        }
+        if( nLastId != -1 )
+        {
+            nLastId = oFirstEnum.panPolyIdMap[nLastId];
+            if( !psJob->bLast )
+                abTouchesSeam[nLastId] = TRUE;
+        }
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Second pass collecting the polygon edges.  There is no edge     */
+/*      above the first line, nor below the last line, on a seam.       */
+/* -------------------------------------------------------------------- */
+    GDALRasterPolygonEnumeratorT<DataType, EqualityTest>
+        oSecondEnum(psJob->nConnectedness);
+    std::vector<RPolygon *> apoPoly( oFirstEnum.nNextPolygonId + 1, NULL );
+    const int nLastIter = psJob->bLast ? nYSize + 1 : nYSize;
+
+    for( iX = 0; iX < nXSize+2; iX++ )
+    {
+        panLastLineId[iX] = -1;
+        panThisLineId[iX] = -1;
+    }
+
+    for( iY = 0; iY < nLastIter; iY++ )
+    {
+        DataType *panThisLineVal = psJob->panVal + static_cast<size_t>(iY) * nXSize;
+
+        if( iY == nYSize )
+        {
+            for( iX = 0; iX < nXSize+2; iX++ )
+                panThisLineId[iX] = -1;
+        }
+        else if( iY == 0 )
+            oSecondEnum.ProcessLine(
+                NULL, panThisLineVal, NULL, panThisLineId+1, nXSize );
+        else
+            oSecondEnum.ProcessLine(
+                panThisLineVal - nXSize, panThisLineVal,
+                panLastLineId+1,  panThisLineId+1,
+                nXSize );
+
+        const bool bEdgeAbove = iY > 0 || psJob->bFirst;
+        for( iX = 0; iX < nXSize+1; iX++ )
+        {
+            AddEdges( panThisLineId, panLastLineId,
+                      oFirstEnum.panPolyIdMap, oFirstEnum.panPolyValue,
+                      &(apoPoly[0]), iX, psJob->nYOff + iY, bEdgeAbove );
+        }
+
+        // Turn the complete polygons into geometries as we go.
+        const bool bEnd = iY == nLastIter - 1;
+        if( iY % 8 == 7 || bEnd )
+        {
+            for( iX = 0; iX < oSecondEnum.nNextPolygonId; iX++ )
+            {
+                RPolygon *poPoly = apoPoly[iX];
+                if( poPoly && !abTouchesSeam[iX] &&
+                    (bEnd || poPoly->nLastLineUpdated < psJob->nYOff+iY-1) )
+                {
+                    psJob->ahCompleteGeom.push_back(
+                        RPolygonToGeometry( poPoly,
+                                            psJob->padfGeoTransform ) );
+                    psJob->adfCompleteValue.push_back( poPoly->dfPolyValue );
+                    delete poPoly;
+                    apoPoly[iX] = NULL;
+                }
+            }
+        }
+
+        GInt32* panTmp = panThisLineId;
+        panThisLineId = panLastLineId;
+        panLastLineId = panTmp;
+    }
+
+    apoPoly.resize( oFirstEnum.nNextPolygonId );
+    psJob->apoSeamPoly.swap( apoPoly );
+}
+
+/************************************************************************/
+/*                           GPStripStitcher                            */
+/************************************************************************/
+
+template<class DataType, class EqualityTest>
+class GPStripStitcher
+{
+    int                     nXSize;
+    int                     nConnectedness;
+    OGRLayerH               hOutLayer;
+    int                     iPixValField;
+    double                 *padfGeoTransform;
+
+    // Polygons reaching the bottom of the last stitched strip.
+    std::vector<RPolygon *> apoOpenPoly;
+    // Values and open polygon index of the pixels of its last line.
+    std::vector<DataType>   anLastLineVal;
+    std::vector<int>        anLastLineOpenId;
+
+    std::vector<int>        anParent;
+
+    int                     Find( int i );
+    void                    Union( int i, int j );
+
+  public:
+            GPStripStitcher( int nXSizeIn, int nConnectednessIn,
+                             OGRLayerH hOutLayerIn, int iPixValFieldIn,
+                             double *padfGeoTransformIn ) :
+                nXSize(nXSizeIn), nConnectedness(nConnectednessIn),
+                hOutLayer(hOutLayerIn), iPixValField(iPixValFieldIn),
+                padfGeoTransform(padfGeoTransformIn) {}
+           ~GPStripStitcher();
+
+    CPLErr  Stitch( GPStripJob<DataType> *psJob );
+};
+
+template<class DataType, class EqualityTest>
+GPStripStitcher<DataType, EqualityTest>::~GPStripStitcher()
+{
+    for( size_t i = 0; i < apoOpenPoly.size(); i++ )
+        delete apoOpenPoly[i];
+}
+
+template<class DataType, class EqualityTest>
+int GPStripStitcher<DataType, EqualityTest>::Find( int i )
+{
+    int nRoot = i;
+    while( anParent[nRoot] != nRoot )
+        nRoot = anParent[nRoot];
+    while( anParent[i] != nRoot )
+    {
+        const int nNext = anParent[i];
+        anParent[i] = nRoot;
+        i = nNext;
+    }
+    return nRoot;
+}
+
+template<class DataType, class EqualityTest>
+void GPStripStitcher<DataType, EqualityTest>::Union( int i, int j )
+{
+    i = Find(i);
+    j = Find(j);
+    // Keep the smallest index as the root, so that the polygons coming
+    // from above come first.
+    if( i < j )
+        anParent[j] = i;
+    else if( j < i )
+        anParent[i] = j;
+}
+
+/************************************************************************/
+/*                               Stitch()                               */
+/*                                                                      */
+/*      Emit the complete polygons of a strip, and merge the ones       */
+/*      touching its top with the polygons left open by the previous    */
+/*      strip.  Must be called in strip order.  Takes ownership of the  */
+/*      geometries and polygons of psJob.                               */
+/************************************************************************/
+
+template<class DataType, class EqualityTest>
+CPLErr GPStripStitcher<DataType, EqualityTest>::Stitch(
+                                            GPStripJob<DataType> *psJob )
+{
+    CPLErr eErr = CE_None;
+    EqualityTest eq;
+    int iX;
+
+    for( size_t i = 0; i < psJob->ahCompleteGeom.size(); i++ )
+    {
+        if( eErr == CE_None )
+            eErr = EmitGeometryToLayer( hOutLayer, iPixValField,
+                                        psJob->ahCompleteGeom[i],
+                                        psJob->adfCompleteValue[i] );
+        else
+            OGR_G_DestroyGeometry( psJob->ahCompleteGeom[i] );
+    }
+    psJob->ahCompleteGeom.clear();
+
+/* -------------------------------------------------------------------- */
+/*      Group the open polygons, numbered first, and the polygons of    */
+/*      the strip that are connected through the seam.                  */
+/* -------------------------------------------------------------------- */
+    const int nOpen = static_cast<int>(apoOpenPoly.size());
+    const int nNodes = nOpen + static_cast<int>(psJob->apoSeamPoly.size());
+    const DataType *panFirstLineVal = psJob->panVal;
+    const std::vector<GInt32> &anFirstLineId = psJob->anFirstLineId;
+
+    anParent.resize( nNodes );
+    for( int i = 0; i < nNodes; i++ )
+        anParent[i] = i;
+
+    if( !psJob->bFirst )
+    {
+        for( iX = 0; iX < nXSize; iX++ )
+        {
+            if( anFirstLineId[iX] == -1 )
+                continue;
+
+            const DataType nVal = panFirstLineVal[iX];
+            const int nNode = nOpen + anFirstLineId[iX];
+
+            if( anLastLineOpenId[iX] >= 0
+                && eq.operator()(anLastLineVal[iX], nVal) )
+                Union( anLastLineOpenId[iX], nNode );
+
+            if( nConnectedness == 8 )
+            {
+                if( iX > 0 && anLastLineOpenId[iX-1] >= 0
+                    && eq.operator()(anLastLineVal[iX-1], nVal) )
+                    Union( anLastLineOpenId[iX-1], nNode );
+                if( iX < nXSize-1 && anLastLineOpenId[iX+1] >= 0
+                    && eq.operator()(anLastLineVal[iX+1], nVal) )
+                    Union( anLastLineOpenId[iX+1], nNode );
+            }
+        }
+    }
+
+    std::vector<RPolygon *> apoGroup( nNodes, NULL );
+    for( int i = 0; i < nNodes; i++ )
+    {
+        RPolygon *poPoly = (i < nOpen) ? apoOpenPoly[i] :
+                                         psJob->apoSeamPoly[i - nOpen];
+        if( poPoly == NULL )
+            continue;
+
+        RPolygon *&poGroup = apoGroup[Find(i)];
+        if( poGroup == NULL )
+            poGroup = poPoly;
+        else
+        {
+            poGroup->aanXY.insert( poGroup->aanXY.end(),
+                                   poPoly->aanXY.begin(),
+                                   poPoly->aanXY.end() );
+            delete poPoly;
+        }
+    }
+    apoOpenPoly.clear();
+    psJob->apoSeamPoly.clear();
+
+/* -------------------------------------------------------------------- */
+/*      Add the edges along the seam between different polygons.        */
+/* -------------------------------------------------------------------- */
+    if( !psJob->bFirst )
+    {
+        for( iX = 0; iX < nXSize; iX++ )
+        {
+            const int nAbove = anLastLineOpenId[iX] >= 0 ?
+                Find( anLastLineOpenId[iX] ) : -1;
+            const int nBelow = anFirstLineId[iX] != -1 ?
+                Find( nOpen + anFirstLineId[iX] ) : -1;
+
+            if( nAbove == nBelow )
+                continue;
+            if( nAbove >= 0 )
+                apoGroup[nAbove]->AddSegment( iX, psJob->nYOff,
+                                              iX+1, psJob->nYOff );
+            if( nBelow >= 0 )
+                apoGroup[nBelow]->AddSegment( iX, psJob->nYOff,
+                                              iX+1, psJob->nYOff );
+        }
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Keep the groups reaching the bottom of the strip open, and      */
+/*      emit the other ones.                                            */
+/* -------------------------------------------------------------------- */
+    std::vector<int> anOpenId( nNodes, -1 );
+    const std::vector<GInt32> &anLastLineId = psJob->anLastLineId;
+
+    anLastLineOpenId.assign( nXSize, -1 );
+    if( !psJob->bLast )
+    {
+        for( iX = 0; iX < nXSize; iX++ )
+        {
+            if( anLastLineId[iX] == -1 )
+                continue;
+            const int nRoot = Find( nOpen + anLastLineId[iX] );
+            if( anOpenId[nRoot] < 0 )
+            {
+                anOpenId[nRoot] = static_cast<int>(apoOpenPoly.size());
+                apoOpenPoly.push_back( apoGroup[nRoot] );
+            }
+            anLastLineOpenId[iX] = anOpenId[nRoot];
+        }
+        anLastLineVal.assign(
+            psJob->panVal + static_cast<size_t>(psJob->nYSize - 1) * nXSize,
+            psJob->panVal + static_cast<size_t>(psJob->nYSize) * nXSize );
+    }
+
+    for( int i = 0; i < nNodes; i++ )
+    {
+        if( apoGroup[i] == NULL || anOpenId[i] >= 0 )
+            continue;
+
+        if( eErr == CE_None )
+            eErr = EmitGeometryToLayer( hOutLayer, iPixValField,
+                                        RPolygonToGeometry( apoGroup[i],
+                                                            padfGeoTransform,
+                                                            true ),
+                                        apoGroup[i]->dfPolyValue );
+        delete apoGroup[i];
+    }
+
+    return eErr;
+}
+
+/************************************************************************/
+/*                        GDALPolygonizeStripsT()                       */
+/************************************************************************/
+
+template<class DataType, class EqualityTest>
+static CPLErr
+GDALPolygonizeStripsT( GDALRasterBandH hSrcBand,
+                       GDALRasterBandH hMaskBand,
+                       OGRLayerH hOutLayer, int iPixValField,
+                       int nConnectedness, int nStripHeight, int nThreads,
+                       double *padfGeoTransform,
+                       GDALProgressFunc pfnProgress,
+                       void * pProgressArg,
+                       GDALDataType eDT )
+
+{
+    const int nXSize = GDALGetRasterBandXSize( hSrcBand );
+    const int nYSize = GDALGetRasterBandYSize( hSrcBand );
+    const int nStrips = (nYSize + nStripHeight - 1) / nStripHeight;
+
+    if( nThreads > nStrips )
+        nThreads = nStrips;
+
+    CPLWorkerThreadPool *poThreadPool = NULL;
+    if( nThreads > 1 )
+    {
+        poThreadPool = new CPLWorkerThreadPool();
+        if( !poThreadPool->Setup( nThreads, NULL, NULL ) )
+        {
+            delete poThreadPool;
+            poThreadPool = NULL;
+            nThreads = 1;
+        }
+    }
+    else
+        nThreads = 1;
+
+    CPLDebug( "GDAL", "Polygonizing %d strips of %d lines with %d thread(s).",
+              nStrips, nStripHeight, nThreads );
+
+/* -------------------------------------------------------------------- */
+/*      Allocate one strip buffer per thread.                           */
+/* -------------------------------------------------------------------- */
+    CPLErr eErr = CE_None;
+    std::vector< GPStripJob<DataType> > asJobs( nThreads );
+    GByte *pabyMask = NULL;
+
+    for( int i = 0; eErr == CE_None && i < nThreads; i++ )
+    {
+        asJobs[i].panVal = (DataType *)
+            VSI_MALLOC3_VERBOSE( sizeof(DataType), nXSize, nStripHeight );
+        if( asJobs[i].panVal == NULL )
+            eErr = CE_Failure;
+    }
+    if( eErr == CE_None && hMaskBand != NULL )
+    {
+        pabyMask = (GByte *) VSI_MALLOC2_VERBOSE( nXSize, nStripHeight );
+        if( pabyMask == NULL )
+            eErr = CE_Failure;
+    }
+
+    GPStripStitcher<DataType, EqualityTest> oStitcher(
+        nXSize, nConnectedness, hOutLayer, iPixValField, padfGeoTransform );
+
+/* ==================================================================== */
+/*      Process the strips by batches of nThreads.                      */
+/* ==================================================================== */
+    for( int iStrip = 0; eErr == CE_None && iStrip < nStrips;
+         iStrip += nThreads )
+    {
+        const int nJobs = MIN(nThreads, nStrips - iStrip);
+        std::vector<void *> apJobs;
+
+        // Reading the raster is done sequentially.
+        for( int i = 0; eErr == CE_None && i < nJobs; i++ )
+        {
+            GPStripJob<DataType> &sJob = asJobs[i];
+            sJob.nXSize = nXSize;
+            sJob.nYOff = (iStrip + i) * nStripHeight;
+            sJob.nYSize = MIN(nStripHeight, nYSize - sJob.nYOff);
+            sJob.bFirst = iStrip + i == 0;
+            sJob.bLast = iStrip + i == nStrips - 1;
+            sJob.nConnectedness = nConnectedness;
+            sJob.padfGeoTransform = padfGeoTransform;
+
+            eErr = GDALRasterIO( hSrcBand, GF_Read,
+                                 0, sJob.nYOff, nXSize, sJob.nYSize,
+                                 sJob.panVal, nXSize, sJob.nYSize, eDT,
+                                 0, 0 );
+            if( eErr == CE_None && hMaskBand != NULL )
+            {
+                eErr = GDALRasterIO( hMaskBand, GF_Read,
+                                     0, sJob.nYOff, nXSize, sJob.nYSize,
+                                     pabyMask, nXSize, sJob.nYSize,
+                                     GDT_Byte, 0, 0 );
+                const size_t nPixels =
+                    static_cast<size_t>(nXSize) * sJob.nYSize;
+                for( size_t j = 0; eErr == CE_None && j < nPixels; j++ )
+                {
+                    if( pabyMask[j] == 0 )
+                        sJob.panVal[j] = GP_NODATA_MARKER;
+                }
+            }
+            apJobs.push_back( &sJob );
+        }
+        if( eErr != CE_None )
+            break;
+
+        // On failure, no job has been queued: run them here.
+        if( poThreadPool != NULL && nJobs > 1 &&
+            poThreadPool->SubmitJobs(
+                GPPolygonizeStrip<DataType, EqualityTest>, apJobs ) )
+        {
+            poThreadPool->WaitCompletion();
+        }
+        else
+        {
+            for( int i = 0; i < nJobs; i++ )
+                GPPolygonizeStrip<DataType, EqualityTest>( apJobs[i] );
+        }
+
+        // Stitching and writing to the layer is done sequentially too.
+        for( int i = 0; i < nJobs; i++ )
+        {
+            GPStripJob<DataType> &sJob = asJobs[i];
+            if( eErr == CE_None )
+                eErr = oStitcher.Stitch( &sJob );
+
+            for( size_t j = 0; j < sJob.ahCompleteGeom.size(); j++ )
+                OGR_G_DestroyGeometry( sJob.ahCompleteGeom[j] );
+            for( size_t j = 0; j < sJob.apoSeamPoly.size(); j++ )
+                delete sJob.apoSeamPoly[j];
+            sJob.ahCompleteGeom.clear();
+            sJob.adfCompleteValue.clear();
+            sJob.apoSeamPoly.clear();
+        }
+
+        if( eErr == CE_None
+            && !pfnProgress( MIN(1.0, (iStrip + nJobs) / (double) nStrips),
+                             "", pProgressArg ) )
+        {
+            CPLError( CE_Failure, CPLE_UserInterrupt, "User terminated" );
+            eErr = CE_Failure;
+        }
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Cleanup                                                         */
+/* -------------------------------------------------------------------- */
+    for( int i = 0; i < nThreads; i++ )
+        CPLFree( asJobs[i].panVal );
+    CPLFree( pabyMask );
+    delete poThreadPool;
+
+    return eErr;
+}
+
 /************************************************************************/
 /*                           GDALPolygonizeT()                          */
 /************************************************************************/
@@ -465,11 +1131,44 @@ GDALPolygonizeT( GDALRasterBandH hSrcBand,
     }
 
 /* -------------------------------------------------------------------- */
-/*      Allocate working buffers.                                       */
+/*      Strip mode.                                                     */
 /* -------------------------------------------------------------------- */
-    CPLErr eErr = CE_None;
     int nXSize = GDALGetRasterBandXSize( hSrcBand );
     int nYSize = GDALGetRasterBandYSize( hSrcBand );
+    const char *pszNumThreads = CSLFetchNameValue( papszOptions, "NUM_THREADS" );
+    const char *pszStripHeight = CSLFetchNameValue( papszOptions, "STRIP_HEIGHT" );
+
+    if( pszNumThreads != NULL || pszStripHeight != NULL )
+    {
+        const int nThreads = CPLParseNumThreads( pszNumThreads );
+
+        // By default, one strip per thread, of at most about 64 MB.
+        int nStripHeight = pszStripHeight ? atoi(pszStripHeight) :
+            static_cast<int>(MIN(static_cast<GIntBig>(nYSize +
+                                                      nThreads - 1) / nThreads,
+                                 64 * 1024 * 1024 /
+                                 (static_cast<GIntBig>(nXSize) *
+                                  static_cast<GIntBig>(sizeof(DataType)))));
+        if( nStripHeight < 1 )
+            nStripHeight = 1;
+        if( nStripHeight > nYSize )
+            nStripHeight = MAX(1, nYSize);
+
+        double adfGeoTransform[6] = { 0.0, 1.0, 0.0, 0.0, 0.0, 1.0 };
+        GDALDatasetH hSrcDS = GDALGetBandDataset( hSrcBand );
+        if( hSrcDS )
+            GDALGetGeoTransform( hSrcDS, adfGeoTransform );
+
+        return GDALPolygonizeStripsT<DataType, EqualityTest>(
+            hSrcBand, hMaskBand, hOutLayer, iPixValField, nConnectedness,
+            nStripHeight, nThreads, adfGeoTransform,
+            pfnProgress, pProgressArg, eDT );
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Allocate working buffers.                                       */
+/* -------------------------------------------------------------------- */
+    CPLErr eErr = CE_None;
     DataType *panLastLineVal = (DataType *) VSI_MALLOC2_VERBOSE(sizeof(DataType),nXSize + 2);
     DataType *panThisLineVal = (DataType *) VSI_MALLOC2_VERBOSE(sizeof(DataType),nXSize + 2);
     GInt32 *panLastLineId =  (GInt32 *) VSI_MALLOC2_VERBOSE(sizeof(GInt32),nXSize + 2);
@@ -804,6 +1503,13 @@ GBool GDALFloatEquals(float A, float B)
  * <dl>
  * <dt>"8CONNECTED":</dt> May be set to "8" to use 8 connectedness.
  * Otherwise 4 connectedness will be applied to the algorithm
+ * <dt>"NUM_THREADS":</dt> (GDAL >= 2.2) Number of worker threads, or
+ * ALL_CPUS. When set, the raster is processed as horizontal strips that are
+ * polygonized in parallel and stitched together afterwards. Polygons are
+ * then written as soon as they are complete, in a different order.
+ * <dt>"STRIP_HEIGHT":</dt> (GDAL >= 2.2) Height of the strips, in lines, in
+ * that mode (which this option also enables). Defaults to one strip per
+ * thread, of at most 64 MB.
  * </dl>
  * @param pfnProgress callback for reporting algorithm progress matching the
  * GDALProgressFunc() semantics.  May be NULL.
@@ -881,6 +1587,13 @@ GDALPolygonize( GDALRasterBandH hSrcBand,
  * <dl>
  * <dt>"8CONNECTED":</dt> May be set to "8" to use 8 connectedness.
  * Otherwise 4 connectedness will be applied to the algorithm
+ * <dt>"NUM_THREADS":</dt> (GDAL >= 2.2) Number of worker threads, or
+ * ALL_CPUS. When set, the raster is processed as horizontal strips that are
+ * polygonized in parallel and stitched together afterwards. Polygons are
+ * then written as soon as they are complete, in a different order.
+ * <dt>"STRIP_HEIGHT":</dt> (GDAL >= 2.2) Height of the strips, in lines, in
+ * that mode (which this option also enables). Defaults to one strip per
+ * thread, of at most 64 MB.
  * </dl>
  * @param pfnProgress callback for reporting algorithm progress matching the
  * GDALProgressFunc() semantics.  May be NULL.
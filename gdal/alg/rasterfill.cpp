@@ -30,8 +30,12 @@
  ***************************************************************************/
 
 #include "gdal_alg.h"
+#include "gdal_alg_priv.h"
 #include "cpl_conv.h"
 #include "cpl_string.h"
+#include "cpl_worker_thread_pool.h"
+
+#include <vector>
 
 CPL_CVSID("$Id$");
 
@@ -347,6 +351,633 @@ if( quad_value != nNoDataVal ) 						\
     }									\
 }
 
+/************************************************************************/
+/*                      GDALFillNodataWorkDriver()                      */
+/*                                                                      */
+/*      Determine the format driver, and its creation options, for      */
+/*      the temporary work files.                                       */
+/************************************************************************/
+
+static GDALDriverH
+GDALFillNodataWorkDriver( char **papszOptions, char ***ppapszWorkFileOptions )
+
+{
+    CPLString osTmpFileDriver = CSLFetchNameValueDef(
+            papszOptions, "TEMP_FILE_DRIVER", "GTiff");
+    GDALDriverH hDriver = GDALGetDriverByName((const char *) osTmpFileDriver);
+
+    if (hDriver == NULL)
+    {
+        CPLError(CE_Failure, CPLE_AppDefined,
+                 "Given driver is not registered");
+        return NULL;
+    }
+
+    if (GDALGetMetadataItem(hDriver, GDAL_DCAP_CREATE, NULL) == NULL)
+    {
+        CPLError(CE_Failure, CPLE_AppDefined,
+                 "Given driver is incapable of creating temp work files");
+        return NULL;
+    }
+
+    *ppapszWorkFileOptions = NULL;
+    if (osTmpFileDriver == "GTiff") {
+        *ppapszWorkFileOptions = CSLSetNameValue(
+                *ppapszWorkFileOptions, "COMPRESS", "LZW");
+        *ppapszWorkFileOptions = CSLSetNameValue(
+                *ppapszWorkFileOptions, "BIGTIFF", "IF_SAFER");
+    }
+
+    return hDriver;
+}
+
+/************************************************************************/
+/* ==================================================================== */
+/*                     Push-pull pyramid algorithm                      */
+/* ==================================================================== */
+/*                                                                      */
+/*      The valid pixels are averaged into a pyramid of levels of       */
+/*      half resolution ("push"), each level keeping the fraction of    */
+/*      its cells covered by valid pixels as a weight.  The levels      */
+/*      are then blended back from the coarsest to the finest one       */
+/*      ("pull"): the uncovered part of a cell takes the bilinear       */
+/*      interpolation of the coarser level.  This fills the voids       */
+/*      smoothly in time proportional to the number of pixels,          */
+/*      whatever the size of the voids.                                 */
+/*                                                                      */
+/*      The raster is processed by tiles, with a margin of twice the    */
+/*      coarsest cell size around each tile, and the pyramids are       */
+/*      aligned on the coarsest cells of the raster.  An euclidean      */
+/*      distance transform of the valid pixels limits the filling to    */
+/*      the pixels closer than the maximum search distance.             */
+/************************************************************************/
+
+// Minimum size of the tiles.
+#define PUSH_PULL_TILE_SIZE 256
+
+typedef struct
+{
+    // Window of the source strip to process.
+    const float *pafValues;
+    const GByte *pabyMask;
+    int          nWinXSize;
+    int          nWinYSize;
+    int          nLineStride;
+
+    // Part of the window written out.
+    int          nTileXOff;
+    int          nTileYOff;
+    int          nTileXSize;
+    int          nTileYSize;
+    float       *pafOut;
+    GByte       *pabyFiltMask;
+
+    int          nLevels;
+    double       dfMaxSearchDist;
+
+    int          nFilled;
+    CPLErr       eErr;
+} GDALFillNodataTile;
+
+/************************************************************************/
+/*                      GDALFillNodataDistance2()                       */
+/*                                                                      */
+/*      Squared euclidean distance of each pixel of the window to the   */
+/*      nearest valid pixel (HUGE_VAL if there is none), computed       */
+/*      exactly from the distances along the columns.                   */
+/************************************************************************/
+
+static bool GDALFillNodataDistance2( const GDALFillNodataTile *psTile,
+                                     float *pafDist2 )
+
+{
+    const int nW = psTile->nWinXSize;
+    const int nH = psTile->nWinYSize;
+    const double dfInf = HUGE_VAL;
+
+    double *padfF = static_cast<double *>(
+        VSI_MALLOC2_VERBOSE(sizeof(double), MAX(nW, nH)));
+    double *padfD = static_cast<double *>(
+        VSI_MALLOC2_VERBOSE(sizeof(double), nW));
+    double *padfZ = static_cast<double *>(
+        VSI_MALLOC2_VERBOSE(sizeof(double), nW + 1));
+    int *panV = static_cast<int *>(VSI_MALLOC2_VERBOSE(sizeof(int), nW));
+    if( padfF == NULL || padfD == NULL || padfZ == NULL || panV == NULL )
+    {
+        CPLFree(padfF);
+        CPLFree(padfD);
+        CPLFree(padfZ);
+        CPLFree(panV);
+        return false;
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Vertical pass: distance to the nearest valid pixel of the       */
+/*      column.                                                         */
+/* -------------------------------------------------------------------- */
+    for( int iX = 0; iX < nW; iX++ )
+    {
+        double dfDist = dfInf;
+        for( int iY = 0; iY < nH; iY++ )
+        {
+            if( psTile->pabyMask[static_cast<size_t>(iY) * psTile->nLineStride
+                                                                    + iX] )
+                dfDist = 0.0;
+            else if( dfDist < dfInf )
+                dfDist += 1.0;
+            padfF[iY] = dfDist;
+        }
+        dfDist = dfInf;
+        for( int iY = nH - 1; iY >= 0; iY-- )
+        {
+            if( padfF[iY] == 0.0 )
+                dfDist = 0.0;
+            else if( dfDist < dfInf )
+                dfDist += 1.0;
+            dfDist = MIN(dfDist, padfF[iY]);
+            pafDist2[static_cast<size_t>(iY) * nW + iX] =
+                static_cast<float>(dfDist < dfInf ? dfDist * dfDist : dfInf);
+        }
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Horizontal pass.                                                */
+/* -------------------------------------------------------------------- */
+    for( int iY = 0; iY < nH; iY++ )
+    {
+        float *pafRow = pafDist2 + static_cast<size_t>(iY) * nW;
+        for( int q = 0; q < nW; q++ )
+            padfF[q] = pafRow[q];
+
+        GDALDistanceTransform1D( padfF, nW, padfD, panV, padfZ );
+
+        for( int q = 0; q < nW; q++ )
+            pafRow[q] = static_cast<float>(padfD[q]);
+    }
+
+    CPLFree(padfF);
+    CPLFree(padfD);
+    CPLFree(padfZ);
+    CPLFree(panV);
+    return true;
+}
+
+/************************************************************************/
+/*                       GDALFillNodataPullLevel()                      */
+/*                                                                      */
+/*      Blend a level with the bilinear interpolation of the (already   */
+/*      pulled) coarser level.  pafW holds the weights of the level,    */
+/*      which become the coverage of the blended values.                */
+/************************************************************************/
+
+static void GDALFillNodataPullLevel( float *pafV, float *pafW,
+                                     int nW, int nH,
+                                     const float *pafCoarseV,
+                                     const float *pafCoarseW,
+                                     int nCoarseW, int nCoarseH )
+
+{
+    for( int iY = 0; iY < nH; iY++ )
+    {
+        // Coarse rows around the center of the row, and their weights.
+        const int iCY = (iY - 1) >> 1;
+        const float fAY = (iY & 1) ? 0.25f : 0.75f;
+        const int aiCY[2] = { iCY, iCY + 1 };
+        const float afWY[2] = { iCY >= 0 ? fAY : 0.0f,
+                                iCY + 1 < nCoarseH ? 1.0f - fAY : 0.0f };
+
+        for( int iX = 0; iX < nW; iX++ )
+        {
+            const size_t iIdx = static_cast<size_t>(iY) * nW + iX;
+            const float fW = pafW[iIdx];
+            if( fW >= 1.0f )
+                continue;
+
+            const int iCX = (iX - 1) >> 1;
+            const float fAX = (iX & 1) ? 0.25f : 0.75f;
+            const int aiCX[2] = { iCX, iCX + 1 };
+            const float afWX[2] = { iCX >= 0 ? fAX : 0.0f,
+                                    iCX + 1 < nCoarseW ? 1.0f - fAX : 0.0f };
+
+            double dfSumW = 0.0;
+            double dfSumWV = 0.0;
+            double dfSumB = 0.0;
+            for( int j = 0; j < 2; j++ )
+            {
+                for( int i = 0; i < 2; i++ )
+                {
+                    const float fB = afWY[j] * afWX[i];
+                    if( fB == 0.0f )
+                        continue;
+                    const size_t iCIdx =
+                        static_cast<size_t>(aiCY[j]) * nCoarseW + aiCX[i];
+                    dfSumB += fB;
+                    dfSumW += fB * pafCoarseW[iCIdx];
+                    dfSumWV += fB * pafCoarseW[iCIdx] * pafCoarseV[iCIdx];
+                }
+            }
+            if( dfSumW <= 0.0 )
+                continue;
+
+            const double dfUpV = dfSumWV / dfSumW;
+            const double dfUpW = dfSumW / dfSumB;
+            pafV[iIdx] = static_cast<float>(fW * pafV[iIdx] + (1 - fW) * dfUpV);
+            pafW[iIdx] = static_cast<float>(fW + (1 - fW) * dfUpW);
+        }
+    }
+}
+
+/************************************************************************/
+/*                         GDALFillNodataTileJob()                      */
+/************************************************************************/
+
+static void GDALFillNodataTileJob( void *pData )
+
+{
+    GDALFillNodataTile *psTile = static_cast<GDALFillNodataTile *>(pData);
+    const int nW = psTile->nWinXSize;
+    const int nH = psTile->nWinYSize;
+    const int nLevels = psTile->nLevels;
+
+    psTile->nFilled = 0;
+    psTile->eErr = CE_None;
+
+/* -------------------------------------------------------------------- */
+/*      Allocate the levels.                                            */
+/* -------------------------------------------------------------------- */
+    std::vector<float *> apafV( nLevels + 1, static_cast<float *>(NULL) );
+    std::vector<float *> apafW( nLevels + 1, static_cast<float *>(NULL) );
+    std::vector<int> anW( nLevels + 1 );
+    std::vector<int> anH( nLevels + 1 );
+    float *pafDist2 = NULL;
+    bool bOK = true;
+    for( int iLevel = 0; iLevel <= nLevels && bOK; iLevel++ )
+    {
+        anW[iLevel] = iLevel == 0 ? nW : (anW[iLevel-1] + 1) / 2;
+        anH[iLevel] = iLevel == 0 ? nH : (anH[iLevel-1] + 1) / 2;
+        apafV[iLevel] = static_cast<float *>(
+            VSI_MALLOC3_VERBOSE(sizeof(float), anW[iLevel], anH[iLevel]));
+        apafW[iLevel] = static_cast<float *>(
+            VSI_MALLOC3_VERBOSE(sizeof(float), anW[iLevel], anH[iLevel]));
+        bOK = apafV[iLevel] != NULL && apafW[iLevel] != NULL;
+    }
+    if( bOK )
+    {
+        pafDist2 = static_cast<float *>(
+            VSI_MALLOC3_VERBOSE(sizeof(float), nW, nH));
+        bOK = pafDist2 != NULL && GDALFillNodataDistance2( psTile, pafDist2 );
+    }
+
+    if( bOK )
+    {
+/* -------------------------------------------------------------------- */
+/*      Push: average the valid pixels in the coarser levels.           */
+/* -------------------------------------------------------------------- */
+        for( int iY = 0; iY < nH; iY++ )
+        {
+            for( int iX = 0; iX < nW; iX++ )
+            {
+                const size_t iSrc =
+                    static_cast<size_t>(iY) * psTile->nLineStride + iX;
+                const size_t iIdx = static_cast<size_t>(iY) * nW + iX;
+                const bool bValid = psTile->pabyMask[iSrc] != 0;
+                apafV[0][iIdx] = bValid ? psTile->pafValues[iSrc] : 0.0f;
+                apafW[0][iIdx] = bValid ? 1.0f : 0.0f;
+            }
+        }
+
+        for( int iLevel = 1; iLevel <= nLevels; iLevel++ )
+        {
+            const int nFineW = anW[iLevel-1];
+            const int nFineH = anH[iLevel-1];
+            const float *pafFineV = apafV[iLevel-1];
+            const float *pafFineW = apafW[iLevel-1];
+            for( int iY = 0; iY < anH[iLevel]; iY++ )
+            {
+                for( int iX = 0; iX < anW[iLevel]; iX++ )
+                {
+                    double dfSumW = 0.0;
+                    double dfSumWV = 0.0;
+                    for( int iFY = 2 * iY; iFY < MIN(2 * iY + 2, nFineH); iFY++ )
+                    {
+                        for( int iFX = 2 * iX; iFX < MIN(2 * iX + 2, nFineW);
+                             iFX++ )
+                        {
+                            const size_t iFIdx =
+                                static_cast<size_t>(iFY) * nFineW + iFX;
+                            dfSumW += pafFineW[iFIdx];
+                            dfSumWV += pafFineW[iFIdx] * pafFineV[iFIdx];
+                        }
+                    }
+                    const size_t iIdx =
+                        static_cast<size_t>(iY) * anW[iLevel] + iX;
+                    apafV[iLevel][iIdx] = dfSumW > 0 ?
+                        static_cast<float>(dfSumWV / dfSumW) : 0.0f;
+                    apafW[iLevel][iIdx] = static_cast<float>(MIN(1.0, dfSumW));
+                }
+            }
+        }
+
+/* -------------------------------------------------------------------- */
+/*      Pull: blend each level with the coarser one.                    */
+/* -------------------------------------------------------------------- */
+        for( int iLevel = nLevels - 1; iLevel >= 0; iLevel-- )
+        {
+            GDALFillNodataPullLevel( apafV[iLevel], apafW[iLevel],
+                                     anW[iLevel], anH[iLevel],
+                                     apafV[iLevel+1], apafW[iLevel+1],
+                                     anW[iLevel+1], anH[iLevel+1] );
+        }
+
+/* -------------------------------------------------------------------- */
+/*      Write the filled pixels of the tile.                            */
+/* -------------------------------------------------------------------- */
+        // Pixels at exactly the maximum distance of the nearest valid
+        // pixel are not filled.
+        const double dfMaxDist2 =
+            psTile->dfMaxSearchDist * psTile->dfMaxSearchDist;
+        for( int iY = 0; iY < psTile->nTileYSize; iY++ )
+        {
+            const int iWinY = psTile->nTileYOff + iY;
+            for( int iX = 0; iX < psTile->nTileXSize; iX++ )
+            {
+                const int iWinX = psTile->nTileXOff + iX;
+                const size_t iSrc =
+                    static_cast<size_t>(iWinY) * psTile->nLineStride + iWinX;
+                const size_t iIdx = static_cast<size_t>(iWinY) * nW + iWinX;
+                const size_t iDst =
+                    static_cast<size_t>(iY) * psTile->nLineStride + iX;
+                if( psTile->pabyMask[iSrc] || apafW[0][iIdx] <= 0.0f ||
+                    pafDist2[iIdx] >= dfMaxDist2 )
+                    continue;
+                psTile->pafOut[iDst] = apafV[0][iIdx];
+                psTile->pabyFiltMask[iDst] = 255;
+                psTile->nFilled++;
+            }
+        }
+    }
+    else
+        psTile->eErr = CE_Failure;
+
+    for( int iLevel = 0; iLevel <= nLevels; iLevel++ )
+    {
+        CPLFree( apafV[iLevel] );
+        CPLFree( apafW[iLevel] );
+    }
+    CPLFree( pafDist2 );
+}
+
+/************************************************************************/
+/*                       GDALFillNodataPushPull()                       */
+/************************************************************************/
+
+static CPLErr
+GDALFillNodataPushPull( GDALRasterBandH hTargetBand,
+                        GDALRasterBandH hMaskBand,
+                        double dfMaxSearchDist,
+                        int nSmoothingIterations,
+                        char **papszOptions,
+                        GDALProgressFunc pfnProgress,
+                        void * pProgressArg )
+
+{
+    const int nXSize = GDALGetRasterBandXSize( hTargetBand );
+    const int nYSize = GDALGetRasterBandYSize( hTargetBand );
+
+/* -------------------------------------------------------------------- */
+/*      The coarsest cells are at least as large as the search          */
+/*      distance, and the margin around the tiles is twice that size.   */
+/* -------------------------------------------------------------------- */
+    int nLevels = 0;
+    while( nLevels < 30 && (1 << nLevels) < dfMaxSearchDist &&
+           (1 << nLevels) < MAX(nXSize, nYSize) )
+        nLevels++;
+    const int nMargin = 2 << nLevels;
+    const int nTileSize = MAX(PUSH_PULL_TILE_SIZE, 2 * nMargin);
+
+/* -------------------------------------------------------------------- */
+/*      Set up the thread pool.                                         */
+/* -------------------------------------------------------------------- */
+    const int nThreads = CPLGetNumThreads( papszOptions, "1" );
+
+    const int nTilesX = (nXSize + nTileSize - 1) / nTileSize;
+    CPLWorkerThreadPool *poThreadPool = NULL;
+    if( nThreads > 1 && nTilesX > 1 )
+    {
+        poThreadPool = new CPLWorkerThreadPool();
+        if( !poThreadPool->Setup( MIN(nThreads, nTilesX), NULL, NULL ) )
+        {
+            delete poThreadPool;
+            poThreadPool = NULL;
+        }
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Create the mask of the filled pixels for the smoothing.         */
+/* -------------------------------------------------------------------- */
+    GDALDriverH hDriver = NULL;
+    GDALDatasetH hFiltMaskDS = NULL;
+    GDALRasterBandH hFiltMaskBand = NULL;
+    CPLString osFiltMaskTmpFile;
+    CPLErr eErr = CE_None;
+
+    if( nSmoothingIterations > 0 )
+    {
+        char **papszWorkFileOptions = NULL;
+        hDriver = GDALFillNodataWorkDriver( papszOptions,
+                                            &papszWorkFileOptions );
+        if( hDriver != NULL )
+        {
+            osFiltMaskTmpFile =
+                CPLGenerateTempFilename("") + CPLString("fill_filtmask_work.tif");
+            hFiltMaskDS =
+                GDALCreate( hDriver, osFiltMaskTmpFile, nXSize, nYSize, 1,
+                            GDT_Byte, papszWorkFileOptions );
+            if ( hFiltMaskDS == NULL )
+                CPLError(CE_Failure, CPLE_AppDefined,
+                    "Could not create mask work file. Check driver capabilities.");
+            else
+                hFiltMaskBand = GDALGetRasterBand( hFiltMaskDS, 1 );
+        }
+        CSLDestroy( papszWorkFileOptions );
+        if( hFiltMaskDS == NULL )
+            eErr = CE_Failure;
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Allocate the strip of source lines, and of output lines.        */
+/* -------------------------------------------------------------------- */
+    const int nStripLines = MIN(nYSize, nTileSize + 2 * nMargin);
+    const int nOutLines = MIN(nYSize, nTileSize);
+    float *pafValues = NULL;
+    GByte *pabyMask = NULL;
+    float *pafOut = NULL;
+    GByte *pabyFiltMask = NULL;
+    if( eErr == CE_None )
+    {
+        pafValues = static_cast<float *>(
+            VSI_MALLOC3_VERBOSE(sizeof(float), nXSize, nStripLines));
+        pabyMask = static_cast<GByte *>(
+            VSI_MALLOC2_VERBOSE(nXSize, nStripLines));
+        pafOut = static_cast<float *>(
+            VSI_MALLOC3_VERBOSE(sizeof(float), nXSize, nOutLines));
+        pabyFiltMask = static_cast<GByte *>(
+            VSI_MALLOC2_VERBOSE(nXSize, nOutLines));
+        if( pafValues == NULL || pabyMask == NULL || pafOut == NULL ||
+            pabyFiltMask == NULL )
+            eErr = CE_Failure;
+    }
+
+    std::vector<GDALFillNodataTile> asTiles( nTilesX );
+    int nStripStart = 0;
+    int nStripEnd = 0;
+
+    for( int iTileY = 0; iTileY < nYSize && eErr == CE_None;
+         iTileY += nTileSize )
+    {
+        const int nTileYSize = MIN(nTileSize, nYSize - iTileY);
+
+/* -------------------------------------------------------------------- */
+/*      Slide the strip of source lines.  The lines read have not been  */
+/*      written yet.                                                    */
+/* -------------------------------------------------------------------- */
+        const int nNewStart = MAX(0, iTileY - nMargin);
+        const int nNewEnd = MIN(nYSize, iTileY + nTileYSize + nMargin);
+        if( nStripEnd > nNewStart )
+        {
+            memmove( pafValues,
+                     pafValues + static_cast<size_t>(nNewStart - nStripStart) * nXSize,
+                     sizeof(float) * nXSize * (nStripEnd - nNewStart) );
+            memmove( pabyMask,
+                     pabyMask + static_cast<size_t>(nNewStart - nStripStart) * nXSize,
+                     static_cast<size_t>(nXSize) * (nStripEnd - nNewStart) );
+        }
+        const int nReadStart = MAX(nStripEnd, nNewStart);
+        if( nNewEnd > nReadStart )
+        {
+            const size_t nOffset =
+                static_cast<size_t>(nReadStart - nNewStart) * nXSize;
+            eErr = GDALRasterIO( hTargetBand, GF_Read, 0, nReadStart,
+                                 nXSize, nNewEnd - nReadStart,
+                                 pafValues + nOffset, nXSize,
+                                 nNewEnd - nReadStart, GDT_Float32, 0, 0 );
+            if( eErr == CE_None )
+                eErr = GDALRasterIO( hMaskBand, GF_Read, 0, nReadStart,
+                                     nXSize, nNewEnd - nReadStart,
+                                     pabyMask + nOffset, nXSize,
+                                     nNewEnd - nReadStart, GDT_Byte, 0, 0 );
+            if( eErr != CE_None )
+                break;
+        }
+        nStripStart = nNewStart;
+        nStripEnd = nNewEnd;
+
+        memcpy( pafOut,
+                pafValues + static_cast<size_t>(iTileY - nStripStart) * nXSize,
+                sizeof(float) * nXSize * nTileYSize );
+        memset( pabyFiltMask, 0, static_cast<size_t>(nXSize) * nTileYSize );
+
+/* -------------------------------------------------------------------- */
+/*      Fill the tiles of the row.                                      */
+/* -------------------------------------------------------------------- */
+        std::vector<void *> apJobs;
+        for( int iTileX = 0; iTileX < nTilesX; iTileX++ )
+        {
+            const int nTileXOff = iTileX * nTileSize;
+            const int nWinXOff = MAX(0, nTileXOff - nMargin);
+            GDALFillNodataTile *psTile = &asTiles[iTileX];
+            psTile->pafValues = pafValues + nWinXOff;
+            psTile->pabyMask = pabyMask + nWinXOff;
+            psTile->nWinXSize = MIN(nXSize, nTileXOff + nTileSize + nMargin)
+                                                                - nWinXOff;
+            psTile->nWinYSize = nStripEnd - nStripStart;
+            psTile->nLineStride = nXSize;
+            psTile->nTileXOff = nTileXOff - nWinXOff;
+            psTile->nTileYOff = iTileY - nStripStart;
+            psTile->nTileXSize = MIN(nTileSize, nXSize - nTileXOff);
+            psTile->nTileYSize = nTileYSize;
+            psTile->pafOut = pafOut + nTileXOff;
+            psTile->pabyFiltMask = pabyFiltMask + nTileXOff;
+            psTile->nLevels = nLevels;
+            psTile->dfMaxSearchDist = dfMaxSearchDist;
+            apJobs.push_back( psTile );
+        }
+
+        // On failure, no job has been queued: run them here.
+        if( poThreadPool != NULL &&
+            poThreadPool->SubmitJobs( GDALFillNodataTileJob, apJobs ) )
+        {
+            poThreadPool->WaitCompletion();
+        }
+        else
+        {
+            for( size_t i = 0; i < apJobs.size(); i++ )
+                GDALFillNodataTileJob( apJobs[i] );
+        }
+
+        int nFilled = 0;
+        for( int iTileX = 0; iTileX < nTilesX; iTileX++ )
+        {
+            if( asTiles[iTileX].eErr != CE_None )
+                eErr = CE_Failure;
+            nFilled += asTiles[iTileX].nFilled;
+        }
+
+/* -------------------------------------------------------------------- */
+/*      Write out the filled lines.                                     */
+/* -------------------------------------------------------------------- */
+        if( eErr == CE_None && nFilled > 0 )
+            eErr = GDALRasterIO( hTargetBand, GF_Write, 0, iTileY,
+                                 nXSize, nTileYSize, pafOut,
+                                 nXSize, nTileYSize, GDT_Float32, 0, 0 );
+        if( eErr == CE_None && hFiltMaskBand != NULL )
+            eErr = GDALRasterIO( hFiltMaskBand, GF_Write, 0, iTileY,
+                                 nXSize, nTileYSize, pabyFiltMask,
+                                 nXSize, nTileYSize, GDT_Byte, 0, 0 );
+
+        if( eErr == CE_None
+            && !pfnProgress( (nSmoothingIterations > 0 ? 0.9 : 1.0) *
+                                (iTileY + nTileYSize) / (double)nYSize,
+                             "Filling...", pProgressArg ) )
+        {
+            CPLError( CE_Failure, CPLE_UserInterrupt, "User terminated" );
+            eErr = CE_Failure;
+        }
+    }
+
+    CPLFree( pafValues );
+    CPLFree( pabyMask );
+    CPLFree( pafOut );
+    CPLFree( pabyFiltMask );
+    delete poThreadPool;
+
+/* -------------------------------------------------------------------- */
+/*      Smooth the filled pixels.                                       */
+/* -------------------------------------------------------------------- */
+    if( eErr == CE_None && hFiltMaskBand != NULL )
+    {
+        // force masks to be to flushed and recomputed.
+        GDALFlushRasterCache( hMaskBand );
+
+        void *pScaledProgress =
+            GDALCreateScaledProgress( 0.9, 1.0, pfnProgress, NULL );
+
+        eErr = GDALMultiFilter( hTargetBand, hMaskBand, hFiltMaskBand,
+                                nSmoothingIterations,
+                                GDALScaledProgress, pScaledProgress );
+
+        GDALDestroyScaledProgress( pScaledProgress );
+    }
+
+    if( hFiltMaskDS != NULL )
+    {
+        GDALClose( hFiltMaskDS );
+        GDALDeleteDataset( hDriver, osFiltMaskTmpFile );
+    }
+
+    return eErr;
+}
+
 /************************************************************************/
 /*                           GDALFillNodata()                           */
 /************************************************************************/
@@ -369,6 +1000,24 @@ if( quad_value != nNoDataVal ) 						\
  * is generally not so great for interpolating a raster from sparse
  * point data - see the algorithms defined in gdal_grid.h for that case.
  *
+ * The search of this algorithm is proportional to the size of the
+ * nodata regions.  Starting with GDAL 2.2, the ALGORITHM=PUSH_PULL option
+ * selects an alternative algorithm, in time proportional to the number
+ * of pixels: the valid pixels are averaged in a pyramid of coarser
+ * levels, which are then blended back from the coarsest to the finest
+ * level into the nodata regions.  The result is smooth, and is limited to
+ * the pixels strictly closer than dfMaxSearchDist to a valid pixel, computed
+ * with an exact distance transform.  The quadrant search only looks at the
+ * nearest valid pixels of its scan lines, so it does not fill exactly the
+ * same pixels: it may leave some of them at nodata.  The raster is
+ * processed by tiles, which can be processed in parallel by setting the
+ * NUM_THREADS option, or the GDAL_NUM_THREADS configuration option, to a
+ * number of threads or ALL_CPUS.  The result does not depend on the number
+ * of threads, nor on the tiling.  Each tile is processed with a margin of
+ * 2 << nLevels pixels, nLevels being the number of pyramid levels needed to
+ * reach dfMaxSearchDist, so the memory used grows with the square of
+ * dfMaxSearchDist.
+ *
  * @param hTargetBand the raster band to be modified in place.
  * @param hMaskBand a mask band indicating pixels to be interpolated (zero valued
  * @param dfMaxSearchDist the maximum number of pixels to search in all
@@ -377,7 +1026,8 @@ if( quad_value != nNoDataVal ) 						\
  * @param nSmoothingIterations the number of 3x3 smoothing filter passes to
  * run (0 or more).
  * @param papszOptions additional name=value options in a string list (the
- * temporary file driver can be specified like TEMP_FILE_DRIVER=MEM).
+ * temporary file driver can be specified like TEMP_FILE_DRIVER=MEM, and
+ * the algorithm with ALGORITHM=QUADRANT_SEARCH or PUSH_PULL).
  * @param pfnProgress the progress function to report completion.
  * @param pProgressArg callback data for progress function.
  *
@@ -424,6 +1074,24 @@ GDALFillNodata( GDALRasterBandH hTargetBand,
     if( hMaskBand == NULL )
         hMaskBand = GDALGetMaskBand( hTargetBand );
 
+    const char *pszAlgorithm =
+        CSLFetchNameValueDef( papszOptions, "ALGORITHM", "QUADRANT_SEARCH" );
+    if( EQUAL(pszAlgorithm, "PUSH_PULL") )
+    {
+        if( pfnProgress == NULL )
+            pfnProgress = GDALDummyProgress;
+        return GDALFillNodataPushPull( hTargetBand, hMaskBand,
+                                       dfMaxSearchDist, nSmoothingIterations,
+                                       papszOptions,
+                                       pfnProgress, pProgressArg );
+    }
+    else if( !EQUAL(pszAlgorithm, "QUADRANT_SEARCH") )
+    {
+        CPLError( CE_Failure, CPLE_NotSupported,
+                  "Unsupported value for ALGORITHM: %s", pszAlgorithm );
+        return CE_Failure;
+    }
+
     /* If there are smoothing iterations, reserve 10% of the progress for them */
     double dfProgressRatio = (nSmoothingIterations > 0) ? 0.9 : 1.0;
 
@@ -442,31 +1110,11 @@ GDALFillNodata( GDALRasterBandH hTargetBand,
 /* -------------------------------------------------------------------- */
 /*      Determine format driver for temp work files.                    */
 /* -------------------------------------------------------------------- */
-    CPLString osTmpFileDriver = CSLFetchNameValueDef(
-            papszOptions, "TEMP_FILE_DRIVER", "GTiff");
-    GDALDriverH hDriver = GDALGetDriverByName((const char *) osTmpFileDriver);
-
+    char **papszWorkFileOptions = NULL;
+    GDALDriverH hDriver = GDALFillNodataWorkDriver( papszOptions,
+                                                    &papszWorkFileOptions );
     if (hDriver == NULL)
-    {
-        CPLError(CE_Failure, CPLE_AppDefined,
-                 "Given driver is not registered");
         return CE_Failure;
-    }
-
-    if (GDALGetMetadataItem(hDriver, GDAL_DCAP_CREATE, NULL) == NULL)
-    {
-        CPLError(CE_Failure, CPLE_AppDefined,
-                 "Given driver is incapable of creating temp work files");
-        return CE_Failure;
-    }
-
-    char **papszWorkFileOptions = NULL;
-    if (osTmpFileDriver == "GTiff") {
-        papszWorkFileOptions = CSLSetNameValue(
-                papszWorkFileOptions, "COMPRESS", "LZW");
-        papszWorkFileOptions = CSLSetNameValue(
-                papszWorkFileOptions, "BIGTIFF", "IF_SAFER");
-    }
 
 /* -------------------------------------------------------------------- */
 /*      Create a work file to hold the Y "last value" indices.          */
@@ -95,6 +95,9 @@
 #include "gdal.h"
 #include "gdal_priv.h"
 #include "gdal_utils_priv.h"
+#include "gdalsse_priv.h"
+#include "cpl_worker_thread_pool.h"
+#include <vector>
 
 CPL_CVSID("$Id$");
 
@@ -172,22 +175,205 @@ static float ComputeVal(int bSrcHasNoData, float fSrcNoDataValue,
     return pfnAlg(afWin, fDstNoDataValue, pData);
 }
 
+/************************************************************************/
+/*                      GDALGeneric3x3LineContext                       */
+/************************************************************************/
+
+/* Computes pafOutputBuf[1] to pafOutputBuf[nXSize-2] from three source */
+/* lines, as pfnAlg would do on each 3x3 window, ignoring nodata.       */
+typedef void (*GDALGeneric3x3ProcessingLineAlg) (const float* pafLine1,
+                                                 const float* pafLine2,
+                                                 const float* pafLine3,
+                                                 int nXSize,
+                                                 float* pafOutputBuf,
+                                                 void* pData);
+
+typedef struct
+{
+    GDALGeneric3x3ProcessingAlg     pfnAlg;
+    GDALGeneric3x3ProcessingLineAlg pfnLineAlg; /* may be NULL */
+    void*   pData;
+    int     nXSize;
+    int     bSrcHasNoData;
+    float   fSrcNoDataValue;
+    int     bIsSrcNoDataNan;
+    float   fDstNoDataValue;
+    int     bComputeAtEdges;
+} GDALGeneric3x3LineContext;
+
+/************************************************************************/
+/*                     GDALGeneric3x3ProcessLine()                      */
+/*                                                                      */
+/*      Compute one line that is neither the first nor the last one     */
+/*      of the raster.  The line algorithm, if any, processes the       */
+/*      whole line at once, and the pixels whose window contains        */
+/*      nodata are computed again one by one.                           */
+/************************************************************************/
+
+static void GDALGeneric3x3ProcessLine( const GDALGeneric3x3LineContext* psCtx,
+                                       const float* pafLine1,
+                                       const float* pafLine2,
+                                       const float* pafLine3,
+                                       float* pafOutputBuf,
+                                       GByte* pabyNoData )
+{
+    const int nXSize = psCtx->nXSize;
+    const int bSrcHasNoData = psCtx->bSrcHasNoData;
+    const float fSrcNoDataValue = psCtx->fSrcNoDataValue;
+    const int bIsSrcNoDataNan = psCtx->bIsSrcNoDataNan;
+    const float fDstNoDataValue = psCtx->fDstNoDataValue;
+    const int bComputeAtEdges = psCtx->bComputeAtEdges;
+    int j;
+
+    if (bComputeAtEdges && nXSize >= 2)
+    {
+        float afWin[9];
+
+        j = 0;
+        afWin[0] = INTERPOL(pafLine1[j], pafLine1[j+1]);
+        afWin[1] = pafLine1[j];
+        afWin[2] = pafLine1[j+1];
+        afWin[3] = INTERPOL(pafLine2[j], pafLine2[j+1]);
+        afWin[4] = pafLine2[j];
+        afWin[5] = pafLine2[j+1];
+        afWin[6] = INTERPOL(pafLine3[j], pafLine3[j+1]);
+        afWin[7] = pafLine3[j];
+        afWin[8] = pafLine3[j+1];
+
+        pafOutputBuf[j] = ComputeVal(bSrcHasNoData, fSrcNoDataValue,
+                                     bIsSrcNoDataNan,
+                                     afWin, fDstNoDataValue,
+                                     psCtx->pfnAlg, psCtx->pData,
+                                     bComputeAtEdges);
+        j = nXSize - 1;
+
+        afWin[0] = pafLine1[j-1];
+        afWin[1] = pafLine1[j];
+        afWin[2] = INTERPOL(pafLine1[j], pafLine1[j-1]);
+        afWin[3] = pafLine2[j-1];
+        afWin[4] = pafLine2[j];
+        afWin[5] = INTERPOL(pafLine2[j], pafLine2[j-1]);
+        afWin[6] = pafLine3[j-1];
+        afWin[7] = pafLine3[j];
+        afWin[8] = INTERPOL(pafLine3[j], pafLine3[j-1]);
+
+        pafOutputBuf[j] = ComputeVal(bSrcHasNoData, fSrcNoDataValue,
+                                     bIsSrcNoDataNan,
+                                     afWin, fDstNoDataValue,
+                                     psCtx->pfnAlg, psCtx->pData,
+                                     bComputeAtEdges);
+    }
+    else
+    {
+        // Exclude the edges
+        pafOutputBuf[0] = fDstNoDataValue;
+        if (nXSize > 1)
+            pafOutputBuf[nXSize - 1] = fDstNoDataValue;
+    }
+
+    if (nXSize < 3)
+        return;
+
+    if (psCtx->pfnLineAlg != NULL)
+    {
+        psCtx->pfnLineAlg(pafLine1, pafLine2, pafLine3, nXSize,
+                          pafOutputBuf, psCtx->pData);
+        if (!bSrcHasNoData)
+            return;
+
+        // Flag the columns having nodata in one of the three lines.
+        for (j = 0; j < nXSize; j++)
+        {
+            if (bIsSrcNoDataNan)
+                pabyNoData[j] = CPLIsNan(pafLine1[j]) ||
+                                CPLIsNan(pafLine2[j]) ||
+                                CPLIsNan(pafLine3[j]);
+            else
+                pabyNoData[j] = ARE_REAL_EQUAL(pafLine1[j], fSrcNoDataValue) ||
+                                ARE_REAL_EQUAL(pafLine2[j], fSrcNoDataValue) ||
+                                ARE_REAL_EQUAL(pafLine3[j], fSrcNoDataValue);
+        }
+    }
+
+    for (j = 1; j < nXSize - 1; j++)
+    {
+        if (psCtx->pfnLineAlg != NULL &&
+            !(pabyNoData[j-1] | pabyNoData[j] | pabyNoData[j+1]))
+            continue;
+
+        float afWin[9];
+        afWin[0] = pafLine1[j-1];
+        afWin[1] = pafLine1[j];
+        afWin[2] = pafLine1[j+1];
+        afWin[3] = pafLine2[j-1];
+        afWin[4] = pafLine2[j];
+        afWin[5] = pafLine2[j+1];
+        afWin[6] = pafLine3[j-1];
+        afWin[7] = pafLine3[j];
+        afWin[8] = pafLine3[j+1];
+
+        pafOutputBuf[j] = ComputeVal(bSrcHasNoData, fSrcNoDataValue,
+                                     bIsSrcNoDataNan,
+                                     afWin, fDstNoDataValue,
+                                     psCtx->pfnAlg, psCtx->pData,
+                                     bComputeAtEdges);
+    }
+}
+
+/************************************************************************/
+/*                      GDALGeneric3x3LinesJob                          */
+/************************************************************************/
+
+typedef struct
+{
+    const GDALGeneric3x3LineContext* psCtx;
+    const float* pafInput;   /* nLines + 2 source lines */
+    float*       pafOutput;  /* nLines output lines */
+    int          nLines;
+} GDALGeneric3x3LinesJob;
+
+static void GDALGeneric3x3LinesJobFunc( void* pData )
+{
+    GDALGeneric3x3LinesJob* psJob = (GDALGeneric3x3LinesJob*) pData;
+    const size_t nXSize = psJob->psCtx->nXSize;
+    std::vector<GByte> abyNoData(nXSize);
+
+    for( int i = 0; i < psJob->nLines; i++ )
+    {
+        GDALGeneric3x3ProcessLine(psJob->psCtx,
+                                  psJob->pafInput + i * nXSize,
+                                  psJob->pafInput + (i + 1) * nXSize,
+                                  psJob->pafInput + (i + 2) * nXSize,
+                                  psJob->pafOutput + i * nXSize,
+                                  &abyNoData[0]);
+    }
+}
+
 /************************************************************************/
 /*                  GDALGeneric3x3Processing()                          */
+/*                                                                      */
+/*      The lines between the first and the last ones are processed     */
+/*      by batches: the source lines of a batch, with one more line     */
+/*      above and below, are read at once, and the batch is split in    */
+/*      strips of lines computed by the threads of GDAL_NUM_THREADS.    */
 /************************************************************************/
 
 static
 CPLErr GDALGeneric3x3Processing  ( GDALRasterBandH hSrcBand,
                                    GDALRasterBandH hDstBand,
                                    GDALGeneric3x3ProcessingAlg pfnAlg,
+                                   GDALGeneric3x3ProcessingLineAlg pfnLineAlg,
                                    void* pData,
                                    int bComputeAtEdges,
                                    GDALProgressFunc pfnProgress,
                                    void * pProgressData)
 {
-    CPLErr eErr;
+    CPLErr eErr = CE_None;
     float *pafThreeLineWin; /* 3 line rotating source buffer */
     float *pafOutputBuf;     /* 1 line destination buffer */
+    float *pafBatchInput = NULL;
+    float *pafBatchOutput = NULL;
+    CPLWorkerThreadPool *poThreadPool = NULL;
     int i, j;
 
     int bSrcHasNoData, bDstHasNoData;
@@ -208,24 +394,60 @@ CPLErr GDALGeneric3x3Processing  ( GDALRasterBandH hSrcBand,
         return CE_Failure;
     }
 
+/* -------------------------------------------------------------------- */
+/*      Set up the threads and the batches of lines.                    */
+/* -------------------------------------------------------------------- */
+    int nThreads = CPLGetNumThreads(NULL, "1");
+    if (nThreads > 1)
+    {
+        poThreadPool = new CPLWorkerThreadPool();
+        if (!poThreadPool->Setup(nThreads, NULL, NULL))
+        {
+            delete poThreadPool;
+            poThreadPool = NULL;
+        }
+    }
+    if (poThreadPool == NULL)
+        nThreads = 1;
+
+    // At most about 16 MB of source lines per batch.
+    const int nBatchLines = std::max(1, std::min(16 * nThreads,
+                              (16 * 1024 * 1024) / (std::max(1, nXSize) *
+                                                    (int)sizeof(float))));
+
     pafOutputBuf = (float *) VSI_MALLOC2_VERBOSE(sizeof(float),nXSize);
     pafThreeLineWin  = (float *) VSI_MALLOC2_VERBOSE(3*sizeof(float),(nXSize+1));
-    if( pafOutputBuf == NULL || pafThreeLineWin == NULL )
+    if (nYSize > 2)
     {
-        VSIFree(pafOutputBuf);
-        VSIFree(pafThreeLineWin);
-        return CE_Failure;
+        pafBatchInput = (float *) VSI_MALLOC3_VERBOSE(sizeof(float), nXSize,
+                                                      nBatchLines + 2);
+        pafBatchOutput = (float *) VSI_MALLOC3_VERBOSE(sizeof(float), nXSize,
+                                                       nBatchLines);
+    }
+    if( pafOutputBuf == NULL || pafThreeLineWin == NULL ||
+        (nYSize > 2 && (pafBatchInput == NULL || pafBatchOutput == NULL)) )
+    {
+        eErr = CE_Failure;
+        goto end;
     }
 
     fSrcNoDataValue = (float) GDALGetRasterNoDataValue(hSrcBand, &bSrcHasNoData);
     fDstNoDataValue = (float) GDALGetRasterNoDataValue(hDstBand, &bDstHasNoData);
     if (!bDstHasNoData)
         fDstNoDataValue = 0.0;
+    {
     int bIsSrcNoDataNan = bSrcHasNoData && CPLIsNan(fSrcNoDataValue);
 
-    int nLine1Off = 0*nXSize;
-    int nLine2Off = 1*nXSize;
-    int nLine3Off = 2*nXSize;
+    GDALGeneric3x3LineContext sCtx;
+    sCtx.pfnAlg = pfnAlg;
+    sCtx.pfnLineAlg = pfnLineAlg;
+    sCtx.pData = pData;
+    sCtx.nXSize = nXSize;
+    sCtx.bSrcHasNoData = bSrcHasNoData;
+    sCtx.fSrcNoDataValue = fSrcNoDataValue;
+    sCtx.bIsSrcNoDataNan = bIsSrcNoDataNan;
+    sCtx.fDstNoDataValue = fDstNoDataValue;
+    sCtx.bComputeAtEdges = bComputeAtEdges;
 
     // Move a 3x3 pafWindow over each cell
     // (where the cell in question is #4)
@@ -299,107 +521,83 @@ CPLErr GDALGeneric3x3Processing  ( GDALRasterBandH hSrcBand,
     if( eErr != CE_None )
         goto end;
 
-
-    for ( i = 1; i < nYSize-1; i++)
+/* -------------------------------------------------------------------- */
+/*      Process the lines in between by batches.                        */
+/* -------------------------------------------------------------------- */
+    for ( i = 1; i < nYSize-1; i += nBatchLines)
     {
-        /* Read third line of the line buffer */
+        const int nLines = std::min(nBatchLines, nYSize - 1 - i);
+
+        /* Read the lines of the batch, and the ones above and below */
         eErr = GDALRasterIO(   hSrcBand,
                         GF_Read,
-                        0, i+1,
-                        nXSize, 1,
-                        pafThreeLineWin + nLine3Off,
-                        nXSize, 1,
+                        0, i-1,
+                        nXSize, nLines + 2,
+                        pafBatchInput,
+                        nXSize, nLines + 2,
                         GDT_Float32,
                         0, 0);
         if (eErr != CE_None)
             goto end;
 
-        if (bComputeAtEdges && nXSize >= 2)
+        const int nJobs = std::min(nThreads, nLines);
+        std::vector<GDALGeneric3x3LinesJob> asJobs(nJobs);
+        std::vector<void*> apJobs;
+        for( int iJob = 0; iJob < nJobs; iJob++ )
         {
-            float afWin[9];
-
-            j = 0;
-            afWin[0] = INTERPOL(pafThreeLineWin[nLine1Off + j], pafThreeLineWin[nLine1Off + j+1]);
-            afWin[1] = pafThreeLineWin[nLine1Off + j];
-            afWin[2] = pafThreeLineWin[nLine1Off + j+1];
-            afWin[3] = INTERPOL(pafThreeLineWin[nLine2Off + j], pafThreeLineWin[nLine2Off + j+1]);
-            afWin[4] = pafThreeLineWin[nLine2Off + j];
-            afWin[5] = pafThreeLineWin[nLine2Off + j+1];
-            afWin[6] = INTERPOL(pafThreeLineWin[nLine3Off + j], pafThreeLineWin[nLine3Off + j+1]);
-            afWin[7] = pafThreeLineWin[nLine3Off + j];
-            afWin[8] = pafThreeLineWin[nLine3Off + j+1];
-
-            pafOutputBuf[j] = ComputeVal(bSrcHasNoData, fSrcNoDataValue,
-                                         bIsSrcNoDataNan,
-                                         afWin, fDstNoDataValue,
-                                         pfnAlg, pData, bComputeAtEdges);
-            j = nXSize - 1;
-
-            afWin[0] = pafThreeLineWin[nLine1Off + j-1];
-            afWin[1] = pafThreeLineWin[nLine1Off + j];
-            afWin[2] = INTERPOL(pafThreeLineWin[nLine1Off + j], pafThreeLineWin[nLine1Off + j-1]);
-            afWin[3] = pafThreeLineWin[nLine2Off + j-1];
-            afWin[4] = pafThreeLineWin[nLine2Off + j];
-            afWin[5] = INTERPOL(pafThreeLineWin[nLine2Off + j], pafThreeLineWin[nLine2Off + j-1]);
-            afWin[6] = pafThreeLineWin[nLine3Off + j-1];
-            afWin[7] = pafThreeLineWin[nLine3Off + j];
-            afWin[8] = INTERPOL(pafThreeLineWin[nLine3Off + j], pafThreeLineWin[nLine3Off + j-1]);
-
-            pafOutputBuf[j] = ComputeVal(bSrcHasNoData, fSrcNoDataValue,
-                                         bIsSrcNoDataNan,
-                                         afWin, fDstNoDataValue,
-                                         pfnAlg, pData, bComputeAtEdges);
+            const int iStart = nLines * iJob / nJobs;
+            const int iEnd = nLines * (iJob + 1) / nJobs;
+            asJobs[iJob].psCtx = &sCtx;
+            asJobs[iJob].pafInput = pafBatchInput + (size_t)iStart * nXSize;
+            asJobs[iJob].pafOutput = pafBatchOutput + (size_t)iStart * nXSize;
+            asJobs[iJob].nLines = iEnd - iStart;
+            apJobs.push_back(&asJobs[iJob]);
         }
-        else
+        // On failure, no job has been queued: run them here.
+        if (poThreadPool != NULL && nJobs > 1 &&
+            poThreadPool->SubmitJobs(GDALGeneric3x3LinesJobFunc, apJobs))
         {
-            // Exclude the edges
-            pafOutputBuf[0] = fDstNoDataValue;
-            if (nXSize > 1)
-                pafOutputBuf[nXSize - 1] = fDstNoDataValue;
+            poThreadPool->WaitCompletion();
         }
-
-        for (j = 1; j < nXSize - 1; j++)
+        else
         {
-            float afWin[9];
-            afWin[0] = pafThreeLineWin[nLine1Off + j-1];
-            afWin[1] = pafThreeLineWin[nLine1Off + j];
-            afWin[2] = pafThreeLineWin[nLine1Off + j+1];
-            afWin[3] = pafThreeLineWin[nLine2Off + j-1];
-            afWin[4] = pafThreeLineWin[nLine2Off + j];
-            afWin[5] = pafThreeLineWin[nLine2Off + j+1];
-            afWin[6] = pafThreeLineWin[nLine3Off + j-1];
-            afWin[7] = pafThreeLineWin[nLine3Off + j];
-            afWin[8] = pafThreeLineWin[nLine3Off + j+1];
-
-            pafOutputBuf[j] = ComputeVal(bSrcHasNoData, fSrcNoDataValue,
-                                         bIsSrcNoDataNan,
-                                         afWin, fDstNoDataValue,
-                                         pfnAlg, pData, bComputeAtEdges);
+            for( int iJob = 0; iJob < nJobs; iJob++ )
+                GDALGeneric3x3LinesJobFunc(apJobs[iJob]);
         }
 
         /* -----------------------------------------
-         * Write Line to Raster
+         * Write Lines to Raster
          */
-        eErr = GDALRasterIO(hDstBand, GF_Write, 0, i, nXSize, 1,
-                     pafOutputBuf, nXSize, 1, GDT_Float32, 0, 0);
+        eErr = GDALRasterIO(hDstBand, GF_Write, 0, i, nXSize, nLines,
+                     pafBatchOutput, nXSize, nLines, GDT_Float32, 0, 0);
         if (eErr != CE_None)
             goto end;
 
-        if( !pfnProgress( 1.0 * (i+1) / nYSize, NULL, pProgressData ) )
+        if( !pfnProgress( 1.0 * (i+nLines) / nYSize, NULL, pProgressData ) )
         {
             CPLError( CE_Failure, CPLE_UserInterrupt, "User terminated" );
             eErr = CE_Failure;
             goto end;
         }
-
-        int nTemp = nLine1Off;
-        nLine1Off = nLine2Off;
-        nLine2Off = nLine3Off;
-        nLine3Off = nTemp;
     }
 
     if (bComputeAtEdges && nXSize >= 2 && nYSize >= 2)
     {
+        /* Load the last 2 lines */
+        eErr = GDALRasterIO(   hSrcBand,
+                        GF_Read,
+                        0, nYSize - 2,
+                        nXSize, 2,
+                        pafThreeLineWin,
+                        nXSize, 2,
+                        GDT_Float32,
+                        0, 0);
+        if (eErr != CE_None)
+            goto end;
+
+        const int nLine1Off = 0;
+        const int nLine2Off = nXSize;
+
         for (j = 0; j < nXSize; j++)
         {
             float afWin[9];
@@ -422,18 +620,22 @@ CPLErr GDALGeneric3x3Processing  ( GDALRasterBandH hSrcBand,
                                          pfnAlg, pData, bComputeAtEdges);
         }
         eErr = GDALRasterIO(hDstBand, GF_Write,
-                     0, i, nXSize, 1,
+                     0, nYSize - 1, nXSize, 1,
                      pafOutputBuf, nXSize, 1, GDT_Float32, 0, 0);
         if( eErr != CE_None )
             goto end;
     }
+    }
 
     pfnProgress( 1.0, NULL, pProgressData );
     eErr = CE_None;
 
 end:
+    delete poThreadPool;
     CPLFree(pafOutputBuf);
     CPLFree(pafThreeLineWin);
+    CPLFree(pafBatchInput);
+    CPLFree(pafBatchOutput);
 
     return eErr;
 }
@@ -448,8 +650,8 @@ typedef struct
     double nsres;
     double ewres;
     double sin_altRadians;
-    double cos_altRadians_mul_z_scale_factor;
-    double azRadians;
+    double cos_az_mul_cos_alt_mul_z_scale_factor;
+    double sin_az_mul_cos_alt_mul_z_scale_factor;
     double square_z_scale_factor;
     double square_M_PI_2;
 } GDALHillshadeAlgData;
@@ -470,36 +672,40 @@ typedef struct
     cang = sin(alt * degreesToRadians) * sin(slope) +
            cos(alt * degreesToRadians) * cos(slope) *
            cos(az * degreesToRadians - M_PI/2 - aspect);
+
+   As sqrt(x*x + y*y) * sin(aspect - az) = y * cos(az) - x * sin(az),
+   the aspect does not need to be computed:
+
+    cang = (sin(alt) - cos(alt) * z_scale_factor *
+            (y * cos(az) - x * sin(az))) /
+           sqrt(1 + square_z_scale_factor * (x*x + y*y))
 */
 
 static
 float GDALHillshadeAlg (float* afWin, CPL_UNUSED float fDstNoDataValue, void* pData)
 {
     GDALHillshadeAlgData* psData = (GDALHillshadeAlgData*)pData;
-    double x, y, aspect, xx_plus_yy, cang;
+    double x, y, xx_plus_yy, cang;
 
     // First Slope ...
-    x = ((afWin[0] + afWin[3] + afWin[3] + afWin[6]) -
-        (afWin[2] + afWin[5] + afWin[5] + afWin[8])) / psData->ewres;
+    x = (((double)afWin[0] + afWin[3] + afWin[3] + afWin[6]) -
+        ((double)afWin[2] + afWin[5] + afWin[5] + afWin[8])) / psData->ewres;
 
-    y = ((afWin[6] + afWin[7] + afWin[7] + afWin[8]) -
-        (afWin[0] + afWin[1] + afWin[1] + afWin[2])) / psData->nsres;
+    y = (((double)afWin[6] + afWin[7] + afWin[7] + afWin[8]) -
+        ((double)afWin[0] + afWin[1] + afWin[1] + afWin[2])) / psData->nsres;
 
     xx_plus_yy = x * x + y * y;
 
-    // ... then aspect...
-    aspect = atan2(y,x);
-
     // ... then the shade value
     cang = (psData->sin_altRadians -
-           psData->cos_altRadians_mul_z_scale_factor * sqrt(xx_plus_yy) *
-           sin(aspect - psData->azRadians)) /
+           (y * psData->cos_az_mul_cos_alt_mul_z_scale_factor -
+            x * psData->sin_az_mul_cos_alt_mul_z_scale_factor)) /
            sqrt(1 + psData->square_z_scale_factor * xx_plus_yy);
 
-    if (cang <= 0.0)
-        cang = 1.0;
-    else
+    if (cang > 0.0)
         cang = 1.0 + (254.0 * cang);
+    else
+        cang = 1.0;
 
     return (float) cang;
 }
@@ -508,25 +714,22 @@ static
 float GDALHillshadeCombinedAlg (float* afWin, CPL_UNUSED float fDstNoDataValue, void* pData)
 {
     GDALHillshadeAlgData* psData = (GDALHillshadeAlgData*)pData;
-    double x, y, aspect, xx_plus_yy, cang;
+    double x, y, xx_plus_yy, cang;
 
     // First Slope ...
-    x = ((afWin[0] + afWin[3] + afWin[3] + afWin[6]) -
-        (afWin[2] + afWin[5] + afWin[5] + afWin[8])) / psData->ewres;
+    x = (((double)afWin[0] + afWin[3] + afWin[3] + afWin[6]) -
+        ((double)afWin[2] + afWin[5] + afWin[5] + afWin[8])) / psData->ewres;
 
-    y = ((afWin[6] + afWin[7] + afWin[7] + afWin[8]) -
-        (afWin[0] + afWin[1] + afWin[1] + afWin[2])) / psData->nsres;
+    y = (((double)afWin[6] + afWin[7] + afWin[7] + afWin[8]) -
+        ((double)afWin[0] + afWin[1] + afWin[1] + afWin[2])) / psData->nsres;
 
     xx_plus_yy = x * x + y * y;
-
-    // ... then aspect...
-    aspect = atan2(y,x);
     double slope = xx_plus_yy * psData->square_z_scale_factor;
 
     // ... then the shade value
     cang = acos((psData->sin_altRadians -
-           psData->cos_altRadians_mul_z_scale_factor * sqrt(xx_plus_yy) *
-           sin(aspect - psData->azRadians)) /
+           (y * psData->cos_az_mul_cos_alt_mul_z_scale_factor -
+            x * psData->sin_az_mul_cos_alt_mul_z_scale_factor)) /
            sqrt(1 + slope));
 
     // combined shading
@@ -544,28 +747,25 @@ static
 float GDALHillshadeZevenbergenThorneAlg (float* afWin, CPL_UNUSED float fDstNoDataValue, void* pData)
 {
     GDALHillshadeAlgData* psData = (GDALHillshadeAlgData*)pData;
-    double x, y, aspect, xx_plus_yy, cang;
+    double x, y, xx_plus_yy, cang;
 
     // First Slope ...
-    x = (afWin[3] - afWin[5]) / psData->ewres;
+    x = ((double)afWin[3] - afWin[5]) / psData->ewres;
 
-    y = (afWin[7] - afWin[1]) / psData->nsres;
+    y = ((double)afWin[7] - afWin[1]) / psData->nsres;
 
     xx_plus_yy = x * x + y * y;
 
-    // ... then aspect...
-    aspect = atan2(y,x);
-
     // ... then the shade value
     cang = (psData->sin_altRadians -
-           psData->cos_altRadians_mul_z_scale_factor * sqrt(xx_plus_yy) *
-           sin(aspect - psData->azRadians)) /
+           (y * psData->cos_az_mul_cos_alt_mul_z_scale_factor -
+            x * psData->sin_az_mul_cos_alt_mul_z_scale_factor)) /
            sqrt(1 + psData->square_z_scale_factor * xx_plus_yy);
 
-    if (cang <= 0.0)
-        cang = 1.0;
-    else
+    if (cang > 0.0)
         cang = 1.0 + (254.0 * cang);
+    else
+        cang = 1.0;
 
     return (float) cang;
 }
@@ -574,23 +774,20 @@ static
 float GDALHillshadeZevenbergenThorneCombinedAlg (float* afWin, CPL_UNUSED float fDstNoDataValue, void* pData)
 {
     GDALHillshadeAlgData* psData = (GDALHillshadeAlgData*)pData;
-    double x, y, aspect, xx_plus_yy, cang;
+    double x, y, xx_plus_yy, cang;
 
     // First Slope ...
-    x = (afWin[3] - afWin[5]) / psData->ewres;
+    x = ((double)afWin[3] - afWin[5]) / psData->ewres;
 
-    y = (afWin[7] - afWin[1]) / psData->nsres;
+    y = ((double)afWin[7] - afWin[1]) / psData->nsres;
 
     xx_plus_yy = x * x + y * y;
-
-    // ... then aspect...
-    aspect = atan2(y,x);
     double slope = xx_plus_yy * psData->square_z_scale_factor;
 
     // ... then the shade value
     cang = acos((psData->sin_altRadians -
-           psData->cos_altRadians_mul_z_scale_factor * sqrt(xx_plus_yy) *
-           sin(aspect - psData->azRadians)) /
+           (y * psData->cos_az_mul_cos_alt_mul_z_scale_factor -
+            x * psData->sin_az_mul_cos_alt_mul_z_scale_factor)) /
            sqrt(1 + slope));
 
     // combined shading
@@ -604,6 +801,135 @@ float GDALHillshadeZevenbergenThorneCombinedAlg (float* afWin, CPL_UNUSED float
     return (float) cang;
 }
 
+/************************************************************************/
+/*                     GDALGeneric3x3Gradient2()                        */
+/*                                                                      */
+/*      Computes the x and y gradients of pixels j and j+1, with the    */
+/*      same operations as the per-pixel algorithms.                    */
+/************************************************************************/
+
+template<bool bZevenbergenThorne> static inline
+void GDALGeneric3x3Gradient2( const float* pafLine1,
+                              const float* pafLine2,
+                              const float* pafLine3,
+                              int j,
+                              const XMMReg2Double& ewres,
+                              const XMMReg2Double& nsres,
+                              XMMReg2Double& x,
+                              XMMReg2Double& y )
+{
+    if( bZevenbergenThorne )
+    {
+        x = (XMMReg2Double::Load2Val(pafLine2 + j - 1) -
+             XMMReg2Double::Load2Val(pafLine2 + j + 1)) / ewres;
+        y = (XMMReg2Double::Load2Val(pafLine3 + j) -
+             XMMReg2Double::Load2Val(pafLine1 + j)) / nsres;
+    }
+    else
+    {
+        const XMMReg2Double w0 = XMMReg2Double::Load2Val(pafLine1 + j - 1);
+        const XMMReg2Double w1 = XMMReg2Double::Load2Val(pafLine1 + j);
+        const XMMReg2Double w2 = XMMReg2Double::Load2Val(pafLine1 + j + 1);
+        const XMMReg2Double w3 = XMMReg2Double::Load2Val(pafLine2 + j - 1);
+        const XMMReg2Double w5 = XMMReg2Double::Load2Val(pafLine2 + j + 1);
+        const XMMReg2Double w6 = XMMReg2Double::Load2Val(pafLine3 + j - 1);
+        const XMMReg2Double w7 = XMMReg2Double::Load2Val(pafLine3 + j);
+        const XMMReg2Double w8 = XMMReg2Double::Load2Val(pafLine3 + j + 1);
+
+        x = ((w0 + w3 + w3 + w6) - (w2 + w5 + w5 + w8)) / ewres;
+        y = ((w6 + w7 + w7 + w8) - (w0 + w1 + w1 + w2)) / nsres;
+    }
+}
+
+/************************************************************************/
+/*                    GDALGeneric3x3ProcessLastPixel()                  */
+/************************************************************************/
+
+static void GDALGeneric3x3ProcessLastPixel( const float* pafLine1,
+                                            const float* pafLine2,
+                                            const float* pafLine3,
+                                            int j,
+                                            float* pafOutputBuf,
+                                            GDALGeneric3x3ProcessingAlg pfnAlg,
+                                            void* pData )
+{
+    float afWin[9];
+    afWin[0] = pafLine1[j-1];
+    afWin[1] = pafLine1[j];
+    afWin[2] = pafLine1[j+1];
+    afWin[3] = pafLine2[j-1];
+    afWin[4] = pafLine2[j];
+    afWin[5] = pafLine2[j+1];
+    afWin[6] = pafLine3[j-1];
+    afWin[7] = pafLine3[j];
+    afWin[8] = pafLine3[j+1];
+    pafOutputBuf[j] = pfnAlg(afWin, 0.0f, pData);
+}
+
+/************************************************************************/
+/*                       GDALHillshadeLineAlg()                         */
+/************************************************************************/
+
+template<bool bZevenbergenThorne> static
+void GDALHillshadeLineAlg( const float* pafLine1,
+                           const float* pafLine2,
+                           const float* pafLine3,
+                           int nXSize,
+                           float* pafOutputBuf,
+                           void* pData )
+{
+    GDALHillshadeAlgData* psData = (GDALHillshadeAlgData*)pData;
+    const XMMReg2Double ewres =
+        XMMReg2Double::Load1ValHighAndLow(&psData->ewres);
+    const XMMReg2Double nsres =
+        XMMReg2Double::Load1ValHighAndLow(&psData->nsres);
+    const XMMReg2Double sin_alt =
+        XMMReg2Double::Load1ValHighAndLow(&psData->sin_altRadians);
+    const XMMReg2Double cos_az_mul =
+        XMMReg2Double::Load1ValHighAndLow(
+            &psData->cos_az_mul_cos_alt_mul_z_scale_factor);
+    const XMMReg2Double sin_az_mul =
+        XMMReg2Double::Load1ValHighAndLow(
+            &psData->sin_az_mul_cos_alt_mul_z_scale_factor);
+    const XMMReg2Double square_z_scale_factor =
+        XMMReg2Double::Load1ValHighAndLow(&psData->square_z_scale_factor);
+    const double dfZero = 0.0;
+    const double dfOne = 1.0;
+    const double df254 = 254.0;
+    const XMMReg2Double zero = XMMReg2Double::Load1ValHighAndLow(&dfZero);
+    const XMMReg2Double one = XMMReg2Double::Load1ValHighAndLow(&dfOne);
+    const XMMReg2Double v254 = XMMReg2Double::Load1ValHighAndLow(&df254);
+
+    int j = 1;
+    for( ; j + 1 < nXSize - 1; j += 2 )
+    {
+        XMMReg2Double x, y;
+        GDALGeneric3x3Gradient2<bZevenbergenThorne>(
+            pafLine1, pafLine2, pafLine3, j, ewres, nsres, x, y);
+
+        const XMMReg2Double xx_plus_yy = x * x + y * y;
+        const XMMReg2Double cang =
+            (sin_alt - (y * cos_az_mul - x * sin_az_mul)) /
+            XMMReg2Double::Sqrt(one + square_z_scale_factor * xx_plus_yy);
+        const XMMReg2Double res =
+            XMMReg2Double::Ternary(XMMReg2Double::Greater(cang, zero),
+                                   one + v254 * cang, one);
+
+        double adfRes[2];
+        res.Store2Double(adfRes);
+        pafOutputBuf[j] = (float)adfRes[0];
+        pafOutputBuf[j+1] = (float)adfRes[1];
+    }
+    if( j < nXSize - 1 )
+    {
+        GDALGeneric3x3ProcessLastPixel(pafLine1, pafLine2, pafLine3, j,
+            pafOutputBuf,
+            bZevenbergenThorne ? GDALHillshadeZevenbergenThorneAlg :
+                                 GDALHillshadeAlg,
+            pData);
+    }
+}
+
 static
 void*  GDALCreateHillshadeData(double* adfGeoTransform,
                                double z,
@@ -619,10 +945,13 @@ void*  GDALCreateHillshadeData(double* adfGeoTransform,
     pData->nsres = adfGeoTransform[5];
     pData->ewres = adfGeoTransform[1];
     pData->sin_altRadians = sin(alt * degreesToRadians);
-    pData->azRadians = az * degreesToRadians;
     double z_scale_factor = z / (((bZevenbergenThorne) ? 2 : 8) * scale);
-    pData->cos_altRadians_mul_z_scale_factor =
+    const double cos_altRadians_mul_z_scale_factor =
         cos(alt * degreesToRadians) * z_scale_factor;
+    pData->cos_az_mul_cos_alt_mul_z_scale_factor =
+        cos(az * degreesToRadians) * cos_altRadians_mul_z_scale_factor;
+    pData->sin_az_mul_cos_alt_mul_z_scale_factor =
+        sin(az * degreesToRadians) * cos_altRadians_mul_z_scale_factor;
     pData->square_z_scale_factor = z_scale_factor * z_scale_factor;
     pData->square_M_PI_2 = (M_PI*M_PI)/4;
     return pData;
@@ -647,11 +976,11 @@ float GDALSlopeHornAlg (float* afWin, CPL_UNUSED float fDstNoDataValue, void* pD
     GDALSlopeAlgData* psData = (GDALSlopeAlgData*)pData;
     double dx, dy, key;
 
-    dx = ((afWin[0] + afWin[3] + afWin[3] + afWin[6]) -
-          (afWin[2] + afWin[5] + afWin[5] + afWin[8]))/psData->ewres;
+    dx = (((double)afWin[0] + afWin[3] + afWin[3] + afWin[6]) -
+          ((double)afWin[2] + afWin[5] + afWin[5] + afWin[8]))/psData->ewres;
 
-    dy = ((afWin[6] + afWin[7] + afWin[7] + afWin[8]) -
-          (afWin[0] + afWin[1] + afWin[1] + afWin[2]))/psData->nsres;
+    dy = (((double)afWin[6] + afWin[7] + afWin[7] + afWin[8]) -
+          ((double)afWin[0] + afWin[1] + afWin[1] + afWin[2]))/psData->nsres;
 
     key = (dx * dx + dy * dy);
 
@@ -668,9 +997,9 @@ float GDALSlopeZevenbergenThorneAlg (float* afWin, CPL_UNUSED float fDstNoDataVa
     GDALSlopeAlgData* psData = (GDALSlopeAlgData*)pData;
     double dx, dy, key;
 
-    dx = (afWin[3] - afWin[5])/psData->ewres;
+    dx = ((double)afWin[3] - afWin[5])/psData->ewres;
 
-    dy = (afWin[7] - afWin[1])/psData->nsres;
+    dy = ((double)afWin[7] - afWin[1])/psData->nsres;
 
     key = (dx * dx + dy * dy);
 
@@ -680,6 +1009,59 @@ float GDALSlopeZevenbergenThorneAlg (float* afWin, CPL_UNUSED float fDstNoDataVa
         return (float) (100*(sqrt(key) / (2*psData->scale)));
 }
 
+/************************************************************************/
+/*                         GDALSlopeLineAlg()                           */
+/************************************************************************/
+
+template<bool bZevenbergenThorne> static
+void GDALSlopeLineAlg( const float* pafLine1,
+                       const float* pafLine2,
+                       const float* pafLine3,
+                       int nXSize,
+                       float* pafOutputBuf,
+                       void* pData )
+{
+    const double radiansToDegrees = 180.0 / M_PI;
+    GDALSlopeAlgData* psData = (GDALSlopeAlgData*)pData;
+    const XMMReg2Double ewres =
+        XMMReg2Double::Load1ValHighAndLow(&psData->ewres);
+    const XMMReg2Double nsres =
+        XMMReg2Double::Load1ValHighAndLow(&psData->nsres);
+    const double dfDenom = (bZevenbergenThorne ? 2 : 8) * psData->scale;
+    const XMMReg2Double denom = XMMReg2Double::Load1ValHighAndLow(&dfDenom);
+
+    int j = 1;
+    for( ; j + 1 < nXSize - 1; j += 2 )
+    {
+        XMMReg2Double x, y;
+        GDALGeneric3x3Gradient2<bZevenbergenThorne>(
+            pafLine1, pafLine2, pafLine3, j, ewres, nsres, x, y);
+
+        const XMMReg2Double ratio = XMMReg2Double::Sqrt(x * x + y * y) / denom;
+        double adfRatio[2];
+        ratio.Store2Double(adfRatio);
+
+        if (psData->slopeFormat == 1)
+        {
+            pafOutputBuf[j] = (float)(atan(adfRatio[0]) * radiansToDegrees);
+            pafOutputBuf[j+1] = (float)(atan(adfRatio[1]) * radiansToDegrees);
+        }
+        else
+        {
+            pafOutputBuf[j] = (float)(100 * adfRatio[0]);
+            pafOutputBuf[j+1] = (float)(100 * adfRatio[1]);
+        }
+    }
+    if( j < nXSize - 1 )
+    {
+        GDALGeneric3x3ProcessLastPixel(pafLine1, pafLine2, pafLine3, j,
+            pafOutputBuf,
+            bZevenbergenThorne ? GDALSlopeZevenbergenThorneAlg :
+                                 GDALSlopeHornAlg,
+            pData);
+    }
+}
+
 static
 void*  GDALCreateSlopeData(double* adfGeoTransform,
                            double scale,
@@ -1956,10 +2338,13 @@ class GDALGeneric3x3Dataset : public GDALDataset
     friend class GDALGeneric3x3RasterBand;
 
     GDALGeneric3x3ProcessingAlg pfnAlg;
+    GDALGeneric3x3ProcessingLineAlg pfnLineAlg;
     void*              pAlgData;
     GDALDatasetH       hSrcDS;
     GDALRasterBandH    hSrcBand;
     float*             apafSourceBuf[3];
+    float*             pafOutputBuf;
+    GByte*             pabyNoData;
     int                bDstHasNoData;
     double             dfDstNoDataValue;
     int                nCurLine;
@@ -1972,13 +2357,16 @@ class GDALGeneric3x3Dataset : public GDALDataset
                                               int bDstHasNoData,
                                               double dfDstNoDataValue,
                                               GDALGeneric3x3ProcessingAlg pfnAlg,
+                                              GDALGeneric3x3ProcessingLineAlg pfnLineAlg,
                                               void* pAlgData,
                                               int bComputeAtEdges);
                        ~GDALGeneric3x3Dataset();
 
     bool                InitOK() const { return apafSourceBuf[0] != NULL &&
                                                 apafSourceBuf[1] != NULL &&
-                                                apafSourceBuf[2] != NULL; }
+                                                apafSourceBuf[2] != NULL &&
+                                                pafOutputBuf != NULL &&
+                                                pabyNoData != NULL; }
 
     CPLErr      GetGeoTransform( double * padfGeoTransform );
     const char *GetProjectionRef();
@@ -2014,12 +2402,14 @@ GDALGeneric3x3Dataset::GDALGeneric3x3Dataset(
                                      int bDstHasNoDataIn,
                                      double dfDstNoDataValueIn,
                                      GDALGeneric3x3ProcessingAlg pfnAlgIn,
+                                     GDALGeneric3x3ProcessingLineAlg pfnLineAlgIn,
                                      void* pAlgDataIn,
                                      int bComputeAtEdgesIn)
 {
     hSrcDS = hSrcDSIn;
     hSrcBand = hSrcBandIn;
     pfnAlg = pfnAlgIn;
+    pfnLineAlg = pfnLineAlgIn;
     pAlgData = pAlgDataIn;
     bDstHasNoData = bDstHasNoDataIn;
     dfDstNoDataValue = dfDstNoDataValueIn;
@@ -2035,6 +2425,8 @@ GDALGeneric3x3Dataset::GDALGeneric3x3Dataset(
     apafSourceBuf[0] = (float *) VSI_MALLOC2_VERBOSE(sizeof(float),nRasterXSize);
     apafSourceBuf[1] = (float *) VSI_MALLOC2_VERBOSE(sizeof(float),nRasterXSize);
     apafSourceBuf[2] = (float *) VSI_MALLOC2_VERBOSE(sizeof(float),nRasterXSize);
+    pafOutputBuf = (float *) VSI_MALLOC2_VERBOSE(sizeof(float),nRasterXSize);
+    pabyNoData = (GByte *) VSI_MALLOC_VERBOSE(nRasterXSize);
 
     nCurLine = -1;
 }
@@ -2044,6 +2436,8 @@ GDALGeneric3x3Dataset::~GDALGeneric3x3Dataset()
     CPLFree(apafSourceBuf[0]);
     CPLFree(apafSourceBuf[1]);
     CPLFree(apafSourceBuf[2]);
+    CPLFree(pafOutputBuf);
+    CPLFree(pabyNoData);
 }
 
 CPLErr GDALGeneric3x3Dataset::GetGeoTransform( double * padfGeoTransform )
@@ -2251,99 +2645,30 @@ CPLErr GDALGeneric3x3RasterBand::IReadBlock( CPL_UNUSED int nBlockXOff,
         poGDS->nCurLine = nBlockYOff;
     }
 
-    if (poGDS->bComputeAtEdges && nRasterXSize >= 2)
-    {
-        float afWin[9];
-
-        j = 0;
-        afWin[0] = INTERPOL(poGDS->apafSourceBuf[0][j], poGDS->apafSourceBuf[0][j+1]);
-        afWin[1] = poGDS->apafSourceBuf[0][j];
-        afWin[2] = poGDS->apafSourceBuf[0][j+1];
-        afWin[3] = INTERPOL(poGDS->apafSourceBuf[1][j], poGDS->apafSourceBuf[1][j+1]);
-        afWin[4] = poGDS->apafSourceBuf[1][j];
-        afWin[5] = poGDS->apafSourceBuf[1][j+1];
-        afWin[6] = INTERPOL(poGDS->apafSourceBuf[2][j], poGDS->apafSourceBuf[2][j+1]);
-        afWin[7] = poGDS->apafSourceBuf[2][j];
-        afWin[8] = poGDS->apafSourceBuf[2][j+1];
-
-        fVal = ComputeVal(bSrcHasNoData, fSrcNoDataValue,
-                          bIsSrcNoDataNan,
-                                    afWin, (float) poGDS->dfDstNoDataValue,
-                                    poGDS->pfnAlg,
-                                    poGDS->pAlgData,
-                                    poGDS->bComputeAtEdges);
+    GDALGeneric3x3LineContext sCtx;
+    sCtx.pfnAlg = poGDS->pfnAlg;
+    sCtx.pfnLineAlg = poGDS->pfnLineAlg;
+    sCtx.pData = poGDS->pAlgData;
+    sCtx.nXSize = nBlockXSize;
+    sCtx.bSrcHasNoData = bSrcHasNoData;
+    sCtx.fSrcNoDataValue = fSrcNoDataValue;
+    sCtx.bIsSrcNoDataNan = bIsSrcNoDataNan;
+    sCtx.fDstNoDataValue = (float) poGDS->dfDstNoDataValue;
+    sCtx.bComputeAtEdges = poGDS->bComputeAtEdges;
+
+    float* pafOutputBuf = (eDataType == GDT_Byte) ? poGDS->pafOutputBuf :
+                                                    (float*) pImage;
+    GDALGeneric3x3ProcessLine(&sCtx,
+                              poGDS->apafSourceBuf[0],
+                              poGDS->apafSourceBuf[1],
+                              poGDS->apafSourceBuf[2],
+                              pafOutputBuf,
+                              poGDS->pabyNoData);
 
-        if (eDataType == GDT_Byte)
-            ((GByte*)pImage)[j] = (GByte) (fVal + 0.5);
-        else
-            ((float*)pImage)[j] = fVal;
-
-        j = nRasterXSize - 1;
-
-        afWin[0] = poGDS->apafSourceBuf[0][j-1];
-        afWin[1] = poGDS->apafSourceBuf[0][j];
-        afWin[2] = INTERPOL(poGDS->apafSourceBuf[0][j], poGDS->apafSourceBuf[0][j-1]);
-        afWin[3] = poGDS->apafSourceBuf[1][j-1];
-        afWin[4] = poGDS->apafSourceBuf[1][j];
-        afWin[5] = INTERPOL(poGDS->apafSourceBuf[1][j], poGDS->apafSourceBuf[1][j-1]);
-        afWin[6] = poGDS->apafSourceBuf[2][j-1];
-        afWin[7] = poGDS->apafSourceBuf[2][j];
-        afWin[8] = INTERPOL(poGDS->apafSourceBuf[2][j], poGDS->apafSourceBuf[2][j-1]);
-
-        fVal = ComputeVal(bSrcHasNoData, fSrcNoDataValue,
-                          bIsSrcNoDataNan,
-                                    afWin, (float) poGDS->dfDstNoDataValue,
-                                    poGDS->pfnAlg,
-                                    poGDS->pAlgData,
-                                    poGDS->bComputeAtEdges);
-
-        if (eDataType == GDT_Byte)
-            ((GByte*)pImage)[j] = (GByte) (fVal + 0.5);
-        else
-            ((float*)pImage)[j] = fVal;
-    }
-    else
-    {
-        if (eDataType == GDT_Byte)
-        {
-            ((GByte*)pImage)[0] = (GByte) poGDS->dfDstNoDataValue;
-            if (nBlockXSize > 1)
-                ((GByte*)pImage)[nBlockXSize - 1] = (GByte) poGDS->dfDstNoDataValue;
-        }
-        else
-        {
-            ((float*)pImage)[0] = (float) poGDS->dfDstNoDataValue;
-            if (nBlockXSize > 1)
-                ((float*)pImage)[nBlockXSize - 1] = (float) poGDS->dfDstNoDataValue;
-        }
-    }
-
-
-    for(j=1;j<nBlockXSize - 1;j++)
+    if (eDataType == GDT_Byte)
     {
-        float afWin[9];
-        afWin[0] = poGDS->apafSourceBuf[0][j-1];
-        afWin[1] = poGDS->apafSourceBuf[0][j];
-        afWin[2] = poGDS->apafSourceBuf[0][j+1];
-        afWin[3] = poGDS->apafSourceBuf[1][j-1];
-        afWin[4] = poGDS->apafSourceBuf[1][j];
-        afWin[5] = poGDS->apafSourceBuf[1][j+1];
-        afWin[6] = poGDS->apafSourceBuf[2][j-1];
-        afWin[7] = poGDS->apafSourceBuf[2][j];
-        afWin[8] = poGDS->apafSourceBuf[2][j+1];
-
-        fVal = ComputeVal(bSrcHasNoData, fSrcNoDataValue,
-                          bIsSrcNoDataNan,
-                                afWin, (float) poGDS->dfDstNoDataValue,
-                                poGDS->pfnAlg,
-                                poGDS->pAlgData,
-                                poGDS->bComputeAtEdges);
-
-        if (eDataType == GDT_Byte)
-            ((GByte*)pImage)[j] = (GByte) (fVal + 0.5);
-        else
-            ((float*)pImage)[j] = fVal;
-
+        for(j=0;j<nBlockXSize;j++)
+            ((GByte*)pImage)[j] = (GByte) (pafOutputBuf[j] + 0.5);
     }
 
     return CE_None;
@@ -2571,6 +2896,7 @@ GDALDatasetH GDALDEMProcessing(const char *pszDest,
     int bDstHasNoData = FALSE;
     void* pData = NULL;
     GDALGeneric3x3ProcessingAlg pfnAlg = NULL;
+    GDALGeneric3x3ProcessingLineAlg pfnLineAlg = NULL;
 
     if (eUtilityMode == HILL_SHADE)
     {
@@ -2585,14 +2911,20 @@ GDALDatasetH GDALDEMProcessing(const char *pszDest,
         if (psOptions->bZevenbergenThorne)
         {
             if(!psOptions->bCombined)
+            {
                 pfnAlg = GDALHillshadeZevenbergenThorneAlg;
+                pfnLineAlg = GDALHillshadeLineAlg<true>;
+            }
             else
                 pfnAlg = GDALHillshadeZevenbergenThorneCombinedAlg;
         }
         else
         {
             if(!psOptions->bCombined)
+            {
                 pfnAlg = GDALHillshadeAlg;
+                pfnLineAlg = GDALHillshadeLineAlg<false>;
+            }
             else
                 pfnAlg = GDALHillshadeCombinedAlg;
         }
@@ -2604,9 +2936,15 @@ GDALDatasetH GDALDEMProcessing(const char *pszDest,
 
         pData = GDALCreateSlopeData(adfGeoTransform, psOptions->scale, psOptions->slopeFormat);
         if (psOptions->bZevenbergenThorne)
+        {
             pfnAlg = GDALSlopeZevenbergenThorneAlg;
+            pfnLineAlg = GDALSlopeLineAlg<true>;
+        }
         else
+        {
             pfnAlg = GDALSlopeHornAlg;
+            pfnLineAlg = GDALSlopeLineAlg<false>;
+        }
     }
 
     else if (eUtilityMode == ASPECT)
@@ -2735,6 +3073,7 @@ GDALDatasetH GDALDEMProcessing(const char *pszDest,
                                           bDstHasNoData,
                                           dfDstNoDataValue,
                                           pfnAlg,
+                                          pfnLineAlg,
                                           pData,
                                           psOptions->bComputeAtEdges);
             if( !(poDS->InitOK()) )
@@ -2805,7 +3144,7 @@ GDALDatasetH GDALDEMProcessing(const char *pszDest,
             GDALSetRasterNoDataValue(hDstBand, dfDstNoDataValue);
 
         GDALGeneric3x3Processing(hSrcBand, hDstBand,
-                                 pfnAlg, pData,
+                                 pfnAlg, pfnLineAlg, pData,
                                  psOptions->bComputeAtEdges,
                                  pfnProgress, pProgressData);
 
@@ -38,6 +38,7 @@
 
 #include "cpl_port.h"  // Must be first.
 
+#include <algorithm>
 #include <set>
 
 #include "cpl_csv.h"
@@ -204,6 +205,31 @@ typedef struct
     bool          bReady;
 } GTiffCompressionJob;
 
+typedef struct
+{
+    int           nBlockXOff;
+    int           nBlockYOff;
+    int           nBlockId;
+    int           nBand;        // Only used in PLANARCONFIG_SEPARATE.
+    vsi_l_offset  nOffset;
+    size_t        nSize;
+    bool          bOK;
+} GTiffDecompressionBlock;
+
+typedef struct
+{
+    GTiffDataset            *poDS;
+    TIFF                    *hTIFF;        // Private to the job.
+    GTiffDecompressionBlock *pasBlocks;
+    int                      nBlocks;
+    int                      iFirstBlock;  // Job processes one block every
+    int                      nBlockStep;   // nBlockStep, from iFirstBlock.
+    GByte                  **papabyDest;   // nBlocks * nBandsPerBlock.
+    int                      nBandsPerBlock;
+    int                      nBlockBufSize;
+    GDALDataType             eDataType;
+} GTiffDecompressionJob;
+
 class GTiffDataset CPL_FINAL : public GDALPamDataset
 {
     friend class GTiffBitmapBand;
@@ -297,7 +323,9 @@ class GTiffDataset CPL_FINAL : public GDALPamDataset
     int         nGCPCount;
     GDAL_GCP    *pasGCPList;
 
-    int         IsBlockAvailable( int nBlockId );
+    int         IsBlockAvailable( int nBlockId,
+                                  vsi_l_offset* pnOffset = NULL,
+                                  vsi_l_offset* pnSize = NULL );
 
     bool        bGeoTIFFInfoChanged;
     bool        bForceUnsetGTOrGCPs;
@@ -364,6 +392,7 @@ class GTiffDataset CPL_FINAL : public GDALPamDataset
 
     int           nZLevel;
     int           nLZMAPreset;
+    int           nZSTDLevel;
     int           nJpegQuality;
     int           nJpegTablesMode;
 
@@ -412,6 +441,16 @@ class GTiffDataset CPL_FINAL : public GDALPamDataset
     int            SubmitCompressionJob(int nStripOrTile, GByte* pabyData,
                                         int cc, int nHeight);
 
+    int            nDecompressThreads;
+    CPLWorkerThreadPool *poDecompressThreadPool;  // Only used in actual base.
+    std::vector<TIFF*> ahDecompressTIFF;
+    void           InitDecompressionThreads(char** papszOptions);
+    static void    ThreadDecompressionFunc(void* pData);
+    void           CacheBlocksMultiThreaded( int nXOff, int nYOff,
+                                             int nXSize, int nYSize,
+                                             int nBandCount,
+                                             const int *panBandMap );
+
     int            GuessJPEGQuality(int& bOutHasQuantizationTable,
                                     int& bOutHasHuffmanTable);
 
@@ -497,6 +536,11 @@ class GTiffDataset CPL_FINAL : public GDALPamDataset
                                     int bStrict, char ** papszOptions,
                                     GDALProgressFunc pfnProgress,
                                     void * pProgressData );
+    static GDALDataset *CreateCloudOptimizedCopy( const char * pszFilename,
+                                    GDALDataset *poSrcDS,
+                                    int bStrict, char ** papszOptions,
+                                    GDALProgressFunc pfnProgress,
+                                    void * pProgressData );
     virtual void    FlushCache( void );
 
     virtual char      **GetMetadataDomainList();
@@ -1997,6 +2041,12 @@ CPLErr GTiffDataset::IRasterIO( GDALRWFlag eRWFlag,
             return static_cast<CPLErr>(nErr);
     }
 
+    if( eRWFlag == GF_Read )
+    {
+        CacheBlocksMultiThreaded(nXOff, nYOff, nXSize, nYSize,
+                                 nBandCount, panBandMap);
+    }
+
     ++nJPEGOverviewVisibilityFlag;
     const CPLErr eErr =
         GDALPamDataset::IRasterIO(
@@ -3911,6 +3961,12 @@ CPLErr GTiffRasterBand::IRasterIO( GDALRWFlag eRWFlag,
         }
     }
 
+    if( eRWFlag == GF_Read )
+    {
+        poGDS->CacheBlocksMultiThreaded(nXOff, nYOff, nXSize, nYSize,
+                                        1, &nBand);
+    }
+
     ++poGDS->nJPEGOverviewVisibilityFlag;
     const CPLErr eErr =
         GDALPamRasterBand::IRasterIO( eRWFlag, nXOff, nYOff, nXSize, nYSize,
@@ -6503,6 +6559,7 @@ GTiffDataset::GTiffDataset() :
     bDontReloadFirstBlock(false),
     nZLevel(-1),
     nLZMAPreset(-1),
+    nZSTDLevel(-1),
     nJpegQuality(-1),
     nJpegTablesMode(-1),
     bPromoteTo8Bits(false),
@@ -6518,6 +6575,8 @@ GTiffDataset::GTiffDataset() :
     bHasDiscardedLsb(false),
     poCompressThreadPool(NULL),
     hCompressThreadPoolMutex(NULL),
+    nDecompressThreads(0),
+    poDecompressThreadPool(NULL),
     m_pTempBufferForCommonDirectIO(NULL),
     m_nTempBufferForCommonDirectIOSize(0),
     m_bReadGeoTransform(false),
@@ -6640,6 +6699,18 @@ int GTiffDataset::Finalize()
         CPLDestroyMutex(hCompressThreadPoolMutex);
     }
 
+    // Close the handles used by the decompression threads
+    for( size_t i = 0; i < ahDecompressTIFF.size(); ++i )
+    {
+        VSILFILE* fpTmp =
+            VSI_TIFFGetVSILFile( TIFFClientdata( ahDecompressTIFF[i] ) );
+        XTIFFClose( ahDecompressTIFF[i] );
+        CPL_IGNORE_RET_VAL(VSIFCloseL( fpTmp ));
+    }
+    ahDecompressTIFF.clear();
+    delete poDecompressThreadPool;
+    poDecompressThreadPool = NULL;
+
 /* -------------------------------------------------------------------- */
 /*      If there is still changed metadata, then presumably we want     */
 /*      to push it into PAM.                                            */
@@ -7218,78 +7289,84 @@ bool GTiffDataset::WriteEncodedStrip( uint32 strip, GByte* pabyData,
 }
 
 /************************************************************************/
-/*                        InitCompressionThreads()                      */
+/*                         GTiffGetNumThreads()                         */
 /************************************************************************/
 
-void GTiffDataset::InitCompressionThreads(char** papszOptions)
+static int GTiffGetNumThreads(char** papszOptions)
 {
     const char* pszValue = CSLFetchNameValue( papszOptions, "NUM_THREADS" );
     if( pszValue == NULL )
         pszValue = CPLGetConfigOption("GDAL_NUM_THREADS", NULL);
-    if( pszValue )
+    if( pszValue == NULL )
+        return 0;
+
+    const int nThreads = CPLParseNumThreads(pszValue);
+    if( nThreads <= 1 &&
+        !EQUAL(pszValue, "0") &&
+        !EQUAL(pszValue, "1") &&
+        !EQUAL(pszValue, "ALL_CPUS") )
+    {
+        CPLError(CE_Warning, CPLE_AppDefined,
+                 "Invalid value for NUM_THREADS: %s", pszValue);
+    }
+    return nThreads;
+}
+
+/************************************************************************/
+/*                        InitCompressionThreads()                      */
+/************************************************************************/
+
+void GTiffDataset::InitCompressionThreads(char** papszOptions)
+{
+    const int nThreads = GTiffGetNumThreads(papszOptions);
+    if( nThreads > 1 )
     {
-        int nThreads = 0;
-        if( EQUAL(pszValue, "ALL_CPUS") )
-            nThreads = CPLGetNumCPUs();
+        if( nCompression == COMPRESSION_NONE ||
+            nCompression == COMPRESSION_JPEG )
+        {
+            CPLDebug( "GTiff",
+                      "NUM_THREADS ignored with uncompressed or JPEG" );
+        }
         else
-            nThreads = atoi(pszValue);
-        if( nThreads > 1 )
         {
-            if( nCompression == COMPRESSION_NONE ||
-                nCompression == COMPRESSION_JPEG )
+            CPLDebug("GTiff", "Using %d threads for compression", nThreads);
+            poCompressThreadPool = new CPLWorkerThreadPool();
+            if( !poCompressThreadPool->Setup(nThreads, NULL, NULL) )
             {
-                CPLDebug( "GTiff",
-                          "NUM_THREADS ignored with uncompressed or JPEG" );
+                delete poCompressThreadPool;
+                poCompressThreadPool = NULL;
             }
             else
             {
-                CPLDebug("GTiff", "Using %d threads for compression", nThreads);
-                poCompressThreadPool = new CPLWorkerThreadPool();
-                if( !poCompressThreadPool->Setup(nThreads, NULL, NULL) )
-                {
-                    delete poCompressThreadPool;
-                    poCompressThreadPool = NULL;
-                }
-                else
+                // Add a margin of an extra job w.r.t thread number
+                // so as to optimize compression time (enables the main
+                // thread to do boring I/O while all CPUs are working)
+                asCompressionJobs.resize(nThreads + 1);
+                memset(&asCompressionJobs[0], 0,
+                       asCompressionJobs.size() *
+                       sizeof(GTiffCompressionJob));
+                for( int i = 0;
+                     i < static_cast<int>(asCompressionJobs.size());
+                     ++i )
                 {
-                    // Add a margin of an extra job w.r.t thread number
-                    // so as to optimize compression time (enables the main
-                    // thread to do boring I/O while all CPUs are working)
-                    asCompressionJobs.resize(nThreads + 1);
-                    memset(&asCompressionJobs[0], 0,
-                           asCompressionJobs.size() *
-                           sizeof(GTiffCompressionJob));
-                    for( int i = 0;
-                         i < static_cast<int>(asCompressionJobs.size());
-                         ++i )
-                    {
-                        asCompressionJobs[i].pszTmpFilename =
-                            CPLStrdup(CPLSPrintf("/vsimem/gtiff/thread/job/%p",
-                                                 &asCompressionJobs[i]));
-                        asCompressionJobs[i].nStripOrTile = -1;
-                    }
-                    hCompressThreadPoolMutex = CPLCreateMutex();
-                    CPLReleaseMutex(hCompressThreadPoolMutex);
-
-                    // This is kind of a hack, but basically using
-                    // TIFFWriteRawStrip/Tile and then TIFFReadEncodedStrip/Tile
-                    // does not work on a newly created file, because
-                    // TIFF_MYBUFFER is not set in tif_flags
-                    // (if using TIFFWriteEncodedStrip/Tile first,
-                    // TIFFWriteBufferSetup() is automatically called).
-                    // This should likely rather fixed in libtiff itself.
-                    TIFFWriteBufferSetup(hTIFF, NULL, -1);
+                    asCompressionJobs[i].pszTmpFilename =
+                        CPLStrdup(CPLSPrintf("/vsimem/gtiff/thread/job/%p",
+                                             &asCompressionJobs[i]));
+                    asCompressionJobs[i].nStripOrTile = -1;
                 }
+                hCompressThreadPoolMutex = CPLCreateMutex();
+                CPLReleaseMutex(hCompressThreadPoolMutex);
+
+                // This is kind of a hack, but basically using
+                // TIFFWriteRawStrip/Tile and then TIFFReadEncodedStrip/Tile
+                // does not work on a newly created file, because
+                // TIFF_MYBUFFER is not set in tif_flags
+                // (if using TIFFWriteEncodedStrip/Tile first,
+                // TIFFWriteBufferSetup() is automatically called).
+                // This should likely rather fixed in libtiff itself.
+                TIFFWriteBufferSetup(hTIFF, NULL, -1);
             }
         }
-        else if( nThreads < 0 ||
-                 (!EQUAL(pszValue, "0") &&
-                  !EQUAL(pszValue, "1") &&
-                  !EQUAL(pszValue, "ALL_CPUS")) )
-        {
-            CPLError(CE_Warning, CPLE_AppDefined,
-                     "Invalid value for NUM_THREADS: %s", pszValue);
-        }
     }
 }
 
@@ -7342,6 +7419,8 @@ void GTiffDataset::ThreadCompressionFunc(void* pData)
         TIFFSetField(hTIFFTmp, TIFFTAG_ZIPQUALITY, poDS->nZLevel);
     if( poDS->nLZMAPreset > 0 && poDS->nCompression == COMPRESSION_LZMA)
         TIFFSetField(hTIFFTmp, TIFFTAG_LZMAPRESET, poDS->nLZMAPreset);
+    if( poDS->nZSTDLevel > 0 && poDS->nCompression == COMPRESSION_ZSTD)
+        TIFFSetField(hTIFFTmp, TIFFTAG_ZSTD_LEVEL, poDS->nZSTDLevel);
     TIFFSetField(hTIFFTmp, TIFFTAG_PHOTOMETRIC, poDS->nPhotometric);
     TIFFSetField(hTIFFTmp, TIFFTAG_SAMPLEFORMAT, poDS->nSampleFormat);
     TIFFSetField(hTIFFTmp, TIFFTAG_SAMPLESPERPIXEL, poDS->nSamplesPerPixel);
@@ -7487,7 +7566,8 @@ int GTiffDataset::SubmitCompressionJob(int nStripOrTile, GByte* pabyData,
            (nCompression == COMPRESSION_ADOBE_DEFLATE ||
             nCompression == COMPRESSION_LZW ||
             nCompression == COMPRESSION_PACKBITS ||
-            nCompression == COMPRESSION_LZMA) ) )
+            nCompression == COMPRESSION_LZMA ||
+            nCompression == COMPRESSION_ZSTD) ) )
         return FALSE;
 
     int nNextCompressionJobAvail = -1;
@@ -7531,7 +7611,8 @@ int GTiffDataset::SubmitCompressionJob(int nStripOrTile, GByte* pabyData,
     psJob->nStripOrTile = nStripOrTile;
     psJob->nPredictor = PREDICTOR_NONE;
     if( nCompression == COMPRESSION_LZW ||
-        nCompression == COMPRESSION_ADOBE_DEFLATE )
+        nCompression == COMPRESSION_ADOBE_DEFLATE ||
+        nCompression == COMPRESSION_ZSTD )
     {
         TIFFGetField( hTIFF, TIFFTAG_PREDICTOR, &psJob->nPredictor );
     }
@@ -7540,6 +7621,408 @@ int GTiffDataset::SubmitCompressionJob(int nStripOrTile, GByte* pabyData,
     return TRUE;
 }
 
+/************************************************************************/
+/*                      InitDecompressionThreads()                      */
+/************************************************************************/
+
+void GTiffDataset::InitDecompressionThreads(char** papszOptions)
+{
+    const int nThreads = GTiffGetNumThreads(papszOptions);
+    if( nThreads > 1 )
+    {
+        // The thread pool is created the first time it is needed.
+        CPLDebug("GTiff", "Using up to %d threads for decompression",
+                 nThreads);
+        nDecompressThreads = nThreads;
+    }
+}
+
+/************************************************************************/
+/*                      ThreadDecompressionFunc()                       */
+/************************************************************************/
+
+void GTiffDataset::ThreadDecompressionFunc(void* pData)
+{
+    GTiffDecompressionJob* psJob = static_cast<GTiffDecompressionJob *>(pData);
+    GTiffDataset* poDS = psJob->poDS;
+    const bool bIsTiled = CPL_TO_BOOL( TIFFIsTiled(psJob->hTIFF) );
+    const int nBlockBufSize = psJob->nBlockBufSize;
+    const int nBandsPerBlock = psJob->nBandsPerBlock;
+    const int nWordBytes = GDALGetDataTypeSizeBytes(psJob->eDataType);
+    const int nBlockPixels =
+        static_cast<int>(poDS->nBlockXSize * poDS->nBlockYSize);
+
+    // Pixel-interleaved blocks are decoded in a temporary buffer, and then
+    // dispatched to the blocks of each band.
+    GByte* pabyTmpBuffer = NULL;
+    if( nBandsPerBlock > 1 )
+    {
+        pabyTmpBuffer = static_cast<GByte*>(VSIMalloc(nBlockBufSize));
+        if( pabyTmpBuffer == NULL )
+            return;
+    }
+
+    // Errors are not reported from here: blocks that cannot be decoded are
+    // discarded from the block cache, and IReadBlock() will report them.
+    CPLPushErrorHandler(CPLQuietErrorHandler);
+
+    for( int i = psJob->iFirstBlock; i < psJob->nBlocks;
+         i += psJob->nBlockStep )
+    {
+        GTiffDecompressionBlock* psBlock = psJob->pasBlocks + i;
+        GByte** papabyDest = psJob->papabyDest + i * nBandsPerBlock;
+        GByte* pabyDecoded =
+            pabyTmpBuffer != NULL ? pabyTmpBuffer : papabyDest[0];
+
+        // The bottom most partial tiles and strips are sometimes only
+        // partially encoded. (#1179)
+        int nBlockReqSize = nBlockBufSize;
+        if( static_cast<int>((psBlock->nBlockYOff + 1) * poDS->nBlockYSize) >
+                                                        poDS->nRasterYSize )
+        {
+            nBlockReqSize = (nBlockBufSize / poDS->nBlockYSize) *
+                (poDS->nBlockYSize -
+                 (((psBlock->nBlockYOff + 1) * poDS->nBlockYSize) %
+                                                    poDS->nRasterYSize));
+            memset( pabyDecoded, 0, nBlockBufSize );
+        }
+
+        if( bIsTiled )
+            psBlock->bOK = TIFFReadEncodedTile( psJob->hTIFF,
+                                                psBlock->nBlockId,
+                                                pabyDecoded,
+                                                nBlockReqSize ) != -1;
+        else
+            psBlock->bOK = TIFFReadEncodedStrip( psJob->hTIFF,
+                                                 psBlock->nBlockId,
+                                                 pabyDecoded,
+                                                 nBlockReqSize ) != -1;
+
+        if( psBlock->bOK && pabyTmpBuffer != NULL )
+        {
+            for( int iBand = 0; iBand < nBandsPerBlock; ++iBand )
+            {
+                if( papabyDest[iBand] == NULL )
+                    continue;
+                GDALCopyWords(pabyTmpBuffer + iBand * nWordBytes,
+                              psJob->eDataType, nBandsPerBlock * nWordBytes,
+                              papabyDest[iBand], psJob->eDataType, nWordBytes,
+                              nBlockPixels);
+            }
+        }
+    }
+
+    CPLPopErrorHandler();
+
+    VSIFree(pabyTmpBuffer);
+}
+
+/************************************************************************/
+/*                   GTiffDecompressionBlockOffsetLess()                */
+/************************************************************************/
+
+static bool GTiffDecompressionBlockOffsetLess( const GTiffDecompressionBlock& a,
+                                               const GTiffDecompressionBlock& b )
+{
+    return a.nOffset < b.nOffset;
+}
+
+/************************************************************************/
+/*                       CacheBlocksMultiThreaded()                     */
+/************************************************************************/
+
+// Decode in worker threads the compressed blocks intersecting the window
+// that are not yet in the block cache. The raw data of those blocks is
+// fetched at once (with ReadMultiRange(), which is efficient on network
+// file systems), and the decoded data is directly written in the block
+// cache, so that the subsequent GDALRasterBand::IRasterIO() finds it there.
+
+void GTiffDataset::CacheBlocksMultiThreaded( int nXOff, int nYOff,
+                                             int nXSize, int nYSize,
+                                             int nBandCount,
+                                             const int *panBandMap )
+{
+    GTiffDataset* poRootDS = this;
+    while( poRootDS->poBaseDS != NULL )
+        poRootDS = poRootDS->poBaseDS;
+
+    if( poRootDS->nDecompressThreads <= 1 ||
+        eAccess != GA_ReadOnly ||
+        bStreamingIn ||
+        nCompression == COMPRESSION_NONE ||
+        bTreatAsRGBA || bTreatAsSplit || bTreatAsSplitBitmap ||
+        nBands == 0 || nXSize <= 0 || nYSize <= 0 )
+    {
+        return;
+    }
+
+    // Only for the plain GTiffRasterBand case (not odd bits, bitmap, ...)
+    const GDALDataType eDataType = GetRasterBand(1)->GetRasterDataType();
+    const int nDTSize = GDALGetDataTypeSizeBytes(eDataType);
+    if( nBitsPerSample != nDTSize * 8 )
+        return;
+
+    if( !SetDirectory() )
+        return;
+
+    const bool bSeparate =
+        nBands == 1 || nPlanarConfig == PLANARCONFIG_SEPARATE;
+    const int nBandsPerBlock = bSeparate ? 1 : nBands;
+    const GIntBig nBlockBufSize = TIFFIsTiled(hTIFF) ?
+        static_cast<GIntBig>(TIFFTileSize(hTIFF)) :
+        static_cast<GIntBig>(TIFFStripSize(hTIFF));
+    if( nBlockBufSize <= 0 || nBlockBufSize > INT_MAX ||
+        nBlockBufSize != static_cast<GIntBig>(nBlockXSize) * nBlockYSize *
+                                                nDTSize * nBandsPerBlock )
+    {
+        return;
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Collect the blocks that are not in the block cache.             */
+/* -------------------------------------------------------------------- */
+    const int nBlocksPerRow = DIV_ROUND_UP(nRasterXSize, nBlockXSize);
+    const int nBlockX1 = nXOff / static_cast<int>(nBlockXSize);
+    const int nBlockY1 = nYOff / static_cast<int>(nBlockYSize);
+    const int nBlockX2 = (nXOff + nXSize - 1) / static_cast<int>(nBlockXSize);
+    const int nBlockY2 = (nYOff + nYSize - 1) / static_cast<int>(nBlockYSize);
+
+    std::vector<GTiffDecompressionBlock> asBlocks;
+    for( int iY = nBlockY1; iY <= nBlockY2; ++iY )
+    {
+        for( int iX = nBlockX1; iX <= nBlockX2; ++iX )
+        {
+            for( int i = 0; i < (bSeparate ? nBandCount : 1); ++i )
+            {
+                bool bMissing = false;
+                for( int j = 0; j < (bSeparate ? 1 : nBandCount); ++j )
+                {
+                    GTiffRasterBand* poBand = static_cast<GTiffRasterBand*>(
+                        GetRasterBand(panBandMap[i + j]));
+                    GDALRasterBlock* poBlock =
+                        poBand->TryGetLockedBlockRef(iX, iY);
+                    if( poBlock == NULL )
+                    {
+                        bMissing = true;
+                        break;
+                    }
+                    poBlock->DropLock();
+                }
+                if( !bMissing )
+                    continue;
+
+                GTiffDecompressionBlock sBlock;
+                sBlock.nBlockXOff = iX;
+                sBlock.nBlockYOff = iY;
+                sBlock.nBlockId = iX + iY * nBlocksPerRow;
+                sBlock.nBand = bSeparate ? panBandMap[i] : 0;
+                if( nPlanarConfig == PLANARCONFIG_SEPARATE )
+                    sBlock.nBlockId += (sBlock.nBand - 1) * nBlocksPerBand;
+                else if( sBlock.nBlockId == nLoadedBlock )
+                    continue;
+                sBlock.bOK = false;
+
+                vsi_l_offset nOffset = 0;
+                vsi_l_offset nSize = 0;
+                if( !IsBlockAvailable(sBlock.nBlockId, &nOffset, &nSize) ||
+                    nSize > static_cast<vsi_l_offset>(INT_MAX) )
+                {
+                    continue;
+                }
+                sBlock.nOffset = nOffset;
+                sBlock.nSize = static_cast<size_t>(nSize);
+                asBlocks.push_back(sBlock);
+            }
+        }
+    }
+
+    const int nBlocks = static_cast<int>(asBlocks.size());
+    if( nBlocks < 2 )
+        return;
+
+    // Decoding is only worth it if the blocks can stay in the cache until
+    // the RasterIO() request uses them.
+    if( static_cast<GIntBig>(nBlocks) * nBlockBufSize > GDALGetCacheMax64() )
+    {
+        CPLDebug( "GTiff",
+                  "Not using threads for decompression. "
+                  "Cache not big enough. "
+                  "At least " CPL_FRMT_GIB " bytes necessary",
+                  static_cast<GIntBig>(nBlocks) * nBlockBufSize );
+        return;
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Get the thread pool and a TIFF handle for each job.             */
+/* -------------------------------------------------------------------- */
+    if( poRootDS->poDecompressThreadPool == NULL )
+    {
+        poRootDS->poDecompressThreadPool = new CPLWorkerThreadPool();
+        if( !poRootDS->poDecompressThreadPool->Setup(
+                        poRootDS->nDecompressThreads, NULL, NULL) )
+        {
+            delete poRootDS->poDecompressThreadPool;
+            poRootDS->poDecompressThreadPool = NULL;
+            poRootDS->nDecompressThreads = 0;
+            return;
+        }
+    }
+
+    const int nJobs = std::min(poRootDS->nDecompressThreads, nBlocks);
+    while( static_cast<int>(ahDecompressTIFF.size()) < nJobs )
+    {
+        const char* pszFilename = poRootDS->osFilename.c_str();
+        VSILFILE* fpTmp = VSIFOpenL(pszFilename, "rb");
+        if( fpTmp == NULL )
+            return;
+        TIFF* hTIFFTmp = VSI_TIFFOpen(pszFilename, "r", fpTmp);
+        if( hTIFFTmp == NULL || !TIFFSetSubDirectory(hTIFFTmp, nDirOffset) )
+        {
+            if( hTIFFTmp != NULL )
+                XTIFFClose(hTIFFTmp);
+            CPL_IGNORE_RET_VAL(VSIFCloseL(fpTmp));
+            return;
+        }
+        if( nCompression == COMPRESSION_JPEG &&
+            nPhotometric == PHOTOMETRIC_YCBCR )
+        {
+            int nColorMode = 0;
+            if( TIFFGetField( hTIFF, TIFFTAG_JPEGCOLORMODE, &nColorMode ) &&
+                nColorMode == JPEGCOLORMODE_RGB )
+            {
+                TIFFSetField(hTIFFTmp, TIFFTAG_JPEGCOLORMODE,
+                             JPEGCOLORMODE_RGB);
+            }
+        }
+        ahDecompressTIFF.push_back(hTIFFTmp);
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Fetch the raw data of the blocks, in file order.                */
+/* -------------------------------------------------------------------- */
+    std::sort(asBlocks.begin(), asBlocks.end(),
+              GTiffDecompressionBlockOffsetLess);
+
+    std::vector<void*> apRawData(nBlocks, static_cast<void*>(NULL));
+    std::vector<vsi_l_offset> anOffsets(nBlocks);
+    std::vector<size_t> anSizes(nBlocks);
+    bool bOK = true;
+    for( int i = 0; i < nBlocks; ++i )
+    {
+        anOffsets[i] = asBlocks[i].nOffset;
+        anSizes[i] = asBlocks[i].nSize;
+        apRawData[i] = VSIMalloc(asBlocks[i].nSize);
+        if( apRawData[i] == NULL )
+        {
+            bOK = false;
+            break;
+        }
+    }
+    if( bOK )
+    {
+        VSILFILE* fp = VSI_TIFFGetVSILFile(TIFFClientdata( hTIFF ));
+        bOK = VSIFReadMultiRangeL(nBlocks, &apRawData[0], &anOffsets[0],
+                                  &anSizes[0], fp) == 0;
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Create the destination blocks in the block cache.               */
+/* -------------------------------------------------------------------- */
+    std::vector<GDALRasterBlock*> apoBlocks(nBlocks * nBandsPerBlock,
+                    static_cast<GDALRasterBlock*>(NULL));
+    std::vector<GByte*> apabyDest(nBlocks * nBandsPerBlock,
+                                  static_cast<GByte*>(NULL));
+    for( int i = 0; bOK && i < nBlocks; ++i )
+    {
+        for( int iBand = 0; iBand < nBandsPerBlock; ++iBand )
+        {
+            GTiffRasterBand* poBand = static_cast<GTiffRasterBand*>(
+                GetRasterBand(bSeparate ? asBlocks[i].nBand : iBand + 1));
+            if( !bSeparate )
+            {
+                GDALRasterBlock* poBlock = poBand->TryGetLockedBlockRef(
+                    asBlocks[i].nBlockXOff, asBlocks[i].nBlockYOff);
+                if( poBlock != NULL )
+                {
+                    poBlock->DropLock();
+                    continue;
+                }
+            }
+            GDALRasterBlock* poBlock = poBand->GetLockedBlockRef(
+                asBlocks[i].nBlockXOff, asBlocks[i].nBlockYOff, TRUE);
+            if( poBlock == NULL )
+            {
+                bOK = false;
+                break;
+            }
+            apoBlocks[i * nBandsPerBlock + iBand] = poBlock;
+            apabyDest[i * nBandsPerBlock + iBand] =
+                static_cast<GByte*>(poBlock->GetDataRef());
+        }
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Decode.                                                         */
+/* -------------------------------------------------------------------- */
+    if( bOK )
+    {
+#if DEBUG_VERBOSE
+        CPLDebug("GTiff", "Decompressing %d blocks with %d threads",
+                 nBlocks, nJobs);
+#endif
+        std::vector<GTiffDecompressionJob> asJobs(nJobs);
+        std::vector<void*> apJobs(nJobs);
+        for( int i = 0; i < nJobs; ++i )
+        {
+            asJobs[i].poDS = this;
+            asJobs[i].hTIFF = ahDecompressTIFF[i];
+            asJobs[i].pasBlocks = &asBlocks[0];
+            asJobs[i].nBlocks = nBlocks;
+            asJobs[i].iFirstBlock = i;
+            asJobs[i].nBlockStep = nJobs;
+            asJobs[i].papabyDest = &apabyDest[0];
+            asJobs[i].nBandsPerBlock = nBandsPerBlock;
+            asJobs[i].nBlockBufSize = static_cast<int>(nBlockBufSize);
+            asJobs[i].eDataType = eDataType;
+            apJobs[i] = &asJobs[i];
+            VSI_TIFFSetCachedRanges( TIFFClientdata( ahDecompressTIFF[i] ),
+                                     nBlocks, &apRawData[0],
+                                     &anOffsets[0], &anSizes[0] );
+        }
+        poRootDS->poDecompressThreadPool->SubmitJobs(ThreadDecompressionFunc,
+                                                     apJobs);
+        poRootDS->poDecompressThreadPool->WaitCompletion();
+        for( int i = 0; i < nJobs; ++i )
+        {
+            VSI_TIFFSetCachedRanges( TIFFClientdata( ahDecompressTIFF[i] ),
+                                     0, NULL, NULL, NULL );
+        }
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Release the blocks. Those that could not be decoded are         */
+/*      removed from the cache, so that they are read again by          */
+/*      IReadBlock(), which will report the error.                      */
+/* -------------------------------------------------------------------- */
+    for( int i = 0; i < nBlocks; ++i )
+    {
+        for( int iBand = 0; iBand < nBandsPerBlock; ++iBand )
+        {
+            GDALRasterBlock* poBlock = apoBlocks[i * nBandsPerBlock + iBand];
+            if( poBlock == NULL )
+                continue;
+            poBlock->DropLock();
+            if( !asBlocks[i].bOK )
+            {
+                GetRasterBand(bSeparate ? asBlocks[i].nBand : iBand + 1)->
+                    FlushBlock(asBlocks[i].nBlockXOff,
+                               asBlocks[i].nBlockYOff, FALSE);
+            }
+        }
+        VSIFree(apRawData[i]);
+    }
+}
+
 /************************************************************************/
 /*                          DiscardLsb()                                */
 /************************************************************************/
@@ -8125,7 +8608,9 @@ void GTiffCacheOffsetOrCount(VSILFILE* fp,
 /*      zero then the block has never been committed to disk.           */
 /************************************************************************/
 
-int GTiffDataset::IsBlockAvailable( int nBlockId )
+int GTiffDataset::IsBlockAvailable( int nBlockId,
+                                    vsi_l_offset* pnOffset,
+                                    vsi_l_offset* pnSize )
 
 {
 #ifdef INTERNAL_LIBTIFF
@@ -8246,20 +8731,34 @@ int GTiffDataset::IsBlockAvailable( int nBlockId )
                 return FALSE;
             }
         }
+        if( pnOffset )
+            *pnOffset = hTIFF->tif_dir.td_stripoffset[nBlockId];
+        if( pnSize )
+            *pnSize = hTIFF->tif_dir.td_stripbytecount[nBlockId];
         return hTIFF->tif_dir.td_stripbytecount[nBlockId] != 0;
     }
 #endif  // DEFER_STRILE_LOAD
 #endif  // INTERNAL_LIBTIFF
     toff_t *panByteCounts = NULL;
+    toff_t *panOffsets = NULL;
+    const bool bIsTiled = CPL_TO_BOOL( TIFFIsTiled(hTIFF) );
 
-    if( ( TIFFIsTiled( hTIFF )
-          && TIFFGetField( hTIFF, TIFFTAG_TILEBYTECOUNTS, &panByteCounts ) )
-        || ( !TIFFIsTiled( hTIFF )
-          && TIFFGetField( hTIFF, TIFFTAG_STRIPBYTECOUNTS, &panByteCounts ) ) )
+    if( ( bIsTiled
+          && TIFFGetField( hTIFF, TIFFTAG_TILEBYTECOUNTS, &panByteCounts )
+          && (pnOffset == NULL ||
+              TIFFGetField( hTIFF, TIFFTAG_TILEOFFSETS, &panOffsets )) )
+        || ( !bIsTiled
+          && TIFFGetField( hTIFF, TIFFTAG_STRIPBYTECOUNTS, &panByteCounts )
+          && (pnOffset == NULL ||
+              TIFFGetField( hTIFF, TIFFTAG_STRIPOFFSETS, &panOffsets )) ) )
     {
-        if( panByteCounts == NULL )
+        if( panByteCounts == NULL || (pnOffset != NULL && panOffsets == NULL) )
             return FALSE;
 
+        if( pnOffset )
+            *pnOffset = panOffsets[nBlockId];
+        if( pnSize )
+            *pnSize = panByteCounts[nBlockId];
         return panByteCounts[nBlockId] != 0;
     }
 
@@ -8479,6 +8978,7 @@ CPLErr GTiffDataset::RegisterNewOverviewDataset(toff_t nOverviewOffset)
     poODS->nJpegQuality = nJpegQuality;
     poODS->nZLevel = nZLevel;
     poODS->nLZMAPreset = nLZMAPreset;
+    poODS->nZSTDLevel = nZSTDLevel;
 
     if( nCompression == COMPRESSION_JPEG )
     {
@@ -8605,7 +9105,8 @@ CPLErr GTiffDataset::CreateOverviewsFromSrcOverviews(GDALDataset* poSrcDS)
 /* -------------------------------------------------------------------- */
     uint16 nPredictor = PREDICTOR_NONE;
     if( nCompression == COMPRESSION_LZW ||
-        nCompression == COMPRESSION_ADOBE_DEFLATE )
+        nCompression == COMPRESSION_ADOBE_DEFLATE ||
+        nCompression == COMPRESSION_ZSTD )
         TIFFGetField( hTIFF, TIFFTAG_PREDICTOR, &nPredictor );
     int nOvrBlockXSize = 0;
     int nOvrBlockYSize = 0;
@@ -8976,7 +9477,8 @@ CPLErr GTiffDataset::IBuildOverviews(
 /* -------------------------------------------------------------------- */
     uint16 nPredictor = PREDICTOR_NONE;
     if( nCompression == COMPRESSION_LZW ||
-        nCompression == COMPRESSION_ADOBE_DEFLATE )
+        nCompression == COMPRESSION_ADOBE_DEFLATE ||
+        nCompression == COMPRESSION_ZSTD )
         TIFFGetField( hTIFF, TIFFTAG_PREDICTOR, &nPredictor );
 
 /* -------------------------------------------------------------------- */
@@ -10224,6 +10726,8 @@ int GTiffDataset::SetDirectory( toff_t nNewOffset )
             TIFFSetField(hTIFF, TIFFTAG_ZIPQUALITY, nZLevel);
         if(nLZMAPreset > 0 && nCompression == COMPRESSION_LZMA)
             TIFFSetField(hTIFF, TIFFTAG_LZMAPRESET, nLZMAPreset);
+        if(nZSTDLevel > 0 && nCompression == COMPRESSION_ZSTD)
+            TIFFSetField(hTIFF, TIFFTAG_ZSTD_LEVEL, nZSTDLevel);
     }
 
     return nSetDirResult;
@@ -10761,6 +11265,10 @@ GDALDataset *GTiffDataset::Open( GDALOpenInfo * poOpenInfo )
     {
         poDS->InitCreationOrOpenOptions(poOpenInfo->papszOpenOptions);
     }
+    else if( !bStreaming )
+    {
+        poDS->InitDecompressionThreads(poOpenInfo->papszOpenOptions);
+    }
 
     if( nCompression == COMPRESSION_JPEG && poOpenInfo->eAccess == GA_Update )
     {
@@ -12315,6 +12823,10 @@ CPLErr GTiffDataset::OpenOffset( TIFF *hTIFFIn,
     {
         oGTiffMDMD.SetMetadataItem( "COMPRESSION", "LZMA", "IMAGE_STRUCTURE" );
     }
+    else if( nCompression == COMPRESSION_ZSTD )
+    {
+        oGTiffMDMD.SetMetadataItem( "COMPRESSION", "ZSTD", "IMAGE_STRUCTURE" );
+    }
     else
     {
         CPLString oComp;
@@ -12991,6 +13503,25 @@ static int GTiffGetLZMAPreset(char** papszOptions)
 }
 
 
+static int GTiffGetZSTDLevel(char** papszOptions)
+{
+    int nZSTDLevel = -1;
+    const char* pszValue = CSLFetchNameValue( papszOptions, "ZSTD_LEVEL" );
+    if( pszValue  != NULL )
+    {
+        nZSTDLevel =  atoi( pszValue );
+        if( !(nZSTDLevel >= 1 && nZSTDLevel <= 22) )
+        {
+            CPLError( CE_Warning, CPLE_IllegalArg,
+                      "ZSTD_LEVEL=%s value not recognised, ignoring.",
+                      pszValue );
+            nZSTDLevel = -1;
+        }
+    }
+    return nZSTDLevel;
+}
+
+
 static int GTiffGetZLevel(char** papszOptions)
 {
     int nZLevel = -1;
@@ -13201,6 +13732,7 @@ TIFF *GTiffDataset::CreateLL( const char * pszFilename,
 
     int nZLevel = GTiffGetZLevel(papszParmList);
     int nLZMAPreset = GTiffGetLZMAPreset(papszParmList);
+    int nZSTDLevel = GTiffGetZSTDLevel(papszParmList);
     int nJpegQuality = GTiffGetJpegQuality(papszParmList);
     int nJpegTablesMode = GTiffGetJpegTablesMode(papszParmList);
 
@@ -13708,7 +14240,8 @@ TIFF *GTiffDataset::CreateLL( const char * pszFilename,
 /*      Set compression related tags.                                   */
 /* -------------------------------------------------------------------- */
     if( nCompression == COMPRESSION_LZW ||
-         nCompression == COMPRESSION_ADOBE_DEFLATE )
+         nCompression == COMPRESSION_ADOBE_DEFLATE ||
+         nCompression == COMPRESSION_ZSTD )
         TIFFSetField( hTIFF, TIFFTAG_PREDICTOR, nPredictor );
     if( nCompression == COMPRESSION_ADOBE_DEFLATE && nZLevel != -1 )
         TIFFSetField( hTIFF, TIFFTAG_ZIPQUALITY, nZLevel );
@@ -13716,6 +14249,8 @@ TIFF *GTiffDataset::CreateLL( const char * pszFilename,
         TIFFSetField( hTIFF, TIFFTAG_JPEGQUALITY, nJpegQuality );
     else if( nCompression == COMPRESSION_LZMA && nLZMAPreset != -1)
         TIFFSetField( hTIFF, TIFFTAG_LZMAPRESET, nLZMAPreset );
+    else if( nCompression == COMPRESSION_ZSTD && nZSTDLevel != -1 )
+        TIFFSetField( hTIFF, TIFFTAG_ZSTD_LEVEL, nZSTDLevel );
 
     if( nCompression == COMPRESSION_JPEG )
         TIFFSetField( hTIFF, TIFFTAG_JPEGTABLESMODE, nJpegTablesMode );
@@ -14183,6 +14718,7 @@ GDALDataset *GTiffDataset::Create( const char * pszFilename,
 
     poDS->nZLevel = GTiffGetZLevel(papszParmList);
     poDS->nLZMAPreset = GTiffGetLZMAPreset(papszParmList);
+    poDS->nZSTDLevel = GTiffGetZSTDLevel(papszParmList);
     poDS->nJpegQuality = GTiffGetJpegQuality(papszParmList);
     poDS->nJpegTablesMode = GTiffGetJpegTablesMode(papszParmList);
     poDS->InitCreationOrOpenOptions(papszParmList);
@@ -14251,6 +14787,216 @@ GDALDataset *GTiffDataset::Create( const char * pszFilename,
     return poDS;
 }
 
+/************************************************************************/
+/*                      CreateCloudOptimizedCopy()                      */
+/*                                                                      */
+/*      Implements COG=YES. The source is read only once: its           */
+/*      imagery is spooled into a temporary tiled file, the overviews   */
+/*      are computed from that file, and the final file is then         */
+/*      assembled with COPY_SRC_OVERVIEWS=YES, so that all the IFDs     */
+/*      are at its beginning, followed by the tiles of the smallest     */
+/*      overview up to the full resolution ones.                        */
+/************************************************************************/
+
+GDALDataset *
+GTiffDataset::CreateCloudOptimizedCopy( const char * pszFilename,
+                                        GDALDataset *poSrcDS,
+                                        int bStrict, char ** papszOptions,
+                                        GDALProgressFunc pfnProgress,
+                                        void * pProgressData )
+
+{
+    const int nXSize = poSrcDS->GetRasterXSize();
+    const int nYSize = poSrcDS->GetRasterYSize();
+
+    int nBlockXSize = 256;
+    int nBlockYSize = 256;
+    const char* pszValue = CSLFetchNameValue(papszOptions, "BLOCKXSIZE");
+    if( pszValue != NULL )
+        nBlockXSize = atoi(pszValue);
+    pszValue = CSLFetchNameValue(papszOptions, "BLOCKYSIZE");
+    if( pszValue != NULL )
+        nBlockYSize = atoi(pszValue);
+    if( nBlockXSize <= 0 || nBlockYSize <= 0 ||
+        (nBlockXSize % 16) != 0 || (nBlockYSize % 16) != 0 )
+    {
+        CPLError( CE_Failure, CPLE_NotSupported,
+                  "COG=YES requires BLOCKXSIZE and BLOCKYSIZE to be "
+                  "multiples of 16" );
+        return NULL;
+    }
+
+    // The final file is written with COPY_SRC_OVERVIEWS=YES, which streaming
+    // does not support: fail before reading the source.
+    if( strcmp(pszFilename, "/vsistdout/") == 0 ||
+        CSLFetchBoolean(papszOptions, "STREAMABLE_OUTPUT", FALSE) )
+    {
+        CPLError( CE_Failure, CPLE_NotSupported,
+                  "COG=YES is not supported with streaming output" );
+        return NULL;
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Options of the temporary file. Its compression must be          */
+/*      lossless, so that the overviews are computed from the source    */
+/*      values.                                                         */
+/* -------------------------------------------------------------------- */
+    char** papszTmpOptions = NULL;
+    const char* const apszTmpOptionNames[] = {
+        "BLOCKXSIZE", "BLOCKYSIZE", "INTERLEAVE", "NBITS", "PIXELTYPE",
+        "ALPHA", "PROFILE", "BIGTIFF", "NUM_THREADS", NULL };
+    for( int i = 0; apszTmpOptionNames[i] != NULL; ++i )
+    {
+        pszValue = CSLFetchNameValue(papszOptions, apszTmpOptionNames[i]);
+        if( pszValue != NULL )
+            papszTmpOptions = CSLSetNameValue(papszTmpOptions,
+                                              apszTmpOptionNames[i],
+                                              pszValue);
+    }
+    papszTmpOptions = CSLSetNameValue(papszTmpOptions, "TILED", "YES");
+    papszTmpOptions = CSLSetNameValue(papszTmpOptions, "BLOCKXSIZE",
+                                      CPLSPrintf("%d", nBlockXSize));
+    papszTmpOptions = CSLSetNameValue(papszTmpOptions, "BLOCKYSIZE",
+                                      CPLSPrintf("%d", nBlockYSize));
+    const char* pszCompress = CSLFetchNameValue(papszOptions, "COMPRESS");
+    if( pszCompress != NULL &&
+        (EQUAL(pszCompress, "NONE") || EQUAL(pszCompress, "LZW") ||
+         EQUAL(pszCompress, "DEFLATE") || EQUAL(pszCompress, "ZSTD") ||
+         EQUAL(pszCompress, "PACKBITS")) )
+    {
+        papszTmpOptions = CSLSetNameValue(papszTmpOptions, "COMPRESS",
+                                          pszCompress);
+        pszValue = CSLFetchNameValue(papszOptions, "PREDICTOR");
+        if( pszValue != NULL )
+            papszTmpOptions = CSLSetNameValue(papszTmpOptions, "PREDICTOR",
+                                              pszValue);
+    }
+    else
+    {
+        papszTmpOptions = CSLSetNameValue(papszTmpOptions, "COMPRESS",
+                                          "DEFLATE");
+        papszTmpOptions = CSLSetNameValue(papszTmpOptions, "ZLEVEL", "1");
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Overview levels: halve the dimensions until the smallest        */
+/*      level fits into a single block.                                 */
+/* -------------------------------------------------------------------- */
+    std::vector<int> anOverviewList;
+    int nOvrFactor = 1;
+    while( DIV_ROUND_UP(nXSize, nOvrFactor) > nBlockXSize ||
+           DIV_ROUND_UP(nYSize, nOvrFactor) > nBlockYSize )
+    {
+        nOvrFactor *= 2;
+        anOverviewList.push_back(nOvrFactor);
+    }
+    const char* pszResampling =
+        CSLFetchNameValueDef(papszOptions, "OVERVIEW_RESAMPLING", "NEAREST");
+
+    // Overviews get the same block dimensions as the full resolution
+    // image when that is acceptable for GDAL_TIFF_OVR_BLOCKSIZE.
+    const bool bSetOvrBlockSize =
+        nBlockXSize == nBlockYSize && nBlockXSize >= 64 &&
+        nBlockXSize <= 4096 && IsPowerOfTwo(nBlockXSize) &&
+        CPLGetConfigOption("GDAL_TIFF_OVR_BLOCKSIZE", NULL) == NULL;
+    if( bSetOvrBlockSize )
+        CPLSetThreadLocalConfigOption("GDAL_TIFF_OVR_BLOCKSIZE",
+                                      CPLSPrintf("%d", nBlockXSize));
+
+/* -------------------------------------------------------------------- */
+/*      Spool the source into the temporary file.                       */
+/* -------------------------------------------------------------------- */
+    // The temporary file has a name that is unique to this process and
+    // call, so that an existing file is not overwritten and concurrent
+    // writes of the same target do not share it. It is next to the target
+    // when that is a local or in-memory file. Otherwise, as for an archive
+    // or a network file system that only supports sequential writing, it
+    // goes to the directory of CPLGenerateTempFilename().
+    const CPLString osTmpStem(
+        CPLGenerateTempFilename(
+            CPLSPrintf("%s.tmp", CPLGetFilename(pszFilename)) ) );
+    CPLString osTmpFilename;
+    if( !STARTS_WITH(pszFilename, "/vsi") ||
+        STARTS_WITH(pszFilename, "/vsimem/") )
+    {
+        osTmpFilename = CPLFormFilename( CPLGetPath(pszFilename),
+                                         CPLGetFilename(osTmpStem), "tif" );
+    }
+    else
+    {
+        osTmpFilename = osTmpStem + ".tif";
+    }
+    GDALDataset* poDstDS = NULL;
+
+    void* pScaledData =
+        GDALCreateScaledProgress( 0.0, 0.5, pfnProgress, pProgressData );
+    GDALDataset* poTmpDS =
+        CreateCopy( osTmpFilename, poSrcDS, bStrict, papszTmpOptions,
+                    GDALScaledProgress, pScaledData );
+    GDALDestroyScaledProgress(pScaledData);
+    CSLDestroy(papszTmpOptions);
+
+/* -------------------------------------------------------------------- */
+/*      Compute the overviews from it.                                  */
+/* -------------------------------------------------------------------- */
+    CPLErr eErr = poTmpDS != NULL ? CE_None : CE_Failure;
+    if( eErr == CE_None && !anOverviewList.empty() )
+    {
+        pScaledData =
+            GDALCreateScaledProgress( 0.5, 0.75, pfnProgress, pProgressData );
+        eErr = poTmpDS->BuildOverviews(
+            pszResampling, static_cast<int>(anOverviewList.size()),
+            &anOverviewList[0], 0, NULL, GDALScaledProgress, pScaledData );
+        GDALDestroyScaledProgress(pScaledData);
+        poTmpDS->FlushCache();
+    }
+
+/* -------------------------------------------------------------------- */
+/*      And assemble the final file.                                    */
+/* -------------------------------------------------------------------- */
+    if( eErr == CE_None )
+    {
+        char** papszFinalOptions = CSLDuplicate(papszOptions);
+        papszFinalOptions = CSLSetNameValue(papszFinalOptions, "COG", NULL);
+        papszFinalOptions = CSLSetNameValue(papszFinalOptions,
+                                            "OVERVIEW_RESAMPLING", NULL);
+        papszFinalOptions = CSLSetNameValue(papszFinalOptions, "TILED",
+                                            "YES");
+        papszFinalOptions = CSLSetNameValue(papszFinalOptions,
+                                            "COPY_SRC_OVERVIEWS", "YES");
+
+        pScaledData =
+            GDALCreateScaledProgress( 0.75, 1.0, pfnProgress, pProgressData );
+        poDstDS = CreateCopy( pszFilename, poTmpDS, bStrict,
+                              papszFinalOptions,
+                              GDALScaledProgress, pScaledData );
+        GDALDestroyScaledProgress(pScaledData);
+        CSLDestroy(papszFinalOptions);
+    }
+
+    if( bSetOvrBlockSize )
+        CPLSetThreadLocalConfigOption("GDAL_TIFF_OVR_BLOCKSIZE", NULL);
+
+/* -------------------------------------------------------------------- */
+/*      Remove the temporary file, including what a failed CreateCopy() */
+/*      may have left behind of it.                                     */
+/* -------------------------------------------------------------------- */
+    delete poTmpDS;
+    VSIStatBufL sStat;
+    if( VSIStatL(osTmpFilename, &sStat) == 0 )
+    {
+        GDALDriver* poDriver =
+            GetGDALDriverManager()->GetDriverByName("GTiff");
+        CPLPushErrorHandler(CPLQuietErrorHandler);
+        if( poDriver != NULL )
+            poDriver->Delete(osTmpFilename);
+        CPLPopErrorHandler();
+        VSIUnlink(osTmpFilename);
+    }
+
+    return poDstDS;
+}
+
 /************************************************************************/
 /*                             CreateCopy()                             */
 /************************************************************************/
@@ -14268,6 +15014,13 @@ GTiffDataset::CreateCopy( const char * pszFilename, GDALDataset *poSrcDS,
         return NULL;
     }
 
+    if( CSLFetchBoolean(papszOptions, "COG", FALSE) )
+    {
+        return CreateCloudOptimizedCopy( pszFilename, poSrcDS, bStrict,
+                                         papszOptions,
+                                         pfnProgress, pProgressData );
+    }
+
     GDALRasterBand * const poPBand = poSrcDS->GetRasterBand(1);
     const GDALDataType eType = poPBand->GetRasterDataType();
 
@@ -15141,6 +15894,7 @@ GTiffDataset::CreateCopy( const char * pszFilename, GDALDataset *poSrcDS,
 
     poDS->nZLevel = GTiffGetZLevel(papszOptions);
     poDS->nLZMAPreset = GTiffGetLZMAPreset(papszOptions);
+    poDS->nZSTDLevel = GTiffGetZSTDLevel(papszOptions);
     poDS->nJpegQuality = GTiffGetJpegQuality(papszOptions);
     poDS->nJpegTablesMode = GTiffGetJpegTablesMode(papszOptions);
     poDS->GetDiscardLsbOption(papszOptions);
@@ -15168,6 +15922,13 @@ GTiffDataset::CreateCopy( const char * pszFilename, GDALDataset *poSrcDS,
             TIFFSetField( hTIFF, TIFFTAG_LZMAPRESET, poDS->nLZMAPreset );
         }
     }
+    else if( nCompression == COMPRESSION_ZSTD )
+    {
+        if( poDS->nZSTDLevel != -1 )
+        {
+            TIFFSetField( hTIFF, TIFFTAG_ZSTD_LEVEL, poDS->nZSTDLevel );
+        }
+    }
 
     // Precreate (internal) mask, so that the IBuildOverviews() below
     // has a chance to create also the overviews of the mask.
@@ -16430,6 +17191,8 @@ int GTIFFGetCompressionMethod(const char* pszValue, const char* pszVariableName)
         nCompression = COMPRESSION_CCITTRLE;
     else if( EQUAL( pszValue, "LZMA" ) )
         nCompression = COMPRESSION_LZMA;
+    else if( EQUAL( pszValue, "ZSTD" ) )
+        nCompression = COMPRESSION_ZSTD;
     else
         CPLError( CE_Warning, CPLE_IllegalArg,
                     "%s=%s value not recognised, ignoring.",
@@ -16459,12 +17222,13 @@ void GDALRegister_GTiff()
     if( GDALGetDriverByName( "GTiff" ) != NULL )
         return;
 
-    char szCreateOptions[5000] = { '\0' };
+    char szCreateOptions[6000] = { '\0' };
     char szOptionalCompressItems[500] = { '\0' };
     bool bHasJPEG = false;
     bool bHasLZW = false;
     bool bHasDEFLATE = false;
     bool bHasLZMA = false;
+    bool bHasZSTD = false;
 
     GDALDriver *poDriver = new GDALDriver();
 
@@ -16531,6 +17295,12 @@ void GDALRegister_GTiff()
             strcat( szOptionalCompressItems,
                     "       <Value>LZMA</Value>" );
         }
+        else if( c->scheme == COMPRESSION_ZSTD )
+        {
+            bHasZSTD = true;
+            strcat( szOptionalCompressItems,
+                    "       <Value>ZSTD</Value>" );
+        }
     }
     _TIFFfree( codecs );
 #endif
@@ -16543,7 +17313,7 @@ void GDALRegister_GTiff()
               "   <Option name='COMPRESS' type='string-select'>",
               szOptionalCompressItems,
               "   </Option>");
-    if( bHasLZW || bHasDEFLATE )
+    if( bHasLZW || bHasDEFLATE || bHasZSTD )
         strcat( szCreateOptions, ""
 "   <Option name='PREDICTOR' type='int' description='Predictor Type (1=default, 2=horizontal differencing, 3=floating point prediction)'/>");
     strcat( szCreateOptions, ""
@@ -16564,6 +17334,9 @@ void GDALRegister_GTiff()
     if( bHasLZMA )
         strcat( szCreateOptions, ""
 "   <Option name='LZMA_PRESET' type='int' description='LZMA compression level 0(fast)-9(slow)' default='6'/>");
+    if( bHasZSTD )
+        strcat( szCreateOptions, ""
+"   <Option name='ZSTD_LEVEL' type='int' description='ZSTD compression level 1(fast)-22(slow)' default='9'/>");
     strcat( szCreateOptions, ""
 "   <Option name='NUM_THREADS' type='string' description='Number of worker threads for compression. Can be set to ALL_CPUS' default='1'/>"
 "   <Option name='NBITS' type='int' description='BITS for sub-byte files (1-7), sub-uint16 (9-15), sub-uint32 (17-31)'/>"
@@ -16620,6 +17393,8 @@ void GDALRegister_GTiff()
 "       <Value>BIG</Value>"
 "   </Option>"
 "   <Option name='COPY_SRC_OVERVIEWS' type='boolean' default='NO' description='Force copy of overviews of source dataset (CreateCopy())'/>"
+"   <Option name='COG' type='boolean' default='NO' description='Whether to create a cloud optimized GeoTIFF, with overviews computed while reading the source once (CreateCopy())'/>"
+"   <Option name='OVERVIEW_RESAMPLING' type='string' default='NEAREST' description='Resampling method for the overviews computed with COG=YES'/>"
 "   <Option name='SOURCE_ICC_PROFILE' type='string' description='ICC profile'/>"
 "   <Option name='SOURCE_PRIMARIES_RED' type='string' description='x,y,1.0 (xyY) red chromaticity'/>"
 "   <Option name='SOURCE_PRIMARIES_GREEN' type='string' description='x,y,1.0 (xyY) green chromaticity'/>"
@@ -16653,7 +17428,7 @@ void GDALRegister_GTiff()
     poDriver->SetMetadataItem( GDAL_DMD_CREATIONOPTIONLIST, szCreateOptions );
     poDriver->SetMetadataItem( GDAL_DMD_OPENOPTIONLIST,
 "<OpenOptionList>"
-"   <Option name='NUM_THREADS' type='string' description='Number of worker threads for compression. Can be set to ALL_CPUS' default='1'/>"
+"   <Option name='NUM_THREADS' type='string' description='Number of worker threads for compression (update mode) or decompression (read-only mode). Can be set to ALL_CPUS' default='1'/>"
 "   <Option name='GEOTIFF_KEYS_FLAVOR' type='string-select' default='STANDARD' description='Which flavor of GeoTIFF keys must be used (for writing)'>"
 "       <Value>STANDARD</Value>"
 "       <Value>ESRI_PE</Value>"
@@ -76,4 +76,12 @@ char** GTiffDatasetReadRPCTag( TIFF *hTIFF );
 #define TIFFTAG_LZMAPRESET      65562   /* LZMA2 preset (compression level) */
 #endif
 
+#if !defined(COMPRESSION_ZSTD)
+#define     COMPRESSION_ZSTD        50000   /* ZSTD */
+#endif
+
+#if !defined(TIFFTAG_ZSTD_LEVEL)
+#define TIFFTAG_ZSTD_LEVEL      65564   /* ZSTD compression level */
+#endif
+
 #endif // GTIFF_H_INCLUDED
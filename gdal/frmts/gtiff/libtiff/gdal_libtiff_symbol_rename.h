@@ -746,3 +746,6 @@
 #ifdef LZMA_SUPPORT
 #define TIFFInitLZMA gdal_TIFFInitLZMA
 #endif
+#ifdef ZSTD_SUPPORT
+#define TIFFInitZSTD gdal_TIFFInitZSTD
+#endif
@@ -32,6 +32,12 @@
 #include "tiffiop.h"
 #include "tif_predict.h"
 
+/* We restrict to 64bit processors because they are guaranteed to have SSE2 */
+#if defined(__x86_64) || defined(_M_X64)
+#define USE_SSE2
+#include <emmintrin.h>
+#endif
+
 #define	PredictorState(tif)	((TIFFPredictorState*) (tif)->tif_data)
 
 static void horAcc8(TIFF* tif, uint8* cp0, tmsize_t cc);
@@ -264,56 +270,200 @@ PredictorSetupEncode(TIFF* tif)
 /* - when storing into the byte stream, we explicitly mask with 0xff so */
 /*   as to make icc -check=conversions happy (not necessary by the standard) */
 
+#ifdef USE_SSE2
+
+/*
+ * SSE2 helpers for the horizontal predictor. They process whole 16-byte
+ * vectors and return the index of the first sample they did not handle,
+ * so that the caller finishes the row with its scalar loop.
+ */
+
+/* Is the distance in bytes between two samples of the same component */
+/* one that the vectorized accumulation can handle ? */
+#define PREDICT_SSE2_PERIOD_OK(sb) \
+    ((sb) == 1 || (sb) == 2 || (sb) == 4 || (sb) == 8)
+
+/*
+ * Running sum, inside a vector, of the lanes that are a multiple of sb
+ * bytes apart (sb being 1, 2, 4 or 8).
+ */
+#define PREDICT_SSE2_PREFIX_SUM(x, sb, add)				\
+    do {								\
+	if ((sb) == 1) x = add(x, _mm_slli_si128(x, 1));		\
+	if ((sb) <= 2) x = add(x, _mm_slli_si128(x, 2));		\
+	if ((sb) <= 4) x = add(x, _mm_slli_si128(x, 4));		\
+	x = add(x, _mm_slli_si128(x, 8));				\
+    } while(0)
+
+/*
+ * Fill c with the last sb bytes of v, repeated over the whole vector.
+ */
+#define PREDICT_SSE2_REPEAT_TAIL(c, v, sb)				\
+    do {								\
+	switch (sb) {							\
+	    case 1:  c = _mm_srli_si128(v, 15); break;			\
+	    case 2:  c = _mm_srli_si128(v, 14); break;			\
+	    case 4:  c = _mm_srli_si128(v, 12); break;			\
+	    default: c = _mm_srli_si128(v, 8); break;			\
+	}								\
+	if ((sb) == 1) c = _mm_or_si128(c, _mm_slli_si128(c, 1));	\
+	if ((sb) <= 2) c = _mm_or_si128(c, _mm_slli_si128(c, 2));	\
+	if ((sb) <= 4) c = _mm_or_si128(c, _mm_slli_si128(c, 4));	\
+	c = _mm_or_si128(c, _mm_slli_si128(c, 8));			\
+    } while(0)
+
+/*
+ * Horizontal accumulation of a row of wc samples, stride samples apart.
+ * Each vector is prefix-summed, then offset by the last output values of
+ * the previous vector.
+ */
+#define DEFINE_HORACC_SSE2(name, type, add)				\
+static tmsize_t								\
+name(type* wp, tmsize_t wc, tmsize_t stride)				\
+{									\
+	const tmsize_t nvals = (tmsize_t)(16 / sizeof(type));		\
+	const tmsize_t sb = stride * (tmsize_t)sizeof(type);		\
+	__m128i carry = _mm_setzero_si128();				\
+	tmsize_t i;							\
+	for (i = 0; i + nvals <= wc; i += nvals) {			\
+		__m128i x = _mm_loadu_si128((const __m128i*)(wp + i));	\
+		PREDICT_SSE2_PREFIX_SUM(x, sb, add);			\
+		x = add(x, carry);					\
+		_mm_storeu_si128((__m128i*)(wp + i), x);		\
+		PREDICT_SSE2_REPEAT_TAIL(carry, x, sb);			\
+	}								\
+	return i;							\
+}
+
+/*
+ * Horizontal differencing of a row of wc samples, stride samples apart.
+ * The row is processed from its end, so that each sample is differenced
+ * against the original value of its neighbour. Returns the number of
+ * leading samples that remain to be processed.
+ */
+#define DEFINE_HORDIFF_SSE2(name, type, sub)				\
+static tmsize_t								\
+name(type* wp, tmsize_t wc, tmsize_t stride)				\
+{									\
+	const tmsize_t nvals = (tmsize_t)(16 / sizeof(type));		\
+	tmsize_t i = wc;						\
+	while (i - nvals >= stride) {					\
+		__m128i a, b;						\
+		i -= nvals;						\
+		a = _mm_loadu_si128((const __m128i*)(wp + i));		\
+		b = _mm_loadu_si128((const __m128i*)(wp + i - stride));	\
+		_mm_storeu_si128((__m128i*)(wp + i), sub(a, b));	\
+	}								\
+	return i;							\
+}
+
+DEFINE_HORACC_SSE2(horAcc8SSE2, uint8, _mm_add_epi8)
+DEFINE_HORACC_SSE2(horAcc16SSE2, uint16, _mm_add_epi16)
+DEFINE_HORACC_SSE2(horAcc32SSE2, uint32, _mm_add_epi32)
+DEFINE_HORDIFF_SSE2(horDiff8SSE2, uint8, _mm_sub_epi8)
+DEFINE_HORDIFF_SSE2(horDiff16SSE2, uint16, _mm_sub_epi16)
+DEFINE_HORDIFF_SSE2(horDiff32SSE2, uint32, _mm_sub_epi32)
+
+/*
+ * Perfect shuffle of the bytes of nvec vectors: the bytes of the first
+ * half of the vectors are interleaved with the ones of the second half.
+ * Seen as an index into the concatenated vectors, this is a rotation of
+ * the index bits by one, so that a few rounds transpose between the byte
+ * planes and the interleaved samples of the floating point predictor.
+ */
 static void
-horAcc8(TIFF* tif, uint8* cp0, tmsize_t cc)
+fpShuffleSSE2(__m128i* v, uint32 nvec, int nrounds)
 {
-	tmsize_t stride = PredictorState(tif)->stride;
+	__m128i t[8];
+	uint32 half = nvec / 2;
+	uint32 i;
+	int round;
+
+	for (round = 0; round < nrounds; round++) {
+		for (i = 0; i < half; i++) {
+			t[2 * i] = _mm_unpacklo_epi8(v[i], v[i + half]);
+			t[2 * i + 1] = _mm_unpackhi_epi8(v[i], v[i + half]);
+		}
+		for (i = 0; i < nvec; i++)
+			v[i] = t[i];
+	}
+}
 
-	unsigned char* cp = (unsigned char*) cp0;
-	assert((cc%stride)==0);
-	if (cc > stride) {
-		/*
-		 * Pipeline the most common cases.
-		 */
-		if (stride == 3)  {
-			unsigned int cr = cp[0];
-			unsigned int cg = cp[1];
-			unsigned int cb = cp[2];
+#endif /* USE_SSE2 */
+
+/* Index of the byte plane that holds byte "byte" of the samples in the */
+/* output of the floating point predictor. */
+#if WORDS_BIGENDIAN
+#define FP_PLANE(byte, bps)	(byte)
+#else
+#define FP_PLANE(byte, bps)	((bps) - (byte) - 1)
+#endif
+
+static void
+accumulate8(unsigned char* cp, tmsize_t cc, tmsize_t stride)
+{
+#ifdef USE_SSE2
+	if (PREDICT_SSE2_PERIOD_OK(stride)) {
+		tmsize_t i = horAcc8SSE2(cp, cc, stride);
+		if (i < stride)
+			i = stride;
+		for (; i < cc; i++)
+			cp[i] = (unsigned char) ((cp[i] + cp[i - stride]) & 0xff);
+		return;
+	}
+#endif
+	/*
+	 * Pipeline the most common cases.
+	 */
+	if (stride == 3)  {
+		unsigned int cr = cp[0];
+		unsigned int cg = cp[1];
+		unsigned int cb = cp[2];
+		cc -= 3;
+		cp += 3;
+		while (cc>0) {
+			cp[0] = (unsigned char) ((cr += cp[0]) & 0xff);
+			cp[1] = (unsigned char) ((cg += cp[1]) & 0xff);
+			cp[2] = (unsigned char) ((cb += cp[2]) & 0xff);
 			cc -= 3;
 			cp += 3;
-			while (cc>0) {
-				cp[0] = (unsigned char) ((cr += cp[0]) & 0xff);
-				cp[1] = (unsigned char) ((cg += cp[1]) & 0xff);
-				cp[2] = (unsigned char) ((cb += cp[2]) & 0xff);
-				cc -= 3;
-				cp += 3;
-			}
-		} else if (stride == 4)  {
-			unsigned int cr = cp[0];
-			unsigned int cg = cp[1];
-			unsigned int cb = cp[2];
-			unsigned int ca = cp[3];
+		}
+	} else if (stride == 4)  {
+		unsigned int cr = cp[0];
+		unsigned int cg = cp[1];
+		unsigned int cb = cp[2];
+		unsigned int ca = cp[3];
+		cc -= 4;
+		cp += 4;
+		while (cc>0) {
+			cp[0] = (unsigned char) ((cr += cp[0]) & 0xff);
+			cp[1] = (unsigned char) ((cg += cp[1]) & 0xff);
+			cp[2] = (unsigned char) ((cb += cp[2]) & 0xff);
+			cp[3] = (unsigned char) ((ca += cp[3]) & 0xff);
 			cc -= 4;
 			cp += 4;
-			while (cc>0) {
-				cp[0] = (unsigned char) ((cr += cp[0]) & 0xff);
-				cp[1] = (unsigned char) ((cg += cp[1]) & 0xff);
-				cp[2] = (unsigned char) ((cb += cp[2]) & 0xff);
-				cp[3] = (unsigned char) ((ca += cp[3]) & 0xff);
-				cc -= 4;
-				cp += 4;
-			}
-		} else  {
-			cc -= stride;
-			do {
-				REPEAT4(stride, cp[stride] =
-					(unsigned char) ((cp[stride] + *cp) & 0xff); cp++)
-				cc -= stride;
-			} while (cc>0);
 		}
+	} else  {
+		cc -= stride;
+		do {
+			REPEAT4(stride, cp[stride] =
+				(unsigned char) ((cp[stride] + *cp) & 0xff); cp++)
+			cc -= stride;
+		} while (cc>0);
 	}
 }
 
+static void
+horAcc8(TIFF* tif, uint8* cp0, tmsize_t cc)
+{
+	tmsize_t stride = PredictorState(tif)->stride;
+
+	unsigned char* cp = (unsigned char*) cp0;
+	assert((cc%stride)==0);
+	if (cc > stride)
+		accumulate8(cp, cc, stride);
+}
+
 static void
 swabHorAcc16(TIFF* tif, uint8* cp0, tmsize_t cc)
 {
@@ -334,6 +484,16 @@ horAcc16(TIFF* tif, uint8* cp0, tmsize_t cc)
 	assert((cc%(2*stride))==0);
 
 	if (wc > stride) {
+#ifdef USE_SSE2
+		if (PREDICT_SSE2_PERIOD_OK(2 * stride)) {
+			tmsize_t i = horAcc16SSE2(wp, wc, stride);
+			if (i < stride)
+				i = stride;
+			for (; i < wc; i++)
+				wp[i] = (uint16)(((unsigned int)wp[i] + (unsigned int)wp[i - stride]) & 0xffff);
+			return;
+		}
+#endif
 		wc -= stride;
 		do {
 			REPEAT4(stride, wp[stride] = (uint16)(((unsigned int)wp[stride] + (unsigned int)wp[0]) & 0xffff); wp++)
@@ -362,6 +522,16 @@ horAcc32(TIFF* tif, uint8* cp0, tmsize_t cc)
 	assert((cc%(4*stride))==0);
 
 	if (wc > stride) {
+#ifdef USE_SSE2
+		if (PREDICT_SSE2_PERIOD_OK(4 * stride)) {
+			tmsize_t i = horAcc32SSE2(wp, wc, stride);
+			if (i < stride)
+				i = stride;
+			for (; i < wc; i++)
+				wp[i] += wp[i - stride];
+			return;
+		}
+#endif
 		wc -= stride;
 		do {
 			REPEAT4(stride, wp[stride] += wp[0]; wp++)
@@ -379,7 +549,7 @@ fpAcc(TIFF* tif, uint8* cp0, tmsize_t cc)
 	tmsize_t stride = PredictorState(tif)->stride;
 	uint32 bps = tif->tif_dir.td_bitspersample / 8;
 	tmsize_t wc = cc / bps;
-	tmsize_t count = cc;
+	tmsize_t count = 0;
 	uint8 *cp = (uint8 *) cp0;
 	uint8 *tmp = (uint8 *)_TIFFmalloc(cc);
 
@@ -388,23 +558,34 @@ fpAcc(TIFF* tif, uint8* cp0, tmsize_t cc)
 	if (!tmp)
 		return;
 
-	while (count > stride) {
-		REPEAT4(stride, cp[stride] =
-                        (unsigned char) ((cp[stride] + cp[0]) & 0xff); cp++)
-		count -= stride;
-	}
+	if (cc > stride)
+		accumulate8(cp, cc, stride);
 
 	_TIFFmemcpy(tmp, cp0, cc);
-	cp = (uint8 *) cp0;
-	for (count = 0; count < wc; count++) {
+#ifdef USE_SSE2
+	/*
+	 * Interleave the byte planes 16 samples at a time.
+	 */
+	if (bps == 2 || bps == 4 || bps == 8) {
+		__m128i v[8];
+		const int nrounds = (bps == 2) ? 1 : (bps == 4) ? 2 : 3;
+		for (; count + 16 <= wc; count += 16) {
+			uint32 byte;
+			for (byte = 0; byte < bps; byte++)
+				v[byte] = _mm_loadu_si128((const __m128i*)
+				    (tmp + FP_PLANE(byte, bps) * wc + count));
+			fpShuffleSSE2(v, bps, nrounds);
+			for (byte = 0; byte < bps; byte++)
+				_mm_storeu_si128((__m128i*)
+				    (cp + bps * count + 16 * byte), v[byte]);
+		}
+	}
+#endif
+	for (; count < wc; count++) {
 		uint32 byte;
 		for (byte = 0; byte < bps; byte++) {
-			#if WORDS_BIGENDIAN
-			cp[bps * count + byte] = tmp[byte * wc + count];
-			#else
 			cp[bps * count + byte] =
-				tmp[(bps - byte - 1) * wc + count];
-			#endif
+				tmp[FP_PLANE(byte, bps) * wc + count];
 		}
 	}
 	_TIFFfree(tmp);
@@ -459,6 +640,19 @@ PredictorDecodeTile(TIFF* tif, uint8* op0, tmsize_t occ0, uint16 s)
 		return 0;
 }
 
+static void
+differentiate8(unsigned char* cp, tmsize_t cc, tmsize_t stride)
+{
+	tmsize_t i = cc;
+#ifdef USE_SSE2
+	i = horDiff8SSE2(cp, cc, stride);
+#endif
+	while (i > stride) {
+		i--;
+		cp[i] = (unsigned char)((cp[i] - cp[i - stride])&0xff);
+	}
+}
+
 static void
 horDiff8(TIFF* tif, uint8* cp0, tmsize_t cc)
 {
@@ -468,42 +662,8 @@ horDiff8(TIFF* tif, uint8* cp0, tmsize_t cc)
 
 	assert((cc%stride)==0);
 
-	if (cc > stride) {
-		cc -= stride;
-		/*
-		 * Pipeline the most common cases.
-		 */
-		if (stride == 3) {
-			unsigned int r1, g1, b1;
-			unsigned int r2 = cp[0];
-			unsigned int g2 = cp[1];
-			unsigned  int b2 = cp[2];
-			do {
-				r1 = cp[3]; cp[3] = (unsigned char)((r1-r2)&0xff); r2 = r1;
-				g1 = cp[4]; cp[4] = (unsigned char)((g1-g2)&0xff); g2 = g1;
-				b1 = cp[5]; cp[5] = (unsigned char)((b1-b2)&0xff); b2 = b1;
-				cp += 3;
-			} while ((cc -= 3) > 0);
-		} else if (stride == 4) {
-			unsigned int r1, g1, b1, a1;
-			unsigned int r2 = cp[0];
-			unsigned int g2 = cp[1];
-			unsigned int b2 = cp[2];
-			unsigned int a2 = cp[3];
-			do {
-				r1 = cp[4]; cp[4] = (unsigned char)((r1-r2)&0xff); r2 = r1;
-				g1 = cp[5]; cp[5] = (unsigned char)((g1-g2)&0xff); g2 = g1;
-				b1 = cp[6]; cp[6] = (unsigned char)((b1-b2)&0xff); b2 = b1;
-				a1 = cp[7]; cp[7] = (unsigned char)((a1-a2)&0xff); a2 = a1;
-				cp += 4;
-			} while ((cc -= 4) > 0);
-		} else {
-			cp += cc - 1;
-			do {
-				REPEAT4(stride, cp[stride] = (unsigned char)((cp[stride] - cp[0])&0xff); cp--)
-			} while ((cc -= stride) > 0);
-		}
-	}
+	if (cc > stride)
+		differentiate8(cp, cc, stride);
 }
 
 static void
@@ -517,12 +677,14 @@ horDiff16(TIFF* tif, uint8* cp0, tmsize_t cc)
 	assert((cc%(2*stride))==0);
 
 	if (wc > stride) {
-		wc -= stride;
-		wp += wc - 1;
-		do {
-			REPEAT4(stride, wp[stride] = (uint16)(((unsigned int)wp[stride] - (unsigned int)wp[0]) & 0xffff); wp--)
-			wc -= stride;
-		} while (wc > 0);
+		tmsize_t i = wc;
+#ifdef USE_SSE2
+		i = horDiff16SSE2(wp, wc, stride);
+#endif
+		while (i > stride) {
+			i--;
+			wp[i] = (uint16)(((unsigned int)wp[i] - (unsigned int)wp[i - stride]) & 0xffff);
+		}
 	}
 }
 
@@ -548,12 +710,14 @@ horDiff32(TIFF* tif, uint8* cp0, tmsize_t cc)
 	assert((cc%(4*stride))==0);
 
 	if (wc > stride) {
-		wc -= stride;
-		wp += wc - 1;
-		do {
-			REPEAT4(stride, wp[stride] -= wp[0]; wp--)
-			wc -= stride;
-		} while (wc > 0);
+		tmsize_t i = wc;
+#ifdef USE_SSE2
+		i = horDiff32SSE2(wp, wc, stride);
+#endif
+		while (i > stride) {
+			i--;
+			wp[i] -= wp[i - stride];
+		}
 	}
 }
 
@@ -577,7 +741,7 @@ fpDiff(TIFF* tif, uint8* cp0, tmsize_t cc)
 	tmsize_t stride = PredictorState(tif)->stride;
 	uint32 bps = tif->tif_dir.td_bitspersample / 8;
 	tmsize_t wc = cc / bps;
-	tmsize_t count;
+	tmsize_t count = 0;
 	uint8 *cp = (uint8 *) cp0;
 	uint8 *tmp = (uint8 *)_TIFFmalloc(cc);
 
@@ -587,23 +751,36 @@ fpDiff(TIFF* tif, uint8* cp0, tmsize_t cc)
 		return;
 
 	_TIFFmemcpy(tmp, cp0, cc);
-	for (count = 0; count < wc; count++) {
+#ifdef USE_SSE2
+	/*
+	 * Split the samples into byte planes 16 samples at a time.
+	 */
+	if (bps == 2 || bps == 4 || bps == 8) {
+		__m128i v[8];
+		for (; count + 16 <= wc; count += 16) {
+			uint32 byte;
+			for (byte = 0; byte < bps; byte++)
+				v[byte] = _mm_loadu_si128((const __m128i*)
+				    (tmp + bps * count + 16 * byte));
+			fpShuffleSSE2(v, bps, 4);
+			for (byte = 0; byte < bps; byte++)
+				_mm_storeu_si128((__m128i*)
+				    (cp + FP_PLANE(byte, bps) * wc + count),
+				    v[byte]);
+		}
+	}
+#endif
+	for (; count < wc; count++) {
 		uint32 byte;
 		for (byte = 0; byte < bps; byte++) {
-			#if WORDS_BIGENDIAN
-			cp[byte * wc + count] = tmp[bps * count + byte];
-			#else
-			cp[(bps - byte - 1) * wc + count] =
+			cp[FP_PLANE(byte, bps) * wc + count] =
 				tmp[bps * count + byte];
-			#endif
 		}
 	}
 	_TIFFfree(tmp);
 
-	cp = (uint8 *) cp0;
-	cp += cc - stride - 1;
-	for (count = cc; count > stride; count -= stride)
-		REPEAT4(stride, cp[stride] = (unsigned char)((cp[stride] - cp[0])&0xff); cp--)
+	if (cc > stride)
+		differentiate8(cp, cc, stride);
 }
 
 static int
@@ -64,12 +64,38 @@ typedef struct
     vsi_l_offset nExpectedPos;
     GByte      *abyWriteBuffer;
     int         nWriteBufferSize;
+
+    // For pre-fetched raw blocks (not owned by the handle)
+    int         nCachedRanges;
+    void      **ppCachedData;
+    const vsi_l_offset *panCachedOffsets;
+    const size_t *panCachedSizes;
 } GDALTiffHandle;
 
 static tsize_t
 _tiffReadProc(thandle_t th, tdata_t buf, tsize_t size)
 {
     GDALTiffHandle* psGTH = (GDALTiffHandle*) th;
+    if( psGTH->nCachedRanges )
+    {
+        // Serve the read from a pre-fetched range if it fits entirely in it
+        const vsi_l_offset nCurOffset = VSIFTellL( psGTH->fpL );
+        for( int i = 0; i < psGTH->nCachedRanges; i++ )
+        {
+            if( nCurOffset >= psGTH->panCachedOffsets[i] &&
+                nCurOffset + size <= psGTH->panCachedOffsets[i] +
+                                                psGTH->panCachedSizes[i] )
+            {
+                memcpy( buf,
+                        static_cast<GByte*>(psGTH->ppCachedData[i]) +
+                            (nCurOffset - psGTH->panCachedOffsets[i]),
+                        size );
+                if( VSIFSeekL( psGTH->fpL, nCurOffset + size, SEEK_SET ) != 0 )
+                    return 0;
+                return size;
+            }
+        }
+    }
     return VSIFReadL( buf, 1, size, psGTH->fpL );
 }
 
@@ -227,6 +253,18 @@ VSILFILE* VSI_TIFFGetVSILFile(thandle_t th)
     return psGTH->fpL;
 }
 
+void VSI_TIFFSetCachedRanges( thandle_t th, int nRanges,
+                              void ** ppData,
+                              const vsi_l_offset* panOffsets,
+                              const size_t* panSizes )
+{
+    GDALTiffHandle* psGTH = reinterpret_cast<GDALTiffHandle*>( th );
+    psGTH->nCachedRanges = nRanges;
+    psGTH->ppCachedData = ppData;
+    psGTH->panCachedOffsets = panOffsets;
+    psGTH->panCachedSizes = panSizes;
+}
+
 int VSI_TIFFFlushBufferedWrite(thandle_t th)
 {
     GDALTiffHandle* psGTH = reinterpret_cast<GDALTiffHandle*>( th );
@@ -278,6 +316,10 @@ TIFF* VSI_TIFFOpen( const char* name, const char* mode,
     psGTH->abyWriteBuffer =
         bAllocBuffer ? static_cast<GByte *>( VSIMalloc(BUFFER_SIZE) ) : NULL;
     psGTH->nWriteBufferSize = 0;
+    psGTH->nCachedRanges = 0;
+    psGTH->ppCachedData = NULL;
+    psGTH->panCachedOffsets = NULL;
+    psGTH->panCachedSizes = NULL;
 
     TIFF *tif =
         XTIFFClientOpen( name, mode,
@@ -38,5 +38,11 @@
 TIFF* VSI_TIFFOpen( const char* name, const char* mode, VSILFILE* fp );
 VSILFILE* VSI_TIFFGetVSILFile( thandle_t th );
 int VSI_TIFFFlushBufferedWrite( thandle_t th );
+// Memory pointed by ppData[i] and the arrays must be kept alive by the caller
+// until the ranges are unset (nRanges = 0).
+void VSI_TIFFSetCachedRanges( thandle_t th, int nRanges,
+                              void ** ppData,
+                              const vsi_l_offset* panOffsets,
+                              const size_t* panSizes );
 
 #endif // TIFVSI_H_INCLUDED
@@ -29,11 +29,337 @@
  ****************************************************************************/
 
 #include "cpl_string.h"
+#include "cpl_worker_thread_pool.h"
 #include "gdal_frmts.h"
 #include "memdataset.h"
 
+#include <algorithm>
+#include <vector>
+
+#if defined(__linux)
+#include <sys/mman.h>
+#endif
+
 CPL_CVSID("$Id$");
 
+// Alignment of the buffers allocated by the driver, so that SIMD code can
+// use aligned loads and a row of pixels does not needlessly straddle cache
+// lines.
+static const size_t MEM_ALIGNMENT = 64;
+
+// Alignment used when huge pages are requested.
+static const size_t MEM_HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+// Minimum number of words copied by a job, to keep the threading overhead
+// negligible.
+static const int MEM_MIN_WORDS_PER_JOB = 65536;
+
+// Worker threads shared by all the datasets of the driver, created on the
+// first copy big enough to be split.
+static CPLMutex *hMEMThreadPoolMutex = NULL;
+static CPLWorkerThreadPool *poMEMThreadPool = NULL;
+
+/************************************************************************/
+/*                         MEMAllocateAligned()                         */
+/*                                                                      */
+/*      Allocate zero-initialized memory, aligned on MEM_ALIGNMENT      */
+/*      bytes, or on huge page boundaries if bHugePages is set, in      */
+/*      which case the kernel is also advised to back it with           */
+/*      (transparent) huge pages on Linux. Must be freed with           */
+/*      MEMFreeAligned().                                               */
+/************************************************************************/
+
+static GByte *MEMAllocateAligned( size_t nSize, bool bHugePages )
+{
+    const size_t nAlignment =
+        ( bHugePages && nSize >= MEM_HUGE_PAGE_SIZE ) ? MEM_HUGE_PAGE_SIZE
+                                                      : MEM_ALIGNMENT;
+    if( nSize > ~static_cast<size_t>(0) - nAlignment - sizeof(void*) )
+    {
+        CPLError( CE_Failure, CPLE_OutOfMemory,
+                  "Cannot allocate " CPL_FRMT_GUIB " bytes",
+                  static_cast<GUIntBig>(nSize) );
+        return NULL;
+    }
+
+    // Calloc() rather than malloc() + memset(), so that the pages of big
+    // allocations are only materialized when first accessed.
+    GByte *pabyBase = static_cast<GByte *>(
+        VSI_CALLOC_VERBOSE( 1, nSize + nAlignment + sizeof(void*) ) );
+    if( pabyBase == NULL )
+        return NULL;
+
+    GByte *pabyAligned = reinterpret_cast<GByte *>(
+        ( reinterpret_cast<size_t>(pabyBase) + sizeof(void*) +
+          nAlignment - 1 ) & ~(nAlignment - 1) );
+    reinterpret_cast<void **>(pabyAligned)[-1] = pabyBase;
+
+#if defined(__linux) && defined(MADV_HUGEPAGE)
+    if( nAlignment == MEM_HUGE_PAGE_SIZE &&
+        madvise( pabyAligned, nSize, MADV_HUGEPAGE ) != 0 )
+    {
+        CPLDebug( "MEM", "madvise(MADV_HUGEPAGE) failed" );
+    }
+#endif
+
+    return pabyAligned;
+}
+
+/************************************************************************/
+/*                           MEMFreeAligned()                           */
+/************************************************************************/
+
+static void MEMFreeAligned( void *pData )
+{
+    if( pData != NULL )
+        VSIFree( reinterpret_cast<void **>(pData)[-1] );
+}
+
+/************************************************************************/
+/*                              MEMCopyJob                              */
+/*                                                                      */
+/*      Copy, with data type conversion, of a range of lines between    */
+/*      the memory of a band and a RasterIO() buffer.                   */
+/************************************************************************/
+
+struct MEMCopyJob
+{
+    GDALRWFlag      eRWFlag;
+
+    // Start of the window in the band memory, or start of the band memory
+    // for nearest neighbour resampling.
+    GByte          *pabyMem;
+    GDALDataType    eMemType;
+    int             nMemPixelOffset;
+    GSpacing        nMemLineOffset;
+
+    GByte          *pabyBuf;
+    GDALDataType    eBufType;
+    int             nBufPixelSpace;
+    GSpacing        nBufLineSpace;
+
+    // Number of words per line, and range of buffer lines to process.
+    int             nWords;
+    int             iStartLine;
+    int             iEndLine;
+
+    // For nearest neighbour resampling, source line and byte offset in the
+    // source line of each buffer line and column. NULL otherwise.
+    const int      *panSrcLine;
+    const GPtrDiff_t *panSrcOffset;
+
+    bool            bOK;
+
+    // Completion of the jobs of a copy, which cannot wait for the whole
+    // thread pool since other copies may use it at the same time.
+    CPLMutex       *hMutex;
+    CPLCond        *hCond;
+    int            *pnRemainingJobs;
+};
+
+/************************************************************************/
+/*                            MEMCopyLines()                            */
+/************************************************************************/
+
+static void MEMCopyLines( void *pData )
+{
+    MEMCopyJob *psJob = static_cast<MEMCopyJob *>(pData);
+
+    if( psJob->panSrcLine == NULL )
+    {
+        for( int iLine = psJob->iStartLine; iLine < psJob->iEndLine; iLine++ )
+        {
+            GByte *pabyMemLine =
+                psJob->pabyMem + psJob->nMemLineOffset * iLine;
+            GByte *pabyBufLine =
+                psJob->pabyBuf + psJob->nBufLineSpace * iLine;
+            if( psJob->eRWFlag == GF_Read )
+                GDALCopyWords( pabyMemLine, psJob->eMemType,
+                               psJob->nMemPixelOffset,
+                               pabyBufLine, psJob->eBufType,
+                               psJob->nBufPixelSpace,
+                               psJob->nWords );
+            else
+                GDALCopyWords( pabyBufLine, psJob->eBufType,
+                               psJob->nBufPixelSpace,
+                               pabyMemLine, psJob->eMemType,
+                               psJob->nMemPixelOffset,
+                               psJob->nWords );
+        }
+        return;
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Nearest neighbour: gather the source pixels of each line in a   */
+/*      temporary line, and then convert it in one go.                  */
+/* -------------------------------------------------------------------- */
+    const int nWordSize = GDALGetDataTypeSizeBytes( psJob->eMemType );
+    GByte *pabyLine = static_cast<GByte *>(
+        VSI_MALLOC2_VERBOSE( nWordSize, psJob->nWords ) );
+    if( pabyLine == NULL )
+    {
+        psJob->bOK = false;
+        return;
+    }
+
+    for( int iLine = psJob->iStartLine; iLine < psJob->iEndLine; iLine++ )
+    {
+        const GByte *pabySrcLine =
+            psJob->pabyMem + psJob->nMemLineOffset * psJob->panSrcLine[iLine];
+        if( nWordSize == 1 )
+        {
+            for( int i = 0; i < psJob->nWords; i++ )
+                pabyLine[i] = pabySrcLine[psJob->panSrcOffset[i]];
+        }
+        else
+        {
+            for( int i = 0; i < psJob->nWords; i++ )
+                memcpy( pabyLine + i * nWordSize,
+                        pabySrcLine + psJob->panSrcOffset[i], nWordSize );
+        }
+        GDALCopyWords( pabyLine, psJob->eMemType, nWordSize,
+                       psJob->pabyBuf + psJob->nBufLineSpace * iLine,
+                       psJob->eBufType, psJob->nBufPixelSpace,
+                       psJob->nWords );
+    }
+
+    VSIFree( pabyLine );
+}
+
+/************************************************************************/
+/*                          MEMCopyLinesJob()                           */
+/************************************************************************/
+
+static void MEMCopyLinesJob( void *pData )
+{
+    MEMCopyJob *psJob = static_cast<MEMCopyJob *>(pData);
+
+    MEMCopyLines( psJob );
+
+    CPLAcquireMutex( psJob->hMutex, 1000.0 );
+    if( --(*psJob->pnRemainingJobs) == 0 )
+        CPLCondBroadcast( psJob->hCond );
+    CPLReleaseMutex( psJob->hMutex );
+}
+
+/************************************************************************/
+/*                          MEMGetThreadPool()                          */
+/*                                                                      */
+/*      Return the worker threads shared by all datasets, creating      */
+/*      them on first use with at least nThreads threads.               */
+/************************************************************************/
+
+static CPLWorkerThreadPool *MEMGetThreadPool( int nThreads )
+{
+    CPLMutexHolderD( &hMEMThreadPoolMutex );
+    if( poMEMThreadPool == NULL )
+    {
+        // Later requests for more threads than the pool has are served by
+        // the existing threads, so do not create less than there are CPUs.
+        const int nPoolThreads = std::max( nThreads,
+            CPLParseNumThreads( "ALL_CPUS" ) );
+        CPLDebug( "MEM", "Using a pool of %d threads", nPoolThreads );
+        poMEMThreadPool = new CPLWorkerThreadPool();
+        if( !poMEMThreadPool->Setup( nPoolThreads, NULL, NULL ) )
+        {
+            delete poMEMThreadPool;
+            poMEMThreadPool = NULL;
+        }
+    }
+    return poMEMThreadPool;
+}
+
+/************************************************************************/
+/*                           MEMRunCopyJobs()                           */
+/*                                                                      */
+/*      Split the copy of nLines lines between the worker threads,      */
+/*      if the dataset allows several threads and the copy is big       */
+/*      enough.                                                         */
+/************************************************************************/
+
+static CPLErr MEMRunCopyJobs( GDALDataset *poDS,
+                              const MEMCopyJob &sJobTemplate, int nLines )
+{
+    int nJobs = 1;
+    CPLWorkerThreadPool *poThreadPool = NULL;
+    const GIntBig nTotalWords =
+        static_cast<GIntBig>(sJobTemplate.nWords) * nLines;
+    // Small copies, which are the most frequent ones, are done right away
+    // without looking for the threads.
+    if( nLines > 1 && nTotalWords >= 2 * MEM_MIN_WORDS_PER_JOB )
+    {
+        MEMDataset *poMEMDS = dynamic_cast<MEMDataset *>(poDS);
+        const int nThreads = poMEMDS != NULL ? poMEMDS->GetNumThreads() : 1;
+        if( nThreads > 1 )
+            poThreadPool = MEMGetThreadPool( nThreads );
+        if( poThreadPool != NULL )
+        {
+            const GIntBig nMaxJobs =
+                std::min( static_cast<GIntBig>(nLines),
+                          nTotalWords / MEM_MIN_WORDS_PER_JOB );
+            nJobs = static_cast<int>(
+                std::min( static_cast<GIntBig>(
+                              std::min( nThreads,
+                                        poThreadPool->GetThreadCount() ) ),
+                          nMaxJobs ) );
+        }
+    }
+
+    std::vector<MEMCopyJob> asJobs( nJobs, sJobTemplate );
+    for( int i = 0; i < nJobs; i++ )
+    {
+        asJobs[i].iStartLine =
+            static_cast<int>( static_cast<GIntBig>(nLines) * i / nJobs );
+        asJobs[i].iEndLine =
+            static_cast<int>( static_cast<GIntBig>(nLines) * (i + 1) / nJobs );
+        asJobs[i].bOK = true;
+    }
+
+    bool bDone = false;
+    if( nJobs > 1 )
+    {
+        CPLMutex *hMutex = CPLCreateMutex();
+        CPLReleaseMutex( hMutex );
+        CPLCond *hCond = CPLCreateCond();
+        int nRemainingJobs = nJobs;
+
+        std::vector<void*> apJobs;
+        for( int i = 0; i < nJobs; i++ )
+        {
+            asJobs[i].hMutex = hMutex;
+            asJobs[i].hCond = hCond;
+            asJobs[i].pnRemainingJobs = &nRemainingJobs;
+            apJobs.push_back( &asJobs[i] );
+        }
+
+        // On failure, no job has been queued, and they are run below.
+        if( poThreadPool->SubmitJobs( MEMCopyLinesJob, apJobs ) )
+        {
+            CPLAcquireMutex( hMutex, 1000.0 );
+            while( nRemainingJobs > 0 )
+                CPLCondWait( hCond, hMutex );
+            CPLReleaseMutex( hMutex );
+            bDone = true;
+        }
+
+        CPLDestroyCond( hCond );
+        CPLDestroyMutex( hMutex );
+    }
+
+    if( !bDone )
+    {
+        for( int i = 0; i < nJobs; i++ )
+            MEMCopyLines( &asJobs[i] );
+    }
+
+    for( int i = 0; i < nJobs; i++ )
+    {
+        if( !asJobs[i].bOK )
+            return CE_Failure;
+    }
+    return CE_None;
+}
+
 /************************************************************************/
 /*                        MEMCreateRasterBand()                         */
 /************************************************************************/
@@ -77,6 +403,7 @@ MEMRasterBand::MEMRasterBand( GDALDataset *poDSIn, int nBandIn,
     pabyData(pabyDataIn),
     // Skip nPixelOffset and nLineOffset.
     bOwnData(bAssumeOwnership),
+    bOwnDataAligned(false),
     bNoDataSet(FALSE),
     dfNoData(0.0),
     poColorTable(NULL),
@@ -120,7 +447,10 @@ MEMRasterBand::~MEMRasterBand()
 {
     if( bOwnData )
     {
-        VSIFree( pabyData );
+        if( bOwnDataAligned )
+            MEMFreeAligned( pabyData );
+        else
+            VSIFree( pabyData );
     }
 
     if( poColorTable != NULL )
@@ -215,6 +545,20 @@ CPLErr MEMRasterBand::IRasterIO( GDALRWFlag eRWFlag,
 {
     if( nXSize != nBufXSize || nYSize != nBufYSize )
     {
+        // Nearest neighbour reads can be done directly from our buffer,
+        // unless overviews may be used (or skipped, see
+        // GDAL_NO_COSTLY_OVERVIEW) by the generic implementation.
+        if( eRWFlag == GF_Read &&
+            psExtraArg->eResampleAlg == GRIORA_NearestNeighbour &&
+            !(nBufXSize < nXSize / 100 && nBufYSize < nYSize / 100) &&
+            GetOverviewCount() == 0 )
+        {
+            return NearestRasterIO( nXOff, nYOff, nXSize, nYSize,
+                                    pData, nBufXSize, nBufYSize, eBufType,
+                                    nPixelSpaceBuf, nLineSpaceBuf,
+                                    psExtraArg );
+        }
+
         return GDALRasterBand::IRasterIO(eRWFlag, nXOff, nYOff, nXSize, nYSize,
                                          pData, nBufXSize, nBufYSize,
                                          eBufType,
@@ -226,39 +570,118 @@ CPLErr MEMRasterBand::IRasterIO( GDALRWFlag eRWFlag,
     // In case block based I/O has been done before.
     FlushCache();
 
-    if( eRWFlag == GF_Read )
+    MEMCopyJob sJob;
+    sJob.eRWFlag = eRWFlag;
+    sJob.pabyMem = pabyData + nLineOffset * static_cast<size_t>(nYOff) +
+                   nXOff * nPixelOffset;
+    sJob.eMemType = eDataType;
+    sJob.nMemPixelOffset = static_cast<int>(nPixelOffset);
+    sJob.nMemLineOffset = nLineOffset;
+    sJob.pabyBuf = static_cast<GByte *>(pData);
+    sJob.eBufType = eBufType;
+    sJob.nBufPixelSpace = static_cast<int>(nPixelSpaceBuf);
+    sJob.nBufLineSpace = nLineSpaceBuf;
+    sJob.nWords = nXSize;
+    sJob.iStartLine = 0;
+    sJob.iEndLine = 0;
+    sJob.panSrcLine = NULL;
+    sJob.panSrcOffset = NULL;
+    sJob.bOK = true;
+
+    return MEMRunCopyJobs( poDS, sJob, nYSize );
+}
+
+/************************************************************************/
+/*                          NearestRasterIO()                           */
+/*                                                                      */
+/*      Read with nearest neighbour resampling. The source pixel of     */
+/*      each buffer pixel is computed exactly as in                     */
+/*      GDALRasterBand::IRasterIO(), so that the result is the same.    */
+/************************************************************************/
+
+CPLErr MEMRasterBand::NearestRasterIO( int nXOff, int nYOff,
+                                       int nXSize, int nYSize,
+                                       void * pData,
+                                       int nBufXSize, int nBufYSize,
+                                       GDALDataType eBufType,
+                                       GSpacing nPixelSpaceBuf,
+                                       GSpacing nLineSpaceBuf,
+                                       GDALRasterIOExtraArg* psExtraArg )
+{
+    double dfXOff = nXOff;
+    double dfYOff = nYOff;
+    double dfXSize = nXSize;
+    double dfYSize = nYSize;
+    if( psExtraArg->bFloatingPointWindowValidity )
     {
-        for( int iLine=0; iLine < nYSize; iLine++ )
-        {
-            GDALCopyWords(
-                pabyData + nLineOffset*static_cast<size_t>(iLine + nYOff) +
-                nXOff*nPixelOffset,
-                eDataType,
-                static_cast<int>(nPixelOffset),
-                reinterpret_cast<GByte*>( pData ) +
-                nLineSpaceBuf * static_cast<size_t>(iLine),
-                eBufType,
-                static_cast<int>(nPixelSpaceBuf),
-                nXSize );
-        }
+        dfXOff = psExtraArg->dfXOff;
+        dfYOff = psExtraArg->dfYOff;
+        dfXSize = psExtraArg->dfXSize;
+        dfYSize = psExtraArg->dfYSize;
     }
-    else
+
+    const double dfSrcXInc = dfXSize / static_cast<double>( nBufXSize );
+    const double dfSrcYInc = dfYSize / static_cast<double>( nBufYSize );
+
+    GPtrDiff_t *panSrcOffset = static_cast<GPtrDiff_t *>(
+        VSI_MALLOC2_VERBOSE( sizeof(GPtrDiff_t), nBufXSize ) );
+    int *panSrcLine = static_cast<int *>(
+        VSI_MALLOC2_VERBOSE( sizeof(int), nBufYSize ) );
+    if( panSrcOffset == NULL || panSrcLine == NULL )
     {
-        for( int iLine = 0; iLine < nYSize; iLine++ )
-        {
-            GDALCopyWords(
-                reinterpret_cast<GByte *>( pData ) +
-                nLineSpaceBuf*(size_t)iLine,
-                eBufType,
-                static_cast<int>(nPixelSpaceBuf),
-                pabyData + nLineOffset*static_cast<size_t>(iLine + nYOff) +
-                nXOff*nPixelOffset,
-                eDataType,
-                static_cast<int>(nPixelOffset),
-                nXSize );
-        }
+        VSIFree( panSrcOffset );
+        VSIFree( panSrcLine );
+        return CE_Failure;
     }
-    return CE_None;
+
+    // Same incremental computation as in GDALRasterBand::IRasterIO().
+    double dfSrcX = 0.5 * dfSrcXInc + dfXOff;
+    for( int iBufXOff = 0; iBufXOff < nBufXSize;
+         iBufXOff++, dfSrcX += dfSrcXInc )
+    {
+        const int iSrcX = std::min( static_cast<int>(dfSrcX),
+                                    nRasterXSize - 1 );
+        panSrcOffset[iBufXOff] = static_cast<GPtrDiff_t>(iSrcX) * nPixelOffset;
+    }
+    for( int iBufYOff = 0; iBufYOff < nBufYSize; iBufYOff++ )
+    {
+        const double dfSrcY = (iBufYOff+0.5) * dfSrcYInc + dfYOff;
+        panSrcLine[iBufYOff] = std::min( static_cast<int>(dfSrcY),
+                                         nRasterYSize - 1 );
+    }
+
+    // In case block based I/O has been done before.
+    FlushCache();
+
+    MEMCopyJob sJob;
+    sJob.eRWFlag = GF_Read;
+    sJob.pabyMem = pabyData;
+    sJob.eMemType = eDataType;
+    sJob.nMemPixelOffset = static_cast<int>(nPixelOffset);
+    sJob.nMemLineOffset = nLineOffset;
+    sJob.pabyBuf = static_cast<GByte *>(pData);
+    sJob.eBufType = eBufType;
+    sJob.nBufPixelSpace = static_cast<int>(nPixelSpaceBuf);
+    sJob.nBufLineSpace = nLineSpaceBuf;
+    sJob.nWords = nBufXSize;
+    sJob.iStartLine = 0;
+    sJob.iEndLine = 0;
+    sJob.panSrcLine = panSrcLine;
+    sJob.panSrcOffset = panSrcOffset;
+    sJob.bOK = true;
+
+    CPLErr eErr = MEMRunCopyJobs( poDS, sJob, nBufYSize );
+
+    VSIFree( panSrcOffset );
+    VSIFree( panSrcLine );
+
+    if( eErr == CE_None && psExtraArg->pfnProgress != NULL &&
+        !psExtraArg->pfnProgress( 1.0, "", psExtraArg->pProgressData ) )
+    {
+        eErr = CE_Failure;
+    }
+
+    return eErr;
 }
 
 /************************************************************************/
@@ -318,41 +741,27 @@ CPLErr MEMDataset::IRasterIO( GDALRWFlag eRWFlag,
         if( iBandIndex == nBandCount )
         {
             FlushCache();
-            if( eRWFlag == GF_Read )
-            {
-                for(int iLine=0;iLine<nYSize;iLine++)
-                {
-                    GDALCopyWords(
-                        pabyData +
-                        nLineOffset*static_cast<size_t>(iLine + nYOff) +
-                        nXOff*nPixelOffset,
-                        eDT,
-                        eDTSize,
-                        reinterpret_cast<GByte *>( pData ) +
-                        nLineSpaceBuf * static_cast<size_t>(iLine),
-                        eBufType,
-                        eBufTypeSize,
-                        nXSize * nBands );
-                }
-            }
-            else
-            {
-                for(int iLine=0;iLine<nYSize;iLine++)
-                {
-                    GDALCopyWords(
-                        reinterpret_cast<GByte *>( pData ) +
-                        nLineSpaceBuf*(size_t)iLine,
-                        eBufType,
-                        eBufTypeSize,
-                        pabyData +
-                        nLineOffset * static_cast<size_t>(iLine + nYOff) +
-                        nXOff*nPixelOffset,
-                        eDT,
-                        eDTSize,
-                        nXSize * nBands);
-                }
-            }
-            return CE_None;
+
+            MEMCopyJob sJob;
+            sJob.eRWFlag = eRWFlag;
+            sJob.pabyMem = pabyData +
+                           nLineOffset * static_cast<size_t>(nYOff) +
+                           nXOff * nPixelOffset;
+            sJob.eMemType = eDT;
+            sJob.nMemPixelOffset = eDTSize;
+            sJob.nMemLineOffset = nLineOffset;
+            sJob.pabyBuf = static_cast<GByte *>(pData);
+            sJob.eBufType = eBufType;
+            sJob.nBufPixelSpace = eBufTypeSize;
+            sJob.nBufLineSpace = nLineSpaceBuf;
+            sJob.nWords = nXSize * nBands;
+            sJob.iStartLine = 0;
+            sJob.iEndLine = 0;
+            sJob.panSrcLine = NULL;
+            sJob.panSrcOffset = NULL;
+            sJob.bOK = true;
+
+            return MEMRunCopyJobs( this, sJob, nYSize );
         }
     }
 
@@ -693,7 +1102,8 @@ MEMDataset::MEMDataset() :
     bGeoTransformSet(FALSE),
     pszProjection(NULL),
     nGCPCount(0),
-    pasGCPs(NULL)
+    pasGCPs(NULL),
+    bHugePages(false)
 {
     adfGeoTransform[0] = 0.0;
     adfGeoTransform[1] = 1.0;
@@ -717,6 +1127,25 @@ MEMDataset::~MEMDataset()
     CPLFree( pasGCPs );
 }
 
+/************************************************************************/
+/*                           GetNumThreads()                            */
+/************************************************************************/
+
+/** Return the number of threads between which copies between the memory
+ * of the bands and RasterIO() buffers can be split.
+ *
+ * It comes from the NUM_THREADS creation option, or the GDAL_NUM_THREADS
+ * configuration option (a number of threads, or ALL_CPUS), and is 1 if none
+ * is set. The threads themselves are shared by all MEM datasets.
+ */
+int MEMDataset::GetNumThreads() const
+{
+    const char *pszNumThreads =
+        !osNumThreads.empty() ? osNumThreads.c_str()
+                              : CPLGetConfigOption("GDAL_NUM_THREADS", NULL);
+    return CPLParseNumThreads( pszNumThreads );
+}
+
 #if 0
 /************************************************************************/
 /*                          EnterReadWrite()                            */
@@ -897,17 +1326,24 @@ CPLErr MEMDataset::AddBand( GDALDataType eType, char **papszOptions )
             pData = NULL;
         else
 #endif
-            pData = reinterpret_cast<GByte *>(
-                VSI_CALLOC_VERBOSE((size_t)nTmp, GetRasterYSize() ) );
+        if( GetRasterYSize() == 0 ||
+            static_cast<GUIntBig>(nTmp) <=
+                ~static_cast<size_t>(0) / GetRasterYSize() )
+        {
+            pData = MEMAllocateAligned(
+                static_cast<size_t>(nTmp) * GetRasterYSize(), bHugePages );
+        }
 
         if( pData == NULL )
         {
             return CE_Failure;
         }
 
-        SetBand( nBandId,
-                 new MEMRasterBand( this, nBandId, pData, eType, nPixelSize,
-                                    nPixelSize * GetRasterXSize(), TRUE ) );
+        MEMRasterBand *poNewBand =
+            new MEMRasterBand( this, nBandId, pData, eType, nPixelSize,
+                               nPixelSize * GetRasterXSize(), TRUE );
+        poNewBand->bOwnDataAligned = true;
+        SetBand( nBandId, poNewBand );
 
         return CE_None;
     }
@@ -1130,13 +1566,16 @@ GDALDataset *MEMDataset::Create( const char * /* pszFilename */,
     }
 #endif
 
+    const bool bHugePages =
+        CPLFetchBool( const_cast<const char **>(papszOptions), "HUGE_PAGES",
+                      false );
+
     std::vector<GByte*> apbyBandData;
     bool bAllocOK = true;
 
     if( bPixelInterleaved )
     {
-        apbyBandData.push_back(
-            reinterpret_cast<GByte *>( VSI_CALLOC_VERBOSE( 1, nGlobalSize ) ) );
+        apbyBandData.push_back( MEMAllocateAligned( nGlobalSize, bHugePages ) );
 
         if( apbyBandData[0] == NULL )
             bAllocOK = FALSE;
@@ -1151,10 +1590,9 @@ GDALDataset *MEMDataset::Create( const char * /* pszFilename */,
         for( int iBand = 0; iBand < nBands; iBand++ )
         {
             apbyBandData.push_back(
-                reinterpret_cast<GByte *>(
-                    VSI_CALLOC_VERBOSE(
-                        1,
-                        static_cast<size_t>(nWordSize) * nXSize * nYSize ) ) );
+                MEMAllocateAligned(
+                    static_cast<size_t>(nWordSize) * nXSize * nYSize,
+                    bHugePages ) );
             if( apbyBandData[iBand] == NULL )
             {
                 bAllocOK = FALSE;
@@ -1169,8 +1607,8 @@ GDALDataset *MEMDataset::Create( const char * /* pszFilename */,
              iBand < static_cast<int>( apbyBandData.size() );
              iBand++ )
         {
-            if( apbyBandData[iBand] )
-                VSIFree( apbyBandData[iBand] );
+            if( apbyBandData[iBand] && (!bPixelInterleaved || iBand == 0) )
+                MEMFreeAligned( apbyBandData[iBand] );
         }
         return NULL;
     }
@@ -1183,6 +1621,11 @@ GDALDataset *MEMDataset::Create( const char * /* pszFilename */,
     poDS->nRasterXSize = nXSize;
     poDS->nRasterYSize = nYSize;
     poDS->eAccess = GA_Update;
+    poDS->bHugePages = bHugePages;
+
+    const char *pszNumThreads = CSLFetchNameValue( papszOptions, "NUM_THREADS" );
+    if( pszNumThreads != NULL )
+        poDS->osNumThreads = pszNumThreads;
 
     const char *pszPixelType = CSLFetchNameValue( papszOptions, "PIXELTYPE" );
     if( pszPixelType && EQUAL(pszPixelType, "SIGNEDBYTE") )
@@ -1206,6 +1649,7 @@ GDALDataset *MEMDataset::Create( const char * /* pszFilename */,
             poNewBand = new MEMRasterBand( poDS, iBand+1, apbyBandData[iBand],
                                            eType, 0, 0, TRUE );
 
+        poNewBand->bOwnDataAligned = true;
         poDS->SetBand( iBand+1, poNewBand );
     }
 
@@ -1235,6 +1679,19 @@ static CPLErr MEMDatasetDelete( const char* /* fileName */)
     return CE_None;
 }
 
+/************************************************************************/
+/*                          MEMUnloadDriver()                           */
+/************************************************************************/
+
+static void MEMUnloadDriver( GDALDriver * /* poDriver */ )
+{
+    delete poMEMThreadPool;
+    poMEMThreadPool = NULL;
+    if( hMEMThreadPoolMutex != NULL )
+        CPLDestroyMutex( hMEMThreadPoolMutex );
+    hMEMThreadPoolMutex = NULL;
+}
+
 /************************************************************************/
 /*                          GDALRegister_MEM()                          */
 /************************************************************************/
@@ -1260,6 +1717,11 @@ void GDALRegister_MEM()
 "       <Value>BAND</Value>"
 "       <Value>PIXEL</Value>"
 "   </Option>"
+"   <Option name='HUGE_PAGES' type='boolean' default='NO' description="
+"'Whether to advise the system to use huge pages for the band buffers "
+"(Linux only)'/>"
+"   <Option name='NUM_THREADS' type='string' description="
+"'Number of worker threads for RasterIO() copies. Can be set to ALL_CPUS'/>"
 "</CreationOptionList>" );
 
     // Define GDAL_NO_OPEN_FOR_MEM_DRIVER macro to undefine Open() method for
@@ -1273,6 +1735,7 @@ void GDALRegister_MEM()
 #endif
     poDriver->pfnCreate = MEMDataset::Create;
     poDriver->pfnDelete = MEMDatasetDelete;
+    poDriver->pfnUnloadDriver = MEMUnloadDriver;
 
     GetGDALDriverManager()->RegisterDriver( poDriver );
 }
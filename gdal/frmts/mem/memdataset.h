@@ -61,6 +61,10 @@ class CPL_DLL MEMDataset : public GDALDataset
     GDAL_GCP    *pasGCPs;
     CPLString    osGCPProjection;
 
+    bool         bHugePages;
+
+    CPLString    osNumThreads;
+
 #if 0
   protected:
     virtual int                 EnterReadWrite(GDALRWFlag eRWFlag);
@@ -97,6 +101,8 @@ class CPL_DLL MEMDataset : public GDALDataset
                                GSpacing nBandSpaceBuf,
                                GDALRasterIOExtraArg* psExtraArg);
 
+    int          GetNumThreads() const;
+
     static GDALDataset *Open( GDALOpenInfo * );
     static GDALDataset *Create( const char * pszFilename,
                                 int nXSize, int nYSize, int nBands,
@@ -116,6 +122,7 @@ class CPL_DLL MEMRasterBand : public GDALPamRasterBand
     GSpacing    nPixelOffset;
     GSpacing    nLineOffset;
     int         bOwnData;
+    bool        bOwnDataAligned;
 
     int         bNoDataSet;
     double      dfNoData;
@@ -148,6 +155,13 @@ class CPL_DLL MEMRasterBand : public GDALPamRasterBand
                                   GSpacing nPixelSpaceBuf,
                                   GSpacing nLineSpaceBuf,
                                   GDALRasterIOExtraArg* psExtraArg );
+    CPLErr         NearestRasterIO( int nXOff, int nYOff,
+                                    int nXSize, int nYSize,
+                                    void * pData, int nBufXSize, int nBufYSize,
+                                    GDALDataType eBufType,
+                                    GSpacing nPixelSpaceBuf,
+                                    GSpacing nLineSpaceBuf,
+                                    GDALRasterIOExtraArg* psExtraArg );
     virtual double GetNoDataValue( int *pbSuccess = NULL );
     virtual CPLErr SetNoDataValue( double );
     virtual CPLErr DeleteNoDataValue();
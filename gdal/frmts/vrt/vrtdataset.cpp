@@ -32,6 +32,8 @@
 
 #include "cpl_minixml.h"
 #include "cpl_string.h"
+#include "cpl_worker_thread_pool.h"
+#include "gdal_proxy.h"
 #include "ogr_spatialref.h"
 
 #include <algorithm>
@@ -52,7 +54,9 @@ VRTDataset::VRTDataset( int nXSize, int nYSize ) :
     m_bWritable(TRUE),
     m_pszVRTPath(NULL),
     m_poMaskBand(NULL),
-    m_bCompatibleForDatasetIO(-1)
+    m_bCompatibleForDatasetIO(-1),
+    m_poThreadPool(NULL),
+    m_bThreadPoolChecked(false)
 {
     nRasterXSize = nXSize;
     nRasterYSize = nYSize;
@@ -91,6 +95,7 @@ VRTDataset::~VRTDataset()
 
 {
     FlushCache();
+    delete m_poThreadPool;
     CPLFree( m_pszProjection );
 
     CPLFree( m_pszGCPProjection );
@@ -1006,6 +1011,11 @@ CPLErr VRTDataset::AddBand( GDALDataType eType, char **papszOptions )
             if( pszFuncName != NULL )
                 poDerivedBand->SetPixelFunctionName(pszFuncName);
 
+            const char* pszExpression =
+                CSLFetchNameValue(papszOptions, "PixelFunctionExpression");
+            if( pszExpression != NULL )
+                poDerivedBand->SetPixelFunctionExpression(pszExpression);
+
             const char* pszTransferTypeName =
                 CSLFetchNameValue(papszOptions, "SourceTransferType");
             if( pszTransferTypeName != NULL )
@@ -1498,20 +1508,11 @@ CPLErr VRTDataset::IRasterIO( GDALRWFlag eRWFlag,
                 = reinterpret_cast<VRTSourcedRasterBand *>(
                     GetRasterBand( panBandMap[iBandIndex] ) );
 
-            /* Dirty little trick to initialize the buffer without doing */
-            /* any real I/O */
-            const int nSavedSources = poBand->nSources;
-            poBand->nSources = 0;
-
             GByte *pabyBandData
                 = reinterpret_cast<GByte *>( pData ) + iBandIndex * nBandSpace;
 
-            poBand->IRasterIO(GF_Read, nXOff, nYOff, nXSize, nYSize,
-                                pabyBandData, nBufXSize, nBufYSize,
-                                eBufType,
-                                nPixelSpace, nLineSpace, psExtraArg);
-
-            poBand->nSources = nSavedSources;
+            poBand->InitializeOutputBuffer( pabyBandData, nBufXSize, nBufYSize,
+                                            eBufType, nPixelSpace, nLineSpace );
         }
 
         CPLErr eErr = CE_None;
@@ -1520,17 +1521,22 @@ CPLErr VRTDataset::IRasterIO( GDALRWFlag eRWFlag,
 
         // Use the last band, because when sources reference a GDALProxyDataset,
         // they don't necessary instantiate all underlying rasterbands.
+        // With many sources, only consider the ones intersecting the window.
         VRTSourcedRasterBand* poBand = reinterpret_cast<VRTSourcedRasterBand *>(
             papoBands[nBands - 1] );
-        for( int iSource = 0;
-             eErr == CE_None && iSource < poBand->nSources;
-             iSource++ )
+        int nSelected = poBand->nSources;
+        int* panSelected = poBand->GetSourcesInWindow( nXOff, nYOff,
+                                                       nXSize, nYSize,
+                                                       &nSelected );
+        for( int i = 0; eErr == CE_None && i < nSelected; i++ )
         {
+            const int iSource = panSelected ? panSelected[i] : i;
+
             psExtraArg->pfnProgress = GDALScaledProgress;
             psExtraArg->pProgressData =
                 GDALCreateScaledProgress(
-                    1.0 * iSource / poBand->nSources,
-                    1.0 * (iSource + 1) / poBand->nSources,
+                    1.0 * i / nSelected,
+                    1.0 * (i + 1) / nSelected,
                     pfnProgressGlobal,
                     pProgressDataGlobal );
 
@@ -1547,6 +1553,7 @@ CPLErr VRTDataset::IRasterIO( GDALRWFlag eRWFlag,
 
             GDALDestroyScaledProgress( psExtraArg->pProgressData );
         }
+        CPLFree( panSelected );
 
         psExtraArg->pfnProgress = pfnProgressGlobal;
         psExtraArg->pProgressData = pProgressDataGlobal;
@@ -1590,6 +1597,51 @@ void VRTDataset::UnsetPreservedRelativeFilenames()
     }
 }
 
+/************************************************************************/
+/*                           GetThreadPool()                            */
+/************************************************************************/
+
+/** Return the thread pool used to fetch disjoint sources concurrently, and
+ * to evaluate pixel function expressions of derived bands.
+ *
+ * The pool is created on first use, from the value of the VRT_NUM_THREADS
+ * configuration option (a number of threads, or ALL_CPUS), limited to one
+ * less than the size of the dataset pool. NULL is returned if it is not set,
+ * or set to less than 2 threads.
+ */
+CPLWorkerThreadPool* VRTDataset::GetThreadPool()
+{
+    if( m_bThreadPoolChecked )
+        return m_poThreadPool;
+    m_bThreadPoolChecked = true;
+
+    int nThreads =
+        CPLParseNumThreads( CPLGetConfigOption("VRT_NUM_THREADS", NULL) );
+
+    // Each worker keeps a source dataset of the proxy pool referenced while
+    // reading it, and referenced datasets cannot be closed to make room for
+    // others. So leave one entry of the pool to the calling thread.
+    const int nMaxPoolThreads = GDALProxyPoolGetMaxSize() - 1;
+    if( nThreads > nMaxPoolThreads )
+    {
+        CPLDebug( "VRT", "Limiting to %d threads, due to the size of the "
+                  "dataset pool (GDAL_MAX_DATASET_POOL_SIZE)",
+                  nMaxPoolThreads );
+        nThreads = nMaxPoolThreads;
+    }
+    if( nThreads <= 1 )
+        return NULL;
+
+    CPLDebug( "VRT", "Using %d threads", nThreads );
+    m_poThreadPool = new CPLWorkerThreadPool();
+    if( !m_poThreadPool->Setup( nThreads, NULL, NULL ) )
+    {
+        delete m_poThreadPool;
+        m_poThreadPool = NULL;
+    }
+    return m_poThreadPool;
+}
+
 /************************************************************************/
 /*                        BuildVirtualOverviews()                       */
 /************************************************************************/
@@ -32,6 +32,7 @@
 #define VIRTUALDATASET_H_INCLUDED
 
 #include "cpl_hash_set.h"
+#include "cpl_packed_rtree.h"
 #include "gdal_pam.h"
 #include "gdal_priv.h"
 #include "gdal_vrt.h"
@@ -39,6 +40,9 @@
 #include <map>
 #include <vector>
 
+class CPLWorkerThreadPool;
+class VRTExpression;
+
 int VRTApplyMetadata( CPLXMLNode *, GDALMajorObject * );
 CPLXMLNode *VRTSerializeMetadata( GDALMajorObject * );
 
@@ -150,6 +154,9 @@ class CPL_DLL VRTDataset : public GDALDataset
     std::vector<GDALDataset*> m_apoOverviews;
     std::vector<GDALDataset*> m_apoOverviewsBak;
 
+    CPLWorkerThreadPool *m_poThreadPool;
+    bool           m_bThreadPoolChecked;
+
   protected:
     virtual int         CloseDependentDatasets();
 
@@ -208,6 +215,8 @@ class CPL_DLL VRTDataset : public GDALDataset
 
     void                UnsetPreservedRelativeFilenames();
 
+    CPLWorkerThreadPool *GetThreadPool();
+
     static int          Identify( GDALOpenInfo * );
     static GDALDataset *Open( GDALOpenInfo * );
     static GDALDataset *OpenXML( const char *, const char * = NULL,
@@ -235,8 +244,18 @@ class CPL_DLL VRTWarpedDataset : public VRTDataset
     VRTWarpedDataset **m_papoOverviews;
     int               m_nSrcOvrLevel;
 
+    int               m_nReadAheadBlocks;
+    int               m_nLastBlockX;
+    int               m_nLastBlockY;
+
     void              CreateImplicitOverviews();
 
+    bool              IsBlockCached( int iBlockX, int iBlockY );
+    CPLErr            ProcessBlocks( int iBlockX, int iBlockY,
+                                     int nBlocksX, int nBlocksY );
+    CPLErr            ProcessBlockRange( int iXBlockStart, int iYBlockStart,
+                                         int iXBlockEnd, int iYBlockEnd );
+
     friend class VRTWarpedRasterBand;
 
   protected:
@@ -457,12 +476,38 @@ class VRTSimpleSource;
 
 class CPL_DLL VRTSourcedRasterBand : public VRTRasterBand
 {
+    friend class VRTDataset;
+
   private:
     int            m_nRecursionCounter;
     CPLString      m_osLastLocationInfo;
     char         **m_papszSourceList;
 
+    CPLPackedRTree *m_hSourcesIndex;
+    bool           m_bSourcesIndexChecked;
+
     bool           CanUseSourcesMinMaxImplementations();
+    void           InvalidateSourcesIndex();
+    int           *GetSourcesInWindow( int nXOff, int nYOff,
+                                       int nXSize, int nYSize,
+                                       int *pnCount );
+    int           *GetSourcesInBand( int *pnCount );
+    void           InitializeOutputBuffer( void *pData,
+                                           int nBufXSize, int nBufYSize,
+                                           GDALDataType eBufType,
+                                           GSpacing nPixelSpace,
+                                           GSpacing nLineSpace );
+    bool           RasterIOSourcesInParallel( int nSelected,
+                                              const int *panSelected,
+                                              int nXOff, int nYOff,
+                                              int nXSize, int nYSize,
+                                              void *pData,
+                                              int nBufXSize, int nBufYSize,
+                                              GDALDataType eBufType,
+                                              GSpacing nPixelSpace,
+                                              GSpacing nLineSpace,
+                                              GDALRasterIOExtraArg* psExtraArg,
+                                              CPLErr *peErr );
 
   public:
     int            nSources;
@@ -562,6 +607,10 @@ class CPL_DLL VRTSourcedRasterBand : public VRTRasterBand
 
 class CPL_DLL VRTWarpedRasterBand : public VRTRasterBand
 {
+    bool           IsBlockCached( int nBlockXOff, int nBlockYOff );
+
+    friend class VRTWarpedDataset;
+
   public:
                    VRTWarpedRasterBand( GDALDataset *poDS, int nBand,
                                         GDALDataType eType = GDT_Unknown );
@@ -573,6 +622,13 @@ class CPL_DLL VRTWarpedRasterBand : public VRTRasterBand
     virtual CPLErr IReadBlock( int, int, void * );
     virtual CPLErr IWriteBlock( int, int, void * );
 
+    virtual CPLErr  IRasterIO( GDALRWFlag eRWFlag,
+                               int nXOff, int nYOff, int nXSize, int nYSize,
+                               void * pData, int nBufXSize, int nBufYSize,
+                               GDALDataType eBufType,
+                               GSpacing nPixelSpace, GSpacing nLineSpace,
+                               GDALRasterIOExtraArg* psExtraArg );
+
     virtual int GetOverviewCount();
     virtual GDALRasterBand *GetOverview(int);
 };
@@ -619,6 +675,18 @@ class VRTPansharpenedRasterBand : public VRTRasterBand
 
 class CPL_DLL VRTDerivedRasterBand : public VRTSourcedRasterBand
 {
+    CPLString      m_osExpression;
+    VRTExpression *m_poExpression;
+
+    VRTExpression *GetCompiledExpression();
+    CPLErr         EvaluateExpression( VRTExpression *poExpression,
+                                       void **papSources,
+                                       void *pData,
+                                       int nBufXSize, int nBufYSize,
+                                       GDALDataType eBufType,
+                                       GSpacing nPixelSpace,
+                                       GSpacing nLineSpace );
+
  public:
     char *pszFuncName;
     GDALDataType eSourceTransferType;
@@ -638,6 +706,9 @@ class CPL_DLL VRTDerivedRasterBand : public VRTSourcedRasterBand
     static GDALDerivedPixelFunc GetPixelFunction( const char *pszFuncName );
 
     void SetPixelFunctionName( const char *pszFuncName );
+    void SetPixelFunctionExpression( const char *pszExpression );
+    const char *GetPixelFunctionExpression() const
+        { return m_osExpression.c_str(); }
     void SetSourceTransferType( GDALDataType eDataType );
 
     virtual CPLErr         XMLInit( CPLXMLNode *, const char * );
@@ -756,6 +827,7 @@ public:
     void           SetSrcMaskBand( GDALRasterBand * );
     void           SetSrcWindow( double, double, double, double );
     void           SetDstWindow( double, double, double, double );
+    int            GetDstWindow( double *, double *, double *, double * ) const;
     void           SetNoDataValue( double dfNoDataValue );
     const CPLString& GetResampling() const { return m_osResampling; }
     void           SetResampling( const char* pszResampling );
@@ -975,10 +1047,26 @@ class VRTKernelFilteredSource : public VRTFilteredSource
 protected:
     int     m_nKernelSize;
 
+    bool    m_bSeparable;
+
     double  *m_padfKernelCoefs;
 
+    // Vertical then horizontal 1D coefficients when the kernel is separable,
+    // either because it was declared so or detected as such.
+    double  *m_padfSeparableCoefs;
+
+    double  m_dfKernelSum;
+
     int     m_bNormalized;
 
+    void    DetectSeparableKernel();
+    void    FilterDataFull( int nXSize, int nYSize,
+                            const float *pafSrcData, float *pafDstData,
+                            int bHasNoData, float fNoData );
+    void    FilterDataSeparable( int nXSize, int nYSize,
+                                 const float *pafSrcData, float *pafDstData,
+                                 int bHasNoData, float fNoData );
+
 public:
             VRTKernelFilteredSource();
     virtual ~VRTKernelFilteredSource();
@@ -990,6 +1078,8 @@ public:
                                 GByte *pabySrcData, GByte *pabyDstData );
 
     CPLErr          SetKernel( int nKernelSize, double *padfCoefs );
+    CPLErr          SetKernel( int nKernelSize, bool bSeparable,
+                               double *padfCoefs );
     void            SetNormalized( int );
 };
 
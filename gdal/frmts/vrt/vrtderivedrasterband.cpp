@@ -30,9 +30,13 @@
 
 #include "cpl_minixml.h"
 #include "cpl_string.h"
+#include "cpl_worker_thread_pool.h"
 #include "vrtdataset.h"
+#include "vrtexpression.h"
 
+#include <algorithm>
 #include <map>
+#include <vector>
 
 static std::map<CPLString, GDALDerivedPixelFunc> osMapPixelFunction;
 
@@ -48,6 +52,7 @@ static std::map<CPLString, GDALDerivedPixelFunc> osMapPixelFunction;
 
 VRTDerivedRasterBand::VRTDerivedRasterBand( GDALDataset *poDSIn, int nBandIn ) :
     VRTSourcedRasterBand( poDSIn, nBandIn ),
+    m_poExpression(NULL),
     pszFuncName(NULL),
     eSourceTransferType(GDT_Unknown)
 {}
@@ -60,6 +65,7 @@ VRTDerivedRasterBand::VRTDerivedRasterBand( GDALDataset *poDSIn, int nBandIn,
                                             GDALDataType eType,
                                             int nXSize, int nYSize ) :
     VRTSourcedRasterBand(poDSIn, nBandIn, eType, nXSize, nYSize),
+    m_poExpression(NULL),
     pszFuncName(NULL),
     eSourceTransferType(GDT_Unknown)
 {}
@@ -72,6 +78,7 @@ VRTDerivedRasterBand::~VRTDerivedRasterBand()
 
 {
     CPLFree( pszFuncName );
+    delete m_poExpression;
 }
 
 /************************************************************************/
@@ -172,7 +179,192 @@ VRTDerivedRasterBand::GetPixelFunction( const char *pszFuncName )
  */
 void VRTDerivedRasterBand::SetPixelFunctionName( const char *pszFuncNameIn )
 {
+    CPLFree( pszFuncName );
     pszFuncName = CPLStrdup( pszFuncNameIn );
+    delete m_poExpression;
+    m_poExpression = NULL;
+}
+
+/************************************************************************/
+/*                      SetPixelFunctionExpression()                    */
+/************************************************************************/
+
+/**
+ * Set the band math expression to be applied to this derived band,
+ * instead of a pixel function.
+ *
+ * The expression combines the values of the sources, named B1, B2, ...
+ * in the order of the sources, with arithmetic operators (+, -, *, /, %,
+ * ^), comparison and logical operators (==, !=, <, <=, >, >=, &&, ||, !),
+ * the "cond ? a : b" conditional operator and functions such as sqrt(),
+ * log10(), pow(), min() or max(). For example "(B2-B1)/(B2+B1)".
+ *
+ * Sources are read as Float64 values. If the band has a nodata value, the
+ * result is nodata wherever a source used by the expression is nodata
+ * or NaN.
+ *
+ * @param pszExpression Band math expression, or NULL/empty string to use
+ * the pixel function.
+ *
+ * @since GDAL 2.2
+ */
+void VRTDerivedRasterBand::SetPixelFunctionExpression(
+    const char *pszExpression )
+{
+    m_osExpression = pszExpression ? pszExpression : "";
+    delete m_poExpression;
+    m_poExpression = NULL;
+}
+
+/************************************************************************/
+/*                       GetCompiledExpression()                        */
+/************************************************************************/
+
+// Return the expression of the band, or of its built-in pixel function,
+// compiled for the current sources.
+VRTExpression *VRTDerivedRasterBand::GetCompiledExpression()
+{
+    if( m_poExpression != NULL &&
+        m_poExpression->GetSourceCount() == nSources )
+        return m_poExpression;
+
+    delete m_poExpression;
+    m_poExpression = NULL;
+
+    CPLString osExpression( m_osExpression );
+    if( osExpression.empty() &&
+        !VRTExpression::GetBuiltinFunction( pszFuncName, nSources,
+                                            osExpression ) )
+        return NULL;
+
+    m_poExpression = VRTExpression::Compile( osExpression, nSources );
+    return m_poExpression;
+}
+
+/************************************************************************/
+/*                         EvaluateExpression()                         */
+/************************************************************************/
+
+typedef struct
+{
+    const VRTExpression  *poExpression;
+    const double * const *papadfSources;
+    int                   nSources;
+    int                   nXSize;
+    int                   nYStart;
+    int                   nYEnd;
+    int                   bHasNoData;
+    double                dfNoData;
+    GByte                *pabyData;
+    GDALDataType          eBufType;
+    int                   nPixelSpace;
+    GSpacing              nLineSpace;
+    bool                  bOK;
+} VRTExpressionJob;
+
+static void VRTExpressionJobFunc( void *pData )
+{
+    VRTExpressionJob *psJob = static_cast<VRTExpressionJob *>( pData );
+
+    double *padfWork = static_cast<double *>(
+        VSI_MALLOC2_VERBOSE( psJob->poExpression->GetWorkBufferSize() +
+                             psJob->nXSize, sizeof(double) ) );
+    if( padfWork == NULL )
+    {
+        psJob->bOK = false;
+        return;
+    }
+    double *padfLine = padfWork + psJob->poExpression->GetWorkBufferSize();
+
+    std::vector<const double *> apdfLineSources( psJob->nSources + 1 );
+    for( int iY = psJob->nYStart; iY < psJob->nYEnd; iY++ )
+    {
+        const size_t nOffset = static_cast<size_t>(iY) * psJob->nXSize;
+        for( int iSrc = 0; iSrc < psJob->nSources; iSrc++ )
+            apdfLineSources[iSrc] = psJob->papadfSources[iSrc] + nOffset;
+
+        psJob->poExpression->Evaluate( &apdfLineSources[0], psJob->nXSize,
+                                       psJob->bHasNoData, psJob->dfNoData,
+                                       padfLine, padfWork );
+
+        GDALCopyWords( padfLine, GDT_Float64, sizeof(double),
+                       psJob->pabyData + iY * psJob->nLineSpace,
+                       psJob->eBufType, psJob->nPixelSpace, psJob->nXSize );
+    }
+
+    VSIFree( padfWork );
+    psJob->bOK = true;
+}
+
+// Evaluate the expression on the Float64 source buffers, in several threads
+// if the dataset has a thread pool (VRT_NUM_THREADS) and the request is big
+// enough.
+CPLErr VRTDerivedRasterBand::EvaluateExpression( VRTExpression *poExpression,
+                                                 void **papSources,
+                                                 void *pData,
+                                                 int nBufXSize, int nBufYSize,
+                                                 GDALDataType eBufType,
+                                                 GSpacing nPixelSpace,
+                                                 GSpacing nLineSpace )
+{
+    CPLWorkerThreadPool *poThreadPool = NULL;
+    if( poDS != NULL &&
+        static_cast<GIntBig>(nBufXSize) * nBufYSize >= 65536 )
+    {
+        poThreadPool = reinterpret_cast<VRTDataset *>( poDS )->GetThreadPool();
+    }
+    int nJobs = 1;
+    if( poThreadPool != NULL )
+        nJobs = std::min( poThreadPool->GetThreadCount(), nBufYSize );
+
+    std::vector<VRTExpressionJob> asJobs( nJobs );
+    for( int iJob = 0; iJob < nJobs; iJob++ )
+    {
+        VRTExpressionJob &sJob = asJobs[iJob];
+        sJob.poExpression = poExpression;
+        sJob.papadfSources = reinterpret_cast<double **>( papSources );
+        sJob.nSources = nSources;
+        sJob.nXSize = nBufXSize;
+        sJob.nYStart = static_cast<int>(
+            static_cast<GIntBig>(nBufYSize) * iJob / nJobs );
+        sJob.nYEnd = static_cast<int>(
+            static_cast<GIntBig>(nBufYSize) * (iJob + 1) / nJobs );
+        sJob.bHasNoData = m_bNoDataValueSet;
+        sJob.dfNoData = m_dfNoDataValue;
+        sJob.pabyData = static_cast<GByte *>( pData );
+        sJob.eBufType = eBufType;
+        sJob.nPixelSpace = static_cast<int>(nPixelSpace);
+        sJob.nLineSpace = nLineSpace;
+        sJob.bOK = false;
+    }
+
+    if( nJobs == 1 )
+    {
+        VRTExpressionJobFunc( &asJobs[0] );
+    }
+    else
+    {
+        std::vector<void *> apJobs;
+        for( int iJob = 0; iJob < nJobs; iJob++ )
+            apJobs.push_back( &asJobs[iJob] );
+        if( !poThreadPool->SubmitJobs( VRTExpressionJobFunc, apJobs ) )
+        {
+            poThreadPool->WaitCompletion();
+            for( int iJob = 0; iJob < nJobs; iJob++ )
+                VRTExpressionJobFunc( &asJobs[iJob] );
+        }
+        else
+        {
+            poThreadPool->WaitCompletion();
+        }
+    }
+
+    for( int iJob = 0; iJob < nJobs; iJob++ )
+    {
+        if( !asJobs[iJob].bOK )
+            return CE_Failure;
+    }
+    return CE_None;
 }
 
 /************************************************************************/
@@ -269,11 +461,6 @@ CPLErr VRTDerivedRasterBand::IRasterIO( GDALRWFlag eRWFlag,
 
     int typesize = GDALGetDataTypeSizeBytes(eBufType);
     if( GDALGetDataTypeSize(eBufType) % 8 > 0 ) typesize++;
-    GDALDataType eSrcType = eSourceTransferType;
-    if( eSrcType == GDT_Unknown || eSrcType >= GDT_TypeCount ) {
-        eSrcType = eBufType;
-    }
-    const int sourcesize = GDALGetDataTypeSizeBytes(eSrcType);
 
 /* -------------------------------------------------------------------- */
 /*      Initialize the buffer to some background value. Use the         */
@@ -313,17 +500,36 @@ CPLErr VRTDerivedRasterBand::IRasterIO( GDALRWFlag eRWFlag,
             return CE_None;
     }
 
-    /* ---- Get pixel function for band ---- */
-    GDALDerivedPixelFunc pfnPixelFunc
-        = VRTDerivedRasterBand::GetPixelFunction(pszFuncName);
+    /* ---- Get pixel function or expression for band ---- */
+    GDALDerivedPixelFunc pfnPixelFunc = NULL;
+    VRTExpression *poExpression = NULL;
+    if( m_osExpression.empty() )
+        pfnPixelFunc = VRTDerivedRasterBand::GetPixelFunction(pszFuncName);
     if( pfnPixelFunc == NULL )
     {
-        CPLError( CE_Failure, CPLE_IllegalArg,
-                  "VRTDerivedRasterBand::IRasterIO:"
-                  "Derived band pixel function '%s' not registered.",
-                  this->pszFuncName) ;
-        return CE_Failure;
+        if( m_osExpression.empty() &&
+            !VRTExpression::IsBuiltinFunction(pszFuncName) )
+        {
+            CPLError( CE_Failure, CPLE_IllegalArg,
+                      "VRTDerivedRasterBand::IRasterIO:"
+                      "Derived band pixel function '%s' not registered.",
+                      this->pszFuncName) ;
+            return CE_Failure;
+        }
+        poExpression = GetCompiledExpression();
+        if( poExpression == NULL )
+            return CE_Failure;
+    }
+
+    GDALDataType eSrcType = eSourceTransferType;
+    if( poExpression != NULL ) {
+        // Expressions are evaluated on double values.
+        eSrcType = GDT_Float64;
     }
+    else if( eSrcType == GDT_Unknown || eSrcType >= GDT_TypeCount ) {
+        eSrcType = eBufType;
+    }
+    const int sourcesize = GDALGetDataTypeSizeBytes(eSrcType);
 
     /* TODO: It would be nice to use a MallocBlock function for each
        individual buffer that would recycle blocks of memory from a
@@ -379,8 +585,13 @@ CPLErr VRTDerivedRasterBand::IRasterIO( GDALRWFlag eRWFlag,
             GDALGetDataTypeSizeBytes( eSrcType ) * nBufXSize, &sExtraArg );
     }
 
-    // Apply pixel function.
-    if( eErr == CE_None ) {
+    // Apply pixel function or expression.
+    if( eErr == CE_None && poExpression != NULL ) {
+        eErr = EvaluateExpression( poExpression, pBuffers, pData,
+                                   nBufXSize, nBufYSize, eBufType,
+                                   nPixelSpace, nLineSpace );
+    }
+    else if( eErr == CE_None ) {
         eErr = pfnPixelFunc( reinterpret_cast<void **>( pBuffers ), nSources,
                              pData, nBufXSize, nBufYSize,
                              eSrcType, eBufType, static_cast<int>(nPixelSpace),
@@ -411,6 +622,16 @@ CPLErr VRTDerivedRasterBand::XMLInit( CPLXMLNode *psTree,
     // Read derived pixel function type.
     SetPixelFunctionName( CPLGetXMLValue( psTree, "PixelFunctionType", NULL ) );
 
+    // Read optional band math expression, and check its syntax now.
+    const char *pszExpression =
+        CPLGetXMLValue( psTree, "PixelFunctionExpression", NULL );
+    if( pszExpression != NULL && pszExpression[0] != '\0' )
+    {
+        SetPixelFunctionExpression( pszExpression );
+        if( GetCompiledExpression() == NULL )
+            return CE_Failure;
+    }
+
     // Read optional source transfer data type.
     const char *pszTypeName = CPLGetXMLValue(psTree, "SourceTransferType", NULL);
     if( pszTypeName != NULL )
@@ -439,6 +660,8 @@ CPLXMLNode *VRTDerivedRasterBand::SerializeToXML( const char *pszVRTPath )
     /* ---- Encode DerivedBand-specific fields ---- */
     if( pszFuncName != NULL && strlen(pszFuncName) > 0 )
         CPLSetXMLValue( psTree, "PixelFunctionType", pszFuncName );
+    if( !m_osExpression.empty() )
+        CPLSetXMLValue( psTree, "PixelFunctionExpression", m_osExpression );
     if( this->eSourceTransferType != GDT_Unknown)
         CPLSetXMLValue( psTree, "SourceTransferType",
                         GDALGetDataTypeName( eSourceTransferType ) );
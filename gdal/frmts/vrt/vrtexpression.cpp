@@ -0,0 +1,912 @@
+/******************************************************************************
+ *
+ * Project:  Virtual GDAL Datasets
+ * Purpose:  Band math expressions for derived bands.
+ * Author:   agent <agent at local>
+ *
+ ******************************************************************************
+ * Copyright (c) 2026, agent <agent at local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ****************************************************************************/
+
+#include "vrtexpression.h"
+
+#include "cpl_conv.h"
+#include "cpl_error.h"
+#include "gdalsse_priv.h"
+
+#include <cmath>
+#include <cstring>
+
+CPL_CVSID("$Id$");
+
+const int VRTExpression::CHUNK_SIZE;
+
+// Maximum number of nested sub-expressions (parentheses, function arguments,
+// unary operators, ...), so that a hostile expression cannot exhaust the
+// stack of the recursive descent parser.
+static const int MAX_NESTING_LEVEL = 512;
+
+/************************************************************************/
+/* ==================================================================== */
+/*                          VRTExpressionParser                         */
+/* ==================================================================== */
+/************************************************************************/
+
+/* Recursive descent parser emitting the postfix program of an expression.
+ * Grammar, from lowest to highest precedence:
+ *
+ * expr    := or [ '?' expr ':' expr ]
+ * or      := and { '||' and }
+ * and     := cmp { '&&' cmp }
+ * cmp     := add { ('==' | '!=' | '<' | '<=' | '>' | '>=') add }
+ * add     := mul { ('+' | '-') mul }
+ * mul     := unary { ('*' | '/' | '%') unary }
+ * unary   := ('-' | '+' | '!') unary | power
+ * power   := primary [ '^' unary ]
+ * primary := number | 'B' index | 'pi' | function '(' expr {',' expr} ')'
+ *            | '(' expr ')'
+ */
+
+class VRTExpressionParser
+{
+    VRTExpression *m_poExpr;
+    const char    *m_pszStart;
+    const char    *m_pszCur;
+    int            m_nDepth;
+    int            m_nNestingLevel;
+    bool           m_bError;
+
+    void        SkipSpaces();
+    bool        EnterNesting();
+    bool        Accept( const char *pszToken );
+    void        Error( const char *pszMsg );
+    void        Emit( VRTExpression::OpCode eOp, int nStackChange,
+                      int iSource = 0, double dfValue = 0.0 );
+
+    void        ParseExpr();
+    void        ParseOr();
+    void        ParseAnd();
+    void        ParseCmp();
+    void        ParseAdd();
+    void        ParseMul();
+    void        ParseUnary();
+    void        ParsePower();
+    void        ParsePrimary();
+    void        ParseFunction( const CPLString &osName );
+
+  public:
+    VRTExpressionParser( VRTExpression *poExpr, const char *pszExpression ) :
+        m_poExpr(poExpr),
+        m_pszStart(pszExpression),
+        m_pszCur(pszExpression),
+        m_nDepth(0),
+        m_nNestingLevel(0),
+        m_bError(false) {}
+
+    bool        Parse();
+};
+
+/************************************************************************/
+/*                             SkipSpaces()                             */
+/************************************************************************/
+
+void VRTExpressionParser::SkipSpaces()
+{
+    while( *m_pszCur == ' ' || *m_pszCur == '\t' ||
+           *m_pszCur == '\r' || *m_pszCur == '\n' )
+        m_pszCur++;
+}
+
+/************************************************************************/
+/*                               Accept()                               */
+/************************************************************************/
+
+bool VRTExpressionParser::Accept( const char *pszToken )
+{
+    SkipSpaces();
+    const size_t nLen = strlen(pszToken);
+    if( strncmp(m_pszCur, pszToken, nLen) != 0 )
+        return false;
+    // Do not take the '<' of '<=' for example.
+    if( nLen == 1 && (pszToken[0] == '<' || pszToken[0] == '>' ||
+                      pszToken[0] == '=' || pszToken[0] == '!') &&
+        m_pszCur[1] == '=' )
+        return false;
+    m_pszCur += nLen;
+    return true;
+}
+
+/************************************************************************/
+/*                               Error()                                */
+/************************************************************************/
+
+void VRTExpressionParser::Error( const char *pszMsg )
+{
+    if( m_bError )
+        return;
+    m_bError = true;
+    CPLError( CE_Failure, CPLE_AppDefined,
+              "Invalid expression '%s': %s at position %d",
+              m_pszStart, pszMsg, static_cast<int>(m_pszCur - m_pszStart) );
+}
+
+/************************************************************************/
+/*                            EnterNesting()                            */
+/************************************************************************/
+
+/* Must be balanced by a decrement of m_nNestingLevel when returning true. */
+bool VRTExpressionParser::EnterNesting()
+{
+    if( m_bError )
+        return false;
+    if( m_nNestingLevel == MAX_NESTING_LEVEL )
+    {
+        Error("expression too deeply nested");
+        return false;
+    }
+    m_nNestingLevel++;
+    return true;
+}
+
+/************************************************************************/
+/*                                Emit()                                */
+/************************************************************************/
+
+void VRTExpressionParser::Emit( VRTExpression::OpCode eOp, int nStackChange,
+                                int iSource, double dfValue )
+{
+    VRTExpression::Instruction sInstr;
+    sInstr.eOp = eOp;
+    sInstr.iSource = iSource;
+    sInstr.dfValue = dfValue;
+    m_poExpr->m_aoProgram.push_back(sInstr);
+
+    m_nDepth += nStackChange;
+    if( m_nDepth > m_poExpr->m_nStackDepth )
+        m_poExpr->m_nStackDepth = m_nDepth;
+}
+
+/************************************************************************/
+/*                               Parse()                                */
+/************************************************************************/
+
+bool VRTExpressionParser::Parse()
+{
+    ParseExpr();
+    SkipSpaces();
+    if( !m_bError && *m_pszCur != '\0' )
+        Error("unexpected character");
+    return !m_bError;
+}
+
+/************************************************************************/
+/*                             ParseExpr()                              */
+/************************************************************************/
+
+void VRTExpressionParser::ParseExpr()
+{
+    if( !EnterNesting() )
+        return;
+    ParseOr();
+    if( !m_bError && Accept("?") )
+    {
+        ParseExpr();
+        if( !m_bError && !Accept(":") )
+            Error("':' expected");
+        ParseExpr();
+        Emit(VRTExpression::OP_SELECT, -2);
+    }
+    m_nNestingLevel--;
+}
+
+/************************************************************************/
+/*                        ParseOr() / ParseAnd()                        */
+/************************************************************************/
+
+void VRTExpressionParser::ParseOr()
+{
+    ParseAnd();
+    while( !m_bError && Accept("||") )
+    {
+        ParseAnd();
+        Emit(VRTExpression::OP_OR, -1);
+    }
+}
+
+void VRTExpressionParser::ParseAnd()
+{
+    ParseCmp();
+    while( !m_bError && Accept("&&") )
+    {
+        ParseCmp();
+        Emit(VRTExpression::OP_AND, -1);
+    }
+}
+
+/************************************************************************/
+/*                              ParseCmp()                              */
+/************************************************************************/
+
+void VRTExpressionParser::ParseCmp()
+{
+    ParseAdd();
+    while( !m_bError )
+    {
+        VRTExpression::OpCode eOp;
+        if( Accept("==") )
+            eOp = VRTExpression::OP_EQ;
+        else if( Accept("!=") )
+            eOp = VRTExpression::OP_NE;
+        else if( Accept("<=") )
+            eOp = VRTExpression::OP_LE;
+        else if( Accept(">=") )
+            eOp = VRTExpression::OP_GE;
+        else if( Accept("<") )
+            eOp = VRTExpression::OP_LT;
+        else if( Accept(">") )
+            eOp = VRTExpression::OP_GT;
+        else
+            break;
+        ParseAdd();
+        Emit(eOp, -1);
+    }
+}
+
+/************************************************************************/
+/*                        ParseAdd() / ParseMul()                       */
+/************************************************************************/
+
+void VRTExpressionParser::ParseAdd()
+{
+    ParseMul();
+    while( !m_bError )
+    {
+        VRTExpression::OpCode eOp;
+        if( Accept("+") )
+            eOp = VRTExpression::OP_ADD;
+        else if( Accept("-") )
+            eOp = VRTExpression::OP_SUB;
+        else
+            break;
+        ParseMul();
+        Emit(eOp, -1);
+    }
+}
+
+void VRTExpressionParser::ParseMul()
+{
+    ParseUnary();
+    while( !m_bError )
+    {
+        VRTExpression::OpCode eOp;
+        if( Accept("*") )
+            eOp = VRTExpression::OP_MUL;
+        else if( Accept("/") )
+            eOp = VRTExpression::OP_DIV;
+        else if( Accept("%") )
+            eOp = VRTExpression::OP_MOD;
+        else
+            break;
+        ParseUnary();
+        Emit(eOp, -1);
+    }
+}
+
+/************************************************************************/
+/*                       ParseUnary() / ParsePower()                    */
+/************************************************************************/
+
+void VRTExpressionParser::ParseUnary()
+{
+    if( !EnterNesting() )
+        return;
+    if( Accept("-") )
+    {
+        ParseUnary();
+        Emit(VRTExpression::OP_NEG, 0);
+    }
+    else if( Accept("+") )
+    {
+        ParseUnary();
+    }
+    else if( Accept("!") )
+    {
+        ParseUnary();
+        Emit(VRTExpression::OP_NOT, 0);
+    }
+    else
+    {
+        ParsePower();
+    }
+    m_nNestingLevel--;
+}
+
+void VRTExpressionParser::ParsePower()
+{
+    ParsePrimary();
+    if( !m_bError && Accept("^") )
+    {
+        // Right associative, and binds tighter than a unary minus on its
+        // left: -2^2 = -4, 2^-1 = 0.5
+        ParseUnary();
+        Emit(VRTExpression::OP_POW, -1);
+    }
+}
+
+/************************************************************************/
+/*                            ParsePrimary()                            */
+/************************************************************************/
+
+void VRTExpressionParser::ParsePrimary()
+{
+    if( m_bError )
+        return;
+
+    SkipSpaces();
+    const char ch = *m_pszCur;
+
+    if( (ch >= '0' && ch <= '9') || ch == '.' )
+    {
+        char *pszEnd = NULL;
+        const double dfValue = CPLStrtod(m_pszCur, &pszEnd);
+        if( pszEnd == m_pszCur )
+        {
+            Error("invalid number");
+            return;
+        }
+        m_pszCur = pszEnd;
+        Emit(VRTExpression::OP_CONSTANT, 1, 0, dfValue);
+        return;
+    }
+
+    if( (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || ch == '_' )
+    {
+        const char *pszNameStart = m_pszCur;
+        while( (*m_pszCur >= 'a' && *m_pszCur <= 'z') ||
+               (*m_pszCur >= 'A' && *m_pszCur <= 'Z') ||
+               (*m_pszCur >= '0' && *m_pszCur <= '9') ||
+               *m_pszCur == '_' )
+            m_pszCur++;
+        const CPLString osName(
+            std::string(pszNameStart, m_pszCur - pszNameStart));
+
+        // Bn: value of the n-th source
+        if( (osName[0] == 'B' || osName[0] == 'b') && osName.size() > 1 &&
+            osName.find_first_not_of("0123456789", 1) == std::string::npos )
+        {
+            const int nIdx = atoi(osName.c_str() + 1);
+            if( nIdx < 1 || nIdx > m_poExpr->m_nSources )
+            {
+                Error(CPLSPrintf("%s does not match any of the %d sources",
+                                 osName.c_str(), m_poExpr->m_nSources));
+                return;
+            }
+            Emit(VRTExpression::OP_SOURCE, 1, nIdx - 1);
+            return;
+        }
+
+        if( EQUAL(osName, "pi") )
+        {
+            Emit(VRTExpression::OP_CONSTANT, 1, 0, M_PI);
+            return;
+        }
+
+        ParseFunction(osName);
+        return;
+    }
+
+    if( Accept("(") )
+    {
+        ParseExpr();
+        if( !m_bError && !Accept(")") )
+            Error("')' expected");
+        return;
+    }
+
+    Error(ch == '\0' ? "unexpected end of expression" : "unexpected character");
+}
+
+/************************************************************************/
+/*                           ParseFunction()                            */
+/************************************************************************/
+
+void VRTExpressionParser::ParseFunction( const CPLString &osName )
+{
+    static const struct
+    {
+        const char           *pszName;
+        VRTExpression::OpCode eOp;
+        int                   nArgs; // -1 for 2 or more
+    } asFunctions[] = {
+        { "abs", VRTExpression::OP_ABS, 1 },
+        { "sqrt", VRTExpression::OP_SQRT, 1 },
+        { "exp", VRTExpression::OP_EXP, 1 },
+        { "log", VRTExpression::OP_LOG, 1 },
+        { "log10", VRTExpression::OP_LOG10, 1 },
+        { "sin", VRTExpression::OP_SIN, 1 },
+        { "cos", VRTExpression::OP_COS, 1 },
+        { "tan", VRTExpression::OP_TAN, 1 },
+        { "asin", VRTExpression::OP_ASIN, 1 },
+        { "acos", VRTExpression::OP_ACOS, 1 },
+        { "atan", VRTExpression::OP_ATAN, 1 },
+        { "floor", VRTExpression::OP_FLOOR, 1 },
+        { "ceil", VRTExpression::OP_CEIL, 1 },
+        { "round", VRTExpression::OP_ROUND, 1 },
+        { "pow", VRTExpression::OP_POW, 2 },
+        { "atan2", VRTExpression::OP_ATAN2, 2 },
+        { "fmod", VRTExpression::OP_MOD, 2 },
+        { "min", VRTExpression::OP_MIN, -1 },
+        { "max", VRTExpression::OP_MAX, -1 },
+    };
+
+    size_t iFunc = 0;
+    for( ; iFunc < CPL_ARRAYSIZE(asFunctions); iFunc++ )
+    {
+        if( EQUAL(osName, asFunctions[iFunc].pszName) )
+            break;
+    }
+    if( iFunc == CPL_ARRAYSIZE(asFunctions) )
+    {
+        Error(CPLSPrintf("unknown identifier '%s'", osName.c_str()));
+        return;
+    }
+    if( !Accept("(") )
+    {
+        Error("'(' expected");
+        return;
+    }
+
+    int nArgs = 0;
+    do
+    {
+        ParseExpr();
+        nArgs++;
+        // min() and max() are folded as a sequence of binary operations.
+        if( asFunctions[iFunc].nArgs < 0 && nArgs > 1 )
+            Emit(asFunctions[iFunc].eOp, -1);
+    }
+    while( !m_bError && Accept(",") );
+
+    if( m_bError )
+        return;
+    if( !Accept(")") )
+    {
+        Error("')' expected");
+        return;
+    }
+
+    const int nExpected = asFunctions[iFunc].nArgs;
+    if( (nExpected > 0 && nArgs != nExpected) ||
+        (nExpected < 0 && nArgs < 2) )
+    {
+        Error(CPLSPrintf("wrong number of arguments for %s()",
+                         asFunctions[iFunc].pszName));
+        return;
+    }
+    if( nExpected > 0 )
+        Emit(asFunctions[iFunc].eOp, 1 - nArgs);
+}
+
+/************************************************************************/
+/* ==================================================================== */
+/*                            VRTExpression                             */
+/* ==================================================================== */
+/************************************************************************/
+
+VRTExpression::VRTExpression() :
+    m_nSources(0),
+    m_nStackDepth(0)
+{}
+
+/************************************************************************/
+/*                              Compile()                               */
+/************************************************************************/
+
+/** Parse an expression referencing nSources sources.
+ *
+ * @return a new object to delete, or NULL in case of syntax error, in which
+ * case an error has been emitted.
+ */
+VRTExpression *VRTExpression::Compile( const char *pszExpression,
+                                       int nSources )
+{
+    VRTExpression *poExpr = new VRTExpression();
+    poExpr->m_osExpression = pszExpression;
+    poExpr->m_nSources = nSources;
+
+    VRTExpressionParser oParser(poExpr, pszExpression);
+    if( !oParser.Parse() )
+    {
+        delete poExpr;
+        return NULL;
+    }
+
+    std::vector<bool> abUsed(nSources, false);
+    for( size_t i = 0; i < poExpr->m_aoProgram.size(); i++ )
+    {
+        if( poExpr->m_aoProgram[i].eOp == OP_SOURCE )
+            abUsed[poExpr->m_aoProgram[i].iSource] = true;
+    }
+    for( int i = 0; i < nSources; i++ )
+    {
+        if( abUsed[i] )
+            poExpr->m_anUsedSources.push_back(i);
+    }
+
+    return poExpr;
+}
+
+/************************************************************************/
+/*                          Built-in functions                          */
+/************************************************************************/
+
+// Built-in pixel functions of a fixed number of sources. "sum" and "mul",
+// that accept any number of sources, are handled separately.
+static const struct
+{
+    const char *pszName;
+    int         nSources;
+    const char *pszExpression;
+} asBuiltinFunctions[] = {
+    { "diff", 2, "B1-B2" },
+    { "div", 2, "B1/B2" },
+    { "ndvi", 2, "(B2-B1)/(B2+B1)" },
+    { "inv", 1, "1/B1" },
+    { "mod", 1, "abs(B1)" },
+    { "intensity", 1, "B1*B1" },
+    { "sqrt", 1, "sqrt(B1)" },
+    { "log10", 1, "log10(B1)" },
+    { "dB", 1, "20*log10(abs(B1))" },
+    { "dB2amp", 1, "10^(B1/20)" },
+    { "dB2pow", 1, "10^(B1/10)" },
+};
+
+/************************************************************************/
+/*                         IsBuiltinFunction()                          */
+/************************************************************************/
+
+/** Return whether pszName is the name of a built-in pixel function. */
+bool VRTExpression::IsBuiltinFunction( const char *pszName )
+{
+    if( pszName == NULL )
+        return false;
+    if( EQUAL(pszName, "sum") || EQUAL(pszName, "mul") )
+        return true;
+    for( size_t i = 0; i < CPL_ARRAYSIZE(asBuiltinFunctions); i++ )
+    {
+        if( EQUAL(pszName, asBuiltinFunctions[i].pszName) )
+            return true;
+    }
+    return false;
+}
+
+/************************************************************************/
+/*                         GetBuiltinFunction()                         */
+/************************************************************************/
+
+/** Return the expression of a built-in pixel function, for a given number
+ * of sources.
+ *
+ * @return false, and emit an error, if there is no such function, or if it
+ * cannot be applied to nSources sources.
+ */
+bool VRTExpression::GetBuiltinFunction( const char *pszName, int nSources,
+                                        CPLString &osExpression )
+{
+    if( !IsBuiltinFunction(pszName) )
+    {
+        CPLError( CE_Failure, CPLE_AppDefined,
+                  "'%s' is not a built-in pixel function",
+                  pszName ? pszName : "" );
+        return false;
+    }
+
+    // Functions of any number of sources.
+    if( EQUAL(pszName, "sum") || EQUAL(pszName, "mul") )
+    {
+        if( nSources < 1 )
+        {
+            CPLError( CE_Failure, CPLE_AppDefined,
+                      "Pixel function '%s' requires at least one source",
+                      pszName );
+            return false;
+        }
+        const char *pszOp = EQUAL(pszName, "sum") ? "+" : "*";
+        osExpression = "B1";
+        for( int i = 2; i <= nSources; i++ )
+            osExpression += CPLSPrintf("%sB%d", pszOp, i);
+        return true;
+    }
+
+    for( size_t i = 0; i < CPL_ARRAYSIZE(asBuiltinFunctions); i++ )
+    {
+        if( EQUAL(pszName, asBuiltinFunctions[i].pszName) )
+        {
+            if( nSources != asBuiltinFunctions[i].nSources )
+            {
+                CPLError( CE_Failure, CPLE_AppDefined,
+                          "Pixel function '%s' requires %d source(s), "
+                          "but %d are defined",
+                          asBuiltinFunctions[i].pszName,
+                          asBuiltinFunctions[i].nSources, nSources );
+                return false;
+            }
+            osExpression = asBuiltinFunctions[i].pszExpression;
+            break;
+        }
+    }
+    return true;
+}
+
+/************************************************************************/
+/*                         GetWorkBufferSize()                          */
+/************************************************************************/
+
+/** Return the number of doubles of the work buffer to pass to Evaluate() */
+size_t VRTExpression::GetWorkBufferSize() const
+{
+    return static_cast<size_t>(m_nStackDepth) * CHUNK_SIZE;
+}
+
+/************************************************************************/
+/*                              Kernels                                 */
+/************************************************************************/
+
+// Arithmetic operators use SSE2 (with an emulation on other CPUs), four
+// values at a time.
+#define DEFINE_SIMD_KERNEL(name, EXPR4, EXPR1)                              \
+static void name( const double *padfA, const double *padfB,                 \
+                  double *padfOut, int n )                                  \
+{                                                                           \
+    int i = 0;                                                              \
+    for( ; i + 4 <= n; i += 4 )                                             \
+    {                                                                       \
+        const XMMReg4Double a = XMMReg4Double::Load4Val(padfA + i);         \
+        const XMMReg4Double b = XMMReg4Double::Load4Val(padfB + i);         \
+        const XMMReg4Double r = EXPR4;                                      \
+        r.low.Store2Double(padfOut + i);                                    \
+        r.high.Store2Double(padfOut + i + 2);                               \
+    }                                                                       \
+    for( ; i < n; i++ )                                                     \
+    {                                                                       \
+        const double a = padfA[i];                                          \
+        const double b = padfB[i];                                          \
+        padfOut[i] = EXPR1;                                                 \
+    }                                                                       \
+}
+
+DEFINE_SIMD_KERNEL(AddKernel, a + b, a + b)
+DEFINE_SIMD_KERNEL(SubKernel, a - b, a - b)
+DEFINE_SIMD_KERNEL(MulKernel, a * b, a * b)
+DEFINE_SIMD_KERNEL(DivKernel, a / b, a / b)
+DEFINE_SIMD_KERNEL(MinKernel, XMMReg4Double::Min(a, b), (a < b) ? a : b)
+
+#define DEFINE_BINARY_KERNEL(name, EXPR)                                    \
+static void name( const double *padfA, const double *padfB,                 \
+                  double *padfOut, int n )                                  \
+{                                                                           \
+    for( int i = 0; i < n; i++ )                                            \
+    {                                                                       \
+        const double a = padfA[i];                                          \
+        const double b = padfB[i];                                          \
+        padfOut[i] = EXPR;                                                  \
+    }                                                                       \
+}
+
+DEFINE_BINARY_KERNEL(MaxKernel, (a > b) ? a : b)
+DEFINE_BINARY_KERNEL(ModKernel, fmod(a, b))
+DEFINE_BINARY_KERNEL(PowKernel, pow(a, b))
+DEFINE_BINARY_KERNEL(Atan2Kernel, atan2(a, b))
+DEFINE_BINARY_KERNEL(EqKernel, (a == b) ? 1.0 : 0.0)
+DEFINE_BINARY_KERNEL(NeKernel, (a != b) ? 1.0 : 0.0)
+DEFINE_BINARY_KERNEL(LtKernel, (a < b) ? 1.0 : 0.0)
+DEFINE_BINARY_KERNEL(LeKernel, (a <= b) ? 1.0 : 0.0)
+DEFINE_BINARY_KERNEL(GtKernel, (a > b) ? 1.0 : 0.0)
+DEFINE_BINARY_KERNEL(GeKernel, (a >= b) ? 1.0 : 0.0)
+DEFINE_BINARY_KERNEL(AndKernel, (a != 0.0 && b != 0.0) ? 1.0 : 0.0)
+DEFINE_BINARY_KERNEL(OrKernel, (a != 0.0 || b != 0.0) ? 1.0 : 0.0)
+
+static double RoundHalfAwayFromZero( double dfVal )
+{
+    return dfVal >= 0.0 ? floor(dfVal + 0.5) : ceil(dfVal - 0.5);
+}
+
+#define DEFINE_UNARY_KERNEL(name, EXPR)                                     \
+static void name( const double *padfA, double *padfOut, int n )             \
+{                                                                           \
+    for( int i = 0; i < n; i++ )                                            \
+    {                                                                       \
+        const double a = padfA[i];                                          \
+        padfOut[i] = EXPR;                                                  \
+    }                                                                       \
+}
+
+DEFINE_UNARY_KERNEL(NegKernel, -a)
+DEFINE_UNARY_KERNEL(NotKernel, (a == 0.0) ? 1.0 : 0.0)
+DEFINE_UNARY_KERNEL(AbsKernel, fabs(a))
+DEFINE_UNARY_KERNEL(SqrtKernel, sqrt(a))
+DEFINE_UNARY_KERNEL(ExpKernel, exp(a))
+DEFINE_UNARY_KERNEL(LogKernel, log(a))
+DEFINE_UNARY_KERNEL(Log10Kernel, log10(a))
+DEFINE_UNARY_KERNEL(SinKernel, sin(a))
+DEFINE_UNARY_KERNEL(CosKernel, cos(a))
+DEFINE_UNARY_KERNEL(TanKernel, tan(a))
+DEFINE_UNARY_KERNEL(AsinKernel, asin(a))
+DEFINE_UNARY_KERNEL(AcosKernel, acos(a))
+DEFINE_UNARY_KERNEL(AtanKernel, atan(a))
+DEFINE_UNARY_KERNEL(FloorKernel, floor(a))
+DEFINE_UNARY_KERNEL(CeilKernel, ceil(a))
+DEFINE_UNARY_KERNEL(RoundKernel, RoundHalfAwayFromZero(a))
+
+/************************************************************************/
+/*                              Evaluate()                              */
+/************************************************************************/
+
+/** Evaluate the expression on nValues values.
+ *
+ * @param papadfSources array of GetSourceCount() pointers to the values of
+ *                      each source.
+ * @param nValues number of values to compute.
+ * @param bHasNoData whether dfNoData is the nodata value. If it is set, the
+ *                   result is dfNoData wherever one of the sources used by
+ *                   the expression is dfNoData or NaN, or where the result
+ *                   is NaN.
+ * @param dfNoData nodata value.
+ * @param padfOut output array of nValues values.
+ * @param padfWork work buffer of GetWorkBufferSize() values.
+ */
+void VRTExpression::Evaluate( const double * const *papadfSources,
+                              int nValues,
+                              int bHasNoData, double dfNoData,
+                              double *padfOut, double *padfWork ) const
+{
+    std::vector<const double *> apdfStack(m_nStackDepth + 1);
+    const size_t nInstructions = m_aoProgram.size();
+
+    for( int iStart = 0; iStart < nValues; iStart += CHUNK_SIZE )
+    {
+        const int n = (nValues - iStart < CHUNK_SIZE) ?
+                                    nValues - iStart : CHUNK_SIZE;
+        int nTop = 0;
+
+        for( size_t iInstr = 0; iInstr < nInstructions; iInstr++ )
+        {
+            const Instruction &sInstr = m_aoProgram[iInstr];
+            switch( sInstr.eOp )
+            {
+                case OP_SOURCE:
+                    apdfStack[nTop++] = papadfSources[sInstr.iSource] + iStart;
+                    break;
+
+                case OP_CONSTANT:
+                {
+                    double *padfSlot = padfWork + nTop * CHUNK_SIZE;
+                    for( int i = 0; i < n; i++ )
+                        padfSlot[i] = sInstr.dfValue;
+                    apdfStack[nTop++] = padfSlot;
+                    break;
+                }
+
+                case OP_SELECT:
+                {
+                    double *padfSlot = padfWork + (nTop - 3) * CHUNK_SIZE;
+                    const double *padfCond = apdfStack[nTop - 3];
+                    const double *padfTrue = apdfStack[nTop - 2];
+                    const double *padfFalse = apdfStack[nTop - 1];
+                    for( int i = 0; i < n; i++ )
+                        padfSlot[i] = padfCond[i] != 0.0 ? padfTrue[i]
+                                                         : padfFalse[i];
+                    nTop -= 2;
+                    apdfStack[nTop - 1] = padfSlot;
+                    break;
+                }
+
+                case OP_NEG: case OP_NOT: case OP_ABS: case OP_SQRT:
+                case OP_EXP: case OP_LOG: case OP_LOG10: case OP_SIN:
+                case OP_COS: case OP_TAN: case OP_ASIN: case OP_ACOS:
+                case OP_ATAN: case OP_FLOOR: case OP_CEIL: case OP_ROUND:
+                {
+                    double *padfSlot = padfWork + (nTop - 1) * CHUNK_SIZE;
+                    const double *padfA = apdfStack[nTop - 1];
+                    switch( sInstr.eOp )
+                    {
+                        case OP_NEG: NegKernel(padfA, padfSlot, n); break;
+                        case OP_NOT: NotKernel(padfA, padfSlot, n); break;
+                        case OP_ABS: AbsKernel(padfA, padfSlot, n); break;
+                        case OP_SQRT: SqrtKernel(padfA, padfSlot, n); break;
+                        case OP_EXP: ExpKernel(padfA, padfSlot, n); break;
+                        case OP_LOG: LogKernel(padfA, padfSlot, n); break;
+                        case OP_LOG10: Log10Kernel(padfA, padfSlot, n); break;
+                        case OP_SIN: SinKernel(padfA, padfSlot, n); break;
+                        case OP_COS: CosKernel(padfA, padfSlot, n); break;
+                        case OP_TAN: TanKernel(padfA, padfSlot, n); break;
+                        case OP_ASIN: AsinKernel(padfA, padfSlot, n); break;
+                        case OP_ACOS: AcosKernel(padfA, padfSlot, n); break;
+                        case OP_ATAN: AtanKernel(padfA, padfSlot, n); break;
+                        case OP_FLOOR: FloorKernel(padfA, padfSlot, n); break;
+                        case OP_CEIL: CeilKernel(padfA, padfSlot, n); break;
+                        default: RoundKernel(padfA, padfSlot, n); break;
+                    }
+                    apdfStack[nTop - 1] = padfSlot;
+                    break;
+                }
+
+                default:
+                {
+                    // Binary operators.
+                    double *padfSlot = padfWork + (nTop - 2) * CHUNK_SIZE;
+                    const double *padfA = apdfStack[nTop - 2];
+                    const double *padfB = apdfStack[nTop - 1];
+                    switch( sInstr.eOp )
+                    {
+                        case OP_ADD: AddKernel(padfA, padfB, padfSlot, n); break;
+                        case OP_SUB: SubKernel(padfA, padfB, padfSlot, n); break;
+                        case OP_MUL: MulKernel(padfA, padfB, padfSlot, n); break;
+                        case OP_DIV: DivKernel(padfA, padfB, padfSlot, n); break;
+                        case OP_MOD: ModKernel(padfA, padfB, padfSlot, n); break;
+                        case OP_POW: PowKernel(padfA, padfB, padfSlot, n); break;
+                        case OP_ATAN2:
+                            Atan2Kernel(padfA, padfB, padfSlot, n); break;
+                        case OP_MIN: MinKernel(padfA, padfB, padfSlot, n); break;
+                        case OP_MAX: MaxKernel(padfA, padfB, padfSlot, n); break;
+                        case OP_EQ: EqKernel(padfA, padfB, padfSlot, n); break;
+                        case OP_NE: NeKernel(padfA, padfB, padfSlot, n); break;
+                        case OP_LT: LtKernel(padfA, padfB, padfSlot, n); break;
+                        case OP_LE: LeKernel(padfA, padfB, padfSlot, n); break;
+                        case OP_GT: GtKernel(padfA, padfB, padfSlot, n); break;
+                        case OP_GE: GeKernel(padfA, padfB, padfSlot, n); break;
+                        case OP_AND: AndKernel(padfA, padfB, padfSlot, n); break;
+                        default: OrKernel(padfA, padfB, padfSlot, n); break;
+                    }
+                    nTop--;
+                    apdfStack[nTop - 1] = padfSlot;
+                    break;
+                }
+            }
+        }
+
+        CPLAssert( nTop == 1 );
+        double *padfChunkOut = padfOut + iStart;
+        memcpy( padfChunkOut, apdfStack[0], n * sizeof(double) );
+
+/* -------------------------------------------------------------------- */
+/*      Propagate nodata.                                               */
+/* -------------------------------------------------------------------- */
+        if( bHasNoData )
+        {
+            for( size_t iSrc = 0; iSrc < m_anUsedSources.size(); iSrc++ )
+            {
+                const double *padfSrc =
+                    papadfSources[m_anUsedSources[iSrc]] + iStart;
+                for( int i = 0; i < n; i++ )
+                {
+                    if( padfSrc[i] == dfNoData || CPLIsNan(padfSrc[i]) )
+                        padfChunkOut[i] = dfNoData;
+                }
+            }
+            for( int i = 0; i < n; i++ )
+            {
+                if( CPLIsNan(padfChunkOut[i]) )
+                    padfChunkOut[i] = dfNoData;
+            }
+        }
+    }
+}
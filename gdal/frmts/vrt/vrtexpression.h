@@ -0,0 +1,130 @@
+/******************************************************************************
+ * $Id$
+ *
+ * Project:  Virtual GDAL Datasets
+ * Purpose:  Band math expressions for derived bands.
+ * Author:   agent <agent at local>
+ *
+ ******************************************************************************
+ * Copyright (c) 2026, agent <agent at local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ****************************************************************************/
+
+#ifndef VRTEXPRESSION_H_INCLUDED
+#define VRTEXPRESSION_H_INCLUDED
+
+#ifndef DOXYGEN_SKIP
+
+#include "cpl_string.h"
+
+#include <vector>
+
+/************************************************************************/
+/*                            VRTExpression                             */
+/*                                                                      */
+/*      Band math expression, such as "(B2-B1)/(B2+B1)", where Bn is    */
+/*      the value of the n-th source of the derived band. It is parsed  */
+/*      once into a postfix program, that is then evaluated on arrays   */
+/*      of values, one operator at a time over chunks of pixels.        */
+/************************************************************************/
+
+class VRTExpression
+{
+  public:
+    /* Number of values processed by each operator at once */
+    static const int CHUNK_SIZE = 256;
+
+    enum OpCode
+    {
+        OP_SOURCE,
+        OP_CONSTANT,
+        OP_NEG,
+        OP_NOT,
+        OP_ABS,
+        OP_SQRT,
+        OP_EXP,
+        OP_LOG,
+        OP_LOG10,
+        OP_SIN,
+        OP_COS,
+        OP_TAN,
+        OP_ASIN,
+        OP_ACOS,
+        OP_ATAN,
+        OP_FLOOR,
+        OP_CEIL,
+        OP_ROUND,
+        OP_ADD,
+        OP_SUB,
+        OP_MUL,
+        OP_DIV,
+        OP_MOD,
+        OP_POW,
+        OP_ATAN2,
+        OP_MIN,
+        OP_MAX,
+        OP_EQ,
+        OP_NE,
+        OP_LT,
+        OP_LE,
+        OP_GT,
+        OP_GE,
+        OP_AND,
+        OP_OR,
+        OP_SELECT
+    };
+
+    struct Instruction
+    {
+        OpCode eOp;
+        int    iSource;
+        double dfValue;
+    };
+
+  private:
+    CPLString                m_osExpression;
+    int                      m_nSources;
+    std::vector<Instruction> m_aoProgram;
+    std::vector<int>         m_anUsedSources;
+    int                      m_nStackDepth;
+
+    friend class VRTExpressionParser;
+
+                VRTExpression();
+
+  public:
+    static VRTExpression *Compile( const char *pszExpression, int nSources );
+    static bool IsBuiltinFunction( const char *pszName );
+    static bool GetBuiltinFunction( const char *pszName, int nSources,
+                                    CPLString &osExpression );
+
+    const CPLString &GetExpression() const { return m_osExpression; }
+    int         GetSourceCount() const { return m_nSources; }
+
+    size_t      GetWorkBufferSize() const;
+    void        Evaluate( const double * const *papadfSources,
+                          int nValues,
+                          int bHasNoData, double dfNoData,
+                          double *padfOut, double *padfWork ) const;
+};
+
+#endif /* #ifndef DOXYGEN_SKIP */
+
+#endif /* VRTEXPRESSION_H_INCLUDED */
@@ -32,6 +32,9 @@
 #include "cpl_port.h"
 #include "cpl_string.h"
 #include "vrtdataset.h"
+#include "gdalsse_priv.h"
+
+#include <cmath>
 
 CPL_CVSID("$Id$");
 
@@ -395,7 +398,10 @@ VRTFilteredSource::RasterIO( int nXOff, int nYOff, int nXSize, int nYSize,
 
 VRTKernelFilteredSource::VRTKernelFilteredSource() :
     m_nKernelSize(0),
+    m_bSeparable(false),
     m_padfKernelCoefs(NULL),
+    m_padfSeparableCoefs(NULL),
+    m_dfKernelSum(0.0),
     m_bNormalized(FALSE)
 {
     GDALDataType aeSupTypes[] = { GDT_Float32 };
@@ -410,6 +416,7 @@ VRTKernelFilteredSource::~VRTKernelFilteredSource()
 
 {
     CPLFree( m_padfKernelCoefs );
+    CPLFree( m_padfSeparableCoefs );
 }
 
 /************************************************************************/
@@ -429,6 +436,24 @@ void VRTKernelFilteredSource::SetNormalized( int bNormalizedIn )
 CPLErr VRTKernelFilteredSource::SetKernel( int nNewKernelSize,
                                            double *padfNewCoefs )
 
+{
+    return SetKernel( nNewKernelSize, false, padfNewCoefs );
+}
+
+/**
+ * Set the filtering kernel.
+ *
+ * @param nNewKernelSize kernel size, which must be an odd number.
+ * @param bSeparable if true, padfNewCoefs contains nNewKernelSize values
+ * that are applied along both axis (the equivalent 2D kernel being their
+ * outer product). Otherwise it contains nNewKernelSize * nNewKernelSize values.
+ * @param padfNewCoefs kernel coefficients.
+ */
+
+CPLErr VRTKernelFilteredSource::SetKernel( int nNewKernelSize,
+                                           bool bSeparable,
+                                           double *padfNewCoefs )
+
 {
     if( nNewKernelSize < 1 || (nNewKernelSize % 2) != 1 )
     {
@@ -440,12 +465,42 @@ CPLErr VRTKernelFilteredSource::SetKernel( int nNewKernelSize,
     }
 
     CPLFree( m_padfKernelCoefs );
+    CPLFree( m_padfSeparableCoefs );
+    m_padfSeparableCoefs = NULL;
     m_nKernelSize = nNewKernelSize;
+    m_bSeparable = bSeparable;
 
     m_padfKernelCoefs = static_cast<double *>(
         CPLMalloc(sizeof(double) * m_nKernelSize * m_nKernelSize ) );
-    memcpy( m_padfKernelCoefs, padfNewCoefs,
-            sizeof(double) * m_nKernelSize * m_nKernelSize );
+    if( bSeparable )
+    {
+        m_padfSeparableCoefs = static_cast<double *>(
+            CPLMalloc(sizeof(double) * 2 * m_nKernelSize ) );
+        memcpy( m_padfSeparableCoefs, padfNewCoefs,
+                sizeof(double) * m_nKernelSize );
+        memcpy( m_padfSeparableCoefs + m_nKernelSize, padfNewCoefs,
+                sizeof(double) * m_nKernelSize );
+        for( int i = 0; i < m_nKernelSize; i++ )
+        {
+            for( int j = 0; j < m_nKernelSize; j++ )
+            {
+                m_padfKernelCoefs[i * m_nKernelSize + j] =
+                    padfNewCoefs[i] * padfNewCoefs[j];
+            }
+        }
+    }
+    else
+    {
+        memcpy( m_padfKernelCoefs, padfNewCoefs,
+                sizeof(double) * m_nKernelSize * m_nKernelSize );
+        DetectSeparableKernel();
+    }
+
+    // Summed in the same order as in the loop of FilterDataFull(), so that
+    // normalized results do not depend on the code path.
+    m_dfKernelSum = 0.0;
+    for( int i = 0; i < m_nKernelSize * m_nKernelSize; i++ )
+        m_dfKernelSum += m_padfKernelCoefs[i];
 
     SetExtraEdgePixels( (nNewKernelSize - 1) / 2 );
 
@@ -453,99 +508,351 @@ CPLErr VRTKernelFilteredSource::SetKernel( int nNewKernelSize,
 }
 
 /************************************************************************/
-/*                             FilterData()                             */
+/*                       DetectSeparableKernel()                        */
+/*                                                                      */
+/*      Check if the 2D kernel is the outer product of a vertical and   */
+/*      an horizontal 1D kernel, in which case it can be applied as     */
+/*      two 1D passes (2 * N instead of N * N operations per pixel).    */
 /************************************************************************/
 
-CPLErr VRTKernelFilteredSource::FilterData( int nXSize, int nYSize,
-                                            GDALDataType eType,
-                                            GByte *pabySrcData,
-                                            GByte *pabyDstData )
+void VRTKernelFilteredSource::DetectSeparableKernel()
+
+{
+    const int nSize = m_nKernelSize;
+    if( nSize < 3 )
+        return;
+
+    // Use the coefficient of largest magnitude as the pivot.
+    int iPivot = 0;
+    for( int i = 1; i < nSize * nSize; i++ )
+    {
+        if( fabs(m_padfKernelCoefs[i]) > fabs(m_padfKernelCoefs[iPivot]) )
+            iPivot = i;
+    }
+    const double dfPivot = m_padfKernelCoefs[iPivot];
+    if( dfPivot == 0.0 )
+        return;
+    const int iPivotRow = iPivot / nSize;
+    const int iPivotCol = iPivot % nSize;
+
+    double *padfCoefs = static_cast<double *>(
+        CPLMalloc( sizeof(double) * 2 * nSize ) );
+    double *padfVert = padfCoefs;
+    double *padfHorz = padfCoefs + nSize;
+    for( int i = 0; i < nSize; i++ )
+    {
+        padfVert[i] = m_padfKernelCoefs[i * nSize + iPivotCol] / dfPivot;
+        padfHorz[i] = m_padfKernelCoefs[iPivotRow * nSize + i];
+    }
+
+    const double dfTolerance = fabs(dfPivot) * 1e-10;
+    for( int i = 0; i < nSize; i++ )
+    {
+        for( int j = 0; j < nSize; j++ )
+        {
+            if( fabs( m_padfKernelCoefs[i * nSize + j] -
+                      padfVert[i] * padfHorz[j] ) > dfTolerance )
+            {
+                CPLFree( padfCoefs );
+                return;
+            }
+        }
+    }
+
+    CPLDebug( "VRT", "%dx%d kernel is separable", nSize, nSize );
+    m_padfSeparableCoefs = padfCoefs;
+}
+
+/************************************************************************/
+/*                         FilterPixelFull()                            */
+/************************************************************************/
+
+static float FilterPixelFull( int iX, int iY, int nLineSize, int nKernelSize,
+                              const double *padfKernelCoefs,
+                              int bNormalized,
+                              const float *pafSrcData,
+                              int bHasNoData, float fNoData )
+{
+    int iKern = 0;
+    double dfSum = 0.0;
+    double dfKernSum = 0.0;
+
+    for( int iYY = 0; iYY < nKernelSize; iYY++ )
+    {
+        const float *pafData = pafSrcData + (iY+iYY) * nLineSize + iX;
+
+        for( int i = 0; i < nKernelSize; i++, pafData++, iKern++ )
+        {
+            if( !bHasNoData || *pafData != fNoData )
+            {
+                dfSum += *pafData * padfKernelCoefs[iKern];
+                dfKernSum += padfKernelCoefs[iKern];
+            }
+        }
+    }
+    if( bNormalized )
+    {
+        if( dfKernSum != 0.0 )
+            return static_cast<float>( dfSum / dfKernSum );
+        return 0.0f;
+    }
+    return static_cast<float>( dfSum );
+}
+
+/************************************************************************/
+/*                           FilterDataFull()                           */
+/************************************************************************/
+
+void VRTKernelFilteredSource::FilterDataFull( int nXSize, int nYSize,
+                                              const float *pafSrcData,
+                                              float *pafDstData,
+                                              int bHasNoData, float fNoData )
 
 {
+    const int nLineSize = nXSize + 2 * m_nExtraEdgePixels;
+
+    for( int iY = 0; iY < nYSize; iY++ )
+    {
+        for( int iX = 0; iX < nXSize; iX++ )
+        {
+            const int iIndex =
+                ( iY + m_nKernelSize / 2 ) * nLineSize
+                + iX + m_nKernelSize / 2;
+            const float fCenter = pafSrcData[iIndex];
+
+            // Check if center srcpixel is NoData
+            if( !bHasNoData || fCenter != fNoData )
+            {
+                pafDstData[iX + iY * nXSize] =
+                    FilterPixelFull( iX, iY, nLineSize, m_nKernelSize,
+                                     m_padfKernelCoefs, m_bNormalized,
+                                     pafSrcData, bHasNoData, fNoData );
+            }
+            else
+            {
+                pafDstData[iX + iY * nXSize] = fNoData;
+            }
+        }
+    }
+}
+
+/************************************************************************/
+/*                        FilterDataSeparable()                         */
+/*                                                                      */
+/*      Apply the kernel as an horizontal pass, in a temporary buffer   */
+/*      of doubles, followed by a vertical pass. Both passes process    */
+/*      4 pixels at a time with SSE2. Pixels whose neighbourhood        */
+/*      contains nodata values are recomputed with the 2D kernel.       */
+/************************************************************************/
+
+void VRTKernelFilteredSource::FilterDataSeparable( int nXSize, int nYSize,
+                                                   const float *pafSrcData,
+                                                   float *pafDstData,
+                                                   int bHasNoData,
+                                                   float fNoData )
+
+{
+    const int nSize = m_nKernelSize;
+    const int nLineSize = nXSize + 2 * m_nExtraEdgePixels;
+    const int nTmpYSize = nYSize + 2 * m_nExtraEdgePixels;
+    const double *padfVert = m_padfSeparableCoefs;
+    const double *padfHorz = m_padfSeparableCoefs + nSize;
+
 /* -------------------------------------------------------------------- */
-/*      Validate data type.                                             */
+/*      Horizontal pass.                                                */
 /* -------------------------------------------------------------------- */
-    if( eType != GDT_Float32 )
+    double *padfTmp = static_cast<double *>(
+        VSI_MALLOC3_VERBOSE( sizeof(double), nXSize, nTmpYSize ) );
+    if( padfTmp == NULL )
     {
-        CPLError( CE_Failure, CPLE_AppDefined,
-                  "Unsupported data type (%s) in "
-                  "VRTKernelFilteredSource::FilterData()",
-                  GDALGetDataTypeName( eType ) );
-        return CE_Failure;
+        FilterDataFull( nXSize, nYSize, pafSrcData, pafDstData,
+                        bHasNoData, fNoData );
+        return;
     }
 
-    CPLAssert( m_nExtraEdgePixels*2 + 1 == m_nKernelSize ||
-               (m_nKernelSize == 0 && m_nExtraEdgePixels == 0) );
+    for( int iY = 0; iY < nTmpYSize; iY++ )
+    {
+        const float *pafLine = pafSrcData + static_cast<size_t>(iY) * nLineSize;
+        double *padfTmpLine = padfTmp + static_cast<size_t>(iY) * nXSize;
+        int iX = 0;
+        for( ; iX + 4 <= nXSize; iX += 4 )
+        {
+            XMMReg4Double oSum = XMMReg4Double::Zero();
+            for( int i = 0; i < nSize; i++ )
+            {
+                oSum += XMMReg4Double::Load1ValHighAndLow(padfHorz + i) *
+                        XMMReg4Double::Load4Val(pafLine + iX + i);
+            }
+            oSum.low.Store2Double(padfTmpLine + iX);
+            oSum.high.Store2Double(padfTmpLine + iX + 2);
+        }
+        for( ; iX < nXSize; iX++ )
+        {
+            double dfSum = 0.0;
+            for( int i = 0; i < nSize; i++ )
+                dfSum += padfHorz[i] * pafLine[iX + i];
+            padfTmpLine[iX] = dfSum;
+        }
+    }
 
 /* -------------------------------------------------------------------- */
-/*      Float32 case.                                                   */
+/*      Vertical pass.                                                  */
 /* -------------------------------------------------------------------- */
-    if( eType == GDT_Float32 )
+    const double dfScale = m_bNormalized ? m_dfKernelSum : 1.0;
+    const XMMReg4Double oScale = XMMReg4Double::Load1ValHighAndLow(&dfScale);
+
+    for( int iY = 0; iY < nYSize; iY++ )
     {
-        int bHasNoData = FALSE;
-        const float fNoData =
-            static_cast<float>( m_poRasterBand->GetNoDataValue(&bHasNoData) );
+        float *pafDstLine = pafDstData + static_cast<size_t>(iY) * nXSize;
+        int iX = 0;
+        for( ; iX + 4 <= nXSize; iX += 4 )
+        {
+            XMMReg4Double oSum = XMMReg4Double::Zero();
+            for( int i = 0; i < nSize; i++ )
+            {
+                oSum += XMMReg4Double::Load1ValHighAndLow(padfVert + i) *
+                        XMMReg4Double::Load4Val(
+                            padfTmp + static_cast<size_t>(iY + i) * nXSize + iX);
+            }
+            double adfRes[4];
+            if( dfScale != 1.0 && dfScale != 0.0 )
+                oSum = oSum / oScale;
+            oSum.low.Store2Double(adfRes);
+            oSum.high.Store2Double(adfRes + 2);
+            for( int j = 0; j < 4; j++ )
+            {
+                pafDstLine[iX + j] =
+                    dfScale == 0.0 ? 0.0f : static_cast<float>( adfRes[j] );
+            }
+        }
+        for( ; iX < nXSize; iX++ )
+        {
+            double dfSum = 0.0;
+            for( int i = 0; i < nSize; i++ )
+            {
+                dfSum += padfVert[i] *
+                         padfTmp[static_cast<size_t>(iY + i) * nXSize + iX];
+            }
+            if( dfScale == 0.0 )
+                pafDstLine[iX] = 0.0f;
+            else if( dfScale != 1.0 )
+                pafDstLine[iX] = static_cast<float>( dfSum / dfScale );
+            else
+                pafDstLine[iX] = static_cast<float>( dfSum );
+        }
+    }
 
-        for( int iY = 0; iY < nYSize; iY++ )
+/* -------------------------------------------------------------------- */
+/*      Fix pixels that have nodata values in their neighbourhood.      */
+/*      The count of nodata values in the window of each pixel is       */
+/*      itself computed with two 1D passes.                             */
+/* -------------------------------------------------------------------- */
+    if( bHasNoData )
+    {
+        int *panCount = reinterpret_cast<int *>( padfTmp );
+        bool bFoundNoData = false;
+        for( int iY = 0; iY < nTmpYSize; iY++ )
         {
+            const float *pafLine =
+                pafSrcData + static_cast<size_t>(iY) * nLineSize;
+            int *panCountLine = panCount + static_cast<size_t>(iY) * nXSize;
+            int nCount = 0;
+            for( int i = 0; i < nSize - 1; i++ )
+                nCount += ( pafLine[i] == fNoData ) ? 1 : 0;
             for( int iX = 0; iX < nXSize; iX++ )
             {
-                const int iIndex =
-                    ( iY + m_nKernelSize / 2 ) *
-                    ( nXSize + 2 * m_nExtraEdgePixels )
-                    + iX + m_nKernelSize / 2;
-                const float fCenter =
-                    reinterpret_cast<float *>( pabySrcData )[iIndex];
-
-                float fResult = 0.0;
+                nCount += ( pafLine[iX + nSize - 1] == fNoData ) ? 1 : 0;
+                panCountLine[iX] = nCount;
+                if( nCount != 0 )
+                    bFoundNoData = true;
+                nCount -= ( pafLine[iX] == fNoData ) ? 1 : 0;
+            }
+        }
 
-                // Check if center srcpixel is NoData
-                if( !bHasNoData || fCenter != fNoData )
+        if( bFoundNoData )
+        {
+            for( int iY = 0; iY < nYSize; iY++ )
+            {
+                for( int iX = 0; iX < nXSize; iX++ )
                 {
-                    int iKern = 0;
-                    double dfSum = 0.0;
-                    double dfKernSum = 0.0;
-
-                    for( int iYY = 0; iYY < m_nKernelSize; iYY++ )
+                    int nCount = 0;
+                    for( int i = 0; i < nSize; i++ )
                     {
-                        float *pafData =
-                            reinterpret_cast<float *>( pabySrcData )
-                            + (iY+iYY) * (nXSize+2*m_nExtraEdgePixels) + iX;
-
-                        for( int i = 0; i < m_nKernelSize; i++, pafData++,
-                             iKern++ )
-                        {
-                            if( !bHasNoData || *pafData != fNoData )
-                            {
-                                dfSum += *pafData * m_padfKernelCoefs[iKern];
-                                dfKernSum += m_padfKernelCoefs[iKern];
-                            }
-                        }
+                        nCount += panCount[static_cast<size_t>(iY + i) *
+                                           nXSize + iX];
                     }
-                    if( m_bNormalized )
+                    if( nCount == 0 )
+                        continue;
+
+                    const float fCenter =
+                        pafSrcData[static_cast<size_t>(iY + nSize / 2) *
+                                   nLineSize + iX + nSize / 2];
+                    if( fCenter == fNoData )
                     {
-                        if( dfKernSum != 0.0 )
-                            fResult = static_cast<float>( dfSum / dfKernSum );
-                        else
-                            fResult = 0.0;
+                        pafDstData[iX + iY * nXSize] = fNoData;
                     }
                     else
                     {
-                        fResult = static_cast<float>( dfSum );
+                        pafDstData[iX + iY * nXSize] =
+                            FilterPixelFull( iX, iY, nLineSize, nSize,
+                                             m_padfKernelCoefs, m_bNormalized,
+                                             pafSrcData, TRUE, fNoData );
                     }
-
-                    reinterpret_cast<float *>( pabyDstData )[iX + iY * nXSize] =
-                        fResult;
-                }
-                else
-                {
-                    reinterpret_cast<float *>( pabyDstData )[iX + iY * nXSize] =
-                        fNoData;
                 }
             }
         }
     }
 
+    CPLFree( padfTmp );
+}
+
+/************************************************************************/
+/*                             FilterData()                             */
+/************************************************************************/
+
+CPLErr VRTKernelFilteredSource::FilterData( int nXSize, int nYSize,
+                                            GDALDataType eType,
+                                            GByte *pabySrcData,
+                                            GByte *pabyDstData )
+
+{
+/* -------------------------------------------------------------------- */
+/*      Validate data type.                                             */
+/* -------------------------------------------------------------------- */
+    if( eType != GDT_Float32 )
+    {
+        CPLError( CE_Failure, CPLE_AppDefined,
+                  "Unsupported data type (%s) in "
+                  "VRTKernelFilteredSource::FilterData()",
+                  GDALGetDataTypeName( eType ) );
+        return CE_Failure;
+    }
+
+    CPLAssert( m_nExtraEdgePixels*2 + 1 == m_nKernelSize ||
+               (m_nKernelSize == 0 && m_nExtraEdgePixels == 0) );
+
+/* -------------------------------------------------------------------- */
+/*      Float32 case.                                                   */
+/* -------------------------------------------------------------------- */
+    int bHasNoData = FALSE;
+    const float fNoData =
+        static_cast<float>( m_poRasterBand->GetNoDataValue(&bHasNoData) );
+
+    if( m_padfSeparableCoefs != NULL )
+    {
+        FilterDataSeparable( nXSize, nYSize,
+                             reinterpret_cast<float *>( pabySrcData ),
+                             reinterpret_cast<float *>( pabyDstData ),
+                             bHasNoData, fNoData );
+    }
+    else
+    {
+        FilterDataFull( nXSize, nYSize,
+                        reinterpret_cast<float *>( pabySrcData ),
+                        reinterpret_cast<float *>( pabyDstData ),
+                        bHasNoData, fNoData );
+    }
+
     return CE_None;
 }
 
@@ -573,14 +880,17 @@ CPLErr VRTKernelFilteredSource::XMLInit( CPLXMLNode *psTree,
 
     const int nCoefs = CSLCount(papszCoefItems);
 
-    if( nCoefs != nNewKernelSize * nNewKernelSize )
+    // A separable kernel is declared by only giving Size coefficients.
+    const bool bSeparable = nCoefs == nNewKernelSize && nNewKernelSize > 1;
+
+    if( nCoefs != nNewKernelSize * nNewKernelSize && !bSeparable )
     {
         CSLDestroy( papszCoefItems );
         CPLError( CE_Failure, CPLE_AppDefined,
                   "Got wrong number of filter kernel coefficients (%s).  "
-                  "Expected %d, got %d.",
+                  "Expected %d or %d, got %d.",
                   CPLGetXMLValue(psTree,"Kernel.Coefs",""),
-                  nNewKernelSize * nNewKernelSize, nCoefs );
+                  nNewKernelSize * nNewKernelSize, nNewKernelSize, nCoefs );
         return CE_Failure;
     }
 
@@ -590,7 +900,7 @@ CPLErr VRTKernelFilteredSource::XMLInit( CPLXMLNode *psTree,
     for( int i = 0; i < nCoefs; i++ )
         padfNewCoefs[i] = CPLAtof(papszCoefItems[i]);
 
-    const CPLErr eErr = SetKernel( nNewKernelSize, padfNewCoefs );
+    const CPLErr eErr = SetKernel( nNewKernelSize, bSeparable, padfNewCoefs );
 
     CPLFree( padfNewCoefs );
     CSLDestroy( papszCoefItems );
@@ -629,7 +939,10 @@ CPLXMLNode *VRTKernelFilteredSource::SerializeToXML( const char *pszVRTPath )
             CPLCreateXMLNode( psKernel, CXT_Attribute, "normalized" ),
             CXT_Text, "0" );
 
-    const int nCoefCount = m_nKernelSize * m_nKernelSize;
+    const int nCoefCount =
+        m_bSeparable ? m_nKernelSize : m_nKernelSize * m_nKernelSize;
+    const double *padfCoefs =
+        m_bSeparable ? m_padfSeparableCoefs : m_padfKernelCoefs;
     const size_t nBufLen = nCoefCount * 32;
     char *pszKernelCoefs = static_cast<char *>( CPLMalloc(nBufLen) );
 
@@ -637,7 +950,7 @@ CPLXMLNode *VRTKernelFilteredSource::SerializeToXML( const char *pszVRTPath )
     for( int iCoef = 0; iCoef < nCoefCount; iCoef++ )
         CPLsnprintf( pszKernelCoefs + strlen(pszKernelCoefs),
                      nBufLen - strlen(pszKernelCoefs),
-                     "%.8g ", m_padfKernelCoefs[iCoef] );
+                     "%.8g ", padfCoefs[iCoef] );
 
     CPLSetXMLValue( psKernel, "Size", CPLSPrintf( "%d", m_nKernelSize ) );
     CPLSetXMLValue( psKernel, "Coefs", pszKernelCoefs );
@@ -30,8 +30,14 @@
 
 #include "cpl_minixml.h"
 #include "cpl_string.h"
+#include "cpl_worker_thread_pool.h"
 
 #include "vrtdataset.h"
+
+#include <algorithm>
+#include <map>
+#include <vector>
+
 CPL_CVSID("$Id$");
 
 /************************************************************************/
@@ -47,6 +53,8 @@ CPL_CVSID("$Id$");
 VRTSourcedRasterBand::VRTSourcedRasterBand( GDALDataset *poDSIn, int nBandIn ) :
     m_nRecursionCounter(0),
     m_papszSourceList(NULL),
+    m_hSourcesIndex(NULL),
+    m_bSourcesIndexChecked(false),
     nSources(0),
     papoSources(NULL),
     bEqualAreas(FALSE)
@@ -66,6 +74,8 @@ VRTSourcedRasterBand::VRTSourcedRasterBand( GDALDataType eType,
                                             int nXSize, int nYSize ) :
     m_nRecursionCounter(0),
     m_papszSourceList(NULL),
+    m_hSourcesIndex(NULL),
+    m_bSourcesIndexChecked(false),
     nSources(0),
     papoSources(NULL),
     bEqualAreas(FALSE)
@@ -84,6 +94,8 @@ VRTSourcedRasterBand::VRTSourcedRasterBand( GDALDataset *poDSIn, int nBandIn,
                                             int nXSize, int nYSize ) :
     m_nRecursionCounter(0),
     m_papszSourceList(NULL),
+    m_hSourcesIndex(NULL),
+    m_bSourcesIndexChecked(false),
     nSources(0),
     papoSources(NULL),
     bEqualAreas(FALSE)
@@ -105,6 +117,430 @@ VRTSourcedRasterBand::~VRTSourcedRasterBand()
 {
     CloseDependentDatasets();
     CSLDestroy(m_papszSourceList);
+    InvalidateSourcesIndex();
+}
+
+/************************************************************************/
+/*                       InvalidateSourcesIndex()                       */
+/************************************************************************/
+
+void VRTSourcedRasterBand::InvalidateSourcesIndex()
+
+{
+    if( m_hSourcesIndex != NULL )
+        CPLPackedRTreeDestroy( m_hSourcesIndex );
+    m_hSourcesIndex = NULL;
+    m_bSourcesIndexChecked = false;
+}
+
+/************************************************************************/
+/*                         GetSourceDstBounds()                         */
+/*                                                                      */
+/*      Bounds of the destination window of a source, if it is a        */
+/*      simple source with an explicit destination window.              */
+/************************************************************************/
+
+static bool GetSourceDstBounds( VRTSource *poSource, CPLRectObj *psBounds )
+
+{
+    if( !poSource->IsSimpleSource() )
+        return false;
+    VRTSimpleSource * const poSimpleSource =
+        reinterpret_cast<VRTSimpleSource *>( poSource );
+    double dfXOff = 0.0;
+    double dfYOff = 0.0;
+    double dfXSize = 0.0;
+    double dfYSize = 0.0;
+    if( !poSimpleSource->GetDstWindow( &dfXOff, &dfYOff,
+                                       &dfXSize, &dfYSize ) ||
+        CPLIsNan(dfXOff) || CPLIsNan(dfYOff) ||
+        CPLIsNan(dfXSize) || CPLIsNan(dfYSize) )
+        return false;
+    psBounds->minx = std::min(dfXOff, dfXOff + dfXSize);
+    psBounds->maxx = std::max(dfXOff, dfXOff + dfXSize);
+    psBounds->miny = std::min(dfYOff, dfYOff + dfYSize);
+    psBounds->maxy = std::max(dfYOff, dfYOff + dfYSize);
+    return true;
+}
+
+/************************************************************************/
+/*                         GetSourcesInWindow()                         */
+/*                                                                      */
+/*      Return the indices, in increasing order, of the sources whose   */
+/*      destination window intersects the passed window, so that        */
+/*      overlapping sources are still composited in their declaration   */
+/*      order. The spatial index is built on first use when the band    */
+/*      has many sources. NULL is returned when no index is available,  */
+/*      in which case the caller must iterate over all sources.         */
+/************************************************************************/
+
+int *VRTSourcedRasterBand::GetSourcesInWindow( int nXOff, int nYOff,
+                                               int nXSize, int nYSize,
+                                               int *pnCount )
+
+{
+    if( !m_bSourcesIndexChecked )
+    {
+        m_bSourcesIndexChecked = true;
+
+        const char* pszIndex = CPLGetConfigOption("VRT_SOURCES_INDEX", NULL);
+        bool bBuild = nSources >= 64;
+        if( pszIndex != NULL )
+            bBuild = nSources > 0 && CPLTestBool(pszIndex);
+
+        CPLRectObj* pasBounds = NULL;
+        if( bBuild )
+        {
+            pasBounds = static_cast<CPLRectObj *>(
+                VSI_MALLOC2_VERBOSE( nSources, sizeof(CPLRectObj) ) );
+            if( pasBounds == NULL )
+                bBuild = false;
+        }
+
+        // Only sources with an explicit destination window can be indexed.
+        for( int iSource = 0; bBuild && iSource < nSources; iSource++ )
+        {
+            if( !GetSourceDstBounds( papoSources[iSource],
+                                     &pasBounds[iSource] ) )
+                bBuild = false;
+        }
+
+        if( bBuild )
+        {
+            m_hSourcesIndex =
+                CPLPackedRTreeCreateWithBounds( nSources, NULL, pasBounds,
+                                                CPLPRT_ORDER_STR, 0 );
+            CPLDebug( "VRT", "Built spatial index over %d sources of band %d",
+                      nSources, nBand );
+        }
+        CPLFree( pasBounds );
+    }
+
+    if( m_hSourcesIndex == NULL )
+        return NULL;
+
+    CPLRectObj sAoi;
+    sAoi.minx = nXOff;
+    sAoi.miny = nYOff;
+    sAoi.maxx = static_cast<double>(nXOff) + nXSize;
+    sAoi.maxy = static_cast<double>(nYOff) + nYSize;
+    *pnCount = 0;
+    int* panIndices =
+        CPLPackedRTreeSearchIndices( m_hSourcesIndex, &sAoi, pnCount );
+    // No intersecting source: return an empty, but non NULL, list.
+    if( panIndices == NULL )
+        panIndices = static_cast<int *>( CPLMalloc( sizeof(int) ) );
+    return panIndices;
+}
+
+/************************************************************************/
+/*                          GetSourcesInBand()                          */
+/*                                                                      */
+/*      Return the indices, in increasing order, of the sources that    */
+/*      may contribute to the band, skipping the ones whose destination */
+/*      window is entirely outside of it. The same test as the spatial  */
+/*      index is done when the index is not available, so that the      */
+/*      min/max computations do not depend on whether it is built.      */
+/************************************************************************/
+
+int *VRTSourcedRasterBand::GetSourcesInBand( int *pnCount )
+
+{
+    int* panSelected =
+        GetSourcesInWindow( 0, 0, nRasterXSize, nRasterYSize, pnCount );
+    if( panSelected != NULL )
+        return panSelected;
+
+    panSelected = static_cast<int *>(
+        CPLMalloc( sizeof(int) * std::max(1, nSources) ) );
+    *pnCount = 0;
+    for( int iSource = 0; iSource < nSources; iSource++ )
+    {
+        CPLRectObj sBounds;
+        if( GetSourceDstBounds( papoSources[iSource], &sBounds ) &&
+            (sBounds.minx > nRasterXSize || sBounds.maxx < 0 ||
+             sBounds.miny > nRasterYSize || sBounds.maxy < 0) )
+            continue;
+        panSelected[(*pnCount)++] = iSource;
+    }
+    return panSelected;
+}
+
+/************************************************************************/
+/*                           VRTSourcesJob                              */
+/************************************************************************/
+
+// Sources that read from the same underlying dataset, and that must thus
+// be processed sequentially by the same thread.
+struct VRTSourcesJob
+{
+    std::vector<VRTSource*> apoSources;
+    int                     nXOff;
+    int                     nYOff;
+    int                     nXSize;
+    int                     nYSize;
+    void                   *pData;
+    int                     nBufXSize;
+    int                     nBufYSize;
+    GDALDataType            eBufType;
+    GSpacing                nPixelSpace;
+    GSpacing                nLineSpace;
+    GDALRasterIOExtraArg    sExtraArg;
+    CPLErr                  eErr;
+};
+
+// Part of the output buffer written by a source.
+struct VRTSourceOutWindow
+{
+    int nX1;
+    int nY1;
+    int nX2;
+    int nY2;
+    int iJob;
+
+    bool operator<( const VRTSourceOutWindow& other ) const
+        { return nX1 < other.nX1; }
+};
+
+static void VRTSourcesJobFunc( void* pData )
+{
+    VRTSourcesJob* psJob = static_cast<VRTSourcesJob *>( pData );
+    for( size_t i = 0;
+         psJob->eErr == CE_None && i < psJob->apoSources.size(); i++ )
+    {
+        psJob->eErr = psJob->apoSources[i]->RasterIO(
+            psJob->nXOff, psJob->nYOff, psJob->nXSize, psJob->nYSize,
+            psJob->pData, psJob->nBufXSize, psJob->nBufYSize,
+            psJob->eBufType, psJob->nPixelSpace, psJob->nLineSpace,
+            &(psJob->sExtraArg) );
+    }
+}
+
+/************************************************************************/
+/*                     RasterIOSourcesInParallel()                      */
+/*                                                                      */
+/*      Dispatch the RasterIO() of the selected sources on the thread   */
+/*      pool of the dataset, if there is one. Sources reading from the  */
+/*      same underlying dataset (or through GDALProxyPoolDataset, from  */
+/*      the same file) are grouped in the same job, since a dataset     */
+/*      may not be used by several threads at once. Returns false,      */
+/*      without having done anything, if the sources must be processed  */
+/*      serially: when sources of different jobs write to overlapping   */
+/*      parts of the buffer, for which the source order matters, or     */
+/*      when the source kind does not allow to know what it reads.      */
+/************************************************************************/
+
+bool VRTSourcedRasterBand::RasterIOSourcesInParallel(
+    int nSelected, const int *panSelected,
+    int nXOff, int nYOff, int nXSize, int nYSize,
+    void *pData, int nBufXSize, int nBufYSize,
+    GDALDataType eBufType, GSpacing nPixelSpace, GSpacing nLineSpace,
+    GDALRasterIOExtraArg* psExtraArg, CPLErr *peErr )
+{
+    if( poDS == NULL )
+        return false;
+    CPLWorkerThreadPool* poThreadPool =
+        reinterpret_cast<VRTDataset *>( poDS )->GetThreadPool();
+    if( poThreadPool == NULL )
+        return false;
+
+    std::map<CPLString, int> oMapDatasetToJob;
+    std::vector< std::vector<VRTSource*> > aapoJobSources;
+    std::vector<VRTSourceOutWindow> asWindows;
+    for( int i = 0; i < nSelected; i++ )
+    {
+        const int iSource = panSelected ? panSelected[i] : i;
+        if( !papoSources[iSource]->IsSimpleSource() )
+            return false;
+        VRTSimpleSource * const poSource =
+            reinterpret_cast<VRTSimpleSource *>( papoSources[iSource] );
+        GDALRasterBand* poSrcBand = poSource->GetBand();
+        if( poSrcBand == NULL )
+            return false;
+        GDALDataset* poSrcDS = poSrcBand->GetDataset();
+        if( poSrcDS == NULL )
+            return false;
+
+        // Nested VRTs might read from the same datasets as other sources.
+        const char* pszDesc = poSrcDS->GetDescription();
+        if( (poSrcDS->GetDriver() != NULL &&
+             EQUAL(poSrcDS->GetDriver()->GetDescription(), "VRT")) ||
+            EQUAL(CPLGetExtension(pszDesc), "vrt") ||
+            STARTS_WITH_CI(pszDesc, "<VRTDataset") )
+            return false;
+
+        double dfReqXOff = 0.0;
+        double dfReqYOff = 0.0;
+        double dfReqXSize = 0.0;
+        double dfReqYSize = 0.0;
+        int nReqXOff = 0;
+        int nReqYOff = 0;
+        int nReqXSize = 0;
+        int nReqYSize = 0;
+        int nOutXOff = 0;
+        int nOutYOff = 0;
+        int nOutXSize = 0;
+        int nOutYSize = 0;
+        if( !poSource->GetSrcDstWindow( nXOff, nYOff, nXSize, nYSize,
+                                        nBufXSize, nBufYSize,
+                                        &dfReqXOff, &dfReqYOff,
+                                        &dfReqXSize, &dfReqYSize,
+                                        &nReqXOff, &nReqYOff,
+                                        &nReqXSize, &nReqYSize,
+                                        &nOutXOff, &nOutYOff,
+                                        &nOutXSize, &nOutYSize ) )
+        {
+            // Nothing to read from this source.
+            continue;
+        }
+
+        const CPLString osKey( pszDesc[0] != '\0' ?
+                               CPLString(pszDesc) :
+                               CPLString().Printf("%p", poSrcDS) );
+        std::map<CPLString, int>::const_iterator oIter =
+            oMapDatasetToJob.find(osKey);
+        int iJob = 0;
+        if( oIter == oMapDatasetToJob.end() )
+        {
+            iJob = static_cast<int>(aapoJobSources.size());
+            oMapDatasetToJob[osKey] = iJob;
+            aapoJobSources.push_back( std::vector<VRTSource*>() );
+        }
+        else
+        {
+            iJob = oIter->second;
+        }
+        aapoJobSources[iJob].push_back( poSource );
+
+        VRTSourceOutWindow sWindow;
+        sWindow.nX1 = nOutXOff;
+        sWindow.nY1 = nOutYOff;
+        sWindow.nX2 = nOutXOff + nOutXSize;
+        sWindow.nY2 = nOutYOff + nOutYSize;
+        sWindow.iJob = iJob;
+        asWindows.push_back( sWindow );
+    }
+
+    const int nJobs = static_cast<int>(aapoJobSources.size());
+    if( nJobs < 2 )
+        return false;
+
+    // Check that sources of different jobs write disjoint parts of the
+    // buffer, otherwise their relative order would not be honoured.
+    std::sort( asWindows.begin(), asWindows.end() );
+    for( size_t i = 0; i < asWindows.size(); i++ )
+    {
+        for( size_t j = i + 1;
+             j < asWindows.size() && asWindows[j].nX1 < asWindows[i].nX2;
+             j++ )
+        {
+            if( asWindows[j].iJob != asWindows[i].iJob &&
+                asWindows[j].nY1 < asWindows[i].nY2 &&
+                asWindows[i].nY1 < asWindows[j].nY2 )
+            {
+                return false;
+            }
+        }
+    }
+
+    std::vector<VRTSourcesJob> asJobs( nJobs );
+    std::vector<void*> apJobs;
+    for( int iJob = 0; iJob < nJobs; iJob++ )
+    {
+        VRTSourcesJob& sJob = asJobs[iJob];
+        sJob.apoSources.swap( aapoJobSources[iJob] );
+        sJob.nXOff = nXOff;
+        sJob.nYOff = nYOff;
+        sJob.nXSize = nXSize;
+        sJob.nYSize = nYSize;
+        sJob.pData = pData;
+        sJob.nBufXSize = nBufXSize;
+        sJob.nBufYSize = nBufYSize;
+        sJob.eBufType = eBufType;
+        sJob.nPixelSpace = nPixelSpace;
+        sJob.nLineSpace = nLineSpace;
+        sJob.sExtraArg = *psExtraArg;
+        sJob.sExtraArg.pfnProgress = NULL;
+        sJob.sExtraArg.pProgressData = NULL;
+        sJob.eErr = CE_None;
+        apJobs.push_back( &sJob );
+    }
+
+    if( !poThreadPool->SubmitJobs( VRTSourcesJobFunc, apJobs ) )
+    {
+        // Should not happen, but make sure that no job is still running
+        // before falling back to serial processing.
+        poThreadPool->WaitCompletion();
+        return false;
+    }
+
+    // Report progress, from the calling thread, as jobs complete.
+    for( int iJob = 0; iJob < nJobs; iJob++ )
+    {
+        poThreadPool->WaitCompletion( nJobs - iJob - 1 );
+        if( psExtraArg->pfnProgress != NULL )
+            psExtraArg->pfnProgress( 1.0 * (iJob + 1) / nJobs, "",
+                                     psExtraArg->pProgressData );
+    }
+
+    *peErr = CE_None;
+    for( int iJob = 0; iJob < nJobs; iJob++ )
+    {
+        if( asJobs[iJob].eErr != CE_None )
+            *peErr = asJobs[iJob].eErr;
+    }
+
+    return true;
+}
+
+/************************************************************************/
+/*                       InitializeOutputBuffer()                       */
+/*                                                                      */
+/*      Initialize the buffer of a read request to some background      */
+/*      value. Use the nodata value if available.                       */
+/************************************************************************/
+
+void VRTSourcedRasterBand::InitializeOutputBuffer( void *pData,
+                                                   int nBufXSize,
+                                                   int nBufYSize,
+                                                   GDALDataType eBufType,
+                                                   GSpacing nPixelSpace,
+                                                   GSpacing nLineSpace )
+
+{
+    if( nPixelSpace == GDALGetDataTypeSizeBytes(eBufType) &&
+         (!m_bNoDataValueSet || (!CPLIsNan(m_dfNoDataValue) &&
+                                 m_dfNoDataValue == 0)) )
+    {
+        if( nLineSpace == nBufXSize * nPixelSpace )
+        {
+             memset( pData, 0, static_cast<size_t>(nBufYSize * nLineSpace) );
+        }
+        else
+        {
+            for( int iLine = 0; iLine < nBufYSize; iLine++ )
+            {
+                memset( reinterpret_cast<GByte *>( pData )
+                        + static_cast<GIntBig>(iLine) * nLineSpace,
+                        0,
+                        static_cast<size_t>(nBufXSize * nPixelSpace) );
+            }
+        }
+    }
+    else if( !bEqualAreas || m_bNoDataValueSet )
+    {
+        double dfWriteValue = 0.0;
+        if( m_bNoDataValueSet )
+            dfWriteValue = m_dfNoDataValue;
+
+        for( int iLine = 0; iLine < nBufYSize; iLine++ )
+        {
+            GDALCopyWords( &dfWriteValue, GDT_Float64, 0,
+                           reinterpret_cast<GByte *>( pData )
+                           + static_cast<GIntBig>( nLineSpace ) * iLine,
+                           eBufType, static_cast<int>(nPixelSpace), nBufXSize );
+        }
+    }
 }
 
 /************************************************************************/
@@ -194,43 +630,8 @@ CPLErr VRTSourcedRasterBand::IRasterIO( GDALRWFlag eRWFlag,
             return CE_None;
     }
 
-/* -------------------------------------------------------------------- */
-/*      Initialize the buffer to some background value. Use the         */
-/*      nodata value if available.                                      */
-/* -------------------------------------------------------------------- */
-    if( nPixelSpace == GDALGetDataTypeSizeBytes(eBufType) &&
-         (!m_bNoDataValueSet || (!CPLIsNan(m_dfNoDataValue) &&
-                                 m_dfNoDataValue == 0)) )
-    {
-        if( nLineSpace == nBufXSize * nPixelSpace )
-        {
-             memset( pData, 0, static_cast<size_t>(nBufYSize * nLineSpace) );
-        }
-        else
-        {
-            for( int iLine = 0; iLine < nBufYSize; iLine++ )
-            {
-                memset( reinterpret_cast<GByte *>( pData )
-                        + static_cast<GIntBig>(iLine) * nLineSpace,
-                        0,
-                        static_cast<size_t>(nBufXSize * nPixelSpace) );
-            }
-        }
-    }
-    else if( !bEqualAreas || m_bNoDataValueSet )
-    {
-        double dfWriteValue = 0.0;
-        if( m_bNoDataValueSet )
-            dfWriteValue = m_dfNoDataValue;
-
-        for( int iLine = 0; iLine < nBufYSize; iLine++ )
-        {
-            GDALCopyWords( &dfWriteValue, GDT_Float64, 0,
-                           reinterpret_cast<GByte *>( pData )
-                           + static_cast<GIntBig>( nLineSpace ) * iLine,
-                           eBufType, static_cast<int>(nPixelSpace), nBufXSize );
-        }
-    }
+    InitializeOutputBuffer( pData, nBufXSize, nBufYSize, eBufType,
+                            nPixelSpace, nLineSpace );
 
     m_nRecursionCounter++;
 
@@ -238,15 +639,29 @@ CPLErr VRTSourcedRasterBand::IRasterIO( GDALRWFlag eRWFlag,
     void * const pProgressDataGlobal = psExtraArg->pProgressData;
 
 /* -------------------------------------------------------------------- */
-/*      Overlay each source in turn over top this.                      */
+/*      Overlay each source in turn over top this. With many sources,   */
+/*      only consider the ones intersecting the request window.         */
 /* -------------------------------------------------------------------- */
+    int nSelected = nSources;
+    int* panSelected =
+        GetSourcesInWindow( nXOff, nYOff, nXSize, nYSize, &nSelected );
+
     CPLErr eErr = CE_None;
-    for( int iSource = 0; eErr == CE_None && iSource < nSources; iSource++ )
+    const bool bDone =
+        nSelected > 1 &&
+        RasterIOSourcesInParallel( nSelected, panSelected,
+                                   nXOff, nYOff, nXSize, nYSize,
+                                   pData, nBufXSize, nBufYSize,
+                                   eBufType, nPixelSpace, nLineSpace,
+                                   psExtraArg, &eErr );
+    for( int i = 0; !bDone && eErr == CE_None && i < nSelected; i++ )
     {
+        const int iSource = panSelected ? panSelected[i] : i;
+
         psExtraArg->pfnProgress = GDALScaledProgress;
         psExtraArg->pProgressData =
-            GDALCreateScaledProgress( 1.0 * iSource / nSources,
-                                      1.0 * (iSource + 1) / nSources,
+            GDALCreateScaledProgress( 1.0 * i / nSelected,
+                                      1.0 * (i + 1) / nSelected,
                                       pfnProgressGlobal,
                                       pProgressDataGlobal );
         if( psExtraArg->pProgressData == NULL )
@@ -260,6 +675,7 @@ CPLErr VRTSourcedRasterBand::IRasterIO( GDALRWFlag eRWFlag,
 
         GDALDestroyScaledProgress( psExtraArg->pProgressData );
     }
+    CPLFree( panSelected );
 
     psExtraArg->pfnProgress = pfnProgressGlobal;
     psExtraArg->pProgressData = pProgressDataGlobal;
@@ -392,23 +808,30 @@ double VRTSourcedRasterBand::GetMinimum( int *pbSuccess )
     }
     m_nRecursionCounter ++;
 
+    // Sources entirely outside of the band do not contribute to it.
+    int nSelected = 0;
+    int* panSelected = GetSourcesInBand( &nSelected );
+
     double dfMin = 0;
-    for( int iSource = 0; iSource < nSources; iSource++ )
+    for( int i = 0; i < nSelected; i++ )
     {
+        const int iSource = panSelected[i];
         int bSuccess = FALSE;
         double dfSourceMin
             = papoSources[iSource]->GetMinimum(GetXSize(), GetYSize(),
                                                &bSuccess);
         if( !bSuccess )
         {
+            CPLFree( panSelected );
             dfMin = GDALRasterBand::GetMinimum(pbSuccess);
             m_nRecursionCounter --;
             return dfMin;
         }
 
-        if( iSource == 0 || dfSourceMin < dfMin )
+        if( i == 0 || dfSourceMin < dfMin )
             dfMin = dfSourceMin;
     }
+    CPLFree( panSelected );
 
     m_nRecursionCounter --;
 
@@ -448,23 +871,29 @@ double VRTSourcedRasterBand::GetMaximum( int *pbSuccess )
     }
     m_nRecursionCounter ++;
 
+    int nSelected = 0;
+    int* panSelected = GetSourcesInBand( &nSelected );
+
     double dfMax = 0;
-    for( int iSource = 0; iSource < nSources; iSource++ )
+    for( int i = 0; i < nSelected; i++ )
     {
+        const int iSource = panSelected[i];
         int bSuccess = FALSE;
         const double dfSourceMax =
             papoSources[iSource]->GetMaximum( GetXSize(), GetYSize(),
                                               &bSuccess );
         if( !bSuccess )
         {
+            CPLFree( panSelected );
             dfMax = GDALRasterBand::GetMaximum(pbSuccess);
             m_nRecursionCounter--;
             return dfMax;
         }
 
-        if( iSource == 0 || dfSourceMax > dfMax )
+        if( i == 0 || dfSourceMax > dfMax )
             dfMax = dfSourceMax;
     }
+    CPLFree( panSelected );
 
     m_nRecursionCounter--;
 
@@ -525,27 +954,33 @@ CPLErr VRTSourcedRasterBand::ComputeRasterMinMax( int bApproxOK, double* adfMinM
     }
     m_nRecursionCounter ++;
 
+    int nSelected = 0;
+    int* panSelected = GetSourcesInBand( &nSelected );
+
     adfMinMax[0] = 0.0;
     adfMinMax[1] = 0.0;
-    for( int iSource = 0; iSource < nSources; iSource++ )
+    for( int i = 0; i < nSelected; i++ )
     {
+        const int iSource = panSelected[i];
         double adfSourceMinMax[2] = { 0.0, 0.0 };
         const CPLErr eErr =
             papoSources[iSource]->ComputeRasterMinMax(
                 GetXSize(), GetYSize(), bApproxOK, adfSourceMinMax );
         if( eErr != CE_None )
         {
+            CPLFree( panSelected );
             const CPLErr eErr2 =
                 GDALRasterBand::ComputeRasterMinMax( bApproxOK, adfMinMax );
             m_nRecursionCounter --;
             return eErr2;
         }
 
-        if( iSource == 0 || adfSourceMinMax[0] < adfMinMax[0] )
+        if( i == 0 || adfSourceMinMax[0] < adfMinMax[0] )
             adfMinMax[0] = adfSourceMinMax[0];
-        if( iSource == 0 || adfSourceMinMax[1] > adfMinMax[1] )
+        if( i == 0 || adfSourceMinMax[1] > adfMinMax[1] )
             adfMinMax[1] = adfSourceMinMax[1];
     }
+    CPLFree( panSelected );
 
     m_nRecursionCounter--;
 
@@ -727,6 +1162,8 @@ CPLErr VRTSourcedRasterBand::GetHistogram( double dfMin, double dfMax,
 CPLErr VRTSourcedRasterBand::AddSource( VRTSource *poNewSource )
 
 {
+    InvalidateSourcesIndex();
+
     nSources++;
 
     papoSources = static_cast<VRTSource **>(
@@ -1394,6 +1831,7 @@ CPLErr VRTSourcedRasterBand::SetMetadataItem( const char *pszName,
         {
             delete papoSources[iSource];
             papoSources[iSource] = poSource;
+            InvalidateSourcesIndex();
             reinterpret_cast<VRTDataset *>( poDS )->SetNeedsFlush();
             return CE_None;
         }
@@ -1425,6 +1863,7 @@ CPLErr VRTSourcedRasterBand::SetMetadata( char **papszNewMD, const char *pszDoma
             CPLFree( papoSources );
             papoSources = NULL;
             nSources = 0;
+            InvalidateSourcesIndex();
         }
 
         for( int i = 0; i < CSLCount(papszNewMD); i++ )
@@ -1485,6 +1924,7 @@ int VRTSourcedRasterBand::CloseDependentDatasets()
     CPLFree( papoSources );
     papoSources = NULL;
     nSources = 0;
+    InvalidateSourcesIndex();
 
     return TRUE;
 }
@@ -205,6 +205,30 @@ void VRTSimpleSource::SetDstWindow( double dfNewXOff, double dfNewYOff,
     m_dfDstYSize = dfNewYSize;
 }
 
+/************************************************************************/
+/*                            GetDstWindow()                            */
+/************************************************************************/
+
+/** Return the window of the VRT band written by this source.
+ *
+ * @return FALSE if no destination window is set, in which case the source
+ * may contribute to any part of the VRT band.
+ */
+int VRTSimpleSource::GetDstWindow( double *pdfXOff, double *pdfYOff,
+                                   double *pdfXSize, double *pdfYSize ) const
+
+{
+    if( m_dfDstXOff == -1 && m_dfDstXSize == -1 &&
+        m_dfDstYOff == -1 && m_dfDstYSize == -1 )
+        return FALSE;
+
+    *pdfXOff = m_dfDstXOff;
+    *pdfYOff = m_dfDstYOff;
+    *pdfXSize = m_dfDstXSize;
+    *pdfYSize = m_dfDstYSize;
+    return TRUE;
+}
+
 /************************************************************************/
 /*                           SetNoDataValue()                           */
 /************************************************************************/
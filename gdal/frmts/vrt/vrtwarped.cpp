@@ -36,6 +36,7 @@
 #include "vrtdataset.h"
 
 #include <algorithm>
+#include <vector>
 
 CPL_CVSID("$Id$");
 
@@ -294,7 +295,11 @@ VRTWarpedDataset::VRTWarpedDataset( int nXSize, int nYSize ) :
     m_poWarper(NULL),
     m_nOverviewCount(0),
     m_papoOverviews(NULL),
-    m_nSrcOvrLevel(-2)
+    m_nSrcOvrLevel(-2),
+    m_nReadAheadBlocks(
+        std::max(0, atoi(CPLGetConfigOption("VRT_WARP_READ_AHEAD", "0")))),
+    m_nLastBlockX(-1),
+    m_nLastBlockY(-1)
 {
     eAccess = GA_Update;
     DisableReadWriteMutex();
@@ -1336,11 +1341,75 @@ void VRTWarpedDataset::GetBlockSize( int *pnBlockXSize, int *pnBlockYSize )
 /*                            ProcessBlock()                            */
 /*                                                                      */
 /*      Warp a single requested block, and then push each band of       */
-/*      the result into the block cache.                                */
+/*      the result into the block cache. With the VRT_WARP_READ_AHEAD   */
+/*      configuration option, the following blocks of the row may be    */
+/*      warped at the same time.                                        */
 /************************************************************************/
 
 CPLErr VRTWarpedDataset::ProcessBlock( int iBlockX, int iBlockY )
 
+{
+/* -------------------------------------------------------------------- */
+/*      If the blocks are requested in sequence, as when a reader       */
+/*      scans the dataset block by block, warp the next blocks of the   */
+/*      row at the same time, so that they share the reading of their   */
+/*      source window.                                                  */
+/* -------------------------------------------------------------------- */
+    int nBlocksX = 1;
+    if( m_nReadAheadBlocks > 0 &&
+        ((iBlockY == m_nLastBlockY && iBlockX == m_nLastBlockX + 1) ||
+         (iBlockY == m_nLastBlockY + 1 && iBlockX == 0)) )
+    {
+        const int nBlocksPerRow =
+            (nRasterXSize + m_nBlockXSize - 1) / m_nBlockXSize;
+        const int nMaxBlocksX =
+            std::min( 1 + m_nReadAheadBlocks, nBlocksPerRow - iBlockX );
+        while( nBlocksX < nMaxBlocksX &&
+               !IsBlockCached( iBlockX + nBlocksX, iBlockY ) )
+            nBlocksX++;
+    }
+
+    const CPLErr eErr =
+        ProcessBlockRange( iBlockX, iBlockY, iBlockX + nBlocksX - 1, iBlockY );
+
+    m_nLastBlockX = iBlockX + nBlocksX - 1;
+    m_nLastBlockY = iBlockY;
+
+    return eErr;
+}
+
+/************************************************************************/
+/*                           IsBlockCached()                            */
+/*                                                                      */
+/*      Whether a block of any of the bands is in the block cache.      */
+/************************************************************************/
+
+bool VRTWarpedDataset::IsBlockCached( int iBlockX, int iBlockY )
+
+{
+    for( int iBand = 1; iBand <= nBands; iBand++ )
+    {
+        VRTWarpedRasterBand *poBand =
+            static_cast<VRTWarpedRasterBand *>( GetRasterBand(iBand) );
+        if( poBand->IsBlockCached( iBlockX, iBlockY ) )
+            return true;
+    }
+    return false;
+}
+
+/************************************************************************/
+/*                           ProcessBlocks()                            */
+/*                                                                      */
+/*      Warp a rectangle of nBlocksX * nBlocksY blocks in a single      */
+/*      operation, and then push each band of each block of the result  */
+/*      into the block cache. The blocks already in the cache, apart    */
+/*      from the first one that the caller is loading, are left         */
+/*      untouched.                                                      */
+/************************************************************************/
+
+CPLErr VRTWarpedDataset::ProcessBlocks( int iBlockX, int iBlockY,
+                                        int nBlocksX, int nBlocksY )
+
 {
     if( m_poWarper == NULL )
         return CE_Failure;
@@ -1349,14 +1418,27 @@ CPLErr VRTWarpedDataset::ProcessBlock( int iBlockX, int iBlockY )
 
 /* -------------------------------------------------------------------- */
 /*      Allocate block of memory large enough to hold all the bands     */
-/*      for this block.                                                 */
+/*      for this region.                                                */
 /* -------------------------------------------------------------------- */
     const int nWordSize = GDALGetDataTypeSizeBytes(psWO->eWorkingDataType);
 
-    // FIXME? : risk of overflow in multiplication if nBlockXSize or
-    // nBlockYSize are very large.
-    const int nDstBufferSize
-        = m_nBlockXSize * m_nBlockYSize * psWO->nBandCount * nWordSize;
+    int nReqXSize = nBlocksX * m_nBlockXSize;
+    if( iBlockX * m_nBlockXSize + nReqXSize > nRasterXSize )
+        nReqXSize = nRasterXSize - iBlockX * m_nBlockXSize;
+    int nReqYSize = nBlocksY * m_nBlockYSize;
+    if( iBlockY * m_nBlockYSize + nReqYSize > nRasterYSize )
+        nReqYSize = nRasterYSize - iBlockY * m_nBlockYSize;
+
+    const size_t nBandSize =
+        static_cast<size_t>(nReqXSize) * nReqYSize * nWordSize;
+    const size_t nDstBufferSize = nBandSize * psWO->nBandCount;
+    if( nDstBufferSize / psWO->nBandCount != nBandSize ||
+        nBandSize / nWordSize / nReqYSize != static_cast<size_t>(nReqXSize) )
+    {
+        CPLError( CE_Failure, CPLE_OutOfMemory,
+                  "Too large region to warp" );
+        return CE_Failure;
+    }
 
     GByte *pabyDstBuffer = static_cast<GByte *>(
         VSI_MALLOC_VERBOSE(nDstBufferSize) );
@@ -1385,7 +1467,6 @@ CPLErr VRTWarpedDataset::ProcessBlock( int iBlockX, int iBlockY )
 
         for( int iBand = 0; iBand < psWO->nBandCount; iBand++ )
         {
-            const int nBandSize = m_nBlockXSize * m_nBlockYSize * nWordSize;
             const char *pszBandInit
                 = papszInitValues[std::min( iBand, nInitCount - 1 )];
 
@@ -1402,8 +1483,7 @@ CPLErr VRTWarpedDataset::ProcessBlock( int iBlockX, int iBlockY )
                                     adfInitRealImag + 0, adfInitRealImag + 1);
             }
 
-            GByte *pBandData = reinterpret_cast<GByte *>(
-                pabyDstBuffer ) + iBand * nBandSize;
+            GByte *pBandData = pabyDstBuffer + iBand * nBandSize;
 
             if( psWO->eWorkingDataType == GDT_Byte )
                 memset( pBandData,
@@ -1424,13 +1504,13 @@ CPLErr VRTWarpedDataset::ProcessBlock( int iBlockX, int iBlockY )
             {
                 GDALCopyWords( &adfInitRealImag, GDT_Float64, 0,
                                pBandData,psWO->eWorkingDataType,nWordSize,
-                               m_nBlockXSize * m_nBlockYSize );
+                               nReqXSize * nReqYSize );
             }
             else
             {
                 GDALCopyWords( &adfInitRealImag, GDT_CFloat64, 0,
                                pBandData,psWO->eWorkingDataType,nWordSize,
-                               m_nBlockXSize * m_nBlockYSize );
+                               nReqXSize * nReqYSize );
             }
         }
 
@@ -1440,12 +1520,9 @@ CPLErr VRTWarpedDataset::ProcessBlock( int iBlockX, int iBlockY )
 /* -------------------------------------------------------------------- */
 /*      Warp into this buffer.                                          */
 /* -------------------------------------------------------------------- */
-    int nReqXSize = m_nBlockXSize;
-    if( iBlockX * m_nBlockXSize + nReqXSize > nRasterXSize )
-        nReqXSize = nRasterXSize - iBlockX * m_nBlockXSize;
-    int nReqYSize = m_nBlockYSize;
-    if( iBlockY * m_nBlockYSize + nReqYSize > nRasterYSize )
-        nReqYSize = nRasterYSize - iBlockY * m_nBlockYSize;
+    if( nBlocksX > 1 || nBlocksY > 1 )
+        CPLDebug( "VRT", "Warping %d x %d blocks at once from (%d,%d)",
+                  nBlocksX, nBlocksY, iBlockX, iBlockY );
 
     const CPLErr eErr =
         m_poWarper->WarpRegionToBuffer(
@@ -1464,47 +1541,56 @@ CPLErr VRTWarpedDataset::ProcessBlock( int iBlockX, int iBlockY )
 /* -------------------------------------------------------------------- */
     for( int iBand = 0; iBand < std::min(nBands, psWO->nBandCount); iBand++ )
     {
-        GDALRasterBand *poBand = GetRasterBand(iBand+1);
-        GDALRasterBlock *poBlock
-            = poBand->GetLockedBlockRef( iBlockX, iBlockY, TRUE );
+        VRTWarpedRasterBand *poBand =
+            static_cast<VRTWarpedRasterBand *>( GetRasterBand(iBand+1) );
+        const GByte *pabyBandData = pabyDstBuffer + iBand * nBandSize;
 
-        if( poBlock != NULL )
+        for( int iY = 0; iY < nBlocksY; iY++ )
         {
-            if ( poBlock->GetDataRef() != NULL )
+            for( int iX = 0; iX < nBlocksX; iX++ )
             {
-                if( nReqXSize == m_nBlockXSize && nReqYSize == m_nBlockYSize )
-                {
-                    GDALCopyWords(
-                        pabyDstBuffer +
-                        iBand*m_nBlockXSize*m_nBlockYSize*nWordSize,
-                        psWO->eWorkingDataType, nWordSize,
-                        poBlock->GetDataRef(),
-                        poBlock->GetDataType(),
-                        GDALGetDataTypeSizeBytes(poBlock->GetDataType()),
-                        m_nBlockXSize * m_nBlockYSize );
-                }
-                else
+                // The warped pixels may slightly differ from the ones of an
+                // earlier warp of that block.
+                if( (iX != 0 || iY != 0) &&
+                    poBand->IsBlockCached( iBlockX + iX, iBlockY + iY ) )
+                    continue;
+
+                GDALRasterBlock *poBlock
+                    = poBand->GetLockedBlockRef( iBlockX + iX, iBlockY + iY,
+                                                 TRUE );
+                if( poBlock == NULL )
+                    continue;
+
+                if( poBlock->GetDataRef() != NULL )
                 {
                     GByte* pabyBlock = reinterpret_cast<GByte *>(
                         poBlock->GetDataRef() );
                     const int nDTSize =
                         GDALGetDataTypeSizeBytes(poBlock->GetDataType());
-                    for(int iY=0;iY<nReqYSize;iY++)
+                    const int nXOffInBuf = iX * m_nBlockXSize;
+                    const int nYOffInBuf = iY * m_nBlockYSize;
+                    const int nCopyXSize =
+                        std::min( m_nBlockXSize, nReqXSize - nXOffInBuf );
+                    const int nCopyYSize =
+                        std::min( m_nBlockYSize, nReqYSize - nYOffInBuf );
+                    for( int iLine = 0; iLine < nCopyYSize; iLine++ )
                     {
                         GDALCopyWords(
-                            pabyDstBuffer +
-                            iBand*nReqXSize*nReqYSize*nWordSize +
-                            iY * nReqXSize*nWordSize,
+                            pabyBandData +
+                            (static_cast<size_t>(nYOffInBuf + iLine) *
+                                nReqXSize + nXOffInBuf) * nWordSize,
                             psWO->eWorkingDataType, nWordSize,
-                            pabyBlock + iY * m_nBlockXSize * nDTSize,
+                            pabyBlock +
+                            static_cast<size_t>(iLine) * m_nBlockXSize *
+                                nDTSize,
                             poBlock->GetDataType(),
                             nDTSize,
-                            nReqXSize );
+                            nCopyXSize );
                     }
                 }
-            }
 
-            poBlock->DropLock();
+                poBlock->DropLock();
+            }
         }
     }
 
@@ -1513,6 +1599,81 @@ CPLErr VRTWarpedDataset::ProcessBlock( int iBlockX, int iBlockY )
     return CE_None;
 }
 
+/************************************************************************/
+/*                         ProcessBlockRange()                          */
+/*                                                                      */
+/*      Warp the blocks from (iXBlockStart, iYBlockStart) to            */
+/*      (iXBlockEnd, iYBlockEnd) included, in as few warping            */
+/*      operations as the warp memory limit allows. Compared to warping  */
+/*      them one by one, this avoids reading the source pixels shared   */
+/*      by neighbouring blocks several times, and gives the warp        */
+/*      kernel threads larger regions to work on.                       */
+/************************************************************************/
+
+CPLErr VRTWarpedDataset::ProcessBlockRange( int iXBlockStart, int iYBlockStart,
+                                            int iXBlockEnd, int iYBlockEnd )
+
+{
+    if( m_poWarper == NULL )
+        return CE_Failure;
+
+    const int nBlocksX = iXBlockEnd - iXBlockStart + 1;
+    const int nBlocksY = iYBlockEnd - iYBlockStart + 1;
+    if( nBlocksX == 1 && nBlocksY == 1 )
+        return ProcessBlocks( iXBlockStart, iYBlockStart, 1, 1 );
+
+/* -------------------------------------------------------------------- */
+/*      As GDALWarpOperation::CollectChunkList() does, bound the         */
+/*      region by the memory needed for its source window and its       */
+/*      destination buffer, and split it in two along its longest       */
+/*      dimension if it exceeds the warp memory limit. This matters     */
+/*      when downsampling, where a region of a few blocks may need a    */
+/*      very large source window. If that window cannot be computed,    */
+/*      the blocks end up being warped one by one.                      */
+/* -------------------------------------------------------------------- */
+    const int nDstXOff = iXBlockStart * m_nBlockXSize;
+    const int nDstYOff = iYBlockStart * m_nBlockYSize;
+    const int nDstXSize =
+        std::min( nBlocksX * m_nBlockXSize, nRasterXSize - nDstXOff );
+    const int nDstYSize =
+        std::min( nBlocksY * m_nBlockYSize, nRasterYSize - nDstYOff );
+
+    double dfMemoryUse = 0.0;
+    CPLPushErrorHandler( CPLQuietErrorHandler );
+    const CPLErr eErr =
+        m_poWarper->ComputeRegionMemoryUse( nDstXOff, nDstYOff,
+                                            nDstXSize, nDstYSize,
+                                            &dfMemoryUse );
+    CPLPopErrorHandler();
+
+    if( eErr == CE_None &&
+        dfMemoryUse <= m_poWarper->GetOptions()->dfWarpMemoryLimit )
+    {
+        return ProcessBlocks( iXBlockStart, iYBlockStart, nBlocksX, nBlocksY );
+    }
+
+    CPLErrorReset();
+
+    if( (nDstXSize > nDstYSize && nBlocksX > 1) || nBlocksY == 1 )
+    {
+        const int iXBlockMid = iXBlockStart + nBlocksX / 2;
+        const CPLErr eErr1 = ProcessBlockRange( iXBlockStart, iYBlockStart,
+                                                iXBlockMid - 1, iYBlockEnd );
+        if( eErr1 != CE_None )
+            return eErr1;
+        return ProcessBlockRange( iXBlockMid, iYBlockStart,
+                                  iXBlockEnd, iYBlockEnd );
+    }
+
+    const int iYBlockMid = iYBlockStart + nBlocksY / 2;
+    const CPLErr eErr1 = ProcessBlockRange( iXBlockStart, iYBlockStart,
+                                            iXBlockEnd, iYBlockMid - 1 );
+    if( eErr1 != CE_None )
+        return eErr1;
+    return ProcessBlockRange( iXBlockStart, iYBlockMid,
+                              iXBlockEnd, iYBlockEnd );
+}
+
 /************************************************************************/
 /*                              AddBand()                               */
 /************************************************************************/
@@ -1591,6 +1752,134 @@ CPLErr VRTWarpedRasterBand::IReadBlock( int nBlockXOff, int nBlockYOff,
     return eErr;
 }
 
+/************************************************************************/
+/*                             IRasterIO()                              */
+/************************************************************************/
+
+CPLErr VRTWarpedRasterBand::IRasterIO( GDALRWFlag eRWFlag,
+                                       int nXOff, int nYOff,
+                                       int nXSize, int nYSize,
+                                       void * pData,
+                                       int nBufXSize, int nBufYSize,
+                                       GDALDataType eBufType,
+                                       GSpacing nPixelSpace,
+                                       GSpacing nLineSpace,
+                                       GDALRasterIOExtraArg* psExtraArg )
+{
+    VRTWarpedDataset *poWDS = reinterpret_cast<VRTWarpedDataset *>( poDS );
+
+    // For a non-resampled read spanning several blocks, warp the missing
+    // blocks together before the block-based implementation collects them
+    // from the block cache. This is done by default only when the result
+    // does not depend on the size of the warped region: with nearest
+    // neighbour resampling (the warp kernel derives the footprint of the
+    // other kernels from the ratio of the destination and source windows)
+    // and with an exact transformer (the approximate transformer
+    // interpolates over the lines of the warped region).
+    bool bMultiBlock = false;
+    if( eRWFlag == GF_Read && nXSize == nBufXSize && nYSize == nBufYSize &&
+        poWDS->m_poWarper != NULL )
+    {
+        const char *pszMultiBlock =
+            CPLGetConfigOption( "VRT_WARP_MULTI_BLOCK", NULL );
+        const GDALWarpOptions *psWO = poWDS->m_poWarper->GetOptions();
+        if( pszMultiBlock != NULL )
+            bMultiBlock = CPLTestBool( pszMultiBlock );
+        else
+            bMultiBlock = psWO->eResampleAlg == GRA_NearestNeighbour &&
+                          psWO->pfnTransformer != GDALApproxTransform;
+    }
+
+    if( bMultiBlock )
+    {
+        const int nXBlockStart = nXOff / nBlockXSize;
+        const int nXBlockEnd = (nXOff + nXSize - 1) / nBlockXSize;
+        const int nYBlockStart = nYOff / nBlockYSize;
+        const int nYBlockEnd = (nYOff + nYSize - 1) / nBlockYSize;
+
+        // Find the blocks not yet in the cache.
+        const int nXBlocks = nXBlockEnd - nXBlockStart + 1;
+        const int nYBlocks = nYBlockEnd - nYBlockStart + 1;
+        std::vector<bool> abMissing( static_cast<size_t>(nXBlocks) * nYBlocks );
+        int nMissingCount = 0;
+        for( int iY = 0; iY < nYBlocks; iY++ )
+        {
+            for( int iX = 0; iX < nXBlocks; iX++ )
+            {
+                if( !poWDS->IsBlockCached( nXBlockStart + iX,
+                                           nYBlockStart + iY ) )
+                {
+                    abMissing[static_cast<size_t>(iY) * nXBlocks + iX] = true;
+                    nMissingCount++;
+                }
+            }
+        }
+
+        // Warp them by rectangles made of runs of missing blocks of a row,
+        // extended over the following rows where the same run is missing.
+        for( int iY = 0; nMissingCount > 1 && iY < nYBlocks; iY++ )
+        {
+            for( int iX = 0; iX < nXBlocks; )
+            {
+                const size_t iIdx = static_cast<size_t>(iY) * nXBlocks;
+                if( !abMissing[iIdx + iX] )
+                {
+                    iX++;
+                    continue;
+                }
+                int iXEnd = iX;
+                while( iXEnd + 1 < nXBlocks && abMissing[iIdx + iXEnd + 1] )
+                    iXEnd++;
+
+                int iYEnd = iY;
+                bool bExtend = true;
+                while( bExtend && iYEnd + 1 < nYBlocks )
+                {
+                    const size_t iNextIdx =
+                        static_cast<size_t>(iYEnd + 1) * nXBlocks;
+                    for( int i = iX; bExtend && i <= iXEnd; i++ )
+                        bExtend = abMissing[iNextIdx + i];
+                    if( bExtend )
+                        iYEnd++;
+                }
+
+                for( int i = iY; i <= iYEnd; i++ )
+                    for( int j = iX; j <= iXEnd; j++ )
+                        abMissing[static_cast<size_t>(i) * nXBlocks + j] =
+                            false;
+
+                const CPLErr eErr =
+                    poWDS->ProcessBlockRange( nXBlockStart + iX,
+                                              nYBlockStart + iY,
+                                              nXBlockStart + iXEnd,
+                                              nYBlockStart + iYEnd );
+                if( eErr != CE_None )
+                    return eErr;
+
+                iX = iXEnd + 1;
+            }
+        }
+    }
+
+    return VRTRasterBand::IRasterIO( eRWFlag, nXOff, nYOff, nXSize, nYSize,
+                                     pData, nBufXSize, nBufYSize, eBufType,
+                                     nPixelSpace, nLineSpace, psExtraArg );
+}
+
+/************************************************************************/
+/*                           IsBlockCached()                            */
+/************************************************************************/
+
+bool VRTWarpedRasterBand::IsBlockCached( int nBlockXOff, int nBlockYOff )
+
+{
+    GDALRasterBlock *poBlock = TryGetLockedBlockRef( nBlockXOff, nBlockYOff );
+    if( poBlock == NULL )
+        return false;
+    poBlock->DropLock();
+    return true;
+}
+
 /************************************************************************/
 /*                            IWriteBlock()                             */
 /************************************************************************/
@@ -219,8 +219,6 @@ class CPL_DLL GDALProxyPoolDataset : public GDALProxyDataset
         CPLHashSet      *metadataSet;
         CPLHashSet      *metadataItemSet;
 
-        GDALProxyPoolCacheEntry* cacheEntry;
-
     protected:
         virtual GDALDataset *RefUnderlyingDataset();
         virtual void UnrefUnderlyingDataset(GDALDataset* poUnderlyingDataset);
@@ -325,9 +323,6 @@ class GDALProxyPoolOverviewRasterBand : public GDALProxyPoolRasterBand
         GDALProxyPoolRasterBand *poMainBand;
         int                      nOverviewBand;
 
-        GDALRasterBand          *poUnderlyingMainRasterBand;
-        int                      nRefCountUnderlyingMainRasterBand;
-
     protected:
         virtual GDALRasterBand* RefUnderlyingRasterBand();
         virtual void UnrefUnderlyingRasterBand(GDALRasterBand* poUnderlyingRasterBand);
@@ -349,9 +344,6 @@ class GDALProxyPoolMaskBand : public GDALProxyPoolRasterBand
     private:
         GDALProxyPoolRasterBand *poMainBand;
 
-        GDALRasterBand          *poUnderlyingMainRasterBand;
-        int                      nRefCountUnderlyingMainRasterBand;
-
     protected:
         virtual GDALRasterBand* RefUnderlyingRasterBand();
         virtual void UnrefUnderlyingRasterBand(GDALRasterBand* poUnderlyingRasterBand);
@@ -391,6 +383,8 @@ void CPL_DLL GDALProxyPoolDatasetAddSrcBandDescription( GDALProxyPoolDatasetH hP
                                                         GDALDataType eDataType,
                                                         int nBlockXSize, int nBlockYSize);
 
+int CPL_DLL GDALProxyPoolGetMaxSize(void);
+
 CPL_C_END
 
 #endif /* GDAL_PROXY_H_INCLUDED */
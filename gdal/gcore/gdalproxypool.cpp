@@ -29,14 +29,25 @@
  ****************************************************************************/
 
 #include "gdal_proxy.h"
+#include "cpl_atomic_ops.h"
 #include "cpl_multiproc.h"
 
+#include <algorithm>
+
+#ifndef WIN32
+#include <sys/resource.h>
+#endif
+
 CPL_CVSID("$Id$");
 
-/* We *must* share the same mutex as the gdaldataset.cpp file, as we are */
-/* doing GDALOpen() calls that can indirectly call GDALOpenShared() on */
-/* an auxiliary dataset ... */
-/* Then we could get dead-locks in multi-threaded use case */
+/* Opening and closing of the pooled datasets is done while holding the */
+/* same mutex as the gdaldataset.cpp file, as we are doing GDALOpen() calls */
+/* that can indirectly call GDALOpenShared() on an auxiliary dataset ... */
+/* Then we could get dead-locks in multi-threaded use case. */
+/* The lookup of already opened datasets, which is done for each I/O */
+/* request on a proxy dataset, only takes the mutex of the pool shard */
+/* where the file name of the dataset falls, and the shard mutexes are */
+/* never held when taking the above mutex. */
 
 /* ******************************************************************** */
 /*                         GDALDatasetPool                              */
@@ -59,10 +70,31 @@ struct _GDALProxyPoolCacheEntry
     /* Ref count of the cached dataset */
     int           refCount;
 
+    /* Thread using the dataset, when refCount > 0. A dataset is used by */
+    /* a single thread at a time: other threads get another handle. */
+    GIntBig       ownerThread;
+
+    /* Value of the pool use counter when the dataset was last released */
+    unsigned int  lastUse;
+
     GDALProxyPoolCacheEntry* prev;
     GDALProxyPoolCacheEntry* next;
 };
 
+/* Number of independently locked parts of the pool. A dataset goes into */
+/* the shard selected by the hash of its file name. */
+#define DATASET_POOL_SHARD_COUNT 16
+
+typedef struct
+{
+    CPLMutex                *hMutex;
+    GDALProxyPoolCacheEntry *firstEntry;
+
+    /* Statistics */
+    int                      nHits;
+    int                      nOpened;
+} GDALDatasetPoolShard;
+
 class GDALDatasetPool
 {
     private:
@@ -73,9 +105,18 @@ class GDALDatasetPool
         int refCount;
 
         int maxSize;
-        int currentSize;
-        GDALProxyPoolCacheEntry* firstEntry;
-        GDALProxyPoolCacheEntry* lastEntry;
+
+        /* Number of entries, including datasets being opened. Updated */
+        /* atomically */
+        volatile int currentSize;
+
+        /* Incremented atomically each time a dataset is released */
+        volatile int useCounter;
+
+        /* Number of datasets closed to stay within maxSize */
+        volatile int nEvicted;
+
+        GDALDatasetPoolShard asShards[DATASET_POOL_SHARD_COUNT];
 
         /* This variable prevents a dataset that is going to be opened in GDALDatasetPool::_RefDataset */
         /* from increasing refCount if, during its opening, it creates a GDALProxyPoolDataset */
@@ -87,25 +128,37 @@ class GDALDatasetPool
 
         /* Caution : to be sure that we don't run out of entries, size must be at */
         /* least greater or equal than the maximum number of threads */
-        GDALDatasetPool(int maxSize);
+        explicit GDALDatasetPool(int maxSize);
         ~GDALDatasetPool();
+
+        GDALDatasetPoolShard& GetShard(const char* pszFileName);
+        static void Unlink(GDALDatasetPoolShard& oShard,
+                           GDALProxyPoolCacheEntry* entry);
+        void _CloseEntry(GDALProxyPoolCacheEntry* entry);
+        bool _EvictOneDataset();
+
         GDALProxyPoolCacheEntry* _RefDataset(const char* pszFileName,
                                              GDALAccess eAccess,
                                              char** papszOpenOptions,
                                              int bShared);
+        void _UnrefDataset(const char* pszFileName, GDALDataset* poDS);
         void _CloseDataset(const char* pszFileName, GDALAccess eAccess);
 
         void ShowContent();
         void CheckLinks();
 
+        static int GetMaxAllowedSize();
+        static int ComputeMaxSize(bool bVerbose);
+
     public:
         static void Ref();
         static void Unref();
+        static int GetMaxSize();
         static GDALProxyPoolCacheEntry* RefDataset(const char* pszFileName,
                                                    GDALAccess eAccess,
                                                    char** papszOpenOptions,
                                                    int bShared);
-        static void UnrefDataset(GDALProxyPoolCacheEntry* cacheEntry);
+        static void UnrefDataset(const char* pszFileName, GDALDataset* poDS);
         static void CloseDataset(const char* pszFileName, GDALAccess eAccess);
 
         static void PreventDestroy();
@@ -121,8 +174,9 @@ GDALDatasetPool::GDALDatasetPool(int maxSizeIn)
 {
     maxSize = maxSizeIn;
     currentSize = 0;
-    firstEntry = NULL;
-    lastEntry = NULL;
+    useCounter = 0;
+    nEvicted = 0;
+    memset(asShards, 0, sizeof(asShards));
     refCount = 0;
     refCountOfDisableRefCount = 0;
 }
@@ -133,22 +187,86 @@ GDALDatasetPool::GDALDatasetPool(int maxSizeIn)
 
 GDALDatasetPool::~GDALDatasetPool()
 {
-    GDALProxyPoolCacheEntry* cur = firstEntry;
+    int nHits = 0;
+    int nOpened = 0;
     GIntBig responsiblePID = GDALGetResponsiblePIDForCurrentThread();
-    while(cur)
+    for( int i = 0; i < DATASET_POOL_SHARD_COUNT; i++ )
     {
-        GDALProxyPoolCacheEntry* next = cur->next;
-        CPLFree(cur->pszFileName);
-        CPLAssert(cur->refCount == 0);
-        if (cur->poDS)
+        GDALProxyPoolCacheEntry* cur = asShards[i].firstEntry;
+        while(cur)
         {
-            GDALSetResponsiblePIDForCurrentThread(cur->responsiblePID);
-            GDALClose(cur->poDS);
+            GDALProxyPoolCacheEntry* next = cur->next;
+            CPLFree(cur->pszFileName);
+            CPLAssert(cur->refCount == 0);
+            if (cur->poDS)
+            {
+                GDALSetResponsiblePIDForCurrentThread(cur->responsiblePID);
+                GDALClose(cur->poDS);
+            }
+            CPLFree(cur);
+            cur = next;
         }
-        CPLFree(cur);
-        cur = next;
+        if( asShards[i].hMutex )
+            CPLDestroyMutex(asShards[i].hMutex);
+        nHits += asShards[i].nHits;
+        nOpened += asShards[i].nOpened;
     }
     GDALSetResponsiblePIDForCurrentThread(responsiblePID);
+
+    CPLDebug("GDAL",
+             "Dataset pool of max size %d: %d reuses of opened datasets, "
+             "%d datasets opened, %d closed to stay within the size",
+             maxSize, nHits, nOpened, nEvicted);
+}
+
+/************************************************************************/
+/*                         GetMaxAllowedSize()                          */
+/************************************************************************/
+
+/* Maximum size of the pool, so that the opened datasets do not exhaust */
+/* the file descriptors of the process. As a dataset may open several */
+/* files (overviews, masks, side-car files, ...), only a third of them */
+/* is devoted to the pool. */
+int GDALDatasetPool::GetMaxAllowedSize()
+{
+#ifndef WIN32
+    struct rlimit sLimit;
+    if( getrlimit(RLIMIT_NOFILE, &sLimit) == 0 &&
+        sLimit.rlim_cur != RLIM_INFINITY )
+    {
+        return static_cast<int>(
+            std::max(static_cast<rlim_t>(2),
+                     std::min(sLimit.rlim_cur / 3,
+                              static_cast<rlim_t>(INT_MAX))));
+    }
+#endif
+    return 1000;
+}
+
+/************************************************************************/
+/*                             GetShard()                               */
+/************************************************************************/
+
+GDALDatasetPoolShard& GDALDatasetPool::GetShard(const char* pszFileName)
+{
+    return asShards[CPLHashSetHashStr(pszFileName) % DATASET_POOL_SHARD_COUNT];
+}
+
+/************************************************************************/
+/*                              Unlink()                                */
+/************************************************************************/
+
+void GDALDatasetPool::Unlink(GDALDatasetPoolShard& oShard,
+                             GDALProxyPoolCacheEntry* entry)
+{
+    if (entry->prev)
+        entry->prev->next = entry->next;
+    else
+        oShard.firstEntry = entry->next;
+    if (entry->next)
+        entry->next->prev = entry->prev;
+    entry->prev = NULL;
+    entry->next = NULL;
 }
 
 /************************************************************************/
@@ -157,14 +275,19 @@ GDALDatasetPool::~GDALDatasetPool()
 
 void GDALDatasetPool::ShowContent()
 {
-    GDALProxyPoolCacheEntry* cur = firstEntry;
     int i = 0;
-    while(cur)
+    for( int iShard = 0; iShard < DATASET_POOL_SHARD_COUNT; iShard++ )
     {
-        printf("[%d] pszFileName=%s, refCount=%d, responsiblePID=%d\n",
-               i, cur->pszFileName, cur->refCount, (int)cur->responsiblePID);
-        i++;
-        cur = cur->next;
+        CPLMutexHolderD( &(asShards[iShard].hMutex) );
+        GDALProxyPoolCacheEntry* cur = asShards[iShard].firstEntry;
+        while(cur)
+        {
+            printf("[%d] shard=%d, pszFileName=%s, refCount=%d, responsiblePID=%d\n",
+                   i, iShard, cur->pszFileName, cur->refCount,
+                   (int)cur->responsiblePID);
+            i++;
+            cur = cur->next;
+        }
     }
 }
 
@@ -174,17 +297,121 @@ void GDALDatasetPool::ShowContent()
 
 void GDALDatasetPool::CheckLinks()
 {
-    GDALProxyPoolCacheEntry* cur = firstEntry;
     int i = 0;
-    while(cur)
+    for( int iShard = 0; iShard < DATASET_POOL_SHARD_COUNT; iShard++ )
+    {
+        CPLMutexHolderD( &(asShards[iShard].hMutex) );
+        GDALProxyPoolCacheEntry* cur = asShards[iShard].firstEntry;
+        while(cur)
+        {
+            CPLAssert(cur->prev != NULL || cur == asShards[iShard].firstEntry);
+            CPLAssert(cur->prev == NULL || cur->prev->next == cur);
+            CPLAssert(cur->next == NULL || cur->next->prev == cur);
+            ++i;
+            cur = cur->next;
+        }
+    }
+    CPLAssert(i <= currentSize);
+}
+
+/************************************************************************/
+/*                            _CloseEntry()                             */
+/************************************************************************/
+
+/* Close the dataset of an entry that has been unlinked from its shard, */
+/* and free the entry */
+void GDALDatasetPool::_CloseEntry(GDALProxyPoolCacheEntry* entry)
+{
+    if (entry->poDS)
+    {
+        CPLMutexHolderD( GDALGetphDLMutex() );
+
+        /* Close by pretending we are the thread that GDALOpen'ed this */
+        /* dataset */
+        GIntBig responsiblePID = GDALGetResponsiblePIDForCurrentThread();
+        GDALSetResponsiblePIDForCurrentThread(entry->responsiblePID);
+
+        refCountOfDisableRefCount ++;
+        GDALClose(entry->poDS);
+        refCountOfDisableRefCount --;
+
+        GDALSetResponsiblePIDForCurrentThread(responsiblePID);
+    }
+    CPLFree(entry->pszFileName);
+    CPLFree(entry);
+    CPLAtomicDec(&currentSize);
+}
+
+/************************************************************************/
+/*                         _EvictOneDataset()                           */
+/************************************************************************/
+
+/* Close the least recently used dataset that is not in use, among all */
+/* the shards. Return false if all datasets are in use. */
+bool GDALDatasetPool::_EvictOneDataset()
+{
+    /* Another thread may use the selected dataset between the time we */
+    /* have found it and the time we lock its shard again, so retry a */
+    /* few times */
+    for( int iIter = 0; iIter < 10; iIter++ )
     {
-        CPLAssert(cur == firstEntry || cur->prev->next == cur);
-        CPLAssert(cur == lastEntry || cur->next->prev == cur);
-        ++i;
-        CPLAssert(cur->next != NULL || cur == lastEntry);
-        cur = cur->next;
+        GDALProxyPoolCacheEntry* candidate = NULL;
+        int iCandidateShard = -1;
+        unsigned int nCandidateLastUse = 0;
+        unsigned int nCandidateAge = 0;
+        const unsigned int nNow = static_cast<unsigned int>(useCounter);
+
+        for( int iShard = 0; iShard < DATASET_POOL_SHARD_COUNT; iShard++ )
+        {
+            CPLMutexHolderD( &(asShards[iShard].hMutex) );
+            for( GDALProxyPoolCacheEntry* cur = asShards[iShard].firstEntry;
+                 cur != NULL; cur = cur->next )
+            {
+                if( cur->refCount != 0 )
+                    continue;
+                // Wrap-around safe age computation
+                const unsigned int nAge = nNow - cur->lastUse;
+                if( candidate == NULL || nAge > nCandidateAge )
+                {
+                    candidate = cur;
+                    iCandidateShard = iShard;
+                    nCandidateLastUse = cur->lastUse;
+                    nCandidateAge = nAge;
+                }
+            }
+        }
+
+        if( candidate == NULL )
+            return false;
+
+        bool bFound = false;
+        {
+            GDALDatasetPoolShard& oShard = asShards[iCandidateShard];
+            CPLMutexHolderD( &(oShard.hMutex) );
+            for( GDALProxyPoolCacheEntry* cur = oShard.firstEntry;
+                 cur != NULL; cur = cur->next )
+            {
+                if( cur == candidate )
+                {
+                    if( cur->refCount == 0 &&
+                        cur->lastUse == nCandidateLastUse )
+                    {
+                        Unlink(oShard, cur);
+                        bFound = true;
+                    }
+                    break;
+                }
+            }
+        }
+
+        if( bFound )
+        {
+            _CloseEntry(candidate);
+            CPLAtomicInc(&nEvicted);
+            return true;
+        }
     }
-    CPLAssert(i == currentSize);
+    return false;
 }
 
 /************************************************************************/
@@ -196,124 +423,135 @@ GDALProxyPoolCacheEntry* GDALDatasetPool::_RefDataset(const char* pszFileName,
                                                       char** papszOpenOptions,
                                                       int bShared)
 {
-    GDALProxyPoolCacheEntry* cur = firstEntry;
     GIntBig responsiblePID = GDALGetResponsiblePIDForCurrentThread();
-    GDALProxyPoolCacheEntry* lastEntryWithZeroRefCount = NULL;
+    const GIntBig nThisThread = CPLGetPID();
+    GDALDatasetPoolShard& oShard = GetShard(pszFileName);
+    GDALProxyPoolCacheEntry* cur = NULL;
 
-    while(cur)
+/* -------------------------------------------------------------------- */
+/*      Look for a dataset that is not used by another thread.          */
+/* -------------------------------------------------------------------- */
     {
-        GDALProxyPoolCacheEntry* next = cur->next;
+        CPLMutexHolderD( &(oShard.hMutex) );
 
-        if (strcmp(cur->pszFileName, pszFileName) == 0 &&
-            ((bShared && cur->responsiblePID == responsiblePID) ||
-             (!bShared && cur->refCount == 0)) )
+        for( cur = oShard.firstEntry; cur != NULL; cur = cur->next )
         {
-            if (cur != firstEntry)
+            /* poDS == NULL means that the dataset is being opened */
+            if (cur->poDS != NULL &&
+                strcmp(cur->pszFileName, pszFileName) == 0 &&
+                ((bShared && cur->responsiblePID == responsiblePID &&
+                  (cur->refCount == 0 || cur->ownerThread == nThisThread)) ||
+                 (!bShared && cur->refCount == 0)) )
             {
-                /* Move to begin */
-                if (cur->next)
-                    cur->next->prev = cur->prev;
-                else
-                    lastEntry = cur->prev;
-                cur->prev->next = cur->next;
-                cur->prev = NULL;
-                firstEntry->prev = cur;
-                cur->next = firstEntry;
-                firstEntry = cur;
-
-#ifdef DEBUG_PROXY_POOL
-                CheckLinks();
-#endif
+                if( cur->refCount == 0 )
+                    cur->ownerThread = nThisThread;
+                cur->refCount ++;
+                oShard.nHits ++;
+                return cur;
             }
-
-            cur->refCount ++;
-            return cur;
         }
 
-        if (cur->refCount == 0)
-            lastEntryWithZeroRefCount = cur;
-
-        cur = next;
+/* -------------------------------------------------------------------- */
+/*      Otherwise reserve a new entry, so that other threads do not     */
+/*      wait for the opening of the dataset.                            */
+/* -------------------------------------------------------------------- */
+        cur = static_cast<GDALProxyPoolCacheEntry*>(
+            CPLCalloc(1, sizeof(GDALProxyPoolCacheEntry)));
+        cur->pszFileName = CPLStrdup(pszFileName);
+        cur->responsiblePID = responsiblePID;
+        cur->refCount = 1;
+        cur->ownerThread = nThisThread;
+        cur->next = oShard.firstEntry;
+        if (oShard.firstEntry)
+            oShard.firstEntry->prev = cur;
+        oShard.firstEntry = cur;
+        oShard.nOpened ++;
+#ifdef DEBUG_PROXY_POOL
+        CheckLinks();
+#endif
     }
 
-    if (currentSize == maxSize)
+    if (CPLAtomicInc(&currentSize) > maxSize && !_EvictOneDataset())
     {
-        if (lastEntryWithZeroRefCount == NULL)
+        CPLError(CE_Failure, CPLE_AppDefined,
+                 "Too many threads are running for the current value of the dataset pool size (%d).\n"
+                 "or too many proxy datasets are opened in a cascaded way.\n"
+                 "Try increasing GDAL_MAX_DATASET_POOL_SIZE.", maxSize);
         {
-            CPLError(CE_Failure, CPLE_AppDefined,
-                     "Too many threads are running for the current value of the dataset pool size (%d).\n"
-                     "or too many proxy datasets are opened in a cascaded way.\n"
-                     "Try increasing GDAL_MAX_DATASET_POOL_SIZE.", maxSize);
-            return NULL;
+            CPLMutexHolderD( &(oShard.hMutex) );
+            Unlink(oShard, cur);
         }
+        _CloseEntry(cur);
+        return NULL;
+    }
 
-        lastEntryWithZeroRefCount->pszFileName[0] = '\0';
-        if (lastEntryWithZeroRefCount->poDS)
-        {
-            /* Close by pretending we are the thread that GDALOpen'ed this */
-            /* dataset */
-            GDALSetResponsiblePIDForCurrentThread(lastEntryWithZeroRefCount->responsiblePID);
-
-            refCountOfDisableRefCount ++;
-            GDALClose(lastEntryWithZeroRefCount->poDS);
-            refCountOfDisableRefCount --;
+/* -------------------------------------------------------------------- */
+/*      Open the dataset.                                               */
+/* -------------------------------------------------------------------- */
+    GDALDataset* poDS = NULL;
+    {
+        CPLMutexHolderD( GDALGetphDLMutex() );
+        refCountOfDisableRefCount ++;
+        int nFlag = ((eAccess == GA_Update) ? GDAL_OF_UPDATE : GDAL_OF_READONLY) | GDAL_OF_RASTER | GDAL_OF_VERBOSE_ERROR;
+        poDS = (GDALDataset*) GDALOpenEx( pszFileName, nFlag, NULL,
+                               (const char* const* )papszOpenOptions, NULL );
+        refCountOfDisableRefCount --;
+    }
 
-            lastEntryWithZeroRefCount->poDS = NULL;
-            GDALSetResponsiblePIDForCurrentThread(responsiblePID);
-        }
-        CPLFree(lastEntryWithZeroRefCount->pszFileName);
-
-        /* Recycle this entry for the to-be-opened dataset and */
-        /* moves it to the top of the list */
-        if (lastEntryWithZeroRefCount->prev)
-            lastEntryWithZeroRefCount->prev->next = lastEntryWithZeroRefCount->next;
-        else {
-            CPLAssert(0);
-        }
-        if (lastEntryWithZeroRefCount->next)
-            lastEntryWithZeroRefCount->next->prev = lastEntryWithZeroRefCount->prev;
+    {
+        CPLMutexHolderD( &(oShard.hMutex) );
+        if( poDS == NULL )
+            Unlink(oShard, cur);
         else
-        {
-            CPLAssert(lastEntryWithZeroRefCount == lastEntry);
-            lastEntry->prev->next = NULL;
-            lastEntry = lastEntry->prev;
-        }
-        lastEntryWithZeroRefCount->prev = NULL;
-        lastEntryWithZeroRefCount->next = firstEntry;
-        firstEntry->prev = lastEntryWithZeroRefCount;
-        cur = firstEntry = lastEntryWithZeroRefCount;
-#ifdef DEBUG_PROXY_POOL
-        CheckLinks();
-#endif
+            cur->poDS = poDS;
     }
-    else
+    if( poDS == NULL )
     {
-        /* Prepend */
-        cur = (GDALProxyPoolCacheEntry*) CPLMalloc(sizeof(GDALProxyPoolCacheEntry));
-        if (lastEntry == NULL)
-            lastEntry = cur;
-        cur->prev = NULL;
-        cur->next = firstEntry;
-        if (firstEntry)
-            firstEntry->prev = cur;
-        firstEntry = cur;
-        currentSize ++;
-#ifdef DEBUG_PROXY_POOL
-        CheckLinks();
-#endif
+        _CloseEntry(cur);
+        return NULL;
     }
 
-    cur->pszFileName = CPLStrdup(pszFileName);
-    cur->responsiblePID = responsiblePID;
-    cur->refCount = 1;
+    return cur;
+}
 
-    refCountOfDisableRefCount ++;
-    int nFlag = ((eAccess == GA_Update) ? GDAL_OF_UPDATE : GDAL_OF_READONLY) | GDAL_OF_RASTER | GDAL_OF_VERBOSE_ERROR;
-    cur->poDS = (GDALDataset*) GDALOpenEx( pszFileName, nFlag, NULL,
-                           (const char* const* )papszOpenOptions, NULL );
-    refCountOfDisableRefCount --;
+/************************************************************************/
+/*                           _UnrefDataset()                            */
+/************************************************************************/
 
-    return cur;
+void GDALDatasetPool::_UnrefDataset(const char* pszFileName, GDALDataset* poDS)
+{
+    GDALDatasetPoolShard& oShard = GetShard(pszFileName);
+    CPLMutexHolderD( &(oShard.hMutex) );
+
+    /* The dataset is normally identified by its pointer. But in case */
+    /* the caller got it from a raster band that is not attached to the */
+    /* dataset that we opened, fallback to the dataset of that file used */
+    /* by this thread. */
+    GDALProxyPoolCacheEntry* entry = NULL;
+    const GIntBig nThisThread = CPLGetPID();
+    for( GDALProxyPoolCacheEntry* cur = oShard.firstEntry;
+         cur != NULL; cur = cur->next )
+    {
+        if( cur->refCount == 0 || cur->poDS == NULL )
+            continue;
+        if( cur->poDS == poDS )
+        {
+            entry = cur;
+            break;
+        }
+        if( entry == NULL && cur->ownerThread == nThisThread &&
+            strcmp(cur->pszFileName, pszFileName) == 0 )
+        {
+            entry = cur;
+        }
+    }
+    CPLAssert(entry != NULL);
+    if( entry == NULL )
+        return;
+
+    entry->refCount --;
+    if( entry->refCount == 0 )
+        entry->lastUse = static_cast<unsigned int>(CPLAtomicInc(&useCounter));
 }
 
 /************************************************************************/
@@ -322,36 +560,74 @@ GDALProxyPoolCacheEntry* GDALDatasetPool::_RefDataset(const char* pszFileName,
 
 void GDALDatasetPool::_CloseDataset(const char* pszFileName, CPL_UNUSED GDALAccess eAccess)
 {
-    GDALProxyPoolCacheEntry* cur = firstEntry;
-    GIntBig responsiblePID = GDALGetResponsiblePIDForCurrentThread();
+    GDALDatasetPoolShard& oShard = GetShard(pszFileName);
 
-    while(cur)
+    /* Close all the datasets of that file not currently in use */
+    GDALProxyPoolCacheEntry* toClose = NULL;
     {
-        GDALProxyPoolCacheEntry* next = cur->next;
-
-        CPLAssert(cur->pszFileName);
-        if (strcmp(cur->pszFileName, pszFileName) == 0 && cur->refCount == 0 &&
-            cur->poDS != NULL )
+        CPLMutexHolderD( &(oShard.hMutex) );
+        GDALProxyPoolCacheEntry* cur = oShard.firstEntry;
+        while(cur)
         {
-            /* Close by pretending we are the thread that GDALOpen'ed this */
-            /* dataset */
-            GDALSetResponsiblePIDForCurrentThread(cur->responsiblePID);
+            GDALProxyPoolCacheEntry* next = cur->next;
 
-            refCountOfDisableRefCount ++;
-            GDALClose(cur->poDS);
-            refCountOfDisableRefCount --;
-
-            GDALSetResponsiblePIDForCurrentThread(responsiblePID);
+            CPLAssert(cur->pszFileName);
+            if (strcmp(cur->pszFileName, pszFileName) == 0 && cur->refCount == 0 &&
+                cur->poDS != NULL )
+            {
+                Unlink(oShard, cur);
+                cur->next = toClose;
+                toClose = cur;
+            }
 
-            cur->poDS = NULL;
-            cur->pszFileName[0] = '\0';
-            break;
+            cur = next;
         }
+    }
 
-        cur = next;
+    while( toClose )
+    {
+        GDALProxyPoolCacheEntry* next = toClose->next;
+        _CloseEntry(toClose);
+        toClose = next;
     }
 }
 
+/************************************************************************/
+/*                           ComputeMaxSize()                           */
+/************************************************************************/
+
+/* Size of the pool, from the GDAL_MAX_DATASET_POOL_SIZE configuration */
+/* option, limited by GetMaxAllowedSize() */
+int GDALDatasetPool::ComputeMaxSize(bool bVerbose)
+{
+    int l_maxSize = atoi(CPLGetConfigOption("GDAL_MAX_DATASET_POOL_SIZE", "100"));
+    if (l_maxSize < 2)
+        l_maxSize = 100;
+    const int nMaxAllowedSize = GetMaxAllowedSize();
+    if (l_maxSize > nMaxAllowedSize)
+    {
+        if( bVerbose )
+            CPLDebug("GDAL",
+                     "Limiting the dataset pool size to %d, due to the "
+                     "maximum number of opened files",
+                     nMaxAllowedSize);
+        l_maxSize = nMaxAllowedSize;
+    }
+    return l_maxSize;
+}
+
+/************************************************************************/
+/*                             GetMaxSize()                             */
+/************************************************************************/
+
+int GDALDatasetPool::GetMaxSize()
+{
+    CPLMutexHolderD( GDALGetphDLMutex() );
+    if (singleton != NULL)
+        return singleton->maxSize;
+    return ComputeMaxSize(false);
+}
+
 /************************************************************************/
 /*                                 Ref()                                */
 /************************************************************************/
@@ -361,10 +637,7 @@ void GDALDatasetPool::Ref()
     CPLMutexHolderD( GDALGetphDLMutex() );
     if (singleton == NULL)
     {
-        int l_maxSize = atoi(CPLGetConfigOption("GDAL_MAX_DATASET_POOL_SIZE", "100"));
-        if (l_maxSize < 2 || l_maxSize > 1000)
-            l_maxSize = 100;
-        singleton = new GDALDatasetPool(l_maxSize);
+        singleton = new GDALDatasetPool(ComputeMaxSize(true));
     }
     if (singleton->refCountOfDisableRefCount == 0)
       singleton->refCount++;
@@ -441,7 +714,6 @@ GDALProxyPoolCacheEntry* GDALDatasetPool::RefDataset(const char* pszFileName,
                                                      char** papszOpenOptions,
                                                      int bShared)
 {
-    CPLMutexHolderD( GDALGetphDLMutex() );
     return singleton->_RefDataset(pszFileName, eAccess, papszOpenOptions, bShared);
 }
 
@@ -449,10 +721,9 @@ GDALProxyPoolCacheEntry* GDALDatasetPool::RefDataset(const char* pszFileName,
 /*                       UnrefDataset()                                 */
 /************************************************************************/
 
-void GDALDatasetPool::UnrefDataset(GDALProxyPoolCacheEntry* cacheEntry)
+void GDALDatasetPool::UnrefDataset(const char* pszFileName, GDALDataset* poDS)
 {
-    CPLMutexHolderD( GDALGetphDLMutex() );
-    cacheEntry->refCount --;
+    singleton->_UnrefDataset(pszFileName, poDS);
 }
 
 /************************************************************************/
@@ -461,7 +732,6 @@ void GDALDatasetPool::UnrefDataset(GDALProxyPoolCacheEntry* cacheEntry)
 
 void GDALDatasetPool::CloseDataset(const char* pszFileName, GDALAccess eAccess)
 {
-    CPLMutexHolderD( GDALGetphDLMutex() );
     singleton->_CloseDataset(pszFileName, eAccess);
 }
 
@@ -596,7 +866,6 @@ GDALProxyPoolDataset::GDALProxyPoolDataset(const char* pszSourceDatasetDescripti
     pasGCPList = NULL;
     metadataSet = NULL;
     metadataItemSet = NULL;
-    cacheEntry = NULL;
 }
 
 /************************************************************************/
@@ -668,16 +937,12 @@ GDALDataset* GDALProxyPoolDataset::RefUnderlyingDataset()
     /* a VRT of GeoTIFFs that have associated .aux files */
     GIntBig curResponsiblePID = GDALGetResponsiblePIDForCurrentThread();
     GDALSetResponsiblePIDForCurrentThread(responsiblePID);
-    cacheEntry = GDALDatasetPool::RefDataset(GetDescription(), eAccess, papszOpenOptions,
-                                             GetShared());
+    GDALProxyPoolCacheEntry* cacheEntry =
+        GDALDatasetPool::RefDataset(GetDescription(), eAccess, papszOpenOptions,
+                                    GetShared());
     GDALSetResponsiblePIDForCurrentThread(curResponsiblePID);
     if (cacheEntry != NULL)
-    {
-        if (cacheEntry->poDS != NULL)
-            return cacheEntry->poDS;
-        else
-            GDALDatasetPool::UnrefDataset(cacheEntry);
-    }
+        return cacheEntry->poDS;
     return NULL;
 }
 
@@ -685,14 +950,9 @@ GDALDataset* GDALProxyPoolDataset::RefUnderlyingDataset()
 /*                    UnrefUnderlyingDataset()                        */
 /************************************************************************/
 
-void GDALProxyPoolDataset::UnrefUnderlyingDataset(CPL_UNUSED GDALDataset* poUnderlyingDataset)
+void GDALProxyPoolDataset::UnrefUnderlyingDataset(GDALDataset* poUnderlyingDataset)
 {
-    if (cacheEntry != NULL)
-    {
-        CPLAssert(cacheEntry->poDS == poUnderlyingDataset);
-        if (cacheEntry->poDS != NULL)
-            GDALDatasetPool::UnrefDataset(cacheEntry);
-    }
+    GDALDatasetPool::UnrefDataset(GetDescription(), poUnderlyingDataset);
 }
 
 /************************************************************************/
@@ -900,6 +1160,19 @@ void GDALProxyPoolDatasetAddSrcBandDescription( GDALProxyPoolDatasetH hProxyPool
             AddSrcBandDescription(eDataType, nBlockXSize, nBlockYSize);
 }
 
+/************************************************************************/
+/*                        GDALProxyPoolGetMaxSize()                     */
+/************************************************************************/
+
+/* Return the maximum number of datasets that can be opened at the same */
+/* time by the pool. As a dataset referenced by a thread cannot be closed, */
+/* this bounds the number of threads that can access proxy pool datasets */
+/* concurrently. */
+int GDALProxyPoolGetMaxSize()
+{
+    return GDALDatasetPool::GetMaxSize();
+}
+
 /* ******************************************************************** */
 /*                    GDALProxyPoolRasterBand()                         */
 /* ******************************************************************** */
@@ -1238,9 +1511,6 @@ GDALProxyPoolOverviewRasterBand::GDALProxyPoolOverviewRasterBand(GDALProxyPoolDa
 {
     poMainBand = poMainBandIn;
     nOverviewBand = nOverviewBandIn;
-
-    poUnderlyingMainRasterBand = NULL;
-    nRefCountUnderlyingMainRasterBand = 0;
 }
 
 /* ******************************************************************** */
@@ -1249,7 +1519,6 @@ GDALProxyPoolOverviewRasterBand::GDALProxyPoolOverviewRasterBand(GDALProxyPoolDa
 
 GDALProxyPoolOverviewRasterBand::~GDALProxyPoolOverviewRasterBand()
 {
-    CPLAssert(nRefCountUnderlyingMainRasterBand == 0);
 }
 
 /* ******************************************************************** */
@@ -1258,22 +1527,28 @@ GDALProxyPoolOverviewRasterBand::~GDALProxyPoolOverviewRasterBand()
 
 GDALRasterBand* GDALProxyPoolOverviewRasterBand::RefUnderlyingRasterBand()
 {
-    poUnderlyingMainRasterBand = poMainBand->RefUnderlyingRasterBand();
+    /* The reference on the main band is not kept in a member, as several */
+    /* threads may use this band at the same time. */
+    GDALRasterBand* poUnderlyingMainRasterBand =
+        poMainBand->RefUnderlyingRasterBand();
     if (poUnderlyingMainRasterBand == NULL)
         return NULL;
 
-    nRefCountUnderlyingMainRasterBand ++;
-    return poUnderlyingMainRasterBand->GetOverview(nOverviewBand);
+    GDALRasterBand* poBand = poUnderlyingMainRasterBand->GetOverview(nOverviewBand);
+    if (poBand == NULL)
+        poMainBand->UnrefUnderlyingRasterBand(poUnderlyingMainRasterBand);
+    return poBand;
 }
 
 /* ******************************************************************** */
 /*                  UnrefUnderlyingRasterBand()                         */
 /* ******************************************************************** */
 
-void GDALProxyPoolOverviewRasterBand::UnrefUnderlyingRasterBand(CPL_UNUSED GDALRasterBand* poUnderlyingRasterBand)
+void GDALProxyPoolOverviewRasterBand::UnrefUnderlyingRasterBand(GDALRasterBand* poUnderlyingRasterBand)
 {
-    poMainBand->UnrefUnderlyingRasterBand(poUnderlyingMainRasterBand);
-    nRefCountUnderlyingMainRasterBand --;
+    /* The band may not be attached to the dataset that was referenced, */
+    /* in which case the pool releases the one referenced by this thread. */
+    poMainBand->UnrefUnderlyingRasterBand(poUnderlyingRasterBand);
 }
 
 
@@ -1287,9 +1562,6 @@ GDALProxyPoolMaskBand::GDALProxyPoolMaskBand(GDALProxyPoolDataset* poDSIn,
         GDALProxyPoolRasterBand(poDSIn, poUnderlyingMaskBand)
 {
     poMainBand = poMainBandIn;
-
-    poUnderlyingMainRasterBand = NULL;
-    nRefCountUnderlyingMainRasterBand = 0;
 }
 
 /* ******************************************************************** */
@@ -1303,9 +1575,6 @@ GDALProxyPoolMaskBand::GDALProxyPoolMaskBand(GDALProxyPoolDataset* poDSIn,
         GDALProxyPoolRasterBand(poDSIn, 1, eDataTypeIn, nBlockXSizeIn, nBlockYSizeIn)
 {
     poMainBand = poMainBandIn;
-
-    poUnderlyingMainRasterBand = NULL;
-    nRefCountUnderlyingMainRasterBand = 0;
 }
 
 /* ******************************************************************** */
@@ -1314,7 +1583,6 @@ GDALProxyPoolMaskBand::GDALProxyPoolMaskBand(GDALProxyPoolDataset* poDSIn,
 
 GDALProxyPoolMaskBand::~GDALProxyPoolMaskBand()
 {
-    CPLAssert(nRefCountUnderlyingMainRasterBand == 0);
 }
 
 /* ******************************************************************** */
@@ -1323,20 +1591,26 @@ GDALProxyPoolMaskBand::~GDALProxyPoolMaskBand()
 
 GDALRasterBand* GDALProxyPoolMaskBand::RefUnderlyingRasterBand()
 {
-    poUnderlyingMainRasterBand = poMainBand->RefUnderlyingRasterBand();
+    /* The reference on the main band is not kept in a member, as several */
+    /* threads may use this band at the same time. */
+    GDALRasterBand* poUnderlyingMainRasterBand =
+        poMainBand->RefUnderlyingRasterBand();
     if (poUnderlyingMainRasterBand == NULL)
         return NULL;
 
-    nRefCountUnderlyingMainRasterBand ++;
-    return poUnderlyingMainRasterBand->GetMaskBand();
+    GDALRasterBand* poBand = poUnderlyingMainRasterBand->GetMaskBand();
+    if (poBand == NULL)
+        poMainBand->UnrefUnderlyingRasterBand(poUnderlyingMainRasterBand);
+    return poBand;
 }
 
 /* ******************************************************************** */
 /*                  UnrefUnderlyingRasterBand()                         */
 /* ******************************************************************** */
 
-void GDALProxyPoolMaskBand::UnrefUnderlyingRasterBand(CPL_UNUSED GDALRasterBand* poUnderlyingRasterBand)
+void GDALProxyPoolMaskBand::UnrefUnderlyingRasterBand(GDALRasterBand* poUnderlyingRasterBand)
 {
-    poMainBand->UnrefUnderlyingRasterBand(poUnderlyingMainRasterBand);
-    nRefCountUnderlyingMainRasterBand --;
+    /* The band may not be attached to the dataset that was referenced, */
+    /* in which case the pool releases the one referenced by this thread. */
+    poMainBand->UnrefUnderlyingRasterBand(poUnderlyingRasterBand);
 }
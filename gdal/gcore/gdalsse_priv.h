@@ -149,6 +149,13 @@ class XMMReg2Double
         return reg;
     }
 
+    static inline XMMReg2Double Sqrt(const XMMReg2Double& expr)
+    {
+        XMMReg2Double reg;
+        reg.xmm = _mm_sqrt_pd(expr.xmm);
+        return reg;
+    }
+
     inline void nsLoad1ValHighAndLow(const double* ptr)
     {
         xmm =  _mm_load1_pd(ptr);
@@ -450,6 +457,14 @@ class XMMReg2Double
         return reg;
     }
 
+    static inline XMMReg2Double Sqrt(const XMMReg2Double& expr)
+    {
+        XMMReg2Double reg;
+        reg.low = sqrt(expr.low);
+        reg.high = sqrt(expr.high);
+        return reg;
+    }
+
     static inline XMMReg2Double Load2Val(const double* ptr)
     {
         XMMReg2Double reg;
@@ -41,6 +41,7 @@
 #define SPACE_FOR_BBOX  130
 
 class OGRGeoJSONDataSource;
+class OGRGeoJSONReader;
 
 /************************************************************************/
 /*                           OGRGeoJSONLayer                            */
@@ -67,16 +68,27 @@ public:
     virtual int         TestCapability( const char * pszCap );
 
     virtual OGRErr      SyncToDisk();
+
+    virtual void        ResetReading();
+    virtual OGRFeature* GetNextFeature();
+    virtual OGRFeature* GetFeature( GIntBig nFID );
+    virtual OGRErr      SetNextByIndex( GIntBig nIndex );
+    virtual GIntBig     GetFeatureCount( int bForce = TRUE );
+
     //
     // OGRGeoJSONLayer Interface
     //
     void SetFIDColumn( const char* pszFIDColumn );
     void AddFeature( OGRFeature* poFeature );
     void DetectGeometryType();
+    void SetReader( OGRGeoJSONReader* poReader );
 
 private:
 
     OGRGeoJSONDataSource* poDS_;
+    // Set when features are read on demand from the file, in which case
+    // the in-memory feature store of OGRMemLayer is not used.
+    OGRGeoJSONReader* poReader_;
     CPLString sFIDColumn_;
     bool bUpdated_;
     bool bOriginalIdModified_;
@@ -209,7 +221,10 @@ private:
     void Clear();
     int ReadFromFile( GDALOpenInfo* poOpenInfo );
     int ReadFromService( const char* pszSource );
+    bool LoadLayerStreaming( GDALOpenInfo* poOpenInfo );
     void LoadLayers(char** papszOpenOptions);
+    void SetOptionsOnReader( OGRGeoJSONReader& oReader,
+                             char** papszOpenOptions );
 };
 
 
@@ -34,6 +34,7 @@
 #include <cpl_http.h>
 #include <json.h> // JSON-C
 #include "ogrgeojsonwriter.h"
+#include <cctype>
 #include <cstddef>
 #include <cstdlib>
 using namespace std;
@@ -87,6 +88,8 @@ int OGRGeoJSONDataSource::Open( GDALOpenInfo* poOpenInfo,
     }
     else if( eGeoJSONSourceFile == nSrcType )
     {
+        if( LoadLayerStreaming( poOpenInfo ) )
+            return TRUE;
         if( !ReadFromFile( poOpenInfo ) )
             return FALSE;
     }
@@ -463,6 +466,69 @@ int OGRGeoJSONDataSource::ReadFromFile( GDALOpenInfo* poOpenInfo )
     return TRUE;
 }
 
+/************************************************************************/
+/*                         LoadLayerStreaming()                         */
+/************************************************************************/
+
+/* Read a FeatureCollection from a file without ingesting it, when the  */
+/* file is opened in read-only mode. Returns false if the regular,      */
+/* in-memory, reading must be used instead.                             */
+bool OGRGeoJSONDataSource::LoadLayerStreaming( GDALOpenInfo* poOpenInfo )
+{
+    if( poOpenInfo->eAccess == GA_Update || poOpenInfo->fpL == NULL ||
+        poOpenInfo->pabyHeader == NULL ||
+        STARTS_WITH(poOpenInfo->pszFilename, "/vsistdin/") ||
+        !CPLTestBool(CPLGetConfigOption("OGR_GEOJSON_STREAMING", "YES")) )
+    {
+        return false;
+    }
+
+    // ESRI JSON, TopoJSON and JSONP are handled by LoadLayers().
+    const char* pszHeader =
+        reinterpret_cast<const char*>(poOpenInfo->pabyHeader);
+    if( STARTS_WITH(pszHeader, "\xEF\xBB\xBF") )
+        pszHeader += 3;
+    while( isspace(static_cast<unsigned char>(*pszHeader)) )
+        pszHeader++;
+    if( *pszHeader != '{' ||
+        strstr(pszHeader, "esriGeometry") != NULL ||
+        strstr(pszHeader, "esriFieldType") != NULL ||
+        strstr(pszHeader, "\"Topology\"") != NULL )
+    {
+        return false;
+    }
+
+    OGRGeoJSONReader* poReader = new OGRGeoJSONReader();
+    SetOptionsOnReader( *poReader, poOpenInfo->papszOpenOptions );
+
+    pszName_ = CPLStrdup( poOpenInfo->pszFilename );
+    if( !poReader->FirstPassReadLayer( this, poOpenInfo->fpL ) )
+    {
+        CPLDebug( "GeoJSON", "Cannot use streaming reading for %s",
+                  poOpenInfo->pszFilename );
+        delete poReader;
+        CPLFree( pszName_ );
+        pszName_ = NULL;
+        return false;
+    }
+
+    // The reader, owned by the layer, now owns the file handle.
+    poOpenInfo->fpL = NULL;
+
+    json_object* poObj = poReader->GetJSonObject();
+    json_object* poProperties = json_object_object_get(poObj, "properties");
+    if( poProperties && json_object_get_type(poProperties) == json_type_object )
+    {
+        json_object* poExceededTransferLimit =
+            json_object_object_get(poProperties, "exceededTransferLimit");
+        if( poExceededTransferLimit && json_object_get_type(poExceededTransferLimit) == json_type_boolean )
+          bOtherPages_ = CPL_TO_BOOL(
+              json_object_get_boolean(poExceededTransferLimit) );
+    }
+
+    return true;
+}
+
 /************************************************************************/
 /*                           ReadFromService()                          */
 /************************************************************************/
@@ -620,30 +686,7 @@ void OGRGeoJSONDataSource::LoadLayers(char** papszOpenOptionsIn)
 /*      Configure GeoJSON format translator.                            */
 /* -------------------------------------------------------------------- */
     OGRGeoJSONReader reader;
-
-    if( eGeometryAsCollection == flTransGeom_ )
-    {
-        reader.SetPreserveGeometryType( false );
-        CPLDebug( "GeoJSON", "Geometry as OGRGeometryCollection type." );
-    }
-
-    if( eAttributesSkip == flTransAttrs_ )
-    {
-        reader.SetSkipAttributes( true );
-        CPLDebug( "GeoJSON", "Skip all attributes." );
-    }
-
-    reader.SetFlattenNestedAttributes(
-        CPL_TO_BOOL(CSLFetchBoolean(papszOpenOptionsIn, "FLATTEN_NESTED_ATTRIBUTES", FALSE)),
-        CSLFetchNameValueDef(papszOpenOptionsIn, "NESTED_ATTRIBUTE_SEPARATOR", "_")[0]);
-
-    const int bDefaultNativeData = bUpdatable_ ? TRUE : FALSE ;
-    reader.SetStoreNativeData(
-        CPL_TO_BOOL(CSLFetchBoolean(papszOpenOptionsIn, "NATIVE_DATA", bDefaultNativeData)));
-
-    reader.SetArrayAsString(
-        CPLTestBool(CSLFetchNameValueDef(papszOpenOptionsIn, "ARRAY_AS_STRING",
-                CPLGetConfigOption("OGR_GEOJSON_ARRAY_AS_STRING", "NO"))));
+    SetOptionsOnReader( reader, papszOpenOptionsIn );
 
 /* -------------------------------------------------------------------- */
 /*      Parse GeoJSON and build valid OGRLayer instance.                */
@@ -671,6 +714,38 @@ void OGRGeoJSONDataSource::LoadLayers(char** papszOpenOptionsIn)
     return;
 }
 
+/************************************************************************/
+/*                         SetOptionsOnReader()                         */
+/************************************************************************/
+
+void OGRGeoJSONDataSource::SetOptionsOnReader( OGRGeoJSONReader& oReader,
+                                               char** papszOpenOptionsIn )
+{
+    if( eGeometryAsCollection == flTransGeom_ )
+    {
+        oReader.SetPreserveGeometryType( false );
+        CPLDebug( "GeoJSON", "Geometry as OGRGeometryCollection type." );
+    }
+
+    if( eAttributesSkip == flTransAttrs_ )
+    {
+        oReader.SetSkipAttributes( true );
+        CPLDebug( "GeoJSON", "Skip all attributes." );
+    }
+
+    oReader.SetFlattenNestedAttributes(
+        CPL_TO_BOOL(CSLFetchBoolean(papszOpenOptionsIn, "FLATTEN_NESTED_ATTRIBUTES", FALSE)),
+        CSLFetchNameValueDef(papszOpenOptionsIn, "NESTED_ATTRIBUTE_SEPARATOR", "_")[0]);
+
+    const int bDefaultNativeData = bUpdatable_ ? TRUE : FALSE ;
+    oReader.SetStoreNativeData(
+        CPL_TO_BOOL(CSLFetchBoolean(papszOpenOptionsIn, "NATIVE_DATA", bDefaultNativeData)));
+
+    oReader.SetArrayAsString(
+        CPLTestBool(CSLFetchNameValueDef(papszOpenOptionsIn, "ARRAY_AS_STRING",
+                CPLGetConfigOption("OGR_GEOJSON_ARRAY_AS_STRING", "NO"))));
+}
+
 /************************************************************************/
 /*                            AddLayer()                                */
 /************************************************************************/
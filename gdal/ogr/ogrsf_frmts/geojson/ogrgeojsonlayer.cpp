@@ -30,6 +30,7 @@
 #include <algorithm> // for_each, find_if
 #include <json.h> // JSON-C
 #include "ogr_geojson.h"
+#include "ogrgeojsonreader.h"
 
 /* Remove annoying warnings Microsoft Visual C++ */
 #if defined(_MSC_VER)
@@ -51,8 +52,8 @@ OGRGeoJSONLayer::OGRGeoJSONLayer( const char* pszName,
                                   OGRSpatialReference* poSRSIn,
                                   OGRwkbGeometryType eGType,
                                   OGRGeoJSONDataSource* poDS )
-  : OGRMemLayer( pszName, poSRSIn, eGType), poDS_(poDS), bUpdated_(false),
-    bOriginalIdModified_(false)
+  : OGRMemLayer( pszName, poSRSIn, eGType), poDS_(poDS), poReader_(NULL),
+    bUpdated_(false), bOriginalIdModified_(false)
 {
     SetAdvertizeUTF8(true);
     SetUpdatable( poDS->IsUpdatable() );
@@ -64,6 +65,7 @@ OGRGeoJSONLayer::OGRGeoJSONLayer( const char* pszName,
 
 OGRGeoJSONLayer::~OGRGeoJSONLayer()
 {
+    delete poReader_;
 }
 
 /************************************************************************/
@@ -96,6 +98,91 @@ int OGRGeoJSONLayer::TestCapability( const char * pszCap )
     return OGRMemLayer::TestCapability(pszCap);
 }
 
+/************************************************************************/
+/*                             SetReader()                              */
+/************************************************************************/
+
+void OGRGeoJSONLayer::SetReader( OGRGeoJSONReader* poReader )
+{
+    delete poReader_;
+    poReader_ = poReader;
+}
+
+/************************************************************************/
+/*                           ResetReading()                             */
+/************************************************************************/
+
+void OGRGeoJSONLayer::ResetReading()
+{
+    if( poReader_ != NULL )
+        poReader_->ResetReading();
+    else
+        OGRMemLayer::ResetReading();
+}
+
+/************************************************************************/
+/*                           GetNextFeature()                           */
+/************************************************************************/
+
+OGRFeature* OGRGeoJSONLayer::GetNextFeature()
+{
+    if( poReader_ == NULL )
+        return OGRMemLayer::GetNextFeature();
+
+    while( true )
+    {
+        OGRFeature* poFeature = poReader_->GetNextFeature(this);
+        if( poFeature == NULL )
+            return NULL;
+        if( (m_poFilterGeom == NULL
+             || FilterGeometry( poFeature->GetGeomFieldRef(m_iGeomFieldFilter) ) )
+            && (m_poAttrQuery == NULL
+                || m_poAttrQuery->Evaluate( poFeature ) ) )
+        {
+            m_nFeaturesRead++;
+            return poFeature;
+        }
+        delete poFeature;
+    }
+}
+
+/************************************************************************/
+/*                             GetFeature()                             */
+/************************************************************************/
+
+OGRFeature* OGRGeoJSONLayer::GetFeature( GIntBig nFID )
+{
+    if( poReader_ != NULL )
+        return poReader_->GetFeature(this, nFID);
+    return OGRMemLayer::GetFeature(nFID);
+}
+
+/************************************************************************/
+/*                           SetNextByIndex()                           */
+/************************************************************************/
+
+OGRErr OGRGeoJSONLayer::SetNextByIndex( GIntBig nIndex )
+{
+    if( poReader_ == NULL )
+        return OGRMemLayer::SetNextByIndex(nIndex);
+    if( m_poFilterGeom != NULL || m_poAttrQuery != NULL )
+        return OGRLayer::SetNextByIndex(nIndex);
+    return poReader_->SetNextByIndex(nIndex);
+}
+
+/************************************************************************/
+/*                          GetFeatureCount()                           */
+/************************************************************************/
+
+GIntBig OGRGeoJSONLayer::GetFeatureCount( int bForce )
+{
+    if( poReader_ == NULL )
+        return OGRMemLayer::GetFeatureCount(bForce);
+    if( m_poFilterGeom != NULL || m_poAttrQuery != NULL )
+        return OGRLayer::GetFeatureCount(bForce);
+    return poReader_->GetFeatureCount();
+}
+
 /************************************************************************/
 /*                           SyncToDisk()                               */
 /************************************************************************/
@@ -167,6 +254,10 @@ void OGRGeoJSONLayer::AddFeature( OGRFeature* poFeature )
 
 void OGRGeoJSONLayer::DetectGeometryType()
 {
+    // Already done by the first pass of the streaming reader.
+    if( poReader_ != NULL )
+        return;
+
     if (GetLayerDefn()->GetGeomType() != wkbUnknown)
         return;
 
@@ -30,8 +30,10 @@
 #include "ogrgeojsonreader.h"
 #include "ogrgeojsonutils.h"
 #include "ogr_geojson.h"
+#include "cpl_json_streaming_parser.h"
 #include <json.h> // JSON-C
 #include <ogr_api.h>
+#include <algorithm>
 
 /************************************************************************/
 /*                           OGRGeoJSONReader                           */
@@ -50,7 +52,12 @@ OGRGeoJSONReader::OGRGeoJSONReader() :
     bFoundRev(false),
     bFoundTypeFeature(false),
     bIsGeocouchSpatiallistFormat(false),
-    bFoundFeatureId(false)
+    bFoundFeatureId(false),
+    fp_(NULL),
+    bFIDIsIndex_(true),
+    nNextFeature_(0),
+    bFirstGeometry_(true),
+    eLayerGeomType_(wkbUnknown)
 { }
 
 /************************************************************************/
@@ -65,6 +72,9 @@ OGRGeoJSONReader::~OGRGeoJSONReader()
     }
 
     poGJObject_ = NULL;
+
+    if( fp_ != NULL )
+        VSIFCloseL(fp_);
 }
 
 /************************************************************************/
@@ -436,6 +446,17 @@ bool OGRGeoJSONReader::GenerateLayerDefn( OGRGeoJSONLayer* poLayer, json_object*
         }
     }
 
+    SetFIDColumnFromLayerDefn( poLayer );
+
+    return bSuccess;
+}
+
+/************************************************************************/
+/*                     SetFIDColumnFromLayerDefn()                      */
+/************************************************************************/
+
+void OGRGeoJSONReader::SetFIDColumnFromLayerDefn( OGRGeoJSONLayer* poLayer )
+{
 /* -------------------------------------------------------------------- */
 /*      Validate and add FID column if necessary.                       */
 /* -------------------------------------------------------------------- */
@@ -454,8 +475,6 @@ bool OGRGeoJSONReader::GenerateLayerDefn( OGRGeoJSONLayer* poLayer, json_object*
             }
         }
     }
-
-    return bSuccess;
 }
 
 /************************************************************************/
@@ -1131,6 +1150,16 @@ OGRGeoJSONReader::ReadFeatureCollection( OGRGeoJSONLayer* poLayer, json_object*
         //CPLAssert( nFeatures == poLayer_->GetFeatureCount() );
     }
 
+    SetLayerNativeData( poLayer, poObj );
+}
+
+/************************************************************************/
+/*                         SetLayerNativeData()                         */
+/************************************************************************/
+
+void OGRGeoJSONReader::SetLayerNativeData( OGRGeoJSONLayer* poLayer,
+                                           json_object* poObj )
+{
     // Collect top objects except 'type' and the 'features' array
     if( bStoreNativeData_ )
     {
@@ -1173,6 +1202,924 @@ OGRGeoJSONReader::ReadFeatureCollection( OGRGeoJSONLayer* poLayer, json_object*
     }
 }
 
+/************************************************************************/
+/*                   OGRGeoJSONReaderStreamingParser                    */
+/************************************************************************/
+
+/* Event-based parsing of a FeatureCollection. The members of the       */
+/* "features" array are built as json-c objects one at a time and       */
+/* handed to the reader along with their location in the file, so that */
+/* the whole document never needs to be held in memory. The other       */
+/* members of the top-level object are collected in a json-c object.    */
+/*                                                                      */
+/* The geometry of the features, which makes most of their size, is    */
+/* not built: only its type and whether it has Z coordinates are        */
+/* collected from the parsing events.                                   */
+
+class OGRGeoJSONReaderStreamingParser : public CPLJSonStreamingParser
+{
+        OGRGeoJSONReader& m_oReader;
+        OGRGeoJSONLayer* m_poLayer;
+        vsi_l_offset m_nBaseOffset;
+
+        json_object* m_poRootObj;
+        json_object* m_poCurFeature;
+        std::vector<json_object*> m_apoCurObj;
+        CPLString m_osCurKey;
+        int m_nDepth;
+        bool m_bStartFeatures;
+        bool m_bInFeatures;
+        bool m_bFoundFeatures;
+        bool m_bIsFeatureCollection;
+        bool m_bGiveUp;
+        vsi_l_offset m_nFeatureStart;
+
+        // State of the analysis of the geometry of the current feature.
+        bool m_bStartGeometry;
+        bool m_bInGeometry;
+        int m_nGeometryDepth;
+        CPLString m_osGeomType;
+        bool m_bGeomHasCoordinates;
+        bool m_bGeomHasGeometries;
+        bool m_bGeomHasPosition;
+        bool m_bGeomHasZ;
+        int m_nCoordinatesDepth;
+        std::vector<int> m_anCoordinateCount;
+        OGRwkbGeometryType m_eCurGeomType;
+
+        void GiveUp() { m_bGiveUp = true; StopParsing(); }
+        bool AcceptValue();
+        void AppendObject( json_object* poObj );
+        bool SkipGeometryValue();
+        void StartGeometry();
+        void EndGeometry();
+
+    protected:
+        virtual void String( const char* pszValue, size_t nLength );
+        virtual void Number( const char* pszValue, size_t nLength );
+        virtual void Boolean( bool b );
+        virtual void Null();
+
+        virtual void StartObject();
+        virtual void EndObject();
+        virtual void StartObjectMember( const char* pszKey, size_t nLength );
+
+        virtual void StartArray();
+        virtual void EndArray();
+
+        virtual void Exception( const char* pszMessage );
+
+    public:
+        OGRGeoJSONReaderStreamingParser( OGRGeoJSONReader& oReader,
+                                         OGRGeoJSONLayer* poLayer,
+                                         vsi_l_offset nBaseOffset );
+        ~OGRGeoJSONReaderStreamingParser();
+
+        bool IsStreamable() const;
+        json_object* StealRootObject();
+};
+
+/************************************************************************/
+/*                  OGRGeoJSONReaderStreamingParser()                   */
+/************************************************************************/
+
+OGRGeoJSONReaderStreamingParser::OGRGeoJSONReaderStreamingParser(
+                                                OGRGeoJSONReader& oReader,
+                                                OGRGeoJSONLayer* poLayer,
+                                                vsi_l_offset nBaseOffset ) :
+    m_oReader(oReader),
+    m_poLayer(poLayer),
+    m_nBaseOffset(nBaseOffset),
+    m_poRootObj(NULL),
+    m_poCurFeature(NULL),
+    m_nDepth(0),
+    m_bStartFeatures(false),
+    m_bInFeatures(false),
+    m_bFoundFeatures(false),
+    m_bIsFeatureCollection(false),
+    m_bGiveUp(false),
+    m_nFeatureStart(0),
+    m_bStartGeometry(false),
+    m_bInGeometry(false),
+    m_nGeometryDepth(0),
+    m_bGeomHasCoordinates(false),
+    m_bGeomHasGeometries(false),
+    m_bGeomHasPosition(false),
+    m_bGeomHasZ(false),
+    m_nCoordinatesDepth(0),
+    m_eCurGeomType(wkbNone)
+{
+    // Same limit as the json-c tokener.
+    SetMaxDepth(JSON_TOKENER_DEFAULT_DEPTH);
+}
+
+/************************************************************************/
+/*                 ~OGRGeoJSONReaderStreamingParser()                   */
+/************************************************************************/
+
+OGRGeoJSONReaderStreamingParser::~OGRGeoJSONReaderStreamingParser()
+{
+    if( m_poCurFeature != NULL )
+        json_object_put(m_poCurFeature);
+    if( m_poRootObj != NULL )
+        json_object_put(m_poRootObj);
+}
+
+/************************************************************************/
+/*                            IsStreamable()                            */
+/************************************************************************/
+
+bool OGRGeoJSONReaderStreamingParser::IsStreamable() const
+{
+    return !m_bGiveUp && !ExceptionOccurred() && m_poRootObj != NULL &&
+           m_nDepth == 0 && m_bFoundFeatures && m_bIsFeatureCollection;
+}
+
+/************************************************************************/
+/*                          StealRootObject()                           */
+/************************************************************************/
+
+json_object* OGRGeoJSONReaderStreamingParser::StealRootObject()
+{
+    json_object* poRet = m_poRootObj;
+    m_poRootObj = NULL;
+    return poRet;
+}
+
+/************************************************************************/
+/*                             AcceptValue()                            */
+/************************************************************************/
+
+/* Scalar values are only expected as members of the top-level object   */
+/* (but not for "features") or within features.                         */
+bool OGRGeoJSONReaderStreamingParser::AcceptValue()
+{
+    if( m_nDepth == 0 || (m_nDepth == 1 && m_bStartFeatures) ||
+        (m_nDepth == 2 && m_bInFeatures) )
+    {
+        GiveUp();
+        return false;
+    }
+    return true;
+}
+
+/************************************************************************/
+/*                            AppendObject()                            */
+/************************************************************************/
+
+void OGRGeoJSONReaderStreamingParser::AppendObject( json_object* poObj )
+{
+    json_object* poParent = m_apoCurObj.back();
+    if( json_object_get_type(poParent) == json_type_object )
+        json_object_object_add(poParent, m_osCurKey, poObj);
+    else
+        json_object_array_add(poParent, poObj);
+}
+
+/************************************************************************/
+/*                         SkipGeometryValue()                          */
+/************************************************************************/
+
+/* Returns true if a scalar value is part of the geometry of a feature, */
+/* or is the geometry itself (null), and so must not be built.          */
+bool OGRGeoJSONReaderStreamingParser::SkipGeometryValue()
+{
+    if( m_bStartGeometry )
+    {
+        m_bStartGeometry = false;
+        m_eCurGeomType = wkbNone;
+        return true;
+    }
+    return m_bInGeometry;
+}
+
+/************************************************************************/
+/*                           StartGeometry()                            */
+/************************************************************************/
+
+void OGRGeoJSONReaderStreamingParser::StartGeometry()
+{
+    m_bStartGeometry = false;
+    m_bInGeometry = true;
+    m_nGeometryDepth = m_nDepth + 1;
+    m_osGeomType.clear();
+    m_bGeomHasCoordinates = false;
+    m_bGeomHasGeometries = false;
+    m_bGeomHasPosition = false;
+    m_bGeomHasZ = false;
+    m_nCoordinatesDepth = 0;
+    m_anCoordinateCount.clear();
+}
+
+/************************************************************************/
+/*                            EndGeometry()                             */
+/************************************************************************/
+
+/* Determine the type of the geometry, as OGRGeoJSONReadGeometry() would */
+/* return it. A geometry without a recognized type, or without          */
+/* coordinates (geometries for a collection), would not be read.        */
+void OGRGeoJSONReaderStreamingParser::EndGeometry()
+{
+    m_bInGeometry = false;
+
+    OGRwkbGeometryType eType = wkbNone;
+    if( EQUAL(m_osGeomType, "Point") )
+        eType = m_bGeomHasPosition ? wkbPoint : wkbNone;
+    else if( EQUAL(m_osGeomType, "LineString") )
+        eType = wkbLineString;
+    else if( EQUAL(m_osGeomType, "Polygon") )
+        eType = wkbPolygon;
+    else if( EQUAL(m_osGeomType, "MultiPoint") )
+        eType = wkbMultiPoint;
+    else if( EQUAL(m_osGeomType, "MultiLineString") )
+        eType = wkbMultiLineString;
+    else if( EQUAL(m_osGeomType, "MultiPolygon") )
+        eType = wkbMultiPolygon;
+
+    if( eType != wkbNone && !m_bGeomHasCoordinates )
+        eType = wkbNone;
+    if( EQUAL(m_osGeomType, "GeometryCollection") && m_bGeomHasGeometries )
+        eType = wkbGeometryCollection;
+
+    if( eType != wkbNone && m_bGeomHasZ )
+        eType = wkbSetZ(eType);
+    m_eCurGeomType = eType;
+}
+
+/************************************************************************/
+/*                               String()                               */
+/************************************************************************/
+
+void OGRGeoJSONReaderStreamingParser::String( const char* pszValue,
+                                              size_t nLength )
+{
+    if( SkipGeometryValue() )
+    {
+        if( m_nDepth == m_nGeometryDepth && EQUAL(m_osCurKey, "type") )
+            m_osGeomType.assign(pszValue, nLength);
+        return;
+    }
+    if( !AcceptValue() )
+        return;
+    if( m_nDepth == 1 && EQUAL(m_osCurKey, "type") )
+    {
+        if( !EQUAL(pszValue, "FeatureCollection") )
+        {
+            GiveUp();
+            return;
+        }
+        m_bIsFeatureCollection = true;
+    }
+    AppendObject(json_object_new_string_len(pszValue,
+                                            static_cast<int>(nLength)));
+}
+
+/************************************************************************/
+/*                               Number()                               */
+/************************************************************************/
+
+void OGRGeoJSONReaderStreamingParser::Number( const char* pszValue,
+                                              size_t /* nLength */ )
+{
+    if( SkipGeometryValue() )
+    {
+        if( m_nCoordinatesDepth > 0 && !m_anCoordinateCount.empty() )
+            m_anCoordinateCount.back()++;
+        return;
+    }
+    if( !AcceptValue() )
+        return;
+
+    // Build the value as the json-c tokener would do.
+    json_object* poObj = NULL;
+    if( strpbrk(pszValue, ".eE") == NULL )
+    {
+        int64_t nVal = 0;
+        if( json_parse_int64(pszValue, &nVal) == 0 )
+            poObj = json_object_new_int64(nVal);
+    }
+    else
+    {
+        double dfVal = 0.0;
+        if( json_parse_double(pszValue, &dfVal) == 0 )
+            poObj = json_object_new_double(dfVal);
+    }
+    if( poObj == NULL )
+    {
+        // NaN and Infinity are not supported by json-c.
+        GiveUp();
+        return;
+    }
+    if( m_nDepth == 1 && EQUAL(m_osCurKey, "type") )
+    {
+        json_object_put(poObj);
+        GiveUp();
+        return;
+    }
+    AppendObject(poObj);
+}
+
+/************************************************************************/
+/*                              Boolean()                               */
+/************************************************************************/
+
+void OGRGeoJSONReaderStreamingParser::Boolean( bool b )
+{
+    if( SkipGeometryValue() || !AcceptValue() )
+        return;
+    AppendObject(json_object_new_boolean(b));
+}
+
+/************************************************************************/
+/*                                Null()                                */
+/************************************************************************/
+
+void OGRGeoJSONReaderStreamingParser::Null()
+{
+    if( SkipGeometryValue() || !AcceptValue() )
+        return;
+    AppendObject(NULL);
+}
+
+/************************************************************************/
+/*                            StartObject()                             */
+/************************************************************************/
+
+void OGRGeoJSONReaderStreamingParser::StartObject()
+{
+    if( m_bStartGeometry )
+        StartGeometry();
+    if( m_bInGeometry )
+    {
+        m_nDepth++;
+        return;
+    }
+
+    if( m_nDepth == 0 )
+    {
+        m_poRootObj = json_object_new_object();
+        m_apoCurObj.push_back(m_poRootObj);
+    }
+    else if( m_nDepth == 2 && m_bInFeatures )
+    {
+        m_nFeatureStart = m_nBaseOffset + GetCurrentOffset();
+        m_eCurGeomType = wkbNone;
+        m_poCurFeature = json_object_new_object();
+        m_apoCurObj.push_back(m_poCurFeature);
+    }
+    else if( m_nDepth == 1 && m_bStartFeatures )
+    {
+        GiveUp();
+        return;
+    }
+    else
+    {
+        json_object* poObj = json_object_new_object();
+        AppendObject(poObj);
+        m_apoCurObj.push_back(poObj);
+    }
+    m_nDepth++;
+}
+
+/************************************************************************/
+/*                             EndObject()                              */
+/************************************************************************/
+
+void OGRGeoJSONReaderStreamingParser::EndObject()
+{
+    m_nDepth--;
+    if( m_bInGeometry )
+    {
+        if( m_nDepth < m_nGeometryDepth )
+            EndGeometry();
+        return;
+    }
+    m_apoCurObj.pop_back();
+    if( m_nDepth == 2 && m_bInFeatures )
+    {
+        const bool bOK = m_oReader.AnalyzeStreamedFeature(
+            m_poLayer, m_poCurFeature, m_eCurGeomType, m_nFeatureStart,
+            m_nBaseOffset + GetCurrentOffset() + 1);
+        json_object_put(m_poCurFeature);
+        m_poCurFeature = NULL;
+        if( !bOK )
+            GiveUp();
+    }
+}
+
+/************************************************************************/
+/*                         StartObjectMember()                          */
+/************************************************************************/
+
+void OGRGeoJSONReaderStreamingParser::StartObjectMember( const char* pszKey,
+                                                         size_t nLength )
+{
+    m_osCurKey.assign(pszKey, nLength);
+    m_bStartFeatures = (m_nDepth == 1 && EQUAL(m_osCurKey, "features"));
+    m_bStartGeometry = (m_nDepth == 3 && m_bInFeatures &&
+                        EQUAL(m_osCurKey, "geometry"));
+}
+
+/************************************************************************/
+/*                             StartArray()                             */
+/************************************************************************/
+
+void OGRGeoJSONReaderStreamingParser::StartArray()
+{
+    if( m_bStartGeometry )
+        StartGeometry();
+    if( m_bInGeometry )
+    {
+        if( m_nDepth == m_nGeometryDepth )
+        {
+            if( m_nCoordinatesDepth == 0 && EQUAL(m_osCurKey, "coordinates") )
+            {
+                m_bGeomHasCoordinates = true;
+                m_nCoordinatesDepth = m_nDepth;
+            }
+            else if( EQUAL(m_osCurKey, "geometries") )
+                m_bGeomHasGeometries = true;
+        }
+        else if( m_nCoordinatesDepth == 0 &&
+                 EQUAL(m_osCurKey, "coordinates") )
+        {
+            // Member of a GeometryCollection.
+            m_nCoordinatesDepth = m_nDepth;
+        }
+        if( m_nCoordinatesDepth > 0 )
+            m_anCoordinateCount.push_back(0);
+        m_nDepth++;
+        return;
+    }
+
+    if( m_nDepth == 0 || (m_nDepth == 2 && m_bInFeatures) )
+    {
+        GiveUp();
+        return;
+    }
+    if( m_nDepth == 1 && m_bStartFeatures )
+    {
+        // Only one "features" array is expected.
+        if( m_bFoundFeatures )
+        {
+            GiveUp();
+            return;
+        }
+        m_bFoundFeatures = true;
+        m_bInFeatures = true;
+        m_bStartFeatures = false;
+    }
+    else
+    {
+        json_object* poObj = json_object_new_array();
+        AppendObject(poObj);
+        m_apoCurObj.push_back(poObj);
+    }
+    m_nDepth++;
+}
+
+/************************************************************************/
+/*                              EndArray()                              */
+/************************************************************************/
+
+void OGRGeoJSONReaderStreamingParser::EndArray()
+{
+    m_nDepth--;
+    if( m_bInGeometry )
+    {
+        if( m_nCoordinatesDepth > 0 )
+        {
+            // An array of numbers is a position.
+            const int nCount = m_anCoordinateCount.back();
+            m_anCoordinateCount.pop_back();
+            if( nCount >= 3 )
+                m_bGeomHasZ = true;
+            if( nCount >= 2 )
+                m_bGeomHasPosition = true;
+            if( m_nDepth == m_nCoordinatesDepth )
+                m_nCoordinatesDepth = 0;
+        }
+        if( m_nDepth < m_nGeometryDepth )
+            EndGeometry();
+        return;
+    }
+    if( m_nDepth == 1 && m_bInFeatures )
+        m_bInFeatures = false;
+    else
+        m_apoCurObj.pop_back();
+}
+
+/************************************************************************/
+/*                              Exception()                             */
+/************************************************************************/
+
+void OGRGeoJSONReaderStreamingParser::Exception( const char* pszMessage )
+{
+    // The regular json-c based reading will report the error.
+    CPLDebug("GeoJSON", "%s", pszMessage);
+}
+
+/************************************************************************/
+/*                         FirstPassReadLayer()                         */
+/************************************************************************/
+
+/**
+ * Scan a FeatureCollection stored in a file, without ingesting it, to
+ * establish the layer schema, its geometry type and the location of
+ * each feature in the file. The features are then read on demand.
+ *
+ * On success, the layer created in poDS takes ownership of the reader and
+ * of fp. Otherwise, the reader should be discarded, and the file read with
+ * the regular method.
+ */
+bool OGRGeoJSONReader::FirstPassReadLayer( OGRGeoJSONDataSource* poDS,
+                                           VSILFILE* fp )
+{
+    CPLErrorReset();
+
+    OGRGeoJSONLayer* poLayer = new OGRGeoJSONLayer(
+                                    OGRGeoJSONLayer::DefaultName, NULL,
+                                    OGRGeoJSONLayer::DefaultGeometryType,
+                                    poDS );
+
+    /* Skip UTF-8 BOM (#5630) */
+    vsi_l_offset nBaseOffset = 0;
+    GByte abyBOM[3] = { 0, 0, 0 };
+    if( VSIFSeekL(fp, 0, SEEK_SET) == 0 &&
+        VSIFReadL(abyBOM, 1, 3, fp) == 3 &&
+        abyBOM[0] == 0xEF && abyBOM[1] == 0xBB && abyBOM[2] == 0xBF )
+    {
+        CPLDebug("GeoJSON", "Skip UTF-8 BOM");
+        nBaseOffset = 3;
+    }
+    VSIFSeekL(fp, nBaseOffset, SEEK_SET);
+
+    OGRGeoJSONReaderStreamingParser oParser(*this, poLayer, nBaseOffset);
+    const size_t nBufferSize = 65536;
+    std::vector<char> abyBuffer(nBufferSize);
+    while( true )
+    {
+        const size_t nRead = VSIFReadL(&abyBuffer[0], 1, nBufferSize, fp);
+        const bool bFinished = nRead < nBufferSize;
+        if( !oParser.Parse(&abyBuffer[0], nRead, bFinished) || bFinished )
+            break;
+    }
+
+    if( !oParser.IsStreamable() )
+    {
+        delete poLayer;
+        return false;
+    }
+
+    poGJObject_ = oParser.StealRootObject();
+
+    OGRSpatialReference* poSRS = OGRGeoJSONReadSpatialReference( poGJObject_ );
+    if (poSRS == NULL ) {
+        // If there is none defined, we use 4326
+        poSRS = new OGRSpatialReference();
+        if( OGRERR_NONE != poSRS->importFromEPSG( 4326 ) )
+        {
+            delete poSRS;
+            poSRS = NULL;
+        }
+    }
+    if( poSRS != NULL )
+    {
+        poLayer->GetLayerDefn()->GetGeomFieldDefn(0)->SetSpatialRef(poSRS);
+        poSRS->Release();
+    }
+
+    if( !bAttributesSkip_ )
+        SetFIDColumnFromLayerDefn( poLayer );
+    AssignStreamedFeatureFIDs( poLayer );
+
+    // Equivalent of OGRGeoJSONLayer::DetectGeometryType()
+    if( !bFirstGeometry_ )
+        poLayer->GetLayerDefn()->SetGeomType( eLayerGeomType_ );
+
+    SetLayerNativeData( poLayer, poGJObject_ );
+
+    fp_ = fp;
+    poLayer->SetReader( this );
+
+    if( CPLGetLastErrorType() != CE_Warning )
+        CPLErrorReset();
+
+    poDS->AddLayer(poLayer);
+    return true;
+}
+
+/************************************************************************/
+/*                       AnalyzeStreamedFeature()                       */
+/************************************************************************/
+
+bool OGRGeoJSONReader::AnalyzeStreamedFeature( OGRGeoJSONLayer* poLayer,
+                                               json_object* poObj,
+                                               OGRwkbGeometryType eGeomType,
+                                               vsi_l_offset nStart,
+                                               vsi_l_offset nEnd )
+{
+    if( !bAttributesSkip_ )
+    {
+        if( !GenerateFeatureDefn( poLayer, poObj ) )
+        {
+            CPLDebug( "GeoJSON", "Create feature schema failure." );
+            return false;
+        }
+        // The GeoCouch spatiallist format is only handled by the regular
+        // reading.
+        if( bIsGeocouchSpatiallistFormat )
+            return false;
+    }
+
+/* -------------------------------------------------------------------- */
+/*      Record the candidate FID, with the same rules as ReadFeature(): */
+/*      a top-level id of integer type, or otherwise properties.id if   */
+/*      it ends up being an integer field.                              */
+/* -------------------------------------------------------------------- */
+    FeatureLocation sLocation;
+    sLocation.nFID = OGRNullFID;
+    sLocation.nStart = nStart;
+    sLocation.nEnd = nEnd;
+
+    json_object* poObjId = OGRGeoJSONFindMemberByName( poObj, "id" );
+    if( NULL != poObjId && json_object_get_type(poObjId) == json_type_int )
+        sLocation.nFID = (GIntBig)json_object_get_int64( poObjId );
+
+    if( bFoundFeatureId )
+    {
+        if( !anPropertiesId_.empty() )
+            std::vector<GIntBig>().swap(anPropertiesId_);
+    }
+    else if( !bAttributesSkip_ )
+    {
+        GIntBig nPropertiesId = OGRNullFID;
+        json_object* poObjProps =
+            OGRGeoJSONFindMemberByName( poObj, "properties" );
+        if( NULL != poObjProps &&
+            json_object_get_type(poObjProps) == json_type_object )
+        {
+            json_object_iter it;
+            it.key = NULL;
+            it.val = NULL;
+            it.entry = NULL;
+            json_object_object_foreachC( poObjProps, it )
+            {
+                if( EQUAL(it.key, "id") && it.val != NULL &&
+                    (json_object_get_type(it.val) == json_type_int ||
+                     json_object_get_type(it.val) == json_type_boolean) )
+                {
+                    nPropertiesId = (GIntBig)json_object_get_int64( it.val );
+                }
+            }
+        }
+        anPropertiesId_.push_back( nPropertiesId );
+    }
+
+    asFeatureLocations_.push_back( sLocation );
+
+/* -------------------------------------------------------------------- */
+/*      Detect the layer geometry type, until it is found to be mixed.  */
+/*      eGeomType is wkbNone if the feature has no readable geometry.   */
+/* -------------------------------------------------------------------- */
+    if( eGeomType != wkbNone &&
+        (bFirstGeometry_ || eLayerGeomType_ != wkbUnknown) )
+    {
+        // Wrapping done by ReadGeometry().
+        if( !bGeometryPreserve_ &&
+            wkbFlatten(eGeomType) != wkbGeometryCollection )
+        {
+            eGeomType = wkbHasZ(eGeomType) ? wkbGeometryCollection25D
+                                           : wkbGeometryCollection;
+        }
+
+        if( bFirstGeometry_ )
+        {
+            eLayerGeomType_ = eGeomType;
+            bFirstGeometry_ = false;
+        }
+        else if( eGeomType != eLayerGeomType_ )
+        {
+            CPLDebug( "GeoJSON",
+                      "Detected layer of mixed-geometry type features." );
+            eLayerGeomType_ = OGRGeoJSONLayer::DefaultGeometryType;
+        }
+    }
+
+    return true;
+}
+
+/************************************************************************/
+/*                      CompareFeatureLocationFID()                     */
+/************************************************************************/
+
+bool OGRGeoJSONReader::CompareFeatureLocationFID( const FeatureLocation& a,
+                                                  const FeatureLocation& b )
+{
+    return a.nFID < b.nFID;
+}
+
+/************************************************************************/
+/*                      AssignStreamedFeatureFIDs()                     */
+/************************************************************************/
+
+/* Assign the FIDs the features would have got with OGRGeoJSONLayer::   */
+/* AddFeature(), and order the features by FID, as OGRMemLayer does.    */
+void OGRGeoJSONReader::AssignStreamedFeatureFIDs( OGRGeoJSONLayer* poLayer )
+{
+    if( !bFoundFeatureId && poLayer->GetFIDColumn()[0] != '\0' )
+    {
+        CPLAssert( anPropertiesId_.size() == asFeatureLocations_.size() );
+        for( size_t i = 0; i < asFeatureLocations_.size(); i++ )
+            asFeatureLocations_[i].nFID = anPropertiesId_[i];
+    }
+    std::vector<GIntBig>().swap(anPropertiesId_);
+
+    bool bHasExplicitFID = false;
+    for( size_t i = 0; i < asFeatureLocations_.size(); i++ )
+    {
+        if( asFeatureLocations_[i].nFID != OGRNullFID )
+        {
+            bHasExplicitFID = true;
+            break;
+        }
+    }
+
+    bFIDIsIndex_ = true;
+    if( !bHasExplicitFID )
+    {
+        for( size_t i = 0; i < asFeatureLocations_.size(); i++ )
+            asFeatureLocations_[i].nFID = static_cast<GIntBig>(i);
+    }
+    else
+    {
+        std::set<GIntBig> oSetFIDs;
+        bool bOriginalIdModified = false;
+        size_t nKept = 0;
+        for( size_t i = 0; i < asFeatureLocations_.size(); i++ )
+        {
+            GIntBig nFID = asFeatureLocations_[i].nFID;
+            if( nFID == OGRNullFID || oSetFIDs.find(nFID) != oSetFIDs.end() )
+            {
+                if( nFID != OGRNullFID && !bOriginalIdModified )
+                {
+                    CPLError(
+                        CE_Warning, CPLE_AppDefined,
+                        "Several features with id = " CPL_FRMT_GIB " have "
+                        "been found. Altering it to be unique. This warning "
+                        "will not be emitted for this layer",
+                        nFID );
+                    bOriginalIdModified = true;
+                }
+                nFID = static_cast<GIntBig>(oSetFIDs.size());
+                while( oSetFIDs.find(nFID) != oSetFIDs.end() )
+                    nFID++;
+            }
+            else if( nFID < 0 )
+            {
+                // Rejected by OGRMemLayer as well.
+                CPLError( CE_Failure, CPLE_NotSupported,
+                          "negative FID are not supported" );
+                continue;
+            }
+            oSetFIDs.insert(nFID);
+            if( !CPL_INT64_FITS_ON_INT32(nFID) )
+                poLayer->SetMetadataItem(OLMD_FID64, "YES");
+
+            asFeatureLocations_[nKept] = asFeatureLocations_[i];
+            asFeatureLocations_[nKept].nFID = nFID;
+            nKept++;
+        }
+        asFeatureLocations_.resize(nKept);
+
+        std::sort(asFeatureLocations_.begin(), asFeatureLocations_.end(),
+                  CompareFeatureLocationFID);
+        for( size_t i = 0; i < asFeatureLocations_.size(); i++ )
+        {
+            if( asFeatureLocations_[i].nFID != static_cast<GIntBig>(i) )
+            {
+                bFIDIsIndex_ = false;
+                break;
+            }
+        }
+    }
+
+    CPLDebug("GeoJSON", "%d features indexed%s",
+             static_cast<int>(asFeatureLocations_.size()),
+             bFIDIsIndex_ ? "" : " (with sparse FIDs)");
+}
+
+/************************************************************************/
+/*                        ReadStreamedFeature()                         */
+/************************************************************************/
+
+OGRFeature* OGRGeoJSONReader::ReadStreamedFeature(
+                                        OGRGeoJSONLayer* poLayer,
+                                        const FeatureLocation& sLocation )
+{
+    const size_t nSize = static_cast<size_t>(sLocation.nEnd - sLocation.nStart);
+    osFeatureBuffer_.resize(nSize);
+    if( VSIFSeekL(fp_, sLocation.nStart, SEEK_SET) != 0 ||
+        VSIFReadL(&osFeatureBuffer_[0], 1, nSize, fp_) != nSize )
+    {
+        CPLError(CE_Failure, CPLE_FileIO,
+                 "Cannot read feature at offset " CPL_FRMT_GUIB,
+                 static_cast<GUIntBig>(sLocation.nStart));
+        return NULL;
+    }
+
+    json_object* poObj = NULL;
+    if( !OGRJSonParse(osFeatureBuffer_.c_str(), &poObj) )
+        return NULL;
+
+    OGRFeature* poFeature = ReadFeature( poLayer, poObj );
+    json_object_put( poObj );
+
+    poFeature->SetFID( sLocation.nFID );
+    for( int i = 0; i < poFeature->GetGeomFieldCount(); i++ )
+    {
+        OGRGeometry* poGeom = poFeature->GetGeomFieldRef(i);
+        if( poGeom != NULL && poGeom->getSpatialReference() == NULL )
+        {
+            poGeom->assignSpatialReference(
+                poLayer->GetLayerDefn()->GetGeomFieldDefn(i)->GetSpatialRef());
+        }
+    }
+    return poFeature;
+}
+
+/************************************************************************/
+/*                            ResetReading()                            */
+/************************************************************************/
+
+void OGRGeoJSONReader::ResetReading()
+{
+    nNextFeature_ = 0;
+}
+
+/************************************************************************/
+/*                           GetNextFeature()                           */
+/************************************************************************/
+
+OGRFeature* OGRGeoJSONReader::GetNextFeature( OGRGeoJSONLayer* poLayer )
+{
+    if( nNextFeature_ >= asFeatureLocations_.size() )
+        return NULL;
+    return ReadStreamedFeature( poLayer, asFeatureLocations_[nNextFeature_++] );
+}
+
+/************************************************************************/
+/*                             GetFeature()                             */
+/************************************************************************/
+
+OGRFeature* OGRGeoJSONReader::GetFeature( OGRGeoJSONLayer* poLayer,
+                                          GIntBig nFID )
+{
+    if( nFID < 0 )
+        return NULL;
+    if( bFIDIsIndex_ )
+    {
+        if( nFID >= static_cast<GIntBig>(asFeatureLocations_.size()) )
+            return NULL;
+        return ReadStreamedFeature( poLayer,
+                                    asFeatureLocations_[static_cast<size_t>(nFID)] );
+    }
+
+    FeatureLocation sKey;
+    sKey.nFID = nFID;
+    sKey.nStart = 0;
+    sKey.nEnd = 0;
+    std::vector<FeatureLocation>::const_iterator oIter =
+        std::lower_bound(asFeatureLocations_.begin(),
+                         asFeatureLocations_.end(),
+                         sKey, CompareFeatureLocationFID);
+    if( oIter == asFeatureLocations_.end() || oIter->nFID != nFID )
+        return NULL;
+    return ReadStreamedFeature( poLayer, *oIter );
+}
+
+/************************************************************************/
+/*                           SetNextByIndex()                           */
+/************************************************************************/
+
+OGRErr OGRGeoJSONReader::SetNextByIndex( GIntBig nIndex )
+{
+    if( nIndex < 0 ||
+        nIndex >= static_cast<GIntBig>(asFeatureLocations_.size()) )
+        return OGRERR_FAILURE;
+    nNextFeature_ = static_cast<size_t>(nIndex);
+    return OGRERR_NONE;
+}
+
+/************************************************************************/
+/*                          GetFeatureCount()                           */
+/************************************************************************/
+
+GIntBig OGRGeoJSONReader::GetFeatureCount() const
+{
+    return static_cast<GIntBig>(asFeatureLocations_.size());
+}
+
 /************************************************************************/
 /*                           OGRGeoJSONFindMemberByName                 */
 /************************************************************************/
@@ -35,6 +35,7 @@
 #include "ogrsf_frmts.h"
 #include <json.h> // JSON-C
 #include <set>
+#include <vector>
 
 /************************************************************************/
 /*                         FORWARD DECLARATIONS                         */
@@ -86,9 +87,12 @@ struct GeoJSONObject
 /************************************************************************/
 
 class OGRGeoJSONDataSource;
+class OGRGeoJSONReaderStreamingParser;
 
 class OGRGeoJSONReader
 {
+    friend class OGRGeoJSONReaderStreamingParser;
+
 public:
 
     OGRGeoJSONReader();
@@ -108,6 +112,16 @@ public:
 
     json_object* GetJSonObject() { return poGJObject_; }
 
+    //
+    // Streaming reading of a FeatureCollection stored in a file.
+    //
+    bool FirstPassReadLayer( OGRGeoJSONDataSource* poDS, VSILFILE* fp );
+    void ResetReading();
+    OGRFeature* GetNextFeature( OGRGeoJSONLayer* poLayer );
+    OGRFeature* GetFeature( OGRGeoJSONLayer* poLayer, GIntBig nFID );
+    OGRErr SetNextByIndex( GIntBig nIndex );
+    GIntBig GetFeatureCount() const;
+
 private:
 
     json_object* poGJObject_;
@@ -129,6 +143,26 @@ private:
     bool bIsGeocouchSpatiallistFormat;
     bool bFoundFeatureId;
 
+    //
+    // Streaming mode: location in the file of the features of the
+    // "features" array, ordered by FID.
+    //
+    struct FeatureLocation
+    {
+        GIntBig nFID;
+        vsi_l_offset nStart;
+        vsi_l_offset nEnd;
+    };
+
+    VSILFILE* fp_;
+    std::vector<FeatureLocation> asFeatureLocations_;
+    std::vector<GIntBig> anPropertiesId_;
+    bool bFIDIsIndex_;
+    size_t nNextFeature_;
+    CPLString osFeatureBuffer_;
+    bool bFirstGeometry_;
+    OGRwkbGeometryType eLayerGeomType_;
+
     //
     // Copy operations not supported.
     //
@@ -139,6 +173,7 @@ private:
     // Translation utilities.
     //
     bool GenerateLayerDefn( OGRGeoJSONLayer* poLayer, json_object* poGJObject );
+    void SetFIDColumnFromLayerDefn( OGRGeoJSONLayer* poLayer );
     bool GenerateFeatureDefn( OGRGeoJSONLayer* poLayer, json_object* poObj );
     bool AddFeature( OGRGeoJSONLayer* poLayer, OGRGeometry* poGeometry );
     bool AddFeature( OGRGeoJSONLayer* poLayer, OGRFeature* poFeature );
@@ -146,6 +181,16 @@ private:
     OGRGeometry* ReadGeometry( json_object* poObj );
     OGRFeature* ReadFeature( OGRGeoJSONLayer* poLayer, json_object* poObj );
     void ReadFeatureCollection( OGRGeoJSONLayer* poLayer, json_object* poObj );
+    void SetLayerNativeData( OGRGeoJSONLayer* poLayer, json_object* poObj );
+
+    bool AnalyzeStreamedFeature( OGRGeoJSONLayer* poLayer, json_object* poObj,
+                                 OGRwkbGeometryType eGeomType,
+                                 vsi_l_offset nStart, vsi_l_offset nEnd );
+    void AssignStreamedFeatureFIDs( OGRGeoJSONLayer* poLayer );
+    OGRFeature* ReadStreamedFeature( OGRGeoJSONLayer* poLayer,
+                                     const FeatureLocation& sLocation );
+    static bool CompareFeatureLocationFID( const FeatureLocation& a,
+                                           const FeatureLocation& b );
 };
 
 void OGRGeoJSONReaderSetField(OGRLayer* poLayer,
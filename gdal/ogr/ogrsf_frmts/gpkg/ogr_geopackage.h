@@ -34,6 +34,9 @@
 #include "ogr_sqlite.h"
 #include "ogrgeopackageutility.h"
 #include "gpkgmbtilescommon.h"
+#include "cpl_quad_tree.h"
+
+#include <vector>
 
 #define UNKNOWN_SRID   -2
 #define DEFAULT_SRID    0
@@ -192,6 +195,7 @@ class GDALGeoPackageDataset CPL_FINAL : public OGRSQLiteBaseDataSource, public G
         bool                HasExtensionsTable();
         OGRErr              CreateGDALAspatialExtension();
         void                SetMetadataDirty() { m_bMetadataDirty = true; }
+        bool                IsInUserTransaction() const { return bUserTransactionActive != FALSE; }
 
         const char*         GetGeometryTypeString(OGRwkbGeometryType eType);
 
@@ -306,6 +310,18 @@ class OGRGeoPackageTableLayer CPL_FINAL : public OGRGeoPackageLayer
     // m_bHasSpatialIndex cannot be bool.  -1 is unset.
     int                         m_bHasSpatialIndex;
     bool                        m_bDropRTreeTable;
+    // Set when the rtree insert trigger has been dropped during a user
+    // transaction and new envelopes are accumulated in m_anRTreeFIDs /
+    // m_asRTreeBounds to be bulk-inserted in the RTree.
+    bool                        m_bAllowDeferredSpatialIndexUpdate;
+    bool                        m_bDeferredSpatialIndexUpdate;
+    // Set when the deferred update could not be started in the current
+    // transaction, for example because the rtree insert trigger is missing,
+    // so that this is not checked again for each new feature.
+    bool                        m_bDeferredSpatialIndexUpdateUnavailable;
+    std::vector<GIntBig>        m_anRTreeFIDs;
+    std::vector<CPLRectObj>     m_asRTreeBounds;
+    size_t                      m_nRTreeBufferMaxSize;
     bool                        m_abHasGeometryExtension[wkbTIN+1];
     bool                        m_bPreservePrecision;
     bool                        m_bTruncateFields;
@@ -366,6 +382,12 @@ class OGRGeoPackageTableLayer CPL_FINAL : public OGRGeoPackageLayer
 
     void                CreateSpatialIndexIfNecessary();
     bool                CreateSpatialIndex();
+    bool                RunDeferredSpatialIndexUpdate();
+    void                CancelDeferredSpatialIndexUpdate();
+    // To be called at commit time, or after statements that may have
+    // changed the triggers.
+    void                ResetDeferredSpatialIndexUpdateState()
+                                { m_bDeferredSpatialIndexUpdateUnavailable = false; }
     bool                DropSpatialIndex(bool bCalledFromSQLFunction = false);
 
     virtual char **     GetMetadata( const char *pszDomain = NULL );
@@ -406,6 +428,11 @@ class OGRGeoPackageTableLayer CPL_FINAL : public OGRGeoPackageLayer
     OGRErr              FeatureBindInsertParameters( OGRFeature *poFeature, sqlite3_stmt *poStmt, bool bAddFID, bool bBindNullFields );
     OGRErr              FeatureBindParameters( OGRFeature *poFeature, sqlite3_stmt *poStmt, int *pnColCount, bool bAddFID, bool bBindNullFields );
 
+    bool                StartDeferredSpatialIndexUpdate();
+    bool                AddToRTreeBuffer( GIntBig nFID, const OGREnvelope& sEnvelope );
+    bool                FlushRTreeBuffer();
+    bool                CreateRTreeInsertTrigger();
+
     void                CheckUnknownExtensions();
     bool                CreateGeometryExtensionIfNecessary(OGRwkbGeometryType eGType);
 };
@@ -1451,13 +1451,17 @@ CPLErr GDALGeoPackageDataset::IFlushCacheWithErrCode()
     // Short circuit GDALPamDataset to avoid serialization to .aux.xml
     GDALDataset::FlushCache();
 
+    CPLErr eErr = CE_None;
     for( int i = 0; i < m_nLayers; i++ )
     {
         m_papoLayers[i]->RunDeferredCreationIfNecessary();
         m_papoLayers[i]->CreateSpatialIndexIfNecessary();
+        if( !m_papoLayers[i]->RunDeferredSpatialIndexUpdate() )
+            eErr = CE_Failure;
     }
 
-    CPLErr eErr = FlushTiles();
+    if( FlushTiles() != CE_None )
+        eErr = CE_Failure;
 
     m_bInFlushCache = false;
     return eErr;
@@ -3553,6 +3557,9 @@ OGRLayer * GDALGeoPackageDataset::ExecuteSQL( const char *pszSQLCommand,
     {
         m_papoLayers[i]->RunDeferredCreationIfNecessary();
         m_papoLayers[i]->CreateSpatialIndexIfNecessary();
+        if( !m_papoLayers[i]->RunDeferredSpatialIndexUpdate() )
+            return NULL;
+        m_papoLayers[i]->ResetDeferredSpatialIndexUpdateState();
     }
 
     if( pszDialect != NULL && EQUAL(pszDialect,"OGRSQL") )
@@ -4387,6 +4394,14 @@ OGRErr GDALGeoPackageDataset::CommitTransaction()
         for( int i = 0; i < m_nLayers; i++ )
         {
             m_papoLayers[i]->RunDeferredCreationIfNecessary();
+            // The features inserted in the transaction would otherwise be
+            // committed without being in the spatial index.
+            if( !m_papoLayers[i]->RunDeferredSpatialIndexUpdate() )
+            {
+                RollbackTransaction();
+                return OGRERR_FAILURE;
+            }
+            m_papoLayers[i]->ResetDeferredSpatialIndexUpdateState();
         }
     }
 
@@ -4407,6 +4422,7 @@ OGRErr GDALGeoPackageDataset::RollbackTransaction()
         {
             m_papoLayers[i]->RunDeferredCreationIfNecessary();
             m_papoLayers[i]->CreateSpatialIndexIfNecessary();
+            m_papoLayers[i]->CancelDeferredSpatialIndexUpdate();
             m_papoLayers[i]->ResetReading();
         }
     }
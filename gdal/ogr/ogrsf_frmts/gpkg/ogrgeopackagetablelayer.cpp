@@ -32,6 +32,9 @@
 #include "ogrgeopackageutility.h"
 #include "cpl_time.h"
 #include "ogr_p.h"
+#include "cpl_packed_rtree.h"
+
+#include <algorithm>
 
 //----------------------------------------------------------------------
 // SaveExtent()
@@ -861,6 +864,12 @@ OGRGeoPackageTableLayer::OGRGeoPackageTableLayer(
     m_bDeferredSpatialIndexCreation = false;
     m_bHasSpatialIndex = -1;
     m_bDropRTreeTable = false;
+    m_bDeferredSpatialIndexUpdate = false;
+    m_bDeferredSpatialIndexUpdateUnavailable = false;
+    m_bAllowDeferredSpatialIndexUpdate = CPLTestBool(
+        CPLGetConfigOption("OGR_GPKG_DEFERRED_SPATIAL_INDEX_UPDATE", "YES"));
+    m_nRTreeBufferMaxSize = static_cast<size_t>(std::max(1,
+        atoi(CPLGetConfigOption("OGR_GPKG_RTREE_BUFFER_SIZE", "1000000"))));
     memset(m_abHasGeometryExtension, 0, sizeof(m_abHasGeometryExtension)); /* false */
     m_bPreservePrecision = true;
     m_bTruncateFields = false;
@@ -879,6 +888,8 @@ OGRGeoPackageTableLayer::~OGRGeoPackageTableLayer()
     if( m_bDeferredCreation )
         RunDeferredCreationIfNecessary();
 
+    RunDeferredSpatialIndexUpdate();
+
     if( m_bDropRTreeTable )
     {
         const char* pszT = m_pszTableName;
@@ -1148,6 +1159,14 @@ OGRErr OGRGeoPackageTableLayer::ICreateFeature( OGRFeature *poFeature )
         }
     }
 
+    /* In a transaction, replace the per-row RTree insert trigger by */
+    /* a bulk load of the RTree at commit time */
+    if( !m_bDeferredSpatialIndexUpdate && m_bAllowDeferredSpatialIndexUpdate &&
+        m_poDS->IsInUserTransaction() )
+    {
+        StartDeferredSpatialIndexUpdate();
+    }
+
     /* If there's a unset field with a default value, then we must create */
     /* a specific INSERT statement to avoid unset fields to be bound to NULL */
     if( m_poInsertStatement && (bHasDefaultValue || m_bInsertStatementWithFID != (poFeature->GetFID() != OGRNullFID)) )
@@ -1212,15 +1231,24 @@ OGRErr OGRGeoPackageTableLayer::ICreateFeature( OGRFeature *poFeature )
     }
 
     /* Update the layer extents with this new object */
-    if ( IsGeomFieldSet(poFeature) )
+    OGREnvelope oEnv;
+    const bool bHasGeom = CPL_TO_BOOL(IsGeomFieldSet(poFeature));
+    if ( bHasGeom )
     {
-        OGREnvelope oEnv;
         poFeature->GetGeomFieldRef(0)->getEnvelope(&oEnv);
         UpdateExtent(&oEnv);
     }
 
     /* Read the latest FID value */
     GIntBig nFID = sqlite3_last_insert_rowid(m_poDS->GetDB());
+
+    /* Do what the RTree insert trigger would have done */
+    if( m_bDeferredSpatialIndexUpdate && bHasGeom &&
+        !poFeature->GetGeomFieldRef(0)->IsEmpty() &&
+        !AddToRTreeBuffer(nFID, oEnv) )
+    {
+        return OGRERR_FAILURE;
+    }
     if( nFID )
     {
         poFeature->SetFID(nFID);
@@ -1271,6 +1299,9 @@ OGRErr OGRGeoPackageTableLayer::ISetFeature( OGRFeature *poFeature )
     if( m_bDeferredCreation && RunDeferredCreationIfNecessary() != OGRERR_NONE )
         return OGRERR_FAILURE;
 
+    if( !RunDeferredSpatialIndexUpdate() )
+        return OGRERR_FAILURE;
+
     /* Old version of SQLite have issues with some of the spatial index triggers */
 #if SQLITE_VERSION_NUMBER < 3007008
     if( HasSpatialIndex() )
@@ -1461,6 +1492,8 @@ OGRFeature* OGRGeoPackageTableLayer::GetNextFeature()
         return NULL;
 
     CreateSpatialIndexIfNecessary();
+    if( !RunDeferredSpatialIndexUpdate() )
+        return NULL;
 
     OGRFeature* poFeature = OGRGeoPackageLayer::GetNextFeature();
     if( poFeature && m_iFIDAsRegularColumnIndex >= 0 )
@@ -1484,6 +1517,8 @@ OGRFeature* OGRGeoPackageTableLayer::GetFeature(GIntBig nFID)
         return NULL;
 
     CreateSpatialIndexIfNecessary();
+    if( !RunDeferredSpatialIndexUpdate() )
+        return NULL;
 
     /* Clear out any existing query */
     ResetReading();
@@ -1545,6 +1580,9 @@ OGRErr OGRGeoPackageTableLayer::DeleteFeature(GIntBig nFID)
     if( m_bDeferredCreation && RunDeferredCreationIfNecessary() != OGRERR_NONE )
         return OGRERR_FAILURE;
 
+    if( !RunDeferredSpatialIndexUpdate() )
+        return OGRERR_FAILURE;
+
     /* Clear out any existing query */
     ResetReading();
 
@@ -1568,6 +1606,9 @@ OGRErr OGRGeoPackageTableLayer::SyncToDisk()
     if( m_bDeferredCreation && RunDeferredCreationIfNecessary() != OGRERR_NONE )
         return OGRERR_FAILURE;
 
+    if( !RunDeferredSpatialIndexUpdate() )
+        return OGRERR_FAILURE;
+
     SaveExtent();
     return OGRERR_NONE;
 }
@@ -1614,6 +1655,10 @@ GIntBig OGRGeoPackageTableLayer::GetFeatureCount( CPL_UNUSED int bForce )
     if( m_bDeferredCreation && RunDeferredCreationIfNecessary() != OGRERR_NONE )
         return 0;
 
+    /* The spatial filter is evaluated against the RTree */
+    if( m_poFilterGeom != NULL && !RunDeferredSpatialIndexUpdate() )
+        return -1;
+
     /* Ignore bForce, because we always do a full count on the database */
     OGRErr err;
     CPLString soSQL;
@@ -1791,42 +1836,60 @@ bool OGRGeoPackageTableLayer::CreateSpatialIndex()
     }
     m_bDropRTreeTable = false;
 
-    /* Populate the RTree */
+    /* Populate the RTree. Rather than inserting the rows in FID order, */
+    /* collect their envelopes and insert them in spatially sorted batches */
+    /* which is much faster for SQLite's R*-tree */
     pszSQL = sqlite3_mprintf(
-                 "INSERT OR REPLACE INTO \"rtree_%s_%s\" "
-                 "SELECT \"%s\", st_minx(\"%s\"), st_maxx(\"%s\"), st_miny(\"%s\"), st_maxy(\"%s\") FROM \"%s\"",
-                 pszT, pszC, pszI, pszC, pszC, pszC, pszC, pszT );
-    err = SQLCommand(m_poDS->GetDB(), pszSQL);
+                 "SELECT \"%s\", ST_MinX(\"%s\"), ST_MaxX(\"%s\"), "
+                 "ST_MinY(\"%s\"), ST_MaxY(\"%s\") FROM \"%s\" "
+                 "WHERE \"%s\" NOT NULL AND NOT ST_IsEmpty(\"%s\")",
+                 pszI, pszC, pszC, pszC, pszC, pszT, pszC, pszC );
+    sqlite3_stmt* hSelectStmt = NULL;
+    int rc = sqlite3_prepare(m_poDS->GetDB(), pszSQL, -1, &hSelectStmt, NULL);
+    if( rc != SQLITE_OK )
+    {
+        CPLError( CE_Failure, CPLE_AppDefined, "failed to prepare SQL: %s",
+                  pszSQL);
+        sqlite3_free(pszSQL);
+        m_poDS->SoftRollbackTransaction();
+        return false;
+    }
     sqlite3_free(pszSQL);
-    if( err != OGRERR_NONE )
+
+    bool bOK = true;
+    m_anRTreeFIDs.clear();
+    m_asRTreeBounds.clear();
+    while( bOK && (rc = sqlite3_step(hSelectStmt)) == SQLITE_ROW )
+    {
+        OGREnvelope sEnvelope;
+        sEnvelope.MinX = sqlite3_column_double(hSelectStmt, 1);
+        sEnvelope.MaxX = sqlite3_column_double(hSelectStmt, 2);
+        sEnvelope.MinY = sqlite3_column_double(hSelectStmt, 3);
+        sEnvelope.MaxY = sqlite3_column_double(hSelectStmt, 4);
+        bOK = AddToRTreeBuffer(sqlite3_column_int64(hSelectStmt, 0),
+                               sEnvelope);
+    }
+    if( bOK && rc != SQLITE_DONE )
     {
+        CPLError( CE_Failure, CPLE_AppDefined,
+                  "failed to read envelopes: %s",
+                  sqlite3_errmsg(m_poDS->GetDB()) );
+        bOK = false;
+    }
+    sqlite3_finalize(hSelectStmt);
+    if( bOK )
+        bOK = FlushRTreeBuffer();
+    if( !bOK )
+    {
+        m_anRTreeFIDs.clear();
+        m_asRTreeBounds.clear();
         m_poDS->SoftRollbackTransaction();
         return false;
     }
 
     /* Define Triggers to Maintain Spatial Index Values */
 
-    /* Conditions: Insertion of non-empty geometry
-       Actions   : Insert record into rtree */
-    pszSQL = sqlite3_mprintf(
-                   "CREATE TRIGGER \"rtree_%s_%s_insert\" AFTER INSERT ON \"%s\" "
-                   "WHEN (new.\"%s\" NOT NULL AND NOT ST_IsEmpty(NEW.\"%s\")) "
-                   "BEGIN "
-                   "INSERT OR REPLACE INTO \"rtree_%s_%s\" VALUES ("
-                   "NEW.\"%s\","
-                   "ST_MinX(NEW.\"%s\"), ST_MaxX(NEW.\"%s\"),"
-                   "ST_MinY(NEW.\"%s\"), ST_MaxY(NEW.\"%s\")"
-                   "); "
-                   "END",
-                   pszT, pszC, pszT,
-                   pszC, pszC,
-                   pszT, pszC,
-                   pszI,
-                   pszC, pszC,
-                   pszC, pszC);
-    err = SQLCommand(m_poDS->GetDB(), pszSQL);
-    sqlite3_free(pszSQL);
-    if( err != OGRERR_NONE )
+    if( !CreateRTreeInsertTrigger() )
     {
         m_poDS->SoftRollbackTransaction();
         return false;
@@ -1965,6 +2028,233 @@ bool OGRGeoPackageTableLayer::CreateSpatialIndex()
     return true;
 }
 
+/************************************************************************/
+/*                      CreateRTreeInsertTrigger()                      */
+/************************************************************************/
+
+bool OGRGeoPackageTableLayer::CreateRTreeInsertTrigger()
+{
+    const char* pszT = m_pszTableName;
+    const char* pszC = m_poFeatureDefn->GetGeomFieldDefn(0)->GetNameRef();
+    const char* pszI = GetFIDColumn();
+
+    /* Conditions: Insertion of non-empty geometry
+       Actions   : Insert record into rtree */
+    char* pszSQL = sqlite3_mprintf(
+                   "CREATE TRIGGER \"rtree_%s_%s_insert\" AFTER INSERT ON \"%s\" "
+                   "WHEN (new.\"%s\" NOT NULL AND NOT ST_IsEmpty(NEW.\"%s\")) "
+                   "BEGIN "
+                   "INSERT OR REPLACE INTO \"rtree_%s_%s\" VALUES ("
+                   "NEW.\"%s\","
+                   "ST_MinX(NEW.\"%s\"), ST_MaxX(NEW.\"%s\"),"
+                   "ST_MinY(NEW.\"%s\"), ST_MaxY(NEW.\"%s\")"
+                   "); "
+                   "END",
+                   pszT, pszC, pszT,
+                   pszC, pszC,
+                   pszT, pszC,
+                   pszI,
+                   pszC, pszC,
+                   pszC, pszC);
+    OGRErr err = SQLCommand(m_poDS->GetDB(), pszSQL);
+    sqlite3_free(pszSQL);
+    return err == OGRERR_NONE;
+}
+
+/************************************************************************/
+/*                      AddToRTreeBuffer()                              */
+/************************************************************************/
+
+bool OGRGeoPackageTableLayer::AddToRTreeBuffer( GIntBig nFID,
+                                                const OGREnvelope& sEnvelope )
+{
+    CPLRectObj sRect;
+    sRect.minx = sEnvelope.MinX;
+    sRect.miny = sEnvelope.MinY;
+    sRect.maxx = sEnvelope.MaxX;
+    sRect.maxy = sEnvelope.MaxY;
+    m_anRTreeFIDs.push_back(nFID);
+    m_asRTreeBounds.push_back(sRect);
+
+    /* Keep memory usage bounded for huge loads by flushing sorted batches */
+    /* to the RTree as we go */
+    if( m_anRTreeFIDs.size() >= m_nRTreeBufferMaxSize )
+        return FlushRTreeBuffer();
+    return true;
+}
+
+/************************************************************************/
+/*                      OGRGPKGInsertRTreeEntry()                       */
+/************************************************************************/
+
+typedef struct
+{
+    sqlite3_stmt         *hStmt;
+    const GIntBig        *panFIDs;
+    const CPLRectObj     *pasBounds;
+    bool                  bOK;
+} OGRGPKGRTreeInsertContext;
+
+static int OGRGPKGInsertRTreeEntry( void* hFeature, void* pUserData )
+{
+    OGRGPKGRTreeInsertContext* psContext =
+        static_cast<OGRGPKGRTreeInsertContext*>(pUserData);
+    const size_t i = reinterpret_cast<size_t>(hFeature);
+    const CPLRectObj& sRect = psContext->pasBounds[i];
+
+    sqlite3_bind_int64(psContext->hStmt, 1, psContext->panFIDs[i]);
+    sqlite3_bind_double(psContext->hStmt, 2, sRect.minx);
+    sqlite3_bind_double(psContext->hStmt, 3, sRect.maxx);
+    sqlite3_bind_double(psContext->hStmt, 4, sRect.miny);
+    sqlite3_bind_double(psContext->hStmt, 5, sRect.maxy);
+    const int rc = sqlite3_step(psContext->hStmt);
+    sqlite3_reset(psContext->hStmt);
+    if( rc != SQLITE_DONE )
+    {
+        CPLError( CE_Failure, CPLE_AppDefined,
+                  "failed to insert into RTree: %s",
+                  sqlite3_errmsg(sqlite3_db_handle(psContext->hStmt)) );
+        psContext->bOK = false;
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/************************************************************************/
+/*                      FlushRTreeBuffer()                              */
+/************************************************************************/
+
+/* Insert the pending envelopes into the RTree, in the order of a packed */
+/* Hilbert R-tree built over them, so that consecutive insertions touch */
+/* the same SQLite R*-tree nodes. */
+bool OGRGeoPackageTableLayer::FlushRTreeBuffer()
+{
+    if( m_anRTreeFIDs.empty() )
+        return true;
+
+    const char* pszT = m_pszTableName;
+    const char* pszC = m_poFeatureDefn->GetGeomFieldDefn(0)->GetNameRef();
+    char* pszSQL = sqlite3_mprintf(
+        "INSERT OR REPLACE INTO \"rtree_%s_%s\" VALUES (?,?,?,?,?)",
+        pszT, pszC);
+    OGRGPKGRTreeInsertContext sContext;
+    sContext.hStmt = NULL;
+    sContext.panFIDs = &m_anRTreeFIDs[0];
+    sContext.pasBounds = &m_asRTreeBounds[0];
+    sContext.bOK = true;
+    int rc = sqlite3_prepare_v2(m_poDS->GetDB(), pszSQL, -1,
+                                &sContext.hStmt, NULL);
+    if( rc != SQLITE_OK )
+    {
+        CPLError( CE_Failure, CPLE_AppDefined, "failed to prepare SQL: %s",
+                  pszSQL );
+        sqlite3_free(pszSQL);
+        return false;
+    }
+    sqlite3_free(pszSQL);
+
+    const int nCount = static_cast<int>(m_anRTreeFIDs.size());
+    CPLPackedRTree* hTree = CPLPackedRTreeCreateWithBounds(
+        nCount, NULL, sContext.pasBounds, CPLPRT_ORDER_HILBERT, 0);
+    if( hTree != NULL )
+    {
+        CPLPackedRTreeForeach(hTree, OGRGPKGInsertRTreeEntry, &sContext);
+        CPLPackedRTreeDestroy(hTree);
+    }
+    else
+    {
+        /* Fallback to insertion in FID order */
+        for( int i = 0; i < nCount && sContext.bOK; i++ )
+        {
+            OGRGPKGInsertRTreeEntry(
+                reinterpret_cast<void*>(static_cast<size_t>(i)), &sContext);
+        }
+    }
+    sqlite3_finalize(sContext.hStmt);
+
+    m_anRTreeFIDs.clear();
+    m_asRTreeBounds.clear();
+    return sContext.bOK;
+}
+
+/************************************************************************/
+/*                   StartDeferredSpatialIndexUpdate()                  */
+/************************************************************************/
+
+/* When features are appended inside a user transaction, drop the RTree */
+/* insert trigger and accumulate the envelopes of the new features, so */
+/* that they can be bulk-loaded at commit time. As the trigger is dropped */
+/* within the transaction, a crash or a rollback leaves the database in */
+/* its original state. */
+bool OGRGeoPackageTableLayer::StartDeferredSpatialIndexUpdate()
+{
+    if( m_bDeferredSpatialIndexUpdate )
+        return true;
+    if( m_bDeferredSpatialIndexUpdateUnavailable ||
+        !m_poDS->IsInUserTransaction() || !HasSpatialIndex() )
+        return false;
+
+    const char* pszT = m_pszTableName;
+    const char* pszC = m_poFeatureDefn->GetGeomFieldDefn(0)->GetNameRef();
+
+    /* Only proceed if the trigger is the one we know how to recreate */
+    char* pszSQL = sqlite3_mprintf(
+        "SELECT COUNT(*) FROM sqlite_master WHERE type = 'trigger' "
+        "AND name = 'rtree_%q_%q_insert'", pszT, pszC);
+    OGRErr err = OGRERR_NONE;
+    const int nCount = SQLGetInteger(m_poDS->GetDB(), pszSQL, &err);
+    sqlite3_free(pszSQL);
+    if( err != OGRERR_NONE || nCount != 1 )
+    {
+        m_bDeferredSpatialIndexUpdateUnavailable = true;
+        return false;
+    }
+
+    pszSQL = sqlite3_mprintf("DROP TRIGGER \"rtree_%s_%s_insert\"", pszT, pszC);
+    err = SQLCommand(m_poDS->GetDB(), pszSQL);
+    sqlite3_free(pszSQL);
+    if( err != OGRERR_NONE )
+    {
+        m_bDeferredSpatialIndexUpdateUnavailable = true;
+        return false;
+    }
+
+    m_bDeferredSpatialIndexUpdate = true;
+    return true;
+}
+
+/************************************************************************/
+/*                    RunDeferredSpatialIndexUpdate()                   */
+/************************************************************************/
+
+bool OGRGeoPackageTableLayer::RunDeferredSpatialIndexUpdate()
+{
+    if( !m_bDeferredSpatialIndexUpdate )
+        return true;
+    m_bDeferredSpatialIndexUpdate = false;
+
+    bool bOK = FlushRTreeBuffer();
+    m_anRTreeFIDs.clear();
+    m_asRTreeBounds.clear();
+    if( !CreateRTreeInsertTrigger() )
+        bOK = false;
+    return bOK;
+}
+
+/************************************************************************/
+/*                   CancelDeferredSpatialIndexUpdate()                 */
+/************************************************************************/
+
+/* To be called when the current transaction is rolled back: the trigger */
+/* drop is rolled back with it. */
+void OGRGeoPackageTableLayer::CancelDeferredSpatialIndexUpdate()
+{
+    m_bDeferredSpatialIndexUpdate = false;
+    m_bDeferredSpatialIndexUpdateUnavailable = false;
+    m_anRTreeFIDs.clear();
+    m_asRTreeBounds.clear();
+}
+
 /************************************************************************/
 /*                    CheckUnknownExtensions()                          */
 /************************************************************************/
@@ -2164,9 +2454,17 @@ bool OGRGeoPackageTableLayer::DropSpatialIndex(bool bCalledFromSQLFunction)
     SQLCommand(m_poDS->GetDB(), pszSQL);
     sqlite3_free(pszSQL);
 
-    pszSQL = sqlite3_mprintf("DROP TRIGGER \"rtree_%s_%s_insert\"", pszT, pszC);
-    SQLCommand(m_poDS->GetDB(), pszSQL);
-    sqlite3_free(pszSQL);
+    /* In deferred update mode, the insert trigger is already dropped */
+    if( m_bDeferredSpatialIndexUpdate )
+    {
+        CancelDeferredSpatialIndexUpdate();
+    }
+    else
+    {
+        pszSQL = sqlite3_mprintf("DROP TRIGGER \"rtree_%s_%s_insert\"", pszT, pszC);
+        SQLCommand(m_poDS->GetDB(), pszSQL);
+        sqlite3_free(pszSQL);
+    }
 
     pszSQL = sqlite3_mprintf("DROP TRIGGER \"rtree_%s_%s_update1\"", pszT, pszC);
     SQLCommand(m_poDS->GetDB(), pszSQL);
@@ -33,7 +33,7 @@
 #include "ogrsf_frmts.h"
 #include "filegdbtable.h"
 #include "swq.h"
-#include "cpl_quad_tree.h"
+#include "cpl_packed_rtree.h"
 
 #include <vector>
 #include <map>
@@ -87,12 +87,15 @@ class OGROpenFileGDBLayer : public OGRLayer
     FileGDBIterator*      m_poIterMinMax;
 
     SPIState            m_eSpatialIndexState;
-    CPLQuadTree        *m_pQuadTree;
+    CPLPackedRTree     *m_pRTree;
+    std::vector<void*>  m_ahSPIRows;
+    std::vector<CPLRectObj> m_asSPIBounds;
     void              **m_pahFilteredFeatures;
     int                 m_nFilteredFeatureCount;
-    static void         GetBoundsFuncEx(const void* hFeature,
-                                        CPLRectObj* pBounds,
-                                        void* pQTUserData);
+
+    void                AddToSpatialIndex(int iRow, const OGRField* psField);
+    void                CompleteSpatialIndex();
+    void                InvalidateSpatialIndex();
 
 public:
 
@@ -154,7 +154,7 @@ OGROpenFileGDBLayer::OGROpenFileGDBLayer(const char* pszGDBFilename,
             m_bIteratorSufficientToEvaluateFilter(FALSE),
             m_poIterMinMax(NULL),
             m_eSpatialIndexState(SPI_IN_BUILDING),
-            m_pQuadTree(NULL),
+            m_pRTree(NULL),
             m_pahFilteredFeatures(NULL),
             m_nFilteredFeatureCount(-1)
 {
@@ -188,8 +188,8 @@ OGROpenFileGDBLayer::~OGROpenFileGDBLayer()
     delete m_poIterator;
     delete m_poIterMinMax;
     delete m_poGeomConverter;
-    if( m_pQuadTree != NULL )
-        CPLQuadTreeDestroy(m_pQuadTree);
+    if( m_pRTree != NULL )
+        CPLPackedRTreeDestroy(m_pRTree);
     CPLFree(m_pahFilteredFeatures);
 }
 
@@ -359,21 +359,8 @@ int OGROpenFileGDBLayer::BuildLayerDefinition()
         m_poGeomConverter =
             FileGDBOGRGeometryConverter::BuildConverter(poGDBGeomField);
 
-        if( CPLTestBool(
+        if( !CPLTestBool(
                 CPLGetConfigOption("OPENFILEGDB_IN_MEMORY_SPI", "YES")) )
-        {
-            CPLRectObj sGlobalBounds;
-            sGlobalBounds.minx = poGDBGeomField->GetXMin();
-            sGlobalBounds.miny = poGDBGeomField->GetYMin();
-            sGlobalBounds.maxx = poGDBGeomField->GetXMax();
-            sGlobalBounds.maxy = poGDBGeomField->GetYMax();
-            m_pQuadTree = CPLQuadTreeCreate(&sGlobalBounds,
-                                            NULL);
-            CPLQuadTreeSetMaxDepth(m_pQuadTree,
-                CPLQuadTreeGetAdvisedMaxDepth(
-                    m_poLyrTable->GetValidRecordCount()));
-        }
-        else
         {
             m_eSpatialIndexState = SPI_INVALID;
         }
@@ -692,7 +679,7 @@ void OGROpenFileGDBLayer::ResetReading()
     if( m_iCurFeat != 0 )
     {
         if( m_eSpatialIndexState == SPI_IN_BUILDING )
-            m_eSpatialIndexState = SPI_INVALID;
+            InvalidateSpatialIndex();
     }
     m_bEOF = FALSE;
     m_iCurFeat = 0;
@@ -740,9 +727,9 @@ void OGROpenFileGDBLayer::SetSpatialFilter( OGRGeometry *poGeom )
             aoi.maxy = m_sFilterEnvelope.MaxY;
             CPLFree(m_pahFilteredFeatures);
             m_nFilteredFeatureCount = -1;
-            m_pahFilteredFeatures = CPLQuadTreeSearch(m_pQuadTree,
-                                                      &aoi,
-                                                      &m_nFilteredFeatureCount);
+            m_pahFilteredFeatures = CPLPackedRTreeSearch(m_pRTree,
+                                                         &aoi,
+                                                         &m_nFilteredFeatureCount);
             if( m_nFilteredFeatureCount >= 0 )
             {
                 size_t* panStart = (size_t*)m_pahFilteredFeatures;
@@ -1295,13 +1282,76 @@ OGRErr OGROpenFileGDBLayer::SetAttributeFilter( const char* pszFilter )
         m_bIteratorSufficientToEvaluateFilter = -1;
         m_poIterator = BuildIteratorFromExprNode(poNode);
         if( m_poIterator != NULL && m_eSpatialIndexState == SPI_IN_BUILDING )
-            m_eSpatialIndexState = SPI_INVALID;
+            InvalidateSpatialIndex();
         if( m_bIteratorSufficientToEvaluateFilter < 0 )
             m_bIteratorSufficientToEvaluateFilter = FALSE;
     }
     return eErr;
 }
 
+/***********************************************************************/
+/*                         AddToSpatialIndex()                         */
+/***********************************************************************/
+
+void OGROpenFileGDBLayer::AddToSpatialIndex(int iRow, const OGRField* psField)
+{
+    OGREnvelope sFeatureEnvelope;
+    if( m_poLyrTable->GetFeatureExtent(psField, &sFeatureEnvelope) )
+    {
+        CPLRectObj sBounds;
+        sBounds.minx = sFeatureEnvelope.MinX;
+        sBounds.miny = sFeatureEnvelope.MinY;
+        sBounds.maxx = sFeatureEnvelope.MaxX;
+        sBounds.maxy = sFeatureEnvelope.MaxY;
+        m_ahSPIRows.push_back((void*)(size_t)iRow);
+        m_asSPIBounds.push_back(sBounds);
+    }
+}
+
+/***********************************************************************/
+/*                      InvalidateSpatialIndex()                       */
+/***********************************************************************/
+
+/* Give up building the spatial index, and free the extents collected */
+/* so far. */
+void OGROpenFileGDBLayer::InvalidateSpatialIndex()
+{
+    m_eSpatialIndexState = SPI_INVALID;
+    std::vector<void*>().swap(m_ahSPIRows);
+    std::vector<CPLRectObj>().swap(m_asSPIBounds);
+}
+
+/***********************************************************************/
+/*                       CompleteSpatialIndex()                        */
+/***********************************************************************/
+
+/* All the features have been read, so that the collected extents can be */
+/* bulk-loaded into a packed R-tree. */
+void OGROpenFileGDBLayer::CompleteSpatialIndex()
+{
+    CPLAssert( m_eSpatialIndexState == SPI_IN_BUILDING );
+    CPLAssert( m_pRTree == NULL );
+
+    const int nFeatures = static_cast<int>(m_ahSPIRows.size());
+    m_pRTree = CPLPackedRTreeCreateWithBounds(
+                    nFeatures,
+                    nFeatures ? &m_ahSPIRows[0] : NULL,
+                    nFeatures ? &m_asSPIBounds[0] : NULL,
+                    CPLPRT_ORDER_HILBERT, 0 );
+    std::vector<void*>().swap(m_ahSPIRows);
+    std::vector<CPLRectObj>().swap(m_asSPIBounds);
+
+    if( m_pRTree != NULL )
+    {
+        CPLDebug("OpenFileGDB", "SPI_COMPLETED");
+        m_eSpatialIndexState = SPI_COMPLETED;
+    }
+    else
+    {
+        m_eSpatialIndexState = SPI_INVALID;
+    }
+}
+
 /***********************************************************************/
 /*                         GetCurrentFeature()                         */
 /***********************************************************************/
@@ -1318,7 +1368,7 @@ OGRFeature* OGROpenFileGDBLayer::GetCurrentFeature()
             if( m_poFeatureDefn->GetGeomFieldDefn(0)->IsIgnored() )
             {
                 if( m_eSpatialIndexState == SPI_IN_BUILDING )
-                    m_eSpatialIndexState = SPI_INVALID;
+                    InvalidateSpatialIndex();
                 continue;
             }
 
@@ -1326,21 +1376,7 @@ OGRFeature* OGROpenFileGDBLayer::GetCurrentFeature()
             if( psField != NULL )
             {
                 if( m_eSpatialIndexState == SPI_IN_BUILDING )
-                {
-                    OGREnvelope sFeatureEnvelope;
-                    if( m_poLyrTable->GetFeatureExtent(psField,
-                                                       &sFeatureEnvelope) )
-                    {
-                        CPLRectObj sBounds;
-                        sBounds.minx = sFeatureEnvelope.MinX;
-                        sBounds.miny = sFeatureEnvelope.MinY;
-                        sBounds.maxx = sFeatureEnvelope.MaxX;
-                        sBounds.maxy = sFeatureEnvelope.MaxY;
-                        CPLQuadTreeInsertWithBounds(m_pQuadTree,
-                                                    (void*)(size_t)iRow,
-                                                    &sBounds);
-                    }
-                }
+                    AddToSpatialIndex(iRow, psField);
 
                 if( m_poFilterGeom != NULL &&
                     m_eSpatialIndexState != SPI_COMPLETED &&
@@ -1476,8 +1512,7 @@ OGRFeature* OGROpenFileGDBLayer::GetNextFeature()
                     if( m_eSpatialIndexState == SPI_IN_BUILDING &&
                         m_iCurFeat == m_poLyrTable->GetTotalRecordCount() )
                     {
-                        CPLDebug("OpenFileGDB", "SPI_COMPLETED");
-                        m_eSpatialIndexState = SPI_COMPLETED;
+                        CompleteSpatialIndex();
                     }
                     if( poFeature )
                         break;
@@ -1542,7 +1577,7 @@ OGRErr OGROpenFileGDBLayer::SetNextByIndex( GIntBig nIndex )
         return OGRERR_FAILURE;
 
     if( m_eSpatialIndexState == SPI_IN_BUILDING )
-        m_eSpatialIndexState = SPI_INVALID;
+        InvalidateSpatialIndex();
 
     if( m_nFilteredFeatureCount >= 0 )
     {
@@ -1610,7 +1645,7 @@ GIntBig OGROpenFileGDBLayer::GetFeatureCount( int bForce )
     {
         int nCount = 0;
         if( m_eSpatialIndexState == SPI_IN_BUILDING && m_iCurFeat != 0 )
-            m_eSpatialIndexState = SPI_INVALID;
+            InvalidateSpatialIndex();
 
         int nFilteredFeatureCountAlloc = 0;
         if( m_eSpatialIndexState == SPI_IN_BUILDING )
@@ -1634,21 +1669,7 @@ GIntBig OGROpenFileGDBLayer::GetFeatureCount( int bForce )
             if( psField != NULL )
             {
                 if( m_eSpatialIndexState == SPI_IN_BUILDING )
-                {
-                    OGREnvelope sFeatureEnvelope;
-                    if( m_poLyrTable->GetFeatureExtent(psField,
-                                                       &sFeatureEnvelope) )
-                    {
-                        CPLRectObj sBounds;
-                        sBounds.minx = sFeatureEnvelope.MinX;
-                        sBounds.miny = sFeatureEnvelope.MinY;
-                        sBounds.maxx = sFeatureEnvelope.MaxX;
-                        sBounds.maxy = sFeatureEnvelope.MaxY;
-                        CPLQuadTreeInsertWithBounds(m_pQuadTree,
-                                                    (void*)(size_t)i,
-                                                    &sBounds);
-                    }
-                }
+                    AddToSpatialIndex(i, psField);
 
                 if( m_poLyrTable->DoesGeometryIntersectsFilterEnvelope(psField) )
                 {
@@ -1678,7 +1699,7 @@ GIntBig OGROpenFileGDBLayer::GetFeatureCount( int bForce )
         if( m_eSpatialIndexState == SPI_IN_BUILDING )
         {
             m_nFilteredFeatureCount = nCount;
-            m_eSpatialIndexState = SPI_COMPLETED;
+            CompleteSpatialIndex();
         }
 
         return nCount;
@@ -35,6 +35,7 @@
 
 #include "ogrsf_frmts.h"
 #include "cpl_string.h"
+#include "cpl_virtualmem.h"
 
 #include <set>
 #include <map>
@@ -385,6 +386,10 @@ class OGROSMDataSource : public OGRDataSource
     bool                bMustUnlinkNodesFile;
     GIntBig             nNodesFileSize;
     VSILFILE           *fpNodes;
+    /* Direct read-only view of the content of fpNodes for lookups */
+    CPLVirtualMem      *psNodesVirtualMem;
+    const GByte        *pabyNodesView;
+    GIntBig             nNodesViewSize;
 
     GIntBig             nPrevNodeId;
     int                 nBucketOld;
@@ -447,6 +452,11 @@ class OGROSMDataSource : public OGRDataSource
 
     bool                TransferToDiskIfNecesserary();
 
+    void                UpdateNodesView();
+    void                ReleaseNodesView();
+    bool                ReadNodesFile( GIntBig nOffset, void* pBuffer,
+                                       size_t nSize );
+
     bool                AllocBucket(int iBucket);
     bool                AllocMoreBuckets( int nNewBucketIdx,
                                           bool bAllocBucket = false );
@@ -250,6 +250,9 @@ OGROSMDataSource::OGROSMDataSource() :
     bMustUnlinkNodesFile(true),
     nNodesFileSize(0),
     fpNodes(NULL),
+    psNodesVirtualMem(NULL),
+    pabyNodesView(NULL),
+    nNodesViewSize(0),
     nPrevNodeId(-INT_MAX),
     nBucketOld(-1),
     nOffInBucketReducedOld(-1),
@@ -341,6 +344,7 @@ OGROSMDataSource::~OGROSMDataSource()
         delete psKD;
     }
 
+    ReleaseNodesView();
     if( fpNodes )
         VSIFCloseL(fpNodes);
     if( osNodesFilename.size() && bMustUnlinkNodesFile )
@@ -1071,6 +1075,90 @@ static int DecompressSector(GByte* pabyIn, int nSectorSize, GByte* pabyOut)
     return( nRead == nSectorSize );
 }
 
+/************************************************************************/
+/*                          ReleaseNodesView()                          */
+/************************************************************************/
+
+void OGROSMDataSource::ReleaseNodesView()
+{
+    if( psNodesVirtualMem != NULL )
+        CPLVirtualMemFree(psNodesVirtualMem);
+    psNodesVirtualMem = NULL;
+    pabyNodesView = NULL;
+    nNodesViewSize = 0;
+}
+
+/************************************************************************/
+/*                           UpdateNodesView()                          */
+/*                                                                      */
+/*      Get a direct view of the temporary node file, so that node      */
+/*      lookups are plain memory accesses instead of seeks and reads.   */
+/*      The in-memory file buffer is used directly, and the on-disk     */
+/*      file is memory mapped when possible.                            */
+/************************************************************************/
+
+void OGROSMDataSource::UpdateNodesView()
+{
+    if( bInMemoryNodesFile )
+    {
+        /* The buffer of the /vsimem file may be reallocated when writing */
+        /* to it, so always fetch it again. */
+        ReleaseNodesView();
+        vsi_l_offset nLength = 0;
+        GByte* pabyBuffer =
+            VSIGetMemFileBuffer(osNodesFilename, &nLength, FALSE);
+        if( pabyBuffer != NULL &&
+            nLength >= static_cast<vsi_l_offset>(nNodesFileSize) )
+        {
+            pabyNodesView = pabyBuffer;
+            nNodesViewSize = nNodesFileSize;
+        }
+        return;
+    }
+
+    if( psNodesVirtualMem != NULL && nNodesViewSize == nNodesFileSize )
+        return;
+
+    ReleaseNodesView();
+    if( nNodesFileSize == 0 || !CPLIsVirtualMemFileMapAvailable() ||
+        !CPLTestBool(CPLGetConfigOption("OSM_MMAP_NODES_FILE", "YES")) )
+        return;
+
+    VSIFFlushL(fpNodes);
+    CPLPushErrorHandler(CPLQuietErrorHandler);
+    psNodesVirtualMem = CPLVirtualMemFileMapNew(
+        fpNodes, 0, static_cast<vsi_l_offset>(nNodesFileSize),
+        VIRTUALMEM_READONLY, NULL, NULL);
+    CPLPopErrorHandler();
+    if( psNodesVirtualMem != NULL )
+    {
+        pabyNodesView = static_cast<const GByte*>(
+            CPLVirtualMemGetAddr(psNodesVirtualMem));
+        nNodesViewSize = nNodesFileSize;
+    }
+}
+
+/************************************************************************/
+/*                            ReadNodesFile()                           */
+/************************************************************************/
+
+bool OGROSMDataSource::ReadNodesFile( GIntBig nOffset, void* pBuffer,
+                                      size_t nSize )
+{
+    if( pabyNodesView != NULL )
+    {
+        if( nOffset < 0 ||
+            nOffset + static_cast<GIntBig>(nSize) > nNodesViewSize )
+            return false;
+        memcpy(pBuffer, pabyNodesView + nOffset, nSize);
+        return true;
+    }
+
+    return VSIFSeekL(fpNodes, static_cast<vsi_l_offset>(nOffset),
+                     SEEK_SET) == 0 &&
+           VSIFReadL(pBuffer, 1, nSize, fpNodes) == nSize;
+}
+
 /************************************************************************/
 /*                           LookupNodesCustom()                        */
 /************************************************************************/
@@ -1090,6 +1178,8 @@ void OGROSMDataSource::LookupNodesCustom( )
         nBucketOld = -1;
     }
 
+    UpdateNodesView();
+
     unsigned int i;
 
     CPLAssert(nUnsortedReqIds <= MAX_ACCUMULATED_NODES);
@@ -1212,10 +1302,10 @@ void OGROSMDataSource::LookupNodesCustomCompressedCase()
                     nOffFromBucketStart += COMPRESS_SIZE_FROM_BYTE(psBucket->u.panSectorSize[k]);
             }
 
-            VSIFSeekL(fpNodes, psBucket->nOff + nOffFromBucketStart, SEEK_SET);
+            const GIntBig nSectorOff = psBucket->nOff + nOffFromBucketStart;
             if( nSectorSize == SECTOR_SIZE )
             {
-                if( VSIFReadL(pabySector, 1, SECTOR_SIZE, fpNodes) != SECTOR_SIZE )
+                if( !ReadNodesFile(nSectorOff, pabySector, SECTOR_SIZE) )
                 {
                     CPLError(CE_Failure,  CPLE_AppDefined,
                             "Cannot read node " CPL_FRMT_GIB, id);
@@ -1225,7 +1315,7 @@ void OGROSMDataSource::LookupNodesCustomCompressedCase()
             }
             else
             {
-                if( (int)VSIFReadL(abyRawSector, 1, nSectorSize, fpNodes) != nSectorSize )
+                if( !ReadNodesFile(nSectorOff, abyRawSector, nSectorSize) )
                 {
                     CPLError(CE_Failure,  CPLE_AppDefined,
                             "Cannot read sector for node " CPL_FRMT_GIB, id);
@@ -1265,10 +1355,16 @@ void OGROSMDataSource::LookupNodesCustomCompressedCase()
 
 void OGROSMDataSource::LookupNodesCustomNonCompressedCase()
 {
-    unsigned int i;
     unsigned int j = 0;
 
-    for(i = 0; i < nReqIds; i++)
+    /* As ids are sorted, the number of sectors before the one of the */
+    /* current node can be computed from the one of the previous node when */
+    /* they are in the same bucket */
+    int l_nBucketOld = -1;
+    int k = 0;
+    int nSectorsBefore = 0;
+
+    for( unsigned int i = 0; i < nReqIds; i++ )
     {
         GIntBig id = panReqIds[i];
 
@@ -1296,15 +1392,21 @@ void OGROSMDataSource::LookupNodesCustomNonCompressedCase()
             // FIXME ?
         }
 
-        int k;
-        int nSector = 0;
-        for(k = 0; k < nBitmapIndex; k++)
-            nSector += abyBitsCount[psBucket->u.pabyBitmap[k]];
+        if( nBucket != l_nBucketOld )
+        {
+            l_nBucketOld = nBucket;
+            k = 0;
+            nSectorsBefore = 0;
+        }
+        for( ; k < nBitmapIndex; k++ )
+            nSectorsBefore += abyBitsCount[psBucket->u.pabyBitmap[k]];
+        int nSector = nSectorsBefore;
         if (nBitmapRemainer)
             nSector += abyBitsCount[psBucket->u.pabyBitmap[nBitmapIndex] & ((1 << nBitmapRemainer) - 1)];
 
-        VSIFSeekL(fpNodes, psBucket->nOff + nSector * SECTOR_SIZE + nOffInBucketReducedRemainer * sizeof(LonLat), SEEK_SET);
-        if( VSIFReadL(pasLonLatArray + j, 1, sizeof(LonLat), fpNodes) != sizeof(LonLat) )
+        if( !ReadNodesFile(psBucket->nOff + nSector * SECTOR_SIZE +
+                                nOffInBucketReducedRemainer * sizeof(LonLat),
+                           pasLonLatArray + j, sizeof(LonLat)) )
         {
             CPLError(CE_Failure,  CPLE_AppDefined,
                      "Cannot read node " CPL_FRMT_GIB, id);
@@ -3724,6 +3826,7 @@ int OGROSMDataSource::ResetReading()
         nBucketOld = -1;
         nOffInBucketReducedOld = -1;
 
+        ReleaseNodesView();
         VSIFSeekL(fpNodes, 0, SEEK_SET);
         VSIFTruncateL(fpNodes, 0);
         nNodesFileSize = 0;
@@ -3833,10 +3936,13 @@ bool OGROSMDataSource::TransferToDiskIfNecesserary()
 {
     if( bInMemoryNodesFile )
     {
-        if( nNodesFileSize / 1024 / 1024 > 3 * nMaxSizeForInMemoryDBInMB / 4 )
+        if( nNodesFileSize >
+            static_cast<GIntBig>(nMaxSizeForInMemoryDBInMB) * 1024 * 1024 *
+            3 / 4 )
         {
             bInMemoryNodesFile = false;
 
+            ReleaseNodesView();
             VSIFCloseL(fpNodes);
             fpNodes = NULL;
 
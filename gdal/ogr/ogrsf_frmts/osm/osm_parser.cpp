@@ -31,8 +31,12 @@
 #include "gpb.h"
 
 #include "cpl_conv.h"
+#include "cpl_multiproc.h"
 #include "cpl_string.h"
 #include "cpl_vsi.h"
+#include "cpl_worker_thread_pool.h"
+
+#include <vector>
 
 #ifdef HAVE_EXPAT
 #include "ogr_expat.h"
@@ -65,6 +69,8 @@ CPL_CVSID("$Id$");
 /*                            _OSMContext                               */
 /************************************************************************/
 
+struct OSMBlobJob;
+
 struct _OSMContext
 {
     char          *pszStrBuf;
@@ -127,6 +133,19 @@ struct _OSMContext
 
     GUIntBig        nBytesRead;
 
+    /* Multi-threaded PBF decoding */
+    int                  nThreads;
+    CPLWorkerThreadPool *poWorkerPool;
+    OSMBlobJob         **papsJobs;
+    int                  nJobs;
+    int                  iNextJob;
+    int                  nJobsInFlight;
+    bool                 bReadAheadEOF;
+    bool                 bReadAheadError;
+    GUIntBig             nBytesReadAhead;
+    CPLMutex            *hJobMutex;
+    CPLCond             *hJobCond;
+
     NotifyNodesFunc     pfnNotifyNodes;
     NotifyWayFunc       pfnNotifyWay;
     NotifyRelationFunc  pfnNotifyRelation;
@@ -2179,6 +2198,9 @@ static OSMRetCode XML_ProcessBlock(OSMContext* psCtxt)
 
 #endif
 
+static void PBF_FreeThreads(OSMContext* psCtxt);
+static void PBF_WaitPendingJobs(OSMContext* psCtxt);
+
 /************************************************************************/
 /*                              OSM_Open()                              */
 /************************************************************************/
@@ -2259,6 +2281,10 @@ OSMContext* OSM_Open( const char* pszFilename,
     if( bPBF )
     {
         psCtxt->nBlobSizeAllocated = 64 * 1024 + EXTRA_BYTES;
+
+        /* Blobs are decoded by a pool of worker threads if more than one */
+        /* thread is available. The pool is started on the first block. */
+        psCtxt->nThreads = CPLGetNumThreads(NULL, "ALL_CPUS");
     }
 #ifdef HAVE_EXPAT
     else
@@ -2335,6 +2361,8 @@ void OSM_Close(OSMContext* psCtxt)
     }
 #endif
 
+    PBF_FreeThreads(psCtxt);
+
     VSIFree(psCtxt->pabyBlob);
     VSIFree(psCtxt->pabyUncompressed);
     VSIFree(psCtxt->panStrOff);
@@ -2352,6 +2380,8 @@ void OSM_Close(OSMContext* psCtxt)
 
 void OSM_ResetReading( OSMContext* psCtxt )
 {
+    PBF_WaitPendingJobs(psCtxt);
+
     VSIFSeekL(psCtxt->fp, 0, SEEK_SET);
 
     psCtxt->nBytesRead = 0;
@@ -2381,16 +2411,21 @@ void OSM_ResetReading( OSMContext* psCtxt )
 }
 
 /************************************************************************/
-/*                          OSM_ProcessBlock()                          */
+/*                            PBF_ReadBlob()                            */
 /************************************************************************/
 
-static OSMRetCode PBF_ProcessBlock(OSMContext* psCtxt)
+/* Read the next BlobHeader and the Blob that follows it in *ppabyBlob */
+static OSMRetCode PBF_ReadBlob(OSMContext* psCtxt,
+                               GByte** ppabyBlob,
+                               unsigned int* pnBlobSizeAllocated,
+                               unsigned int* pnBlobSize,
+                               BlobType* peType,
+                               GUIntBig* pnBytesRead)
 {
     int nRet = FALSE;
     GByte abyHeaderSize[4];
     unsigned int nHeaderSize;
     unsigned int nBlobSize = 0;
-    BlobType eType;
 
     if (VSIFReadL(abyHeaderSize, 4, 1, psCtxt->fp) != 1)
     {
@@ -2399,43 +2434,40 @@ static OSMRetCode PBF_ProcessBlock(OSMContext* psCtxt)
     nHeaderSize = (abyHeaderSize[0] << 24) | (abyHeaderSize[1] << 16) |
                     (abyHeaderSize[2] << 8) | abyHeaderSize[3];
 
-    psCtxt->nBytesRead += 4;
+    *pnBytesRead += 4;
 
     /* printf("nHeaderSize = %d\n", nHeaderSize); */
     if (nHeaderSize > 64 * 1024)
         GOTO_END_ERROR;
-    if (VSIFReadL(psCtxt->pabyBlob, 1, nHeaderSize, psCtxt->fp) != nHeaderSize)
+    if (VSIFReadL(*ppabyBlob, 1, nHeaderSize, psCtxt->fp) != nHeaderSize)
         GOTO_END_ERROR;
 
-    psCtxt->nBytesRead += nHeaderSize;
+    *pnBytesRead += nHeaderSize;
 
-    memset(psCtxt->pabyBlob + nHeaderSize, 0, EXTRA_BYTES);
-    nRet = ReadBlobHeader(psCtxt->pabyBlob, psCtxt->pabyBlob + nHeaderSize, &nBlobSize, &eType);
-    if (!nRet || eType == BLOB_UNKNOWN)
+    memset(*ppabyBlob + nHeaderSize, 0, EXTRA_BYTES);
+    nRet = ReadBlobHeader(*ppabyBlob, *ppabyBlob + nHeaderSize, &nBlobSize, peType);
+    if (!nRet || *peType == BLOB_UNKNOWN)
         GOTO_END_ERROR;
 
     if (nBlobSize > 64*1024*1024)
         GOTO_END_ERROR;
-    if (nBlobSize > psCtxt->nBlobSizeAllocated)
+    if (nBlobSize > *pnBlobSizeAllocated)
     {
         GByte* pabyBlobNew;
-        psCtxt->nBlobSizeAllocated = MAX(psCtxt->nBlobSizeAllocated * 2, nBlobSize);
-        pabyBlobNew = (GByte*)VSI_REALLOC_VERBOSE(psCtxt->pabyBlob,
-                                        psCtxt->nBlobSizeAllocated + EXTRA_BYTES);
+        *pnBlobSizeAllocated = MAX(*pnBlobSizeAllocated * 2, nBlobSize);
+        pabyBlobNew = (GByte*)VSI_REALLOC_VERBOSE(*ppabyBlob,
+                                        *pnBlobSizeAllocated + EXTRA_BYTES);
         if( pabyBlobNew == NULL )
             GOTO_END_ERROR;
-        psCtxt->pabyBlob = pabyBlobNew;
+        *ppabyBlob = pabyBlobNew;
     }
-    if (VSIFReadL(psCtxt->pabyBlob, 1, nBlobSize, psCtxt->fp) != nBlobSize)
+    if (VSIFReadL(*ppabyBlob, 1, nBlobSize, psCtxt->fp) != nBlobSize)
         GOTO_END_ERROR;
 
-    psCtxt->nBytesRead += nBlobSize;
+    *pnBytesRead += nBlobSize;
 
-    memset(psCtxt->pabyBlob + nBlobSize, 0, EXTRA_BYTES);
-    nRet = ReadBlob(psCtxt->pabyBlob, nBlobSize, eType,
-                    psCtxt);
-    if (!nRet)
-        GOTO_END_ERROR;
+    memset(*ppabyBlob + nBlobSize, 0, EXTRA_BYTES);
+    *pnBlobSize = nBlobSize;
 
     return OSM_OK;
 
@@ -2444,6 +2476,425 @@ end_error:
     return OSM_ERROR;
 }
 
+/************************************************************************/
+/*                              OSMBlobJob                              */
+/************************************************************************/
+
+/* When several threads are available, blobs are read in advance on the */
+/* calling thread, and inflated and decoded by worker threads. The */
+/* objects decoded by a worker are recorded in its job, and the */
+/* notification callbacks are then replayed in file order by */
+/* OSM_ProcessBlock(). The strings referenced by the recorded objects point */
+/* to the decompressed buffer of the job, which is kept until the job is */
+/* recycled. */
+
+typedef enum
+{
+    OSM_EVENT_NODES,
+    OSM_EVENT_WAY,
+    OSM_EVENT_RELATION,
+    OSM_EVENT_BOUNDS
+} OSMEventType;
+
+typedef struct
+{
+    OSMEventType eType;
+    unsigned int nCount;
+} OSMEvent;
+
+struct OSMBlobJob
+{
+    OSMContext               sCtxt;
+    GByte                   *pabyBlob;
+    unsigned int             nBlobSizeAllocated;
+    unsigned int             nBlobSize;
+    BlobType                 eType;
+    GUIntBig                 nBytesRead;
+    bool                     bOK;
+    bool                     bDone;
+    CPLMutex                *hMutex;
+    CPLCond                 *hCond;
+
+    std::vector<OSMEvent>    asEvents;
+    std::vector<OSMNode>     asNodes;
+    std::vector<OSMWay>      asWays;
+    std::vector<OSMRelation> asRelations;
+    std::vector<OSMTag>      asTags;
+    std::vector<GIntBig>     anNodeRefs;
+    std::vector<OSMMember>   asMembers;
+    double                   adfBounds[4];
+};
+
+/************************************************************************/
+/*                          OSM_RecordEvent()                           */
+/************************************************************************/
+
+static void OSM_RecordEvent(OSMBlobJob* psJob, OSMEventType eType,
+                            unsigned int nCount)
+{
+    OSMEvent sEvent;
+    sEvent.eType = eType;
+    sEvent.nCount = nCount;
+    psJob->asEvents.push_back(sEvent);
+}
+
+/************************************************************************/
+/*                          OSM_RecordNodes()                           */
+/************************************************************************/
+
+static void OSM_RecordNodes(unsigned int nNodes, OSMNode* pasNodes,
+                            OSMContext* /* psCtxt */, void* user_data)
+{
+    OSMBlobJob* psJob = static_cast<OSMBlobJob*>(user_data);
+    OSM_RecordEvent(psJob, OSM_EVENT_NODES, nNodes);
+    for( unsigned int i = 0; i < nNodes; i++ )
+    {
+        psJob->asNodes.push_back(pasNodes[i]);
+        if( pasNodes[i].nTags )
+            psJob->asTags.insert(psJob->asTags.end(), pasNodes[i].pasTags,
+                                 pasNodes[i].pasTags + pasNodes[i].nTags);
+    }
+}
+
+/************************************************************************/
+/*                           OSM_RecordWay()                            */
+/************************************************************************/
+
+static void OSM_RecordWay(OSMWay* psWay, OSMContext* /* psCtxt */,
+                          void* user_data)
+{
+    OSMBlobJob* psJob = static_cast<OSMBlobJob*>(user_data);
+    OSM_RecordEvent(psJob, OSM_EVENT_WAY, 1);
+    psJob->asWays.push_back(*psWay);
+    if( psWay->nTags )
+        psJob->asTags.insert(psJob->asTags.end(), psWay->pasTags,
+                             psWay->pasTags + psWay->nTags);
+    if( psWay->nRefs )
+        psJob->anNodeRefs.insert(psJob->anNodeRefs.end(), psWay->panNodeRefs,
+                                 psWay->panNodeRefs + psWay->nRefs);
+}
+
+/************************************************************************/
+/*                         OSM_RecordRelation()                         */
+/************************************************************************/
+
+static void OSM_RecordRelation(OSMRelation* psRelation,
+                               OSMContext* /* psCtxt */, void* user_data)
+{
+    OSMBlobJob* psJob = static_cast<OSMBlobJob*>(user_data);
+    OSM_RecordEvent(psJob, OSM_EVENT_RELATION, 1);
+    psJob->asRelations.push_back(*psRelation);
+    if( psRelation->nTags )
+        psJob->asTags.insert(psJob->asTags.end(), psRelation->pasTags,
+                             psRelation->pasTags + psRelation->nTags);
+    if( psRelation->nMembers )
+        psJob->asMembers.insert(psJob->asMembers.end(),
+                                psRelation->pasMembers,
+                                psRelation->pasMembers + psRelation->nMembers);
+}
+
+/************************************************************************/
+/*                          OSM_RecordBounds()                          */
+/************************************************************************/
+
+static void OSM_RecordBounds(double dfXMin, double dfYMin,
+                             double dfXMax, double dfYMax,
+                             OSMContext* /* psCtxt */, void* user_data)
+{
+    OSMBlobJob* psJob = static_cast<OSMBlobJob*>(user_data);
+    OSM_RecordEvent(psJob, OSM_EVENT_BOUNDS, 1);
+    psJob->adfBounds[0] = dfXMin;
+    psJob->adfBounds[1] = dfYMin;
+    psJob->adfBounds[2] = dfXMax;
+    psJob->adfBounds[3] = dfYMax;
+}
+
+/************************************************************************/
+/*                           OSM_ReplayJob()                            */
+/************************************************************************/
+
+static void OSM_ReplayJob(OSMBlobJob* psJob, OSMContext* psCtxt)
+{
+    OSMNode* pasNodes = psJob->asNodes.empty() ? NULL : &psJob->asNodes[0];
+    OSMWay* pasWays = psJob->asWays.empty() ? NULL : &psJob->asWays[0];
+    OSMRelation* pasRelations =
+        psJob->asRelations.empty() ? NULL : &psJob->asRelations[0];
+    OSMTag* pasTags = psJob->asTags.empty() ? NULL : &psJob->asTags[0];
+    GIntBig* panNodeRefs =
+        psJob->anNodeRefs.empty() ? NULL : &psJob->anNodeRefs[0];
+    OSMMember* pasMembers =
+        psJob->asMembers.empty() ? NULL : &psJob->asMembers[0];
+
+    for( size_t i = 0; i < psJob->asEvents.size(); i++ )
+    {
+        const OSMEvent& sEvent = psJob->asEvents[i];
+        if( sEvent.eType == OSM_EVENT_NODES )
+        {
+            for( unsigned int j = 0; j < sEvent.nCount; j++ )
+            {
+                pasNodes[j].pasTags = pasNodes[j].nTags ? pasTags : NULL;
+                pasTags += pasNodes[j].nTags;
+            }
+            psCtxt->pfnNotifyNodes(sEvent.nCount, pasNodes,
+                                   psCtxt, psCtxt->user_data);
+            pasNodes += sEvent.nCount;
+        }
+        else if( sEvent.eType == OSM_EVENT_WAY )
+        {
+            pasWays->pasTags = pasWays->nTags ? pasTags : NULL;
+            pasTags += pasWays->nTags;
+            pasWays->panNodeRefs = panNodeRefs;
+            panNodeRefs += pasWays->nRefs;
+            psCtxt->pfnNotifyWay(pasWays, psCtxt, psCtxt->user_data);
+            pasWays ++;
+        }
+        else if( sEvent.eType == OSM_EVENT_RELATION )
+        {
+            pasRelations->pasTags = pasRelations->nTags ? pasTags : NULL;
+            pasTags += pasRelations->nTags;
+            pasRelations->pasMembers = pasMembers;
+            pasMembers += pasRelations->nMembers;
+            psCtxt->pfnNotifyRelation(pasRelations, psCtxt, psCtxt->user_data);
+            pasRelations ++;
+        }
+        else
+        {
+            psCtxt->dfLeft = psJob->adfBounds[0];
+            psCtxt->dfBottom = psJob->adfBounds[1];
+            psCtxt->dfRight = psJob->adfBounds[2];
+            psCtxt->dfTop = psJob->adfBounds[3];
+            psCtxt->pfnNotifyBounds(psCtxt->dfLeft, psCtxt->dfBottom,
+                                    psCtxt->dfRight, psCtxt->dfTop,
+                                    psCtxt, psCtxt->user_data);
+        }
+    }
+}
+
+/************************************************************************/
+/*                        OSM_DecodeBlobJobFunc()                       */
+/************************************************************************/
+
+static void OSM_DecodeBlobJobFunc(void* pData)
+{
+    OSMBlobJob* psJob = static_cast<OSMBlobJob*>(pData);
+
+    psJob->bOK = ReadBlob(psJob->pabyBlob, psJob->nBlobSize, psJob->eType,
+                          &psJob->sCtxt) != FALSE;
+
+    CPLAcquireMutex(psJob->hMutex, 1000.0);
+    psJob->bDone = true;
+    CPLCondBroadcast(psJob->hCond);
+    CPLReleaseMutex(psJob->hMutex);
+}
+
+/************************************************************************/
+/*                          PBF_FreeThreads()                           */
+/************************************************************************/
+
+static void PBF_FreeThreads(OSMContext* psCtxt)
+{
+    /* Make sure no worker is still using a job */
+    delete psCtxt->poWorkerPool;
+    psCtxt->poWorkerPool = NULL;
+
+    for( int i = 0; i < psCtxt->nJobs; i++ )
+    {
+        OSMBlobJob* psJob = psCtxt->papsJobs[i];
+        VSIFree(psJob->sCtxt.pabyUncompressed);
+        VSIFree(psJob->sCtxt.panStrOff);
+        VSIFree(psJob->sCtxt.pasNodes);
+        VSIFree(psJob->sCtxt.pasTags);
+        VSIFree(psJob->sCtxt.pasMembers);
+        VSIFree(psJob->sCtxt.panNodeRefs);
+        VSIFree(psJob->pabyBlob);
+        delete psJob;
+    }
+    CPLFree(psCtxt->papsJobs);
+    psCtxt->papsJobs = NULL;
+    psCtxt->nJobs = 0;
+    psCtxt->nJobsInFlight = 0;
+
+    if( psCtxt->hJobCond )
+        CPLDestroyCond(psCtxt->hJobCond);
+    psCtxt->hJobCond = NULL;
+    if( psCtxt->hJobMutex )
+        CPLDestroyMutex(psCtxt->hJobMutex);
+    psCtxt->hJobMutex = NULL;
+}
+
+/************************************************************************/
+/*                          PBF_InitThreads()                           */
+/************************************************************************/
+
+static bool PBF_InitThreads(OSMContext* psCtxt)
+{
+    psCtxt->poWorkerPool = new CPLWorkerThreadPool();
+    if( !psCtxt->poWorkerPool->Setup(psCtxt->nThreads, NULL, NULL) )
+    {
+        delete psCtxt->poWorkerPool;
+        psCtxt->poWorkerPool = NULL;
+        return false;
+    }
+
+    psCtxt->hJobMutex = CPLCreateMutex();
+    CPLReleaseMutex(psCtxt->hJobMutex);
+    psCtxt->hJobCond = CPLCreateCond();
+
+    /* Bound the number of blobs in flight, and thus the memory usage */
+    const int nJobs = 2 * psCtxt->nThreads;
+    psCtxt->papsJobs = static_cast<OSMBlobJob**>(
+        CPLCalloc(nJobs, sizeof(OSMBlobJob*)));
+    for( int i = 0; i < nJobs; i++ )
+    {
+        OSMBlobJob* psJob = new OSMBlobJob();
+        psCtxt->papsJobs[i] = psJob;
+        psCtxt->nJobs ++;
+        memset(&psJob->sCtxt, 0, sizeof(OSMContext));
+        psJob->sCtxt.bPBF = TRUE;
+        psJob->sCtxt.pfnNotifyNodes = OSM_RecordNodes;
+        psJob->sCtxt.pfnNotifyWay = OSM_RecordWay;
+        psJob->sCtxt.pfnNotifyRelation = OSM_RecordRelation;
+        psJob->sCtxt.pfnNotifyBounds = OSM_RecordBounds;
+        psJob->sCtxt.user_data = psJob;
+        psJob->nBlobSizeAllocated = 64 * 1024 + EXTRA_BYTES;
+        psJob->pabyBlob = (GByte*)VSI_MALLOC_VERBOSE(psJob->nBlobSizeAllocated);
+        psJob->nBlobSize = 0;
+        psJob->eType = BLOB_UNKNOWN;
+        psJob->nBytesRead = 0;
+        psJob->bOK = false;
+        psJob->bDone = true;
+        psJob->hMutex = psCtxt->hJobMutex;
+        psJob->hCond = psCtxt->hJobCond;
+        if( psJob->pabyBlob == NULL )
+        {
+            PBF_FreeThreads(psCtxt);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/************************************************************************/
+/*                        PBF_WaitPendingJobs()                         */
+/************************************************************************/
+
+static void PBF_WaitPendingJobs(OSMContext* psCtxt)
+{
+    if( psCtxt->poWorkerPool == NULL )
+        return;
+    psCtxt->poWorkerPool->WaitCompletion();
+    psCtxt->iNextJob = 0;
+    psCtxt->nJobsInFlight = 0;
+    psCtxt->bReadAheadEOF = false;
+    psCtxt->bReadAheadError = false;
+    psCtxt->nBytesReadAhead = 0;
+}
+
+/************************************************************************/
+/*                        PBF_ProcessBlockMT()                          */
+/************************************************************************/
+
+static OSMRetCode PBF_ProcessBlockMT(OSMContext* psCtxt)
+{
+    /* Keep the window of blobs being decoded full */
+    while( !psCtxt->bReadAheadEOF && !psCtxt->bReadAheadError &&
+           psCtxt->nJobsInFlight < psCtxt->nJobs )
+    {
+        OSMBlobJob* psJob = psCtxt->papsJobs[
+            (psCtxt->iNextJob + psCtxt->nJobsInFlight) % psCtxt->nJobs];
+        OSMRetCode eRet = PBF_ReadBlob(psCtxt, &psJob->pabyBlob,
+                                       &psJob->nBlobSizeAllocated,
+                                       &psJob->nBlobSize, &psJob->eType,
+                                       &psCtxt->nBytesReadAhead);
+        if( eRet == OSM_EOF )
+        {
+            psCtxt->bReadAheadEOF = true;
+            break;
+        }
+        if( eRet == OSM_ERROR )
+        {
+            psCtxt->bReadAheadError = true;
+            break;
+        }
+
+        psJob->nBytesRead = psCtxt->nBytesReadAhead;
+        psJob->bOK = false;
+        psJob->bDone = false;
+        psJob->asEvents.clear();
+        psJob->asNodes.clear();
+        psJob->asWays.clear();
+        psJob->asRelations.clear();
+        psJob->asTags.clear();
+        psJob->anNodeRefs.clear();
+        psJob->asMembers.clear();
+        if( !psCtxt->poWorkerPool->SubmitJob(OSM_DecodeBlobJobFunc, psJob) )
+        {
+            psJob->bDone = true;
+            psCtxt->bReadAheadError = true;
+            break;
+        }
+        psCtxt->nJobsInFlight ++;
+    }
+
+    if( psCtxt->nJobsInFlight == 0 )
+    {
+        if( psCtxt->bReadAheadError )
+        {
+            psCtxt->nBytesRead = psCtxt->nBytesReadAhead;
+            return OSM_ERROR;
+        }
+        return OSM_EOF;
+    }
+
+    /* Consume the blobs in file order */
+    OSMBlobJob* psJob = psCtxt->papsJobs[psCtxt->iNextJob];
+    CPLAcquireMutex(psCtxt->hJobMutex, 1000.0);
+    while( !psJob->bDone )
+        CPLCondWait(psCtxt->hJobCond, psCtxt->hJobMutex);
+    CPLReleaseMutex(psCtxt->hJobMutex);
+
+    psCtxt->iNextJob = (psCtxt->iNextJob + 1) % psCtxt->nJobs;
+    psCtxt->nJobsInFlight --;
+    psCtxt->nBytesRead = psJob->nBytesRead;
+
+    if( !psJob->bOK )
+        return OSM_ERROR;
+
+    OSM_ReplayJob(psJob, psCtxt);
+
+    return OSM_OK;
+}
+
+/************************************************************************/
+/*                          PBF_ProcessBlock()                          */
+/************************************************************************/
+
+static OSMRetCode PBF_ProcessBlock(OSMContext* psCtxt)
+{
+    if( psCtxt->nThreads > 1 )
+    {
+        if( psCtxt->poWorkerPool == NULL && !PBF_InitThreads(psCtxt) )
+            psCtxt->nThreads = 1;
+        else
+            return PBF_ProcessBlockMT(psCtxt);
+    }
+
+    unsigned int nBlobSize = 0;
+    BlobType eType;
+
+    OSMRetCode eRet = PBF_ReadBlob(psCtxt, &psCtxt->pabyBlob,
+                                   &psCtxt->nBlobSizeAllocated,
+                                   &nBlobSize, &eType, &psCtxt->nBytesRead);
+    if( eRet != OSM_OK )
+        return eRet;
+
+    if( !ReadBlob(psCtxt->pabyBlob, nBlobSize, eType, psCtxt) )
+        return OSM_ERROR;
+
+    return OSM_OK;
+}
+
 /************************************************************************/
 /*                          OSM_ProcessBlock()                          */
 /************************************************************************/
@@ -30,31 +30,12 @@
 #include "cpl_conv.h"
 #include "cpl_port.h"
 #include "cpl_error.h"
-#include "cpl_quad_tree.h"
+#include "cpl_packed_rtree.h"
 
 namespace Selafin {
 
     const char SELAFIN_ERROR_MESSAGE[]="Error when reading Selafin file\n";
 
-    struct Point {
-        int nIndex;
-        const Header *poHeader;
-    };
-
-    static void GetBoundsFunc(const void *hFeature,CPLRectObj *poBounds) {
-        const Point *poPoint=(const Point*)hFeature;
-        poBounds->minx=poPoint->poHeader->paadfCoords[0][poPoint->nIndex];
-        poBounds->maxx=poPoint->poHeader->paadfCoords[0][poPoint->nIndex];
-        poBounds->miny=poPoint->poHeader->paadfCoords[1][poPoint->nIndex];
-        poBounds->maxy=poPoint->poHeader->paadfCoords[1][poPoint->nIndex];
-    }
-
-    static int DumpFeatures(void *pElt,
-                     CPL_UNUSED void *pUserData) {
-        Point *poPoint=(Point*)pElt;
-        delete poPoint;
-        return TRUE;
-    }
 
 
     /****************************************************************/
@@ -96,10 +77,7 @@ namespace Selafin {
         }
         CPLFree(panConnectivity);
         CPLFree(panBorder);
-        if (poTree!=NULL) {
-            CPLQuadTreeForeach(poTree,DumpFeatures,NULL);
-            CPLQuadTreeDestroy(poTree);
-        }
+        if (poTree!=NULL) CPLPackedRTreeDestroy(poTree);
         CPLFree(panStartDate);
         for (size_t i=0;i<2;++i) CPLFree(paadfCoords[i]);
         if (fp!=NULL) VSIFCloseL(fp);
@@ -139,25 +117,24 @@ namespace Selafin {
     }
 
     int Header::getClosestPoint(const double &dfx,const double &dfy,const double &dfMax) {
-        // If there is no quad-tree of the points, build it now
+        // If there is no R-tree of the points, build it now
         if (bTreeUpdateNeeded) {
             if (poTree!=NULL) {
-                CPLQuadTreeForeach(poTree,DumpFeatures,NULL);
-                CPLQuadTreeDestroy(poTree);
+                CPLPackedRTreeDestroy(poTree);
+                poTree=NULL;
             }
         }
         if (bTreeUpdateNeeded || poTree==NULL) {
             bTreeUpdateNeeded=false;
-            CPLRectObj *poBB=getBoundingBox();
-            poTree=CPLQuadTreeCreate(poBB,GetBoundsFunc);
-            delete poBB;
-            CPLQuadTreeSetBucketCapacity(poTree,2);
+            CPLRectObj *pasBounds=(CPLRectObj*)VSI_MALLOC2_VERBOSE(nPoints,sizeof(CPLRectObj));
+            if (pasBounds==NULL) return -1;
             for (int i=0;i<nPoints;++i) {
-                Point *poPoint=new Point;
-                poPoint->poHeader=this;
-                poPoint->nIndex=i;
-                CPLQuadTreeInsert(poTree,(void*)poPoint);
+                pasBounds[i].minx=pasBounds[i].maxx=paadfCoords[0][i];
+                pasBounds[i].miny=pasBounds[i].maxy=paadfCoords[1][i];
             }
+            poTree=CPLPackedRTreeCreateWithBounds(nPoints,NULL,pasBounds,CPLPRT_ORDER_HILBERT,0);
+            CPLFree(pasBounds);
+            if (poTree==NULL) return -1;
         }
         // Now we can look for the nearest neighbour using this tree
         int nIndex=-1;
@@ -168,23 +145,22 @@ namespace Selafin {
         poObj.miny=dfy-dfMax;
         poObj.maxy=dfy+dfMax;
         int nFeatureCount;
-        void **phResults=CPLQuadTreeSearch(poTree,&poObj,&nFeatureCount);
+        int *panResults=CPLPackedRTreeSearchIndices(poTree,&poObj,&nFeatureCount);
         if (nFeatureCount<=0) return -1;
         double dfa,dfb,dfc;
         dfMin=dfMax*dfMax;
         for (int i=0;i<nFeatureCount;++i) {
-            Point *poPoint=(Point*)(phResults[i]);
-            dfa=dfx-poPoint->poHeader->paadfCoords[0][poPoint->nIndex];
+            dfa=dfx-paadfCoords[0][panResults[i]];
             dfa*=dfa;
             if (dfa>=dfMin) continue;
-            dfb=dfy-poPoint->poHeader->paadfCoords[1][poPoint->nIndex];
+            dfb=dfy-paadfCoords[1][panResults[i]];
             dfc=dfa+dfb*dfb;
             if (dfc<dfMin) {
                 dfMin=dfc;
-                nIndex=poPoint->nIndex;
+                nIndex=panResults[i];
             }
         }
-        CPLFree(phResults);
+        CPLFree(panResults);
         return nIndex;
     }
 
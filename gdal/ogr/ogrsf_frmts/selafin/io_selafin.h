@@ -30,7 +30,7 @@
 #define  IO_SELAFIN_H_INC
 
 #include "cpl_vsi.h"
-#include "cpl_quad_tree.h"
+#include "cpl_packed_rtree.h"
 
 namespace Selafin {
     /**
@@ -44,7 +44,7 @@ namespace Selafin {
             int nMaxxIndex;    //!< Index of the point at the eastern border of the bounding box
             int nMinyIndex;    //!< Index of the point at the southern border of the bounding box
             int nMaxyIndex;    //!< Index of the point at the northern border of the bounding box
-            bool bTreeUpdateNeeded;  //!< Tell if the quad tree has to be updated
+            bool bTreeUpdateNeeded;  //!< Tell if the R-tree has to be updated
         public:
             //size_t nRefCount;   //!< Number of references to this object
             VSILFILE *fp;   //!< Pointer to the file with the layers
@@ -57,7 +57,7 @@ namespace Selafin {
             int nPointsPerElement;  //!< Number of points per element
             int *panConnectivity;   //!< Connectivity table of elements: first nPointsPerElement elements are the indices of the points making the first element, and so on. In the Selafin file, the first point has index 1.
             double *paadfCoords[2]; //!< Table of coordinates of points: x then y
-            CPLQuadTree *poTree;    //!< Quad-tree for spatially indexing points in the array paadfCoords. The tree will mostly contain a Null value, until a request is made to find a closest neighbour, in which case it will be built and maintained
+            CPLPackedRTree *poTree;    //!< Packed R-tree for spatially indexing points in the array paadfCoords. The tree will mostly contain a Null value, until a request is made to find a closest neighbour, in which case it will be built and maintained
             double adfOrigin[2];  //!< Table of coordinates of the origin of the axis
             int *panBorder;    //!< Array of integers defining border points (0 for an inner point, and the index of the border point otherwise). This table is not used by the driver but stored to allow to rewrite the header if needed
             int *panStartDate;    //!< Table with the starting date of the simulation (may be 0 if date is not defined). Date is registered as a set of six elements: year, month, day, hour, minute, second.
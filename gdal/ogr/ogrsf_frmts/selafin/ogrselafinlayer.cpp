@@ -32,7 +32,7 @@
 #include "io_selafin.h"
 #include "ogr_selafin.h"
 #include "cpl_error.h"
-#include "cpl_quad_tree.h"
+#include "cpl_packed_rtree.h"
 
 /************************************************************************/
 /*                           Utilities functions                        */
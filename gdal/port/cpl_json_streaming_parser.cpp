@@ -0,0 +1,598 @@
+/******************************************************************************
+ * $Id$
+ *
+ * Project:  CPL - Common Portability Library
+ * Purpose:  JSon streaming parser
+ * Author:   agent <agent at local>
+ *
+ ******************************************************************************
+ * Copyright (c) 2026, agent <agent at local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ****************************************************************************/
+
+#include "cpl_json_streaming_parser.h"
+
+#include <string.h>
+
+#include "cpl_conv.h"
+#include "cpl_error.h"
+#include "cpl_string.h"
+
+CPL_CVSID("$Id$");
+
+/************************************************************************/
+/*                       CPLJSonStreamingParser()                       */
+/************************************************************************/
+
+CPLJSonStreamingParser::CPLJSonStreamingParser() :
+    m_bExceptionOccurred(false),
+    m_bElementFound(false),
+    m_bStopParsing(false),
+    m_nLineCounter(1),
+    m_nCharCounter(1),
+    m_nOffset(0),
+    m_bInStringEscape(false),
+    m_bInUnicode(false),
+    m_nHighSurrogate(0),
+    m_nMaxDepth(1024),
+    m_nMaxStringSize(10 * 1024 * 1024)
+{
+    m_aState.push_back(INIT);
+}
+
+/************************************************************************/
+/*                      ~CPLJSonStreamingParser()                       */
+/************************************************************************/
+
+CPLJSonStreamingParser::~CPLJSonStreamingParser()
+{
+}
+
+/************************************************************************/
+/*                           SetMaxDepth()                              */
+/************************************************************************/
+
+void CPLJSonStreamingParser::SetMaxDepth(size_t nVal)
+{
+    m_nMaxDepth = nVal;
+}
+
+/************************************************************************/
+/*                         SetMaxStringSize()                           */
+/************************************************************************/
+
+void CPLJSonStreamingParser::SetMaxStringSize(size_t nVal)
+{
+    m_nMaxStringSize = nVal;
+}
+
+/************************************************************************/
+/*                                Reset()                               */
+/************************************************************************/
+
+void CPLJSonStreamingParser::Reset()
+{
+    m_bExceptionOccurred = false;
+    m_bElementFound = false;
+    m_bStopParsing = false;
+    m_nLineCounter = 1;
+    m_nCharCounter = 1;
+    m_nOffset = 0;
+    m_aState.clear();
+    m_aState.push_back(INIT);
+    m_aeMemberState.clear();
+    m_aeArrayState.clear();
+    m_osToken.clear();
+    m_bInStringEscape = false;
+    m_bInUnicode = false;
+    m_osUnicodeHex.clear();
+    m_nHighSurrogate = 0;
+}
+
+/************************************************************************/
+/*                              Exception()                             */
+/************************************************************************/
+
+void CPLJSonStreamingParser::Exception(const char* pszMessage)
+{
+    CPLError(CE_Failure, CPLE_AppDefined, "%s", pszMessage);
+}
+
+/************************************************************************/
+/*                           EmitException()                            */
+/************************************************************************/
+
+bool CPLJSonStreamingParser::EmitException(const char* pszMessage)
+{
+    m_bExceptionOccurred = true;
+    Exception(CPLSPrintf("JSon parsing error: %s (at line %d, character %d)",
+                         pszMessage, m_nLineCounter, m_nCharCounter));
+    return false;
+}
+
+/************************************************************************/
+/*                             ValueDone()                              */
+/************************************************************************/
+
+/* Update the state of the enclosing object or array once a value has */
+/* been completely read */
+void CPLJSonStreamingParser::ValueDone()
+{
+    const State eState = m_aState.back();
+    if( eState == OBJECT )
+        m_aeMemberState.back() = MEMBER_AFTER_VALUE;
+    else if( eState == ARRAY )
+        m_aeArrayState.back() = ARRAY_AFTER_VALUE;
+    else
+        m_bElementFound = true;
+}
+
+/************************************************************************/
+/*                             StartValue()                             */
+/************************************************************************/
+
+bool CPLJSonStreamingParser::StartValue(char ch)
+{
+    if( ch == '{' || ch == '[' )
+    {
+        if( m_aState.size() > m_nMaxDepth )
+            return EmitException("Too many nested objects and/or arrays");
+        if( ch == '{' )
+        {
+            m_aState.push_back(OBJECT);
+            m_aeMemberState.push_back(MEMBER_START);
+            StartObject();
+        }
+        else
+        {
+            m_aState.push_back(ARRAY);
+            m_aeArrayState.push_back(ARRAY_START);
+            StartArray();
+        }
+        return true;
+    }
+
+    m_osToken.clear();
+    if( ch == '"' )
+    {
+        m_aState.push_back(STRING);
+        return true;
+    }
+
+    m_osToken += ch;
+    if( ch == '-' || (ch >= '0' && ch <= '9') || ch == 'N' || ch == 'I' )
+        m_aState.push_back(NUMBER);
+    else if( ch == 't' )
+        m_aState.push_back(STATE_TRUE);
+    else if( ch == 'f' )
+        m_aState.push_back(STATE_FALSE);
+    else if( ch == 'n' )
+        m_aState.push_back(STATE_NULL);
+    else
+        return EmitException(CPLSPrintf("Unexpected character '%c'", ch));
+    return true;
+}
+
+/************************************************************************/
+/*                          EmitStringOrKey()                           */
+/************************************************************************/
+
+bool CPLJSonStreamingParser::EmitStringOrKey()
+{
+    m_aState.pop_back();
+    if( m_aState.back() == OBJECT &&
+        m_aeMemberState.back() == MEMBER_IN_KEY )
+    {
+        m_aeMemberState.back() = MEMBER_WAITING_COLON;
+        StartObjectMember(m_osToken.c_str(), m_osToken.size());
+    }
+    else
+    {
+        String(m_osToken.c_str(), m_osToken.size());
+        ValueDone();
+    }
+    m_osToken.clear();
+    return true;
+}
+
+/************************************************************************/
+/*                         AppendUnicodeChar()                          */
+/************************************************************************/
+
+static void AppendUTF8(std::string& osStr, unsigned nCode)
+{
+    if( nCode < 0x80 )
+    {
+        osStr += static_cast<char>(nCode);
+    }
+    else if( nCode < 0x800 )
+    {
+        osStr += static_cast<char>(0xC0 | (nCode >> 6));
+        osStr += static_cast<char>(0x80 | (nCode & 0x3F));
+    }
+    else if( nCode < 0x10000 )
+    {
+        osStr += static_cast<char>(0xE0 | (nCode >> 12));
+        osStr += static_cast<char>(0x80 | ((nCode >> 6) & 0x3F));
+        osStr += static_cast<char>(0x80 | (nCode & 0x3F));
+    }
+    else
+    {
+        osStr += static_cast<char>(0xF0 | (nCode >> 18));
+        osStr += static_cast<char>(0x80 | ((nCode >> 12) & 0x3F));
+        osStr += static_cast<char>(0x80 | ((nCode >> 6) & 0x3F));
+        osStr += static_cast<char>(0x80 | (nCode & 0x3F));
+    }
+}
+
+bool CPLJSonStreamingParser::AppendUnicodeChar()
+{
+    const unsigned nCode =
+        static_cast<unsigned>(strtol(m_osUnicodeHex.c_str(), NULL, 16));
+    m_osUnicodeHex.clear();
+
+    if( nCode >= 0xD800 && nCode < 0xDC00 )
+    {
+        if( m_nHighSurrogate )
+            AppendUTF8(m_osToken, m_nHighSurrogate);
+        m_nHighSurrogate = nCode;
+        return true;
+    }
+    if( nCode >= 0xDC00 && nCode < 0xE000 && m_nHighSurrogate )
+    {
+        AppendUTF8(m_osToken, 0x10000 + ((m_nHighSurrogate - 0xD800) << 10) +
+                                (nCode - 0xDC00));
+        m_nHighSurrogate = 0;
+        return true;
+    }
+    if( m_nHighSurrogate )
+    {
+        AppendUTF8(m_osToken, m_nHighSurrogate);
+        m_nHighSurrogate = 0;
+    }
+    AppendUTF8(m_osToken, nCode);
+    return true;
+}
+
+/************************************************************************/
+/*                        CheckAndEmitLiteral()                         */
+/************************************************************************/
+
+bool CPLJSonStreamingParser::CheckAndEmitLiteral()
+{
+    const State eState = m_aState.back();
+    m_aState.pop_back();
+    if( eState == STATE_TRUE && m_osToken == "true" )
+        Boolean(true);
+    else if( eState == STATE_FALSE && m_osToken == "false" )
+        Boolean(false);
+    else if( eState == STATE_NULL && m_osToken == "null" )
+        Null();
+    else
+        return EmitException(
+            CPLSPrintf("Invalid literal '%s'", m_osToken.c_str()));
+    m_osToken.clear();
+    ValueDone();
+    return true;
+}
+
+/************************************************************************/
+/*                            IsValidNumber()                           */
+/************************************************************************/
+
+/* Check that the token follows the JSon number grammar: */
+/* -?[0-9]+(\.[0-9]+)?([eE][+-]?[0-9]+)? */
+static bool IsValidNumber(const char* psz)
+{
+    if( *psz == '-' )
+        psz++;
+    if( !(*psz >= '0' && *psz <= '9') )
+        return false;
+    while( *psz >= '0' && *psz <= '9' )
+        psz++;
+    if( *psz == '.' )
+    {
+        psz++;
+        if( !(*psz >= '0' && *psz <= '9') )
+            return false;
+        while( *psz >= '0' && *psz <= '9' )
+            psz++;
+    }
+    if( *psz == 'e' || *psz == 'E' )
+    {
+        psz++;
+        if( *psz == '+' || *psz == '-' )
+            psz++;
+        if( !(*psz >= '0' && *psz <= '9') )
+            return false;
+        while( *psz >= '0' && *psz <= '9' )
+            psz++;
+    }
+    return *psz == '\0';
+}
+
+/************************************************************************/
+/*                        CheckAndEmitNumber()                          */
+/************************************************************************/
+
+bool CPLJSonStreamingParser::CheckAndEmitNumber()
+{
+    m_aState.pop_back();
+    if( m_osToken != "NaN" && m_osToken != "Infinity" &&
+        m_osToken != "-Infinity" && !IsValidNumber(m_osToken.c_str()) )
+    {
+        return EmitException(
+            CPLSPrintf("Invalid number '%s'", m_osToken.c_str()));
+    }
+    Number(m_osToken.c_str(), m_osToken.size());
+    m_osToken.clear();
+    ValueDone();
+    return true;
+}
+
+/************************************************************************/
+/*                                Parse()                               */
+/************************************************************************/
+
+/**
+ * Parse a chunk of a JSon document.
+ *
+ * The document can be fed by successive calls, the last one being done with
+ * bFinished = true. The callbacks of the subclass are invoked as the
+ * corresponding elements are recognized.
+ *
+ * @param pStr chunk of the document (not necessarily null terminated)
+ * @param nLength size of the chunk, in bytes
+ * @param bFinished whether this is the last chunk of the document
+ * @return false if an error occurred or if parsing has been stopped.
+ */
+bool CPLJSonStreamingParser::Parse(const char* pStr, size_t nLength,
+                                   bool bFinished)
+{
+    if( m_bExceptionOccurred || m_bStopParsing )
+        return false;
+
+    while( nLength > 0 && !m_bElementFound )
+    {
+        if( m_bStopParsing )
+            return false;
+
+        const char ch = *pStr;
+        size_t nAdvance = 1;
+        const State eState = m_aState.back();
+
+        if( eState == STRING )
+        {
+            if( m_nHighSurrogate && !m_bInUnicode &&
+                !(m_bInStringEscape && ch == 'u') &&
+                !(!m_bInStringEscape && ch == '\\') )
+            {
+                AppendUTF8(m_osToken, m_nHighSurrogate);
+                m_nHighSurrogate = 0;
+            }
+
+            if( m_bInUnicode )
+            {
+                if( !((ch >= '0' && ch <= '9') || (ch >= 'a' && ch <= 'f') ||
+                      (ch >= 'A' && ch <= 'F')) )
+                {
+                    return EmitException("Illegal character in unicode "
+                                         "sequence");
+                }
+                m_osUnicodeHex += ch;
+                if( m_osUnicodeHex.size() == 4 )
+                {
+                    m_bInUnicode = false;
+                    AppendUnicodeChar();
+                }
+            }
+            else if( m_bInStringEscape )
+            {
+                m_bInStringEscape = false;
+                switch( ch )
+                {
+                    case '"':
+                    case '\\':
+                    case '/': m_osToken += ch; break;
+                    case 'b': m_osToken += '\b'; break;
+                    case 'f': m_osToken += '\f'; break;
+                    case 'n': m_osToken += '\n'; break;
+                    case 'r': m_osToken += '\r'; break;
+                    case 't': m_osToken += '\t'; break;
+                    case 'u': m_bInUnicode = true; break;
+                    default:
+                        return EmitException("Illegal escape sequence");
+                }
+            }
+            else if( ch == '"' )
+            {
+                EmitStringOrKey();
+            }
+            else if( ch == '\\' )
+            {
+                m_bInStringEscape = true;
+            }
+            else
+            {
+                // Consume all the regular characters at once.
+                while( nAdvance < nLength && pStr[nAdvance] != '"' &&
+                       pStr[nAdvance] != '\\' )
+                {
+                    nAdvance++;
+                }
+                m_osToken.append(pStr, nAdvance);
+            }
+
+            if( m_osToken.size() > m_nMaxStringSize )
+                return EmitException("Too many characters in string");
+        }
+        else if( eState == NUMBER || eState == STATE_TRUE ||
+                 eState == STATE_FALSE || eState == STATE_NULL )
+        {
+            if( (ch >= '0' && ch <= '9') || (ch >= 'a' && ch <= 'z') ||
+                (ch >= 'A' && ch <= 'Z') || ch == '.' || ch == '+' ||
+                ch == '-' )
+            {
+                m_osToken += ch;
+                if( m_osToken.size() > 1024 )
+                    return EmitException("Too many characters in number or "
+                                         "literal");
+            }
+            else
+            {
+                const bool bOK = (eState == NUMBER) ? CheckAndEmitNumber() :
+                                                      CheckAndEmitLiteral();
+                if( !bOK )
+                    return false;
+                // Process the current character again in the new state.
+                continue;
+            }
+        }
+        else if( ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n' )
+        {
+            // Skip white space.
+        }
+        else if( eState == OBJECT )
+        {
+            MemberState& eMemberState = m_aeMemberState.back();
+            if( eMemberState == MEMBER_AFTER_VALUE && ch == ',' )
+            {
+                eMemberState = MEMBER_WAITING_KEY;
+            }
+            else if( (eMemberState == MEMBER_AFTER_VALUE ||
+                      eMemberState == MEMBER_START) && ch == '}' )
+            {
+                m_aState.pop_back();
+                m_aeMemberState.pop_back();
+                EndObject();
+                ValueDone();
+            }
+            else if( (eMemberState == MEMBER_START ||
+                      eMemberState == MEMBER_WAITING_KEY) && ch == '"' )
+            {
+                eMemberState = MEMBER_IN_KEY;
+                m_osToken.clear();
+                m_aState.push_back(STRING);
+            }
+            else if( eMemberState == MEMBER_WAITING_COLON && ch == ':' )
+            {
+                eMemberState = MEMBER_WAITING_VALUE;
+            }
+            else if( eMemberState == MEMBER_WAITING_VALUE )
+            {
+                if( !StartValue(ch) )
+                    return false;
+            }
+            else
+            {
+                return EmitException(
+                    CPLSPrintf("Unexpected character '%c' in object", ch));
+            }
+        }
+        else if( eState == ARRAY )
+        {
+            ArrayState& eArrayState = m_aeArrayState.back();
+            if( eArrayState == ARRAY_AFTER_VALUE && ch == ',' )
+            {
+                eArrayState = ARRAY_WAITING_VALUE;
+            }
+            else if( (eArrayState == ARRAY_AFTER_VALUE ||
+                      eArrayState == ARRAY_START) && ch == ']' )
+            {
+                m_aState.pop_back();
+                m_aeArrayState.pop_back();
+                EndArray();
+                ValueDone();
+            }
+            else if( eArrayState == ARRAY_START ||
+                     eArrayState == ARRAY_WAITING_VALUE )
+            {
+                StartArrayMember();
+                if( !StartValue(ch) )
+                    return false;
+            }
+            else
+            {
+                return EmitException(
+                    CPLSPrintf("Unexpected character '%c' in array", ch));
+            }
+        }
+        else /* INIT */
+        {
+            if( !StartValue(ch) )
+                return false;
+        }
+
+        for( size_t i = 0; i < nAdvance; i++ )
+        {
+            if( pStr[i] == '\n' )
+            {
+                m_nLineCounter++;
+                m_nCharCounter = 0;
+            }
+            m_nCharCounter++;
+        }
+        m_nOffset += nAdvance;
+        pStr += nAdvance;
+        nLength -= nAdvance;
+    }
+
+    if( m_bStopParsing )
+        return false;
+
+    /* Only whitespace is allowed after the root element */
+    for( ; nLength > 0; pStr++, nLength-- )
+    {
+        const char ch = *pStr;
+        if( ch != ' ' && ch != '\t' && ch != '\r' && ch != '\n' )
+            return EmitException("Unexpected content after end of document");
+        if( ch == '\n' )
+        {
+            m_nLineCounter++;
+            m_nCharCounter = 0;
+        }
+        m_nCharCounter++;
+        m_nOffset++;
+    }
+
+    if( bFinished && !m_bElementFound )
+    {
+        const State eState = m_aState.back();
+        if( eState == NUMBER )
+        {
+            if( !CheckAndEmitNumber() )
+                return false;
+        }
+        else if( eState == STATE_TRUE || eState == STATE_FALSE ||
+                 eState == STATE_NULL )
+        {
+            if( !CheckAndEmitLiteral() )
+                return false;
+        }
+        if( !m_bElementFound )
+        {
+            if( m_aState.size() == 1 )
+                return EmitException("Empty document");
+            return EmitException("Unterminated document");
+        }
+    }
+
+    return true;
+}
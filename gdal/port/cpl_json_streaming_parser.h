@@ -0,0 +1,144 @@
+/******************************************************************************
+ * $Id$
+ *
+ * Project:  CPL - Common Portability Library
+ * Purpose:  JSon streaming parser
+ * Author:   agent <agent at local>
+ *
+ ******************************************************************************
+ * Copyright (c) 2026, agent <agent at local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ****************************************************************************/
+
+#ifndef CPL_JSON_STREAMING_PARSER_H
+#define CPL_JSON_STREAMING_PARSER_H
+
+#if defined(__cplusplus) && !defined(CPL_SUPRESS_CPLUSPLUS)
+
+#include <vector>
+#include <string>
+#include "cpl_port.h"
+
+/**
+ * \file cpl_json_streaming_parser.h
+ *
+ * Event-based (SAX-style) JSon parser, that can be fed with successive
+ * chunks of a document, and does not need to hold the whole document in
+ * memory.
+ *
+ * @since GDAL 2.2
+ */
+
+class CPL_DLL CPLJSonStreamingParser
+{
+        enum State
+        {
+            INIT,
+            OBJECT,
+            ARRAY,
+            STRING,
+            NUMBER,
+            STATE_TRUE,
+            STATE_FALSE,
+            STATE_NULL
+        };
+
+        enum MemberState
+        {
+            MEMBER_START,        /* just after '{' */
+            MEMBER_WAITING_KEY,  /* just after ',' */
+            MEMBER_IN_KEY,
+            MEMBER_WAITING_COLON,
+            MEMBER_WAITING_VALUE,
+            MEMBER_AFTER_VALUE
+        };
+
+        enum ArrayState
+        {
+            ARRAY_START,         /* just after '[' */
+            ARRAY_WAITING_VALUE, /* just after ',' */
+            ARRAY_AFTER_VALUE
+        };
+
+        bool m_bExceptionOccurred;
+        bool m_bElementFound;
+        bool m_bStopParsing;
+        int m_nLineCounter;
+        int m_nCharCounter;
+        GUIntBig m_nOffset;
+        std::vector<State> m_aState;
+        std::vector<MemberState> m_aeMemberState;
+        std::vector<ArrayState> m_aeArrayState;
+        std::string m_osToken;
+        bool m_bInStringEscape;
+        bool m_bInUnicode;
+        std::string m_osUnicodeHex;
+        unsigned m_nHighSurrogate;
+        size_t m_nMaxDepth;
+        size_t m_nMaxStringSize;
+
+        bool EmitException(const char* pszMessage);
+        bool StartValue(char ch);
+        void ValueDone();
+        bool EmitStringOrKey();
+        bool AppendUnicodeChar();
+        bool CheckAndEmitLiteral();
+        bool CheckAndEmitNumber();
+
+    protected:
+        /** Return the offset, from the start of the document, of the
+         * character being processed. */
+        GUIntBig GetCurrentOffset() const { return m_nOffset; }
+
+        /** Stop parsing. Parse() will return false. */
+        void StopParsing() { m_bStopParsing = true; }
+
+        virtual void String(const char* /*pszValue*/, size_t /*nLength*/) {}
+        virtual void Number(const char* /*pszValue*/, size_t /*nLength*/) {}
+        virtual void Boolean(bool /*b*/) {}
+        virtual void Null() {}
+
+        virtual void StartObject() {}
+        virtual void EndObject() {}
+        virtual void StartObjectMember(const char* /*pszKey*/,
+                                       size_t /*nLength*/) {}
+
+        virtual void StartArray() {}
+        virtual void EndArray() {}
+        virtual void StartArrayMember() {}
+
+        virtual void Exception(const char* pszMessage);
+
+    public:
+        CPLJSonStreamingParser();
+        virtual ~CPLJSonStreamingParser();
+
+        void SetMaxDepth(size_t nVal);
+        void SetMaxStringSize(size_t nVal);
+        bool ExceptionOccurred() const { return m_bExceptionOccurred; }
+
+        void Reset();
+
+        bool Parse(const char* pStr, size_t nLength, bool bFinished);
+};
+
+#endif /* __cplusplus */
+
+#endif /* CPL_JSON_STREAMING_PARSER_H */
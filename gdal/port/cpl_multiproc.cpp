@@ -35,6 +35,7 @@
 #include "cpl_multiproc.h"
 
 #include "cpl_conv.h"
+#include "cpl_string.h"
 
 #include <time.h>
 #include <assert.h>
@@ -359,6 +360,62 @@ static void CPLCleanupTLSList( void **papTLSList )
     CPLFree( papTLSList );
 }
 
+/************************************************************************/
+/*                          CPLParseNumThreads()                        */
+/************************************************************************/
+
+/**
+ * Parse a number of threads.
+ *
+ * @param pszValue "ALL_CPUS" for the number of CPUs, or a number of threads.
+ * May be NULL.
+ * @return the number of threads, between 1 and 128. 1 is returned if
+ * pszValue is NULL or invalid.
+ * @since GDAL 2.2
+ */
+int CPLParseNumThreads( const char *pszValue )
+
+{
+    if( pszValue == NULL )
+        return 1;
+
+    int nThreads = 0;
+    if( EQUAL(pszValue, "ALL_CPUS") )
+        nThreads = CPLGetNumCPUs();
+    else
+        nThreads = atoi(pszValue);
+    if( nThreads > 128 )
+        nThreads = 128;
+    if( nThreads < 1 )
+        nThreads = 1;
+    return nThreads;
+}
+
+/************************************************************************/
+/*                           CPLGetNumThreads()                         */
+/************************************************************************/
+
+/**
+ * Return the number of threads requested for a processing.
+ *
+ * The value of the NUM_THREADS option of papszOptions is used if set, or
+ * else the value of the GDAL_NUM_THREADS configuration option, or else
+ * pszDefault. It is parsed with CPLParseNumThreads().
+ *
+ * @param papszOptions list of options (may be NULL).
+ * @param pszDefault value to use when neither option is set (may be NULL).
+ * @return the number of threads, between 1 and 128.
+ * @since GDAL 2.2
+ */
+int CPLGetNumThreads( char **papszOptions, const char *pszDefault )
+
+{
+    const char *pszValue = CSLFetchNameValue( papszOptions, "NUM_THREADS" );
+    if( pszValue == NULL )
+        pszValue = CPLGetConfigOption( "GDAL_NUM_THREADS", pszDefault );
+    return CPLParseNumThreads( pszValue );
+}
+
 #if defined(CPL_MULTIPROC_STUB)
 /************************************************************************/
 /* ==================================================================== */
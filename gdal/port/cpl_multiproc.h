@@ -100,6 +100,8 @@ void  CPL_DLL CPLSleep( double dfWaitInSeconds );
 const char CPL_DLL *CPLGetThreadingModel( void );
 
 int CPL_DLL CPLGetNumCPUs( void );
+int CPL_DLL CPLParseNumThreads( const char *pszValue );
+int CPL_DLL CPLGetNumThreads( char **papszOptions, const char *pszDefault );
 
 
 typedef struct _CPLLock CPLLock;
@@ -0,0 +1,1036 @@
+/******************************************************************************
+ * $Id$
+ *
+ * Project:  CPL - Common Portability Library
+ * Purpose:  Implementation of a static, bulk-loaded, packed R-tree.
+ * Author:   agent <agent at local>
+ *
+ ******************************************************************************
+ * Copyright (c) 2026, agent <agent at local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ******************************************************************************
+ */
+
+#include "cpl_packed_rtree.h"
+
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "cpl_conv.h"
+#include "cpl_error.h"
+
+CPL_CVSID("$Id$");
+
+/* Number of levels is bounded by log2(INT_MAX) since node capacity >= 2 */
+static const int MAX_LEVELS = 32;
+
+static const char PRT_SIGNATURE[8] = { 'C', 'P', 'L', 'P', 'R', 'T', '0', '1' };
+static const int PRT_HEADER_SIZE = 8 + 3 * 4;
+
+/*
+ * Layout of the tree:
+ * - pasBoxes contains the bounding boxes of all the nodes. The nFeatures
+ *   first ones are the leaves (features bounds, in sorted order), followed
+ *   by the boxes of the level 1 nodes, etc... up to the root node.
+ * - the children of node i of level L (L >= 1) are the nodes
+ *   [anLevelStart[L-1] + (i - anLevelStart[L]) * nNodeCapacity,
+ *    min(anLevelStart[L-1] + (i - anLevelStart[L] + 1) * nNodeCapacity,
+ *        anLevelStart[L]) [
+ * - panIndices[i] is the index, in the original feature array, of the
+ *   feature of leaf i.
+ */
+struct _CPLPackedRTree
+{
+    int          nFeatures;
+    int          nNodeCapacity;
+    int          nLevels;
+    int          anLevelStart[MAX_LEVELS + 1];
+    CPLRectObj  *pasBoxes;
+    int         *panIndices;
+    void       **pahFeatures;
+};
+
+/*
+** Returns TRUE if rectangles a and b overlap
+*/
+static CPL_INLINE bool CPL_RectOverlap( const CPLRectObj *a,
+                                        const CPLRectObj *b )
+{
+  if(a->minx > b->maxx) return(false);
+  if(a->maxx < b->minx) return(false);
+  if(a->miny > b->maxy) return(false);
+  if(a->maxy < b->miny) return(false);
+  return(true);
+}
+
+/************************************************************************/
+/*                      CPLPackedRTreeComputeLayout()                   */
+/************************************************************************/
+
+/* Computes the start offset of each level and returns the total number of */
+/* boxes, or -1 in case of overflow. */
+static int CPLPackedRTreeComputeLayout( CPLPackedRTree* hTree )
+{
+    int nCount = hTree->nFeatures;
+    GIntBig nTotal = 0;
+    hTree->nLevels = 0;
+    hTree->anLevelStart[0] = 0;
+    if( nCount == 0 )
+        return 0;
+    while( true )
+    {
+        nTotal += nCount;
+        if( nTotal > INT_MAX / 2 || hTree->nLevels == MAX_LEVELS )
+            return -1;
+        hTree->nLevels ++;
+        hTree->anLevelStart[hTree->nLevels] = static_cast<int>(nTotal);
+        if( nCount == 1 )
+            break;
+        nCount = (nCount + hTree->nNodeCapacity - 1) / hTree->nNodeCapacity;
+    }
+    return static_cast<int>(nTotal);
+}
+
+/************************************************************************/
+/*                         CPLPackedRTreeAlloc()                        */
+/************************************************************************/
+
+static CPLPackedRTree* CPLPackedRTreeAlloc( int nFeatures,
+                                            void** pahFeatures,
+                                            int nNodeCapacity )
+{
+    if( nFeatures < 0 )
+    {
+        CPLError(CE_Failure, CPLE_AppDefined, "Invalid feature count");
+        return NULL;
+    }
+    if( nNodeCapacity <= 0 )
+        nNodeCapacity = CPLPRT_DEFAULT_NODE_CAPACITY;
+    else if( nNodeCapacity < 2 )
+        nNodeCapacity = 2;
+
+    CPLPackedRTree* hTree = static_cast<CPLPackedRTree*>(
+        VSI_CALLOC_VERBOSE(1, sizeof(CPLPackedRTree)) );
+    if( hTree == NULL )
+        return NULL;
+    hTree->nFeatures = nFeatures;
+    hTree->nNodeCapacity = nNodeCapacity;
+
+    const int nTotalBoxes = CPLPackedRTreeComputeLayout(hTree);
+    if( nTotalBoxes < 0 )
+    {
+        CPLError(CE_Failure, CPLE_AppDefined, "Too many features");
+        CPLFree(hTree);
+        return NULL;
+    }
+    if( nFeatures > 0 )
+    {
+        hTree->pasBoxes = static_cast<CPLRectObj*>(
+            VSI_MALLOC2_VERBOSE(nTotalBoxes, sizeof(CPLRectObj)) );
+        hTree->panIndices = static_cast<int*>(
+            VSI_MALLOC2_VERBOSE(nFeatures, sizeof(int)) );
+        if( pahFeatures != NULL )
+        {
+            hTree->pahFeatures = static_cast<void**>(
+                VSI_MALLOC2_VERBOSE(nFeatures, sizeof(void*)) );
+            if( hTree->pahFeatures != NULL )
+                memcpy(hTree->pahFeatures, pahFeatures,
+                       nFeatures * sizeof(void*));
+        }
+        if( hTree->pasBoxes == NULL || hTree->panIndices == NULL ||
+            (pahFeatures != NULL && hTree->pahFeatures == NULL) )
+        {
+            CPLPackedRTreeDestroy(hTree);
+            return NULL;
+        }
+    }
+    return hTree;
+}
+
+/************************************************************************/
+/*                           CPLHilbertValue()                          */
+/************************************************************************/
+
+/* Index of (x, y), with 0 <= x, y < 65536, along a Hilbert curve. */
+/* From "Fast Hilbert curve generation, sorting, and range queries" */
+/* by rawrunprotected, public domain. */
+static GUInt32 CPLHilbertValue( GUInt32 x, GUInt32 y )
+{
+    GUInt32 a = x ^ y;
+    GUInt32 b = 0xFFFF ^ a;
+    GUInt32 c = 0xFFFF ^ (x | y);
+    GUInt32 d = x & (y ^ 0xFFFF);
+
+    GUInt32 A = a | (b >> 1);
+    GUInt32 B = (a >> 1) ^ a;
+    GUInt32 C = ((c >> 1) ^ (b & (d >> 1))) ^ c;
+    GUInt32 D = ((a & (c >> 1)) ^ (d >> 1)) ^ d;
+
+    a = A; b = B; c = C; d = D;
+    A = ((a & (a >> 2)) ^ (b & (b >> 2)));
+    B = ((a & (b >> 2)) ^ (b & ((a ^ b) >> 2)));
+    C ^= ((a & (c >> 2)) ^ (b & (d >> 2)));
+    D ^= ((b & (c >> 2)) ^ ((a ^ b) & (d >> 2)));
+
+    a = A; b = B; c = C; d = D;
+    A = ((a & (a >> 4)) ^ (b & (b >> 4)));
+    B = ((a & (b >> 4)) ^ (b & ((a ^ b) >> 4)));
+    C ^= ((a & (c >> 4)) ^ (b & (d >> 4)));
+    D ^= ((b & (c >> 4)) ^ ((a ^ b) & (d >> 4)));
+
+    a = A; b = B; c = C; d = D;
+    C ^= ((a & (c >> 8)) ^ (b & (d >> 8)));
+    D ^= ((b & (c >> 8)) ^ ((a ^ b) & (d >> 8)));
+
+    a = C ^ (C >> 1);
+    b = D ^ (D >> 1);
+
+    GUInt32 i0 = x ^ y;
+    GUInt32 i1 = b | (0xFFFF ^ (i0 | a));
+
+    i0 = (i0 | (i0 << 8)) & 0x00FF00FF;
+    i0 = (i0 | (i0 << 4)) & 0x0F0F0F0F;
+    i0 = (i0 | (i0 << 2)) & 0x33333333;
+    i0 = (i0 | (i0 << 1)) & 0x55555555;
+
+    i1 = (i1 | (i1 << 8)) & 0x00FF00FF;
+    i1 = (i1 | (i1 << 4)) & 0x0F0F0F0F;
+    i1 = (i1 | (i1 << 2)) & 0x33333333;
+    i1 = (i1 | (i1 << 1)) & 0x55555555;
+
+    return (i1 << 1) | i0;
+}
+
+/************************************************************************/
+/*                         CPLPackedRTreeSort()                         */
+/************************************************************************/
+
+typedef std::pair<double, int> SortKey;
+
+/* Sort keys are compared on their value, and then on the feature index, */
+/* so that the resulting tree does not depend on the std::sort() */
+/* implementation. */
+static void CPLPackedRTreeSort( CPLPackedRTree* hTree,
+                                const CPLRectObj* pasBounds,
+                                CPLPackedRTreeOrder eOrder )
+{
+    const int nFeatures = hTree->nFeatures;
+    std::vector<SortKey> aoKeys(nFeatures);
+
+    if( eOrder == CPLPRT_ORDER_HILBERT )
+    {
+        CPLRectObj sExtent = pasBounds[0];
+        for( int i = 1; i < nFeatures; i++ )
+        {
+            sExtent.minx = std::min(sExtent.minx, pasBounds[i].minx);
+            sExtent.miny = std::min(sExtent.miny, pasBounds[i].miny);
+            sExtent.maxx = std::max(sExtent.maxx, pasBounds[i].maxx);
+            sExtent.maxy = std::max(sExtent.maxy, pasBounds[i].maxy);
+        }
+        const double dfWidth = sExtent.maxx - sExtent.minx;
+        const double dfHeight = sExtent.maxy - sExtent.miny;
+        const double dfScaleX = dfWidth > 0 ? 65535.0 / dfWidth : 0.0;
+        const double dfScaleY = dfHeight > 0 ? 65535.0 / dfHeight : 0.0;
+        for( int i = 0; i < nFeatures; i++ )
+        {
+            const double dfX = (pasBounds[i].minx + pasBounds[i].maxx) / 2;
+            const double dfY = (pasBounds[i].miny + pasBounds[i].maxy) / 2;
+            const GUInt32 nX = static_cast<GUInt32>(
+                std::max(0.0, std::min(65535.0,
+                                       (dfX - sExtent.minx) * dfScaleX)));
+            const GUInt32 nY = static_cast<GUInt32>(
+                std::max(0.0, std::min(65535.0,
+                                       (dfY - sExtent.miny) * dfScaleY)));
+            aoKeys[i].first = CPLHilbertValue(nX, nY);
+            aoKeys[i].second = i;
+        }
+        std::sort(aoKeys.begin(), aoKeys.end());
+    }
+    else
+    {
+        // Sort-Tile-Recursive: sort by center X, cut into S vertical slices
+        // of S * nNodeCapacity features, and sort each slice by center Y.
+        for( int i = 0; i < nFeatures; i++ )
+        {
+            aoKeys[i].first = pasBounds[i].minx + pasBounds[i].maxx;
+            aoKeys[i].second = i;
+        }
+        std::sort(aoKeys.begin(), aoKeys.end());
+
+        const int nLeafNodes =
+            (nFeatures + hTree->nNodeCapacity - 1) / hTree->nNodeCapacity;
+        const int nSlices =
+            std::max(1, static_cast<int>(ceil(sqrt(
+                static_cast<double>(nLeafNodes)))));
+        const GIntBig nSliceSize =
+            static_cast<GIntBig>(nSlices) * hTree->nNodeCapacity;
+        for( GIntBig nStart = 0; nStart < nFeatures; nStart += nSliceSize )
+        {
+            const int nEnd = static_cast<int>(
+                std::min(static_cast<GIntBig>(nFeatures), nStart + nSliceSize));
+            for( int i = static_cast<int>(nStart); i < nEnd; i++ )
+            {
+                const int idx = aoKeys[i].second;
+                aoKeys[i].first = pasBounds[idx].miny + pasBounds[idx].maxy;
+            }
+            std::sort(aoKeys.begin() + static_cast<size_t>(nStart),
+                      aoKeys.begin() + nEnd);
+        }
+    }
+
+    for( int i = 0; i < nFeatures; i++ )
+    {
+        hTree->panIndices[i] = aoKeys[i].second;
+        hTree->pasBoxes[i] = pasBounds[aoKeys[i].second];
+    }
+}
+
+/************************************************************************/
+/*                      CPLPackedRTreeBuildNodes()                      */
+/************************************************************************/
+
+static void CPLPackedRTreeBuildNodes( CPLPackedRTree* hTree )
+{
+    const int nCap = hTree->nNodeCapacity;
+    for( int iLevel = 1; iLevel < hTree->nLevels; iLevel++ )
+    {
+        const int nChildStart = hTree->anLevelStart[iLevel-1];
+        const int nChildEnd = hTree->anLevelStart[iLevel];
+        int iNode = nChildEnd;
+        for( int iChild = nChildStart; iChild < nChildEnd;
+             iChild += nCap, iNode ++ )
+        {
+            const int iLastChild = std::min(iChild + nCap, nChildEnd);
+            CPLRectObj sRect = hTree->pasBoxes[iChild];
+            for( int j = iChild + 1; j < iLastChild; j++ )
+            {
+                const CPLRectObj& sChild = hTree->pasBoxes[j];
+                if( sChild.minx < sRect.minx ) sRect.minx = sChild.minx;
+                if( sChild.miny < sRect.miny ) sRect.miny = sChild.miny;
+                if( sChild.maxx > sRect.maxx ) sRect.maxx = sChild.maxx;
+                if( sChild.maxy > sRect.maxy ) sRect.maxy = sChild.maxy;
+            }
+            hTree->pasBoxes[iNode] = sRect;
+        }
+        CPLAssert( iNode == hTree->anLevelStart[iLevel+1] );
+    }
+}
+
+/************************************************************************/
+/*                   CPLPackedRTreeCreateWithBounds()                   */
+/************************************************************************/
+
+/**
+ * Create a packed R-tree from a set of features and their bounds.
+ *
+ * The feature handles and bounds are copied, so the arrays can be freed
+ * by the caller after this call.
+ *
+ * @param nFeatures     number of features.
+ * @param pahFeatures   array of nFeatures feature handles that will be returned
+ *                      by CPLPackedRTreeSearch(). May be NULL, in which case
+ *                      CPLPackedRTreeSearch() will return the indices of the
+ *                      features, cast as (void*)(size_t).
+ * @param pasBounds     array of nFeatures bounding boxes.
+ * @param eOrder        ordering method used to pack the features in nodes.
+ * @param nNodeCapacity maximum number of children of a node, or 0 for
+ *                      the default value (CPLPRT_DEFAULT_NODE_CAPACITY).
+ *
+ * @return a newly allocated packed R-tree, or NULL in case of error.
+ *
+ * @since GDAL 2.2
+ */
+
+CPLPackedRTree* CPLPackedRTreeCreateWithBounds( int nFeatures,
+                                                void** pahFeatures,
+                                                const CPLRectObj* pasBounds,
+                                                CPLPackedRTreeOrder eOrder,
+                                                int nNodeCapacity )
+{
+    CPLPackedRTree* hTree =
+        CPLPackedRTreeAlloc(nFeatures, pahFeatures, nNodeCapacity);
+    if( hTree == NULL || nFeatures == 0 )
+        return hTree;
+
+    CPLPackedRTreeSort(hTree, pasBounds, eOrder);
+    CPLPackedRTreeBuildNodes(hTree);
+
+    return hTree;
+}
+
+/************************************************************************/
+/*                        CPLPackedRTreeCreate()                        */
+/************************************************************************/
+
+/**
+ * Create a packed R-tree from a set of features.
+ *
+ * @param nFeatures     number of features.
+ * @param pahFeatures   array of nFeatures feature handles. Must not be NULL.
+ * @param pfnGetBounds  a user provided function to get the bounding box of
+ *                      the features.
+ * @param eOrder        ordering method used to pack the features in nodes.
+ * @param nNodeCapacity maximum number of children of a node, or 0 for
+ *                      the default value (CPLPRT_DEFAULT_NODE_CAPACITY).
+ *
+ * @return a newly allocated packed R-tree, or NULL in case of error.
+ *
+ * @since GDAL 2.2
+ */
+
+CPLPackedRTree* CPLPackedRTreeCreate( int nFeatures,
+                                      void** pahFeatures,
+                                      CPLQuadTreeGetBoundsFunc pfnGetBounds,
+                                      CPLPackedRTreeOrder eOrder,
+                                      int nNodeCapacity )
+{
+    CPLAssert(pfnGetBounds);
+    CPLAssert(pahFeatures != NULL || nFeatures == 0);
+
+    CPLRectObj* pasBounds = static_cast<CPLRectObj*>(
+        VSI_MALLOC2_VERBOSE(std::max(1, nFeatures), sizeof(CPLRectObj)) );
+    if( pasBounds == NULL )
+        return NULL;
+    for( int i = 0; i < nFeatures; i++ )
+        pfnGetBounds(pahFeatures[i], &pasBounds[i]);
+
+    CPLPackedRTree* hTree = CPLPackedRTreeCreateWithBounds(
+        nFeatures, pahFeatures, pasBounds, eOrder, nNodeCapacity);
+    CPLFree(pasBounds);
+    return hTree;
+}
+
+/************************************************************************/
+/*                        CPLPackedRTreeDestroy()                       */
+/************************************************************************/
+
+/**
+ * Destroy a packed R-tree
+ *
+ * @param hTree the packed R-tree to destroy
+ *
+ * @since GDAL 2.2
+ */
+
+void CPLPackedRTreeDestroy( CPLPackedRTree *hTree )
+{
+    if( hTree == NULL )
+        return;
+    CPLFree(hTree->pasBoxes);
+    CPLFree(hTree->panIndices);
+    CPLFree(hTree->pahFeatures);
+    CPLFree(hTree);
+}
+
+/************************************************************************/
+/*                      CPLPackedRTreeCollect()                         */
+/************************************************************************/
+
+/* Appends to panResults the position in the leaf level of all the leaves */
+/* that intersect pAoi. */
+static int CPLPackedRTreeCollect( const CPLPackedRTree *hTree,
+                                  const CPLRectObj* pAoi,
+                                  int** ppanResults )
+{
+    int nCount = 0;
+    int nMaxCount = 0;
+    *ppanResults = NULL;
+
+    if( hTree->nFeatures == 0 )
+        return 0;
+
+    const int nCap = hTree->nNodeCapacity;
+    const int nRoot = hTree->anLevelStart[hTree->nLevels] - 1;
+    if( !CPL_RectOverlap(&hTree->pasBoxes[nRoot], pAoi) )
+        return 0;
+
+    // Stack of (node position, level) whose bounds intersect the AOI.
+    std::vector< std::pair<int, int> > aoStack;
+    aoStack.reserve(static_cast<size_t>(nCap) * hTree->nLevels);
+    aoStack.push_back(std::pair<int,int>(nRoot, hTree->nLevels - 1));
+
+    while( !aoStack.empty() )
+    {
+        const int iNode = aoStack.back().first;
+        const int iLevel = aoStack.back().second;
+        aoStack.pop_back();
+
+        if( iLevel == 0 )
+        {
+            // Only happens for a tree of a single feature.
+            if( nCount == nMaxCount )
+            {
+                nMaxCount = nMaxCount * 2 + 16;
+                *ppanResults = static_cast<int*>(
+                    CPLRealloc(*ppanResults, nMaxCount * sizeof(int)));
+            }
+            (*ppanResults)[nCount++] = iNode;
+            continue;
+        }
+
+        const int iChildStart = hTree->anLevelStart[iLevel-1] +
+            (iNode - hTree->anLevelStart[iLevel]) * nCap;
+        const int iChildEnd = std::min(iChildStart + nCap,
+                                       hTree->anLevelStart[iLevel]);
+        const CPLRectObj* pasChildren = hTree->pasBoxes;
+        if( iLevel == 1 )
+        {
+            for( int i = iChildStart; i < iChildEnd; i++ )
+            {
+                if( !CPL_RectOverlap(&pasChildren[i], pAoi) )
+                    continue;
+                if( nCount == nMaxCount )
+                {
+                    nMaxCount = nMaxCount * 2 + 16;
+                    *ppanResults = static_cast<int*>(
+                        CPLRealloc(*ppanResults, nMaxCount * sizeof(int)));
+                }
+                (*ppanResults)[nCount++] = i;
+            }
+        }
+        else
+        {
+            for( int i = iChildStart; i < iChildEnd; i++ )
+            {
+                if( CPL_RectOverlap(&pasChildren[i], pAoi) )
+                    aoStack.push_back(std::pair<int,int>(i, iLevel - 1));
+            }
+        }
+    }
+
+    return nCount;
+}
+
+/************************************************************************/
+/*                        CPLPackedRTreeSearch()                        */
+/************************************************************************/
+
+/**
+ * Returns all the features whose bounding box intersects the
+ * provided area of interest.
+ *
+ * If the tree was created without feature handles, the returned array
+ * contains the indices of the features, cast as (void*)(size_t).
+ *
+ * @param hTree the packed R-tree
+ * @param pAoi the pointer to the area of interest
+ * @param pnFeatureCount pointer to an integer that will receive the number of
+ *                       returned features
+ *
+ * @return an array of features that must be freed with CPLFree
+ *
+ * @since GDAL 2.2
+ */
+
+void** CPLPackedRTreeSearch( const CPLPackedRTree *hTree,
+                             const CPLRectObj* pAoi,
+                             int* pnFeatureCount )
+{
+    CPLAssert(hTree);
+    CPLAssert(pAoi);
+    CPLAssert(pnFeatureCount);
+
+    int* panLeaves = NULL;
+    const int nCount = CPLPackedRTreeCollect(hTree, pAoi, &panLeaves);
+    *pnFeatureCount = nCount;
+    if( nCount == 0 )
+        return NULL;
+
+    void** pahResults = static_cast<void**>(
+        CPLMalloc(nCount * sizeof(void*)) );
+    for( int i = 0; i < nCount; i++ )
+    {
+        const int idx = hTree->panIndices[panLeaves[i]];
+        pahResults[i] = hTree->pahFeatures ? hTree->pahFeatures[idx] :
+                                        reinterpret_cast<void*>(
+                                            static_cast<size_t>(idx));
+    }
+    CPLFree(panLeaves);
+    return pahResults;
+}
+
+/************************************************************************/
+/*                     CPLPackedRTreeSearchIndices()                    */
+/************************************************************************/
+
+/**
+ * Returns the indices of all the features whose bounding box intersects the
+ * provided area of interest.
+ *
+ * The indices are the position of the features in the arrays provided
+ * at creation time, and are returned sorted in increasing order.
+ *
+ * @param hTree the packed R-tree
+ * @param pAoi the pointer to the area of interest
+ * @param pnFeatureCount pointer to an integer that will receive the number of
+ *                       returned indices
+ *
+ * @return an array of indices that must be freed with CPLFree
+ *
+ * @since GDAL 2.2
+ */
+
+int* CPLPackedRTreeSearchIndices( const CPLPackedRTree *hTree,
+                                  const CPLRectObj* pAoi,
+                                  int* pnFeatureCount )
+{
+    CPLAssert(hTree);
+    CPLAssert(pAoi);
+    CPLAssert(pnFeatureCount);
+
+    int* panResults = NULL;
+    const int nCount = CPLPackedRTreeCollect(hTree, pAoi, &panResults);
+    *pnFeatureCount = nCount;
+    for( int i = 0; i < nCount; i++ )
+        panResults[i] = hTree->panIndices[panResults[i]];
+    if( nCount > 1 )
+        std::sort(panResults, panResults + nCount);
+    return panResults;
+}
+
+/************************************************************************/
+/*                       CPLPackedRTreeNearestItem                      */
+/************************************************************************/
+
+/* Element of the priority queue of the nearest neighbour search: a node */
+/* (iLevel >= 1) or a leaf (iLevel == 0), and the squared distance from */
+/* its box to the query point. */
+struct CPLPackedRTreeNearestItem
+{
+    double dfDist2;
+    int    iLevel;
+    int    nId;   /* node position, or feature index for a leaf */
+    int    iPos;  /* position of the node or leaf in pasBoxes */
+};
+
+/* Orders the queue by increasing distance, then nodes before leaves so */
+/* that all the leaves at a given distance are known before the first of */
+/* them is returned, and then leaves by increasing feature index. */
+struct CPLPackedRTreeNearestGreater
+{
+    bool operator()( const CPLPackedRTreeNearestItem& a,
+                     const CPLPackedRTreeNearestItem& b ) const
+    {
+        if( a.dfDist2 != b.dfDist2 )
+            return a.dfDist2 > b.dfDist2;
+        if( (a.iLevel == 0) != (b.iLevel == 0) )
+            return a.iLevel == 0;
+        return a.nId > b.nId;
+    }
+};
+
+static CPL_INLINE double CPLPackedRTreeDist2( const CPLRectObj& sRect,
+                                              double dfX, double dfY )
+{
+    const double dfDX = dfX < sRect.minx ? sRect.minx - dfX :
+                        dfX > sRect.maxx ? dfX - sRect.maxx : 0.0;
+    const double dfDY = dfY < sRect.miny ? sRect.miny - dfY :
+                        dfY > sRect.maxy ? dfY - sRect.maxy : 0.0;
+    return dfDX * dfDX + dfDY * dfDY;
+}
+
+/************************************************************************/
+/*                 CPLPackedRTreeSearchNearestIndices()                 */
+/************************************************************************/
+
+/**
+ * Returns the indices of the features nearest to a point.
+ *
+ * The distance of a feature is the euclidean distance between the point
+ * and the bounding box of the feature, which is the exact distance for
+ * point features. The indices are returned by increasing distance, and
+ * by increasing index for features at the same distance. The search is
+ * a best-first traversal of the tree, so only the nodes closer than the
+ * last returned feature are visited.
+ *
+ * @param hTree the packed R-tree
+ * @param dfX X coordinate of the point.
+ * @param dfY Y coordinate of the point.
+ * @param nMaxCount maximum number of indices to return (k).
+ * @param dfMaxDistance maximum distance of the returned features, or a
+ *                      negative value for no limit.
+ * @param pnFeatureCount pointer to an integer that will receive the number of
+ *                       returned indices
+ * @param padfDist2 NULL, or an array of at least nMaxCount values that
+ *                  receives the squared distance of the returned features.
+ *
+ * @return an array of indices that must be freed with CPLFree, or NULL if
+ * no feature was found.
+ *
+ * @since GDAL 2.2
+ */
+
+int* CPLPackedRTreeSearchNearestIndices( const CPLPackedRTree *hTree,
+                                         double dfX, double dfY,
+                                         int nMaxCount,
+                                         double dfMaxDistance,
+                                         int* pnFeatureCount,
+                                         double* padfDist2 )
+{
+    CPLAssert(hTree);
+    CPLAssert(pnFeatureCount);
+
+    *pnFeatureCount = 0;
+    if( hTree->nFeatures == 0 || nMaxCount <= 0 )
+        return NULL;
+
+    const double dfMaxDist2 = dfMaxDistance < 0 ? -1.0 :
+                                            dfMaxDistance * dfMaxDistance;
+    const int nCap = hTree->nNodeCapacity;
+    std::vector<CPLPackedRTreeNearestItem> aoQueue;
+    aoQueue.reserve(static_cast<size_t>(nCap) * hTree->nLevels * 2);
+    CPLPackedRTreeNearestGreater oGreater;
+
+    const int nRoot = hTree->anLevelStart[hTree->nLevels] - 1;
+    CPLPackedRTreeNearestItem sItem;
+    sItem.dfDist2 = CPLPackedRTreeDist2(hTree->pasBoxes[nRoot], dfX, dfY);
+    sItem.iLevel = hTree->nLevels - 1;
+    sItem.iPos = nRoot;
+    sItem.nId = sItem.iLevel == 0 ? hTree->panIndices[nRoot] : nRoot;
+    if( dfMaxDist2 >= 0 && sItem.dfDist2 > dfMaxDist2 )
+        return NULL;
+    aoQueue.push_back(sItem);
+
+    int* panResults = NULL;
+    int nCount = 0;
+    while( !aoQueue.empty() && nCount < nMaxCount )
+    {
+        std::pop_heap(aoQueue.begin(), aoQueue.end(), oGreater);
+        const CPLPackedRTreeNearestItem sTop = aoQueue.back();
+        aoQueue.pop_back();
+
+        if( sTop.iLevel == 0 )
+        {
+            if( panResults == NULL )
+                panResults = static_cast<int*>(
+                    CPLMalloc(std::min(nMaxCount, hTree->nFeatures) *
+                              sizeof(int)));
+            if( padfDist2 )
+                padfDist2[nCount] = sTop.dfDist2;
+            panResults[nCount++] = sTop.nId;
+            continue;
+        }
+
+        const int iChildStart = hTree->anLevelStart[sTop.iLevel-1] +
+            (sTop.iPos - hTree->anLevelStart[sTop.iLevel]) * nCap;
+        const int iChildEnd = std::min(iChildStart + nCap,
+                                       hTree->anLevelStart[sTop.iLevel]);
+        for( int i = iChildStart; i < iChildEnd; i++ )
+        {
+            sItem.dfDist2 = CPLPackedRTreeDist2(hTree->pasBoxes[i], dfX, dfY);
+            if( dfMaxDist2 >= 0 && sItem.dfDist2 > dfMaxDist2 )
+                continue;
+            sItem.iLevel = sTop.iLevel - 1;
+            sItem.iPos = i;
+            sItem.nId = sItem.iLevel == 0 ? hTree->panIndices[i] : i;
+            aoQueue.push_back(sItem);
+            std::push_heap(aoQueue.begin(), aoQueue.end(), oGreater);
+        }
+    }
+
+    *pnFeatureCount = nCount;
+    return panResults;
+}
+
+/************************************************************************/
+/*                        CPLPackedRTreeForeach()                       */
+/************************************************************************/
+
+/**
+ * Walk through the features of a packed R-tree, in the order they are
+ * stored in the tree.
+ *
+ * The function pfnForeach must return TRUE to go on the walk, or FALSE to
+ * make it stop. If the tree was created without feature handles, it receives
+ * the feature indices, cast as (void*)(size_t).
+ *
+ * @param hTree the packed R-tree
+ * @param pfnForeach the function called on each element.
+ * @param pUserData the user data provided to the function.
+ *
+ * @since GDAL 2.2
+ */
+
+void CPLPackedRTreeForeach( const CPLPackedRTree *hTree,
+                            CPLQuadTreeForeachFunc pfnForeach,
+                            void* pUserData )
+{
+    CPLAssert(hTree);
+    CPLAssert(pfnForeach);
+    for( int i = 0; i < hTree->nFeatures; i++ )
+    {
+        const int idx = hTree->panIndices[i];
+        void* hFeature = hTree->pahFeatures ? hTree->pahFeatures[idx] :
+                            reinterpret_cast<void*>(static_cast<size_t>(idx));
+        if( pfnForeach(hFeature, pUserData) == FALSE )
+            break;
+    }
+}
+
+/************************************************************************/
+/*                       CPLPackedRTreeGetExtent()                      */
+/************************************************************************/
+
+/**
+ * Returns the extent of all the features of a packed R-tree.
+ *
+ * @param hTree the packed R-tree
+ * @param psExtent pointer to the structure that receives the extent.
+ *
+ * @return TRUE in case of success, FALSE if the tree is empty.
+ *
+ * @since GDAL 2.2
+ */
+
+int CPLPackedRTreeGetExtent( const CPLPackedRTree *hTree,
+                             CPLRectObj* psExtent )
+{
+    CPLAssert(hTree);
+    if( hTree->nFeatures == 0 )
+        return FALSE;
+    *psExtent = hTree->pasBoxes[hTree->anLevelStart[hTree->nLevels] - 1];
+    return TRUE;
+}
+
+/************************************************************************/
+/*                       CPLPackedRTreeGetStats()                       */
+/************************************************************************/
+
+/**
+ * Returns statistics about a packed R-tree.
+ *
+ * @param hTree the packed R-tree
+ * @param pnFeatureCount pointer to the number of features, or NULL.
+ * @param pnNodeCount pointer to the number of non-leaf nodes, or NULL.
+ * @param pnDepth pointer to the number of levels of the tree, or NULL.
+ * @param pnMemoryUsage pointer to the number of bytes used by the tree,
+ *                      or NULL.
+ *
+ * @since GDAL 2.2
+ */
+
+void CPLPackedRTreeGetStats( const CPLPackedRTree *hTree,
+                             int* pnFeatureCount,
+                             int* pnNodeCount,
+                             int* pnDepth,
+                             GUIntBig* pnMemoryUsage )
+{
+    CPLAssert(hTree);
+    const int nTotalBoxes = hTree->anLevelStart[hTree->nLevels];
+    if( pnFeatureCount )
+        *pnFeatureCount = hTree->nFeatures;
+    if( pnNodeCount )
+        *pnNodeCount = nTotalBoxes - hTree->nFeatures;
+    if( pnDepth )
+        *pnDepth = hTree->nLevels;
+    if( pnMemoryUsage )
+    {
+        *pnMemoryUsage = sizeof(CPLPackedRTree) +
+            static_cast<GUIntBig>(nTotalBoxes) * sizeof(CPLRectObj) +
+            static_cast<GUIntBig>(hTree->nFeatures) * sizeof(int);
+        if( hTree->pahFeatures )
+            *pnMemoryUsage +=
+                static_cast<GUIntBig>(hTree->nFeatures) * sizeof(void*);
+    }
+}
+
+/************************************************************************/
+/*                        CPLPackedRTreeWrite()                         */
+/************************************************************************/
+
+/**
+ * Serialize a packed R-tree into a file.
+ *
+ * The serialized form only contains the tree structure and the feature
+ * indices, not the feature handles. It is written in little-endian order,
+ * at the current position of the file, so that it can be embedded in
+ * another file.
+ *
+ * @param hTree the packed R-tree
+ * @param fp file handle opened for writing.
+ *
+ * @return TRUE in case of success.
+ *
+ * @since GDAL 2.2
+ */
+
+int CPLPackedRTreeWrite( const CPLPackedRTree *hTree, VSILFILE* fp )
+{
+    CPLAssert(hTree);
+    CPLAssert(fp);
+
+    GByte abyHeader[PRT_HEADER_SIZE];
+    memcpy(abyHeader, PRT_SIGNATURE, 8);
+    const int nTotalBoxes = hTree->anLevelStart[hTree->nLevels];
+    GInt32 anVals[3] = { hTree->nNodeCapacity, hTree->nFeatures, nTotalBoxes };
+    for( int i = 0; i < 3; i++ )
+    {
+        CPL_LSBPTR32(&anVals[i]);
+        memcpy(abyHeader + 8 + 4 * i, &anVals[i], 4);
+    }
+    if( VSIFWriteL(abyHeader, PRT_HEADER_SIZE, 1, fp) != 1 )
+        return FALSE;
+
+    // Write by chunks to avoid a full copy of the tree when byte swapping
+    // is needed.
+    const int CHUNK_SIZE = 1024;
+    double adfBuffer[4 * CHUNK_SIZE];
+    for( int i = 0; i < nTotalBoxes; i += CHUNK_SIZE )
+    {
+        const int nThisChunk = std::min(CHUNK_SIZE, nTotalBoxes - i);
+        for( int j = 0; j < nThisChunk; j++ )
+        {
+            adfBuffer[4*j+0] = hTree->pasBoxes[i+j].minx;
+            adfBuffer[4*j+1] = hTree->pasBoxes[i+j].miny;
+            adfBuffer[4*j+2] = hTree->pasBoxes[i+j].maxx;
+            adfBuffer[4*j+3] = hTree->pasBoxes[i+j].maxy;
+            for( int k = 0; k < 4; k++ )
+                CPL_LSBPTR64(&adfBuffer[4*j+k]);
+        }
+        if( VSIFWriteL(adfBuffer, 4 * sizeof(double), nThisChunk, fp) !=
+                                        static_cast<size_t>(nThisChunk) )
+            return FALSE;
+    }
+
+    GInt32 anBuffer[CHUNK_SIZE];
+    for( int i = 0; i < hTree->nFeatures; i += CHUNK_SIZE )
+    {
+        const int nThisChunk = std::min(CHUNK_SIZE, hTree->nFeatures - i);
+        for( int j = 0; j < nThisChunk; j++ )
+        {
+            anBuffer[j] = hTree->panIndices[i+j];
+            CPL_LSBPTR32(&anBuffer[j]);
+        }
+        if( VSIFWriteL(anBuffer, sizeof(GInt32), nThisChunk, fp) !=
+                                        static_cast<size_t>(nThisChunk) )
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+/************************************************************************/
+/*                         CPLPackedRTreeRead()                         */
+/************************************************************************/
+
+/**
+ * Read a packed R-tree serialized with CPLPackedRTreeWrite().
+ *
+ * Reading starts at the current position of the file.
+ *
+ * @param fp file handle opened for reading.
+ * @param nFeatureCount number of features the R-tree is expected to index,
+ *                      that is the number of elements of pahFeatures when
+ *                      it is not NULL. The R-tree is rejected if it indexes
+ *                      a different number of features.
+ * @param pahFeatures array of feature handles, in the order of the array
+ *                    used at creation time, that will be returned by
+ *                    CPLPackedRTreeSearch(). May be NULL, in which case
+ *                    feature indices are returned instead.
+ *
+ * @return a newly allocated packed R-tree, or NULL in case of error.
+ *
+ * @since GDAL 2.2
+ */
+
+CPLPackedRTree* CPLPackedRTreeRead( VSILFILE* fp, int nFeatureCount,
+                                    void** pahFeatures )
+{
+    CPLAssert(fp);
+
+    GByte abyHeader[PRT_HEADER_SIZE];
+    if( VSIFReadL(abyHeader, PRT_HEADER_SIZE, 1, fp) != 1 ||
+        memcmp(abyHeader, PRT_SIGNATURE, 8) != 0 )
+    {
+        CPLError(CE_Failure, CPLE_AppDefined,
+                 "Invalid packed R-tree signature");
+        return NULL;
+    }
+    GInt32 anVals[3];
+    for( int i = 0; i < 3; i++ )
+    {
+        memcpy(&anVals[i], abyHeader + 8 + 4 * i, 4);
+        CPL_LSBPTR32(&anVals[i]);
+    }
+    if( anVals[0] < 2 || anVals[1] < 0 )
+    {
+        CPLError(CE_Failure, CPLE_AppDefined, "Invalid packed R-tree header");
+        return NULL;
+    }
+    if( anVals[1] != nFeatureCount )
+    {
+        CPLError(CE_Failure, CPLE_AppDefined,
+                 "Packed R-tree indexes %d features, whereas %d are expected",
+                 anVals[1], nFeatureCount);
+        return NULL;
+    }
+
+    CPLPackedRTree* hTree =
+        CPLPackedRTreeAlloc(anVals[1], pahFeatures, anVals[0]);
+    if( hTree == NULL )
+        return NULL;
+    const int nTotalBoxes = hTree->anLevelStart[hTree->nLevels];
+    if( nTotalBoxes != anVals[2] )
+    {
+        CPLError(CE_Failure, CPLE_AppDefined, "Invalid packed R-tree header");
+        CPLPackedRTreeDestroy(hTree);
+        return NULL;
+    }
+    if( hTree->nFeatures == 0 )
+        return hTree;
+
+    if( VSIFReadL(hTree->pasBoxes, sizeof(CPLRectObj), nTotalBoxes, fp) !=
+                                        static_cast<size_t>(nTotalBoxes) ||
+        VSIFReadL(hTree->panIndices, sizeof(int), hTree->nFeatures, fp) !=
+                                        static_cast<size_t>(hTree->nFeatures) )
+    {
+        CPLError(CE_Failure, CPLE_FileIO, "Cannot read packed R-tree");
+        CPLPackedRTreeDestroy(hTree);
+        return NULL;
+    }
+
+#ifdef CPL_MSB
+    for( int i = 0; i < nTotalBoxes; i++ )
+    {
+        CPL_LSBPTR64(&hTree->pasBoxes[i].minx);
+        CPL_LSBPTR64(&hTree->pasBoxes[i].miny);
+        CPL_LSBPTR64(&hTree->pasBoxes[i].maxx);
+        CPL_LSBPTR64(&hTree->pasBoxes[i].maxy);
+    }
+#endif
+    for( int i = 0; i < hTree->nFeatures; i++ )
+    {
+        CPL_LSBPTR32(&hTree->panIndices[i]);
+        if( hTree->panIndices[i] < 0 ||
+            hTree->panIndices[i] >= hTree->nFeatures )
+        {
+            CPLError(CE_Failure, CPLE_AppDefined,
+                     "Invalid feature index in packed R-tree");
+            CPLPackedRTreeDestroy(hTree);
+            return NULL;
+        }
+    }
+
+    return hTree;
+}
@@ -0,0 +1,119 @@
+/**********************************************************************
+ * $Id$
+ *
+ * Project:  CPL - Common Portability Library
+ * Purpose:  Implementation of a static, bulk-loaded, packed R-tree.
+ * Author:   agent <agent at local>
+ *
+ ******************************************************************************
+ * Copyright (c) 2026, agent <agent at local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ ****************************************************************************/
+
+#ifndef CPL_PACKED_RTREE_H_INCLUDED
+#define CPL_PACKED_RTREE_H_INCLUDED
+
+#include "cpl_port.h"
+#include "cpl_quad_tree.h"
+#include "cpl_vsi.h"
+
+/**
+ * \file cpl_packed_rtree.h
+ *
+ * Packed R-tree implementation.
+ *
+ * A packed R-tree is an immutable spatial index that is bulk-loaded from a
+ * known set of features. Features are sorted once (with the Sort-Tile-Recursive
+ * or Hilbert curve ordering), and the node bounding boxes of all levels are
+ * stored in a single contiguous array, which makes it compact in memory, fast
+ * to build and cache-friendly to search. It is appropriate for data that does
+ * not change after the index has been built. For incrementally built indices,
+ * see cpl_quad_tree.h
+ *
+ * @since GDAL 2.2
+ */
+
+CPL_C_START
+
+/* Types */
+
+typedef struct _CPLPackedRTree CPLPackedRTree;
+
+/** Ordering method used to bulk-load a packed R-tree */
+typedef enum
+{
+    /** Sort-Tile-Recursive ordering */
+    CPLPRT_ORDER_STR,
+    /** Ordering along a Hilbert curve of the center of features */
+    CPLPRT_ORDER_HILBERT
+} CPLPackedRTreeOrder;
+
+/** Default number of children of a node of a packed R-tree */
+#define CPLPRT_DEFAULT_NODE_CAPACITY 16
+
+/* Functions */
+
+CPLPackedRTree CPL_DLL *CPLPackedRTreeCreate(int nFeatures,
+                                             void** pahFeatures,
+                                             CPLQuadTreeGetBoundsFunc pfnGetBounds,
+                                             CPLPackedRTreeOrder eOrder,
+                                             int nNodeCapacity);
+CPLPackedRTree CPL_DLL *CPLPackedRTreeCreateWithBounds(int nFeatures,
+                                                       void** pahFeatures,
+                                                       const CPLRectObj* pasBounds,
+                                                       CPLPackedRTreeOrder eOrder,
+                                                       int nNodeCapacity);
+void           CPL_DLL  CPLPackedRTreeDestroy(CPLPackedRTree *hTree);
+
+void           CPL_DLL **CPLPackedRTreeSearch(const CPLPackedRTree *hTree,
+                                              const CPLRectObj* pAoi,
+                                              int* pnFeatureCount);
+int            CPL_DLL  *CPLPackedRTreeSearchIndices(const CPLPackedRTree *hTree,
+                                                     const CPLRectObj* pAoi,
+                                                     int* pnFeatureCount);
+int            CPL_DLL  *CPLPackedRTreeSearchNearestIndices(
+                                                const CPLPackedRTree *hTree,
+                                                double dfX, double dfY,
+                                                int nMaxCount,
+                                                double dfMaxDistance,
+                                                int* pnFeatureCount,
+                                                double* padfDist2);
+
+void           CPL_DLL   CPLPackedRTreeForeach(const CPLPackedRTree *hTree,
+                                               CPLQuadTreeForeachFunc pfnForeach,
+                                               void* pUserData);
+
+int            CPL_DLL   CPLPackedRTreeGetExtent(const CPLPackedRTree *hTree,
+                                                 CPLRectObj* psExtent);
+void           CPL_DLL   CPLPackedRTreeGetStats(const CPLPackedRTree *hTree,
+                                                int* pnFeatureCount,
+                                                int* pnNodeCount,
+                                                int* pnDepth,
+                                                GUIntBig* pnMemoryUsage);
+
+int            CPL_DLL   CPLPackedRTreeWrite(const CPLPackedRTree *hTree,
+                                             VSILFILE* fp);
+CPLPackedRTree CPL_DLL  *CPLPackedRTreeRead(VSILFILE* fp,
+                                            int nFeatureCount,
+                                            void** pahFeatures);
+
+CPL_C_END
+
+#endif
@@ -93,6 +93,10 @@ while i < len(argv):
         i = i + 1
         src_band = int(argv[i])
 
+    elif arg == '-o':
+        i = i + 1
+        options.append(argv[i])
+
     elif arg == '-md':
         i = i + 1
         max_distance = float(argv[i])
@@ -83,6 +83,10 @@ while i < len(argv):
         i = i + 1
         threshold = int(argv[i])
 
+    elif arg == '-o':
+        i = i + 1
+        options.append(argv[i])
+
     elif arg == '-nomask':
         mask = 'none'
 
@@ -175,6 +179,7 @@ else:
 
 result = gdal.SieveFilter( srcband, maskband, dstband,
                            threshold, connectedness,
+                           options = options,
                            callback = prog_func )
 
 src_ds = None